@@ -0,0 +1,8 @@
+#! /usr/bin/env python
+
+# Programs that are runnable.
+ns3_runnable_programs = ['build/src/bridge/examples/ns3-dev-csma-bridge-debug', 'build/src/bridge/examples/ns3-dev-csma-bridge-one-hop-debug', 'build/src/config-store/examples/ns3-dev-config-store-save-debug', 'build/src/core/examples/ns3-dev-main-callback-debug', 'build/src/core/examples/ns3-dev-sample-simulator-debug', 'build/src/core/examples/ns3-dev-main-ptr-debug', 'build/src/core/examples/ns3-dev-main-random-variable-debug', 'build/src/core/examples/ns3-dev-main-random-variable-stream-debug', 'build/src/core/examples/ns3-dev-sample-random-variable-debug', 'build/src/core/examples/ns3-dev-sample-random-variable-stream-debug', 'build/src/core/examples/ns3-dev-command-line-example-debug', 'build/src/core/examples/ns3-dev-hash-example-debug', 'build/src/core/examples/ns3-dev-main-test-sync-debug', 'build/src/csma/examples/ns3-dev-csma-one-subnet-debug', 'build/src/csma/examples/ns3-dev-csma-broadcast-debug', 'build/src/csma/examples/ns3-dev-csma-packet-socket-debug', 'build/src/csma/examples/ns3-dev-csma-multicast-debug', 'build/src/csma/examples/ns3-dev-csma-raw-ip-socket-debug', 'build/src/csma/examples/ns3-dev-csma-ping-debug', 'build/src/energy/examples/ns3-dev-li-ion-energy-source-debug', 'build/src/energy/examples/ns3-dev-rv-battery-model-test-debug', 'build/src/energy/examples/ns3-dev-basic-energy-model-test-debug', 'build/src/internet/examples/ns3-dev-main-simple-debug', 'build/src/internet/examples/ns3-dev-codel-vs-droptail-basic-test-debug', 'build/src/internet/examples/ns3-dev-codel-vs-droptail-asymmetric-debug', 'build/src/mobility/examples/ns3-dev-main-grid-topology-debug', 'build/src/mobility/examples/ns3-dev-main-random-topology-debug', 'build/src/mobility/examples/ns3-dev-main-random-walk-debug', 'build/src/mobility/examples/ns3-dev-mobility-trace-example-debug', 'build/src/mobility/examples/ns3-dev-ns2-mobility-trace-debug', 'build/src/mobility/examples/ns3-dev-bonnmotion-ns2-example-debug', 'build/src/mpi/examples/ns3-dev-third-distributed-debug', 'build/src/network/examples/ns3-dev-main-packet-header-debug', 'build/src/network/examples/ns3-dev-main-packet-tag-debug', 'build/src/network/examples/ns3-dev-red-tests-debug', 'build/src/network/examples/ns3-dev-packet-socket-apps-debug', 'build/src/point-to-point/examples/ns3-dev-main-attribute-value-debug', 'build/src/propagation/examples/ns3-dev-main-propagation-loss-debug', 'build/src/propagation/examples/ns3-dev-jakes-propagation-model-example-debug', 'build/src/spectrum/examples/ns3-dev-adhoc-aloha-ideal-phy-debug', 'build/src/spectrum/examples/ns3-dev-adhoc-aloha-ideal-phy-matrix-propagation-loss-model-debug', 'build/src/spectrum/examples/ns3-dev-adhoc-aloha-ideal-phy-with-microwave-oven-debug', 'build/src/spectrum/examples/ns3-dev-tv-trans-example-debug', 'build/src/spectrum/examples/ns3-dev-tv-trans-regional-example-debug', 'build/src/stats/examples/ns3-dev-gnuplot-example-debug', 'build/src/stats/examples/ns3-dev-double-probe-example-debug', 'build/src/stats/examples/ns3-dev-time-probe-example-debug', 'build/src/stats/examples/ns3-dev-gnuplot-aggregator-example-debug', 'build/src/stats/examples/ns3-dev-gnuplot-helper-example-debug', 'build/src/stats/examples/ns3-dev-file-aggregator-example-debug', 'build/src/stats/examples/ns3-dev-file-helper-example-debug', 'build/src/traffic-control/examples/ns3-dev-traffic-control-debug', 'build/src/wifi/examples/ns3-dev-wifi-phy-test-debug', 'build/src/wifi/examples/ns3-dev-test-interference-helper-debug', 'build/examples/tcp/ns3-dev-tcp-large-transfer-debug', 'build/examples/tcp/ns3-dev-tcp-nsc-lfn-debug', 'build/examples/tcp/ns3-dev-tcp-nsc-zoo-debug', 'build/examples/tcp/ns3-dev-tcp-star-server-debug', 'build/examples/tcp/ns3-dev-tcp-bulk-send-debug', 'build/examples/tcp/ns3-dev-tcp-nsc-comparison-debug', 'build/examples/tcp/ns3-dev-tcp-variants-comparison-debug', 'build/examples/tcp/ns3-dev-tcp-experimental-variants-comparison-debug', 'build/examples/tcp/ns3-dev-tcp-variants-sweep-debug', 'build/examples/energy/ns3-dev-energy-model-example-debug', 'build/examples/energy/ns3-dev-energy-model-with-harvesting-example-debug', 'build/examples/routing/ns3-dev-dynamic-global-routing-debug', 'build/examples/routing/ns3-dev-static-routing-slash32-debug', 'build/examples/routing/ns3-dev-global-routing-slash32-debug', 'build/examples/routing/ns3-dev-global-injection-slash32-debug', 'build/examples/routing/ns3-dev-simple-global-routing-debug', 'build/examples/routing/ns3-dev-simple-alternate-routing-debug', 'build/examples/routing/ns3-dev-mixed-global-routing-debug', 'build/examples/routing/ns3-dev-simple-routing-ping6-debug', 'build/examples/routing/ns3-dev-ripng-simple-network-debug', 'build/examples/stats/ns3-dev-wifi-example-sim-debug', 'build/examples/udp-client-server/ns3-dev-udp-client-server-debug', 'build/examples/udp-client-server/ns3-dev-udp-trace-client-server-debug', 'build/examples/error-model/ns3-dev-simple-error-model-debug', 'build/examples/wireless/ns3-dev-wifi-adhoc-debug', 'build/examples/wireless/ns3-dev-wifi-clear-channel-cmu-debug', 'build/examples/wireless/ns3-dev-wifi-ap-debug', 'build/examples/wireless/ns3-dev-wifi-wired-bridging-debug', 'build/examples/wireless/ns3-dev-simple-msdu-aggregation-debug', 'build/examples/wireless/ns3-dev-wifi-simple-adhoc-debug', 'build/examples/wireless/ns3-dev-wifi-simple-infra-debug', 'build/examples/wireless/ns3-dev-wifi-simple-interference-debug', 'build/examples/wireless/ns3-dev-wifi-blockack-debug', 'build/examples/wireless/ns3-dev-ofdm-validation-debug', 'build/examples/wireless/ns3-dev-ofdm-ht-validation-debug', 'build/examples/wireless/ns3-dev-ofdm-vht-validation-debug', 'build/examples/wireless/ns3-dev-wifi-hidden-terminal-debug', 'build/examples/wireless/ns3-dev-ht-wifi-network-debug', 'build/examples/wireless/ns3-dev-vht-wifi-network-debug', 'build/examples/wireless/ns3-dev-wifi-timing-attributes-debug', 'build/examples/wireless/ns3-dev-wifi-sleep-debug', 'build/examples/wireless/ns3-dev-power-adaptation-distance-debug', 'build/examples/wireless/ns3-dev-power-adaptation-interference-debug', 'build/examples/wireless/ns3-dev-rate-adaptation-distance-debug', 'build/examples/wireless/ns3-dev-simple-mpdu-aggregation-debug', 'build/examples/wireless/ns3-dev-simple-two-level-aggregation-debug', 'build/examples/wireless/ns3-dev-simple-ht-hidden-stations-debug', 'build/examples/tutorial/ns3-dev-hello-simulator-debug', 'build/examples/tutorial/ns3-dev-first-debug', 'build/examples/tutorial/ns3-dev-second-debug', 'build/examples/tutorial/ns3-dev-third-debug', 'build/examples/tutorial/ns3-dev-fourth-debug', 'build/examples/tutorial/ns3-dev-fifth-debug', 'build/examples/tutorial/ns3-dev-sixth-debug', 'build/examples/tutorial/ns3-dev-seventh-debug', 'build/examples/udp/ns3-dev-udp-echo-debug', 'build/examples/socket/ns3-dev-socket-bound-static-routing-debug', 'build/examples/socket/ns3-dev-socket-bound-tcp-static-routing-debug', 'build/examples/socket/ns3-dev-socket-options-ipv4-debug', 'build/examples/socket/ns3-dev-socket-options-ipv6-debug', 'build/examples/realtime/ns3-dev-realtime-udp-echo-debug', 'build/examples/naming/ns3-dev-object-names-debug', 'build/examples/ipv6/ns3-dev-icmpv6-redirect-debug', 'build/examples/ipv6/ns3-dev-ping6-debug', 'build/examples/ipv6/ns3-dev-radvd-debug', 'build/examples/ipv6/ns3-dev-radvd-two-prefix-debug', 'build/examples/ipv6/ns3-dev-test-ipv6-debug', 'build/examples/ipv6/ns3-dev-fragmentation-ipv6-debug', 'build/examples/ipv6/ns3-dev-fragmentation-ipv6-two-MTU-debug', 'build/examples/ipv6/ns3-dev-loose-routing-ipv6-debug', 'build/scratch/subdir/ns3-dev-subdir-debug', 'build/scratch/ns3-dev-scratch-simulator-debug']
+
+# Scripts that are runnable.
+ns3_runnable_scripts = ['csma-bridge.py', 'sample-simulator.py', 'simple-routing-ping6.py', 'wifi-ap.py', 'first.py', 'second.py', 'third.py', 'realtime-udp-echo.py']
+
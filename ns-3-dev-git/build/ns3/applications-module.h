@@ -0,0 +1,34 @@
+
+#ifdef NS3_MODULE_COMPILATION
+# error "Do not include ns3 module aggregator headers from other modules; these are meant only for end user scripts."
+#endif
+
+#ifndef NS3_MODULE_APPLICATIONS
+    
+
+// Module headers:
+#include "application-packet-probe.h"
+#include "bulk-send-application.h"
+#include "bulk-send-helper.h"
+#include "on-off-helper.h"
+#include "onoff-application.h"
+#include "packet-loss-counter.h"
+#include "packet-sink-helper.h"
+#include "packet-sink.h"
+#include "ping6-helper.h"
+#include "ping6.h"
+#include "radvd-helper.h"
+#include "radvd-interface.h"
+#include "radvd-prefix.h"
+#include "radvd.h"
+#include "seq-ts-header.h"
+#include "udp-client-server-helper.h"
+#include "udp-client.h"
+#include "udp-echo-client.h"
+#include "udp-echo-helper.h"
+#include "udp-echo-server.h"
+#include "udp-server.h"
+#include "udp-trace-client.h"
+#include "v4ping-helper.h"
+#include "v4ping.h"
+#endif
@@ -0,0 +1,263 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright 2007 University of Washington
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author:  Craig Dowell (craigdo@ee.washington.edu)
+ */
+
+#ifndef CANDIDATE_QUEUE_H
+#define CANDIDATE_QUEUE_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+class SPFVertex;
+
+/**
+ * \brief A Candidate Queue used in static routing.
+ *
+ * The CandidateQueue is used in the OSPF shortest path computations.  It
+ * is a priority queue used to store candidates for the shortest path to a
+ * given network.
+ *
+ * The queue holds Shortest Path First Vertex pointers and orders them
+ * according to the lowest value of the field m_distanceFromRoot.  Remaining
+ * vertices are ordered according to increasing distance.  This implements a
+ * priority queue.
+ *
+ * Although a STL priority_queue almost does what we want, the requirement
+ * for a Find () operation, the dynamic nature of the data and the derived
+ * requirement for a Reorder () operation led us to implement this simple 
+ * enhanced priority queue.
+ *
+ * The queue is an indexed binary heap, so that Push (), Pop () and
+ * DecreaseKey () cost a logarithmic time.  The vertices of equal priority
+ * are popped in the order they were pushed or their distance decreased.
+ * The positions in the heap are kept in an array by vertex index, so the
+ * queue holds at most one vertex of each index, and the vertices without
+ * an index can be neither found nor decreased.
+ */
+class CandidateQueue
+{
+public:
+/**
+ * @brief Create an empty SPF Candidate Queue.
+ *
+ * @see SPFVertex
+ */
+  CandidateQueue ();
+
+/**
+ * @brief Destroy an SPF Candidate Queue and release any resources held 
+ * by the contents.
+ *
+ * @see SPFVertex
+ */
+  virtual ~CandidateQueue ();
+
+/**
+ * @brief Empty the Candidate Queue and release all of the resources 
+ * associated with the Shortest Path First Vertex pointers in the queue.
+ *
+ * @see SPFVertex
+ */
+  void Clear (void);
+
+/**
+ * @brief Push a Shortest Path First Vertex pointer onto the queue according
+ * to the priority scheme.
+ * 
+ * On completion, the top of the queue will hold the Shortest Path First
+ * Vertex pointer that points to a vertex having lowest value of the field
+ * m_distanceFromRoot.  Remaining vertices are ordered according to 
+ * increasing distance.
+ *
+ * @see SPFVertex
+ * @param vNew The Shortest Path First Vertex to add to the queue.
+ */
+  void Push (SPFVertex *vNew);
+
+/**
+ * @brief Pop the Shortest Path First Vertex pointer at the top of the queue.
+ *
+ * The caller is given the responsibility for releasing the resources 
+ * associated with the vertex.
+ *
+ * @see SPFVertex
+ * @see Top ()
+ * @returns The Shortest Path First Vertex pointer at the top of the queue.
+ */
+  SPFVertex* Pop (void);
+
+/**
+ * @brief Return the Shortest Path First Vertex pointer at the top of the 
+ * queue.
+ *
+ * This method does not pop the SPFVertex* off of the queue, it simply 
+ * returns the pointer.
+ *
+ * @see SPFVertex
+ * @see Pop ()
+ * @returns The Shortest Path First Vertex pointer at the top of the queue.
+ */
+  SPFVertex* Top (void) const;
+
+/**
+ * @brief Test the Candidate Queue to determine if it is empty.
+ *
+ * @returns True if the queue is empty, false otherwise.
+ */
+  bool Empty (void) const;
+
+/**
+ * @brief Return the number of Shortest Path First Vertex pointers presently
+ * stored in the Candidate Queue.
+ *
+ * @see SPFVertex
+ * @returns The number of SPFVertex* pointers in the Candidate Queue.
+ */
+  uint32_t Size (void) const;
+
+/**
+ * @brief Searches the Candidate Queue for a Shortest Path First Vertex 
+ * pointer that points to a vertex having the given index.
+ *
+ * @see SPFVertex::GetVertexIndex ()
+ * @param index The vertex index to search for.
+ * @returns The SPFVertex* pointer corresponding to the given index, or 0
+ * if there is none in the queue.
+ */
+  SPFVertex* Find (uint32_t index) const;
+
+/**
+ * @brief Reorders the Candidate Queue according to the priority scheme.
+ * 
+ * On completion, the top of the queue will hold the Shortest Path First
+ * Vertex pointer that points to a vertex having lowest value of the field
+ * m_distanceFromRoot.  Remaining vertices are ordered according to 
+ * increasing distance.
+ *
+ * This method is provided in case the values of m_distanceFromRoot change
+ * during the routing calculations.
+ *
+ * @see SPFVertex
+ */
+  void Reorder (void);
+
+/**
+ * @brief Restores the priority order after the m_distanceFromRoot of a
+ * vertex of the queue has been lowered.
+ *
+ * This is the cheap version of Reorder (), when a single vertex has been
+ * given a shorter path.  Among the vertices of equal priority, the vertex
+ * is then popped last, as if it had been pushed again.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex whose distance was lowered.
+ */
+  void DecreaseKey (SPFVertex *v);
+
+private:
+/**
+ * Candidate Queue copy construction is disallowed (not implemented) to 
+ * prevent the compiler from slipping in incorrect versions that don't
+ * properly deal with deep copies.
+ * \param sr object to copy
+ */
+  CandidateQueue (CandidateQueue& sr);
+
+/**
+ * Candidate Queue assignment operator is disallowed (not implemented) to
+ * prevent the compiler from slipping in incorrect versions that don't
+ * properly deal with deep copies.
+ * \param sr object to assign
+ * \return copied object
+ */
+  CandidateQueue& operator= (CandidateQueue& sr);
+/**
+ * \brief return true if v1 < v2
+ *
+ * SPFVertexes are added into the queue according to the ordering
+ * defined by this method. If v1 should be popped before v2, this 
+ * method return true; false otherwise
+ *
+ * \param v1 first operand
+ * \param v2 second operand
+ * \return True if v1 should be popped before v2; false otherwise
+ */
+  static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
+
+/**
+ * \brief A vertex of the heap.
+ */
+  struct Candidate
+  {
+    SPFVertex *vertex; //!< The vertex
+    uint64_t order;    //!< When the vertex was pushed or decreased
+  };
+
+/**
+ * \brief return true if c1 should be popped before c2
+ *
+ * \param c1 first operand
+ * \param c2 second operand
+ * \return True if c1 should be popped before c2; false otherwise
+ */
+  static bool CompareCandidate (const Candidate &c1, const Candidate &c2);
+
+/**
+ * \brief Put a candidate at a position of the heap and index it.
+ * \param i the position
+ * \param c the candidate
+ */
+  void Place (uint32_t i, const Candidate &c);
+
+/**
+ * \brief Move a candidate towards the top of the heap.
+ * \param i the position of the candidate
+ */
+  void SiftUp (uint32_t i);
+
+/**
+ * \brief Move a candidate towards the bottom of the heap.
+ * \param i the position of the candidate
+ */
+  void SiftDown (uint32_t i);
+
+  static const uint32_t NOT_QUEUED = 0xffffffff; //!< The position of the indices without a candidate
+
+  typedef std::vector<Candidate> CandidateList_t; //!< container of the heap
+  CandidateList_t m_candidates;  //!< SPFVertex candidates, as a binary heap
+  /// The position in the heap of the candidate of each vertex index
+  std::vector<uint32_t> m_positions;
+  uint64_t m_order; //!< The number of pushes and decreases
+
+  /**
+   * \brief Stream insertion operator.
+   *
+   * \param os the reference to the output stream
+   * \param q the CandidateQueue
+   * \returns the reference to the output stream
+   */
+  friend std::ostream& operator<< (std::ostream& os, const CandidateQueue& q);
+};
+
+} // namespace ns3
+
+#endif /* CANDIDATE_QUEUE_H */
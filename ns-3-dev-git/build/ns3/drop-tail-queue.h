@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2007 University of Washington
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DROPTAIL_H
+#define DROPTAIL_H
+
+#include <vector>
+#include "ns3/packet.h"
+#include "ns3/queue.h"
+
+namespace ns3 {
+
+class TraceContainer;
+
+/**
+ * \ingroup queue
+ *
+ * \brief A FIFO packet queue that drops tail-end packets on overflow
+ *
+ * The packets are kept in a ring buffer whose capacity is a power of two.
+ * In packet mode the ring is sized for MaxPackets (up to 4096 packets)
+ * on the first enqueue, so that it does not reallocate; otherwise it
+ * doubles when full.
+ */
+class DropTailQueue : public Queue {
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  /**
+   * \brief DropTailQueue Constructor
+   *
+   * Creates a droptail queue with a maximum size of 100 packets by default
+   */
+  DropTailQueue ();
+
+  virtual ~DropTailQueue();
+
+  /**
+   * Set the operating mode of this device.
+   *
+   * \param mode The operating mode of this device.
+   *
+   */
+  void SetMode (DropTailQueue::QueueMode mode);
+
+  /**
+   * Get the encapsulation mode of this device.
+   *
+   * \returns The encapsulation mode of this device.
+   */
+  DropTailQueue::QueueMode GetMode (void) const;
+
+private:
+  virtual bool DoEnqueue (Ptr<Packet> p);
+  virtual Ptr<Packet> DoDequeue (void);
+  virtual Ptr<const Packet> DoPeek (void) const;
+  virtual uint32_t DoDequeueBurst (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets);
+
+  /**
+   * Reallocate the ring buffer so that it holds at least the given
+   * number of packets, keeping the packets in the queue.
+   *
+   * \param capacity the number of packets to hold
+   */
+  void Reserve (uint32_t capacity);
+  /**
+   * Remove the front packet from the ring buffer.
+   *
+   * \return the packet
+   */
+  Ptr<Packet> Pop (void);
+
+  std::vector<Ptr<Packet> > m_ring;   //!< the slots of the ring buffer
+  uint32_t m_head;                    //!< slot of the front packet
+  uint32_t m_count;                   //!< packets in the ring buffer
+  uint32_t m_maxPackets;              //!< max packets in the queue
+  uint32_t m_maxBytes;                //!< max bytes in the queue
+  uint32_t m_bytesInQueue;            //!< actual bytes in the queue
+  QueueMode m_mode;                   //!< queue mode (packets or bytes limited)
+};
+
+} // namespace ns3
+
+#endif /* DROPTAIL_H */
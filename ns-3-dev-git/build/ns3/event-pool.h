@@ -0,0 +1,112 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_POOL_H
+#define EVENT_POOL_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <ostream>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventPool declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup events
+ * \brief The allocator of the simulation events.
+ *
+ * Every EventImpl, and so every event built by MakeEvent, is allocated
+ * from this pool. The pool serves the sizes up to 256 bytes from free
+ * lists of 16 byte size classes; a free list keeps at most 1 MB, or 16
+ * blocks, and returns the other blocks to the system. Larger events fall
+ * back to the global operator new.
+ *
+ * When threading is enabled each thread has its own pool, so that the
+ * real time simulator and the threads scheduling events in it do not
+ * contend for a lock. An event released by another thread than the one
+ * which allocated it goes to the pool of the releasing thread, and the
+ * pool of a thread which exits is taken over by the next thread created.
+ *
+ * The pool is disabled, for instance to track the events with valgrind,
+ * by setting the "EventPoolEnabled" global value to false before the
+ * first event is scheduled.
+ */
+class EventPool
+{
+public:
+  /** Counters of the event pools, summed over all the threads. */
+  struct Stats
+  {
+    uint64_t allocations; //!< Number of events allocated
+    uint64_t reused;      //!< Allocations served from a free list
+    uint64_t large;       //!< Allocations too large for the size classes
+    uint64_t live;        //!< Number of events allocated and not released
+    /**
+     * Highest number of live events of the pool of a single thread. The
+     * pools do not share a counter: with several threads, this is the
+     * peak of the busiest one, not of the simulation.
+     */
+    uint64_t peakLive;
+    uint64_t cached;      //!< Bytes of the blocks held by the free lists
+
+    /**
+     * \returns The fraction of the allocations served from a free list.
+     */
+    double GetReuseRate (void) const;
+  };
+
+  /**
+   * Allocate the memory of an event.
+   *
+   * \param [in] size The size of the event.
+   * \returns The memory of the event.
+   */
+  static void * Allocate (std::size_t size);
+  /**
+   * Release the memory of an event.
+   *
+   * \param [in] p The memory of the event.
+   * \param [in] size The size of the event, as given to Allocate().
+   */
+  static void Deallocate (void *p, std::size_t size);
+  /**
+   * \returns \c true if the events are allocated from the pool.
+   */
+  static bool IsEnabled (void);
+  /**
+   * \returns The counters of the event pools.
+   */
+  static Stats GetStats (void);
+};
+
+/**
+ * \ingroup events
+ * Output streamer for the counters of the event pools.
+ *
+ * \param [in,out] os The output stream.
+ * \param [in] stats The counters.
+ * \returns The stream.
+ */
+std::ostream & operator << (std::ostream &os, const EventPool::Stats &stats);
+
+} // namespace ns3
+
+#endif /* EVENT_POOL_H */
@@ -0,0 +1,193 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FQ_CODEL_QUEUE_DISC_H
+#define FQ_CODEL_QUEUE_DISC_H
+
+#include <list>
+#include <vector>
+#include "ns3/nstime.h"
+#include "queue-disc.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ * \brief The FlowQueue-CoDel queue disc (RFC 8290).
+ *
+ * The items are classified into Flows queues by the hash of their flow.
+ * Each queue is managed by CoDel, and the queues are served by a deficit
+ * round robin which gives precedence to the new flows, those which
+ * just became active.  The queues are kept in two lists threaded
+ * through the queues themselves, so enqueueing and dequeueing an item
+ * take a constant time whatever the number of flows.
+ *
+ * When the queue disc holds more than PacketLimit items, items are
+ * dropped from the head of the queue holding the most bytes until half
+ * of its bytes, or DropBatchSize items, are gone.  Finding that queue
+ * scans the flows, but only happens when the queue disc overflows.
+ *
+ * With UseEcn, CoDel marks the ECN-capable items with CE instead of
+ * dropping them.  A non-zero CeThreshold marks besides every ECN-capable
+ * item which waited longer than the threshold, whatever the state of
+ * CoDel; this is the step marking at a threshold K which DCTCP expects
+ * from the switches, expressed as a sojourn time as in Linux.
+ */
+class FqCoDelQueueDisc : public QueueDisc
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  FqCoDelQueueDisc ();
+  virtual ~FqCoDelQueueDisc ();
+
+  /**
+   * \return the number of items dropped because the queue disc was full
+   */
+  uint32_t GetOverlimitDrops (void) const;
+  /**
+   * \return the number of items dropped by CoDel
+   */
+  uint32_t GetCoDelDrops (void) const;
+  /**
+   * \return the number of items marked by CoDel instead of being dropped
+   */
+  uint32_t GetCoDelMarks (void) const;
+  /**
+   * \return the number of items marked because their sojourn time
+   * exceeded CeThreshold
+   */
+  uint32_t GetCeThresholdMarks (void) const;
+  /**
+   * \return the number of flows in the lists of the round robin
+   */
+  uint32_t GetNActiveFlows (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// The status of a flow queue
+  enum FlowStatus
+  {
+    INACTIVE,  //!< the queue is empty and in no list
+    NEW_FLOW,  //!< the queue is in the list of the new flows
+    OLD_FLOW   //!< the queue is in the list of the old flows
+  };
+
+  /// A flow queue with its CoDel state
+  struct Flow
+  {
+    Flow ();
+    std::list<Ptr<QueueDiscItem> > m_items; //!< the items
+    uint32_t m_backlog;       //!< the bytes of the items
+    int32_t m_deficit;        //!< the deficit of the round robin
+    FlowStatus m_status;      //!< the list the flow is in
+    uint32_t m_next;          //!< the next flow of the list
+    bool m_dropping;          //!< CoDel is in the dropping state
+    uint32_t m_count;         //!< CoDel drops since entering the dropping state
+    uint32_t m_lastCount;     //!< CoDel count when the dropping state was last left
+    uint16_t m_recInvSqrt;    //!< CoDel reciprocal inverse square root of m_count
+    uint32_t m_firstAboveTime; //!< CoDel time at which the sojourn time went above target for interval
+    uint32_t m_dropNext;      //!< CoDel time of the next drop
+  };
+
+  /// A list of flows threaded through Flow::m_next
+  struct FlowList
+  {
+    uint32_t m_head; //!< the first flow, NO_FLOW if the list is empty
+    uint32_t m_tail; //!< the last flow
+  };
+
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+
+  /**
+   * Dequeue the next item of a flow, through its CoDel.
+   * \param flow the flow
+   * \return the item, or 0 if CoDel dropped all the items of the flow
+   */
+  Ptr<QueueDiscItem> CoDelDequeue (Flow &flow);
+  /**
+   * Remove the head item of a flow.
+   * \param flow the flow
+   * \return the item
+   */
+  Ptr<QueueDiscItem> PopItem (Flow &flow);
+  /**
+   * Decide whether CoDel may drop an item.
+   * \param flow the flow of the item
+   * \param item the item, removed from the flow
+   * \param now the CoDel time
+   * \return true if the sojourn time has been above target for interval
+   */
+  bool OkToDrop (Flow &flow, Ptr<QueueDiscItem> item, uint32_t now);
+  /**
+   * Update the reciprocal inverse square root of the count of a flow.
+   * \param flow the flow
+   */
+  void NewtonStep (Flow &flow);
+  /**
+   * \param flow the flow
+   * \param t a CoDel time
+   * \return the time of the next drop after t
+   */
+  uint32_t ControlLaw (const Flow &flow, uint32_t t) const;
+  /**
+   * Drop items from the head of the flow holding the most bytes.
+   */
+  void FatFlowDrop (void);
+
+  /**
+   * Append a flow to a list.
+   * \param list the list
+   * \param index the flow
+   */
+  void PushBack (FlowList &list, uint32_t index);
+  /**
+   * Remove the first flow of a list.
+   * \param list the list
+   */
+  void PopFront (FlowList &list);
+
+  Time m_interval;           //!< CoDel interval
+  Time m_target;             //!< CoDel target
+  uint32_t m_limit;          //!< most items held
+  uint32_t m_nFlows;         //!< number of flow queues
+  uint32_t m_quantum;        //!< bytes served from a flow per round
+  uint32_t m_minBytes;       //!< fewest bytes held for CoDel to drop
+  uint32_t m_dropBatchSize;  //!< most items dropped at once on overflow
+  uint32_t m_perturbation;   //!< mixed in the hash of the flows
+  bool m_useEcn;             //!< CoDel marks instead of dropping
+  Time m_ceThreshold;        //!< sojourn time above which the items are marked (0 disables)
+
+  std::vector<Flow> m_flows; //!< the flow queues, created on the first item
+  FlowList m_newFlows;       //!< the new flows
+  FlowList m_oldFlows;       //!< the old flows
+  uint32_t m_nActiveFlows;   //!< flows in a list
+  uint32_t m_overlimitDrops; //!< items dropped on overflow
+  uint32_t m_codelDrops;     //!< items dropped by CoDel
+  uint32_t m_codelMarks;     //!< items marked by CoDel
+  uint32_t m_ceThresholdMarks; //!< items marked above CeThreshold
+};
+
+} // namespace ns3
+
+#endif /* FQ_CODEL_QUEUE_DISC_H */
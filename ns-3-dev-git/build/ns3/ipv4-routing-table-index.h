@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV4_ROUTING_TABLE_INDEX_H
+#define IPV4_ROUTING_TABLE_INDEX_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/ipv4-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Index of the destinations of a routing table, finding all the
+ * routes which match an address without walking the table.
+ *
+ * The routes are identified by their position in the table.  They are
+ * grouped by mask, each group being sorted by network, so that a lookup
+ * costs a binary search per distinct mask of the table: a few for the
+ * tables built by the routing protocols, whatever the number of routes.
+ * The masks need not be contiguous.
+ *
+ * A lookup gives all the matching routes in the order of the table, so
+ * that the routing protocols keep choosing among them as they did while
+ * walking the table, be it the first match, the longest prefix or a
+ * random equal cost route.
+ */
+class Ipv4RoutingTableIndex
+{
+public:
+  Ipv4RoutingTableIndex ();
+
+  /**
+   * \brief Remove all the routes.
+   */
+  void Clear (void);
+
+  /**
+   * \brief Add the next route of the table.
+   *
+   * The position of the route is the number of routes added before it.
+   *
+   * \param network the destination network of the route
+   * \param mask the mask of the destination network
+   */
+  void Add (Ipv4Address network, Ipv4Mask mask);
+
+  /**
+   * \brief Find the routes which match a destination.
+   * \param dest the destination
+   * \param [out] positions the positions of the matching routes, in
+   * increasing order
+   */
+  void Lookup (Ipv4Address dest, std::vector<uint32_t> &positions);
+
+  /**
+   * \returns the number of routes added
+   */
+  uint32_t GetN (void) const;
+
+private:
+  /**
+   * \brief A route of a group.
+   */
+  struct Entry
+  {
+    uint32_t network;  //!< The masked destination network
+    uint32_t position; //!< The position of the route in the table
+    /**
+     * \param o another entry
+     * \returns true if this entry comes first in the group
+     */
+    bool operator < (const Entry &o) const
+    {
+      return network < o.network || (network == o.network && position < o.position);
+    }
+  };
+
+  /**
+   * \brief The routes with the same mask.
+   */
+  struct Group
+  {
+    uint32_t mask;              //!< The mask of the routes
+    std::vector<Entry> entries; //!< The routes, sorted once indexed
+  };
+
+  std::vector<Group> m_groups; //!< The groups of routes
+  uint32_t m_nRoutes;          //!< The number of routes added
+  bool m_sorted;               //!< The groups are sorted
+};
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTING_TABLE_INDEX_H */
@@ -0,0 +1,248 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <set>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the Ladder Queue of Tang, Goh and Thng,
+ * "Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation", ACM TOMACS 15(3), 2005. The events are kept
+ * in three tiers:
+ *
+ *   - Top: an unsorted array of the events beyond the range of the ladder;
+ *   - Ladder: up to eight rungs of buckets, each rung splitting one bucket
+ *     of the rung above into finer buckets;
+ *   - Bottom: a small sorted array of the earliest events.
+ *
+ * Events are dequeued from the bottom. When it is empty, the first
+ * non-empty bucket of the lowest rung is sorted into it, unless it holds
+ * more events than the threshold, in which case it is spread over a new
+ * rung. When the ladder is empty, the top becomes its first rung, with a
+ * bucket width estimated from a sample of the time stamps so that the
+ * dense part of the event set gets about one event per bucket. A bottom
+ * which grows beyond twice the threshold is also spread over a new rung.
+ *
+ * Contrary to the original algorithm, the buckets of a rung are not
+ * linked lists of events but chains through one array per rung, which is
+ * recycled with the rung, so that the scheduler does not allocate memory
+ * once it has reached its working size.
+ *
+ * As in ns3::DaryHeapScheduler, Remove only marks the event as removed,
+ * and removed events are dropped when they reach the bottom, or when
+ * the removed events outnumber the live ones.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Sorting key of an event and the slot of its data. */
+  struct Node
+  {
+    uint64_t m_ts;   //!< Event time stamp
+    uint32_t m_uid;  //!< Event unique id
+    uint32_t m_slot; //!< Index of the event in m_slots
+  };
+
+  /** Orders the nodes from the latest to the earliest. */
+  struct Later
+  {
+    /**
+     * \param [in] a The first node.
+     * \param [in] b The second node.
+     * \returns \c true if \c a is after \c b
+     */
+    bool operator () (const Node &a, const Node &b) const;
+  };
+
+  /** Entry of the index from the uids to the slots. */
+  struct IndexEntry
+  {
+    uint32_t m_uid;  //!< Event unique id
+    uint32_t m_slot; //!< Index of the event in m_slots
+  };
+
+  /** Event data which does not take part in the ordering. */
+  struct Slot
+  {
+    EventImpl *m_impl;  //!< Event implementation
+    uint32_t m_context; //!< Event context
+    uint32_t m_next;    //!< Next free slot, or marker of a removed event
+  };
+
+  /**
+   * A rung of the ladder. The buckets are chains of nodes through
+   * m_nodes, linked by m_next.
+   */
+  struct Rung
+  {
+    uint64_t m_start;               //!< Time stamp of the start of the first bucket
+    uint64_t m_width;               //!< Width of the buckets
+    uint32_t m_current;             //!< First bucket not yet dequeued
+    std::vector<Node> m_nodes;      //!< Nodes of all the buckets
+    std::vector<uint32_t> m_next;   //!< Next node of the same bucket
+    std::vector<uint32_t> m_head;   //!< First node of each bucket
+    std::vector<uint32_t> m_count;  //!< Number of nodes of each bucket
+  };
+
+  /**
+   * Set up a rung.
+   *
+   * \param [in] rung The index of the rung.
+   * \param [in] start The time stamp of the start of the first bucket.
+   * \param [in] width The width of the buckets.
+   * \param [in] buckets The number of buckets.
+   */
+  void InitRung (uint32_t rung, uint64_t start, uint64_t width, uint32_t buckets);
+  /**
+   * Get the start of the first bucket of a rung not yet dequeued: the
+   * earliest time stamp an event inserted in the rung may have.
+   *
+   * \param [in] rung The index of the rung.
+   * \returns The start of the current bucket.
+   */
+  uint64_t GetCurrentStart (uint32_t rung) const;
+  /**
+   * Add a node to the bucket of its time stamp.
+   *
+   * \param [in] rung The index of the rung.
+   * \param [in] node The node.
+   */
+  void AddToRung (uint32_t rung, const Node &node);
+  /**
+   * Estimate the bucket width of a new rung holding a set of events.
+   *
+   * \param [in] nodes The events.
+   * \param [in] min The earliest time stamp the rung covers.
+   * \param [in] max The latest time stamp the rung covers.
+   * \returns The bucket width.
+   */
+  uint64_t EstimateWidth (const std::vector<Node> &nodes, uint64_t min, uint64_t max) const;
+  /**
+   * Store a node in the tier of its time stamp.
+   *
+   * \param [in] node The node.
+   */
+  void Place (const Node &node);
+  /**
+   * Spread the bottom over a new rung.
+   */
+  void SpreadBottom (void);
+  /**
+   * Fill the empty bottom with the earliest events.
+   */
+  void Refill (void);
+  /**
+   * Make the earliest live event the last node of the bottom.
+   */
+  void Purge (void);
+  /** Drop all the removed events. */
+  void Compact (void);
+  /** Drop everything once no live event remains. */
+  void Reset (void);
+
+  /**
+   * Check if an event has been removed.
+   *
+   * \param [in] node The node of the event.
+   * \returns \c true if the node is a tombstone.
+   */
+  bool IsRemoved (const Node &node) const;
+  /**
+   * Release the slot of a removed event.
+   *
+   * \param [in] node The node of the event.
+   */
+  void DropRemoved (const Node &node);
+  /**
+   * Rebuild the index from the uids to the slots with a new size.
+   *
+   * \param [in] size The number of entries, a power of two.
+   */
+  void ResizeIndex (uint32_t size);
+  /**
+   * Store the data of an event.
+   *
+   * \param [in] ev The event.
+   * \returns The index of the slot.
+   */
+  uint32_t AllocateSlot (const Scheduler::Event &ev);
+  /**
+   * Release a slot.
+   *
+   * \param [in] slot The index of the slot.
+   */
+  void FreeSlot (uint32_t slot);
+  /**
+   * Rebuild an event from its node.
+   *
+   * \param [in] node The node.
+   * \returns The event.
+   */
+  Scheduler::Event GetEvent (const Node &node) const;
+
+  std::vector<Node> m_top;      //!< Events beyond the ladder, unsorted
+  uint64_t m_topMin;            //!< Earliest time stamp of m_top
+  uint64_t m_topMax;            //!< Latest time stamp of m_top
+  uint64_t m_topStart;          //!< Earliest time stamp inserted in m_top
+  std::vector<Rung> m_rungs;    //!< Rungs, the used ones and spare ones
+  uint32_t m_nRungs;            //!< Number of rungs in use
+  std::vector<Node> m_bottom;   //!< Earliest events, the earliest last
+  uint32_t m_live;              //!< Number of events not removed
+  uint32_t m_removedCount;      //!< Number of tombstones
+  std::vector<Slot> m_slots;    //!< Event data, indexed by Node::m_slot
+  uint32_t m_freeSlot;          //!< First free slot
+  std::vector<IndexEntry> m_index; //!< Slots indexed by the low bits of the uids
+  std::set<uint32_t> m_removed; //!< Uids of the tombstones missing from m_index
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
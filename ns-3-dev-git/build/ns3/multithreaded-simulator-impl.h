@@ -0,0 +1,296 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/ptr.h"
+
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+class SystemMutex;
+class SystemThread;
+
+/**
+ * \ingroup mpi
+ *
+ * \brief Conservative parallel simulator running the nodes in the
+ * threads of a single process.
+ *
+ * The nodes are split in partitions, each run by its own thread with its
+ * own event queue: the events of a node, found by their context, run in
+ * the thread of its partition. The partition of a node is its system id,
+ * as with DistributedSimulatorImpl, unless the "Partitions" attribute is
+ * set: the nodes are then spread over that many partitions, keeping
+ * together the nodes linked by other channels than point to point ones.
+ *
+ * The partitions only exchange events through the point to point
+ * channels which link them, so the smallest delay of these channels, the
+ * lookahead, bounds how far a thread can run ahead of the others. The
+ * threads run windows of simulation time: every event of a window is
+ * earlier than the earliest pending event of the simulation plus the
+ * lookahead, so that no partition can receive an event earlier than the
+ * end of the window. Between two windows the threads meet at a barrier.
+ *
+ * An event scheduled for another partition goes to a mailbox written by
+ * the sending thread only, and read by the receiving thread at the start
+ * of the next window: the mailboxes need no lock. The receiver drains
+ * them in the order of the sending partitions, so that the results do not
+ * depend on the timing of the threads, and a simulation gives the same
+ * results at every run with the same partitions.
+ *
+ * The events which belong to no node, such as those scheduled before
+ * Simulator::Run or with no context, run in the main thread, between two
+ * windows, when the partitions have run all the earlier events. They
+ * run before the events of the partitions which have the same time.
+ *
+ * While the partitions run, Multithreading is enabled so that the
+ * reference counts shared by the threads are updated atomically. The
+ * objects shared by the nodes, other than the point to point channels,
+ * must protect themselves, for instance with a MultithreadingMutex. The
+ * system id of a partition is its index, so that its packets get their
+ * uids from its own counter. The streams of the random variables created
+ * during the run, however, depend on the order in which the threads
+ * create them.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // Inherited
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns the number of partitions, zero before the first Run
+   */
+  uint32_t GetNPartitions (void) const;
+  /**
+   * \returns the lookahead between the partitions, computed by the
+   * first Run
+   */
+  Time GetLookAhead (void) const;
+
+private:
+  virtual void DoDispose (void);
+
+  /** The events and the clock of a partition. */
+  struct Partition
+  {
+    /** The event queue. */
+    Ptr<Scheduler> events;
+    /** Index of the partition, or the number of partitions for the global one. */
+    uint32_t index;
+    /** Next event unique id. */
+    uint32_t uid;
+    /** Unique id of the current event. */
+    uint32_t currentUid;
+    /** Timestamp of the current event. */
+    uint64_t currentTs;
+    /** Execution context of the current event. */
+    uint32_t currentContext;
+    /** Events inserted in the queue and not yet run. */
+    int unscheduledEvents;
+    /** Simulator::Stop was called by an event of the partition. */
+    bool stop;
+    /** Earliest stop time requested by the events of the partition. */
+    uint64_t stopTs;
+    /**
+     * Earliest event sent to other partitions during the windows of
+     * each parity.
+     */
+    uint64_t outboxTs[2];
+    /**
+     * Events sent to the other partitions during the windows of each
+     * parity, indexed by the destination partition.
+     */
+    std::vector<std::vector<Scheduler::Event> > outbox[2];
+    /** Sense of the last barrier crossed by the thread of the partition. */
+    bool barrierSense;
+    /** Keeps the partitions written by different threads on different cache lines. */
+    char padding[64];
+  };
+
+  /** Wrap an event scheduled by a thread which runs no partition. */
+  struct EventWithContext {
+    /** The event context. */
+    uint32_t context;
+    /** Event delay. */
+    uint64_t timestamp;
+    /** The event implementation. */
+    EventImpl *event;
+  };
+  /** Container type for the events scheduled by other threads. */
+  typedef std::list<struct EventWithContext> EventsWithContext;
+  /** Container type for the events to run at Simulator::Destroy() */
+  typedef std::list<EventId> DestroyEvents;
+
+  /**
+   * \param [in] index the index of the partition
+   * \returns a new partition, with an empty event queue
+   */
+  Partition *CreatePartition (uint32_t index);
+  /**
+   * Replace the event queue of a partition by a queue built by
+   * m_schedulerFactory, moving the events.
+   *
+   * \param [in] partition the partition
+   */
+  void CreateScheduler (Partition *partition);
+  /**
+   * Assign the nodes to the partitions, compute the lookahead and move
+   * the events of the nodes to the queues of their partitions.
+   */
+  void CreatePartitions (void);
+  /**
+   * Assign the nodes to \p n partitions, keeping together the nodes which
+   * are not linked by point to point channels with a delay.
+   *
+   * \param [in] n the number of partitions
+   */
+  void AssignPartitions (uint32_t n);
+  /**
+   * \param [in] context an event context
+   * \returns the partition which runs the events of the context
+   */
+  Partition *GetPartition (uint32_t context) const;
+  /**
+   * \returns the partition run by the current thread, or the global
+   * partition for the threads which run no partition
+   */
+  Partition *GetCurrent (void) const;
+  /**
+   * Insert an event in the queue of a partition.
+   *
+   * \param [in] partition the partition
+   * \param [in] ts the time of the event
+   * \param [in] context the context of the event
+   * \param [in] event the event
+   * \returns the unique id of the event
+   */
+  uint32_t Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event);
+  /**
+   * Move the events sent to a partition during the windows of a parity
+   * to its queue.
+   *
+   * \param [in] partition the destination partition
+   * \param [in] parity the parity of the windows
+   */
+  void DrainInbox (Partition *partition, uint32_t parity);
+  /** Move the events scheduled by other threads to their queues. */
+  void ProcessEventsWithContext (void);
+  /**
+   * Decide what to run next, running the global events which are due.
+   *
+   * \returns false when the run is over
+   */
+  bool NextWindow (void);
+  /**
+   * Run the events of a partition up to the end of the window.
+   *
+   * \param [in] partition the partition
+   */
+  void ProcessWindow (Partition *partition);
+  /**
+   * Wait for the threads of all the partitions.
+   *
+   * \param [in] partition the partition of the calling thread
+   */
+  void Barrier (Partition *partition);
+  /**
+   * Entry point of the threads of the partitions but the first.
+   *
+   * \param [in] simulator the simulator
+   * \param [in] partition the partition of the thread
+   */
+  static void RunPartition (MultithreadedSimulatorImpl *simulator, Partition *partition);
+
+  /** The partitions which run the nodes. */
+  std::vector<Partition *> m_partitions;
+  /** The partition of the events which belong to no node. */
+  Partition *m_global;
+  /** Partition of each node, indexed by node id. */
+  std::vector<uint32_t> m_partitionOfNode;
+  /** Number of partitions requested, or zero for the system ids. */
+  uint32_t m_nPartitions;
+  /** Lookahead between the partitions, in time steps. */
+  uint64_t m_lookAhead;
+  /** The factory of the event queues. */
+  ObjectFactory m_schedulerFactory;
+
+  /** Flag calling for the end of the simulation. */
+  bool m_stop;
+  /** The partitions are running a window. */
+  bool m_inWindow;
+  /** No more windows to run. */
+  bool m_done;
+  /** Number of windows run, whose parity selects the mailboxes. */
+  uint32_t m_window;
+  /** End of the current window, excluded. */
+  uint64_t m_windowEnd;
+  /** Number of threads which reached the barrier. */
+  uint32_t m_barrierCount;
+  /** Sense of the last barrier opened. */
+  volatile bool m_barrierSense;
+
+  /** The events scheduled by threads which run no partition. */
+  EventsWithContext m_eventsWithContext;
+  /** Flag \c true if m_eventsWithContext is empty. */
+  bool m_eventsWithContextEmpty;
+  /** Protects m_eventsWithContext and m_destroyEvents. */
+  SystemMutex *m_mutex;
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+  /** The threads of the partitions but the first. */
+  std::vector<Ptr<SystemThread> > m_threads;
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
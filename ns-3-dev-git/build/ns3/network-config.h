@@ -0,0 +1,13 @@
+/* WARNING! All changes made to this file will be lost! */
+
+#ifndef W_NS3_NETWORK_CONFIG_H_WAF
+#define W_NS3_NETWORK_CONFIG_H_WAF
+
+#define HAVE_SYS_IOCTL_H 1
+#define HAVE_IF_NETS_H 1
+#define HAVE_NET_ETHERNET_H 1
+#define HAVE_IF_TUN_H 1
+#define HAVE_PACKET_H 1
+#define HAVE_ZLIB 1
+
+#endif /* W_NS3_NETWORK_CONFIG_H_WAF */
@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUEUE_DISC_CONTAINER_H
+#define QUEUE_DISC_CONTAINER_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/queue-disc.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ * \brief holds a vector of ns3::QueueDisc pointers
+ *
+ * The TrafficControlHelper returns the root queue discs it installs on
+ * the devices in a QueueDiscContainer, in the order of the devices.
+ */
+class QueueDiscContainer
+{
+public:
+  /// QueueDisc container iterator
+  typedef std::vector<Ptr<QueueDisc> >::const_iterator Iterator;
+
+  /**
+   * Create an empty QueueDiscContainer.
+   */
+  QueueDiscContainer ();
+  /**
+   * \param qDisc a queue disc to add to the container
+   *
+   * Create a QueueDiscContainer with exactly one queue disc
+   */
+  QueueDiscContainer (Ptr<QueueDisc> qDisc);
+
+  /**
+   * \returns an iterator to the start of the vector of queue disc pointers
+   */
+  Iterator Begin (void) const;
+  /**
+   * \returns an iterator to the end of the vector of queue disc pointers
+   */
+  Iterator End (void) const;
+  /**
+   * \returns the number of queue discs in the container
+   */
+  uint32_t GetN (void) const;
+  /**
+   * \param i the index of the requested queue disc
+   * \returns the requested queue disc
+   */
+  Ptr<QueueDisc> Get (uint32_t i) const;
+
+  /**
+   * \param other another container, whose queue discs are appended
+   */
+  void Add (QueueDiscContainer other);
+  /**
+   * \param qDisc a queue disc to append
+   */
+  void Add (Ptr<QueueDisc> qDisc);
+
+private:
+  std::vector<Ptr<QueueDisc> > m_queueDiscs; //!< the queue discs
+};
+
+} // namespace ns3
+
+#endif /* QUEUE_DISC_CONTAINER_H */
@@ -0,0 +1,267 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUEUE_DISC_H
+#define QUEUE_DISC_H
+
+#include <ostream>
+#include "ns3/object.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/packet.h"
+#include "ns3/address.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+class NetDevice;
+class NetDeviceQueue;
+
+/**
+ * \defgroup traffic-control Traffic Control
+ *
+ * The traffic control layer sits between the network layer and the
+ * network devices, and holds the packets which the devices can not
+ * transmit yet in queue discs.
+ */
+
+/**
+ * \ingroup traffic-control
+ * \brief A packet held by a queue disc, with the information needed to
+ * send it to the device once dequeued.
+ *
+ * The network protocols subclass it to let the queue discs classify the
+ * packets without knowing their headers.
+ */
+class QueueDiscItem : public SimpleRefCount<QueueDiscItem>
+{
+public:
+  /**
+   * \param p the packet
+   * \param addr the destination address, as given to NetDevice::Send
+   * \param protocol the protocol number, as given to NetDevice::Send
+   */
+  QueueDiscItem (Ptr<Packet> p, const Address &addr, uint16_t protocol);
+  virtual ~QueueDiscItem ();
+
+  /**
+   * \return the packet
+   */
+  Ptr<Packet> GetPacket (void) const;
+  /**
+   * \return the destination address
+   */
+  Address GetAddress (void) const;
+  /**
+   * \return the protocol number
+   */
+  uint16_t GetProtocol (void) const;
+  /**
+   * \return the size in bytes of the packet
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \return the time at which the item was enqueued
+   */
+  Time GetTimeStamp (void) const;
+  /**
+   * \param t the time at which the item is enqueued
+   */
+  void SetTimeStamp (Time t);
+
+  /**
+   * Compute a hash of the flow the packet belongs to.  The default
+   * implementation returns 0, which puts all the packets in one flow.
+   *
+   * \param perturbation a value mixed in the hash, so that the flows
+   * which collide are not always the same
+   * \return the hash of the flow
+   */
+  virtual uint32_t Hash (uint32_t perturbation) const;
+
+  /**
+   * Set the CE codepoint of the packet, if it is ECN-capable.  The
+   * queue discs mark the packets instead of dropping them to signal the
+   * congestion to the senders which support ECN.  The default
+   * implementation can not mark.
+   *
+   * \return true if the packet is ECN-capable and now carries CE
+   */
+  virtual bool Mark (void);
+
+  /**
+   * \param os the output stream
+   */
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * TracedCallback signature for an item.
+   *
+   * \param [in] item The item.
+   */
+  typedef void (* TracedCallback) (Ptr<const QueueDiscItem> item);
+
+private:
+  /**
+   * \brief Copy constructor
+   * Defined and unimplemented to avoid misuse
+   */
+  QueueDiscItem (const QueueDiscItem &);
+  /**
+   * \brief Assignment operator
+   * \return this object
+   * Defined and unimplemented to avoid misuse
+   */
+  QueueDiscItem &operator = (const QueueDiscItem &);
+
+  Ptr<Packet> m_packet; //!< the packet
+  Address m_address;    //!< the destination address
+  uint16_t m_protocol;  //!< the protocol number
+  Time m_tstamp;        //!< the enqueue time
+};
+
+/**
+ * \param os the output stream
+ * \param item the item
+ * \return the output stream
+ */
+std::ostream & operator << (std::ostream &os, const QueueDiscItem &item);
+
+/**
+ * \ingroup traffic-control
+ * \brief Abstract base class for queue discs.
+ *
+ * A queue disc holds the packets sent to a device by the layers above,
+ * and passes them to the device as long as the NetDeviceQueue of the
+ * device is not stopped.  When the device stops its queue, the packets
+ * wait in the queue disc, whose subclass decides the order in which
+ * they are sent and which ones are dropped; when the device wakes its
+ * queue up, the queue disc runs again.
+ *
+ * The base class keeps the statistics and the traces; the subclasses
+ * implement DoEnqueue and DoDequeue, and call Drop for the items they
+ * remove from the queue without sending them.
+ */
+class QueueDisc : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  QueueDisc ();
+  virtual ~QueueDisc ();
+
+  /**
+   * Enqueue an item.  The item is dropped if the queue disc refuses it.
+   *
+   * \param item the item
+   * \return true if the item was enqueued
+   */
+  bool Enqueue (Ptr<QueueDiscItem> item);
+  /**
+   * Dequeue the next item to send.
+   *
+   * \return the item, or 0 if the queue disc is empty
+   */
+  Ptr<QueueDiscItem> Dequeue (void);
+  /**
+   * Send items to the device until the queue disc is empty or the device
+   * stops its queue.
+   */
+  void Run (void);
+
+  /**
+   * Attach the queue disc to a device.  A NetDeviceQueue is aggregated to
+   * the device if it does not have one already.
+   *
+   * \param device the device
+   */
+  void SetNetDevice (Ptr<NetDevice> device);
+  /**
+   * \return the device the queue disc is attached to
+   */
+  Ptr<NetDevice> GetNetDevice (void) const;
+
+  /**
+   * \return the number of items held by the queue disc
+   */
+  uint32_t GetNPackets (void) const;
+  /**
+   * \return the number of bytes held by the queue disc
+   */
+  uint32_t GetNBytes (void) const;
+  /**
+   * \return the number of items enqueued since the queue disc was created
+   */
+  uint32_t GetTotalReceivedPackets (void) const;
+  /**
+   * \return the number of items dropped since the queue disc was created,
+   *         including the ones the device refused
+   */
+  uint32_t GetTotalDroppedPackets (void) const;
+  /**
+   * \return the number of bytes dropped since the queue disc was created
+   */
+  uint32_t GetTotalDroppedBytes (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+  /**
+   * Drop an item the queue disc holds, and update the statistics.
+   *
+   * \param item the item
+   */
+  void Drop (Ptr<QueueDiscItem> item);
+
+private:
+  /**
+   * Add an item to the queue disc.  The statistics already count the
+   * item; if the subclass refuses it, the base class drops it.
+   *
+   * \param item the item
+   * \return true if the item was enqueued
+   */
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item) = 0;
+  /**
+   * Remove the next item to send from the queue disc.  The statistics
+   * still count the item.
+   *
+   * \return the item, or 0 if the queue disc is empty
+   */
+  virtual Ptr<QueueDiscItem> DoDequeue (void) = 0;
+
+  uint32_t m_nPackets;              //!< items held
+  uint32_t m_nBytes;                //!< bytes held
+  uint32_t m_nTotalReceivedPackets; //!< items enqueued
+  uint32_t m_nTotalDroppedPackets;  //!< items dropped
+  uint32_t m_nTotalDroppedBytes;    //!< bytes dropped
+  bool m_running;                   //!< Run is sending items to the device
+
+  Ptr<NetDevice> m_device;          //!< the device
+  Ptr<NetDeviceQueue> m_devQueue;   //!< the queue of the device
+
+  TracedCallback<Ptr<const QueueDiscItem> > m_traceEnqueue; //!< enqueue trace
+  TracedCallback<Ptr<const QueueDiscItem> > m_traceDequeue; //!< dequeue trace
+  TracedCallback<Ptr<const QueueDiscItem> > m_traceDrop;    //!< drop trace
+};
+
+} // namespace ns3
+
+#endif /* QUEUE_DISC_H */
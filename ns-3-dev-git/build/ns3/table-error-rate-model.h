@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TABLE_ERROR_RATE_MODEL_H
+#define TABLE_ERROR_RATE_MODEL_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include "wifi-mode.h"
+#include "error-rate-model.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup wifi
+ *
+ * An error rate model which interpolates the BERs of another model,
+ * a NistErrorRateModel by default, from tables.
+ *
+ * For each mode, channel width and guard interval, the first chunk
+ * fills a table of the logarithm of the BER of the model on a grid of
+ * SNRs in dB, the BER being read as the failure rate of a chunk of one
+ * bit. The success rate of a chunk of nbits is then
+ * exp (nbits * log1p (-ber)), with the BER interpolated linearly in the
+ * log domain between the two nearest SNRs of the grid. Beyond the grid,
+ * the model is called instead.
+ *
+ * This trades a small error on the success rates for the cost of the
+ * erfc, the polynomials of the convolutional codes and the pow of the
+ * analytic models, which are computed for every chunk of every frame.
+ * The attributes are to be set before the first chunk.
+ */
+class TableErrorRateModel : public ErrorRateModel
+{
+public:
+  static TypeId GetTypeId (void);
+
+  TableErrorRateModel ();
+
+  virtual double GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const;
+
+
+private:
+  /**
+   * The parameters of the transmissions which share a table.
+   */
+  struct TableKey
+  {
+    uint32_t mode;              //!< the uid of the WifiMode
+    uint32_t channelWidth;      //!< the channel width (MHz)
+    bool shortGuardInterval;    //!< whether the guard interval is short
+    /**
+     * \param o another key
+     * \return true if this key is lower than the other one
+     */
+    bool operator < (const TableKey &o) const;
+  };
+  /// the logarithms of the BERs on the SNR grid
+  typedef std::vector<double> LogBers;
+  /// the tables, by parameters
+  typedef std::map<TableKey, LogBers> Tables;
+
+  /**
+   * Return the table of the given transmission, and fill it the first
+   * time.
+   *
+   * \param mode the Wi-Fi mode of the chunk
+   * \param txVector TXVECTOR of the transmission
+   *
+   * \return the logarithms of the BERs of the transmission
+   */
+  const LogBers & GetTable (WifiMode mode, WifiTxVector txVector) const;
+
+  Ptr<ErrorRateModel> m_errorRateModel;   //!< the model of the BERs
+  double m_minSnr;                        //!< the lowest SNR of the grid (dB)
+  double m_maxSnr;                        //!< the highest SNR of the grid (dB)
+  double m_resolution;                    //!< the step of the grid (dB)
+  mutable Tables m_tables;                //!< the tables filled so far
+  mutable TableKey m_lastKey;             //!< the key of the last table used
+  mutable const LogBers *m_lastTable;     //!< the last table used, or 0
+};
+
+} //namespace ns3
+
+#endif /* TABLE_ERROR_RATE_MODEL_H */
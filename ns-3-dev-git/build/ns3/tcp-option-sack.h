@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef TCP_OPTION_SACK_H
+#define TCP_OPTION_SACK_H
+
+#include <list>
+#include "ns3/tcp-option.h"
+#include "ns3/sequence-number.h"
+
+namespace ns3 {
+
+/**
+ * \brief Defines the TCP option of kind 5 (selective acknowledgment option) as
+ * in \RFC{2018}
+ *
+ * The option carries up to four blocks of data received out of order, each
+ * one given by the sequence number of its first byte (left edge) and the
+ * sequence number following its last byte (right edge). Together with the
+ * timestamp option, only three blocks fit in the option space.
+ */
+class TcpOptionSack : public TcpOption
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  /// A SACK block: [left edge, right edge)
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  /// A list of SACK blocks, the first one being the most recent
+  typedef std::list<SackBlock> SackList;
+
+  TcpOptionSack ();
+  virtual ~TcpOptionSack ();
+
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  virtual uint8_t GetKind (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \brief Append a block to the option
+   * \param s the block
+   */
+  void AddSackBlock (SackBlock s);
+
+  /**
+   * \brief Count the blocks in the option
+   * \return the number of blocks
+   */
+  uint32_t GetNumSackBlocks (void) const;
+
+  /**
+   * \brief Get the blocks in the option
+   * \return the list of blocks
+   */
+  SackList GetSackList (void) const;
+
+  /**
+   * \brief Get the number of blocks that fit in the given option space
+   * \param space option space left in the header (bytes)
+   * \return the number of blocks, at most 4
+   */
+  static uint32_t GetMaxSackBlocks (uint32_t space);
+
+protected:
+  SackList m_sackList; //!< the list of SACK blocks
+};
+
+} // namespace ns3
+
+#endif /* TCP_OPTION_SACK_H */
@@ -0,0 +1,311 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TIME_SERIES_FILE_H
+#define TIME_SERIES_FILE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
+#include "output-stream-wrapper.h"
+
+namespace ns3 {
+
+/**
+ * \brief The layout of the binary time series files.
+ *
+ * A time series file holds (time, value, context) records: the time is a
+ * number of simulator time steps, the value a double and the context an
+ * unsigned integer, for instance a node or flow identifier. All the
+ * integers of the file are little endian.
+ *
+ * The file starts with a header and ends with an index of its blocks:
+ * \verbatim
+ *   header:  magic "NSTS", version (uint16 major, uint16 minor),
+ *            flags (uint32), records per block (uint32),
+ *            time steps per second (uint64)
+ *   block:   magic "SBLK", number of records (uint32), payload size (uint32),
+ *            payload
+ *   ...
+ *   index:   magic "SIDX", number of blocks (uint32), then for each block
+ *            its offset (uint64), smallest and largest time (int64),
+ *            number of records and payload size (uint32)
+ *   trailer: offset of the index (uint64), number of records (uint64),
+ *            magic "SEND"
+ * \endverbatim
+ *
+ * The payload of a block stores the records by column: first the times,
+ * then the values, then the contexts. Without the COMPRESSED flag the
+ * columns are arrays of int64, double and uint32. With it, the times and
+ * the contexts are stored as zigzag varints of their difference with the
+ * previous record, and the values as the bytes of their XOR with the
+ * previous value which are not zero, preceded by a control byte. Slowly
+ * changing series, such as a congestion window sampled at every ACK,
+ * shrink to a few bytes per record.
+ *
+ * A file which was not closed has no index; the reader then recovers the
+ * complete blocks by walking them from the header.
+ */
+class TimeSeriesFile
+{
+public:
+  static const uint32_t MAGIC = 0x5354534e;          //!< "NSTS"
+  static const uint32_t BLOCK_MAGIC = 0x4b4c4253;    //!< "SBLK"
+  static const uint32_t INDEX_MAGIC = 0x58444953;    //!< "SIDX"
+  static const uint32_t TRAILER_MAGIC = 0x444e4553;  //!< "SEND"
+  static const uint16_t VERSION_MAJOR = 1;           //!< Major version of the layout
+  static const uint16_t VERSION_MINOR = 0;           //!< Minor version of the layout
+  static const uint32_t COMPRESSED = 1;              //!< Flag of the compressed payloads
+  static const uint32_t HEADER_SIZE = 24;            //!< Size of the file header
+  static const uint32_t BLOCK_HEADER_SIZE = 12;      //!< Size of the block header
+  static const uint32_t INDEX_ENTRY_SIZE = 32;       //!< Size of an index entry
+  static const uint32_t TRAILER_SIZE = 20;           //!< Size of the trailer
+  static const uint32_t BLOCK_RECORDS_DEFAULT = 4096; //!< Default records per block
+
+  /** A record of a time series. */
+  struct Record
+  {
+    int64_t time;     //!< Time, in time steps
+    double value;     //!< Value
+    uint32_t context; //!< Context
+  };
+
+  /** An entry of the index of the blocks. */
+  struct Block
+  {
+    uint64_t offset;    //!< Offset of the block header in the file
+    int64_t minTime;    //!< Smallest time of the records
+    int64_t maxTime;    //!< Largest time of the records
+    uint32_t count;     //!< Number of records
+    uint32_t size;      //!< Size of the payload
+  };
+};
+
+/**
+ * \brief A buffered writer of binary time series files.
+ *
+ * The records are buffered by column and written a block at a time, so
+ * that a trace sink costs a few stores per event instead of the
+ * formatting and the flush of a line of text. The file is completed,
+ * with its index, by Close() or by the destructor of the writer.
+ *
+ * \see TimeSeriesFile for the layout of the file
+ * \see AsciiTraceHelper::CreateTimeSeriesFile
+ */
+class TimeSeriesWriter : public SimpleRefCount<TimeSeriesWriter>
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param stream the stream to write to, opened in binary mode
+   * \param compress compress the blocks
+   * \param blockRecords number of records buffered in a block
+   */
+  TimeSeriesWriter (Ptr<OutputStreamWrapper> stream, bool compress = true,
+                    uint32_t blockRecords = TimeSeriesFile::BLOCK_RECORDS_DEFAULT);
+  ~TimeSeriesWriter ();
+
+  /**
+   * Append a record.
+   *
+   * \param time the time of the record
+   * \param value the value
+   * \param context the context
+   */
+  void Write (Time time, double value, uint32_t context = 0);
+  /**
+   * Append a record at the current simulation time.
+   *
+   * \param value the value
+   * \param context the context
+   */
+  void Write (double value, uint32_t context = 0);
+
+  /**
+   * Trace sink of the integer traced values, recording the new value at
+   * the current simulation time.
+   *
+   * \param oldValue the previous value
+   * \param newValue the new value
+   */
+  void TraceUint32 (uint32_t oldValue, uint32_t newValue);
+  /**
+   * Trace sink of the double traced values.
+   *
+   * \param oldValue the previous value
+   * \param newValue the new value
+   */
+  void TraceDouble (double oldValue, double newValue);
+  /**
+   * Trace sink of the time traced values, recording the new value in
+   * seconds.
+   *
+   * \param oldValue the previous value
+   * \param newValue the new value
+   */
+  void TraceTime (Time oldValue, Time newValue);
+
+  /**
+   * Write the buffered records as a block.
+   */
+  void Flush (void);
+  /**
+   * Write the buffered records, the index and the trailer. Nothing can be
+   * written after.
+   */
+  void Close (void);
+
+  /**
+   * \returns the number of records written
+   */
+  uint64_t GetNRecords (void) const;
+
+private:
+  /**
+   * Write the file header.
+   */
+  void WriteHeader (void);
+  /**
+   * Write the contents of m_buffer to the stream.
+   */
+  void WriteBuffer (void);
+
+  Ptr<OutputStreamWrapper> m_stream;  //!< The output stream
+  bool m_compress;                    //!< Compress the blocks
+  bool m_closed;                      //!< The file is complete
+  uint32_t m_blockRecords;            //!< Number of records of a full block
+  uint64_t m_offset;                  //!< Number of bytes written
+  uint64_t m_records;                 //!< Number of records written
+  std::vector<int64_t> m_times;       //!< Times of the buffered records
+  std::vector<double> m_values;       //!< Values of the buffered records
+  std::vector<uint32_t> m_contexts;   //!< Contexts of the buffered records
+  std::vector<uint8_t> m_buffer;      //!< Encoding buffer
+  std::vector<TimeSeriesFile::Block> m_index; //!< The blocks written
+};
+
+/**
+ * \brief A reader of binary time series files.
+ *
+ * The reader loads the index of the file, then the blocks on demand, so
+ * that a time range of a large file is read without decoding the rest.
+ */
+class TimeSeriesReader
+{
+public:
+  TimeSeriesReader ();
+  ~TimeSeriesReader ();
+
+  /**
+   * Open a file and load its index.
+   *
+   * \param filename the file name
+   * \returns true if the file is a time series file
+   */
+  bool Open (std::string const &filename);
+  /**
+   * Close the file.
+   */
+  void Close (void);
+
+  /**
+   * \returns true if the blocks are compressed
+   */
+  bool IsCompressed (void) const;
+  /**
+   * \returns true if the file was not closed by its writer, and its
+   * blocks were recovered without an index
+   */
+  bool IsRecovered (void) const;
+  /**
+   * \returns the number of time steps of the records per second
+   */
+  uint64_t GetStepsPerSecond (void) const;
+  /**
+   * \param time the time of a record
+   * \returns the time in seconds
+   */
+  double GetSeconds (int64_t time) const;
+  /**
+   * \returns the number of records of the file
+   */
+  uint64_t GetNRecords (void) const;
+  /**
+   * \returns the number of blocks of the file
+   */
+  uint32_t GetNBlocks (void) const;
+  /**
+   * \param i the index of a block
+   * \returns the index entry of the block
+   */
+  const TimeSeriesFile::Block &GetBlock (uint32_t i) const;
+
+  /**
+   * Read the records of a block.
+   *
+   * \param i the index of the block
+   * \param records the vector the records are appended to
+   * \returns true on success
+   */
+  bool ReadBlock (uint32_t i, std::vector<TimeSeriesFile::Record> &records);
+  /**
+   * Read all the records.
+   *
+   * \param records the vector the records are appended to
+   * \returns true on success
+   */
+  bool ReadAll (std::vector<TimeSeriesFile::Record> &records);
+  /**
+   * Read the records of a time range, skipping the blocks outside of it.
+   *
+   * \param from the start of the range
+   * \param to the end of the range, included
+   * \param records the vector the records are appended to
+   * \returns true on success
+   */
+  bool ReadRange (Time from, Time to, std::vector<TimeSeriesFile::Record> &records);
+
+private:
+  /**
+   * Load the index from the end of the file.
+   *
+   * \param size the size of the file
+   * \returns true if the file has a valid index
+   */
+  bool ReadIndex (uint64_t size);
+  /**
+   * Rebuild the index by walking the blocks.
+   *
+   * \param size the size of the file
+   */
+  void RecoverIndex (uint64_t size);
+
+  std::ifstream m_file;                    //!< The file
+  uint32_t m_flags;                        //!< Flags of the header
+  uint64_t m_stepsPerSecond;               //!< Time steps per second
+  bool m_recovered;                        //!< The index was rebuilt
+  uint64_t m_records;                      //!< Number of records
+  std::vector<TimeSeriesFile::Block> m_index; //!< The blocks
+  std::vector<uint8_t> m_buffer;           //!< Payload buffer
+};
+
+} // namespace ns3
+
+#endif /* TIME_SERIES_FILE_H */
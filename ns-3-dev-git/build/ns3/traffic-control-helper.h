@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRAFFIC_CONTROL_HELPER_H
+#define TRAFFIC_CONTROL_HELPER_H
+
+#include <string>
+#include "ns3/object-factory.h"
+#include "ns3/net-device-container.h"
+#include "queue-disc-container.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ * \brief Install root queue discs on devices.
+ *
+ * The nodes of the devices must have a TrafficControlLayer, which the
+ * InternetStackHelper aggregates.  Each device gets a NetDeviceQueue,
+ * through which the device tells the queue disc when to hold the
+ * packets; only the devices which report their queue, such as the
+ * PointToPointNetDevice, ever make the packets wait in the queue disc.
+ */
+class TrafficControlHelper
+{
+public:
+  TrafficControlHelper ();
+
+  /**
+   * Set the type and the attributes of the root queue discs to install.
+   *
+   * \param type the type of the queue disc
+   * \param n01 the name of the attribute to set on the queue disc
+   * \param v01 the value of the attribute to set on the queue disc
+   * \param n02 the name of the attribute to set on the queue disc
+   * \param v02 the value of the attribute to set on the queue disc
+   * \param n03 the name of the attribute to set on the queue disc
+   * \param v03 the value of the attribute to set on the queue disc
+   * \param n04 the name of the attribute to set on the queue disc
+   * \param v04 the value of the attribute to set on the queue disc
+   */
+  void SetRootQueueDisc (std::string type,
+                         std::string n01 = "", const AttributeValue& v01 = EmptyAttributeValue (),
+                         std::string n02 = "", const AttributeValue& v02 = EmptyAttributeValue (),
+                         std::string n03 = "", const AttributeValue& v03 = EmptyAttributeValue (),
+                         std::string n04 = "", const AttributeValue& v04 = EmptyAttributeValue ());
+
+  /**
+   * Set an attribute of the NetDeviceQueues aggregated to the devices,
+   * such as the bounds of the byte queue limits.
+   *
+   * \param name the name of the attribute
+   * \param value the value of the attribute
+   */
+  void SetNetDeviceQueueAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * \param device the device
+   * \returns a container with the root queue disc installed on the device
+   */
+  QueueDiscContainer Install (Ptr<NetDevice> device);
+  /**
+   * \param c the devices
+   * \returns a container with the root queue discs installed on the devices
+   */
+  QueueDiscContainer Install (NetDeviceContainer c);
+
+  /**
+   * Remove the root queue disc installed on a device.
+   *
+   * \param device the device
+   */
+  void Uninstall (Ptr<NetDevice> device);
+  /**
+   * Remove the root queue discs installed on devices.
+   *
+   * \param c the devices
+   */
+  void Uninstall (NetDeviceContainer c);
+
+private:
+  ObjectFactory m_queueDiscFactory;   //!< creates the root queue discs
+  ObjectFactory m_deviceQueueFactory; //!< creates the NetDeviceQueues
+};
+
+} // namespace ns3
+
+#endif /* TRAFFIC_CONTROL_HELPER_H */
@@ -42,6 +42,7 @@
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
 #include "ns3/error-model.h"
 #include "ns3/tcp-header.h"
 #include "ns3/udp-header.h"
@@ -58,28 +59,47 @@ bool firstCwnd = true;
 bool firstSshThr = true;
 bool firstRtt = true;
 bool firstRto = true;
+bool binaryTracing = false;
 Ptr<OutputStreamWrapper> cWndStream;
 Ptr<OutputStreamWrapper> ssThreshStream;
 Ptr<OutputStreamWrapper> rttStream;
 Ptr<OutputStreamWrapper> rtoStream;
+Ptr<TimeSeriesWriter> cWndSeries;
+Ptr<TimeSeriesWriter> ssThreshSeries;
+Ptr<TimeSeriesWriter> rttSeries;
+Ptr<TimeSeriesWriter> rtoSeries;
 uint32_t cWndValue;
 uint32_t ssThreshValue;
 
+// Write a sample to the binary time series if there is one, else as a
+// "time value" line of text
+static void
+WriteSample (Ptr<OutputStreamWrapper> stream, Ptr<TimeSeriesWriter> series, Time time, double value)
+{
+  if (series)
+    {
+      series->Write (time, value);
+    }
+  else
+    {
+      *stream->GetStream () << time.GetSeconds () << " " << value << "\n";
+    }
+}
 
 static void
 CwndTracer (uint32_t oldval, uint32_t newval)
 {
   if (firstCwnd)
     {
-      *cWndStream->GetStream () << "0.0 " << oldval << std::endl;
+      WriteSample (cWndStream, cWndSeries, Seconds (0), oldval);
       firstCwnd = false;
     }
-  *cWndStream->GetStream () << Simulator::Now ().GetSeconds () << " " << newval << std::endl;
+  WriteSample (cWndStream, cWndSeries, Simulator::Now (), newval);
   cWndValue = newval;
 
   if (!firstSshThr)
     {
-      *ssThreshStream->GetStream () << Simulator::Now ().GetSeconds () << " " << ssThreshValue << std::endl;
+      WriteSample (ssThreshStream, ssThreshSeries, Simulator::Now (), ssThreshValue);
     }
 }
 
@@ -88,15 +108,15 @@ SsThreshTracer (uint32_t oldval, uint32_t newval)
 {
   if (firstSshThr)
     {
-      *ssThreshStream->GetStream () << "0.0 " << oldval << std::endl;
+      WriteSample (ssThreshStream, ssThreshSeries, Seconds (0), oldval);
       firstSshThr = false;
     }
-  *ssThreshStream->GetStream () << Simulator::Now ().GetSeconds () << " " << newval << std::endl;
+  WriteSample (ssThreshStream, ssThreshSeries, Simulator::Now (), newval);
   ssThreshValue = newval;
 
   if (!firstCwnd)
     {
-      *cWndStream->GetStream () << Simulator::Now ().GetSeconds () << " " << cWndValue << std::endl;
+      WriteSample (cWndStream, cWndSeries, Simulator::Now (), cWndValue);
     }
 }
 
@@ -105,10 +125,10 @@ RttTracer (Time oldval, Time newval)
 {
   if (firstRtt)
     {
-      *rttStream->GetStream () << "0.0 " << oldval.GetSeconds () << std::endl;
+      WriteSample (rttStream, rttSeries, Seconds (0), oldval.GetSeconds ());
       firstRtt = false;
     }
-  *rttStream->GetStream () << Simulator::Now ().GetSeconds () << " " << newval.GetSeconds () << std::endl;
+  WriteSample (rttStream, rttSeries, Simulator::Now (), newval.GetSeconds ());
 }
 
 static void
@@ -116,26 +136,39 @@ RtoTracer (Time oldval, Time newval)
 {
   if (firstRto)
     {
-      *rtoStream->GetStream () << "0.0 " << oldval.GetSeconds () << std::endl;
+      WriteSample (rtoStream, rtoSeries, Seconds (0), oldval.GetSeconds ());
       firstRto = false;
     }
-  *rtoStream->GetStream () << Simulator::Now ().GetSeconds () << " " << newval.GetSeconds () << std::endl;
+  WriteSample (rtoStream, rtoSeries, Simulator::Now (), newval.GetSeconds ());
 }
 
+// Open the output of a tracer: "<prefix>.nts" if binary tracing is
+// enabled, "<prefix>.data" else
+static void
+OpenTrace (std::string prefix, Ptr<OutputStreamWrapper> &stream, Ptr<TimeSeriesWriter> &series)
+{
+  AsciiTraceHelper ascii;
+  if (binaryTracing)
+    {
+      series = ascii.CreateTimeSeriesFile (prefix + ".nts");
+    }
+  else
+    {
+      stream = ascii.CreateFileStream (prefix + ".data");
+    }
+}
 
 static void
 TraceCwnd (std::string cwnd_tr_file_name)
 {
-  AsciiTraceHelper ascii;
-  cWndStream = ascii.CreateFileStream (cwnd_tr_file_name.c_str ());
+  OpenTrace (cwnd_tr_file_name, cWndStream, cWndSeries);
   Config::ConnectWithoutContext ("/NodeList/1/$ns3::TcpL4Protocol/SocketList/0/CongestionWindow", MakeCallback (&CwndTracer));
 }
 
 static void
 TraceSsThresh (std::string ssthresh_tr_file_name)
 {
-  AsciiTraceHelper ascii;
-  ssThreshStream = ascii.CreateFileStream (ssthresh_tr_file_name.c_str ());
+  OpenTrace (ssthresh_tr_file_name, ssThreshStream, ssThreshSeries);
   Config::ConnectWithoutContext ("/NodeList/1/$ns3::TcpL4Protocol/SocketList/0/SlowStartThreshold", MakeCallback (&SsThreshTracer));
 }
 
@@ -143,19 +176,32 @@ TraceSsThresh (std::string ssthresh_tr_file_name)
 static void
 TraceRtt (std::string rtt_tr_file_name)
 {
-  AsciiTraceHelper ascii;
-  rttStream = ascii.CreateFileStream (rtt_tr_file_name.c_str ());
+  OpenTrace (rtt_tr_file_name, rttStream, rttSeries);
   Config::ConnectWithoutContext ("/NodeList/1/$ns3::TcpL4Protocol/SocketList/0/RTT", MakeCallback (&RttTracer));
 }
 
 static void
 TraceRto (std::string rto_tr_file_name)
 {
-  AsciiTraceHelper ascii;
-  rtoStream = ascii.CreateFileStream (rto_tr_file_name.c_str ());
+  OpenTrace (rto_tr_file_name, rtoStream, rtoSeries);
   Config::ConnectWithoutContext ("/NodeList/1/$ns3::TcpL4Protocol/SocketList/0/RTO", MakeCallback (&RtoTracer));
 }
 
+// Complete the files of the tracers
+static void
+CloseTraces (void)
+{
+  Ptr<TimeSeriesWriter> series[] = { cWndSeries, ssThreshSeries, rttSeries, rtoSeries };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      if (series[i])
+        {
+          series[i]->Close ();
+        }
+    }
+  cWndStream = ssThreshStream = rttStream = rtoStream = 0;
+}
+
 int main (int argc, char *argv[])
 {
   std::string transport_prot = "TcpInigo";
@@ -166,6 +212,7 @@ int main (int argc, char *argv[])
   std::string access_delay = "45ms";
   std::string prefix_file_name = "/Users/ahume/Documents/UCSC/Thesis/inigo_ns3/inigo_test_results/test5/TcpVariantsComparison_";
   bool tracing = true;
+  bool ascii_tracing = true;
   double data_mbytes = 0;
   uint32_t mtu_bytes = 400;
   uint16_t num_flows = 1;
@@ -173,18 +220,26 @@ int main (int argc, char *argv[])
   uint32_t run = 0;
   bool flow_monitor = false;
   bool pcap = true;
+  bool sack = false;
+  bool pacing = false;
+  double ack_coalescing = 0.0;
   std::string queue_type = "ns3::DropTailQueue";
+  bool ecn = false;
+  double ce_threshold = 0.0;
 
 
   CommandLine cmd;
   cmd.AddValue ("transport_prot", "Transport protocol to use: TcpNewReno, "
-                " TcpInigo, TcpWestwood, TcpWestwoodPlus ", transport_prot);
+                " TcpInigo, TcpDctcp, TcpWestwood, TcpWestwoodPlus ", transport_prot);
   cmd.AddValue ("error_p", "Packet error rate", error_p);
   cmd.AddValue ("bandwidth", "Bottleneck bandwidth", bandwidth);
   cmd.AddValue ("delay", "Bottleneck delay", delay);
   cmd.AddValue ("access_bandwidth", "Access link bandwidth", access_bandwidth);
   cmd.AddValue ("access_delay", "Access link delay", access_delay);
   cmd.AddValue ("tracing", "Flag to enable/disable tracing", tracing);
+  cmd.AddValue ("ascii_tracing", "Flag to enable/disable the ASCII packet trace when tracing", ascii_tracing);
+  cmd.AddValue ("binary_tracing", "Write the cwnd, ssth, rtt and rto traces as binary time series (.nts) "
+                "instead of text (.data)", binaryTracing);
   cmd.AddValue ("prefix_name", "Prefix of output trace file", prefix_file_name);
   cmd.AddValue ("data", "Number of Megabytes of data to transmit", data_mbytes);
   cmd.AddValue ("mtu", "Size of IP packets to send in bytes", mtu_bytes);
@@ -193,7 +248,14 @@ int main (int argc, char *argv[])
   cmd.AddValue ("run", "Run index (for setting repeatable seeds)", run);
   cmd.AddValue ("flow_monitor", "Enable flow monitor", flow_monitor);
   cmd.AddValue ("pcap_tracing", "Enable or disable PCAP tracing", pcap);
-  cmd.AddValue ("queue_type", "Queue type for gateway (e.g. ns3::CoDelQueue)", queue_type);
+  cmd.AddValue ("queue_type", "Queue type for gateway (e.g. ns3::CoDelQueue, or ns3::FqCoDelQueueDisc "
+                "for a queue disc in front of the device queue)", queue_type);
+  cmd.AddValue ("ecn", "Negotiate ECN, and mark instead of dropping in ns3::FqCoDelQueueDisc", ecn);
+  cmd.AddValue ("ce_threshold", "Sojourn time (s) above which ns3::FqCoDelQueueDisc marks the packets, "
+                "the K of DCTCP (0 disables)", ce_threshold);
+  cmd.AddValue ("sack", "Enable or disable SACK option and SACK-based recovery", sack);
+  cmd.AddValue ("pacing", "Enable or disable pacing of the segments by the sender", pacing);
+  cmd.AddValue ("ack_coalescing", "Interval (s) over which the sender coalesces the cWnd growth of new ACKs (0 disables)", ack_coalescing);
   cmd.Parse (argc, argv);
 
   prefix_file_name = prefix_file_name + transport_prot;
@@ -230,6 +292,10 @@ int main (int argc, char *argv[])
   NS_LOG_LOGIC("RCV and SND buf sizes are: " << tmp);
   Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (1 << 21));
   Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (1 << 21));
+  Config::SetDefault ("ns3::TcpSocketBase::Sack", BooleanValue (sack));
+  Config::SetDefault ("ns3::TcpSocketState::EnablePacing", BooleanValue (pacing));
+  Config::SetDefault ("ns3::TcpSocketBase::AckCoalescingTime", TimeValue (Seconds (ack_coalescing)));
+  Config::SetDefault ("ns3::TcpSocketBase::UseEcn", BooleanValue (ecn));
 
   // Select TCP variant
   if (transport_prot.compare ("TcpNewReno") == 0)
@@ -242,6 +308,11 @@ int main (int argc, char *argv[])
       Config::SetDefault ("ns3::TcpL4Protocol::SocketType", TypeIdValue (TcpInigo::GetTypeId ()));
       NS_LOG_INFO("using TcpIniog");
     }
+  else if (transport_prot.compare ("TcpDctcp") == 0)
+    { // DCTCP negotiates ECN by itself
+      Config::SetDefault ("ns3::TcpL4Protocol::SocketType", TypeIdValue (TcpDctcp::GetTypeId ()));
+      ecn = true;
+    }
   else if (transport_prot.compare ("TcpWestwood") == 0)
     { // the default protocol type in ns3::TcpWestwood is WESTWOOD
       Config::SetDefault ("ns3::TcpL4Protocol::SocketType", TypeIdValue (TcpWestwood::GetTypeId ()));
@@ -339,7 +410,8 @@ int main (int argc, char *argv[])
 
           link = DynamicCast<PointToPointNetDevice> (devices.Get (j));
 
-          if (queue_type.compare ("ns3::DropTailQueue") == 0)
+          if (queue_type.compare ("ns3::DropTailQueue") == 0
+              || queue_type.compare ("ns3::FqCoDelQueueDisc") == 0)
             {
               Ptr<DropTailQueue> q = CreateObject <DropTailQueue> ();
               q->SetMode (DropTailQueue::QUEUE_MODE_BYTES);
@@ -355,9 +427,19 @@ int main (int argc, char *argv[])
             }
           else
             {
-              NS_FATAL_ERROR ("Queue not recognized. Allowed values are ns3::CoDelQueue or ns3::DropTailQueue");
+              NS_FATAL_ERROR ("Queue not recognized. Allowed values are ns3::CoDelQueue, "
+                              "ns3::DropTailQueue or ns3::FqCoDelQueueDisc");
             }
         }
+
+      if (queue_type.compare ("ns3::FqCoDelQueueDisc") == 0)
+        {
+          TrafficControlHelper tch;
+          tch.SetRootQueueDisc ("ns3::FqCoDelQueueDisc",
+                                "UseEcn", BooleanValue (ecn),
+                                "CeThreshold", TimeValue (Seconds (ce_threshold)));
+          tch.Install (devices);
+        }
     }
 
   NS_LOG_INFO ("Initialize Global Routing.");
@@ -373,6 +455,7 @@ int main (int argc, char *argv[])
 
       if (transport_prot.compare ("TcpNewReno") == 0
           || transport_prot.compare ("TcpInigo") == 0
+          || transport_prot.compare ("TcpDctcp") == 0
           || transport_prot.compare ("TcpWestwood") == 0
           || transport_prot.compare ("TcpWestwoodPlus") == 0
           || transport_prot.compare ("TcpHybla") == 0
@@ -405,17 +488,20 @@ int main (int argc, char *argv[])
   // Set up tracing if enabled
   if (tracing)
     {
-      std::ofstream ascii;
-      Ptr<OutputStreamWrapper> ascii_wrap;
-      ascii.open ((prefix_file_name + "-ascii").c_str ());
-      ascii_wrap = new OutputStreamWrapper ((prefix_file_name + "-ascii").c_str (),
-                                            std::ios::out);
-      stack.EnableAsciiIpv4All (ascii_wrap);
-
-      Simulator::Schedule (Seconds (0.00001), &TraceCwnd, prefix_file_name + "-cwnd.data");
-      Simulator::Schedule (Seconds (0.00001), &TraceSsThresh, prefix_file_name + "-ssth.data");
-      Simulator::Schedule (Seconds (0.00001), &TraceRtt, prefix_file_name + "-rtt.data");
-      Simulator::Schedule (Seconds (0.00001), &TraceRto, prefix_file_name + "-rto.data");
+      if (ascii_tracing)
+        {
+          std::ofstream ascii;
+          Ptr<OutputStreamWrapper> ascii_wrap;
+          ascii.open ((prefix_file_name + "-ascii").c_str ());
+          ascii_wrap = new OutputStreamWrapper ((prefix_file_name + "-ascii").c_str (),
+                                                std::ios::out);
+          stack.EnableAsciiIpv4All (ascii_wrap);
+        }
+
+      Simulator::Schedule (Seconds (0.00001), &TraceCwnd, prefix_file_name + "-cwnd");
+      Simulator::Schedule (Seconds (0.00001), &TraceSsThresh, prefix_file_name + "-ssth");
+      Simulator::Schedule (Seconds (0.00001), &TraceRtt, prefix_file_name + "-rtt");
+      Simulator::Schedule (Seconds (0.00001), &TraceRto, prefix_file_name + "-rto");
     }
 
   if (pcap)
@@ -433,6 +519,7 @@ int main (int argc, char *argv[])
 
   Simulator::Stop (Seconds (stop_time));
   Simulator::Run ();
+  CloseTraces ();
 
   if (flow_monitor)
     {
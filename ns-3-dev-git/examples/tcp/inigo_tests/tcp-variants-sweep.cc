@@ -0,0 +1,478 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Parameter sweep of tcp-experimental-variants-comparison.
+//
+// Every combination of the swept parameters is an independent simulation,
+// run as a separate process of tcp-experimental-variants-comparison with
+// its own command line, so that as many runs as there are cores proceed
+// in parallel. The runs write their traces in their own directory, and
+// once they are all done their outputs are merged into one result store:
+//
+//   <output>/index.csv        one line per run: parameters, exit status, time
+//   <output>/cwnd.csv         congestion window traces, keyed by run id
+//   <output>/ssth.csv         slow start threshold traces
+//   <output>/rtt.csv          RTT traces
+//   <output>/rto.csv          RTO traces
+//   <output>/flows.csv        flow monitor statistics of every flow
+//   <output>/runs/<id>/       raw outputs and log of each run
+//
+// Example, replacing run_full.sh:
+//
+//   ./waf --run "tcp-variants-sweep --output=results/test5
+//       --transport_prot=TcpNewReno,TcpWestwood,TcpInigo --run=0-4
+//       --args='--duration=50 --error_p=0.001'"
+//
+// With --resume, the runs which already completed successfully in the
+// output directory are not run again.
+//
+// The runs record their traces as binary time series (.nts), converted
+// to CSV when merged; --args='--binary_tracing=0' makes them write the
+// "time value" text files instead.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ns3/core-module.h"
+#include "ns3/time-series-file.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TcpVariantsSweep");
+
+/** One simulation of the sweep. */
+struct SweepRun
+{
+  uint32_t id;             //!< Index of the run in the sweep
+  std::string transport;   //!< transport_prot argument
+  std::string numFlows;    //!< num_flows argument
+  std::string errorP;      //!< error_p argument
+  std::string queueType;   //!< queue_type argument
+  std::string run;         //!< run argument
+  std::string dir;         //!< Output directory of the run
+  int status;              //!< Exit status, -1 if not run
+  int64_t startMs;         //!< Start time, in ms since the start of the sweep
+  int64_t durationMs;      //!< Wall clock duration of the run
+};
+
+/**
+ * Split a string on a separator, dropping the empty fields.
+ *
+ * \param s the string
+ * \param sep the separator
+ * \returns the fields
+ */
+static std::vector<std::string>
+Split (const std::string &s, char sep)
+{
+  std::vector<std::string> fields;
+  std::istringstream is (s);
+  std::string field;
+  while (std::getline (is, field, sep))
+    {
+      if (!field.empty ())
+        {
+          fields.push_back (field);
+        }
+    }
+  return fields;
+}
+
+/**
+ * Expand a list of run indexes such as "0-4,7".
+ *
+ * \param s the list
+ * \returns the run indexes
+ */
+static std::vector<std::string>
+ExpandRuns (const std::string &s)
+{
+  std::vector<std::string> runs;
+  std::vector<std::string> ranges = Split (s, ',');
+  for (std::vector<std::string>::const_iterator i = ranges.begin (); i != ranges.end (); ++i)
+    {
+      std::string::size_type dash = i->find ('-');
+      if (dash == std::string::npos)
+        {
+          runs.push_back (*i);
+          continue;
+        }
+      uint32_t first = atoi (i->substr (0, dash).c_str ());
+      uint32_t last = atoi (i->substr (dash + 1).c_str ());
+      for (uint32_t r = first; r <= last; ++r)
+        {
+          std::ostringstream os;
+          os << r;
+          runs.push_back (os.str ());
+        }
+    }
+  return runs;
+}
+
+/**
+ * \param path a file name
+ * \returns true if the file exists
+ */
+static bool
+FileExists (const std::string &path)
+{
+  return access (path.c_str (), F_OK) == 0;
+}
+
+/**
+ * Start a run in a child process.
+ *
+ * The child runs the simulation program with the fixed arguments, the
+ * arguments of the run and the extra arguments, in this order so that
+ * the extra arguments take precedence. Its output goes to the log file
+ * of the run.
+ *
+ * \param program the simulation program
+ * \param r the run
+ * \param extra extra arguments of every run
+ * \returns the pid of the child
+ */
+static pid_t
+Launch (const std::string &program, const SweepRun &r, const std::vector<std::string> &extra)
+{
+  std::vector<std::string> args;
+  args.push_back (program);
+  args.push_back ("--tracing=1");
+  args.push_back ("--ascii_tracing=0");
+  args.push_back ("--binary_tracing=1");
+  args.push_back ("--flow_monitor=1");
+  args.push_back ("--pcap_tracing=0");
+  args.push_back ("--prefix_name=" + r.dir + "/");
+  args.push_back ("--transport_prot=" + r.transport);
+  args.push_back ("--num_flows=" + r.numFlows);
+  args.push_back ("--error_p=" + r.errorP);
+  args.push_back ("--queue_type=" + r.queueType);
+  args.push_back ("--run=" + r.run);
+  args.insert (args.end (), extra.begin (), extra.end ());
+  std::vector<char *> argv;
+  for (std::vector<std::string>::iterator i = args.begin (); i != args.end (); ++i)
+    {
+      argv.push_back (const_cast<char *> (i->c_str ()));
+    }
+  argv.push_back (0);
+  std::string log = r.dir + "/log.txt";
+
+  pid_t pid = fork ();
+  NS_ABORT_MSG_IF (pid < 0, "fork failed: " << strerror (errno));
+  if (pid == 0)
+    {
+      int fd = open (log.c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd >= 0)
+        {
+          dup2 (fd, STDOUT_FILENO);
+          dup2 (fd, STDERR_FILENO);
+          close (fd);
+        }
+      execv (program.c_str (), &argv[0]);
+      std::cerr << "Cannot execute " << program << ": " << strerror (errno) << std::endl;
+      _exit (127);
+    }
+  return pid;
+}
+
+/**
+ * Append the samples of a trace of every run to a CSV file, read from
+ * the binary time series of the run if there is one, else from its
+ * "time value" text file.
+ *
+ * \param output the output directory of the sweep
+ * \param runs the runs
+ * \param name the name of the trace
+ */
+static void
+MergeTraces (const std::string &output, const std::vector<SweepRun> &runs, const std::string &name)
+{
+  std::ofstream out ((output + "/" + name + ".csv").c_str ());
+  out << "id,time," << name << "\n";
+  for (std::vector<SweepRun>::const_iterator r = runs.begin (); r != runs.end (); ++r)
+    {
+      std::string trace = r->dir + "/" + r->transport + "-" + name;
+      TimeSeriesReader reader;
+      if (FileExists (trace + ".nts") && reader.Open (trace + ".nts"))
+        {
+          std::vector<TimeSeriesFile::Record> records;
+          for (uint32_t i = 0; i < reader.GetNBlocks (); ++i)
+            {
+              records.clear ();
+              reader.ReadBlock (i, records);
+              for (std::vector<TimeSeriesFile::Record>::const_iterator s = records.begin (); s != records.end (); ++s)
+                {
+                  out << r->id << "," << reader.GetSeconds (s->time) << "," << s->value << "\n";
+                }
+            }
+          continue;
+        }
+      std::ifstream in ((trace + ".data").c_str ());
+      double time;
+      double value;
+      while (in >> time >> value)
+        {
+          out << r->id << "," << time << "," << value << "\n";
+        }
+    }
+}
+
+/**
+ * Get the value of an attribute of an XML element, with the times of the
+ * flow monitor ("+1.5ns") reduced to a number of nanoseconds.
+ *
+ * \param element the element
+ * \param name the attribute name
+ * \returns the value, empty if the attribute is missing
+ */
+static std::string
+GetXmlAttribute (const std::string &element, const std::string &name)
+{
+  std::string key = " " + name + "=\"";
+  std::string::size_type start = element.find (key);
+  if (start == std::string::npos)
+    {
+      return "";
+    }
+  start += key.size ();
+  std::string value = element.substr (start, element.find ('"', start) - start);
+  if (value.size () > 3 && value[0] == '+' && value.compare (value.size () - 2, 2, "ns") == 0)
+    {
+      value = value.substr (1, value.size () - 3);
+    }
+  return value;
+}
+
+/**
+ * Merge the per flow statistics of the flow monitor of every run.
+ *
+ * \param output the output directory of the sweep
+ * \param runs the runs
+ */
+static void
+MergeFlowMonitors (const std::string &output, const std::vector<SweepRun> &runs)
+{
+  const char *fields[] = {
+    "flowId", "timeFirstTxPacket", "timeLastRxPacket", "txBytes", "rxBytes",
+    "txPackets", "rxPackets", "lostPackets", "timesForwarded", "delaySum", "jitterSum"
+  };
+  const uint32_t nFields = sizeof (fields) / sizeof (fields[0]);
+
+  std::ofstream out ((output + "/flows.csv").c_str ());
+  out << "id";
+  for (uint32_t f = 0; f < nFields; ++f)
+    {
+      out << "," << fields[f];
+    }
+  out << std::endl;
+
+  for (std::vector<SweepRun>::const_iterator r = runs.begin (); r != runs.end (); ++r)
+    {
+      std::ifstream in ((r->dir + "/" + r->transport + ".flowmonitor").c_str ());
+      std::string line;
+      bool inFlowStats = false;
+      while (std::getline (in, line))
+        {
+          if (line.find ("<FlowStats>") != std::string::npos)
+            {
+              inFlowStats = true;
+            }
+          else if (line.find ("</FlowStats>") != std::string::npos)
+            {
+              inFlowStats = false;
+            }
+          else if (inFlowStats && line.find ("<Flow ") != std::string::npos)
+            {
+              out << r->id;
+              for (uint32_t f = 0; f < nFields; ++f)
+                {
+                  out << "," << GetXmlAttribute (line, fields[f]);
+                }
+              out << std::endl;
+            }
+        }
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  std::string transports = "TcpNewReno,TcpWestwood,TcpInigo";
+  std::string numFlows = "1";
+  std::string errorPs = "0.0";
+  std::string queueTypes = "ns3::DropTailQueue";
+  std::string runList = "0";
+  std::string output = "tcp-variants-sweep";
+  std::string program = "";
+  std::string extraArgs = "";
+  uint32_t jobs = 0;
+  bool resume = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Run a parameter sweep of tcp-experimental-variants-comparison "
+             "in parallel processes and merge the outputs of the runs.\n"
+             "The swept parameters are comma separated lists.");
+  cmd.AddValue ("transport_prot", "Transport protocols to sweep", transports);
+  cmd.AddValue ("num_flows", "Numbers of flows to sweep", numFlows);
+  cmd.AddValue ("error_p", "Packet error rates to sweep", errorPs);
+  cmd.AddValue ("queue_type", "Queue types of the gateway to sweep", queueTypes);
+  cmd.AddValue ("run", "Run indexes to sweep, as a list of indexes and ranges (e.g. 0-4,7)", runList);
+  cmd.AddValue ("args", "Other arguments of tcp-experimental-variants-comparison, "
+                "passed to every run (e.g. '--duration=20 --sack=1')", extraArgs);
+  cmd.AddValue ("output", "Output directory of the sweep", output);
+  cmd.AddValue ("program", "Path of tcp-experimental-variants-comparison "
+                "(default: next to this program)", program);
+  cmd.AddValue ("jobs", "Number of simultaneous runs (default: number of cores)", jobs);
+  cmd.AddValue ("resume", "Skip the runs already completed in the output directory", resume);
+  cmd.Parse (argc, argv);
+
+  if (program.empty ())
+    {
+      program = argv[0];
+      std::string::size_type pos = program.rfind ("tcp-variants-sweep");
+      NS_ABORT_MSG_IF (pos == std::string::npos, "Cannot find the simulation program, use --program");
+      program.replace (pos, strlen ("tcp-variants-sweep"), "tcp-experimental-variants-comparison");
+    }
+  NS_ABORT_MSG_IF (!FileExists (program), "Simulation program " << program << " not found");
+  if (jobs == 0)
+    {
+      long cores = sysconf (_SC_NPROCESSORS_ONLN);
+      jobs = cores > 0 ? cores : 1;
+    }
+
+  std::vector<std::string> extra = Split (extraArgs, ' ');
+  std::vector<std::string> transportList = Split (transports, ',');
+  std::vector<std::string> numFlowsList = Split (numFlows, ',');
+  std::vector<std::string> errorPList = Split (errorPs, ',');
+  std::vector<std::string> queueTypeList = Split (queueTypes, ',');
+  std::vector<std::string> runs = ExpandRuns (runList);
+
+  std::vector<SweepRun> sweep;
+  for (uint32_t t = 0; t < transportList.size (); ++t)
+    {
+      for (uint32_t n = 0; n < numFlowsList.size (); ++n)
+        {
+          for (uint32_t e = 0; e < errorPList.size (); ++e)
+            {
+              for (uint32_t q = 0; q < queueTypeList.size (); ++q)
+                {
+                  for (uint32_t r = 0; r < runs.size (); ++r)
+                    {
+                      SweepRun run;
+                      run.id = sweep.size ();
+                      run.transport = transportList[t];
+                      run.numFlows = numFlowsList[n];
+                      run.errorP = errorPList[e];
+                      run.queueType = queueTypeList[q];
+                      run.run = runs[r];
+                      std::ostringstream dir;
+                      dir << output << "/runs/" << run.id;
+                      run.dir = dir.str ();
+                      run.status = -1;
+                      run.startMs = 0;
+                      run.durationMs = 0;
+                      sweep.push_back (run);
+                    }
+                }
+            }
+        }
+    }
+
+  std::cout << "Sweeping " << sweep.size () << " runs with " << jobs << " jobs into "
+            << output << std::endl;
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  std::map<pid_t, uint32_t> running;
+  uint32_t next = 0;
+  uint32_t failed = 0;
+  while (next < sweep.size () || !running.empty ())
+    {
+      while (next < sweep.size () && running.size () < jobs)
+        {
+          SweepRun &r = sweep[next++];
+          SystemPath::MakeDirectories (r.dir);
+          if (resume && FileExists (r.dir + "/done"))
+            {
+              r.status = 0;
+              continue;
+            }
+          r.startMs = clock.End ();
+          running[Launch (program, r, extra)] = r.id;
+        }
+      if (running.empty ())
+        {
+          continue;
+        }
+
+      int status;
+      pid_t pid = waitpid (-1, &status, 0);
+      NS_ABORT_MSG_IF (pid < 0, "waitpid failed: " << strerror (errno));
+      std::map<pid_t, uint32_t>::iterator it = running.find (pid);
+      if (it == running.end ())
+        {
+          continue;
+        }
+      SweepRun &r = sweep[it->second];
+      running.erase (it);
+      r.durationMs = clock.End () - r.startMs;
+      r.status = WIFEXITED (status) ? WEXITSTATUS (status) : 128 + WTERMSIG (status);
+      if (r.status == 0)
+        {
+          std::ofstream done ((r.dir + "/done").c_str ());
+        }
+      else
+        {
+          ++failed;
+        }
+      std::cout << "[" << r.id + 1 << "/" << sweep.size () << "] " << r.transport
+                << " num_flows=" << r.numFlows << " error_p=" << r.errorP
+                << " queue_type=" << r.queueType << " run=" << r.run
+                << (r.status == 0 ? " done in " : " FAILED after ")
+                << r.durationMs / 1000.0 << " s" << std::endl;
+    }
+
+  std::ofstream index ((output + "/index.csv").c_str ());
+  index << "id,transport_prot,num_flows,error_p,queue_type,run,status,seconds,dir" << std::endl;
+  for (std::vector<SweepRun>::const_iterator r = sweep.begin (); r != sweep.end (); ++r)
+    {
+      index << r->id << "," << r->transport << "," << r->numFlows << "," << r->errorP << ","
+            << r->queueType << "," << r->run << "," << r->status << ","
+            << r->durationMs / 1000.0 << "," << r->dir << std::endl;
+    }
+  index.close ();
+
+  MergeTraces (output, sweep, "cwnd");
+  MergeTraces (output, sweep, "ssth");
+  MergeTraces (output, sweep, "rtt");
+  MergeTraces (output, sweep, "rto");
+  MergeFlowMonitors (output, sweep);
+
+  std::cout << "Sweep done in " << clock.End () / 1000.0 << " s, " << failed << " runs failed"
+            << std::endl;
+  return failed == 0 ? 0 : 1;
+}
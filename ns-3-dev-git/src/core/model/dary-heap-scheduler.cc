@@ -0,0 +1,407 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dary-heap-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "fatal-error.h"
+#include "log.h"
+#include "uinteger.h"
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DaryHeapScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (DaryHeapScheduler);
+
+/** Size of a cache line, the alignment of the heap array. */
+static const size_t CACHE_LINE_SIZE = 64;
+/** Initial number of entries of the index from the uids to the slots. */
+static const uint32_t INITIAL_INDEX_SIZE = 256;
+/** Value of Slot::m_next marking the slot of a removed event. */
+static const uint32_t REMOVED_SLOT = 0xffffffff;
+
+TypeId
+DaryHeapScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DaryHeapScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<DaryHeapScheduler> ()
+    .AddAttribute ("Arity",
+                   "The number of children of a node of the heap, a power of two",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&DaryHeapScheduler::SetArity,
+                                         &DaryHeapScheduler::GetArity),
+                   MakeUintegerChecker<uint32_t> (2, 16))
+  ;
+  return tid;
+}
+
+DaryHeapScheduler::DaryHeapScheduler ()
+  : m_arity (4),
+    m_shift (2),
+    m_heap (0),
+    m_size (0),
+    m_capacity (0),
+    m_freeSlot (0),
+    m_removedCount (0)
+{
+  NS_LOG_FUNCTION (this);
+  IndexEntry empty = { 0, 0 };
+  m_index.resize (INITIAL_INDEX_SIZE, empty);
+}
+
+DaryHeapScheduler::~DaryHeapScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+  free (m_heap);
+}
+
+void
+DaryHeapScheduler::SetArity (uint32_t arity)
+{
+  NS_LOG_FUNCTION (this << arity);
+  if (arity < 2 || (arity & (arity - 1)) != 0)
+    {
+      NS_FATAL_ERROR ("The arity of the heap must be a power of two, not " << arity);
+    }
+  NS_ASSERT_MSG (m_size == 0, "The arity cannot change once events are scheduled");
+
+  free (m_heap);
+  m_heap = 0;
+  m_capacity = 0;
+  m_arity = arity;
+  m_shift = 0;
+  while ((1U << m_shift) < arity)
+    {
+      ++m_shift;
+    }
+}
+
+uint32_t
+DaryHeapScheduler::GetArity (void) const
+{
+  return m_arity;
+}
+
+bool
+DaryHeapScheduler::IsLess (const Node &a, const Node &b)
+{
+  return a.m_ts < b.m_ts || (a.m_ts == b.m_ts && a.m_uid < b.m_uid);
+}
+
+/*
+ * The nodes before the root are padding: with the root at index d - 1, the
+ * children of node i start at index d * (i - d + 2), a multiple of d, so
+ * that every group of siblings starts on a cache line.
+ */
+uint32_t
+DaryHeapScheduler::Root (void) const
+{
+  return m_arity - 1;
+}
+
+uint32_t
+DaryHeapScheduler::FirstChild (uint32_t id) const
+{
+  return (id - m_arity + 2) << m_shift;
+}
+
+uint32_t
+DaryHeapScheduler::Parent (uint32_t id) const
+{
+  return (id >> m_shift) + m_arity - 2;
+}
+
+uint32_t
+DaryHeapScheduler::End (void) const
+{
+  return Root () + m_size;
+}
+
+void
+DaryHeapScheduler::SiftUp (uint32_t hole, const Node &node)
+{
+  while (hole != Root ())
+    {
+      uint32_t parent = Parent (hole);
+      if (!IsLess (node, m_heap[parent]))
+        {
+          break;
+        }
+      m_heap[hole] = m_heap[parent];
+      hole = parent;
+    }
+  m_heap[hole] = node;
+}
+
+void
+DaryHeapScheduler::SiftDown (uint32_t hole, const Node &node)
+{
+  uint32_t end = End ();
+  while (true)
+    {
+      uint32_t child = FirstChild (hole);
+      if (child >= end)
+        {
+          break;
+        }
+      uint32_t last = std::min (child + m_arity, end);
+      uint32_t smallest = child;
+      for (++child; child < last; ++child)
+        {
+          if (IsLess (m_heap[child], m_heap[smallest]))
+            {
+              smallest = child;
+            }
+        }
+      if (!IsLess (m_heap[smallest], node))
+        {
+          break;
+        }
+      m_heap[hole] = m_heap[smallest];
+      hole = smallest;
+    }
+  m_heap[hole] = node;
+}
+
+void
+DaryHeapScheduler::Reserve (void)
+{
+  if (m_size < m_capacity)
+    {
+      return;
+    }
+  uint32_t capacity = std::max<uint32_t> (m_capacity * 2, 64);
+  void *heap = 0;
+  if (posix_memalign (&heap, CACHE_LINE_SIZE, (Root () + capacity) * sizeof (Node)) != 0)
+    {
+      NS_FATAL_ERROR ("Cannot allocate a heap of " << capacity << " events");
+    }
+  if (m_heap != 0)
+    {
+      memcpy (heap, m_heap, End () * sizeof (Node));
+      free (m_heap);
+    }
+  m_heap = static_cast<Node *> (heap);
+  m_capacity = capacity;
+}
+
+uint32_t
+DaryHeapScheduler::AllocateSlot (const Scheduler::Event &ev)
+{
+  uint32_t slot = m_freeSlot;
+  if (slot == m_slots.size ())
+    {
+      m_slots.push_back (Slot ());
+      m_freeSlot = slot + 1;
+    }
+  else
+    {
+      m_freeSlot = m_slots[slot].m_next;
+    }
+  m_slots[slot].m_impl = ev.impl;
+  m_slots[slot].m_context = ev.key.m_context;
+  m_slots[slot].m_next = 0;
+  return slot;
+}
+
+void
+DaryHeapScheduler::FreeSlot (uint32_t slot)
+{
+  m_slots[slot].m_impl = 0;
+  m_slots[slot].m_next = m_freeSlot;
+  m_freeSlot = slot;
+}
+
+Scheduler::Event
+DaryHeapScheduler::GetEvent (const Node &node) const
+{
+  const Slot &slot = m_slots[node.m_slot];
+  Scheduler::Event ev;
+  ev.impl = slot.m_impl;
+  ev.key.m_ts = node.m_ts;
+  ev.key.m_uid = node.m_uid;
+  ev.key.m_context = slot.m_context;
+  return ev;
+}
+
+void
+DaryHeapScheduler::PopRoot (void)
+{
+  FreeSlot (m_heap[Root ()].m_slot);
+  --m_size;
+  if (m_size > 0)
+    {
+      SiftDown (Root (), m_heap[End ()]);
+    }
+}
+
+bool
+DaryHeapScheduler::IsRemoved (const Node &node) const
+{
+  return m_slots[node.m_slot].m_next == REMOVED_SLOT
+         || (!m_removed.empty () && m_removed.find (node.m_uid) != m_removed.end ());
+}
+
+void
+DaryHeapScheduler::PurgeRoot (void)
+{
+  while (m_removedCount > 0 && m_size > 0 && IsRemoved (m_heap[Root ()]))
+    {
+      m_removed.erase (m_heap[Root ()].m_uid);
+      --m_removedCount;
+      PopRoot ();
+    }
+}
+
+void
+DaryHeapScheduler::ResizeIndex (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+
+  IndexEntry empty = { 0, 0 };
+  m_index.assign (size, empty);
+  uint32_t end = End ();
+  for (uint32_t i = Root (); i < end; ++i)
+    {
+      IndexEntry entry = { m_heap[i].m_uid, m_heap[i].m_slot };
+      m_index[entry.m_uid & (size - 1)] = entry;
+    }
+}
+
+void
+DaryHeapScheduler::Compact (void)
+{
+  NS_LOG_FUNCTION (this << m_size << m_removedCount);
+
+  uint32_t end = End ();
+  uint32_t kept = Root ();
+  for (uint32_t i = Root (); i < end; ++i)
+    {
+      if (IsRemoved (m_heap[i]))
+        {
+          FreeSlot (m_heap[i].m_slot);
+        }
+      else
+        {
+          m_heap[kept++] = m_heap[i];
+        }
+    }
+  m_size = kept - Root ();
+  m_removed.clear ();
+  m_removedCount = 0;
+
+  // Bottom-up heap construction
+  if (m_size > 1)
+    {
+      for (uint32_t i = Parent (End () - 1) + 1; i-- > Root (); )
+        {
+          Node node = m_heap[i];
+          SiftDown (i, node);
+        }
+    }
+}
+
+void
+DaryHeapScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  Reserve ();
+  Node node;
+  node.m_ts = ev.key.m_ts;
+  node.m_uid = ev.key.m_uid;
+  node.m_slot = AllocateSlot (ev);
+  ++m_size;
+  SiftUp (End () - 1, node);
+
+  if (m_size > m_index.size () / 2)
+    {
+      ResizeIndex (m_index.size () * 2);
+    }
+  else
+    {
+      IndexEntry entry = { node.m_uid, node.m_slot };
+      m_index[node.m_uid & (m_index.size () - 1)] = entry;
+    }
+}
+
+bool
+DaryHeapScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  // Removed events never stay at the root, so a non-empty heap holds live events
+  return m_size == 0;
+}
+
+Scheduler::Event
+DaryHeapScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_size > 0);
+  return GetEvent (m_heap[Root ()]);
+}
+
+Scheduler::Event
+DaryHeapScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_size > 0);
+  Scheduler::Event next = GetEvent (m_heap[Root ()]);
+  PopRoot ();
+  PurgeRoot ();
+  return next;
+}
+
+void
+DaryHeapScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  NS_ASSERT (m_size > 0);
+  if (m_heap[Root ()].m_uid == ev.key.m_uid)
+    {
+      PopRoot ();
+      PurgeRoot ();
+      return;
+    }
+  const IndexEntry &entry = m_index[ev.key.m_uid & (m_index.size () - 1)];
+  if (entry.m_uid == ev.key.m_uid)
+    {
+      NS_ASSERT (m_slots[entry.m_slot].m_impl == ev.impl);
+      m_slots[entry.m_slot].m_next = REMOVED_SLOT;
+    }
+  else
+    {
+      m_removed.insert (ev.key.m_uid);
+    }
+  ++m_removedCount;
+  if (m_removedCount * 2 > m_size)
+    {
+      Compact ();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DARY_HEAP_SCHEDULER_H
+#define DARY_HEAP_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <set>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::DaryHeapScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a d-ary heap event scheduler with lazy removal
+ *
+ * The heap holds only the sorting key of each event (time stamp and uid)
+ * and the index of a slot holding the rest of the event, so that a node
+ * takes 16 bytes. The children of a node are contiguous, and the array is
+ * laid out so that every group of siblings starts on a cache line: with
+ * the default arity of 4 a sift down touches one cache line per level,
+ * and the heap is half as deep as a binary one. The arity is set with the
+ * "Arity" attribute, and must be a power of two (4 and 8 keep the sibling
+ * groups within whole cache lines).
+ *
+ * Remove does not search the heap: the event is marked as removed (a
+ * tombstone), and its node is dropped when it reaches the root. The slot of
+ * the event is found through a direct-mapped index on the low bits of the
+ * uids, sized to twice the heap, so that Remove is O(1); the few events
+ * whose index entry has been overwritten by a later event are recorded in a
+ * set instead. The heap is compacted when the tombstones outnumber the live
+ * events.
+ */
+class DaryHeapScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  DaryHeapScheduler ();
+  /** Destructor. */
+  virtual ~DaryHeapScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Heap node: the sorting key of an event and the slot of its data. */
+  struct Node
+  {
+    uint64_t m_ts;   //!< Event time stamp
+    uint32_t m_uid;  //!< Event unique id
+    uint32_t m_slot; //!< Index of the event in m_slots
+  };
+
+  /** Entry of the index from the uids to the slots. */
+  struct IndexEntry
+  {
+    uint32_t m_uid;  //!< Event unique id
+    uint32_t m_slot; //!< Index of the event in m_slots
+  };
+
+  /** Event data which does not take part in the ordering. */
+  struct Slot
+  {
+    EventImpl *m_impl;  //!< Event implementation
+    uint32_t m_context; //!< Event context
+    uint32_t m_next;    //!< Next free slot, or marker of a removed event
+  };
+
+  /**
+   * Set the arity of the heap.
+   *
+   * \param [in] arity The number of children of a node, a power of two.
+   */
+  void SetArity (uint32_t arity);
+  /**
+   * Get the arity of the heap.
+   *
+   * \returns The number of children of a node.
+   */
+  uint32_t GetArity (void) const;
+
+  /**
+   * Compare (less than) two nodes.
+   *
+   * \param [in] a The first node.
+   * \param [in] b The second node.
+   * \returns \c true if \c a < \c b
+   */
+  static inline bool IsLess (const Node &a, const Node &b);
+  /**
+   * Get the index of the root.
+   *
+   * \returns The root index.
+   */
+  inline uint32_t Root (void) const;
+  /**
+   * Get the first child of a node.
+   *
+   * \param [in] id The parent index.
+   * \returns The index of the first child of \p id.
+   */
+  inline uint32_t FirstChild (uint32_t id) const;
+  /**
+   * Get the parent of a node.
+   *
+   * \param [in] id The child index, not the root.
+   * \returns The index of the parent of \p id.
+   */
+  inline uint32_t Parent (uint32_t id) const;
+  /**
+   * Get the index past the last node.
+   *
+   * \returns The end index.
+   */
+  inline uint32_t End (void) const;
+
+  /**
+   * Move a node up from a hole until the heap order holds.
+   *
+   * \param [in] hole The index of the hole.
+   * \param [in] node The node to place.
+   */
+  void SiftUp (uint32_t hole, const Node &node);
+  /**
+   * Move a node down from a hole until the heap order holds.
+   *
+   * \param [in] hole The index of the hole.
+   * \param [in] node The node to place.
+   */
+  void SiftDown (uint32_t hole, const Node &node);
+  /** Remove the root node and free its slot. */
+  void PopRoot (void);
+  /**
+   * Check if an event has been removed.
+   *
+   * \param [in] node The node of the event.
+   * \returns \c true if the node is a tombstone.
+   */
+  inline bool IsRemoved (const Node &node) const;
+  /**
+   * Rebuild the index from the uids to the slots with a new size.
+   *
+   * \param [in] size The number of entries, a power of two.
+   */
+  void ResizeIndex (uint32_t size);
+  /** Drop the removed events sitting at the root. */
+  void PurgeRoot (void);
+  /** Drop all the removed events and rebuild the heap. */
+  void Compact (void);
+  /**
+   * Make room for one more node.
+   */
+  void Reserve (void);
+
+  /**
+   * Store the data of an event.
+   *
+   * \param [in] ev The event.
+   * \returns The index of the slot.
+   */
+  uint32_t AllocateSlot (const Scheduler::Event &ev);
+  /**
+   * Release a slot.
+   *
+   * \param [in] slot The index of the slot.
+   */
+  void FreeSlot (uint32_t slot);
+  /**
+   * Rebuild an event from its node.
+   *
+   * \param [in] node The node.
+   * \returns The event.
+   */
+  Scheduler::Event GetEvent (const Node &node) const;
+
+  uint32_t m_arity;           //!< Number of children of a node
+  uint32_t m_shift;           //!< Log2 of m_arity
+  Node *m_heap;               //!< Cache line aligned array of nodes
+  uint32_t m_size;            //!< Number of nodes, removed ones included
+  uint32_t m_capacity;        //!< Number of nodes m_heap can hold
+  std::vector<Slot> m_slots;  //!< Event data, indexed by Node::m_slot
+  uint32_t m_freeSlot;        //!< First free slot
+  std::vector<IndexEntry> m_index; //!< Slots indexed by the low bits of the uids
+  uint32_t m_removedCount;    //!< Number of tombstones in the heap
+  std::set<uint32_t> m_removed; //!< Uids of the tombstones missing from m_index
+};
+
+} // namespace ns3
+
+#endif /* DARY_HEAP_SCHEDULER_H */
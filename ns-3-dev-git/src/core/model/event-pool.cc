@@ -0,0 +1,294 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "event-pool.h"
+#include "global-value.h"
+#include "boolean.h"
+#include "log.h"
+#include "multithreading.h"
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#include "system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
+#include <new>
+#include <algorithm>
+#include <string.h>
+
+/**
+ * \file
+ * \ingroup events
+ * ns3::EventPool implementation.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EventPool");
+
+/**
+ * \ingroup events
+ * Allocate the events from the event pool.
+ */
+static GlobalValue g_eventPoolEnabled = GlobalValue
+  ("EventPoolEnabled",
+   "Allocate the simulation events from the event pool; "
+   "must be set before the first event is scheduled",
+   BooleanValue (true),
+   MakeBooleanChecker ());
+
+namespace {
+
+/** Size classes are multiples of this size. */
+const std::size_t GRANULE = 16;
+/** Number of size classes. */
+const std::size_t CLASSES = 16;
+/** Bytes a free list may hold. */
+const std::size_t MAX_CACHED_BYTES = 1 << 20;
+/** Blocks a free list may hold, whatever their size. */
+const std::size_t MIN_CACHED_BLOCKS = 16;
+
+/**
+ * The event pool of a thread. Only the thread of the pool writes its
+ * counters, with Multithreading::Publish, so that GetStats may read them
+ * from another thread.
+ */
+struct ThreadPool
+{
+  void *m_free[CLASSES];     //!< Free lists, linked through the first word of the blocks
+  uint32_t m_nFree[CLASSES]; //!< Number of blocks of each free list
+  uint64_t m_allocations;    //!< Number of events allocated
+  uint64_t m_reused;         //!< Allocations served from a free list
+  uint64_t m_large;          //!< Allocations too large for the size classes
+  int64_t m_live;            //!< Events allocated minus events released
+  int64_t m_peakLive;        //!< Highest value of m_live
+  uint64_t m_cached;         //!< Bytes of the blocks of the free lists
+  bool m_orphan;             //!< The thread of the pool exited
+  ThreadPool *m_next;        //!< Next pool of the list of all the pools
+};
+
+/** List of the pools of all the threads. */
+ThreadPool *g_pools = 0;
+
+#ifdef HAVE_PTHREAD_H
+/** The pool of the current thread. */
+__thread ThreadPool *g_threadPool = 0;
+
+/**
+ * \returns The mutex protecting g_pools.
+ */
+SystemMutex &
+GetPoolsMutex (void)
+{
+  static SystemMutex mutex;
+  return mutex;
+}
+
+/**
+ * Leave the pool of an exiting thread to the next thread created.
+ *
+ * \param [in] pool The pool of the thread.
+ */
+void
+ReleaseThreadPool (void *pool)
+{
+  CriticalSection cs (GetPoolsMutex ());
+  static_cast<ThreadPool *> (pool)->m_orphan = true;
+}
+
+/**
+ * \returns The key whose destructor releases the pool of a thread.
+ */
+pthread_key_t
+GetPoolKey (void)
+{
+  static struct PoolKey
+  {
+    PoolKey ()
+    {
+      pthread_key_create (&key, &ReleaseThreadPool);
+    }
+    pthread_key_t key; //!< The key
+  } poolKey;
+  return poolKey.key;
+}
+#else /* HAVE_PTHREAD_H */
+/** The pool of the only thread. */
+ThreadPool *g_threadPool = 0;
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \returns The pool of the current thread, created or taken over from an
+ * exited thread on first use.
+ */
+ThreadPool *
+GetThreadPool (void)
+{
+  if (g_threadPool == 0)
+    {
+      ThreadPool *pool = 0;
+      {
+#ifdef HAVE_PTHREAD_H
+        CriticalSection cs (GetPoolsMutex ());
+#endif /* HAVE_PTHREAD_H */
+        for (ThreadPool *i = g_pools; i != 0 && pool == 0; i = i->m_next)
+          {
+            if (i->m_orphan)
+              {
+                pool = i;
+                pool->m_orphan = false;
+              }
+          }
+        if (pool == 0)
+          {
+            pool = new ThreadPool;
+            memset (pool, 0, sizeof (ThreadPool));
+            pool->m_next = g_pools;
+            g_pools = pool;
+          }
+      }
+#ifdef HAVE_PTHREAD_H
+      pthread_setspecific (GetPoolKey (), pool);
+#endif /* HAVE_PTHREAD_H */
+      g_threadPool = pool;
+    }
+  return g_threadPool;
+}
+
+/**
+ * \returns The value of the "EventPoolEnabled" global value.
+ */
+bool
+ReadEnabled (void)
+{
+  BooleanValue enabled;
+  g_eventPoolEnabled.GetValue (enabled);
+  return enabled.Get ();
+}
+
+} // unnamed namespace
+
+bool
+EventPool::IsEnabled (void)
+{
+  static bool enabled = ReadEnabled ();
+  return enabled;
+}
+
+void *
+EventPool::Allocate (std::size_t size)
+{
+  if (!IsEnabled ())
+    {
+      return ::operator new (size);
+    }
+  ThreadPool *pool = GetThreadPool ();
+  Multithreading::Publish (pool->m_allocations, pool->m_allocations + 1);
+  Multithreading::Publish (pool->m_live, pool->m_live + 1);
+  if (pool->m_live > pool->m_peakLive)
+    {
+      Multithreading::Publish (pool->m_peakLive, pool->m_live);
+    }
+  if (size > CLASSES * GRANULE)
+    {
+      Multithreading::Publish (pool->m_large, pool->m_large + 1);
+      return ::operator new (size);
+    }
+  std::size_t cls = (size - 1) / GRANULE;
+  void *block = pool->m_free[cls];
+  if (block == 0)
+    {
+      return ::operator new ((cls + 1) * GRANULE);
+    }
+  Multithreading::Publish (pool->m_reused, pool->m_reused + 1);
+  pool->m_free[cls] = *static_cast<void **> (block);
+  --pool->m_nFree[cls];
+  Multithreading::Publish (pool->m_cached, pool->m_cached - (cls + 1) * GRANULE);
+  return block;
+}
+
+void
+EventPool::Deallocate (void *p, std::size_t size)
+{
+  if (!IsEnabled ())
+    {
+      ::operator delete (p);
+      return;
+    }
+  ThreadPool *pool = GetThreadPool ();
+  Multithreading::Publish (pool->m_live, pool->m_live - 1);
+  if (size > CLASSES * GRANULE)
+    {
+      ::operator delete (p);
+      return;
+    }
+  std::size_t cls = (size - 1) / GRANULE;
+  size = (cls + 1) * GRANULE;
+  if (pool->m_nFree[cls] >= MIN_CACHED_BLOCKS
+      && (pool->m_nFree[cls] + 1) * size > MAX_CACHED_BYTES)
+    {
+      ::operator delete (p);
+      return;
+    }
+  *static_cast<void **> (p) = pool->m_free[cls];
+  pool->m_free[cls] = p;
+  ++pool->m_nFree[cls];
+  Multithreading::Publish (pool->m_cached, pool->m_cached + size);
+}
+
+EventPool::Stats
+EventPool::GetStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Stats stats;
+  memset (&stats, 0, sizeof (stats));
+  int64_t live = 0;
+  int64_t peakLive = 0;
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (GetPoolsMutex ());
+#endif /* HAVE_PTHREAD_H */
+  for (ThreadPool *pool = g_pools; pool != 0; pool = pool->m_next)
+    {
+      stats.allocations += Multithreading::Read (pool->m_allocations);
+      stats.reused += Multithreading::Read (pool->m_reused);
+      stats.large += Multithreading::Read (pool->m_large);
+      live += Multithreading::Read (pool->m_live);
+      peakLive = std::max (peakLive, Multithreading::Read (pool->m_peakLive));
+      stats.cached += Multithreading::Read (pool->m_cached);
+    }
+  stats.live = live;
+  stats.peakLive = peakLive;
+  return stats;
+}
+
+double
+EventPool::Stats::GetReuseRate (void) const
+{
+  return allocations == 0 ? 0 : static_cast<double> (reused) / allocations;
+}
+
+std::ostream &
+operator << (std::ostream &os, const EventPool::Stats &stats)
+{
+  os << "allocations=" << stats.allocations
+     << " reuse=" << stats.GetReuseRate ()
+     << " large=" << stats.large
+     << " live=" << stats.live
+     << " peak=" << stats.peakLive
+     << " cached=" << stats.cached;
+  return os;
+}
+
+} // namespace ns3
@@ -153,7 +153,14 @@ void
 HeapScheduler::BottomUp (void)
 {
   NS_LOG_FUNCTION (this);
-  uint32_t index = Last ();
+  BottomUp (Last ());
+}
+
+void
+HeapScheduler::BottomUp (uint32_t start)
+{
+  NS_LOG_FUNCTION (this << start);
+  uint32_t index = start;
   while (!IsRoot (index)
          && IsLessStrictly (index, Parent (index)))
     {
@@ -236,7 +243,15 @@ HeapScheduler::Remove (const Event &ev)
           NS_ASSERT (m_heap[i].impl == ev.impl);
           Exch (i, Last ());
           m_heap.pop_back ();
-          TopDown (i);
+          // The former last item may belong above or below i
+          if (i < m_heap.size () && !IsRoot (i) && IsLessStrictly (i, Parent (i)))
+            {
+              BottomUp (i);
+            }
+          else
+            {
+              TopDown (i);
+            }
           return;
         }
     }
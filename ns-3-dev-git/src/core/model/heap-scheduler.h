@@ -153,6 +153,12 @@ private:
   inline void Exch (uint32_t a, uint32_t b);
   /** Percolate a newly inserted Last item to its proper position. */ 
   void BottomUp (void);
+  /**
+   * Percolate an item up the heap to its proper position.
+   *
+   * \param [in] start Starting entry.
+   */
+  void BottomUp (uint32_t start);
   /**
    * Percolate a deletion bubble down the heap.
    *
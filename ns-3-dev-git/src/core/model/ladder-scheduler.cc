@@ -0,0 +1,585 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+/** Number of events of a bucket above which it is spread over a new rung. */
+static const uint32_t THRESHOLD = 50;
+/** Maximum number of rungs of the ladder. */
+static const uint32_t MAX_RUNGS = 8;
+/** Number of events of the bottom above which it is spread over a new rung. */
+static const uint32_t BOTTOM_LIMIT = 2 * THRESHOLD;
+/** Number of time stamps sampled to estimate the width of the first rung. */
+static const uint32_t SAMPLE_SIZE = 64;
+/** End of a chain of nodes of a bucket. */
+static const uint32_t NO_NODE = 0xffffffff;
+/** Initial number of entries of the index from the uids to the slots. */
+static const uint32_t INITIAL_INDEX_SIZE = 256;
+/** Value of Slot::m_next marking the slot of a removed event. */
+static const uint32_t REMOVED_SLOT = 0xffffffff;
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (0),
+    m_topMax (0),
+    m_topStart (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_live (0),
+    m_removedCount (0),
+    m_freeSlot (0)
+{
+  NS_LOG_FUNCTION (this);
+  IndexEntry empty = { 0, 0 };
+  m_index.resize (INITIAL_INDEX_SIZE, empty);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+LadderScheduler::Later::operator () (const Node &a, const Node &b) const
+{
+  return a.m_ts > b.m_ts || (a.m_ts == b.m_ts && a.m_uid > b.m_uid);
+}
+
+uint32_t
+LadderScheduler::AllocateSlot (const Scheduler::Event &ev)
+{
+  uint32_t slot = m_freeSlot;
+  if (slot == m_slots.size ())
+    {
+      m_slots.push_back (Slot ());
+      m_freeSlot = slot + 1;
+    }
+  else
+    {
+      m_freeSlot = m_slots[slot].m_next;
+    }
+  m_slots[slot].m_impl = ev.impl;
+  m_slots[slot].m_context = ev.key.m_context;
+  m_slots[slot].m_next = 0;
+  return slot;
+}
+
+void
+LadderScheduler::FreeSlot (uint32_t slot)
+{
+  m_slots[slot].m_impl = 0;
+  m_slots[slot].m_next = m_freeSlot;
+  m_freeSlot = slot;
+}
+
+Scheduler::Event
+LadderScheduler::GetEvent (const Node &node) const
+{
+  const Slot &slot = m_slots[node.m_slot];
+  Scheduler::Event ev;
+  ev.impl = slot.m_impl;
+  ev.key.m_ts = node.m_ts;
+  ev.key.m_uid = node.m_uid;
+  ev.key.m_context = slot.m_context;
+  return ev;
+}
+
+bool
+LadderScheduler::IsRemoved (const Node &node) const
+{
+  return m_slots[node.m_slot].m_next == REMOVED_SLOT
+         || (!m_removed.empty () && m_removed.find (node.m_uid) != m_removed.end ());
+}
+
+void
+LadderScheduler::DropRemoved (const Node &node)
+{
+  if (!m_removed.empty ())
+    {
+      m_removed.erase (node.m_uid);
+    }
+  --m_removedCount;
+  FreeSlot (node.m_slot);
+}
+
+void
+LadderScheduler::ResizeIndex (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+
+  IndexEntry empty = { 0, 0 };
+  m_index.assign (size, empty);
+  std::vector<Node>::const_iterator i;
+  for (i = m_top.begin (); i != m_top.end (); ++i)
+    {
+      IndexEntry entry = { i->m_uid, i->m_slot };
+      m_index[i->m_uid & (size - 1)] = entry;
+    }
+  for (i = m_bottom.begin (); i != m_bottom.end (); ++i)
+    {
+      IndexEntry entry = { i->m_uid, i->m_slot };
+      m_index[i->m_uid & (size - 1)] = entry;
+    }
+  for (uint32_t r = 0; r < m_nRungs; ++r)
+    {
+      const Rung &rung = m_rungs[r];
+      for (uint32_t b = rung.m_current; b < rung.m_head.size (); ++b)
+        {
+          for (uint32_t n = rung.m_head[b]; n != NO_NODE; n = rung.m_next[n])
+            {
+              IndexEntry entry = { rung.m_nodes[n].m_uid, rung.m_nodes[n].m_slot };
+              m_index[entry.m_uid & (size - 1)] = entry;
+            }
+        }
+    }
+}
+
+void
+LadderScheduler::InitRung (uint32_t rung, uint64_t start, uint64_t width, uint32_t buckets)
+{
+  NS_LOG_FUNCTION (this << rung << start << width << buckets);
+  Rung &r = m_rungs[rung];
+  r.m_start = start;
+  r.m_width = width;
+  r.m_current = 0;
+  r.m_nodes.clear ();
+  r.m_next.clear ();
+  r.m_head.assign (buckets, NO_NODE);
+  r.m_count.assign (buckets, 0);
+}
+
+uint64_t
+LadderScheduler::GetCurrentStart (uint32_t rung) const
+{
+  const Rung &r = m_rungs[rung];
+  return r.m_start + r.m_current * r.m_width;
+}
+
+void
+LadderScheduler::AddToRung (uint32_t rung, const Node &node)
+{
+  Rung &r = m_rungs[rung];
+  uint32_t bucket = (node.m_ts - r.m_start) / r.m_width;
+  NS_ASSERT (bucket >= r.m_current && bucket < r.m_head.size ());
+  uint32_t n = r.m_nodes.size ();
+  r.m_nodes.push_back (node);
+  r.m_next.push_back (r.m_head[bucket]);
+  r.m_head[bucket] = n;
+  ++r.m_count[bucket];
+}
+
+/*
+ * The events of a simulation are far from uniform: most of them are
+ * packet events in the near future, with a tail of timers orders of
+ * magnitude further. The width is sized for the decile range of a sample
+ * of the time stamps to hold about one event per bucket, and the number
+ * of buckets is bounded by four times the number of events.
+ */
+uint64_t
+LadderScheduler::EstimateWidth (const std::vector<Node> &nodes, uint64_t min, uint64_t max) const
+{
+  NS_ASSERT (!nodes.empty ());
+  uint32_t n = nodes.size ();
+  uint32_t samples = std::min (n, SAMPLE_SIZE);
+  uint32_t step = n / samples;
+  std::vector<uint64_t> ts (samples);
+  for (uint32_t i = 0; i < samples; ++i)
+    {
+      ts[i] = nodes[i * step].m_ts;
+    }
+  std::sort (ts.begin (), ts.end ());
+  uint32_t cut = samples / 10;
+  double span = ts[samples - 1 - cut] - ts[cut];
+  double events = static_cast<double> (samples - 2 * cut) / samples * n;
+  uint64_t width = static_cast<uint64_t> (span / events);
+  return std::max (width, (max - min) / (4 * static_cast<uint64_t> (n)) + 1);
+}
+
+void
+LadderScheduler::Place (const Node &node)
+{
+  if (node.m_ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = node.m_ts;
+          m_topMax = node.m_ts;
+        }
+      m_topMin = std::min (m_topMin, node.m_ts);
+      m_topMax = std::max (m_topMax, node.m_ts);
+      m_top.push_back (node);
+      return;
+    }
+  for (uint32_t r = 0; r < m_nRungs; ++r)
+    {
+      if (node.m_ts >= GetCurrentStart (r))
+        {
+          AddToRung (r, node);
+          return;
+        }
+    }
+  m_bottom.insert (std::lower_bound (m_bottom.begin (), m_bottom.end (), node, Later ()), node);
+  if (m_bottom.size () > BOTTOM_LIMIT && m_nRungs < MAX_RUNGS
+      && m_bottom.front ().m_ts != m_bottom.back ().m_ts)
+    {
+      SpreadBottom ();
+    }
+}
+
+void
+LadderScheduler::SpreadBottom (void)
+{
+  NS_LOG_FUNCTION (this << m_bottom.size ());
+
+  uint64_t min = m_bottom.back ().m_ts;
+  uint64_t max = (m_nRungs > 0 ? GetCurrentStart (m_nRungs - 1) : m_topStart) - 1;
+  uint64_t width = EstimateWidth (m_bottom, min, max);
+  InitRung (m_nRungs, min, width, (max - min) / width + 1);
+  for (std::vector<Node>::const_iterator i = m_bottom.begin (); i != m_bottom.end (); ++i)
+    {
+      if (IsRemoved (*i))
+        {
+          DropRemoved (*i);
+        }
+      else
+        {
+          AddToRung (m_nRungs, *i);
+        }
+    }
+  ++m_nRungs;
+  m_bottom.clear ();
+  Refill ();
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  while (m_bottom.empty ())
+    {
+      if (m_nRungs == 0)
+        {
+          NS_ASSERT (!m_top.empty ());
+          if (m_top.size () <= THRESHOLD)
+            {
+              for (std::vector<Node>::const_iterator i = m_top.begin (); i != m_top.end (); ++i)
+                {
+                  if (IsRemoved (*i))
+                    {
+                      DropRemoved (*i);
+                    }
+                  else
+                    {
+                      m_bottom.push_back (*i);
+                    }
+                }
+              std::sort (m_bottom.begin (), m_bottom.end (), Later ());
+              m_topStart = m_topMax + 1;
+            }
+          else
+            {
+              uint64_t width = EstimateWidth (m_top, m_topMin, m_topMax);
+              uint32_t buckets = (m_topMax - m_topMin) / width + 1;
+              InitRung (0, m_topMin, width, buckets);
+              for (std::vector<Node>::const_iterator i = m_top.begin (); i != m_top.end (); ++i)
+                {
+                  if (IsRemoved (*i))
+                    {
+                      DropRemoved (*i);
+                    }
+                  else
+                    {
+                      AddToRung (0, *i);
+                    }
+                }
+              m_nRungs = 1;
+              m_topStart = m_topMin + buckets * width;
+            }
+          m_top.clear ();
+          continue;
+        }
+
+      // References to the rungs stay valid: m_rungs is never resized
+      Rung &rung = m_rungs[m_nRungs - 1];
+      while (rung.m_current < rung.m_head.size () && rung.m_count[rung.m_current] == 0)
+        {
+          ++rung.m_current;
+        }
+      if (rung.m_current == rung.m_head.size ())
+        {
+          --m_nRungs;
+          continue;
+        }
+
+      uint32_t bucket = rung.m_current++;
+      uint32_t count = rung.m_count[bucket];
+      if (count > THRESHOLD && m_nRungs < MAX_RUNGS && rung.m_width > 1)
+        {
+          uint64_t width = (rung.m_width + count - 1) / count;
+          InitRung (m_nRungs, rung.m_start + bucket * rung.m_width, width,
+                    (rung.m_width + width - 1) / width);
+          for (uint32_t n = rung.m_head[bucket]; n != NO_NODE; n = rung.m_next[n])
+            {
+              if (IsRemoved (rung.m_nodes[n]))
+                {
+                  DropRemoved (rung.m_nodes[n]);
+                }
+              else
+                {
+                  AddToRung (m_nRungs, rung.m_nodes[n]);
+                }
+            }
+          ++m_nRungs;
+        }
+      else
+        {
+          for (uint32_t n = rung.m_head[bucket]; n != NO_NODE; n = rung.m_next[n])
+            {
+              if (IsRemoved (rung.m_nodes[n]))
+                {
+                  DropRemoved (rung.m_nodes[n]);
+                }
+              else
+                {
+                  m_bottom.push_back (rung.m_nodes[n]);
+                }
+            }
+          std::sort (m_bottom.begin (), m_bottom.end (), Later ());
+        }
+      rung.m_head[bucket] = NO_NODE;
+      rung.m_count[bucket] = 0;
+    }
+}
+
+void
+LadderScheduler::Purge (void)
+{
+  while (true)
+    {
+      while (!m_bottom.empty () && IsRemoved (m_bottom.back ()))
+        {
+          DropRemoved (m_bottom.back ());
+          m_bottom.pop_back ();
+        }
+      if (!m_bottom.empty ())
+        {
+          return;
+        }
+      if (m_live == 0)
+        {
+          Reset ();
+          return;
+        }
+      Refill ();
+    }
+}
+
+void
+LadderScheduler::Compact (void)
+{
+  NS_LOG_FUNCTION (this << m_live << m_removedCount);
+
+  std::vector<Node>::iterator kept = m_top.begin ();
+  for (std::vector<Node>::const_iterator i = m_top.begin (); i != m_top.end (); ++i)
+    {
+      if (IsRemoved (*i))
+        {
+          DropRemoved (*i);
+        }
+      else
+        {
+          if (kept == m_top.begin () || i->m_ts < m_topMin)
+            {
+              m_topMin = i->m_ts;
+            }
+          if (kept == m_top.begin () || i->m_ts > m_topMax)
+            {
+              m_topMax = i->m_ts;
+            }
+          *kept++ = *i;
+        }
+    }
+  m_top.erase (kept, m_top.end ());
+
+  for (uint32_t r = 0; r < m_nRungs; ++r)
+    {
+      Rung &rung = m_rungs[r];
+      std::vector<Node> nodes;
+      std::vector<uint32_t> next;
+      nodes.swap (rung.m_nodes);
+      next.swap (rung.m_next);
+      for (uint32_t b = rung.m_current; b < rung.m_head.size (); ++b)
+        {
+          uint32_t n = rung.m_head[b];
+          rung.m_head[b] = NO_NODE;
+          rung.m_count[b] = 0;
+          for (; n != NO_NODE; n = next[n])
+            {
+              if (IsRemoved (nodes[n]))
+                {
+                  DropRemoved (nodes[n]);
+                }
+              else
+                {
+                  AddToRung (r, nodes[n]);
+                }
+            }
+        }
+    }
+
+  kept = m_bottom.begin ();
+  for (std::vector<Node>::const_iterator i = m_bottom.begin (); i != m_bottom.end (); ++i)
+    {
+      if (IsRemoved (*i))
+        {
+          DropRemoved (*i);
+        }
+      else
+        {
+          *kept++ = *i;
+        }
+    }
+  m_bottom.erase (kept, m_bottom.end ());
+
+  NS_ASSERT (m_removedCount == 0 && m_removed.empty ());
+}
+
+void
+LadderScheduler::Reset (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_live == 0);
+  m_top.clear ();
+  m_topStart = 0;
+  m_nRungs = 0;
+  m_bottom.clear ();
+  m_slots.clear ();
+  m_freeSlot = 0;
+  m_removedCount = 0;
+  m_removed.clear ();
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  Node node;
+  node.m_ts = ev.key.m_ts;
+  node.m_uid = ev.key.m_uid;
+  node.m_slot = AllocateSlot (ev);
+  ++m_live;
+
+  if (m_live + m_removedCount > m_index.size () / 2)
+    {
+      ResizeIndex (m_index.size () * 2);
+    }
+  IndexEntry entry = { node.m_uid, node.m_slot };
+  m_index[node.m_uid & (m_index.size () - 1)] = entry;
+
+  Place (node);
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_live == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_live > 0);
+  return GetEvent (m_bottom.back ());
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_live > 0);
+  Node node = m_bottom.back ();
+  m_bottom.pop_back ();
+  Scheduler::Event next = GetEvent (node);
+  FreeSlot (node.m_slot);
+  --m_live;
+  Purge ();
+  return next;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << &ev);
+  NS_ASSERT (m_live > 0);
+  --m_live;
+  if (m_bottom.back ().m_uid == ev.key.m_uid)
+    {
+      FreeSlot (m_bottom.back ().m_slot);
+      m_bottom.pop_back ();
+      Purge ();
+      return;
+    }
+  const IndexEntry &entry = m_index[ev.key.m_uid & (m_index.size () - 1)];
+  if (entry.m_uid == ev.key.m_uid)
+    {
+      NS_ASSERT (m_slots[entry.m_slot].m_impl == ev.impl);
+      m_slots[entry.m_slot].m_next = REMOVED_SLOT;
+    }
+  else
+    {
+      m_removed.insert (ev.key.m_uid);
+    }
+  ++m_removedCount;
+  if (m_removedCount > m_live + THRESHOLD)
+    {
+      Compact ();
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "multithreading.h"
+#include "fatal-error.h"
+#include "log.h"
+#ifdef HAVE_PTHREAD_H
+#include "system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::Multithreading, ns3::MultithreadingMutex and
+ * ns3::MultithreadingCriticalSection implementations.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Multithreading");
+
+bool Multithreading::m_enabled = false;
+
+void
+Multithreading::Enable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+#ifdef HAVE_PTHREAD_H
+  m_enabled = true;
+  __sync_synchronize ();
+#else /* HAVE_PTHREAD_H */
+  NS_FATAL_ERROR ("Multithreading requires ns-3 to be built with threading support");
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+Multithreading::Disable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  __sync_synchronize ();
+  m_enabled = false;
+}
+
+MultithreadingMutex::MultithreadingMutex ()
+  : m_mutex (0)
+{
+#ifdef HAVE_PTHREAD_H
+  m_mutex = new SystemMutex ();
+#endif /* HAVE_PTHREAD_H */
+}
+
+MultithreadingMutex::~MultithreadingMutex ()
+{
+#ifdef HAVE_PTHREAD_H
+  delete m_mutex;
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+MultithreadingMutex::Lock (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (Multithreading::IsEnabled ())
+    {
+      m_mutex->Lock ();
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+MultithreadingMutex::Unlock (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (Multithreading::IsEnabled ())
+    {
+      m_mutex->Unlock ();
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+MultithreadingCriticalSection::MultithreadingCriticalSection (MultithreadingMutex &mutex)
+  : m_mutex (mutex)
+{
+  m_mutex.Lock ();
+}
+
+MultithreadingCriticalSection::~MultithreadingCriticalSection ()
+{
+  m_mutex.Unlock ();
+}
+
+} // namespace ns3
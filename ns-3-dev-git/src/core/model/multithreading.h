@@ -0,0 +1,255 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADING_H
+#define MULTITHREADING_H
+
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::Multithreading, ns3::MultithreadingMutex and
+ * ns3::MultithreadingCriticalSection declarations.
+ */
+
+namespace ns3 {
+
+class SystemMutex;
+
+/**
+ * \ingroup simulator
+ * \brief Switch for the synchronization of the state shared by the
+ * events of a multithreaded simulation.
+ *
+ * The reference counts of the objects, of the packets and of their
+ * buffers, as well as a few global counters, are updated without
+ * synchronization, which is only safe when a single thread runs the
+ * events. A simulator implementation which runs events in several
+ * threads at once enables the atomic updates for the duration of its
+ * Run, so that the sequential simulations keep paying for a plain
+ * increment.
+ *
+ * Enable and Disable must only be called while no event runs.
+ */
+class Multithreading
+{
+public:
+  /**
+   * Use atomic updates until Disable is called. This is fatal when
+   * ns-3 is built without threading support.
+   */
+  static void Enable (void);
+  /**
+   * Go back to the plain updates.
+   */
+  static void Disable (void);
+  /**
+   * \returns true if several threads may run events at once
+   */
+  static inline bool IsEnabled (void)
+  {
+    return m_enabled;
+  }
+
+  /**
+   * Increment a counter shared by the threads.
+   *
+   * \param [in,out] count the counter
+   */
+  static inline void Increment (uint32_t &count)
+  {
+    if (m_enabled)
+      {
+        __sync_add_and_fetch (&count, 1);
+      }
+    else
+      {
+        count++;
+      }
+  }
+  /**
+   * Decrement a counter shared by the threads.
+   *
+   * \param [in,out] count the counter
+   * \returns the decremented value; only the thread which sees zero may
+   * release the object the counter belongs to
+   */
+  static inline uint32_t Decrement (uint32_t &count)
+  {
+    if (m_enabled)
+      {
+        return __sync_sub_and_fetch (&count, 1);
+      }
+    return --count;
+  }
+  /**
+   * Allocate a value from a counter shared by the threads.
+   *
+   * \param [in,out] counter the counter
+   * \returns the value of the counter before its increment
+   */
+  static inline uint32_t FetchAndIncrement (uint32_t &counter)
+  {
+    if (m_enabled)
+      {
+        return __sync_fetch_and_add (&counter, 1);
+      }
+    return counter++;
+  }
+  /**
+   * \copydoc FetchAndIncrement(uint32_t&)
+   */
+  static inline uint64_t FetchAndIncrement (uint64_t &counter)
+  {
+    if (m_enabled)
+      {
+        return __sync_fetch_and_add (&counter, 1);
+      }
+    return counter++;
+  }
+  /**
+   * Add to a counter shared by the threads.
+   *
+   * \param [in,out] counter the counter
+   * \param [in] delta the value to add, negative to subtract
+   * \returns the value of the counter after the addition
+   */
+  static inline uint64_t Add (uint64_t &counter, int64_t delta)
+  {
+    if (m_enabled)
+      {
+        return __sync_add_and_fetch (&counter, delta);
+      }
+    return counter += delta;
+  }
+  /**
+   * Raise a maximum shared by the threads to a value, if it is lower.
+   *
+   * \param [in,out] maximum the maximum
+   * \param [in] value the value
+   */
+  static inline void Raise (uint64_t &maximum, uint64_t value)
+  {
+    if (m_enabled)
+      {
+        uint64_t current = __atomic_load_n (&maximum, __ATOMIC_RELAXED);
+        while (current < value
+               && !__atomic_compare_exchange_n (&maximum, &current, value, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+          {
+          }
+      }
+    else if (maximum < value)
+      {
+        maximum = value;
+      }
+  }
+
+  /**
+   * Write a counter which only the current thread writes, but which
+   * other threads may read with Read at the same time, such as the
+   * counters of a per-thread pool. The thread reads its own counters
+   * directly.
+   *
+   * \param [out] counter the counter
+   * \param [in] value the new value
+   */
+  template <typename T>
+  static inline void Publish (T &counter, T value)
+  {
+    __atomic_store_n (&counter, value, __ATOMIC_RELAXED);
+  }
+  /**
+   * Read a counter written by another thread with Publish.
+   *
+   * \param [in] counter the counter
+   * \returns the last value published
+   */
+  template <typename T>
+  static inline T Read (const T &counter)
+  {
+    return __atomic_load_n (&counter, __ATOMIC_RELAXED);
+  }
+
+private:
+  /** Several threads may run events at once. */
+  static bool m_enabled;
+};
+
+/**
+ * \ingroup simulator
+ * \brief A mutex which is only locked while Multithreading is enabled.
+ *
+ * Objects shared by all the nodes of a simulation, such as a flow
+ * monitor, protect their state with it: a sequential simulation does
+ * not pay for the lock.
+ */
+class MultithreadingMutex
+{
+public:
+  MultithreadingMutex ();
+  ~MultithreadingMutex ();
+
+  /**
+   * Acquire the mutex, if Multithreading is enabled.
+   */
+  void Lock (void);
+  /**
+   * Release the mutex, if Multithreading is enabled.
+   */
+  void Unlock (void);
+
+private:
+  /**
+   * Copy constructor, not implemented.
+   * \param [in] o the other mutex
+   */
+  MultithreadingMutex (const MultithreadingMutex &o);
+  /**
+   * Assignment, not implemented.
+   * \param [in] o the other mutex
+   * \returns this mutex
+   */
+  MultithreadingMutex &operator = (const MultithreadingMutex &o);
+
+  /** The mutex; null without threading support. */
+  SystemMutex *m_mutex;
+};
+
+/**
+ * \ingroup simulator
+ * \brief Lock a MultithreadingMutex for the lifetime of this object.
+ */
+class MultithreadingCriticalSection
+{
+public:
+  /**
+   * Lock the mutex.
+   *
+   * \param [in] mutex the mutex
+   */
+  MultithreadingCriticalSection (MultithreadingMutex &mutex);
+  /** Unlock the mutex. */
+  ~MultithreadingCriticalSection ();
+
+private:
+  MultithreadingMutex &m_mutex; //!< The mutex
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADING_H */
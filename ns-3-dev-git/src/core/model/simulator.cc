@@ -23,6 +23,7 @@
 #include "scheduler.h"
 #include "map-scheduler.h"
 #include "event-impl.h"
+#include "event-pool.h"
 
 #include "ptr.h"
 #include "string.h"
@@ -180,6 +181,7 @@ Simulator::Destroy (void)
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
+  NS_LOG_INFO ("Event pool: " << EventPool::GetStats ());
 }
 
 void
@@ -121,6 +121,9 @@ public:
    * After this method has been invoked, it is actually possible
    * to restart a new simulation with a set of calls to Simulator::Run,
    * Simulator::Schedule and Simulator::ScheduleWithContext.
+   *
+   * The counters of the EventPool are logged at the INFO level
+   * of the Simulator log component.
    */
   static void Destroy (void);
 
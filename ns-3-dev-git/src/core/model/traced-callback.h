@@ -209,6 +209,16 @@ public:
   void operator() (T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6, T7 a7, T8 a8) const;
   /**@}*/
 
+  /**
+   * Check for an empty chain.
+   *
+   * Callers whose trace arguments are costly to build can skip the
+   * invocation entirely when nothing is connected.
+   *
+   * \returns \c true if no Callback is connected.
+   */
+  bool IsEmpty (void) const;
+
   /**
    *  TracedCallback signature for POD.
    *
@@ -314,6 +324,15 @@ TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::Disconnect (const CallbackBase & callba
   Callback<void,T1,T2,T3,T4,T5,T6,T7,T8> realCb = cb.Bind (path);
   DisconnectWithoutContext (realCb);
 }
+template<typename T1, typename T2, 
+         typename T3, typename T4,
+         typename T5, typename T6,
+         typename T7, typename T8>
+bool
+TracedCallback<T1,T2,T3,T4,T5,T6,T7,T8>::IsEmpty (void) const
+{
+  return m_callbackList.empty ();
+}
 template<typename T1, typename T2, 
          typename T3, typename T4,
          typename T5, typename T6,
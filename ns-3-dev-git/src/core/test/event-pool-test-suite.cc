@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/event-pool.h"
+
+using namespace ns3;
+
+/**
+ * Check the counters of the event pool and that the events allocated from
+ * it, small and large, carry their arguments.
+ */
+class EventPoolTestCase : public TestCase
+{
+public:
+  /** A bound argument too large for the size classes of the pool. */
+  struct Large
+  {
+    uint32_t values[100]; //!< Payload
+  };
+
+  EventPoolTestCase ();
+  virtual void DoRun (void);
+
+  /**
+   * Small event.
+   * \param a first argument
+   * \param b second argument
+   */
+  void Small (uint32_t a, uint64_t b);
+  /**
+   * Large event.
+   * \param large the argument
+   */
+  void Big (Large large);
+
+  uint64_t m_sum; //!< Sum of the arguments of the events
+};
+
+EventPoolTestCase::EventPoolTestCase ()
+  : TestCase ("Check the event pool counters"),
+    m_sum (0)
+{
+}
+
+void
+EventPoolTestCase::Small (uint32_t a, uint64_t b)
+{
+  m_sum += a + b;
+}
+
+void
+EventPoolTestCase::Big (Large large)
+{
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      m_sum += large.values[i];
+    }
+}
+
+void
+EventPoolTestCase::DoRun (void)
+{
+  if (!EventPool::IsEnabled ())
+    {
+      return;
+    }
+
+  EventPool::Stats before = EventPool::GetStats ();
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      Simulator::Schedule (NanoSeconds (i), &EventPoolTestCase::Small, this, i, 1);
+    }
+  Large large;
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      large.values[i] = i;
+    }
+  Simulator::Schedule (NanoSeconds (10), &EventPoolTestCase::Big, this, large);
+
+  EventPool::Stats scheduled = EventPool::GetStats ();
+  NS_TEST_ASSERT_MSG_EQ (scheduled.allocations - before.allocations, 1001, "Wrong allocations");
+  NS_TEST_ASSERT_MSG_EQ (scheduled.live - before.live, 1001, "Wrong live events");
+  NS_TEST_ASSERT_MSG_EQ (scheduled.large - before.large, 1, "Wrong large allocations");
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (scheduled.peakLive, scheduled.live, "Wrong peak");
+
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_sum, 999 * 1000 / 2 + 1000 + 99 * 100 / 2, "Wrong event arguments");
+  EventPool::Stats run = EventPool::GetStats ();
+  NS_TEST_ASSERT_MSG_EQ (run.live, before.live, "Events not released");
+  NS_TEST_ASSERT_MSG_GT (run.cached, scheduled.cached, "Released events not cached");
+
+  // The released events are reused
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      Simulator::Schedule (NanoSeconds (i), &EventPoolTestCase::Small, this, i, 1);
+    }
+  EventPool::Stats again = EventPool::GetStats ();
+  NS_TEST_ASSERT_MSG_EQ (again.reused - run.reused, 1000, "Released events not reused");
+  NS_TEST_ASSERT_MSG_LT (again.cached, run.cached, "Reused events still cached");
+  NS_TEST_ASSERT_MSG_GT (again.GetReuseRate (), 0, "Wrong reuse rate");
+
+  Simulator::Destroy ();
+  EventPool::Stats destroyed = EventPool::GetStats ();
+  NS_TEST_ASSERT_MSG_EQ (destroyed.live, before.live, "Events not released");
+
+  // The free lists keep at most 1 MB of each size class
+  for (uint32_t i = 0; i < 200000; ++i)
+    {
+      Simulator::Schedule (NanoSeconds (i), &EventPoolTestCase::Small, this, i, 1);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  EventPool::Stats burst = EventPool::GetStats ();
+  NS_TEST_ASSERT_MSG_EQ (burst.live, before.live, "Events not released");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (burst.cached, destroyed.cached + (1 << 20), "Surplus events cached");
+}
+
+/** The event pool test suite. */
+static class EventPoolTestSuite : public TestSuite
+{
+public:
+  EventPoolTestSuite ()
+    : TestSuite ("event-pool")
+  {
+    AddTestCase (new EventPoolTestCase (), TestCase::QUICK);
+  }
+} g_eventPoolTestSuite;
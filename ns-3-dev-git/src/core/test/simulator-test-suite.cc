@@ -23,6 +23,10 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/dary-heap-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/uinteger.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -459,6 +463,95 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/*
+ * Drive a scheduler and a MapScheduler with the same random sequence of
+ * insertions, removals of arbitrary events and removals of the earliest
+ * event, with many time stamp ties and delays spread over several orders
+ * of magnitude, and check that they always agree on the next event.
+ */
+class SchedulerRandomTestCase : public TestCase
+{
+public:
+  SchedulerRandomTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  uint32_t Random (uint32_t max);
+  ObjectFactory m_schedulerFactory;
+  uint32_t m_seed;
+};
+
+SchedulerRandomTestCase::SchedulerRandomTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check random insertions and removals with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory),
+    m_seed (1)
+{
+}
+
+uint32_t
+SchedulerRandomTestCase::Random (uint32_t max)
+{
+  m_seed = m_seed * 1103515245 + 12345;
+  return (m_seed >> 8) % max;
+}
+
+void
+SchedulerRandomTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<Scheduler> reference = CreateObject<MapScheduler> ();
+  std::vector<Scheduler::Event> scheduled;
+  uint64_t now = 0;
+  uint32_t uid = 4;
+
+  for (uint32_t i = 0; i < 20000; ++i)
+    {
+      uint32_t op = Random (10);
+      if (i < 2000 || op < 5 || scheduled.empty ())
+        {
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_ts = now + (Random (100) << (8 * Random (4)));
+          ev.key.m_uid = uid++;
+          ev.key.m_context = Random (16);
+          scheduler->Insert (ev);
+          reference->Insert (ev);
+          scheduled.push_back (ev);
+        }
+      else if (op < 7)
+        {
+          uint32_t index = Random (scheduled.size ());
+          scheduler->Remove (scheduled[index]);
+          reference->Remove (scheduled[index]);
+          scheduled[index] = scheduled.back ();
+          scheduled.pop_back ();
+        }
+      else
+        {
+          Scheduler::Event next = scheduler->RemoveNext ();
+          Scheduler::Event expected = reference->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, expected.key.m_uid, "Wrong next event");
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_ts, expected.key.m_ts, "Wrong time stamp");
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_context, expected.key.m_context, "Wrong context");
+          now = next.key.m_ts;
+          for (uint32_t j = 0; j < scheduled.size (); ++j)
+            {
+              if (scheduled[j].key.m_uid == next.key.m_uid)
+                {
+                  scheduled[j] = scheduled.back ();
+                  scheduled.pop_back ();
+                  break;
+                }
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), scheduled.empty (), "Wrong emptiness");
+      if (!scheduled.empty ())
+        {
+          NS_TEST_ASSERT_MSG_EQ (scheduler->PeekNext ().key.m_uid,
+                                 reference->PeekNext ().key.m_uid, "Wrong peeked event");
+        }
+    }
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +568,23 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (HeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (DaryHeapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
+    factory.Set ("Arity", UintegerValue (8));
+    AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
+    factory.Set ("Arity", UintegerValue (2));
+    AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
+    factory = ObjectFactory ();
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SchedulerRandomTestCase (factory), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -241,7 +241,9 @@ public:
       "ns3::ListScheduler",
       "ns3::HeapScheduler",
       "ns3::MapScheduler",
-      "ns3::CalendarScheduler"
+      "ns3::CalendarScheduler",
+      "ns3::DaryHeapScheduler",
+      "ns3::LadderScheduler"
     };
     unsigned int threadcounts[] = {
       0,
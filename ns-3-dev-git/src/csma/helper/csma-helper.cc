@@ -86,7 +86,7 @@ CsmaHelper::EnablePcapInternal (std::string prefix, Ptr<NetDevice> nd, bool prom
       return;
     }
 
-  PcapHelper pcapHelper;
+  PcapHelper &pcapHelper = m_pcapHelper;
 
   std::string filename;
   if (explicitFilename)
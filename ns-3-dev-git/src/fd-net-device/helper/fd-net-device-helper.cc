@@ -64,7 +64,7 @@ FdNetDeviceHelper::EnablePcapInternal (std::string prefix, Ptr<NetDevice> nd, bo
       return;
     }
 
-  PcapHelper pcapHelper;
+  PcapHelper &pcapHelper = m_pcapHelper;
 
   std::string filename;
   if (explicitFilename)
@@ -22,6 +22,7 @@
 #define FLOW_CLASSIFIER_H
 
 #include "ns3/simple-ref-count.h"
+#include "ns3/multithreading.h"
 #include <ostream>
 
 namespace ns3 {
@@ -76,6 +77,9 @@ protected:
   /// \returns a new FlowId
   FlowId GetNewFlowId ();
 
+  /// Serializes the classifications made by the threads of a
+  /// multithreaded simulation
+  MultithreadingMutex m_mutex;
 };
 
 
@@ -22,6 +22,9 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/abort.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -29,6 +32,9 @@
 
 #define PERIODIC_CHECK_INTERVAL (Seconds (1))
 
+// the flows with a larger identifier are found in m_flowStats only
+#define MAX_INDEXED_FLOW_ID (1 << 20)
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("FlowMonitor");
@@ -72,6 +78,12 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (0.5)),
                    MakeTimeAccessor (&FlowMonitor::m_flowInterruptionsMinTime),
                    MakeTimeChecker ())
+    .AddAttribute ("PacketSampling", ("Track one packet out of PacketSampling packets of each flow. "
+                                      "The delays, jitters, forwarding counts, timeout losses and probe "
+                                      "statistics only cover the tracked packets."),
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&FlowMonitor::m_packetSampling),
+                   MakeUintegerChecker<uint32_t> (1))
   ;
   return tid;
 }
@@ -83,7 +95,9 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_nTrackedPackets (0),
+    m_packetSampling (1),
+    m_enabled (false)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
@@ -102,12 +116,125 @@ FlowMonitor::DoDispose (void)
       m_flowProbes[i]->Dispose ();
       m_flowProbes[i] = 0;
     }
+  if (!m_exportInterval.IsZero ())
+    {
+      Simulator::Cancel (m_exportEvent);
+      Export ();
+      m_exportInterval = Seconds (0);
+    }
+  m_exportCsv = 0;
+  for (uint32_t i = 0; i < m_exportSeries.size (); i++)
+    {
+      m_exportSeries[i]->Close ();
+    }
+  m_exportSeries.clear ();
   Object::DoDispose ();
 }
 
+/**
+ * \brief Hash of a tracked packet
+ * \param flowId the Flow identification
+ * \param packetId the Packet identification
+ * \returns the hash value
+ */
+static inline uint32_t
+HashTrackedPacket (FlowId flowId, FlowPacketId packetId)
+{
+  uint32_t h = flowId * 0x9e3779b1U ^ packetId * 0x85ebca6bU;
+  return h ^ (h >> 15);
+}
+
+int32_t
+FlowMonitor::FindTrackedPacket (FlowId flowId, FlowPacketId packetId) const
+{
+  if (m_nTrackedPackets == 0)
+    {
+      return -1;
+    }
+  uint32_t mask = m_trackedPackets.size () - 1;
+  for (uint32_t i = HashTrackedPacket (flowId, packetId) & mask; m_trackedPackets[i].used; i = (i + 1) & mask)
+    {
+      if (m_trackedPackets[i].flowId == flowId && m_trackedPackets[i].packetId == packetId)
+        {
+          return i;
+        }
+    }
+  return -1;
+}
+
+FlowMonitor::TrackedPacket&
+FlowMonitor::AddTrackedPacket (FlowId flowId, FlowPacketId packetId)
+{
+  if (2 * (m_nTrackedPackets + 1) > m_trackedPackets.size ())
+    {
+      ResizeTrackedPackets (std::max<uint32_t> (64, 2 * m_trackedPackets.size ()));
+    }
+  uint32_t mask = m_trackedPackets.size () - 1;
+  uint32_t i = HashTrackedPacket (flowId, packetId) & mask;
+  while (m_trackedPackets[i].used)
+    {
+      if (m_trackedPackets[i].flowId == flowId && m_trackedPackets[i].packetId == packetId)
+        {
+          return m_trackedPackets[i].packet;
+        }
+      i = (i + 1) & mask;
+    }
+  m_trackedPackets[i].flowId = flowId;
+  m_trackedPackets[i].packetId = packetId;
+  m_trackedPackets[i].used = true;
+  m_nTrackedPackets++;
+  return m_trackedPackets[i].packet;
+}
+
+void
+FlowMonitor::RemoveTrackedPacket (uint32_t slot)
+{
+  // shift back the following packets of the cluster which may fill the
+  // hole, so that the lookups need no tombstones
+  uint32_t mask = m_trackedPackets.size () - 1;
+  uint32_t hole = slot;
+  for (uint32_t i = (slot + 1) & mask; m_trackedPackets[i].used; i = (i + 1) & mask)
+    {
+      uint32_t home = HashTrackedPacket (m_trackedPackets[i].flowId, m_trackedPackets[i].packetId) & mask;
+      if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+          m_trackedPackets[hole] = m_trackedPackets[i];
+          hole = i;
+        }
+    }
+  m_trackedPackets[hole].used = false;
+  m_nTrackedPackets--;
+}
+
+void
+FlowMonitor::ResizeTrackedPackets (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  std::vector<TrackedPacketSlot> old;
+  old.swap (m_trackedPackets);
+  TrackedPacketSlot empty;
+  empty.flowId = 0;
+  empty.packetId = 0;
+  empty.used = false;
+  empty.packet.timesForwarded = 0;
+  m_trackedPackets.resize (size, empty);
+  m_nTrackedPackets = 0;
+  for (std::vector<TrackedPacketSlot>::const_iterator i = old.begin (); i != old.end (); i++)
+    {
+      if (i->used)
+        {
+          AddTrackedPacket (i->flowId, i->packetId) = i->packet;
+        }
+    }
+}
+
 inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow (FlowId flowId)
 {
+  if (flowId < m_flowStatsIndex.size () && m_flowStatsIndex[flowId] != 0)
+    {
+      return *m_flowStatsIndex[flowId];
+    }
   FlowStatsContainerI iter;
   iter = m_flowStats.find (flowId);
   if (iter == m_flowStats.end ())
@@ -126,6 +253,15 @@ FlowMonitor::GetStatsForFlow (FlowId flowId)
       ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
       ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
       ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
+      if (flowId < MAX_INDEXED_FLOW_ID)
+        {
+          // the elements of a map do not move, so the index stays valid
+          if (flowId >= m_flowStatsIndex.size ())
+            {
+              m_flowStatsIndex.resize (flowId + 1, 0);
+            }
+          m_flowStatsIndex[flowId] = &ref;
+        }
       return ref;
     }
   else
@@ -142,15 +278,19 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
     {
       return;
     }
+  MultithreadingCriticalSection cs (m_mutex);
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
-  tracked.firstSeenTime = now;
-  tracked.lastSeenTime = tracked.firstSeenTime;
-  tracked.timesForwarded = 0;
-  NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
-                                                                << ").");
-
-  probe->AddPacketStats (flowId, packetSize, Seconds (0));
+  if (packetId % m_packetSampling == 0)
+    {
+      TrackedPacket &tracked = AddTrackedPacket (flowId, packetId);
+      tracked.firstSeenTime = now;
+      tracked.lastSeenTime = tracked.firstSeenTime;
+      tracked.timesForwarded = 0;
+      NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
+                                                                    << ").");
+
+      probe->AddPacketStats (flowId, packetSize, Seconds (0));
+    }
 
   FlowStats &stats = GetStatsForFlow (flowId);
   stats.txBytes += packetSize;
@@ -160,6 +300,7 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       stats.timeFirstTxPacket = now;
     }
   stats.timeLastTxPacket = now;
+  MarkFlowChanged (flowId);
 }
 
 
@@ -170,23 +311,50 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
     {
       return;
     }
-  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (key);
-  if (tracked == m_trackedPackets.end ())
+  if (packetId % m_packetSampling != 0)
+    {
+      return;
+    }
+  MultithreadingCriticalSection cs (m_mutex);
+  int32_t slot = FindTrackedPacket (flowId, packetId);
+  if (slot < 0)
     {
       NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
+  TrackedPacket &tracked = m_trackedPackets[slot].packet;
 
-  tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  tracked.timesForwarded++;
+  tracked.lastSeenTime = Simulator::Now ();
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (Simulator::Now () - tracked.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 }
 
 
+void
+FlowMonitor::AddRxStats (FlowStats &stats, uint32_t packetSize, Time now)
+{
+  stats.rxBytes += packetSize;
+  stats.packetSizeHistogram.AddValue ((double) packetSize);
+  stats.rxPackets++;
+  if (stats.rxPackets == 1)
+    {
+      stats.timeFirstRxPacket = now;
+    }
+  else
+    {
+      // measure possible flow interruptions
+      Time interArrivalTime = now - stats.timeLastRxPacket;
+      if (interArrivalTime > m_flowInterruptionsMinTime)
+        {
+          stats.flowInterruptionsHistogram.AddValue (interArrivalTime.GetSeconds ());
+        }
+    }
+  stats.timeLastRxPacket = now;
+}
+
 void
 FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetId, uint32_t packetSize)
 {
@@ -194,16 +362,25 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     {
       return;
     }
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked == m_trackedPackets.end ())
+  MultithreadingCriticalSection cs (m_mutex);
+  Time now = Simulator::Now ();
+  if (packetId % m_packetSampling != 0)
+    {
+      // not tracked: only count the packet
+      AddRxStats (GetStatsForFlow (flowId), packetSize, now);
+      MarkFlowChanged (flowId);
+      return;
+    }
+  int32_t slot = FindTrackedPacket (flowId, packetId);
+  if (slot < 0)
     {
       NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
+  TrackedPacket &tracked = m_trackedPackets[slot].packet;
 
-  Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
+  Time delay = (now - tracked.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
   FlowStats &stats = GetStatsForFlow (flowId);
@@ -225,29 +402,14 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     }
   stats.lastDelay = delay;
 
-  stats.rxBytes += packetSize;
-  stats.packetSizeHistogram.AddValue ((double) packetSize);
-  stats.rxPackets++;
-  if (stats.rxPackets == 1)
-    {
-      stats.timeFirstRxPacket = now;
-    }
-  else
-    {
-      // measure possible flow interruptions
-      Time interArrivalTime = now - stats.timeLastRxPacket;
-      if (interArrivalTime > m_flowInterruptionsMinTime)
-        {
-          stats.flowInterruptionsHistogram.AddValue (interArrivalTime.GetSeconds ());
-        }
-    }
-  stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  AddRxStats (stats, packetSize, now);
+  stats.timesForwarded += tracked.timesForwarded;
+  MarkFlowChanged (flowId);
 
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  RemoveTrackedPacket (slot); // we don't need to track this packet anymore
 }
 
 void
@@ -258,8 +420,13 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
     {
       return;
     }
+  MultithreadingCriticalSection cs (m_mutex);
 
-  probe->AddPacketDropStats (flowId, packetSize, reasonCode);
+  bool sampled = (packetId % m_packetSampling == 0);
+  if (sampled)
+    {
+      probe->AddPacketDropStats (flowId, packetSize, reasonCode);
+    }
 
   FlowStats &stats = GetStatsForFlow (flowId);
   stats.lostPackets++;
@@ -271,15 +438,16 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
   ++stats.packetsDropped[reasonCode];
   stats.bytesDropped[reasonCode] += packetSize;
   NS_LOG_DEBUG ("++stats.packetsDropped[" << reasonCode<< "]; // becomes: " << stats.packetsDropped[reasonCode]);
+  MarkFlowChanged (flowId);
 
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked != m_trackedPackets.end ())
+  int32_t slot = sampled ? FindTrackedPacket (flowId, packetId) : -1;
+  if (slot >= 0)
     {
       // we don't need to track this packet anymore
       // FIXME: this will not necessarily be true with broadcast/multicast
       NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      RemoveTrackedPacket (slot);
     }
 }
 
@@ -293,24 +461,26 @@ FlowMonitor::GetFlowStats () const
 void
 FlowMonitor::CheckForLostPackets (Time maxDelay)
 {
+  MultithreadingCriticalSection cs (m_mutex);
   Time now = Simulator::Now ();
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  for (uint32_t i = 0; i < m_trackedPackets.size () && m_nTrackedPackets > 0; )
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
+      TrackedPacketSlot &slot = m_trackedPackets[i];
+      if (slot.used && now - slot.packet.lastSeenTime >= maxDelay)
         {
           // packet is considered lost, add it to the loss statistics
-          FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
+          NS_ASSERT (m_flowStats.find (slot.flowId) != m_flowStats.end ());
+          GetStatsForFlow (slot.flowId).lostPackets++;
+          MarkFlowChanged (slot.flowId);
 
-          // we won't track it anymore
-          m_trackedPackets.erase (iter++);
+          // we won't track it anymore; the slot may now hold a
+          // following packet, so check it again
+          RemoveTrackedPacket (i);
         }
       else
         {
-          iter++;
+          i++;
         }
     }
 }
@@ -328,6 +498,105 @@ FlowMonitor::PeriodicCheckForLostPackets ()
   Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
 }
 
+void
+FlowMonitor::MarkFlowChanged (FlowId flowId)
+{
+  if (m_exportInterval.IsZero ())
+    {
+      return;
+    }
+  if (flowId >= m_flowChanged.size ())
+    {
+      m_flowChanged.resize (flowId + 1, false);
+    }
+  if (!m_flowChanged[flowId])
+    {
+      m_flowChanged[flowId] = true;
+      m_changedFlows.push_back (flowId);
+    }
+}
+
+void
+FlowMonitor::EnableStreamingExport (std::string prefix, Time interval, bool binary)
+{
+  NS_LOG_FUNCTION (this << prefix << interval << binary);
+  NS_ABORT_MSG_UNLESS (interval.IsStrictlyPositive (), "The export interval must be positive");
+  MultithreadingCriticalSection cs (m_mutex);
+  if (binary)
+    {
+      const char *names[] = { "txBytes", "rxBytes", "txPackets", "rxPackets", "lostPackets",
+                              "timesForwarded", "delaySum", "jitterSum" };
+      m_exportSeries.clear ();
+      for (uint32_t i = 0; i < sizeof (names) / sizeof (names[0]); i++)
+        {
+          std::string filename = prefix + "-" + names[i] + ".nts";
+          Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (filename, std::ios::out | std::ios::binary);
+          m_exportSeries.push_back (Create<TimeSeriesWriter> (stream));
+        }
+      m_exportCsv = 0;
+    }
+  else
+    {
+      m_exportCsv = Create<OutputStreamWrapper> (prefix + ".csv", std::ios::out);
+      *m_exportCsv->GetStream () << "time,flowId,txBytes,rxBytes,txPackets,rxPackets,lostPackets,"
+                                 << "timesForwarded,delaySum,jitterSum\n";
+      m_exportSeries.clear ();
+    }
+  // the flows seen so far go to the first export
+  m_exportInterval = interval;
+  for (FlowStatsContainerCI i = m_flowStats.begin (); i != m_flowStats.end (); i++)
+    {
+      MarkFlowChanged (i->first);
+    }
+  Simulator::Cancel (m_exportEvent);
+  m_exportEvent = Simulator::Schedule (interval, &FlowMonitor::PeriodicExport, this);
+}
+
+void
+FlowMonitor::Export (void)
+{
+  MultithreadingCriticalSection cs (m_mutex);
+  Time now = Simulator::Now ();
+  std::sort (m_changedFlows.begin (), m_changedFlows.end ());
+  for (std::vector<FlowId>::const_iterator i = m_changedFlows.begin (); i != m_changedFlows.end (); i++)
+    {
+      m_flowChanged[*i] = false;
+      const FlowStats &stats = GetStatsForFlow (*i);
+      if (m_exportCsv != 0)
+        {
+          *m_exportCsv->GetStream () << now.GetSeconds () << "," << *i << ","
+                                     << stats.txBytes << "," << stats.rxBytes << ","
+                                     << stats.txPackets << "," << stats.rxPackets << ","
+                                     << stats.lostPackets << "," << stats.timesForwarded << ","
+                                     << stats.delaySum.GetSeconds () << ","
+                                     << stats.jitterSum.GetSeconds () << "\n";
+        }
+      if (!m_exportSeries.empty ())
+        {
+          m_exportSeries[0]->Write (now, stats.txBytes, *i);
+          m_exportSeries[1]->Write (now, stats.rxBytes, *i);
+          m_exportSeries[2]->Write (now, stats.txPackets, *i);
+          m_exportSeries[3]->Write (now, stats.rxPackets, *i);
+          m_exportSeries[4]->Write (now, stats.lostPackets, *i);
+          m_exportSeries[5]->Write (now, stats.timesForwarded, *i);
+          m_exportSeries[6]->Write (now, stats.delaySum.GetSeconds (), *i);
+          m_exportSeries[7]->Write (now, stats.jitterSum.GetSeconds (), *i);
+        }
+    }
+  m_changedFlows.clear ();
+  if (m_exportCsv != 0)
+    {
+      m_exportCsv->GetStream ()->flush ();
+    }
+}
+
+void
+FlowMonitor::PeriodicExport (void)
+{
+  Export ();
+  m_exportEvent = Simulator::Schedule (m_exportInterval, &FlowMonitor::PeriodicExport, this);
+}
+
 void
 FlowMonitor::NotifyConstructionCompleted ()
 {
@@ -31,6 +31,9 @@
 #include "ns3/histogram.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/multithreading.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/time-series-file.h"
 
 namespace ns3 {
 
@@ -46,6 +49,15 @@ namespace ns3 {
  * The FlowMonitor class is responsible for coordinating efforts
  * regarding probes, and collects end-to-end flow statistics.
  *
+ * The packets in flight are tracked in a hash table.  To bound its size
+ * in large simulations, the PacketSampling attribute tracks only one
+ * packet out of N of each flow: the packet and byte counts of the flows
+ * still cover all the packets, but the delays, the jitters, the times
+ * forwarded, the packets found lost by CheckForLostPackets and the
+ * statistics of the probes only cover the tracked packets.
+ *
+ * The statistics can also be streamed to a file while the simulation
+ * runs, see EnableStreamingExport.
  */
 class FlowMonitor : public Object
 {
@@ -256,6 +268,21 @@ public:
   /// \param enableProbes if true, include also the per-probe/flow pair statistics in the output
   void SerializeToXmlFile (std::string fileName, bool enableHistograms, bool enableProbes);
 
+  /// Writes the statistics of the flows to files every interval, from
+  /// now on until the monitor is disposed of.  Each record holds the
+  /// cumulated statistics of a flow which changed during the interval.
+  ///
+  /// In text mode, the records are the lines of the CSV file
+  /// prefix.csv: time, flowId, txBytes, rxBytes, txPackets, rxPackets,
+  /// lostPackets, timesForwarded, delaySum and jitterSum, the times
+  /// being in seconds.  In binary mode, each statistic goes to the time
+  /// series file prefix-<statistic>.nts, with the flow identifier as
+  /// context (see TimeSeriesWriter).
+  /// \param prefix the prefix of the names of the files
+  /// \param interval the time between two exports
+  /// \param binary write time series files instead of a CSV file
+  void EnableStreamingExport (std::string prefix, Time interval, bool binary = false);
+
 
 protected:
 
@@ -272,12 +299,25 @@ private:
     uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
   };
 
+  /// A slot of the table of the tracked packets
+  struct TrackedPacketSlot
+  {
+    FlowId flowId;         //!< the flow of the packet
+    FlowPacketId packetId; //!< the packet
+    bool used;             //!< the slot holds a packet
+    TrackedPacket packet;  //!< the tracked packet data
+  };
+
   /// FlowId --> FlowStats
   FlowStatsContainer m_flowStats;
-
-  /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
-  TrackedPacketMap m_trackedPackets; //!< Tracked packets
+  /// FlowId --> FlowStats in m_flowStats, or 0
+  std::vector<FlowStats *> m_flowStatsIndex;
+
+  /// (FlowId,PacketId) --> TrackedPacket, as an open addressing hash
+  /// table with linear probing, whose size is a power of two
+  std::vector<TrackedPacketSlot> m_trackedPackets;
+  uint32_t m_nTrackedPackets; //!< Number of tracked packets
+  uint32_t m_packetSampling; //!< Track one packet out of m_packetSampling
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
 
@@ -292,12 +332,56 @@ private:
   double m_packetSizeBinWidth;  //!< packet size bin width (for histograms)
   double m_flowInterruptionsBinWidth; //!< Flow interruptions bin width (for histograms)
   Time m_flowInterruptionsMinTime; //!< Flow interruptions minimum time
-
+  MultithreadingMutex m_mutex; //!< Serializes the reports of a multithreaded simulation
+
+  Time m_exportInterval; //!< Time between two streaming exports
+  EventId m_exportEvent; //!< Next streaming export
+  Ptr<OutputStreamWrapper> m_exportCsv; //!< CSV file of the streaming export
+  std::vector<Ptr<TimeSeriesWriter> > m_exportSeries; //!< Binary files of the streaming export, by statistic
+  std::vector<FlowId> m_changedFlows; //!< The flows changed since the last export
+  std::vector<bool> m_flowChanged; //!< FlowId --> in m_changedFlows
   /// Get the stats for a given flow
   /// \param flowId the Flow identification
   /// \returns the stats of the flow
   FlowStats& GetStatsForFlow (FlowId flowId);
 
+  /// Count a received packet in the stats of its flow, whether it is
+  /// tracked or not
+  /// \param stats the stats of the flow
+  /// \param packetSize packet size
+  /// \param now the time of the reception
+  void AddRxStats (FlowStats &stats, uint32_t packetSize, Time now);
+
+  /// Find a tracked packet
+  /// \param flowId the Flow identification
+  /// \param packetId the Packet identification
+  /// \returns the slot of the packet in m_trackedPackets, or -1
+  int32_t FindTrackedPacket (FlowId flowId, FlowPacketId packetId) const;
+
+  /// Start tracking a packet, or restart if it is already tracked
+  /// \param flowId the Flow identification
+  /// \param packetId the Packet identification
+  /// \returns the tracked packet data
+  TrackedPacket& AddTrackedPacket (FlowId flowId, FlowPacketId packetId);
+
+  /// Stop tracking a packet
+  /// \param slot the slot of the packet in m_trackedPackets
+  void RemoveTrackedPacket (uint32_t slot);
+
+  /// Resize the table of the tracked packets
+  /// \param size the new number of slots, a power of two
+  void ResizeTrackedPackets (uint32_t size);
+
+  /// Note that the statistics of a flow changed, for the streaming export
+  /// \param flowId the Flow identification
+  void MarkFlowChanged (FlowId flowId);
+
+  /// Write the statistics of the flows changed since the last export
+  void Export (void);
+
+  /// Periodic function to export the statistics of the flows
+  void PeriodicExport (void);
+
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
 };
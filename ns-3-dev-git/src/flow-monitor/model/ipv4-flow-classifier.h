@@ -23,6 +23,7 @@
 
 #include <stdint.h>
 #include <map>
+#include <vector>
 
 #include "ns3/ipv4-header.h"
 #include "ns3/flow-classifier.h"
@@ -73,10 +74,25 @@ public:
 
 private:
 
-  /// Map to Flows Identifiers to FlowIds
-  std::map<FiveTuple, FlowId> m_flowMap;
-  /// Map to FlowIds to FlowPacketId
-  std::map<FlowId, FlowPacketId> m_flowPktIdMap;
+  /// A classified flow
+  struct Flow
+  {
+    FiveTuple tuple;           //!< the tuple of the flow
+    FlowId flowId;             //!< the identifier of the flow
+    FlowPacketId lastPacketId; //!< the identifier of the last packet of the flow
+  };
+
+  /// Find the flow of a tuple, or add it
+  /// \param tuple the tuple
+  /// \returns the flow of the tuple
+  Flow& FindOrAddFlow (const FiveTuple &tuple);
+
+  /// The flows, by order of classification
+  std::vector<Flow> m_flows;
+  /// Open addressing hash table, with linear probing, of the flows: each
+  /// slot holds an index in m_flows plus one, or zero if it is empty.
+  /// Its size is a power of two.
+  std::vector<uint32_t> m_flowSlots;
 
 };
 
@@ -19,6 +19,7 @@
 // Modifications: Tommaso Pecorella <tommaso.pecorella@unifi.it>
 //
 
+#include <algorithm>
 #include "ns3/packet.h"
 
 #include "ipv6-flow-classifier.h"
@@ -147,38 +148,91 @@ Ipv6FlowClassifier::Classify (const Ipv6Header &ipHeader, Ptr<const Packet> ipPa
   tuple.sourcePort = srcPort;
   tuple.destinationPort = dstPort;
 
-  // try to insert the tuple, but check if it already exists
-  std::pair<std::map<FiveTuple, FlowId>::iterator, bool> insert
-    = m_flowMap.insert (std::pair<FiveTuple, FlowId> (tuple, 0));
+  MultithreadingCriticalSection cs (m_mutex);
+  Flow &flow = FindOrAddFlow (tuple);
+  *out_flowId = flow.flowId;
+  *out_packetId = flow.lastPacketId;
 
-  // if the insertion succeeded, we need to assign this tuple a new flow identifier
-  if (insert.second)
+  return true;
+}
+
+/**
+ * \brief Hash of a FiveTuple
+ * \param tuple the tuple
+ * \returns the hash value
+ */
+static uint32_t
+HashFiveTuple (const Ipv6FlowClassifier::FiveTuple &tuple)
+{
+  uint32_t h = Ipv6AddressHash () (tuple.sourceAddress);
+  h = h * 0x9e3779b1U ^ Ipv6AddressHash () (tuple.destinationAddress);
+  h = h * 0x9e3779b1U ^ ((uint32_t) tuple.sourcePort << 16 | tuple.destinationPort);
+  h = h * 0x9e3779b1U ^ tuple.protocol;
+  return h ^ (h >> 16);
+}
+
+Ipv6FlowClassifier::Flow&
+Ipv6FlowClassifier::FindOrAddFlow (const FiveTuple &tuple)
+{
+  uint32_t hash = HashFiveTuple (tuple);
+  if (!m_flowSlots.empty ())
     {
-      FlowId newFlowId = GetNewFlowId ();
-      insert.first->second = newFlowId;
-      m_flowPktIdMap[newFlowId] = 0;
+      uint32_t mask = m_flowSlots.size () - 1;
+      for (uint32_t i = hash & mask; m_flowSlots[i] != 0; i = (i + 1) & mask)
+        {
+          Flow &flow = m_flows[m_flowSlots[i] - 1];
+          if (flow.tuple == tuple)
+            {
+              flow.lastPacketId++;
+              return flow;
+            }
+        }
     }
-  else
+
+  // a new tuple: assign it a new flow identifier
+  if (2 * (m_flows.size () + 1) > m_flowSlots.size ())
     {
-      m_flowPktIdMap[insert.first->second] ++;
+      m_flowSlots.assign (std::max<uint32_t> (64, 2 * m_flowSlots.size ()), 0);
+      uint32_t mask = m_flowSlots.size () - 1;
+      for (uint32_t f = 0; f < m_flows.size (); f++)
+        {
+          uint32_t i = HashFiveTuple (m_flows[f].tuple) & mask;
+          while (m_flowSlots[i] != 0)
+            {
+              i = (i + 1) & mask;
+            }
+          m_flowSlots[i] = f + 1;
+        }
     }
-
-  *out_flowId = insert.first->second;
-  *out_packetId = m_flowPktIdMap[*out_flowId];
-
-  return true;
+  uint32_t mask = m_flowSlots.size () - 1;
+  uint32_t i = hash & mask;
+  while (m_flowSlots[i] != 0)
+    {
+      i = (i + 1) & mask;
+    }
+  Flow flow;
+  flow.tuple = tuple;
+  flow.flowId = GetNewFlowId ();
+  flow.lastPacketId = 0;
+  m_flows.push_back (flow);
+  m_flowSlots[i] = m_flows.size ();
+  return m_flows.back ();
 }
 
 
 Ipv6FlowClassifier::FiveTuple
 Ipv6FlowClassifier::FindFlow (FlowId flowId) const
 {
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  // the identifiers are usually given in sequence
+  if (flowId > 0 && flowId <= m_flows.size () && m_flows[flowId - 1].flowId == flowId)
     {
-      if (iter->second == flowId)
+      return m_flows[flowId - 1].tuple;
+    }
+  for (std::vector<Flow>::const_iterator iter = m_flows.begin (); iter != m_flows.end (); iter++)
+    {
+      if (iter->flowId == flowId)
         {
-          return iter->first;
+          return iter->tuple;
         }
     }
   NS_FATAL_ERROR ("Could not find the flow with ID " << flowId);
@@ -193,9 +247,16 @@ Ipv6FlowClassifier::SerializeToXmlStream (std::ostream &os, int indent) const
 
   INDENT (indent); os << "<Ipv6FlowClassifier>\n";
 
+  // list the flows by tuple
+  std::map<FiveTuple, FlowId> flowMap;
+  for (std::vector<Flow>::const_iterator iter = m_flows.begin (); iter != m_flows.end (); iter++)
+    {
+      flowMap[iter->tuple] = iter->flowId;
+    }
+
   indent += 2;
   for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+       iter = flowMap.begin (); iter != flowMap.end (); iter++)
     {
       INDENT (indent);
       os << "<Flow flowId=\"" << iter->second << "\""
@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+/**
+ * A probe reporting the packets given by the test cases.
+ */
+class TestFlowProbe : public FlowProbe
+{
+public:
+  /**
+   * \param monitor the monitor of the probe
+   */
+  TestFlowProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+/**
+ * Ipv4FlowClassifier test: the flows and packets keep their identifiers
+ * while the table of the flows grows.
+ */
+class Ipv4FlowClassifierTestCase : public TestCase
+{
+public:
+  Ipv4FlowClassifierTestCase ();
+private:
+  virtual void DoRun (void);
+  /**
+   * Classify a packet of a flow
+   * \param classifier the classifier
+   * \param flow the index of the flow
+   * \param flowId [out] the identifier of the flow
+   * \param packetId [out] the identifier of the packet
+   * \returns true if the packet was classified
+   */
+  bool Classify (Ipv4FlowClassifier &classifier, uint32_t flow, uint32_t *flowId, uint32_t *packetId);
+};
+
+Ipv4FlowClassifierTestCase::Ipv4FlowClassifierTestCase ()
+  : TestCase ("Ipv4FlowClassifier identifiers")
+{
+}
+
+bool
+Ipv4FlowClassifierTestCase::Classify (Ipv4FlowClassifier &classifier, uint32_t flow,
+                                      uint32_t *flowId, uint32_t *packetId)
+{
+  Ipv4Header header;
+  header.SetSource (Ipv4Address (0x0a000001 + flow / 8));
+  header.SetDestination (Ipv4Address ("10.1.0.1"));
+  header.SetProtocol (flow % 2 ? 6 : 17);
+  uint8_t ports[4] = { 0x10, 0, 0, (uint8_t) (flow % 8) };
+  Ptr<Packet> payload = Create<Packet> (ports, 4);
+  return classifier.Classify (header, payload, flowId, packetId);
+}
+
+void
+Ipv4FlowClassifierTestCase::DoRun (void)
+{
+  Ipv4FlowClassifier classifier;
+  const uint32_t nFlows = 300;
+  for (uint32_t round = 0; round < 3; round++)
+    {
+      for (uint32_t flow = 0; flow < nFlows; flow++)
+        {
+          uint32_t flowId = 0;
+          uint32_t packetId = 0;
+          bool classified = Classify (classifier, flow, &flowId, &packetId);
+          NS_TEST_ASSERT_MSG_EQ (classified, true, "Packet not classified");
+          NS_TEST_ASSERT_MSG_EQ (flowId, flow + 1, "Wrong flow identifier");
+          NS_TEST_ASSERT_MSG_EQ (packetId, round, "Wrong packet identifier");
+        }
+    }
+  for (uint32_t flow = 0; flow < nFlows; flow++)
+    {
+      Ipv4FlowClassifier::FiveTuple tuple = classifier.FindFlow (flow + 1);
+      NS_TEST_ASSERT_MSG_EQ (tuple.sourceAddress, Ipv4Address (0x0a000001 + flow / 8), "Wrong source of flow " << flow + 1);
+      NS_TEST_ASSERT_MSG_EQ (tuple.destinationPort, flow % 8, "Wrong port of flow " << flow + 1);
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) tuple.protocol, (flow % 2 ? 6U : 17U), "Wrong protocol of flow " << flow + 1);
+    }
+}
+
+/**
+ * FlowMonitor test: the tracked packets give the delays and losses of
+ * the flows, and the sampling keeps the counts of the packets.
+ */
+class FlowMonitorTrackingTestCase : public TestCase
+{
+public:
+  /**
+   * \param sampling the PacketSampling of the monitor
+   */
+  FlowMonitorTrackingTestCase (uint32_t sampling);
+private:
+  virtual void DoRun (void);
+  uint32_t m_sampling; //!< the PacketSampling of the monitor
+};
+
+/**
+ * \param sampling the PacketSampling of the monitor
+ * \returns the name of the test case
+ */
+static std::string
+TrackingTestCaseName (uint32_t sampling)
+{
+  std::ostringstream oss;
+  oss << "FlowMonitor tracked packets, sampling " << sampling;
+  return oss.str ();
+}
+
+FlowMonitorTrackingTestCase::FlowMonitorTrackingTestCase (uint32_t sampling)
+  : TestCase (TrackingTestCaseName (sampling)),
+    m_sampling (sampling)
+{
+}
+
+void
+FlowMonitorTrackingTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  monitor->SetAttribute ("PacketSampling", UintegerValue (m_sampling));
+  monitor->SetAttribute ("MaxPerHopDelay", TimeValue (Seconds (5)));
+  Ptr<FlowProbe> probe = Create<TestFlowProbe> (monitor);
+  monitor->StartRightNow ();
+
+  // send 100 packets on each of 10 flows, receive the even ones after
+  // flowId milliseconds, drop one, lose the others
+  const uint32_t nFlows = 10;
+  const uint32_t nPackets = 100;
+  for (uint32_t flowId = 1; flowId <= nFlows; flowId++)
+    {
+      for (uint32_t packetId = 0; packetId < nPackets; packetId++)
+        {
+          monitor->ReportFirstTx (probe, flowId, packetId, 100);
+        }
+    }
+  for (uint32_t flowId = 1; flowId <= nFlows; flowId++)
+    {
+      Simulator::Schedule (MilliSeconds (flowId), &FlowMonitor::ReportDrop, monitor,
+                           probe, flowId, 1, 100, 0);
+      for (uint32_t packetId = 0; packetId < nPackets; packetId += 2)
+        {
+          Simulator::Schedule (MilliSeconds (flowId), &FlowMonitor::ReportForwarding, monitor,
+                               probe, flowId, packetId, 100);
+          Simulator::Schedule (MilliSeconds (flowId), &FlowMonitor::ReportLastRx, monitor,
+                               probe, flowId, packetId, 100);
+        }
+    }
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  // the odd packets are still in flight
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), nFlows, "Wrong number of flows");
+  uint32_t sampled = 0;
+  for (uint32_t packetId = 0; packetId < nPackets; packetId += 2)
+    {
+      sampled += (packetId % m_sampling == 0);
+    }
+  for (uint32_t flowId = 1; flowId <= nFlows; flowId++)
+    {
+      FlowMonitor::FlowStats s = stats.find (flowId)->second;
+      NS_TEST_ASSERT_MSG_EQ (s.txPackets, nPackets, "Wrong txPackets of flow " << flowId);
+      NS_TEST_ASSERT_MSG_EQ (s.rxPackets, nPackets / 2, "Wrong rxPackets of flow " << flowId);
+      NS_TEST_ASSERT_MSG_EQ (s.rxBytes, 100 * nPackets / 2, "Wrong rxBytes of flow " << flowId);
+      NS_TEST_ASSERT_MSG_EQ (s.lostPackets, 1, "Wrong lostPackets of flow " << flowId);
+      NS_TEST_ASSERT_MSG_EQ (s.timesForwarded, sampled, "Wrong timesForwarded of flow " << flowId);
+      NS_TEST_ASSERT_MSG_EQ (s.delaySum, MilliSeconds (flowId * sampled), "Wrong delaySum of flow " << flowId);
+    }
+
+  // then they are lost
+  Simulator::Stop (Seconds (8));
+  Simulator::Run ();
+  for (uint32_t flowId = 1; flowId <= nFlows; flowId++)
+    {
+      FlowMonitor::FlowStats s = stats.find (flowId)->second;
+      uint32_t lost = 1;
+      for (uint32_t packetId = 3; packetId < nPackets; packetId += 2)
+        {
+          lost += (packetId % m_sampling == 0);
+        }
+      NS_TEST_ASSERT_MSG_EQ (s.lostPackets, lost, "Wrong lostPackets of flow " << flowId);
+    }
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * FlowMonitor test: the streaming export writes the changed flows at each
+ * interval.
+ */
+class FlowMonitorExportTestCase : public TestCase
+{
+public:
+  FlowMonitorExportTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+FlowMonitorExportTestCase::FlowMonitorExportTestCase ()
+  : TestCase ("FlowMonitor streaming export")
+{
+}
+
+void
+FlowMonitorExportTestCase::DoRun (void)
+{
+  std::string prefix = CreateTempDirFilename ("flow-monitor-export");
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  Ptr<FlowProbe> probe = Create<TestFlowProbe> (monitor);
+  monitor->StartRightNow ();
+  monitor->EnableStreamingExport (prefix, Seconds (1));
+
+  // flow 1 sends during the first second, flow 2 during the second one
+  Simulator::Schedule (MilliSeconds (500), &FlowMonitor::ReportFirstTx, monitor, probe, 1, 0, 100);
+  Simulator::Schedule (MilliSeconds (600), &FlowMonitor::ReportLastRx, monitor, probe, 1, 0, 100);
+  Simulator::Schedule (MilliSeconds (1500), &FlowMonitor::ReportFirstTx, monitor, probe, 2, 0, 200);
+  Simulator::Stop (MilliSeconds (2500));
+  Simulator::Run ();
+  monitor->Dispose ();
+  Simulator::Destroy ();
+
+  std::ifstream file ((prefix + ".csv").c_str ());
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline (file, line))
+    {
+      lines.push_back (line);
+    }
+  NS_TEST_ASSERT_MSG_EQ (lines.size (), 3, "Wrong number of lines");
+  NS_TEST_EXPECT_MSG_EQ (lines[0], "time,flowId,txBytes,rxBytes,txPackets,rxPackets,lostPackets,timesForwarded,delaySum,jitterSum",
+                         "Wrong header");
+  NS_TEST_EXPECT_MSG_EQ (lines[1], "1,1,100,100,1,1,0,0,0.1,0", "Wrong record of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (lines[2], "2,2,200,0,1,0,0,0,0,0", "Wrong record of flow 2");
+}
+
+/**
+ * FlowMonitor TestSuite
+ */
+class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ();
+};
+
+FlowMonitorTestSuite::FlowMonitorTestSuite ()
+  : TestSuite ("flow-monitor", UNIT)
+{
+  AddTestCase (new Ipv4FlowClassifierTestCase (), TestCase::QUICK);
+  AddTestCase (new FlowMonitorTrackingTestCase (1), TestCase::QUICK);
+  AddTestCase (new FlowMonitorTrackingTestCase (4), TestCase::QUICK);
+  AddTestCase (new FlowMonitorExportTestCase (), TestCase::QUICK);
+}
+
+static FlowMonitorTestSuite g_flowMonitorTestSuite;
@@ -164,6 +164,7 @@
 #include "ns3/node-list.h"
 #include "ns3/core-config.h"
 #include "ns3/arp-l3-protocol.h"
+#include "ns3/traffic-control-layer.h"
 #include "internet-stack-helper.h"
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/ipv4-list-routing-helper.h"
@@ -422,6 +423,14 @@ InternetStackHelper::CreateAndAggregateObjectFromTypeId (Ptr<Node> node, const s
 void
 InternetStackHelper::Install (Ptr<Node> node) const
 {
+  if ((m_ipv4Enabled || m_ipv6Enabled) && node->GetObject<TrafficControlLayer> () == 0)
+    {
+      // the interfaces send through the traffic control layer, which
+      // passes the packets straight to the devices until a root queue
+      // disc is installed on them
+      CreateAndAggregateObjectFromTypeId (node, "ns3::TrafficControlLayer");
+    }
+
   if (m_ipv4Enabled)
     {
       if (node->GetObject<Ipv4> () != 0)
@@ -719,7 +728,7 @@ Ipv4L3ProtocolDropSinkWithoutContext (
 
   Ptr<Packet> p = packet->Copy ();
   p->AddHeader (header);
-  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << *p << std::endl;
+  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << *p << "\n";
 }
 
 /**
@@ -743,7 +752,7 @@ Ipv4L3ProtocolTxSinkWithoutContext (
       return;
     }
 
-  *stream->GetStream () << "t " << Simulator::Now ().GetSeconds () << " " << *packet << std::endl;
+  *stream->GetStream () << "t " << Simulator::Now ().GetSeconds () << " " << *packet << "\n";
 }
 
 /**
@@ -767,7 +776,7 @@ Ipv4L3ProtocolRxSinkWithoutContext (
       return;
     }
 
-  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << *packet << std::endl;
+  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << *packet << "\n";
 }
 
 /**
@@ -807,9 +816,9 @@ Ipv4L3ProtocolDropSinkWithContext (
   p->AddHeader (header);
 #ifdef INTERFACE_CONTEXT
   *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << context << "(" << interface << ") " 
-                        << *p << std::endl;
+                        << *p << "\n";
 #else
-  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << context << " "  << *p << std::endl;
+  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << context << " "  << *p << "\n";
 #endif
 }
 
@@ -838,9 +847,9 @@ Ipv4L3ProtocolTxSinkWithContext (
 
 #ifdef INTERFACE_CONTEXT
   *stream->GetStream () << "t " << Simulator::Now ().GetSeconds () << " " << context << "(" << interface << ") " 
-                        << *packet << std::endl;
+                        << *packet << "\n";
 #else
-  *stream->GetStream () << "t " << Simulator::Now ().GetSeconds () << " " << context << " "  << *packet << std::endl;
+  *stream->GetStream () << "t " << Simulator::Now ().GetSeconds () << " " << context << " "  << *packet << "\n";
 #endif
 }
 
@@ -869,9 +878,9 @@ Ipv4L3ProtocolRxSinkWithContext (
 
 #ifdef INTERFACE_CONTEXT
   *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << "(" << interface << ") " 
-                        << *packet << std::endl;
+                        << *packet << "\n";
 #else
-  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << " "  << *packet << std::endl;
+  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << " "  << *packet << "\n";
 #endif
 }
 
@@ -1057,7 +1066,7 @@ Ipv6L3ProtocolDropSinkWithoutContext (
 
   Ptr<Packet> p = packet->Copy ();
   p->AddHeader (header);
-  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << *p << std::endl;
+  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << *p << "\n";
 }
 
 /**
@@ -1081,7 +1090,7 @@ Ipv6L3ProtocolTxSinkWithoutContext (
       return;
     }
 
-  *stream->GetStream () << "t " << Simulator::Now ().GetSeconds () << " " << *packet << std::endl;
+  *stream->GetStream () << "t " << Simulator::Now ().GetSeconds () << " " << *packet << "\n";
 }
 
 /**
@@ -1105,7 +1114,7 @@ Ipv6L3ProtocolRxSinkWithoutContext (
       return;
     }
 
-  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << *packet << std::endl;
+  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << *packet << "\n";
 }
 
 /**
@@ -1145,9 +1154,9 @@ Ipv6L3ProtocolDropSinkWithContext (
   p->AddHeader (header);
 #ifdef INTERFACE_CONTEXT
   *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << context << "(" << interface << ") " 
-                        << *p << std::endl;
+                        << *p << "\n";
 #else
-  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << std::endl;
+  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << "\n";
 #endif
 }
 
@@ -1176,9 +1185,9 @@ Ipv6L3ProtocolTxSinkWithContext (
 
 #ifdef INTERFACE_CONTEXT
   *stream->GetStream () << "t " << Simulator::Now ().GetSeconds () << " " << context << "(" << interface << ") " 
-                        << *packet << std::endl;
+                        << *packet << "\n";
 #else
-  *stream->GetStream () << "t " << Simulator::Now ().GetSeconds () << " " << context << " " << *packet << std::endl;
+  *stream->GetStream () << "t " << Simulator::Now ().GetSeconds () << " " << context << " " << *packet << "\n";
 #endif
 }
 
@@ -1207,9 +1216,9 @@ Ipv6L3ProtocolRxSinkWithContext (
 
 #ifdef INTERFACE_CONTEXT
   *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << "(" << interface << ") " 
-                        << *packet << std::endl;
+                        << *packet << "\n";
 #else
-  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << " " << *packet << std::endl;
+  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << " " << *packet << "\n";
 #endif
 }
 
@@ -80,6 +80,10 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * Only the nodes whose shortest path tree reaches a link state which
+   * changed since the previous computation get new routes; the routes of
+   * the other nodes would be the same.
+   *
    */
   static void RecomputeRoutingTables (void);
 private:
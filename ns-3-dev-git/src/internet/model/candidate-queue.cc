@@ -27,6 +27,8 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("CandidateQueue");
 
+const uint32_t CandidateQueue::NOT_QUEUED;
+
 /**
  * \brief Stream insertion operator.
  *
@@ -50,23 +52,24 @@ std::ostream&
 operator<< (std::ostream& os, const CandidateQueue& q)
 {
   typedef CandidateQueue::CandidateList_t List_t;
-  typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  List_t list = q.m_candidates;
+  std::sort (list.begin (), list.end (), &CandidateQueue::CompareCandidate);
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
-  for (CIter_t iter = list.begin (); iter != list.end (); iter++)
+  for (List_t::const_iterator iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->vertex->GetVertexId () << ", "
+      << iter->vertex->GetDistanceFromRoot () << ", "
+      << iter->vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_order (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -94,11 +97,20 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  Candidate c;
+  c.vertex = vNew;
+  c.order = m_order++;
+  m_candidates.push_back (c);
+  uint32_t index = vNew->GetVertexIndex ();
+  if (index != GlobalRouteManagerLSDB::NO_INDEX)
+    {
+      NS_ASSERT_MSG (Find (index) == 0, "CandidateQueue::Push (): vertex index already in the queue");
+      if (index >= m_positions.size ())
+        {
+          m_positions.resize (index + 1, NOT_QUEUED);
+        }
+    }
+  SiftUp (m_candidates.size () - 1);
 }
 
 SPFVertex *
@@ -110,8 +122,18 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_candidates.front ().vertex;
+  if (v->GetVertexIndex () != GlobalRouteManagerLSDB::NO_INDEX)
+    {
+      m_positions[v->GetVertexIndex ()] = NOT_QUEUED;
+    }
+  Candidate last = m_candidates.back ();
+  m_candidates.pop_back ();
+  if (!m_candidates.empty ())
+    {
+      Place (0, last);
+      SiftDown (0);
+    }
   return v;
 }
 
@@ -124,7 +146,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.front ().vertex;
 }
 
 bool
@@ -142,21 +164,14 @@ CandidateQueue::Size (void) const
 }
 
 SPFVertex *
-CandidateQueue::Find (const Ipv4Address addr) const
+CandidateQueue::Find (uint32_t index) const
 {
-  NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  NS_LOG_FUNCTION (this << index);
+  if (index >= m_positions.size () || m_positions[index] == NOT_QUEUED)
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
-        {
-          return v;
-        }
+      return 0;
     }
-
-  return 0;
+  return m_candidates[m_positions[index]].vertex;
 }
 
 void
@@ -164,11 +179,93 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  for (uint32_t i = m_candidates.size () / 2; i > 0; i--)
+    {
+      SiftDown (i - 1);
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::DecreaseKey (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  NS_ASSERT_MSG (Find (v->GetVertexIndex ()) == v, "CandidateQueue::DecreaseKey (): vertex not in the queue");
+  uint32_t position = m_positions[v->GetVertexIndex ()];
+  m_candidates[position].order = m_order++;
+  SiftUp (position);
+}
+
+void
+CandidateQueue::Place (uint32_t i, const Candidate &c)
+{
+  m_candidates[i] = c;
+  uint32_t index = c.vertex->GetVertexIndex ();
+  if (index != GlobalRouteManagerLSDB::NO_INDEX)
+    {
+      m_positions[index] = i;
+    }
+}
+
+void
+CandidateQueue::SiftUp (uint32_t i)
+{
+  Candidate c = m_candidates[i];
+  while (i > 0)
+    {
+      uint32_t parent = (i - 1) / 2;
+      if (!CompareCandidate (c, m_candidates[parent]))
+        {
+          break;
+        }
+      Place (i, m_candidates[parent]);
+      i = parent;
+    }
+  Place (i, c);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t i)
+{
+  Candidate c = m_candidates[i];
+  uint32_t n = m_candidates.size ();
+  for (;;)
+    {
+      uint32_t child = 2 * i + 1;
+      if (child >= n)
+        {
+          break;
+        }
+      if (child + 1 < n && CompareCandidate (m_candidates[child + 1], m_candidates[child]))
+        {
+          child++;
+        }
+      if (!CompareCandidate (m_candidates[child], c))
+        {
+          break;
+        }
+      Place (i, m_candidates[child]);
+      i = child;
+    }
+  Place (i, c);
+}
+
+bool
+CandidateQueue::CompareCandidate (const Candidate &c1, const Candidate &c2)
+{
+  if (CompareSPFVertex (c1.vertex, c2.vertex))
+    {
+      return true;
+    }
+  if (CompareSPFVertex (c2.vertex, c1.vertex))
+    {
+      return false;
+    }
+  return c1.order < c2.order;
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
@@ -22,7 +22,7 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -45,6 +45,13 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The queue is an indexed binary heap, so that Push (), Pop () and
+ * DecreaseKey () cost a logarithmic time.  The vertices of equal priority
+ * are popped in the order they were pushed or their distance decreased.
+ * The positions in the heap are kept in an array by vertex index, so the
+ * queue holds at most one vertex of each index, and the vertices without
+ * an index can be neither found nor decreased.
  */
 class CandidateQueue
 {
@@ -129,13 +136,14 @@ public:
 
 /**
  * @brief Searches the Candidate Queue for a Shortest Path First Vertex 
- * pointer that points to a vertex having the given IP address.
+ * pointer that points to a vertex having the given index.
  *
- * @see SPFVertex
- * @param addr The IP address to search for.
- * @returns The SPFVertex* pointer corresponding to the given IP address.
+ * @see SPFVertex::GetVertexIndex ()
+ * @param index The vertex index to search for.
+ * @returns The SPFVertex* pointer corresponding to the given index, or 0
+ * if there is none in the queue.
  */
-  SPFVertex* Find (const Ipv4Address addr) const;
+  SPFVertex* Find (uint32_t index) const;
 
 /**
  * @brief Reorders the Candidate Queue according to the priority scheme.
@@ -152,6 +160,19 @@ public:
  */
   void Reorder (void);
 
+/**
+ * @brief Restores the priority order after the m_distanceFromRoot of a
+ * vertex of the queue has been lowered.
+ *
+ * This is the cheap version of Reorder (), when a single vertex has been
+ * given a shorter path.  Among the vertices of equal priority, the vertex
+ * is then popped last, as if it had been pushed again.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex whose distance was lowered.
+ */
+  void DecreaseKey (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -182,8 +203,50 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
-  CandidateList_t m_candidates;  //!< SPFVertex candidates
+/**
+ * \brief A vertex of the heap.
+ */
+  struct Candidate
+  {
+    SPFVertex *vertex; //!< The vertex
+    uint64_t order;    //!< When the vertex was pushed or decreased
+  };
+
+/**
+ * \brief return true if c1 should be popped before c2
+ *
+ * \param c1 first operand
+ * \param c2 second operand
+ * \return True if c1 should be popped before c2; false otherwise
+ */
+  static bool CompareCandidate (const Candidate &c1, const Candidate &c2);
+
+/**
+ * \brief Put a candidate at a position of the heap and index it.
+ * \param i the position
+ * \param c the candidate
+ */
+  void Place (uint32_t i, const Candidate &c);
+
+/**
+ * \brief Move a candidate towards the top of the heap.
+ * \param i the position of the candidate
+ */
+  void SiftUp (uint32_t i);
+
+/**
+ * \brief Move a candidate towards the bottom of the heap.
+ * \param i the position of the candidate
+ */
+  void SiftDown (uint32_t i);
+
+  static const uint32_t NOT_QUEUED = 0xffffffff; //!< The position of the indices without a candidate
+
+  typedef std::vector<Candidate> CandidateList_t; //!< container of the heap
+  CandidateList_t m_candidates;  //!< SPFVertex candidates, as a binary heap
+  /// The position in the heap of the candidate of each vertex index
+  std::vector<uint32_t> m_positions;
+  uint64_t m_order; //!< The number of pushes and decreases
 
   /**
    * \brief Stream insertion operator.
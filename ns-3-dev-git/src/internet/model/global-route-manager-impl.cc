@@ -27,9 +27,16 @@
 #include <queue>
 #include <algorithm>
 #include <iostream>
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include <unistd.h>
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
 #include "ns3/node-list.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
@@ -44,6 +51,17 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+/**
+ * \ingroup globalrouting
+ * The number of threads computing the routes of the global routers.
+ */
+static GlobalValue g_globalRoutingThreads = GlobalValue
+  ("GlobalRoutingThreads",
+   "The number of threads computing the routes of the global routers; "
+   "zero for one per processor",
+   UintegerValue (0),
+   MakeUintegerChecker<uint32_t> ());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -88,6 +106,7 @@ operator<< (std::ostream& os, const SPFVertex::ListOfSPFVertex_t& vs)
 SPFVertex::SPFVertex () : 
   m_vertexType (VertexUnknown), 
   m_vertexId ("255.255.255.255"), 
+  m_vertexIndex (GlobalRouteManagerLSDB::NO_INDEX),
   m_lsa (0),
   m_distanceFromRoot (SPF_INFINITY), 
   m_rootOif (SPF_INFINITY),
@@ -101,6 +120,7 @@ SPFVertex::SPFVertex () :
 
 SPFVertex::SPFVertex (GlobalRoutingLSA* lsa) : 
   m_vertexId (lsa->GetLinkStateId ()),
+  m_vertexIndex (GlobalRouteManagerLSDB::NO_INDEX),
   m_lsa (lsa),
   m_distanceFromRoot (SPF_INFINITY), 
   m_rootOif (SPF_INFINITY),
@@ -202,6 +222,20 @@ SPFVertex::GetVertexId (void) const
   return m_vertexId;
 }
 
+void
+SPFVertex::SetVertexIndex (uint32_t index)
+{
+  NS_LOG_FUNCTION (this << index);
+  m_vertexIndex = index;
+}
+
+uint32_t
+SPFVertex::GetVertexIndex (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_vertexIndex;
+}
+
 void
 SPFVertex::SetLSA (GlobalRoutingLSA* lsa)
 {
@@ -420,9 +454,12 @@ SPFVertex::ClearVertexProcessed (void)
 //
 // ---------------------------------------------------------------------------
 
+const uint32_t GlobalRouteManagerLSDB::NO_INDEX;
+
 GlobalRouteManagerLSDB::GlobalRouteManagerLSDB ()
   :
     m_database (),
+    m_neighborsIndexed (true),
     m_extdatabase ()
 {
   NS_LOG_FUNCTION (this);
@@ -431,11 +468,10 @@ GlobalRouteManagerLSDB::GlobalRouteManagerLSDB ()
 GlobalRouteManagerLSDB::~GlobalRouteManagerLSDB ()
 {
   NS_LOG_FUNCTION (this);
-  LSDBMap_t::iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  for (uint32_t j = 0; j < m_lsas.size (); j++)
     {
       NS_LOG_LOGIC ("free LSA");
-      GlobalRoutingLSA* temp = i->second;
+      GlobalRoutingLSA* temp = m_lsas[j];
       delete temp;
     }
   for (uint32_t j = 0; j < m_extdatabase.size (); j++)
@@ -445,19 +481,62 @@ GlobalRouteManagerLSDB::~GlobalRouteManagerLSDB ()
       delete temp;
     }
   NS_LOG_LOGIC ("clear map");
+  m_lsas.clear ();
   m_database.clear ();
+  m_neighbors.clear ();
+  m_linkDataIndex.clear ();
 }
 
 void
 GlobalRouteManagerLSDB::Initialize ()
 {
   NS_LOG_FUNCTION (this);
-  LSDBMap_t::iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  if (!m_neighborsIndexed)
     {
-      GlobalRoutingLSA* temp = i->second;
-      temp->SetStatus (GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED);
+      IndexNeighbors ();
+    }
+}
+
+void
+GlobalRouteManagerLSDB::IndexNeighbors (void)
+{
+  NS_LOG_FUNCTION (this);
+//
+// A link may lead to an LSA inserted after its own, so the links are looked
+// up once all the LSAs are in, and again if more are inserted.
+//
+  m_neighbors.assign (m_lsas.size (), std::vector<uint32_t> ());
+  for (uint32_t j = 0; j < m_lsas.size (); j++)
+    {
+      GlobalRoutingLSA *lsa = m_lsas[j];
+      std::vector<uint32_t> &neighbors = m_neighbors[j];
+      if (lsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+        {
+          neighbors.resize (lsa->GetNLinkRecords (), NO_INDEX);
+          for (uint32_t k = 0; k < neighbors.size (); k++)
+            {
+              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (k);
+              if (lr->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+                  || lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  neighbors[k] = GetLSAIndex (lr->GetLinkId ());
+                }
+            }
+        }
+      else if (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA)
+        {
+          neighbors.resize (lsa->GetNAttachedRouters (), NO_INDEX);
+          for (uint32_t k = 0; k < neighbors.size (); k++)
+            {
+              LinkDataMap_t::const_iterator i = m_linkDataIndex.find (lsa->GetAttachedRouter (k));
+              if (i != m_linkDataIndex.end ())
+                {
+                  neighbors[k] = GetLSAIndex (i->second);
+                }
+            }
+        }
     }
+  m_neighborsIndexed = true;
 }
 
 void
@@ -470,7 +549,30 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     } 
   else
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+      if (!m_database.insert (LSDBPair_t (addr, m_lsas.size ())).second)
+        {
+          return;
+        }
+      m_lsas.push_back (lsa);
+      m_neighborsIndexed = false;
+//
+// Index the transit link records.  When several LSAs have the same link
+// data, GetLSAByLinkData () returns the one with the lowest address.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          std::pair<LinkDataMap_t::iterator, bool> result = 
+            m_linkDataIndex.insert (std::make_pair (lr->GetLinkData (), addr));
+          if (!result.second && addr < result.first->second)
+            {
+              result.first->second = addr;
+            }
+        }
     }
 }
 
@@ -490,20 +592,52 @@ GlobalRouteManagerLSDB::GetNumExtLSAs () const
 
 GlobalRoutingLSA*
 GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
+{
+  NS_LOG_FUNCTION (this << addr);
+  uint32_t index = GetLSAIndex (addr);
+  if (index != NO_INDEX)
+    {
+      return m_lsas[index];
+    }
+  return 0;
+}
+
+uint32_t
+GlobalRouteManagerLSDB::GetLSAIndex (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
-  return 0;
+  return NO_INDEX;
+}
+
+GlobalRoutingLSA*
+GlobalRouteManagerLSDB::GetLSAByIndex (uint32_t index) const
+{
+  NS_LOG_FUNCTION (this << index);
+  NS_ASSERT (index < m_lsas.size ());
+  return m_lsas[index];
+}
+
+uint32_t
+GlobalRouteManagerLSDB::GetNLSAs (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_lsas.size ();
+}
+
+uint32_t
+GlobalRouteManagerLSDB::GetNeighborIndex (uint32_t index, uint32_t link) const
+{
+  NS_LOG_FUNCTION (this << index << link);
+  NS_ASSERT_MSG (m_neighborsIndexed, "GlobalRouteManagerLSDB::GetNeighborIndex (): Initialize () not called");
+  return m_neighbors[index][link];
 }
 
 GlobalRoutingLSA*
@@ -511,22 +645,12 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the link data of its transit link records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LinkDataMap_t::const_iterator i = m_linkDataIndex.find (addr);
+  if (i != m_linkDataIndex.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return GetLSA (i->second);
     }
   return 0;
 }
@@ -537,9 +661,16 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 //
 // ---------------------------------------------------------------------------
 
+GlobalRouteManagerImpl::SPFState::SPFState ()
+  : m_rootId (),
+    m_root (0),
+    m_ipv4 (0),
+    m_routing (0),
+    m_nodeId (0)
+{
+}
+
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
-  :
-    m_spfroot (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -563,6 +694,7 @@ GlobalRouteManagerImpl::DebugUseLsdb (GlobalRouteManagerLSDB* lsdb)
       delete m_lsdb;
     }
   m_lsdb = lsdb;
+  m_spfTrees.clear ();
 }
 
 void
@@ -573,25 +705,13 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
       Ptr<Node> node = *i;
-      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-      if (router == 0)
+      if (node->GetObject<GlobalRouter> () == 0)
         {
           continue;
         }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      DeleteRoutes (node);
     }
+  m_spfTrees.clear ();
   if (m_lsdb)
     {
       NS_LOG_LOGIC ("Deleting LSDB, creating new one");
@@ -600,6 +720,25 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
     }
 }
 
+void
+GlobalRouteManagerImpl::DeleteRoutes (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  Ptr<Ipv4GlobalRouting> gr = node->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+  uint32_t j = 0;
+  uint32_t nRoutes = gr->GetNRoutes ();
+  NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  for (j = 0; j < nRoutes; j++)
+    {
+      NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
+      gr->RemoveRoute (0);
+    }
+  NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+}
+
 //
 // In order to build the routing database, we need to walk the list of nodes
 // in the system and look for those that support the GlobalRouter interface.
@@ -692,6 +831,9 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase ()
 // algorithm then iterates again.  It terminates when the candidate
 // list becomes empty. 
 //
+// The calculations of the routers only read the link state database, so
+// they are gathered first and then run at once on several threads.
+//
 void
 GlobalRouteManagerImpl::InitializeRoutes ()
 {
@@ -700,6 +842,7 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 // Walk the list of nodes in the system.
 //
   NS_LOG_INFO ("About to start SPF calculation");
+  std::vector<SPFState> states;
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -724,12 +867,263 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 //
       if (rtr && rtr->GetNumLSAs () )
         {
-          SPFCalculate (rtr->GetRouterId ());
+          states.push_back (SPFState ());
+          SetRootNode (states.back (), node);
         }
     }
+  m_spfTrees.clear ();
+  SPFCalculate (states);
   NS_LOG_INFO ("Finished SPF calculation");
 }
 
+/**
+ * \brief Compare the content of two LSAs.
+ *
+ * \param a the first LSA
+ * \param b the second LSA
+ * \returns true if the LSAs advertise the same links and routers
+ */
+static bool
+IsSameLSA (GlobalRoutingLSA* a, GlobalRoutingLSA* b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord* la = a->GetLinkRecord (i);
+      GlobalRoutingLinkRecord* lb = b->GetLinkRecord (i);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < a->GetNAttachedRouters (); i++)
+    {
+      if (a->GetAttachedRouter (i) != b->GetAttachedRouter (i))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+//
+// The routes of a router only depend on the LSAs of its SPF tree, and on
+// the interfaces of the router, which its own LSA describes.  So the
+// routers whose tree holds none of the LSAs which changed keep their
+// routes, which a full computation would find again.
+//
+uint32_t
+GlobalRouteManagerImpl::RecomputeRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB *previous = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  std::set<Ipv4Address> changed;
+  bool allChanged = m_spfTrees.empty () || FindChangedLSAs (previous, changed);
+  delete previous;
+  NS_LOG_LOGIC (changed.size () << " LSAs changed, all: " << allChanged);
+
+  std::vector<SPFState> states;
+  uint32_t systemId = MpiInterface::GetSystemId ();
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr == 0)
+        {
+          continue;
+        }
+      bool calculate = node->GetSystemId () == systemId && rtr->GetNumLSAs ();
+      SPFTreeMap_t::iterator tree = m_spfTrees.find (rtr->GetRouterId ());
+      if (tree != m_spfTrees.end ())
+        {
+          bool reached = allChanged;
+          for (std::vector<Ipv4Address>::const_iterator j = tree->second.begin ();
+               !reached && j != tree->second.end (); j++)
+            {
+              reached = changed.count (*j) != 0;
+            }
+          if (calculate && !reached)
+            {
+              NS_LOG_LOGIC ("Keeping the routes of node " << node->GetId ());
+              continue;
+            }
+          m_spfTrees.erase (tree);
+        }
+      DeleteRoutes (node);
+      if (calculate)
+        {
+          states.push_back (SPFState ());
+          SetRootNode (states.back (), node);
+        }
+    }
+  SPFCalculate (states);
+  return states.size ();
+}
+
+bool
+GlobalRouteManagerImpl::FindChangedLSAs (GlobalRouteManagerLSDB* previous, std::set<Ipv4Address>& changed)
+{
+  NS_LOG_FUNCTION (this << previous);
+  previous->Initialize ();
+  m_lsdb->Initialize ();
+//
+// Gather the LSAs of both databases by ID, with the IDs of the LSAs their
+// links lead to, which may change without their content when another LSA
+// is added or removed.
+//
+  typedef std::map<Ipv4Address, std::pair<GlobalRoutingLSA*, std::vector<Ipv4Address> > > LSAMap_t;
+  LSAMap_t lsas[2];
+  GlobalRouteManagerLSDB* databases[2] = { previous, m_lsdb };
+  for (uint32_t d = 0; d < 2; d++)
+    {
+      for (uint32_t j = 0; j < databases[d]->GetNLSAs (); j++)
+        {
+          GlobalRoutingLSA* lsa = databases[d]->GetLSAByIndex (j);
+          std::pair<GlobalRoutingLSA*, std::vector<Ipv4Address> >& entry = lsas[d][lsa->GetLinkStateId ()];
+          entry.first = lsa;
+          uint32_t nLinks = lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA ?
+            lsa->GetNAttachedRouters () : lsa->GetNLinkRecords ();
+          for (uint32_t k = 0; k < nLinks; k++)
+            {
+              uint32_t neighbor = databases[d]->GetNeighborIndex (j, k);
+              entry.second.push_back (neighbor == GlobalRouteManagerLSDB::NO_INDEX ?
+                                      Ipv4Address::GetAny () :
+                                      databases[d]->GetLSAByIndex (neighbor)->GetLinkStateId ());
+            }
+        }
+    }
+  for (uint32_t d = 0; d < 2; d++)
+    {
+      for (LSAMap_t::const_iterator i = lsas[d].begin (); i != lsas[d].end (); i++)
+        {
+          LSAMap_t::const_iterator other = lsas[1 - d].find (i->first);
+          if (other == lsas[1 - d].end ()
+              || i->second.second != other->second.second
+              || !IsSameLSA (i->second.first, other->second.first))
+            {
+              changed.insert (i->first);
+            }
+        }
+    }
+  if (previous->GetNumExtLSAs () != m_lsdb->GetNumExtLSAs ())
+    {
+      return true;
+    }
+  for (uint32_t j = 0; j < m_lsdb->GetNumExtLSAs (); j++)
+    {
+      if (!IsSameLSA (previous->GetExtLSA (j), m_lsdb->GetExtLSA (j)))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+GlobalRouteManagerImpl::SetRootNode (SPFState& state, Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+  state.m_rootId = rtr->GetRouterId ();
+  state.m_routing = rtr->GetRoutingProtocol ();
+  NS_ASSERT (state.m_routing);
+//
+// Routing information is updated using the Ipv4 interface.  If the node is
+// acting as an IP version 4 router, it should absolutely have an Ipv4
+// interface.  It is looked up here, since the calculations must not call
+// GetObject () on the nodes while other threads run.
+//
+  state.m_ipv4 = node->GetObject<Ipv4> ();
+  NS_ASSERT_MSG (state.m_ipv4,
+                 "GlobalRouteManagerImpl::SetRootNode (): "
+                 "GetObject for <Ipv4> interface failed");
+  state.m_nodeId = node->GetId ();
+}
+
+void
+GlobalRouteManagerImpl::SPFCalculate (std::vector<SPFState>& states)
+{
+  NS_LOG_FUNCTION (this << states.size ());
+  m_lsdb->Initialize ();
+  uint32_t nThreads = 1;
+#ifdef HAVE_PTHREAD_H
+  UintegerValue threads;
+  g_globalRoutingThreads.GetValue (threads);
+  nThreads = threads.Get ();
+  if (nThreads == 0)
+    {
+      long processors = sysconf (_SC_NPROCESSORS_ONLN);
+      nThreads = processors > 0 ? processors : 1;
+    }
+#endif /* HAVE_PTHREAD_H */
+  nThreads = std::max<uint32_t> (1, std::min<uint32_t> (nThreads, states.size ()));
+  NS_LOG_LOGIC ("Running " << states.size () << " SPF calculations on " << nThreads << " threads");
+//
+// The first worker runs in the current thread.  The calculations write the
+// routes of their own root node only, so the workers do not share anything
+// but the link state database, which they read.
+//
+  std::vector<SPFWorker> workers (nThreads);
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      workers[i].m_impl = this;
+      workers[i].m_states = &states;
+      workers[i].m_first = i;
+      workers[i].m_step = nThreads;
+    }
+#ifdef HAVE_PTHREAD_H
+  std::vector<Ptr<SystemThread> > systemThreads;
+  for (uint32_t i = 1; i < nThreads; i++)
+    {
+      systemThreads.push_back (Create<SystemThread> (MakeCallback (&SPFWorker::Run, &workers[i])));
+      systemThreads.back ()->Start ();
+    }
+#endif /* HAVE_PTHREAD_H */
+  workers[0].Run ();
+#ifdef HAVE_PTHREAD_H
+  for (uint32_t i = 0; i < systemThreads.size (); i++)
+    {
+      systemThreads[i]->Join ();
+    }
+#endif /* HAVE_PTHREAD_H */
+//
+// Keep the SPF trees, by the IDs of their LSAs, for RecomputeRoutes ().
+//
+  for (std::vector<SPFState>::const_iterator i = states.begin (); i != states.end (); i++)
+    {
+      std::vector<Ipv4Address>& tree = m_spfTrees[i->m_rootId];
+      tree.clear ();
+      for (uint32_t j = 0; j < i->m_lsas.size (); j++)
+        {
+          tree.push_back (m_lsdb->GetLSAByIndex (i->m_lsas[j])->GetLinkStateId ());
+        }
+      std::sort (tree.begin (), tree.end ());
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFWorker::Run (void)
+{
+  for (uint32_t i = m_first; i < m_states->size (); i += m_step)
+    {
+      m_impl->SPFCalculate ((*m_states)[i]);
+    }
+}
+
 //
 // This method is derived from quagga ospf_spf_next ().  See RFC2328 Section 
 // 16.1 (2) for further details.
@@ -744,12 +1138,13 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 // vertex already on the candidate list, store the new (lower) cost.
 //
 void
-GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
+GlobalRouteManagerImpl::SPFNext (SPFState& state, SPFVertex* v, CandidateQueue& candidate)
 {
   NS_LOG_FUNCTION (this << v << &candidate);
 
   SPFVertex* w = 0;
   GlobalRoutingLSA* w_lsa = 0;
+  uint32_t wIndex = GlobalRouteManagerLSDB::NO_INDEX;
   GlobalRoutingLinkRecord *l = 0;
   uint32_t distance = 0;
   uint32_t numRecordsInVertex = 0;
@@ -797,16 +1192,18 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // Lookup the link state advertisement of the new link -- we call it <w> in
 // the link state database.
 //
-              w_lsa = m_lsdb->GetLSA (l->GetLinkId ());
-              NS_ASSERT (w_lsa);
+              wIndex = m_lsdb->GetNeighborIndex (v->GetVertexIndex (), i);
+              NS_ASSERT (wIndex != GlobalRouteManagerLSDB::NO_INDEX);
+              w_lsa = m_lsdb->GetLSAByIndex (wIndex);
               NS_LOG_LOGIC ("Found a P2P record from " << 
                             v->GetVertexId () << " to " << w_lsa->GetLinkStateId ());
             }
           else if (l->GetLinkType () == 
                    GlobalRoutingLinkRecord::TransitNetwork)
             {
-              w_lsa = m_lsdb->GetLSA (l->GetLinkId ());
-              NS_ASSERT (w_lsa);
+              wIndex = m_lsdb->GetNeighborIndex (v->GetVertexIndex (), i);
+              NS_ASSERT (wIndex != GlobalRouteManagerLSDB::NO_INDEX);
+              w_lsa = m_lsdb->GetLSAByIndex (wIndex);
               NS_LOG_LOGIC ("Found a Transit record from " << 
                             v->GetVertexId () << " to " << w_lsa->GetLinkStateId ());
             }
@@ -818,12 +1215,12 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // Get w_lsa:  In case of V is Network-LSA
       if (v->GetVertexType () == SPFVertex::VertexNetwork) 
         {
-          w_lsa = m_lsdb->GetLSAByLinkData 
-              (v->GetLSA ()->GetAttachedRouter (i));
-          if (!w_lsa)
+          wIndex = m_lsdb->GetNeighborIndex (v->GetVertexIndex (), i);
+          if (wIndex == GlobalRouteManagerLSDB::NO_INDEX)
             {
               continue;
             }
+          w_lsa = m_lsdb->GetLSAByIndex (wIndex);
           NS_LOG_LOGIC ("Found a Network LSA from " << 
                         v->GetVertexId () << " to " << w_lsa->GetLinkStateId ());
         }
@@ -836,7 +1233,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If the link is to a router that is already in the shortest path first tree
 // then we have it covered -- ignore it.
 //
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE) 
+      if (state.m_status[wIndex] == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE)
         {
           NS_LOG_LOGIC ("Skipping ->  LSA "<< 
                         w_lsa->GetLinkStateId () << " already in SPF tree");
@@ -861,7 +1258,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
       NS_LOG_LOGIC ("Considering w_lsa " << w_lsa->GetLinkStateId ());
 
 // Is there already vertex w in candidate list?
-      if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+      if (state.m_status[wIndex] == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
         {
 // Calculate nexthop to w
 // We need to figure out how to actually get to the new router represented
@@ -871,9 +1268,10 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 
 // prepare vertex w
           w = new SPFVertex (w_lsa);
-          if (SPFNexthopCalculation (v, w, l, distance))
+          w->SetVertexIndex (wIndex);
+          if (SPFNexthopCalculation (state, v, w, l, distance))
             {
-              w_lsa->SetStatus (GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+              state.m_status[wIndex] = GlobalRoutingLSA::LSA_SPF_CANDIDATE;
 //
 // Push this new vertex onto the priority queue (ordered by distance from the
 // root node).
@@ -888,7 +1286,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
             NS_ASSERT_MSG (0, "SPFNexthopCalculation never " 
                            << "return false, but it does now!");
         }
-      else if (w_lsa->GetStatus () == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
+      else if (state.m_status[wIndex] == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
         {
 //
 // We have already considered the link represented by <w>.  What wse have to
@@ -904,7 +1302,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 * if we've found a shorter path.
 */
           SPFVertex* cw;
-          cw = candidate.Find (w_lsa->GetLinkStateId ());
+          cw = candidate.Find (wIndex);
           if (cw->GetDistanceFromRoot () < distance)
             {
 //
@@ -935,7 +1333,8 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 
 // prepare vertex w
               w = new SPFVertex (w_lsa);
-              SPFNexthopCalculation (v, w, l, distance);
+              w->SetVertexIndex (wIndex);
+              SPFNexthopCalculation (state, v, w, l, distance);
               cw->MergeRootExitDirections (w);
               cw->MergeParent (w);
 // SPFVertexAddParent (w) is necessary as the destructor of 
@@ -954,13 +1353,13 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // N.B. the nexthop_calculation is conditional, if it finds a valid nexthop
 // it will call spf_add_parents, which will flush the old parents
 //
-              if (SPFNexthopCalculation (v, cw, l, distance))
+              if (SPFNexthopCalculation (state, v, cw, l, distance))
                 {
 //
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.DecreaseKey (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -979,6 +1378,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 //
 int
 GlobalRouteManagerImpl::SPFNexthopCalculation (
+  SPFState& state,
   SPFVertex* v, 
   SPFVertex* w,
   GlobalRoutingLinkRecord* l,
@@ -995,7 +1395,7 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
 */
 
 //
-// The vertex m_spfroot is a distinguished vertex representing the node at
+// The vertex state.m_root is a distinguished vertex representing the node at
 // the root of the calculations.  That is, it is the node for which we are
 // calculating the routes.
 //
@@ -1017,7 +1417,7 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
 // The point-to-point link information is only useful in this calculation when
 // we are examining the root node. 
 //
-  if (v == m_spfroot)
+  if (v == state.m_root)
     {
 //
 // In this case <v> is the root node, which means it is the starting point
@@ -1062,7 +1462,7 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
 // from the perspective of <v> -- remember that <l> is the link "from"
 // <v> "to" <w>.
 //
-          uint32_t outIf = FindOutgoingInterfaceId (l->GetLinkData ());
+          uint32_t outIf = FindOutgoingInterfaceId (state, l->GetLinkData ());
 
           w->SetRootExitDirection (nextHop, outIf);
           w->SetDistanceFromRoot (distance);
@@ -1080,7 +1480,7 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
           GlobalRoutingLSA* w_lsa = w->GetLSA ();
           NS_ASSERT (w_lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA);
 // Find outgoing interface ID for this network
-          uint32_t outIf = FindOutgoingInterfaceId (w_lsa->GetLinkStateId (), 
+          uint32_t outIf = FindOutgoingInterfaceId (state, w_lsa->GetLinkStateId (),
                                                     w_lsa->GetNetworkLSANetworkMask () );
 // Set the next hop to 0.0.0.0 meaning "not exist"
           Ipv4Address nextHop = Ipv4Address::GetZero ();
@@ -1097,7 +1497,7 @@ GlobalRouteManagerImpl::SPFNexthopCalculation (
   else if (v->GetVertexType () == SPFVertex::VertexNetwork) 
     {
 // See if any of v's parents are the root
-      if (v->GetParent () == m_spfroot)
+      if (v->GetParent () == state.m_root)
         {
 // 16.1.1 para 5. ...the parent vertex is a network that
 // directly connects the calculating router to the destination
@@ -1247,7 +1647,18 @@ void
 GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (this << root);
-  SPFCalculate (root);
+  std::vector<SPFState> states (1);
+  states[0].m_rootId = root;
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr != 0 && rtr->GetRouterId () == root)
+        {
+          SetRootNode (states[0], *i);
+          break;
+        }
+    }
+  SPFCalculate (states);
 }
 
 //
@@ -1257,13 +1668,15 @@ GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 // to be run
 //
 bool
-GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
+GlobalRouteManagerImpl::CheckForStubNode (SPFState& state)
 {
-  NS_LOG_FUNCTION (this << root);
-  GlobalRoutingLSA *rlsa = m_lsdb->GetLSA (root);
+  NS_LOG_FUNCTION (this << state.m_rootId);
+  uint32_t rootIndex = state.m_root->GetVertexIndex ();
+  GlobalRoutingLSA *rlsa = state.m_root->GetLSA ();
   Ipv4Address myRouterId = rlsa->GetLinkStateId ();
   int transits = 0;
   GlobalRoutingLinkRecord *transitLink = 0;
+  uint32_t transitIndex = 0;
   for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++)
     {
       GlobalRoutingLinkRecord *l = rlsa->GetLinkRecord (i);
@@ -1271,11 +1684,13 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
         {
           transits++;
           transitLink = l;
+          transitIndex = i;
         }
       else if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
         {
           transits++;
           transitLink = l;
+          transitIndex = i;
         }
     }
   if (transits == 0)
@@ -1283,7 +1698,7 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
       // This router is not connected to any router.  Probably, global
       // routing should not be called for this node, but we can just raise
       // a warning here and return true.
-      NS_LOG_WARN ("all nodes should have at least one transit link:" << root );
+      NS_LOG_WARN ("all nodes should have at least one transit link:" << state.m_rootId);
       return true;
     }
   if (transits == 1)
@@ -1304,7 +1719,9 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
           // Install default route to next hop
           // The link record LinkID is the router ID of the peer.
           // The Link Data is the local IP interface address
-          GlobalRoutingLSA *w_lsa = m_lsdb->GetLSA (transitLink->GetLinkId ());
+          uint32_t wIndex = m_lsdb->GetNeighborIndex (rootIndex, transitIndex);
+          NS_ASSERT (wIndex != GlobalRouteManagerLSDB::NO_INDEX);
+          GlobalRoutingLSA *w_lsa = m_lsdb->GetLSAByIndex (wIndex);
           uint32_t nLinkRecords = w_lsa->GetNLinkRecords ();
           for (uint32_t j = 0; j < nLinkRecords; ++j)
             {
@@ -1319,16 +1736,14 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               // Find the link record that corresponds to our routerId
               if (lr->GetLinkId () == myRouterId)
                 {
-                  // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-                  NS_ASSERT (gr);
-                  gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
-                                         FindOutgoingInterfaceId (transitLink->GetLinkData ()));
+                  // Next hop is stored in the LinkID field of lr.  The route
+                  // depends on the LSA of the peer as well.
+                  state.m_lsas.push_back (wIndex);
+                  int32_t outIf = FindOutgoingInterfaceId (state, transitLink->GetLinkData ());
+                  state.m_routing->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"),
+                                                      lr->GetLinkData (), outIf);
                   NS_LOG_LOGIC ("Inserting default route for node " << myRouterId << " to next hop " << 
-                                lr->GetLinkData () << " via interface " << 
-                                FindOutgoingInterfaceId (transitLink->GetLinkData ()));
+                                lr->GetLinkData () << " via interface " << outIf);
                   return true;
                 }
             }
@@ -1339,15 +1754,17 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
 
 // quagga ospf_spf_calculate
 void
-GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
+GlobalRouteManagerImpl::SPFCalculate (SPFState& state)
 {
+  Ipv4Address root = state.m_rootId;
   NS_LOG_FUNCTION (this << root);
 
   SPFVertex *v;
 //
-// Initialize the Link State Database.
+// None of the LSAs has been explored yet in this calculation.
 //
-  m_lsdb->Initialize ();
+  state.m_status.assign (m_lsdb->GetNLSAs (), GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED);
+  state.m_lsas.clear ();
 //
 // The candidate queue is a priority queue of SPFVertex objects, with the top
 // of the queue being the closest vertex in terms of distance from the root
@@ -1361,13 +1778,15 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // shortest path first (SPF) tree.
 //
   v = new SPFVertex (m_lsdb->GetLSA (root));
+  v->SetVertexIndex (m_lsdb->GetLSAIndex (root));
 // 
 // This vertex is the root of the SPF tree and it is distance 0 from the root.
 // We also mark this vertex as being in the SPF tree.
 //
-  m_spfroot= v;
+  state.m_root = v;
   v->SetDistanceFromRoot (0);
-  v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+  state.m_status[v->GetVertexIndex ()] = GlobalRoutingLSA::LSA_SPF_IN_SPFTREE;
+  state.m_lsas.push_back (v->GetVertexIndex ());
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
 
 //
@@ -1377,10 +1796,11 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if (state.m_routing != 0 && CheckForStubNode (state))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
-      delete m_spfroot;
+      delete state.m_root;
+      state.m_root = 0;
       return;
     }
 
@@ -1400,7 +1820,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // shortest path).  If the new vertices represent shorter paths, we use them
 // and update the path cost.
 //
-      SPFNext (v, candidate);
+      SPFNext (state, v, candidate);
 //
 // RFC2328 16.1. (3). 
 //
@@ -1428,7 +1848,8 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
 //
-      v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      state.m_status[v->GetVertexIndex ()] = GlobalRoutingLSA::LSA_SPF_IN_SPFTREE;
+      state.m_lsas.push_back (v->GetVertexIndex ());
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1444,12 +1865,10 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
 // RFC2328 16.1. (4). 
 //
-// This is the method that actually adds the routes.  It'll walk the list
-// of nodes in the system, looking for the node corresponding to the router
-// ID of the root of the tree -- that is the router we're building the routes
-// for.  It looks for the Ipv4 interface of that node and remembers it.  So
-// we are only actually adding routes to that one node at the root of the SPF 
-// tree.
+// This is the method that actually adds the routes, to the routing protocol
+// of the node at the root of the tree -- that is the router we're building
+// the routes for.  So we are only actually adding routes to that one node at
+// the root of the SPF tree.
 //
 // We're going to pop of a pointer to every vertex in the tree except the 
 // root in order of distance from the root.  For each of the vertices, we call
@@ -1467,11 +1886,11 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
       if (v->GetVertexType () == SPFVertex::VertexRouter)
         {
-          SPFIntraAddRouter (v);
+          SPFIntraAddRouter (state, v);
         }
       else if (v->GetVertexType () == SPFVertex::VertexNetwork)
         {
-          SPFIntraAddTransit (v);
+          SPFIntraAddTransit (state, v);
         }
       else
         {
@@ -1486,13 +1905,13 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
     }  // end for loop
 
 // Second stage of SPF calculation procedure
-  SPFProcessStubs (m_spfroot);
+  SPFProcessStubs (state, state.m_root);
   for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
     {
-      m_spfroot->ClearVertexProcessed ();
+      state.m_root->ClearVertexProcessed ();
       GlobalRoutingLSA *extlsa = m_lsdb->GetExtLSA (i);
       NS_LOG_LOGIC ("Processing External LSA with id " << extlsa->GetLinkStateId ());
-      ProcessASExternals (m_spfroot, extlsa);
+      ProcessASExternals (state, state.m_root, extlsa);
     }
 
 //
@@ -1500,12 +1919,12 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // the SPF tree.  Delete all of the vertices and corresponding resources.  Go
 // possibly do it again for the next router.
 //
-  delete m_spfroot;
-  m_spfroot = 0;
+  delete state.m_root;
+  state.m_root = 0;
 }
 
 void
-GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extlsa)
+GlobalRouteManagerImpl::ProcessASExternals (SPFState& state, SPFVertex* v, GlobalRoutingLSA* extlsa)
 {
   NS_LOG_FUNCTION (this << v << extlsa);
   NS_LOG_LOGIC ("Processing external for destination " << 
@@ -1519,7 +1938,7 @@ GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extl
       if ((rlsa->GetLinkStateId ()) == (extlsa->GetAdvertisingRouter ()))
         {
           NS_LOG_LOGIC ("Found advertising router to destination");
-          SPFAddASExternal (extlsa,v);
+          SPFAddASExternal (state, extlsa, v);
         }
     }
   for (uint32_t i = 0; i < v->GetNChildren (); i++)
@@ -1527,7 +1946,7 @@ GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extl
       if (!v->GetChild (i)->IsVertexProcessed ())
         {
           NS_LOG_LOGIC ("Vertex's child " << i << " not yet processed, processing...");
-          ProcessASExternals (v->GetChild (i), extlsa);
+          ProcessASExternals (state, v->GetChild (i), extlsa);
           v->GetChild (i)->SetVertexProcessed (true);
         }
     }
@@ -1539,15 +1958,15 @@ GlobalRouteManagerImpl::ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extl
 //
 
 void
-GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v)
+GlobalRouteManagerImpl::SPFAddASExternal (SPFState& state, GlobalRoutingLSA *extlsa, SPFVertex *v)
 {
   NS_LOG_FUNCTION (this << extlsa << v);
 
-  NS_ASSERT_MSG (m_spfroot, "GlobalRouteManagerImpl::SPFAddASExternal (): Root pointer not set");
+  NS_ASSERT_MSG (state.m_root, "GlobalRouteManagerImpl::SPFAddASExternal (): Root pointer not set");
 // Two cases to consider: We are advertising the external ourselves
 // => No need to add anything
 // OR find best path to the advertising router
-  if (v->GetVertexId () == m_spfroot->GetVertexId ())
+  if (v->GetVertexId () == state.m_rootId)
     {
       NS_LOG_LOGIC ("External is on local host: " 
                     << v->GetVertexId () << "; returning");
@@ -1555,110 +1974,60 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
     }
   NS_LOG_LOGIC ("External is on remote host: " 
                 << extlsa->GetAdvertisingRouter () << "; installing");
-
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// SetRootNode () has already found the routing protocol of the node at the
+// root of the SPF tree.  This is the one we're going to write the routing
+// information to.  There is none when the calculation is run for a unit
+// test without nodes.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = state.m_routing;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node for router " << state.m_rootId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << state.m_nodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFAddASExternal (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+//
+// The vertex <v> (corresponding to the router advertising the external) has
+// the next hop addresses precalculated for us, to which the root node should
+// send packets to be forwarded to the external network, and the outbound
+// interfaces to which the packets should be sent for forwarding.
+//
+// walk through all next-hop-IPs and out-going-interfaces for reaching
+// the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << state.m_nodeId <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << state.m_nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1666,7 +2035,7 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // stub link records will exist for point-to-point interfaces and for
 // broadcast interfaces for which no neighboring router can be found
 void
-GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
+GlobalRouteManagerImpl::SPFProcessStubs (SPFState& state, SPFVertex* v)
 {
   NS_LOG_FUNCTION (this << v);
   NS_LOG_LOGIC ("Processing stubs for " << v->GetVertexId ());
@@ -1683,7 +2052,7 @@ GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
           if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
             {
               NS_LOG_LOGIC ("Found a Stub record to " << l->GetLinkId ());
-              SPFIntraAddStub (l, v);
+              SPFIntraAddStub (state, l, v);
               continue;
             }
         }
@@ -1692,7 +2061,7 @@ GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
     {
       if (!v->GetChild (i)->IsVertexProcessed ())
         {
-          SPFProcessStubs (v->GetChild (i));
+          SPFProcessStubs (state, v->GetChild (i));
           v->GetChild (i)->SetVertexProcessed (true);
         }
     }
@@ -1700,11 +2069,11 @@ GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
 
 // RFC2328 16.1. second stage. 
 void
-GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex* v)
+GlobalRouteManagerImpl::SPFIntraAddStub (SPFState& state, GlobalRoutingLinkRecord *l, SPFVertex* v)
 {
   NS_LOG_FUNCTION (this << l << v);
 
-  NS_ASSERT_MSG (m_spfroot, 
+  NS_ASSERT_MSG (state.m_root, 
                  "GlobalRouteManagerImpl::SPFIntraAddStub (): Root pointer not set");
 
   // XXX simplifed logic for the moment.  There are two cases to consider:
@@ -1712,7 +2081,7 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
   //    (already handled above)
   // 2) the stub network is on a remote router, so I should use the
   // same next hop that I use to get to vertex v
-  if (v->GetVertexId () == m_spfroot->GetVertexId ())
+  if (v->GetVertexId () == state.m_rootId)
     {
       NS_LOG_LOGIC ("Stub is on local host: " << v->GetVertexId () << "; returning");
       return;
@@ -1720,194 +2089,82 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
   NS_LOG_LOGIC ("Stub is on remote host: " << v->GetVertexId () << "; installing");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
+// going to write the actual routing table entries.  SetRootNode () has
+// already found its routing protocol.
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = state.m_routing;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node for router " << state.m_rootId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << state.m_nodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddStub (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
+// The vertex <v> (corresponding to the node that has the stub network) has
 // an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
+// root node should send packets to be forwarded to the stub network.
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+// walk through all next-hop-IPs and out-going-interfaces for reaching
+// the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << state.m_nodeId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << state.m_nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
 // Return the interface number corresponding to a given IP address and mask
-// This is a wrapper around GetInterfaceForPrefix(), but we first
-// have to find the right node pointer to pass to that function.
+// This is a wrapper around GetInterfaceForPrefix() of the Ipv4 of the node
+// at the root of the calculation, which SetRootNode () has found.
 // If no such interface is found, return -1 (note:  unit test framework
 // for routing assumes -1 to be a legal return value)
 //
 int32_t
-GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
+GlobalRouteManagerImpl::FindOutgoingInterfaceId (SPFState& state, Ipv4Address a, Ipv4Mask amask)
 {
   NS_LOG_FUNCTION (this << a << amask);
-//
-// We have an IP address <a> and a vertex ID of the root of the SPF tree.
-// The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-//
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (state.m_ipv4 == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << state.m_rootId);
+      return -1;
+    }
 //
 // Look through the interfaces on this node for one that has the IP address
 // we're looking for.  If we find one, return the corresponding interface
 // index, or -1 if not found.
 //
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
-
-#if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
-    }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+  return state.m_ipv4->GetInterfaceForPrefix (a, amask);
 }
 
 //
@@ -1927,77 +2184,36 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 // route.
 //
 void
-GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
+GlobalRouteManagerImpl::SPFIntraAddRouter (SPFState& state, SPFVertex* v)
 {
   NS_LOG_FUNCTION (this << v);
 
-  NS_ASSERT_MSG (m_spfroot, 
+  NS_ASSERT_MSG (state.m_root, 
                  "GlobalRouteManagerImpl::SPFIntraAddRouter (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to write the actual routing table entries.  SetRootNode () has
+// already found its routing protocol.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = state.m_routing;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node for router " << state.m_rootId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << state.m_nodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2006,18 +2222,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << state.m_nodeId <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2031,153 +2247,90 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+// walk through all available exit directions due to ECMP,
+// and add host route for each of the exit direction toward
+// the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
+                                  outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << state.m_nodeId <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
             }
-//
-// Done adding the routes for the selected node.
-//
-          return;
-        }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << state.m_nodeId <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
 void
-GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
+GlobalRouteManagerImpl::SPFIntraAddTransit (SPFState& state, SPFVertex* v)
 {
   NS_LOG_FUNCTION (this << v);
 
-  NS_ASSERT_MSG (m_spfroot, 
+  NS_ASSERT_MSG (state.m_root, 
                  "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root pointer not set");
 //
 // The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// going to write the actual routing table entries.  SetRootNode () has
+// already found its routing protocol.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Ipv4GlobalRouting> gr = state.m_routing;
+  if (gr == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No node for router " << state.m_rootId);
+      return;
+    }
+  NS_LOG_LOGIC ("setting routes for node " << state.m_nodeId);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+// walk through all available exit directions due to ECMP,
+// and add host route for each of the exit direction toward
+// the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << state.m_nodeId <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << state.m_nodeId <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
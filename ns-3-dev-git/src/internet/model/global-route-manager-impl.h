@@ -26,10 +26,12 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/node-list.h"
 #include "global-router-interface.h"
 
 namespace ns3 {
@@ -37,6 +39,7 @@ namespace ns3 {
 const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
+class Ipv4;
 class Ipv4GlobalRouting;
 
 /**
@@ -173,6 +176,28 @@ public:
  */
   void SetVertexId (Ipv4Address id);
 
+/**
+ * @brief Get the index of the Link State Advertisement of a SPFVertex
+ * object in the Link State Database.
+ *
+ * The index identifies the vertex in the arrays of the SPF computation,
+ * such as the positions of the CandidateQueue.
+ *
+ * @see GlobalRouteManagerLSDB::GetLSAIndex ()
+ * @returns The index of the vertex, or GlobalRouteManagerLSDB::NO_INDEX
+ * if it has none.
+ */
+  uint32_t GetVertexIndex (void) const;
+
+/**
+ * @brief Set the index of the Link State Advertisement of a SPFVertex
+ * object in the Link State Database.
+ *
+ * @see GlobalRouteManagerLSDB::GetLSAIndex ()
+ * @param index The new index of the current SPFVertex object.
+ */
+  void SetVertexIndex (uint32_t index);
+
 /**
  * @brief Get the Global Router Link State Advertisement returned by the 
  * Global Router represented by this SPFVertex during the route discovery 
@@ -526,6 +551,7 @@ public:
 private:
   VertexType m_vertexType; //!< Vertex type
   Ipv4Address m_vertexId; //!< Vertex ID
+  uint32_t m_vertexIndex; //!< Index of the LSA in the Link State Database
   GlobalRoutingLSA* m_lsa; //!< Link State Advertisement
   uint32_t m_distanceFromRoot; //!< Distance from root node
   int32_t m_rootOif; //!< root Output Interface
@@ -578,6 +604,9 @@ private:
 class GlobalRouteManagerLSDB
 {
 public:
+  /// The index of no Link State Advertisement
+  static const uint32_t NO_INDEX = 0xffffffff;
+
 /**
  * @brief Construct an empty Global Router Manager Link State Database.
  *
@@ -602,6 +631,9 @@ public:
  * The IPV4 address and the GlobalRoutingLSA given as parameters are converted
  * to an STL pair and are inserted into the database map.
  *
+ * The link records of the LSA are indexed as it is inserted, so they
+ * must be complete by then.
+ *
  * @see GlobalRoutingLSA
  * @see Ipv4Address
  * @param addr The IP address associated with the LSA.  Typically the Router 
@@ -640,15 +672,60 @@ public:
   GlobalRoutingLSA* GetLSAByLinkData (Ipv4Address addr) const;
 
 /**
- * @brief Set all LSA flags to an initialized state, for SPF computation
+ * @brief Get the index of the Link State Advertisement associated with the
+ * given link state ID (address).
  *
- * This function walks the database and resets the status flags of all of the
- * contained Link State Advertisements to LSA_SPF_NOT_EXPLORED.  This is done
- * prior to each SPF calculation to reset the state of the SPFVertex structures
- * that will reference the LSAs during the calculation.
+ * The router and network LSAs are numbered from 0 in the order they are
+ * inserted, so that the SPF computation can keep its state in arrays.
  *
- * @see GlobalRoutingLSA
- * @see SPFVertex
+ * @see GetLSAByIndex
+ * @param addr The IP address associated with the LSA.  Typically the Router
+ * ID.
+ * @returns The index of the LSA, or NO_INDEX if there is none.
+ */
+  uint32_t GetLSAIndex (Ipv4Address addr) const;
+
+/**
+ * @brief Get the Link State Advertisement of the given index.
+ *
+ * @see GetLSAIndex
+ * @param index The index of the LSA, lower than GetNLSAs ().
+ * @returns A pointer to the Link State Advertisement.
+ */
+  GlobalRoutingLSA* GetLSAByIndex (uint32_t index) const;
+
+/**
+ * @brief Get the number of router and network Link State Advertisements.
+ *
+ * @returns The number of LSAs, which bounds their indices.
+ */
+  uint32_t GetNLSAs (void) const;
+
+/**
+ * @brief Get the index of the LSA a link of a Link State Advertisement
+ * leads to.
+ *
+ * The links are the link records of a router LSA and the attached routers
+ * of a network LSA.  Their LSAs are looked up once by Initialize (), and
+ * then found here without a search.
+ *
+ * @param index The index of the LSA.
+ * @param link The index of the link record or of the attached router.
+ * @returns The index of the LSA of the point-to-point or transit link
+ * record, or of the router attached to the network, or NO_INDEX for a stub
+ * link record or an unknown LSA.
+ */
+  uint32_t GetNeighborIndex (uint32_t index, uint32_t link) const;
+
+/**
+ * @brief Prepare the database for the SPF computations
+ *
+ * The first call after an Insert () looks up the neighbors of the LSAs.
+ * The SPF computations keep their state apart from the LSAs, so that,
+ * once initialized, the database is only read by them and several of
+ * them may run at once.
+ *
+ * @see GetNeighborIndex
  */
   void Initialize ();
 
@@ -674,10 +751,22 @@ public:
 
 
 private:
-  typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
-  typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
+  typedef std::map<Ipv4Address, uint32_t> LSDBMap_t; //!< container of IPv4 addresses / indices of Link State Advertisements
+  typedef std::pair<Ipv4Address, uint32_t> LSDBPair_t; //!< pair of IPv4 addresses / indices of Link State Advertisements
 
-  LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
+/**
+ * @brief Look up the neighbors of all the Link State Advertisements.
+ */
+  void IndexNeighbors (void);
+
+  std::vector<GlobalRoutingLSA*> m_lsas; //!< router and network Link State Advertisements, by index
+  LSDBMap_t m_database; //!< indices of the Link State Advertisements, by IPv4 address
+  /// The indices of the neighbors of each LSA, by link
+  std::vector<std::vector<uint32_t> > m_neighbors;
+  bool m_neighborsIndexed; //!< whether m_neighbors is up to date
+  typedef std::map<Ipv4Address, Ipv4Address> LinkDataMap_t; //!< container of link data / IPv4 addresses of the LSAs
+  /// The addresses of the LSAs with a TransitNetwork link record, by link data
+  LinkDataMap_t m_linkDataIndex;
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
 
 /**
@@ -730,9 +819,27 @@ public:
 /**
  * @brief Compute routes using a Dijkstra SPF computation and populate
  * per-node forwarding tables
+ *
+ * The computations of the routers run on the number of threads given by
+ * the "GlobalRoutingThreads" global value.  The SPF tree of each router
+ * is kept for RecomputeRoutes ().
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and recompute the routes of the
+ * routers whose SPF tree the changes reach
+ *
+ * The routes of a router are computed from the LSAs of its SPF tree.  The
+ * routers whose tree holds no LSA which changed since the trees were
+ * computed keep their routes, the others get them computed again.  A
+ * change of the external LSAs, or a previous DeleteGlobalRoutes (), has
+ * all the routes computed again.
+ *
+ * @returns The number of routers whose routes were computed again.
+ */
+  virtual uint32_t RecomputeRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -764,8 +871,81 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
-  SPFVertex* m_spfroot; //!< the root node
+/**
+ * @brief The state of the SPF calculation rooted at one router.
+ *
+ * The calculations only read the Link State Database and keep their own
+ * state here, indexed by LSA index, so that the calculations of several
+ * routers may run at once.
+ */
+  struct SPFState
+  {
+    SPFState ();
+    Ipv4Address m_rootId;             //!< the router ID of the root
+    SPFVertex* m_root;                //!< the root of the SPF tree
+    Ptr<Ipv4> m_ipv4;                 //!< the Ipv4 of the root node, or 0
+    Ptr<Ipv4GlobalRouting> m_routing; //!< the routing protocol of the root node, or 0
+    uint32_t m_nodeId;                //!< the id of the root node
+    /// The status of each LSA in this calculation
+    std::vector<GlobalRoutingLSA::SPFStatus> m_status;
+    /// The indices of the LSAs the routes were computed from
+    std::vector<uint32_t> m_lsas;
+  };
+
+/**
+ * @brief A thread running the SPF calculations of some of the routers.
+ */
+  struct SPFWorker
+  {
+    GlobalRouteManagerImpl* m_impl;   //!< the route manager
+    std::vector<SPFState>* m_states;  //!< the calculations of all the routers
+    uint32_t m_first;                 //!< the first calculation of this worker
+    uint32_t m_step;                  //!< the distance to the next calculation of this worker
+    /**
+     * @brief Run the calculations m_first, m_first + m_step, and so on.
+     */
+    void Run (void);
+  };
+
+  /// The SPF trees of the routers, as the sorted IDs of their LSAs, by router ID
+  typedef std::map<Ipv4Address, std::vector<Ipv4Address> > SPFTreeMap_t;
+
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  SPFTreeMap_t m_spfTrees; //!< the SPF trees of the last calculation of each router
+
+  /**
+   * \brief Delete the routes of a node
+   * \param node the node, which has a GlobalRouter interface
+   */
+  void DeleteRoutes (Ptr<Node> node);
+
+  /**
+   * \brief Set the node at the root of an SPF calculation
+   * \param state the calculation
+   * \param node the node, which has a GlobalRouter interface
+   */
+  void SetRootNode (SPFState& state, Ptr<Node> node);
+
+  /**
+   * \brief Find the LSAs which differ between a previous database and the
+   * current one
+   *
+   * An LSA differs if it is only in one of them, if its content changed, or
+   * if one of its links leads to another LSA.
+   *
+   * \param previous the previous database
+   * \param changed the link state IDs of the LSAs which differ
+   * \returns true if the external LSAs differ
+   */
+  bool FindChangedLSAs (GlobalRouteManagerLSDB* previous, std::set<Ipv4Address>& changed);
+
+  /**
+   * \brief Run the SPF calculations of several routers, at once if there are
+   * several threads, and keep their SPF trees
+   *
+   * \param states the calculations, with their root node set
+   */
+  void SPFCalculate (std::vector<SPFState>& states);
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -774,18 +954,18 @@ private:
    * can safely be added to the next-hop router and SPF does not need
    * to be run
    *
-   * \param root the root node
+   * \param state the SPF calculation
    * \returns true if the node is a stub
    */
-  bool CheckForStubNode (Ipv4Address root);
+  bool CheckForStubNode (SPFState& state);
 
   /**
    * \brief Calculate the shortest path first (SPF) tree
    *
    * Equivalent to quagga ospf_spf_calculate
-   * \param root the root node
+   * \param state the SPF calculation, with its root node set
    */
-  void SPFCalculate (Ipv4Address root);
+  void SPFCalculate (SPFState& state);
 
   /**
    * \brief Process Stub nodes
@@ -794,17 +974,19 @@ private:
    * stub link records will exist for point-to-point interfaces and for
    * broadcast interfaces for which no neighboring router can be found
    *
+   * \param state the SPF calculation
    * \param v vertex to be processed
    */
-  void SPFProcessStubs (SPFVertex* v);
+  void SPFProcessStubs (SPFState& state, SPFVertex* v);
 
   /**
    * \brief Process Autonomous Systems (AS) External LSA
    *
+   * \param state the SPF calculation
    * \param v vertex to be processed
    * \param extlsa external LSA
    */
-  void ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extlsa);
+  void ProcessASExternals (SPFState& state, SPFVertex* v, GlobalRoutingLSA* extlsa);
 
   /**
    * \brief Examine the links in v's LSA and update the list of candidates with any
@@ -824,10 +1006,11 @@ private:
    * vertices not already on the list.  If a lower-cost path is found to a
    * vertex already on the candidate list, store the new (lower) cost.
    *
+   * \param state the SPF calculation
    * \param v the vertex
    * \param candidate the SPF candidate queue
    */
-  void SPFNext (SPFVertex* v, CandidateQueue& candidate);
+  void SPFNext (SPFState& state, SPFVertex* v, CandidateQueue& candidate);
 
   /**
    * \brief Calculate nexthop from root through V (parent) to vertex W (destination)
@@ -836,13 +1019,14 @@ private:
    * This method is derived from quagga ospf_nexthop_calculation() 16.1.1.
    * For now, this is greatly simplified from the quagga code
    *
+   * \param state the SPF calculation
    * \param v the parent
    * \param w the destination
    * \param l the link record
    * \param distance the target distance
    * \returns 1 on success
    */
-  int SPFNexthopCalculation (SPFVertex* v, SPFVertex* w, 
+  int SPFNexthopCalculation (SPFState& state, SPFVertex* v, SPFVertex* w,
                              GlobalRoutingLinkRecord* l, uint32_t distance);
 
   /**
@@ -902,47 +1086,51 @@ private:
    * a destination IP address, reachable from the root, to which we add a host
    * route.
    *
+   * \param state the SPF calculation
    * \param v the vertex
    *
    */
-  void SPFIntraAddRouter (SPFVertex* v);
+  void SPFIntraAddRouter (SPFState& state, SPFVertex* v);
 
   /**
    * \brief Add a transit to the routing tables
    *
+   * \param state the SPF calculation
    * \param v the vertex
    */
-  void SPFIntraAddTransit (SPFVertex* v);
+  void SPFIntraAddTransit (SPFState& state, SPFVertex* v);
 
   /**
    * \brief Add a stub to the routing tables
    *
+   * \param state the SPF calculation
    * \param l the global routing link record
    * \param v the vertex
    */
-  void SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex* v);
+  void SPFIntraAddStub (SPFState& state, GlobalRoutingLinkRecord *l, SPFVertex* v);
 
   /**
    * \brief Add an external route to the routing tables
    *
+   * \param state the SPF calculation
    * \param extlsa the external LSA
    * \param v the vertex
    */
-  void SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v);
+  void SPFAddASExternal (SPFState& state, GlobalRoutingLSA *extlsa, SPFVertex *v);
 
   /**
    * \brief Return the interface number corresponding to a given IP address and mask
    *
-   * This is a wrapper around GetInterfaceForPrefix(), but we first
-   * have to find the right node pointer to pass to that function.
-   * If no such interface is found, return -1 (note:  unit test framework
+   * This is a wrapper around GetInterfaceForPrefix() of the Ipv4 of the
+   * node at the root of the calculation.  If no such interface is found, return -1 (note:  unit test framework
    * for routing assumes -1 to be a legal return value)
    *
+   * \param state the SPF calculation
    * \param a the target IP address
    * \param amask the target subnet mask
    * \return the outgoing interface number
    */
-  int32_t FindOutgoingInterfaceId (Ipv4Address a, 
+  int32_t FindOutgoingInterfaceId (SPFState& state, Ipv4Address a,
                                    Ipv4Mask amask = Ipv4Mask ("255.255.255.255"));
 };
 
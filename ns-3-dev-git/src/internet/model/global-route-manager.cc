@@ -58,6 +58,14 @@ GlobalRouteManager::InitializeRoutes (void)
   InitializeRoutes ();
 }
 
+uint32_t
+GlobalRouteManager::RecomputeRoutes (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+         RecomputeRoutes ();
+}
+
 uint32_t
 GlobalRouteManager::AllocateRouterId (void)
 {
@@ -62,6 +62,15 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and recompute the routes of the
+ * nodes whose shortest path tree reaches a Link State Advertisement which
+ * changed since the routes were computed.
+ *
+ * @returns the number of nodes whose routes were recomputed
+ */
+  static uint32_t RecomputeRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
@@ -475,6 +475,11 @@ public:
 
 /**
  * @brief Set the SPF status of the advertisement
+ *
+ * The SPF calculations keep the status of the advertisements they explore
+ * on their own, so that they may share the advertisements; they neither
+ * read nor set this one.
+ *
  * @param status SPF status to set
  * @see SPFStatus
  */
@@ -18,6 +18,7 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 
+#include <algorithm>
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ns3/log.h"
@@ -26,8 +27,50 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+/**
+ * \brief Mix a value into a hash, as boost::hash_combine does.
+ * \param hash the hash
+ * \param value the value
+ * \return the new hash
+ */
+static inline uint32_t
+HashCombine (uint32_t hash, uint32_t value)
+{
+  return hash ^ (value + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+/**
+ * \brief Check that an endpoint can receive the packets of an interface.
+ * \param endP the endpoint
+ * \param incomingInterface the incoming interface
+ * \return true if the endpoint can receive the packets
+ */
+static bool
+CanReceive (Ipv4EndPoint *endP, Ptr<Ipv4Interface> incomingInterface)
+{
+  if (!endP->IsRxEnabled ())
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                    << " because endpoint can not receive packets");
+      return false;
+    }
+  if (endP->GetBoundNetDevice ())
+    {
+      if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+        {
+          NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                             << " because endpoint is bound to specific device and"
+                                             << endP->GetBoundNetDevice ()
+                                             << " does not match packet device " << incomingInterface->GetDevice ());
+          return false;
+        }
+    }
+  return true;
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152),
+    m_nConnections (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -38,6 +81,7 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
       Ipv4EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
@@ -47,20 +91,30 @@ bool
 Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
+  std::map<uint16_t, Port>::iterator p = m_ports.find (port);
+  if (p == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = p->second.wildcards.begin (); i != p->second.wildcards.end (); i++)
+    {
+      if ((*i)->GetLocalAddress () == addr)
+        {
+          return true;
+        }
+    }
+  if (p->second.nEndPoints == p->second.wildcards.size ())
+    {
+      return false;
+    }
+  // some connections have the port, which is rare enough to walk them all
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
       if ((*i)->GetLocalPort () == port &&
@@ -83,7 +137,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -99,7 +153,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -122,7 +176,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -132,21 +186,42 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  EndPoints *candidates = 0;
+  if (localAddress != Ipv4Address::GetAny () &&
+      peerAddress != Ipv4Address::GetAny () &&
+      peerPort != 0)
+    {
+      if (m_nConnections > 0)
+        {
+          candidates = &GetConnections (localAddress, localPort, peerAddress, peerPort);
+        }
+    }
+  else
+    {
+      std::map<uint16_t, Port>::iterator p = m_ports.find (localPort);
+      if (p != m_ports.end ())
+        {
+          candidates = &p->second.wildcards;
+        }
+    }
+  if (candidates != 0)
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
+      for (EndPointsI i = candidates->begin (); i != candidates->end (); i++) 
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          if ((*i)->GetLocalPort () == localPort &&
+              (*i)->GetLocalAddress () == localAddress &&
+              (*i)->GetPeerPort () == peerPort &&
+              (*i)->GetPeerAddress () == peerAddress) 
+            {
+              NS_LOG_WARN ("No way we can allocate this end-point.");
+              /* no way we can allocate this end-point. */
+              return 0;
+            }
         }
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -161,6 +236,8 @@ Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
     {
       if (*i == endPoint)
         {
+          Unindex (endPoint);
+          endPoint->m_demux = 0;
           delete endPoint;
           m_endPoints.erase (i);
           break;
@@ -204,55 +281,65 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  std::map<uint16_t, Port>::iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
     {
-      Ipv4EndPoint* endP = *i;
-
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
+      NS_LOG_LOGIC ("No endpoint with dport " << dport);
+      return retval1;
+    }
 
-      if (!endP->IsRxEnabled ())
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                        << " because endpoint can not receive packets");
-          continue;
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
         }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
 
-      if (endP->GetLocalPort () != dport) 
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
-      if (endP->GetBoundNetDevice ())
+  // A connected endpoint can only match exactly, its local address being
+  // the address of the interface for the broadcasts.  No endpoint with a
+  // wildcard can then match exactly, as the packet has none.
+  if (port->second.nEndPoints > port->second.wildcards.size ())
+    {
+      EndPoints &connections = GetConnections (incomingInterfaceAddr, dport, saddr, sport);
+      for (EndPointsI i = connections.begin (); i != connections.end (); i++)
         {
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+          Ipv4EndPoint* endP = *i;
+          if (endP->GetLocalPort () == dport &&
+              endP->GetLocalAddress () == incomingInterfaceAddr &&
+              endP->GetPeerPort () == sport &&
+              endP->GetPeerAddress () == saddr &&
+              CanReceive (endP, incomingInterface))
             {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
-              continue;
+              retval4.push_back (endP);
             }
         }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+      if (!retval4.empty ())
         {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
+          return retval4;
+        }
+    }
+
+  for (EndPointsI i = port->second.wildcards.begin (); i != port->second.wildcards.end (); i++) 
+    {
+      Ipv4EndPoint* endP = *i;
+
+      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
+                                                 << " daddr=" << endP->GetLocalAddress ()
+                                                 << " sport=" << endP->GetPeerPort ()
+                                                 << " saddr=" << endP->GetPeerAddress ());
+
+      if (!CanReceive (endP, incomingInterface))
+        {
+          continue;
         }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
       bool localAddressMatchesWildCard = 
         endP->GetLocalAddress () == Ipv4Address::GetAny ();
       bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
@@ -324,6 +411,27 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  std::map<uint16_t, Port>::iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return 0;
+    }
+  if (port->second.nEndPoints > port->second.wildcards.size ())
+    {
+      EndPoints &connections = GetConnections (daddr, dport, saddr, sport);
+      for (EndPointsI i = connections.begin (); i != connections.end (); i++)
+        {
+          if ((*i)->GetLocalPort () == dport &&
+              (*i)->GetLocalAddress () == daddr &&
+              (*i)->GetPeerPort () == sport &&
+              (*i)->GetPeerAddress () == saddr) 
+            {
+              /* this is an exact match. */
+              return *i;
+            }
+        }
+    }
+
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
   uint32_t genericity = 3;
@@ -358,28 +466,162 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
     }
   return generic;
 }
+
 uint16_t
 Ipv4EndPointDemux::AllocateEphemeralPort (void)
 {
   // Similar to counting up logic in netinet/in_pcb.c
   NS_LOG_FUNCTION (this);
-  uint16_t port = m_ephemeral;
-  int count = m_portLast - m_portFirst;
-  do 
+  uint32_t nPorts = m_portLast - m_portFirst + 1;
+  if (m_ephemeralInUse.empty ())
     {
-      if (count-- < 0)
+      m_ephemeralInUse.resize ((nPorts + 31) / 32, 0);
+      for (std::map<uint16_t, Port>::iterator i = m_ports.lower_bound (m_portFirst);
+           i != m_ports.end () && i->first <= m_portLast; i++)
         {
-          return 0;
+          MarkEphemeralPort (i->first, true);
         }
-      ++port;
-      if (port < m_portFirst || port > m_portLast)
+    }
+  // the port following the last one allocated
+  uint32_t index = 0;
+  if (m_ephemeral >= m_portFirst && m_ephemeral < m_portLast)
+    {
+      index = m_ephemeral - m_portFirst + 1;
+    }
+  uint32_t count = 0;
+  while (count < nPorts)
+    {
+      uint32_t word = m_ephemeralInUse[index / 32];
+      if (index % 32 == 0 && word == 0xffffffff && index + 32 <= nPorts)
         {
-          port = m_portFirst;
+          // 32 ports in use
+          count += 32;
+          index += 32;
         }
-    } while (LookupPortLocal (port));
-  m_ephemeral = port;
-  return port;
+      else if ((word & (1U << (index % 32))) == 0)
+        {
+          m_ephemeral = m_portFirst + index;
+          return m_ephemeral;
+        }
+      else
+        {
+          count++;
+          index++;
+        }
+      if (index == nPorts)
+        {
+          index = 0;
+        }
+    }
+  return 0;
 }
 
-} // namespace ns3
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+}
 
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Port &port = m_ports[endPoint->GetLocalPort ()];
+  if (port.nEndPoints++ == 0)
+    {
+      MarkEphemeralPort (endPoint->GetLocalPort (), true);
+    }
+  if (!IsConnected (endPoint))
+    {
+      port.wildcards.push_back (endPoint);
+      return;
+    }
+  if (m_nConnections >= m_connections.size ())
+    {
+      ResizeConnections (std::max<uint32_t> (16, 2 * m_connections.size ()));
+    }
+  GetConnections (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                  endPoint->GetPeerAddress (), endPoint->GetPeerPort ()).push_back (endPoint);
+  m_nConnections++;
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::map<uint16_t, Port>::iterator port = m_ports.find (endPoint->GetLocalPort ());
+  NS_ASSERT (port != m_ports.end ());
+  EndPoints &endPoints = IsConnected (endPoint) ?
+    GetConnections (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                    endPoint->GetPeerAddress (), endPoint->GetPeerPort ()) :
+    port->second.wildcards;
+  EndPointsI i = std::find (endPoints.begin (), endPoints.end (), endPoint);
+  NS_ASSERT (i != endPoints.end ());
+  endPoints.erase (i);
+  if (IsConnected (endPoint))
+    {
+      m_nConnections--;
+    }
+  if (--port->second.nEndPoints == 0)
+    {
+      MarkEphemeralPort (endPoint->GetLocalPort (), false);
+      m_ports.erase (port);
+    }
+}
+
+Ipv4EndPointDemux::EndPoints &
+Ipv4EndPointDemux::GetConnections (Ipv4Address localAddress, uint16_t localPort,
+                                   Ipv4Address peerAddress, uint16_t peerPort)
+{
+  uint32_t hash = localAddress.Get ();
+  hash = HashCombine (hash, peerAddress.Get ());
+  hash = HashCombine (hash, (static_cast<uint32_t> (localPort) << 16) | peerPort);
+  return m_connections[hash & (m_connections.size () - 1)];
+}
+
+void
+Ipv4EndPointDemux::ResizeConnections (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  std::vector<EndPoints> old (size);
+  old.swap (m_connections);
+  for (std::vector<EndPoints>::iterator i = old.begin (); i != old.end (); i++)
+    {
+      for (EndPointsI j = i->begin (); j != i->end (); j++)
+        {
+          GetConnections ((*j)->GetLocalAddress (), (*j)->GetLocalPort (),
+                          (*j)->GetPeerAddress (), (*j)->GetPeerPort ()).push_back (*j);
+        }
+    }
+}
+
+void
+Ipv4EndPointDemux::MarkEphemeralPort (uint16_t port, bool inUse)
+{
+  if (m_ephemeralInUse.empty () || port < m_portFirst || port > m_portLast)
+    {
+      return;
+    }
+  uint32_t index = port - m_portFirst;
+  if (inUse)
+    {
+      m_ephemeralInUse[index / 32] |= 1U << (index % 32);
+    }
+  else
+    {
+      m_ephemeralInUse[index / 32] &= ~(1U << (index % 32));
+    }
+}
+
+bool
+Ipv4EndPointDemux::IsConnected (Ipv4EndPoint *endPoint)
+{
+  return endPoint->GetLocalAddress () != Ipv4Address::GetAny () &&
+         endPoint->GetPeerAddress () != Ipv4Address::GetAny () &&
+         endPoint->GetPeerPort () != 0;
+}
+
+} // namespace ns3
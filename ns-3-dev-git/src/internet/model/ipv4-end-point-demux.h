@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -38,6 +40,13 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The connected endpoints, whose four-tuple is fully specified, are kept
+ * in a hash table, so that the lookups of the packets of established
+ * connections do not depend on the number of connections.  The other
+ * endpoints, listening or bound to wildcard addresses, are kept in a list
+ * per local port.  A bitmap of the ephemeral ports in use speeds up the
+ * allocation of the ephemeral ports.
  */
 
 class Ipv4EndPointDemux {
@@ -161,6 +170,17 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief The endpoints with a local port.
+   */
+  struct Port
+  {
+    Port () : nEndPoints (0) {}
+    uint32_t nEndPoints; //!< Number of endpoints with the port
+    EndPoints wildcards; //!< The endpoints not in the connection table
+  };
 
   /**
    * \brief Allocate an ephemeral port.
@@ -168,6 +188,61 @@ private:
    */
   uint16_t AllocateEphemeralPort (void);
 
+  /**
+   * \brief Add an endpoint to the demux.
+   * \param endPoint the new endpoint
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the lookup tables.
+   *
+   * Called by the endpoint after a change of its addresses or ports.
+   *
+   * \param endPoint the endpoint
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the lookup tables.
+   *
+   * Called by the endpoint before a change of its addresses or ports.
+   *
+   * \param endPoint the endpoint
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Get the bucket of the connection table of a four-tuple.
+   * \param localAddress local address
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return the endpoints which may have the four-tuple
+   */
+  EndPoints &GetConnections (Ipv4Address localAddress, uint16_t localPort,
+                             Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Resize the connection table.
+   * \param size the new number of buckets, a power of two
+   */
+  void ResizeConnections (uint32_t size);
+
+  /**
+   * \brief Update the bitmap of the ephemeral ports in use.
+   * \param port the port
+   * \param inUse true if the first endpoint with the port was added,
+   * false if the last one was removed
+   */
+  void MarkEphemeralPort (uint16_t port, bool inUse);
+
+  /**
+   * \param endPoint an endpoint
+   * \return true if the four-tuple of the endpoint has no wildcard
+   */
+  static bool IsConnected (Ipv4EndPoint *endPoint);
+
   /**
    * \brief The ephemeral port.
    */
@@ -187,6 +262,27 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The endpoints indexed by local port.
+   */
+  std::map<uint16_t, Port> m_ports;
+
+  /**
+   * \brief The connected endpoints, hashed on their four-tuple.
+   */
+  std::vector<EndPoints> m_connections;
+
+  /**
+   * \brief The number of endpoints in m_connections.
+   */
+  uint32_t m_nConnections;
+
+  /**
+   * \brief One bit per ephemeral port, set when the port is in use.
+   * Empty until the first ephemeral port allocation.
+   */
+  std::vector<uint32_t> m_ephemeralInUse;
 };
 
 } // namespace ns3
@@ -36,6 +36,21 @@ NS_LOG_COMPONENT_DEFINE ("Ipv4GlobalRouting");
 
 NS_OBJECT_ENSURE_REGISTERED (Ipv4GlobalRouting);
 
+/// The number of destinations whose routes are cached
+static const uint32_t ROUTE_CACHE_SIZE = 4096;
+
+/**
+ * \brief Hash of a destination of the route cache
+ * \param dest the destination
+ * \returns the hash value
+ */
+static inline uint32_t
+HashDestination (Ipv4Address dest)
+{
+  uint32_t h = dest.Get () * 0x9e3779b1U;
+  return h ^ (h >> 15);
+}
+
 TypeId 
 Ipv4GlobalRouting::GetTypeId (void)
 { 
@@ -58,7 +73,9 @@ Ipv4GlobalRouting::GetTypeId (void)
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_indexValid (false),
+    m_nCachedRoutes (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -79,6 +96,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  InvalidateRoutes ();
 }
 
 void 
@@ -89,6 +107,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  InvalidateRoutes ();
 }
 
 void 
@@ -104,6 +123,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  InvalidateRoutes ();
 }
 
 void 
@@ -117,6 +137,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  InvalidateRoutes ();
 }
 
 void 
@@ -132,6 +153,7 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  InvalidateRoutes ();
 }
 
 
@@ -140,108 +162,226 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION (this << dest << oif);
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
-  Ptr<Ipv4Route> rtentry = 0;
-  // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-  RouteVec_t allRoutes;
+  RouteVec computed;
+  CachedRoutes *cached = 0;
+  RouteVec *allRoutes = &computed;
+  if (oif == 0)
+    {
+      cached = &GetCachedRoutes (dest);
+      allRoutes = &cached->routes;
+    }
+  else
+    {
+      FindRoutes (dest, oif, computed);
+    }
+  if (allRoutes->size () > 0 ) // if route(s) is found
+    {
+      // pick up one of the routes uniformly at random if random
+      // ECMP routing is enabled, or always select the first route
+      // consistently if random ECMP routing is disabled
+      uint32_t selectIndex;
+      if (m_randomEcmpRouting)
+        {
+          selectIndex = m_rand->GetInteger (0, allRoutes->size ()-1);
+        }
+      else 
+        {
+          selectIndex = 0;
+        }
+      Ipv4RoutingTableEntry* route = allRoutes->at (selectIndex); 
+      if (cached == 0)
+        {
+          return BuildRoute (route);
+        }
+      Ptr<Ipv4Route> &rtentry = cached->built[selectIndex];
+      if (rtentry == 0)
+        {
+          rtentry = BuildRoute (route);
+        }
+      return rtentry;
+    }
+  else 
+    {
+      return 0;
+    }
+}
 
-  NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::BuildRoute (Ipv4RoutingTableEntry *route) const
+{
+  // create a Ipv4Route object from the selected routing table entry
+  Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
+  rtentry->SetDestination (route->GetDest ());
+  /// \todo handle multi-address case
+  rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
+  rtentry->SetGateway (route->GetGateway ());
+  uint32_t interfaceIdx = route->GetInterface ();
+  rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+  return rtentry;
+}
+
+Ipv4GlobalRouting::CachedRoutes &
+Ipv4GlobalRouting::GetCachedRoutes (Ipv4Address dest)
+{
+  if (m_routeCache.size () > 0)
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest)) 
+      uint32_t mask = m_routeCache.size () - 1;
+      for (uint32_t i = HashDestination (dest) & mask; m_routeCache[i].used; i = (i + 1) & mask)
         {
-          if (oif != 0)
+          if (m_routeCache[i].dest == dest)
             {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
+              return m_routeCache[i];
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
         }
     }
-  if (allRoutes.size () == 0) // if no host route is found
+  if (m_nCachedRoutes >= ROUTE_CACHE_SIZE)
     {
-      NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
+      // evict the destination of the first slot of the new one
+      uint32_t mask = m_routeCache.size () - 1;
+      uint32_t i = HashDestination (dest) & mask;
+      while (!m_routeCache[i].used)
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
-            {
-              if (oif != 0)
-                {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
-                }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
-            }
+          i = (i + 1) & mask;
         }
+      RemoveCachedRoutes (i);
+    }
+  else if (2 * (m_nCachedRoutes + 1) > m_routeCache.size ())
+    {
+      ResizeRouteCache (std::max<uint32_t> (16, 2 * m_routeCache.size ()));
     }
-  if (allRoutes.size () == 0)  // consider external if no host/network found
+  uint32_t mask = m_routeCache.size () - 1;
+  uint32_t i = HashDestination (dest) & mask;
+  while (m_routeCache[i].used)
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
-           k++)
+      i = (i + 1) & mask;
+    }
+  CachedRoutes &cached = m_routeCache[i];
+  cached.dest = dest;
+  cached.used = true;
+  FindRoutes (dest, 0, cached.routes);
+  cached.built.resize (cached.routes.size ());
+  m_nCachedRoutes++;
+  return cached;
+}
+
+void
+Ipv4GlobalRouting::RemoveCachedRoutes (uint32_t slot)
+{
+  // shift back the following destinations of the cluster which may fill
+  // the hole, so that the lookups need no tombstones
+  uint32_t mask = m_routeCache.size () - 1;
+  uint32_t hole = slot;
+  for (uint32_t i = (slot + 1) & mask; m_routeCache[i].used; i = (i + 1) & mask)
+    {
+      uint32_t home = HashDestination (m_routeCache[i].dest) & mask;
+      if (((i - home) & mask) >= ((i - hole) & mask))
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          std::swap (m_routeCache[hole], m_routeCache[i]);
+          hole = i;
+        }
+    }
+  m_routeCache[hole].used = false;
+  m_routeCache[hole].routes.clear ();
+  m_routeCache[hole].built.clear ();
+  m_nCachedRoutes--;
+}
+
+void
+Ipv4GlobalRouting::ResizeRouteCache (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  std::vector<CachedRoutes> old;
+  old.swap (m_routeCache);
+  CachedRoutes empty;
+  empty.used = false;
+  m_routeCache.resize (size, empty);
+  uint32_t mask = size - 1;
+  for (std::vector<CachedRoutes>::iterator i = old.begin (); i != old.end (); i++)
+    {
+      if (i->used)
+        {
+          uint32_t j = HashDestination (i->dest) & mask;
+          while (m_routeCache[j].used)
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
-                {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
-                }
-              allRoutes.push_back (*k);
-              break;
+              j = (j + 1) & mask;
             }
+          std::swap (m_routeCache[j], *i);
         }
     }
-  if (allRoutes.size () > 0 ) // if route(s) is found
+}
+
+void
+Ipv4GlobalRouting::FindRoutes (Ipv4Address dest, Ptr<NetDevice> oif, RouteVec &routes)
+{
+  NS_LOG_FUNCTION (this << dest << oif);
+  if (!m_indexValid)
     {
-      // pick up one of the routes uniformly at random if random
-      // ECMP routing is enabled, or always select the first route
-      // consistently if random ECMP routing is disabled
-      uint32_t selectIndex;
-      if (m_randomEcmpRouting)
+      IndexRoutes ();
+    }
+  // the matching routes, hosts first, then networks, then external
+  std::vector<uint32_t> positions;
+  m_index.Lookup (dest, positions);
+  uint32_t firstNetwork = m_hostRoutes.size ();
+  uint32_t firstExternal = firstNetwork + m_networkRoutes.size ();
+  for (std::vector<uint32_t>::const_iterator i = positions.begin (); i != positions.end (); i++)
+    {
+      if (*i >= firstNetwork && routes.size () > 0)
         {
-          selectIndex = m_rand->GetInteger (0, allRoutes.size ()-1);
+          // only consider networks if no host route is found, and
+          // external if no host/network found
+          break;
         }
-      else 
+      Ipv4RoutingTableEntry *route = m_indexedRoutes[*i];
+      if (oif != 0)
         {
-          selectIndex = 0;
+          if (oif != m_ipv4->GetNetDevice (route->GetInterface ()))
+            {
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
+              continue;
+            }
+        }
+      routes.push_back (route);
+      NS_LOG_LOGIC (routes.size () << "Found global route" << route);
+      if (*i >= firstExternal)
+        {
+          // only the first external route
+          break;
         }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
-      // create a Ipv4Route object from the selected routing table entry
-      rtentry = Create<Ipv4Route> ();
-      rtentry->SetDestination (route->GetDest ());
-      /// \todo handle multi-address case
-      rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
-      rtentry->SetGateway (route->GetGateway ());
-      uint32_t interfaceIdx = route->GetInterface ();
-      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
-      return rtentry;
     }
-  else 
+}
+
+void
+Ipv4GlobalRouting::IndexRoutes (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_indexedRoutes.clear ();
+  m_index.Clear ();
+  for (HostRoutesCI i = m_hostRoutes.begin (); i != m_hostRoutes.end (); i++)
     {
-      return 0;
+      NS_ASSERT ((*i)->IsHost ());
+      m_indexedRoutes.push_back (*i);
+      m_index.Add ((*i)->GetDest (), Ipv4Mask::GetOnes ());
+    }
+  for (NetworkRoutesCI j = m_networkRoutes.begin (); j != m_networkRoutes.end (); j++)
+    {
+      m_indexedRoutes.push_back (*j);
+      m_index.Add ((*j)->GetDestNetwork (), (*j)->GetDestNetworkMask ());
+    }
+  for (ASExternalRoutesCI k = m_ASexternalRoutes.begin (); k != m_ASexternalRoutes.end (); k++)
+    {
+      m_indexedRoutes.push_back (*k);
+      m_index.Add ((*k)->GetDestNetwork (), (*k)->GetDestNetworkMask ());
     }
+  m_indexValid = true;
+}
+
+void
+Ipv4GlobalRouting::InvalidateRoutes (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_indexValid = false;
+  m_routeCache.clear ();
+  m_nCachedRoutes = 0;
 }
 
 uint32_t 
@@ -308,6 +448,7 @@ void
 Ipv4GlobalRouting::RemoveRoute (uint32_t index)
 {
   NS_LOG_FUNCTION (this << index);
+  InvalidateRoutes ();
   if (index < m_hostRoutes.size ())
     {
       uint32_t tmp = 0;
@@ -391,6 +532,7 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  InvalidateRoutes ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -555,11 +697,11 @@ void
 Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  // the cached routes hold the devices and addresses of the interfaces
+  InvalidateRoutes ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutes ();
     }
 }
 
@@ -567,11 +709,11 @@ void
 Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  // the cached routes hold the devices and addresses of the interfaces
+  InvalidateRoutes ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutes ();
     }
 }
 
@@ -579,11 +721,11 @@ void
 Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  // the cached routes hold the devices and addresses of the interfaces
+  InvalidateRoutes ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutes ();
     }
 }
 
@@ -591,11 +733,11 @@ void
 Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  // the cached routes hold the devices and addresses of the interfaces
+  InvalidateRoutes ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::RecomputeRoutes ();
     }
 }
 
@@ -21,6 +21,8 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <map>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +30,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-routing-table-index.h"
 
 namespace ns3 {
 
@@ -258,12 +261,89 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
+  /// container of the routes to a destination, one per equal cost route
+  typedef std::vector<Ipv4RoutingTableEntry *> RouteVec;
+
+  /// A slot of the cache of the routes to the destinations recently looked up
+  struct CachedRoutes
+  {
+    Ipv4Address dest;                   //!< the destination
+    bool used;                          //!< the slot holds a destination
+    RouteVec routes;                    //!< the routes to the destination
+    std::vector<Ptr<Ipv4Route> > built; //!< the Ipv4Route of each route, or 0 until used
+  };
+
+  /**
+   * \brief Lookup in the forwarding table for destination.
+   * \param dest destination address
+   * \param oif output interface if any (put 0 otherwise)
+   * \return Ipv4Route to route the packet to reach dest address
+   */
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /**
+   * \brief Find the equal cost routes to a destination.
+   * \param dest destination address
+   * \param oif output interface if any (put 0 otherwise)
+   * \param [out] routes the routing table entries, in the order of the
+   * routing table
+   */
+  void FindRoutes (Ipv4Address dest, Ptr<NetDevice> oif, RouteVec &routes);
+
+  /**
+   * \brief Build the Ipv4Route of a routing table entry.
+   * \param route the routing table entry
+   * \return the Ipv4Route
+   */
+  Ptr<Ipv4Route> BuildRoute (Ipv4RoutingTableEntry *route) const;
+
+  /**
+   * \brief Get the cached routes to a destination, and find them if they
+   * are not cached.
+   * \param dest destination address
+   * \return the slot of the destination in the cache
+   */
+  CachedRoutes & GetCachedRoutes (Ipv4Address dest);
+
+  /**
+   * \brief Remove a destination from the route cache.
+   * \param slot the slot of the destination
+   */
+  void RemoveCachedRoutes (uint32_t slot);
+
+  /**
+   * \brief Resize the route cache, and keep its destinations.
+   * \param size the new number of slots, a power of two
+   */
+  void ResizeRouteCache (uint32_t size);
+
+  /**
+   * \brief Index the routes, after a change of the routing table.
+   */
+  void IndexRoutes (void);
+
+  /**
+   * \brief Forget the routes looked up and the index, after a change of
+   * the routing table.
+   */
+  void InvalidateRoutes (void);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  /// The routes to hosts, then to networks, then external, by position
+  std::vector<Ipv4RoutingTableEntry *> m_indexedRoutes;
+  /// Index of the destinations of m_indexedRoutes
+  Ipv4RoutingTableIndex m_index;
+  /// m_index matches the routing table
+  bool m_indexValid;
+  /// Routes to the destinations recently looked up with no output interface,
+  /// as an open addressing hash table with linear probing, whose size is a
+  /// power of two
+  std::vector<CachedRoutes> m_routeCache;
+  uint32_t m_nCachedRoutes; //!< Number of destinations in m_routeCache
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
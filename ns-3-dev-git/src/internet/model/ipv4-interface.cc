@@ -29,6 +29,8 @@
 #include "ns3/packet.h"
 #include "ns3/node.h"
 #include "ns3/pointer.h"
+#include "ns3/traffic-control-layer.h"
+#include "ipv4-queue-disc-item.h"
 
 namespace ns3 {
 
@@ -80,6 +82,7 @@ Ipv4Interface::DoDispose (void)
   NS_LOG_FUNCTION (this);
   m_node = 0;
   m_device = 0;
+  m_tc = 0;
   Object::DoDispose ();
 }
 
@@ -107,6 +110,7 @@ Ipv4Interface::DoSetup (void)
     {
       return;
     }
+  m_tc = m_node->GetObject<TrafficControlLayer> ();
   if (!m_device->NeedsArp ())
     {
       return;
@@ -273,16 +277,26 @@ Ipv4Interface::Send (Ptr<Packet> p, Ipv4Address dest)
       if (found)
         {
           NS_LOG_LOGIC ("Address Resolved.  Send.");
-          m_device->Send (p, hardwareDestination,
-                          Ipv4L3Protocol::PROT_NUMBER);
+          SendToDevice (p, hardwareDestination);
         }
     }
   else
     {
       NS_LOG_LOGIC ("Doesn't need ARP");
-      m_device->Send (p, m_device->GetBroadcast (), 
-                      Ipv4L3Protocol::PROT_NUMBER);
+      SendToDevice (p, m_device->GetBroadcast ());
+    }
+}
+
+void
+Ipv4Interface::SendToDevice (Ptr<Packet> p, const Address &dest)
+{
+  NS_LOG_FUNCTION (this << p << dest);
+  if (m_tc != 0 && m_tc->GetRootQueueDiscOnDevice (m_device) != 0)
+    {
+      m_tc->Send (m_device, Create<Ipv4QueueDiscItem> (p, dest, Ipv4L3Protocol::PROT_NUMBER));
+      return;
     }
+  m_device->Send (p, dest, Ipv4L3Protocol::PROT_NUMBER);
 }
 
 uint32_t
@@ -34,6 +34,8 @@ class NetDevice;
 class Packet;
 class Node;
 class ArpCache;
+class TrafficControlLayer;
+class Address;
 
 /**
  * \brief The IPv4 representation of a network interface
@@ -186,6 +188,13 @@ private:
    */
   void DoSetup (void);
 
+  /**
+   * \brief Send a packet to the device, through its root queue disc if any.
+   * \param p packet to send
+   * \param dest the hardware destination address
+   */
+  void SendToDevice (Ptr<Packet> p, const Address &dest);
+
 
   /**
    * \brief Container for the Ipv4InterfaceAddresses.
@@ -211,6 +220,7 @@ private:
   Ptr<Node> m_node; //!< The associated node
   Ptr<NetDevice> m_device; //!< The associated NetDevice
   Ptr<ArpCache> m_cache; //!< ARP cache
+  Ptr<TrafficControlLayer> m_tc; //!< The traffic control layer of the node
 };
 
 } // namespace ns3
@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string.h>
+#include "ns3/hash.h"
+#include "ipv4-header.h"
+#include "ipv4-queue-disc-item.h"
+
+namespace ns3 {
+
+Ipv4QueueDiscItem::Ipv4QueueDiscItem (Ptr<Packet> p, const Address &addr, uint16_t protocol)
+  : QueueDiscItem (p, addr, protocol)
+{
+}
+
+Ipv4QueueDiscItem::~Ipv4QueueDiscItem ()
+{
+}
+
+uint32_t
+Ipv4QueueDiscItem::Hash (uint32_t perturbation) const
+{
+  Ptr<Packet> p = GetPacket ();
+  Ipv4Header header;
+  p->PeekHeader (header);
+  uint32_t headerSize = header.GetSerializedSize ();
+  uint8_t protocol = header.GetProtocol ();
+
+  // addresses (8), protocol (1), ports (4), perturbation (4)
+  uint8_t buf[17];
+  memset (buf, 0, sizeof (buf));
+  header.GetSource ().Serialize (buf);
+  header.GetDestination ().Serialize (buf + 4);
+  buf[8] = protocol;
+
+  // the fragments other than the first have no ports: hash all the
+  // fragments of a packet without ports, so that they stay together
+  if ((protocol == 6 || protocol == 17)
+      && header.IsLastFragment () && header.GetFragmentOffset () == 0
+      && p->GetSize () >= headerSize + 4)
+    {
+      uint8_t data[64];
+      p->CopyData (data, headerSize + 4);
+      memcpy (buf + 9, data + headerSize, 4);
+    }
+  memcpy (buf + 13, &perturbation, 4);
+
+  return Hash32 (reinterpret_cast<char *> (buf), sizeof (buf));
+}
+
+bool
+Ipv4QueueDiscItem::Mark (void)
+{
+  Ptr<Packet> p = GetPacket ();
+  Ipv4Header header;
+  p->PeekHeader (header);
+  if (header.GetEcn () == Ipv4Header::ECN_NotECT)
+    {
+      return false;
+    }
+  if (header.GetEcn () != Ipv4Header::ECN_CE)
+    {
+      p->RemoveHeader (header);
+      header.SetEcn (Ipv4Header::ECN_CE);
+      p->AddHeader (header);
+    }
+  return true;
+}
+
+} // namespace ns3
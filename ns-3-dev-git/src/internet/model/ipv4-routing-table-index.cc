@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ipv4-routing-table-index.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4RoutingTableIndex");
+
+Ipv4RoutingTableIndex::Ipv4RoutingTableIndex ()
+  : m_nRoutes (0),
+    m_sorted (true)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+Ipv4RoutingTableIndex::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_groups.clear ();
+  m_nRoutes = 0;
+  m_sorted = true;
+}
+
+void
+Ipv4RoutingTableIndex::Add (Ipv4Address network, Ipv4Mask mask)
+{
+  NS_LOG_FUNCTION (this << network << mask);
+  std::vector<Group>::iterator group = m_groups.begin ();
+  while (group != m_groups.end () && group->mask != mask.Get ())
+    {
+      group++;
+    }
+  if (group == m_groups.end ())
+    {
+      m_groups.push_back (Group ());
+      group = m_groups.end () - 1;
+      group->mask = mask.Get ();
+    }
+  Entry entry;
+  entry.network = network.Get () & mask.Get ();
+  entry.position = m_nRoutes++;
+  group->entries.push_back (entry);
+  m_sorted = false;
+}
+
+void
+Ipv4RoutingTableIndex::Lookup (Ipv4Address dest, std::vector<uint32_t> &positions)
+{
+  NS_LOG_FUNCTION (this << dest);
+  if (!m_sorted)
+    {
+      for (std::vector<Group>::iterator group = m_groups.begin (); group != m_groups.end (); group++)
+        {
+          std::sort (group->entries.begin (), group->entries.end ());
+        }
+      m_sorted = true;
+    }
+  positions.clear ();
+  uint32_t nGroups = 0;
+  for (std::vector<Group>::const_iterator group = m_groups.begin (); group != m_groups.end (); group++)
+    {
+      Entry first;
+      first.network = dest.Get () & group->mask;
+      first.position = 0;
+      std::vector<Entry>::const_iterator i = std::lower_bound (group->entries.begin (), group->entries.end (), first);
+      if (i == group->entries.end () || i->network != first.network)
+        {
+          continue;
+        }
+      for (; i != group->entries.end () && i->network == first.network; i++)
+        {
+          positions.push_back (i->position);
+        }
+      nGroups++;
+    }
+  if (nGroups > 1)
+    {
+      std::sort (positions.begin (), positions.end ());
+    }
+}
+
+uint32_t
+Ipv4RoutingTableIndex::GetN (void) const
+{
+  return m_nRoutes;
+}
+
+} // namespace ns3
@@ -54,7 +54,8 @@ Ipv4StaticRouting::GetTypeId (void)
 }
 
 Ipv4StaticRouting::Ipv4StaticRouting () 
-  : m_ipv4 (0)
+  : m_indexValid (false),
+    m_ipv4 (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -73,6 +74,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_indexValid = false;
 }
 
 void 
@@ -87,6 +89,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (make_pair (route,metric));
+  m_indexValid = false;
 }
 
 void 
@@ -144,6 +147,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_indexValid = false;
 }
 
 uint32_t 
@@ -239,52 +243,59 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
       return rtentry;
     }
 
+  if (!m_indexValid)
+    {
+      IndexRoutes ();
+    }
 
-  for (NetworkRoutesI i = m_networkRoutes.begin (); 
-       i != m_networkRoutes.end (); 
+  // only the matching routes, in the order of the forwarding table
+  std::vector<uint32_t> positions;
+  m_index.Lookup (dest, positions);
+  Ipv4RoutingTableEntry *best = 0;
+  for (std::vector<uint32_t>::const_iterator i = positions.begin (); 
+       i != positions.end (); 
        i++) 
     {
-      Ipv4RoutingTableEntry *j=i->first;
-      uint32_t metric =i->second;
+      Ipv4RoutingTableEntry *j = m_indexedRoutes[*i].first;
+      uint32_t metric = m_indexedRoutes[*i].second;
       Ipv4Mask mask = (j)->GetDestNetworkMask ();
       uint16_t masklen = mask.GetPrefixLength ();
-      Ipv4Address entry = (j)->GetDestNetwork ();
-      NS_LOG_LOGIC ("Searching for route to " << dest << ", checking against route to " << entry << "/" << masklen);
-      if (mask.IsMatch (dest, entry)) 
+      NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
+      if (oif != 0)
         {
-          NS_LOG_LOGIC ("Found global network route " << j << ", mask length " << masklen << ", metric " << metric);
-          if (oif != 0)
-            {
-              if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
-            }
-          if (masklen < longest_mask) // Not interested if got shorter mask
-            {
-              NS_LOG_LOGIC ("Previous match longer, skipping");
-              continue;
-            }
-          if (masklen > longest_mask) // Reset metric if longer masklen
+          if (oif != m_ipv4->GetNetDevice (j->GetInterface ()))
             {
-              shortest_metric = 0xffffffff;
-            }
-          longest_mask = masklen;
-          if (metric > shortest_metric)
-            {
-              NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
               continue;
             }
-          shortest_metric = metric;
-          Ipv4RoutingTableEntry* route = (j);
-          uint32_t interfaceIdx = route->GetInterface ();
-          rtentry = Create<Ipv4Route> ();
-          rtentry->SetDestination (route->GetDest ());
-          rtentry->SetSource (SourceAddressSelection (interfaceIdx, route->GetDest ()));
-          rtentry->SetGateway (route->GetGateway ());
-          rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
         }
+      if (masklen < longest_mask) // Not interested if got shorter mask
+        {
+          NS_LOG_LOGIC ("Previous match longer, skipping");
+          continue;
+        }
+      if (masklen > longest_mask) // Reset metric if longer masklen
+        {
+          shortest_metric = 0xffffffff;
+        }
+      longest_mask = masklen;
+      if (metric > shortest_metric)
+        {
+          NS_LOG_LOGIC ("Equal mask length, but previous metric shorter, skipping");
+          continue;
+        }
+      shortest_metric = metric;
+      best = j;
+    }
+  if (best != 0)
+    {
+      Ipv4RoutingTableEntry* route = best;
+      uint32_t interfaceIdx = route->GetInterface ();
+      rtentry = Create<Ipv4Route> ();
+      rtentry->SetDestination (route->GetDest ());
+      rtentry->SetSource (SourceAddressSelection (interfaceIdx, route->GetDest ()));
+      rtentry->SetGateway (route->GetGateway ());
+      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
     }
   if (rtentry != 0)
     {
@@ -297,6 +308,21 @@ Ipv4StaticRouting::LookupStatic (Ipv4Address dest, Ptr<NetDevice> oif)
   return rtentry;
 }
 
+void
+Ipv4StaticRouting::IndexRoutes (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_indexedRoutes.assign (m_networkRoutes.begin (), m_networkRoutes.end ());
+  m_index.Clear ();
+  for (NetworkRoutesCI i = m_networkRoutes.begin (); 
+       i != m_networkRoutes.end (); 
+       i++) 
+    {
+      m_index.Add (i->first->GetDestNetwork (), i->first->GetDestNetworkMask ());
+    }
+  m_indexValid = true;
+}
+
 Ptr<Ipv4MulticastRoute>
 Ipv4StaticRouting::LookupStatic (
   Ipv4Address origin, 
@@ -445,6 +471,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
         {
           delete j->first;
           m_networkRoutes.erase (j);
+          m_indexValid = false;
           return;
         }
       tmp++;
@@ -593,6 +620,7 @@ Ipv4StaticRouting::DoDispose (void)
     {
       delete (j->first);
     }
+  m_indexValid = false;
   for (MulticastRoutesI i = m_multicastRoutes.begin (); 
        i != m_multicastRoutes.end (); 
        i = m_multicastRoutes.erase (i)) 
@@ -633,6 +661,7 @@ Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
         {
           delete it->first;
           it = m_networkRoutes.erase (it);
+          m_indexValid = false;
         }
       else
         {
@@ -680,6 +709,7 @@ Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress
         {
           delete it->first;
           it = m_networkRoutes.erase (it);
+          m_indexValid = false;
         }
       else
         {
@@ -24,6 +24,7 @@
 
 #include <list>
 #include <utility>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -31,6 +32,7 @@
 #include "ns3/ptr.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-routing-table-index.h"
 
 namespace ns3 {
 
@@ -425,11 +427,31 @@ private:
    */
   Ipv4Address SourceAddressSelection (uint32_t interface, Ipv4Address dest);
 
+  /**
+   * \brief Index the network routes, after a change of the forwarding table.
+   */
+  void IndexRoutes (void);
+
   /**
    * \brief the forwarding table for network.
    */
   NetworkRoutes m_networkRoutes;
 
+  /**
+   * \brief the network routes, by position in the forwarding table.
+   */
+  std::vector<std::pair <Ipv4RoutingTableEntry *, uint32_t> > m_indexedRoutes;
+
+  /**
+   * \brief index of the destinations of the network routes.
+   */
+  Ipv4RoutingTableIndex m_index;
+
+  /**
+   * \brief whether m_index matches the forwarding table.
+   */
+  bool m_indexValid;
+
   /**
    * \brief the forwarding table for multicast.
    */
@@ -18,6 +18,7 @@
  * Author: Sebastien Vincent <vincent@clarinet.u-strasbg.fr>
  */
 
+#include <algorithm>
 #include "ipv6-end-point-demux.h"
 #include "ipv6-end-point.h"
 #include "ns3/log.h"
@@ -26,10 +27,75 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv6EndPointDemux");
 
+/**
+ * \brief Mix a value into a hash, as boost::hash_combine does.
+ * \param hash the hash
+ * \param value the value
+ * \return the new hash
+ */
+static inline uint32_t
+HashCombine (uint32_t hash, uint32_t value)
+{
+  return hash ^ (value + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+/**
+ * \brief Mix an address into a hash.
+ * \param hash the hash
+ * \param address the address
+ * \return the new hash
+ */
+static uint32_t
+HashAddress (uint32_t hash, Ipv6Address address)
+{
+  uint8_t buf[16];
+  address.GetBytes (buf);
+  for (uint32_t i = 0; i < 16; i += 4)
+    {
+      hash = HashCombine (hash, (buf[i] << 24) | (buf[i + 1] << 16) | (buf[i + 2] << 8) | buf[i + 3]);
+    }
+  return hash;
+}
+
+/**
+ * \brief Check that an endpoint can receive the packets of an interface.
+ * \param endP the endpoint
+ * \param incomingInterface the incoming interface
+ * \return true if the endpoint can receive the packets
+ */
+static bool
+CanReceive (Ipv6EndPoint *endP, Ptr<Ipv6Interface> incomingInterface)
+{
+  if (!endP->IsRxEnabled ())
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                    << " because endpoint can not receive packets");
+      return false;
+    }
+
+  if (endP->GetBoundNetDevice ())
+    {
+      if (!incomingInterface)
+        {
+          return false;
+        }
+      if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+        {
+          NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                             << " because endpoint is bound to specific device and"
+                                             << endP->GetBoundNetDevice ()
+                                             << " does not match packet device " << incomingInterface->GetDevice ());
+          return false;
+        }
+    }
+  return true;
+}
+
 Ipv6EndPointDemux::Ipv6EndPointDemux ()
   : m_ephemeral (49152),
     m_portFirst (49152),
-    m_portLast (65535)
+    m_portLast (65535),
+    m_nConnections (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -40,6 +106,7 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
       Ipv6EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
@@ -48,19 +115,29 @@ Ipv6EndPointDemux::~Ipv6EndPointDemux ()
 bool Ipv6EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
-    {
-      if ((*i)->GetLocalPort  () == port)
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool Ipv6EndPointDemux::LookupLocal (Ipv6Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
+  std::map<uint16_t, Port>::iterator p = m_ports.find (port);
+  if (p == m_ports.end ())
+    {
+      return false;
+    }
+  for (EndPointsI i = p->second.wildcards.begin (); i != p->second.wildcards.end (); i++)
+    {
+      if ((*i)->GetLocalAddress () == addr)
+        {
+          return true;
+        }
+    }
+  if (p->second.nEndPoints == p->second.wildcards.size ())
+    {
+      return false;
+    }
+  /* some connections have the port, which is rare enough to walk them all */
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
     {
       if ((*i)->GetLocalPort () == port
@@ -82,7 +159,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate ()
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (Ipv6Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -97,7 +174,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -118,7 +195,7 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address address, uint16_t port)
       return 0;
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -127,21 +204,42 @@ Ipv6EndPoint* Ipv6EndPointDemux::Allocate (Ipv6Address localAddress, uint16_t lo
                                            Ipv6Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  EndPoints *candidates = 0;
+  if (localAddress != Ipv6Address::GetAny ()
+      && peerAddress != Ipv6Address::GetAny ()
+      && peerPort != 0)
+    {
+      if (m_nConnections > 0)
+        {
+          candidates = &GetConnections (localAddress, localPort, peerAddress, peerPort);
+        }
+    }
+  else
     {
-      if ((*i)->GetLocalPort () == localPort
-          && (*i)->GetLocalAddress () == localAddress
-          && (*i)->GetPeerPort () == peerPort
-          && (*i)->GetPeerAddress () == peerAddress)
+      std::map<uint16_t, Port>::iterator p = m_ports.find (localPort);
+      if (p != m_ports.end ())
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          candidates = &p->second.wildcards;
+        }
+    }
+  if (candidates != 0)
+    {
+      for (EndPointsI i = candidates->begin (); i != candidates->end (); i++)
+        {
+          if ((*i)->GetLocalPort () == localPort
+              && (*i)->GetLocalAddress () == localAddress
+              && (*i)->GetPeerPort () == peerPort
+              && (*i)->GetPeerAddress () == peerAddress)
+            {
+              NS_LOG_WARN ("No way we can allocate this end-point.");
+              /* no way we can allocate this end-point. */
+              return 0;
+            }
         }
     }
   Ipv6EndPoint *endPoint = new Ipv6EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -155,6 +253,8 @@ void Ipv6EndPointDemux::DeAllocate (Ipv6EndPoint *endPoint)
     {
       if (*i == endPoint)
         {
+          Unindex (endPoint);
+          endPoint->m_demux = 0;
           delete endPoint;
           m_endPoints.erase (i);
           break;
@@ -179,7 +279,37 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
   EndPoints retval4; /* Exact match on all 4 */
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  std::map<uint16_t, Port>::iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      NS_LOG_LOGIC ("No endpoint with dport " << dport);
+      return retval1;
+    }
+
+  /* A connected endpoint can only match exactly, and no endpoint with a
+     wildcard can then match exactly, as the packet has none. */
+  if (port->second.nEndPoints > port->second.wildcards.size ())
+    {
+      EndPoints &connections = GetConnections (daddr, dport, saddr, sport);
+      for (EndPointsI i = connections.begin (); i != connections.end (); i++)
+        {
+          Ipv6EndPoint* endP = *i;
+          if (endP->GetLocalPort () == dport
+              && endP->GetLocalAddress () == daddr
+              && endP->GetPeerPort () == sport
+              && endP->GetPeerAddress () == saddr
+              && CanReceive (endP, incomingInterface))
+            {
+              retval4.push_back (endP);
+            }
+        }
+      if (!retval4.empty ())
+        {
+          return retval4;
+        }
+    }
+
+  for (EndPointsI i = port->second.wildcards.begin (); i != port->second.wildcards.end (); i++)
     {
       Ipv6EndPoint* endP = *i;
 
@@ -188,38 +318,11 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
                                                  << " sport=" << endP->GetPeerPort ()
                                                  << " saddr=" << endP->GetPeerAddress ());
 
-      if (!endP->IsRxEnabled ())
+      if (!CanReceive (endP, incomingInterface))
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                        << " because endpoint can not receive packets");
           continue;
         }
 
-      if (endP->GetLocalPort () != dport)
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
-
-      if (endP->GetBoundNetDevice ())
-        {
-          if (!incomingInterface)
-            {
-              continue;
-            }
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
-            {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
-              continue;
-            }
-        }
-
       /*    Ipv6Address incomingInterfaceAddr = incomingInterface->GetAddress (); */
       NS_LOG_DEBUG ("dest addr " << daddr);
 
@@ -293,6 +396,25 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::Lookup (Ipv6Address daddr, uint1
 
 Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport, Ipv6Address src, uint16_t sport)
 {
+  std::map<uint16_t, Port>::iterator port = m_ports.find (dport);
+  if (port == m_ports.end ())
+    {
+      return 0;
+    }
+  if (port->second.nEndPoints > port->second.wildcards.size ())
+    {
+      EndPoints &connections = GetConnections (dst, dport, src, sport);
+      for (EndPointsI i = connections.begin (); i != connections.end (); i++)
+        {
+          if ((*i)->GetLocalPort () == dport && (*i)->GetLocalAddress () == dst
+              && (*i)->GetPeerPort () == sport && (*i)->GetPeerAddress () == src)
+            {
+              /* this is an exact match. */
+              return *i;
+            }
+        }
+    }
+
   uint32_t genericity = 3;
   Ipv6EndPoint *generic = 0;
 
@@ -334,23 +456,48 @@ Ipv6EndPoint* Ipv6EndPointDemux::SimpleLookup (Ipv6Address dst, uint16_t dport,
 uint16_t Ipv6EndPointDemux::AllocateEphemeralPort ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint16_t port = m_ephemeral;
-  int count = m_portLast - m_portFirst;
-  do
+  uint32_t nPorts = m_portLast - m_portFirst + 1;
+  if (m_ephemeralInUse.empty ())
+    {
+      m_ephemeralInUse.resize ((nPorts + 31) / 32, 0);
+      for (std::map<uint16_t, Port>::iterator i = m_ports.lower_bound (m_portFirst);
+           i != m_ports.end () && i->first <= m_portLast; i++)
+        {
+          MarkEphemeralPort (i->first, true);
+        }
+    }
+  /* the port following the last one allocated */
+  uint32_t index = 0;
+  if (m_ephemeral >= m_portFirst && m_ephemeral < m_portLast)
     {
-      if (count-- < 0)
+      index = m_ephemeral - m_portFirst + 1;
+    }
+  uint32_t count = 0;
+  while (count < nPorts)
+    {
+      uint32_t word = m_ephemeralInUse[index / 32];
+      if (index % 32 == 0 && word == 0xffffffff && index + 32 <= nPorts)
+        {
+          /* 32 ports in use */
+          count += 32;
+          index += 32;
+        }
+      else if ((word & (1U << (index % 32))) == 0)
         {
-          return 0;
+          m_ephemeral = m_portFirst + index;
+          return m_ephemeral;
         }
-      ++port;
-      if (port < m_portFirst || port > m_portLast)
+      else
         {
-          port = m_portFirst;
+          count++;
+          index++;
+        }
+      if (index == nPorts)
+        {
+          index = 0;
         }
     }
-  while (LookupPortLocal (port));
-  m_ephemeral = port;
-  return port;
+  return 0;
 }
 
 Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
@@ -358,5 +505,106 @@ Ipv6EndPointDemux::EndPoints Ipv6EndPointDemux::GetEndPoints () const
   return m_endPoints;
 }
 
+void Ipv6EndPointDemux::Insert (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+}
+
+void Ipv6EndPointDemux::Index (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Port &port = m_ports[endPoint->GetLocalPort ()];
+  if (port.nEndPoints++ == 0)
+    {
+      MarkEphemeralPort (endPoint->GetLocalPort (), true);
+    }
+  if (!IsConnected (endPoint))
+    {
+      port.wildcards.push_back (endPoint);
+      return;
+    }
+  if (m_nConnections >= m_connections.size ())
+    {
+      ResizeConnections (std::max<uint32_t> (16, 2 * m_connections.size ()));
+    }
+  GetConnections (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                  endPoint->GetPeerAddress (), endPoint->GetPeerPort ()).push_back (endPoint);
+  m_nConnections++;
+}
+
+void Ipv6EndPointDemux::Unindex (Ipv6EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  std::map<uint16_t, Port>::iterator port = m_ports.find (endPoint->GetLocalPort ());
+  NS_ASSERT (port != m_ports.end ());
+  EndPoints &endPoints = IsConnected (endPoint) ?
+    GetConnections (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                    endPoint->GetPeerAddress (), endPoint->GetPeerPort ()) :
+    port->second.wildcards;
+  EndPointsI i = std::find (endPoints.begin (), endPoints.end (), endPoint);
+  NS_ASSERT (i != endPoints.end ());
+  endPoints.erase (i);
+  if (IsConnected (endPoint))
+    {
+      m_nConnections--;
+    }
+  if (--port->second.nEndPoints == 0)
+    {
+      MarkEphemeralPort (endPoint->GetLocalPort (), false);
+      m_ports.erase (port);
+    }
+}
+
+Ipv6EndPointDemux::EndPoints &
+Ipv6EndPointDemux::GetConnections (Ipv6Address localAddress, uint16_t localPort,
+                                   Ipv6Address peerAddress, uint16_t peerPort)
+{
+  uint32_t hash = HashAddress ((static_cast<uint32_t> (localPort) << 16) | peerPort, localAddress);
+  hash = HashAddress (hash, peerAddress);
+  return m_connections[hash & (m_connections.size () - 1)];
+}
+
+void Ipv6EndPointDemux::ResizeConnections (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  std::vector<EndPoints> old (size);
+  old.swap (m_connections);
+  for (std::vector<EndPoints>::iterator i = old.begin (); i != old.end (); i++)
+    {
+      for (EndPointsI j = i->begin (); j != i->end (); j++)
+        {
+          GetConnections ((*j)->GetLocalAddress (), (*j)->GetLocalPort (),
+                          (*j)->GetPeerAddress (), (*j)->GetPeerPort ()).push_back (*j);
+        }
+    }
+}
+
+void Ipv6EndPointDemux::MarkEphemeralPort (uint16_t port, bool inUse)
+{
+  if (m_ephemeralInUse.empty () || port < m_portFirst || port > m_portLast)
+    {
+      return;
+    }
+  uint32_t index = port - m_portFirst;
+  if (inUse)
+    {
+      m_ephemeralInUse[index / 32] |= 1U << (index % 32);
+    }
+  else
+    {
+      m_ephemeralInUse[index / 32] &= ~(1U << (index % 32));
+    }
+}
+
+bool Ipv6EndPointDemux::IsConnected (Ipv6EndPoint *endPoint)
+{
+  return endPoint->GetLocalAddress () != Ipv6Address::GetAny ()
+         && endPoint->GetPeerAddress () != Ipv6Address::GetAny ()
+         && endPoint->GetPeerPort () != 0;
+}
+
 } /* namespace ns3 */
 
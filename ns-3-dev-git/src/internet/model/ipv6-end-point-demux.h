@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv6-address.h"
 #include "ipv6-interface.h"
 
@@ -33,6 +35,10 @@ class Ipv6EndPoint;
 /**
  * \class Ipv6EndPointDemux
  * \brief Demultiplexor for end points.
+ *
+ * The connected endpoints, whose four-tuple is fully specified, are kept
+ * in a hash table, and the others in a list per local port.  A bitmap of
+ * the ephemeral ports in use speeds up their allocation.
  */
 class Ipv6EndPointDemux
 {
@@ -146,12 +152,79 @@ public:
   EndPoints GetEndPoints () const;
 
 private:
+  friend class Ipv6EndPoint;
+
+  /**
+   * \brief The endpoints with a local port.
+   */
+  struct Port
+  {
+    Port () : nEndPoints (0) {}
+    uint32_t nEndPoints; //!< Number of endpoints with the port
+    EndPoints wildcards; //!< The endpoints not in the connection table
+  };
+
   /**
    * \brief Allocate a ephemeral port.
    * \return a port
    */
   uint16_t AllocateEphemeralPort ();
 
+  /**
+   * \brief Add an endpoint to the demux.
+   * \param endPoint the new endpoint
+   */
+  void Insert (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the lookup tables.
+   *
+   * Called by the endpoint after a change of its addresses or ports.
+   *
+   * \param endPoint the endpoint
+   */
+  void Index (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the lookup tables.
+   *
+   * Called by the endpoint before a change of its addresses or ports.
+   *
+   * \param endPoint the endpoint
+   */
+  void Unindex (Ipv6EndPoint *endPoint);
+
+  /**
+   * \brief Get the bucket of the connection table of a four-tuple.
+   * \param localAddress local address
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return the endpoints which may have the four-tuple
+   */
+  EndPoints &GetConnections (Ipv6Address localAddress, uint16_t localPort,
+                             Ipv6Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Resize the connection table.
+   * \param size the new number of buckets, a power of two
+   */
+  void ResizeConnections (uint32_t size);
+
+  /**
+   * \brief Update the bitmap of the ephemeral ports in use.
+   * \param port the port
+   * \param inUse true if the first endpoint with the port was added,
+   * false if the last one was removed
+   */
+  void MarkEphemeralPort (uint16_t port, bool inUse);
+
+  /**
+   * \param endPoint an endpoint
+   * \return true if the four-tuple of the endpoint has no wildcard
+   */
+  static bool IsConnected (Ipv6EndPoint *endPoint);
+
   /**
    * \brief The ephemeral port.
    */
@@ -171,6 +244,27 @@ private:
    * \brief A list of IPv6 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The endpoints indexed by local port.
+   */
+  std::map<uint16_t, Port> m_ports;
+
+  /**
+   * \brief The connected endpoints, hashed on their four-tuple.
+   */
+  std::vector<EndPoints> m_connections;
+
+  /**
+   * \brief The number of endpoints in m_connections.
+   */
+  uint32_t m_nConnections;
+
+  /**
+   * \brief One bit per ephemeral port, set when the port is in use.
+   * Empty until the first ephemeral port allocation.
+   */
+  std::vector<uint32_t> m_ephemeralInUse;
 };
 
 } /* namespace ns3 */
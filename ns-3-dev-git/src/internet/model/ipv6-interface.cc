@@ -30,6 +30,8 @@
 #include "ipv6-l3-protocol.h"
 #include "icmpv6-l4-protocol.h"
 #include "ndisc-cache.h"
+#include "ipv6-queue-disc-item.h"
+#include "ns3/traffic-control-layer.h"
 
 namespace ns3
 {
@@ -73,6 +75,7 @@ void Ipv6Interface::DoDispose ()
   m_node = 0;
   m_device = 0;
   m_ndCache = 0;
+  m_tc = 0;
   Object::DoDispose ();
 }
 
@@ -85,6 +88,8 @@ void Ipv6Interface::DoSetup ()
       return;
     }
 
+  m_tc = m_node->GetObject<TrafficControlLayer> ();
+
   /* set up link-local address */
   if (!DynamicCast<LoopbackNetDevice> (m_device)) /* no autoconf for ip6-localhost */
     {
@@ -419,14 +424,25 @@ void Ipv6Interface::Send (Ptr<Packet> p, Ipv6Address dest)
       if (found)
         {
           NS_LOG_LOGIC ("Address Resolved.  Send.");
-          m_device->Send (p, hardwareDestination, Ipv6L3Protocol::PROT_NUMBER);
+          SendToDevice (p, hardwareDestination);
         }
     }
   else
     {
       NS_LOG_LOGIC ("Doesn't need ARP");
-      m_device->Send (p, m_device->GetBroadcast (), Ipv6L3Protocol::PROT_NUMBER);
+      SendToDevice (p, m_device->GetBroadcast ());
+    }
+}
+
+void Ipv6Interface::SendToDevice (Ptr<Packet> p, const Address &dest)
+{
+  NS_LOG_FUNCTION (this << p << dest);
+  if (m_tc != 0 && m_tc->GetRootQueueDiscOnDevice (m_device) != 0)
+    {
+      m_tc->Send (m_device, Create<Ipv6QueueDiscItem> (p, dest, Ipv6L3Protocol::PROT_NUMBER));
+      return;
     }
+  m_device->Send (p, dest, Ipv6L3Protocol::PROT_NUMBER);
 }
 
 void Ipv6Interface::SetCurHopLimit (uint8_t curHopLimit)
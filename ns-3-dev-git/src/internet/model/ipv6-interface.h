@@ -36,6 +36,8 @@ class NetDevice;
 class Packet;
 class Node;
 class NdiscCache;
+class Address;
+class TrafficControlLayer;
 
 /**
  * \class Ipv6Interface
@@ -283,6 +285,13 @@ private:
    */
   void DoSetup ();
 
+  /**
+   * \brief Send a packet to the device, through its root queue disc if any.
+   * \param p packet to send
+   * \param dest the hardware destination address
+   */
+  void SendToDevice (Ptr<Packet> p, const Address &dest);
+
   /**
    * \brief The addresses assigned to this interface.
    */
@@ -318,6 +327,11 @@ private:
    */
   Ptr<NdiscCache> m_ndCache;
 
+  /**
+   * \brief The traffic control layer of the node.
+   */
+  Ptr<TrafficControlLayer> m_tc;
+
   /**
    * \brief Current hop limit.
    */
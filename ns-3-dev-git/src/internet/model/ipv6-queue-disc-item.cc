@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string.h>
+#include "ns3/hash.h"
+#include "ipv6-header.h"
+#include "ipv6-queue-disc-item.h"
+
+namespace ns3 {
+
+Ipv6QueueDiscItem::Ipv6QueueDiscItem (Ptr<Packet> p, const Address &addr, uint16_t protocol)
+  : QueueDiscItem (p, addr, protocol)
+{
+}
+
+Ipv6QueueDiscItem::~Ipv6QueueDiscItem ()
+{
+}
+
+uint32_t
+Ipv6QueueDiscItem::Hash (uint32_t perturbation) const
+{
+  Ptr<Packet> p = GetPacket ();
+  Ipv6Header header;
+  p->PeekHeader (header);
+  uint32_t headerSize = header.GetSerializedSize ();
+  uint8_t nextHeader = header.GetNextHeader ();
+
+  // addresses (32), next header (1), ports (4), perturbation (4)
+  uint8_t buf[41];
+  memset (buf, 0, sizeof (buf));
+  header.GetSourceAddress ().Serialize (buf);
+  header.GetDestinationAddress ().Serialize (buf + 16);
+  buf[32] = nextHeader;
+
+  // the ports follow the header only without extension headers; the
+  // fragments have a fragment header and are hashed without ports
+  if ((nextHeader == 6 || nextHeader == 17) && p->GetSize () >= headerSize + 4)
+    {
+      uint8_t data[64];
+      p->CopyData (data, headerSize + 4);
+      memcpy (buf + 33, data + headerSize, 4);
+    }
+  memcpy (buf + 37, &perturbation, 4);
+
+  return Hash32 (reinterpret_cast<char *> (buf), sizeof (buf));
+}
+
+bool
+Ipv6QueueDiscItem::Mark (void)
+{
+  Ptr<Packet> p = GetPacket ();
+  Ipv6Header header;
+  p->PeekHeader (header);
+  // the ECN field is made of the two low bits of the traffic class
+  uint8_t tclass = header.GetTrafficClass ();
+  if ((tclass & 0x03) == 0)
+    {
+      return false;
+    }
+  if ((tclass & 0x03) != 0x03)
+    {
+      p->RemoveHeader (header);
+      header.SetTrafficClass (tclass | 0x03);
+      p->AddHeader (header);
+    }
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,50 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef IPV6_QUEUE_DISC_ITEM_H
+#define IPV6_QUEUE_DISC_ITEM_H
+
+#include "ns3/queue-disc.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv6
+ *
+ * \brief An IPv6 packet held by a queue disc.
+ *
+ * The packet starts with its IPv6 header.  The flow of the packet is
+ * given by its addresses and next header, and by its ports if it is a TCP
+ * or UDP packet without extension headers.
+ */
+class Ipv6QueueDiscItem : public QueueDiscItem
+{
+public:
+  /**
+   * \param p the packet, with its IPv6 header
+   * \param addr the destination address
+   * \param protocol the protocol number
+   */
+  Ipv6QueueDiscItem (Ptr<Packet> p, const Address &addr, uint16_t protocol);
+  virtual ~Ipv6QueueDiscItem ();
+
+  virtual uint32_t Hash (uint32_t perturbation) const;
+  virtual bool Mark (void);
+};
+
+} // namespace ns3
+
+#endif /* IPV6_QUEUE_DISC_ITEM_H */
@@ -19,6 +19,9 @@
 #include "tcp-congestion-ops.h"
 #include "tcp-socket-base.h"
 #include "ns3/log.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
 
 static unsigned int dctcp_shift_g = 4; /* g = 1/2^4 */
 static unsigned int dctcp_alpha_on_init = 0;
@@ -56,6 +59,83 @@ TcpCongestionOps::~TcpCongestionOps ()
 {
 }
 
+void
+TcpCongestionOps::UpdatePacingRate (Ptr<TcpSocketState> tcb)
+{
+  NS_LOG_FUNCTION (this << tcb);
+
+  if (tcb->m_srtt.IsZero ())
+    {
+      return;
+    }
+
+  uint16_t ratio = (tcb->m_cWnd < tcb->m_ssThresh / 2) ? tcb->m_pacingSsRatio
+                                                       : tcb->m_pacingCaRatio;
+  double rate = static_cast<double> (tcb->m_cWnd) * 8 * ratio / 100
+    / tcb->m_srtt.GetSeconds ();
+  DataRate pacingRate (static_cast<uint64_t> (rate));
+
+  tcb->m_pacingRate = std::min (pacingRate, tcb->m_maxPacingRate);
+  NS_LOG_DEBUG ("Pacing rate set to " << tcb->m_pacingRate);
+}
+
+void
+TcpCongestionOps::IncreaseWindowCumulative (Ptr<TcpSocketState> tcb,
+                                            uint32_t segmentsAcked, uint32_t acks)
+{
+  NS_LOG_FUNCTION (this << tcb << segmentsAcked << acks);
+
+  for (uint32_t i = 0; i < acks; ++i)
+    {
+      IncreaseWindow (tcb, segmentsAcked / acks + (i < segmentsAcked % acks ? 1 : 0));
+    }
+}
+
+void
+TcpCongestionOps::CwndEvent (Ptr<TcpSocketState> tcb, TcpCAEvent_t event)
+{
+  NS_LOG_FUNCTION (this << tcb << event);
+
+  if (event == CA_EVENT_ECN_IS_CE)
+    {
+      tcb->m_ecnEcho = true;
+    }
+}
+
+bool
+TcpCongestionOps::NeedsEcn (void) const
+{
+  return false;
+}
+
+const uint32_t TcpCongestionOps::DCTCP_MAX_ALPHA;
+
+uint32_t
+TcpCongestionOps::DctcpUpdateAlpha (uint32_t alpha, uint32_t marked,
+                                    uint32_t total, uint32_t shiftG)
+{
+  /* alpha = (1 - g) * alpha + g * F */
+  if (alpha > (uint32_t) (1 << shiftG))
+    {
+      alpha -= alpha >> shiftG;
+    }
+  else
+    {
+      alpha = 0; // otherwise, alpha can never reach zero
+    }
+
+  if (marked)
+    {
+      /* If shift_g == 1, a 32bit value would overflow after 8 M. */
+      uint64_t fraction = static_cast<uint64_t> (marked) << (10 - shiftG);
+      fraction /= std::max (1U, total);
+
+      alpha = static_cast<uint32_t> (std::min (alpha + fraction,
+                                               static_cast<uint64_t> (DCTCP_MAX_ALPHA)));
+    }
+  return alpha;
+}
+
 
 // RENO
 
@@ -78,7 +158,8 @@ TcpNewReno::TcpNewReno (void) : TcpCongestionOps ()
 }
 
 TcpNewReno::TcpNewReno (const TcpNewReno& sock)
-  : TcpCongestionOps (sock)
+  : TcpCongestionOps (sock),
+    m_cumulativeState (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -202,6 +283,54 @@ TcpNewReno::IncreaseWindow (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked)
    */
 }
 
+/**
+ * \brief Apply the NewReno window growth of a batch of ACKs in one step
+ *
+ * Each ACK of the batch grows the window through IncreaseWindow, and so
+ * through the SlowStart and CongestionAvoidance of the subclasses, but on
+ * an untraced scratch state: cWnd and ssThresh are written (and traced)
+ * only once. The scratch state is allocated with the first batch and
+ * reused by the next ones.
+ *
+ * \param tcb internal congestion state
+ * \param segmentsAcked count of segments acked by the whole batch
+ * \param acks count of ACKs in the batch
+ */
+void
+TcpNewReno::IncreaseWindowCumulative (Ptr<TcpSocketState> tcb,
+                                      uint32_t segmentsAcked, uint32_t acks)
+{
+  NS_LOG_FUNCTION (this << tcb << segmentsAcked << acks);
+
+  Ptr<TcpSocketState> state = m_cumulativeState;
+  if (state == 0)
+    {
+      // The copy of a TracedValue does not copy its callbacks
+      state = CopyObject (tcb);
+      m_cumulativeState = state;
+    }
+  else
+    {
+      state->m_cWnd = tcb->m_cWnd.Get ();
+      state->m_ssThresh = tcb->m_ssThresh.Get ();
+      state->m_initialCWnd = tcb->m_initialCWnd;
+      state->m_initialSsThresh = tcb->m_initialSsThresh;
+      state->m_segmentSize = tcb->m_segmentSize;
+      state->m_congState = tcb->m_congState.Get ();
+      state->m_srtt = tcb->m_srtt;
+      state->m_ecnState = tcb->m_ecnState;
+    }
+  for (uint32_t i = 0; i < acks; ++i)
+    {
+      IncreaseWindow (state, segmentsAcked / acks + (i < segmentsAcked % acks ? 1 : 0));
+    }
+
+  tcb->m_cWnd = state->m_cWnd.Get ();
+  tcb->m_ssThresh = state->m_ssThresh.Get ();
+  NS_LOG_INFO ("After " << acks << " coalesced ACKs, updated to cwnd " << tcb->m_cWnd <<
+               " ssthresh " << tcb->m_ssThresh);
+}
+
 std::string
 TcpNewReno::GetName () const
 {
@@ -362,27 +491,8 @@ void
 TcpInigo::InigoUpdateRttAlpha() {
   NS_LOG_FUNCTION (this);
 
-  uint32_t alpha = this->rtt_alpha;
-  uint32_t marks = this->rtts_late;
-  uint32_t total = this->rtts_observed;
-
-  /* alpha = (1 - g) * alpha + g * F */
-  if (alpha > (uint32_t) (1 << dctcp_shift_g))
-    alpha -= alpha >> dctcp_shift_g;
-  else
-    alpha = 0; // otherwise, alpha can never reach zero                                                                       
-
-  if (marks) {
-    /* If shift_g == 1, a 32bit value would overflow                                                                          
-     * after 8 M.                                                                                                             
-     */
-    marks <<= (10 - dctcp_shift_g);
-    marks = marks/std::max(1U, total);
-
-    alpha = std::min(alpha + (uint32_t)marks, DCTCP_MAX_ALPHA);
-  }
-
-  this->rtt_alpha = alpha;
+  this->rtt_alpha = DctcpUpdateAlpha (this->rtt_alpha, this->rtts_late,
+                                      this->rtts_observed, dctcp_shift_g);
 
   NS_LOG_INFO ("In UpdateRttAlpha, updated alpha " << this->rtt_alpha);
 }
@@ -481,4 +591,153 @@ TcpInigo::InigoSlowStart (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked)
   return segmentsAcked;
 }
 
+// DCTCP
+
+NS_OBJECT_ENSURE_REGISTERED (TcpDctcp);
+
+TypeId
+TcpDctcp::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpDctcp")
+    .SetParent<TcpNewReno> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpDctcp> ()
+    .AddAttribute ("ShiftG",
+                   "Weight of the last window in alpha, as a power of 2 (g = 1 / 2^ShiftG)",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&TcpDctcp::m_shiftG),
+                   MakeUintegerChecker<uint32_t> (1, 10))
+    .AddAttribute ("AlphaOnInit",
+                   "Initial alpha, 1024 standing for 1",
+                   UintegerValue (TcpCongestionOps::DCTCP_MAX_ALPHA),
+                   MakeUintegerAccessor (&TcpDctcp::m_alpha),
+                   MakeUintegerChecker<uint32_t> (0, TcpCongestionOps::DCTCP_MAX_ALPHA))
+  ;
+  return tid;
+}
+
+TcpDctcp::TcpDctcp (void)
+  : TcpNewReno (),
+    m_alpha (DCTCP_MAX_ALPHA),
+    m_shiftG (4),
+    m_ackedBytesEcn (0),
+    m_ackedBytesTotal (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpDctcp::TcpDctcp (const TcpDctcp& sock)
+  : TcpNewReno (sock),
+    m_alpha (sock.m_alpha),
+    m_shiftG (sock.m_shiftG),
+    m_ackedBytesEcn (sock.m_ackedBytesEcn),
+    m_ackedBytesTotal (sock.m_ackedBytesTotal)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpDctcp::~TcpDctcp (void)
+{
+}
+
+std::string
+TcpDctcp::GetName () const
+{
+  return "TcpDctcp";
+}
+
+uint32_t
+TcpDctcp::GetAlpha (void) const
+{
+  return m_alpha;
+}
+
+/**
+ * \brief Reduce cWnd in proportion to the fraction of marked bytes
+ *
+ * cWnd becomes cWnd * (1 - alpha / 2), as in Linux:
+ * \verbatim
+static u32 dctcp_ssthresh(struct sock *sk)
+  {
+    ...
+    return max(tp->snd_cwnd - ((tp->snd_cwnd * ca->dctcp_alpha) >> 11U), 2U);
+  }
+  \endverbatim
+ *
+ * \param tcb internal congestion state
+ * \param bytesInFlight total bytes in flight
+ * \return Slow start threshold
+ */
+uint32_t
+TcpDctcp::GetSsThresh (Ptr<const TcpSocketState> tcb, uint32_t bytesInFlight)
+{
+  NS_LOG_FUNCTION (this << tcb << bytesInFlight);
+
+  uint32_t cWnd = tcb->m_cWnd;
+  uint32_t reduction = static_cast<uint32_t> ((static_cast<uint64_t> (cWnd) * m_alpha) >> 11U);
+  return std::max (cWnd - reduction, 2 * tcb->m_segmentSize);
+}
+
+/**
+ * \brief Echo on the ACKs whether the last data segment was marked
+ *
+ * Unlike RFC 3168, the ECE flag tells the sender exactly which segments
+ * were marked, so that it can count them (RFC 8257 sec. 3.2). The socket
+ * sends the delayed ACK pending when the echo changes, so that the
+ * segments already received are acked with their own echo.
+ *
+ * \param tcb internal congestion state
+ * \param event the event
+ */
+void
+TcpDctcp::CwndEvent (Ptr<TcpSocketState> tcb, TcpCAEvent_t event)
+{
+  NS_LOG_FUNCTION (this << tcb << event);
+
+  tcb->m_ecnEcho = (event == CA_EVENT_ECN_IS_CE);
+}
+
+/**
+ * \brief Count the bytes acked with and without ECE, and update alpha
+ *
+ * Alpha is updated once per window of data, that is once cWnd bytes have
+ * been acked since the last update (RFC 8257 sec. 3.3).
+ *
+ * \param tcb internal congestion state
+ * \param bytesAcked count of bytes newly acked
+ * \param ecnEcho true if the ACK carries the ECE flag
+ */
+void
+TcpDctcp::InAckEvent (Ptr<TcpSocketState> tcb, uint32_t bytesAcked, bool ecnEcho)
+{
+  NS_LOG_FUNCTION (this << tcb << bytesAcked << ecnEcho);
+
+  m_ackedBytesTotal += bytesAcked;
+  if (ecnEcho)
+    {
+      m_ackedBytesEcn += bytesAcked;
+    }
+
+  if (m_ackedBytesTotal >= tcb->m_cWnd)
+    {
+      m_alpha = DctcpUpdateAlpha (m_alpha, m_ackedBytesEcn, m_ackedBytesTotal, m_shiftG);
+      NS_LOG_INFO ("Window of " << m_ackedBytesTotal << " bytes, " << m_ackedBytesEcn <<
+                   " marked: updated alpha " << m_alpha);
+      m_ackedBytesEcn = 0;
+      m_ackedBytesTotal = 0;
+    }
+}
+
+bool
+TcpDctcp::NeedsEcn (void) const
+{
+  return true;
+}
+
+Ptr<TcpCongestionOps>
+TcpDctcp::Fork ()
+{
+  return CopyObject<TcpDctcp> (this);
+}
+
 } // namespace ns3
@@ -22,7 +22,6 @@
 #include "ns3/object.h"
 #include "ns3/timer.h"
 
-#define DCTCP_MAX_ALPHA 1024U
 #define INIGO_MIN_FAIRNESS 3U   // alpha sensitivity of 684 / 1024                                                            
 #define INIGO_MAX_FAIRNESS 512U // alpha sensitivity of 4 / 1024                                                              
 #define INIGO_MAX_MARK 1024U
@@ -63,6 +62,15 @@ public:
 
   virtual ~TcpCongestionOps ();
 
+  /**
+   * \brief Events reported to the congestion control by CwndEvent
+   */
+  typedef enum
+  {
+    CA_EVENT_ECN_NO_CE,  /**< A data segment arrived without the CE codepoint */
+    CA_EVENT_ECN_IS_CE   /**< A data segment arrived with the CE codepoint */
+  } TcpCAEvent_t;
+
   /**
    * \brief Get the name of the congestion control algorithm
    *
@@ -100,6 +108,22 @@ public:
    */
   virtual void IncreaseWindow (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked) = 0;
 
+  /**
+   * \brief Congestion avoidance for a batch of coalesced ACKs
+   *
+   * Called instead of IncreaseWindow when the socket coalesces several new
+   * ACKs into a single congestion control update. The default implementation
+   * calls IncreaseWindow once per ACK, spreading the acked segments evenly
+   * among them; congestion controls able to compute the cumulative growth in
+   * one step should override it.
+   *
+   * \param tcb internal congestion state
+   * \param segmentsAcked count of segments acked by the whole batch
+   * \param acks count of ACKs in the batch
+   */
+  virtual void IncreaseWindowCumulative (Ptr<TcpSocketState> tcb,
+                                         uint32_t segmentsAcked, uint32_t acks);
+
   /**
    * \brief Timing information on received ACK
    *
@@ -117,13 +141,62 @@ public:
   virtual void PktsAcked (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked,
                           const Time& rtt, bool expiredRtt) { }
 
+  /**
+   * \brief Set the pacing rate of the socket
+   *
+   * The function is called every time an ACK has been processed, and after a
+   * retransmission timeout, when pacing is enabled. The default
+   * implementation sets the rate to cWnd / sRTT, multiplied by the slow start
+   * gain while cWnd is below half ssThresh and by the congestion avoidance
+   * gain afterwards (as Linux does), and bounded by the maximum pacing rate.
+   * The rate is left untouched until the first RTT sample is available.
+   *
+   * \param tcb internal congestion state
+   */
+  virtual void UpdatePacingRate (Ptr<TcpSocketState> tcb);
+
+  /**
+   * \brief Trigger events of the congestion state on the receiver side
+   *
+   * Mimic the function cwnd_event in Linux, for the ECN events only. It is
+   * called for every data segment received on a connection which
+   * negotiated ECN, and it decides whether the ACKs carry the ECE flag.
+   * The default implementation follows RFC 3168: a CE mark sets the
+   * echo, which lasts until the sender acknowledges it with a CWR.
+   *
+   * \param tcb internal congestion state
+   * \param event the event
+   */
+  virtual void CwndEvent (Ptr<TcpSocketState> tcb, TcpCAEvent_t event);
+
+  /**
+   * \brief Information on a received ACK of a connection which negotiated ECN
+   *
+   * Mimic the function in_ack_event in Linux. The function is called for
+   * every ACK received, before the ACK changes cWnd. It is optional, and
+   * the default implementation does nothing.
+   *
+   * \param tcb internal congestion state
+   * \param bytesAcked count of bytes newly acked
+   * \param ecnEcho true if the ACK carries the ECE flag
+   */
+  virtual void InAckEvent (Ptr<TcpSocketState> tcb, uint32_t bytesAcked,
+                           bool ecnEcho) { }
+
+  /**
+   * \brief Whether the congestion control works only with ECN
+   *
+   * Mimic the flag TCP_CONG_NEEDS_ECN in Linux: the sockets using such a
+   * congestion control negotiate ECN even if their UseEcn attribute is
+   * false. The default implementation returns false.
+   *
+   * \return true if the congestion control needs ECN
+   */
+  virtual bool NeedsEcn (void) const;
+
   // Present in Linux but not in ns-3 yet:
   /* call before changing ca_state (optional) */
   // void (*set_state)(struct sock *sk, u8 new_state);
-  /* call when cwnd event occurs (optional) */
-  // void (*cwnd_event)(struct sock *sk, enum tcp_ca_event ev);
-  /* call when ack arrives (optional) */
-  // void (*in_ack_event)(struct sock *sk, u32 flags);
   /* new value of cwnd after loss (optional) */
   // u32  (*undo_cwnd)(struct sock *sk);
   /* hook for packet ack accounting (optional) */
@@ -135,6 +208,24 @@ public:
    * \return a pointer of the copied object
    */
   virtual Ptr<TcpCongestionOps> Fork () = 0;
+
+protected:
+  static const uint32_t DCTCP_MAX_ALPHA = 1024; //!< A fraction of 1, in DCTCP fixed point
+
+  /**
+   * \brief Update the DCTCP estimate of the fraction of marked traffic
+   *
+   * Compute alpha = (1 - g) * alpha + g * F in fixed point, as Linux does,
+   * where F is marked / total and g is 1 / 2^shiftG.
+   *
+   * \param alpha the current estimate, DCTCP_MAX_ALPHA standing for 1
+   * \param marked the amount of marked traffic in the last window
+   * \param total the amount of traffic in the last window
+   * \param shiftG the weight of the new fraction, as a power of 2
+   * \return the new estimate
+   */
+  static uint32_t DctcpUpdateAlpha (uint32_t alpha, uint32_t marked,
+                                    uint32_t total, uint32_t shiftG);
 };
 
 /**
@@ -162,6 +253,8 @@ public:
   std::string GetName () const;
 
   virtual void IncreaseWindow (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
+  virtual void IncreaseWindowCumulative (Ptr<TcpSocketState> tcb,
+                                         uint32_t segmentsAcked, uint32_t acks);
   virtual uint32_t GetSsThresh (Ptr<const TcpSocketState> tcb,
                                 uint32_t bytesInFlight);
 
@@ -170,6 +263,9 @@ public:
 protected:
   virtual uint32_t SlowStart (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
   virtual void CongestionAvoidance (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
+
+private:
+  Ptr<TcpSocketState> m_cumulativeState; //!< Untraced scratch state of IncreaseWindowCumulative
 };
 
 /**
@@ -218,6 +314,58 @@ protected:
   virtual uint32_t InigoSlowStart (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
 };
 
+/**
+ * \brief The DCTCP implementation
+ *
+ * DCTCP (RFC 8257) reacts to the extent of the congestion rather than to
+ * its presence: the receiver echoes exactly which segments were marked
+ * with CE, and the sender reduces cWnd in proportion to alpha, its
+ * estimate of the fraction of the bytes marked, once per window of data.
+ * The estimate is computed by the same code as the alpha of TcpInigo,
+ * which derives its marks from the RTT instead of ECN. The window grows
+ * as in NewReno.
+ *
+ * Both ends of the connection must use DCTCP, and the queues of the path
+ * must mark the packets whose queueing delay exceeds a threshold K.
+ */
+class TcpDctcp : public TcpNewReno
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TcpDctcp ();
+  TcpDctcp (const TcpDctcp& sock);
+
+  ~TcpDctcp ();
+
+  std::string GetName () const;
+
+  virtual uint32_t GetSsThresh (Ptr<const TcpSocketState> tcb,
+                                uint32_t bytesInFlight);
+  virtual void CwndEvent (Ptr<TcpSocketState> tcb, TcpCAEvent_t event);
+  virtual void InAckEvent (Ptr<TcpSocketState> tcb, uint32_t bytesAcked,
+                           bool ecnEcho);
+  virtual bool NeedsEcn (void) const;
+
+  virtual Ptr<TcpCongestionOps> Fork ();
+
+  /**
+   * \brief Get the estimate of the fraction of marked bytes
+   * \return alpha, DCTCP_MAX_ALPHA (1024) standing for 1
+   */
+  uint32_t GetAlpha (void) const;
+
+private:
+  uint32_t m_alpha;           //!< Estimate of the fraction of marked bytes
+  uint32_t m_shiftG;          //!< Weight of the last window in alpha, as a power of 2
+  uint32_t m_ackedBytesEcn;   //!< Bytes acked with ECE in the current window
+  uint32_t m_ackedBytesTotal; //!< Bytes acked in the current window
+};
+
 
 } // namespace ns3
 
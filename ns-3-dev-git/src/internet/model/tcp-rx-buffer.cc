@@ -156,16 +156,21 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
+  // Remove overlapped bytes from packet. Only the block before headSeq and
+  // the blocks starting in [headSeq, tailSeq] can overlap.
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      --i;
+    }
   while (i != m_data.end () && i->first <= tailSeq)
     {
-      SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
+      SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second.m_size);
       if (lastByteSeq > headSeq)
         {
           if (i->first > headSeq && lastByteSeq < tailSeq)
-            { // Rare case: Existing packet is embedded fully in the new packet
-              m_size -= i->second->GetSize ();
+            { // Rare case: Existing block is embedded fully in the new packet
+              m_size -= i->second.m_size;
               m_data.erase (i++);
               continue;
             }
@@ -193,25 +198,47 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       p = p->CreateFragment (start, length);
       NS_ASSERT (length == p->GetSize ());
     }
-  // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
+  // Insert packet into buffer, appending it to the block it continues, if any
+  BufIterator next = m_data.lower_bound (headSeq);
+  NS_ASSERT (next == m_data.end () || next->first != headSeq); // Shouldn't be there yet
+  BufIterator cur = next;
+  if (cur != m_data.begin ())
+    {
+      --cur;
+    }
+  if (cur != next && cur->first + SequenceNumber32 (cur->second.m_size) == headSeq)
+    {
+      cur->second.m_pkts.push_back (p);
+      cur->second.m_size += p->GetSize ();
+    }
+  else
+    {
+      cur = m_data.insert (next, std::make_pair (headSeq, DataBlock ()));
+      cur->second.m_pkts.push_back (p);
+      cur->second.m_size = p->GetSize ();
+    }
+  // ... and merging it with the block it fills the gap to
+  if (next != m_data.end () && next->first == tailSeq)
+    {
+      cur->second.m_pkts.splice (cur->second.m_pkts.end (), next->second.m_pkts);
+      cur->second.m_size += next->second.m_size;
+      m_data.erase (next);
+    }
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
   // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  // The in-sequence data, if any, is the first block
+  BufIterator head = m_data.begin ();
+  if (head->first <= m_nextRxSeq)
     {
-      if (i->first < m_nextRxSeq)
+      SequenceNumber32 lastByteSeq = head->first + SequenceNumber32 (head->second.m_size);
+      if (lastByteSeq > m_nextRxSeq)
         {
-          continue;
+          m_availBytes += lastByteSeq - m_nextRxSeq.Get ();
+          m_nextRxSeq = lastByteSeq;
         }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
     }
+  UpdateSackList (cur->first, cur->first + SequenceNumber32 (cur->second.m_size));
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
     { // Account for the FIN packet
@@ -225,44 +252,102 @@ TcpRxBuffer::Extract (uint32_t maxSize)
 {
   NS_LOG_FUNCTION (this << maxSize);
 
+  std::list<Ptr<Packet> > segments;
+  uint32_t extractSize = ExtractSegments (maxSize, segments);
+  if (extractSize == 0)
+    {
+      NS_LOG_LOGIC ("Nothing extracted.");
+      return 0;
+    }
+  if (segments.size () == 1)
+    { // A request served by a single segment hands it over without copy
+      return segments.front ();
+    }
+  Ptr<Packet> outPkt = Create<Packet> ();
+  for (std::list<Ptr<Packet> >::const_iterator i = segments.begin (); i != segments.end (); ++i)
+    {
+      outPkt->AddAtEnd (*i);
+    }
+  return outPkt;
+}
+
+uint32_t
+TcpRxBuffer::ExtractSegments (uint32_t maxSize, std::list<Ptr<Packet> > &segments)
+{
+  NS_LOG_FUNCTION (this << maxSize);
+
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
   NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
-  while (extractSize)
+  BufIterator i = m_data.begin ();
+  NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+  DataBlock &block = i->second;
+  uint32_t remaining = extractSize;
+  while (remaining)
     { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+      Ptr<Packet> piece = block.m_pkts.front ();
       // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
-      if (pktSize <= extractSize)
+      uint32_t pktSize = piece->GetSize ();
+      if (pktSize <= remaining)
         { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
-          m_size -= pktSize;
-          m_availBytes -= pktSize;
-          extractSize -= pktSize;
+          block.m_pkts.pop_front ();
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
-          m_size -= extractSize;
-          m_availBytes -= extractSize;
-          extractSize = 0;
+          block.m_pkts.front () = piece->CreateFragment (remaining, pktSize - remaining);
+          piece = piece->CreateFragment (0, remaining);
+          pktSize = remaining;
         }
+      remaining -= pktSize;
+      segments.push_back (piece);
     }
-  if (outPkt->GetSize () == 0)
+  m_size -= extractSize;
+  m_availBytes -= extractSize;
+  if (block.m_pkts.empty ())
     {
-      NS_LOG_LOGIC ("Nothing extracted.");
-      return 0;
+      m_data.erase (i);
+    }
+  else
+    { // Re-key the rest of the block, moving its segments
+      DataBlock &rest = m_data[i->first + SequenceNumber32 (extractSize)];
+      rest.m_size = block.m_size - extractSize;
+      rest.m_pkts.swap (block.m_pkts);
+      m_data.erase (i);
     }
-  NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
+  NS_LOG_LOGIC ("Extracted " << extractSize << " bytes in " << segments.size ()
+                             << " segments, bufsize=" << m_size
                              << ", num pkts in buffer=" << m_data.size ());
-  return outPkt;
+  return extractSize;
+}
+
+TcpOptionSack::SackList
+TcpRxBuffer::GetSackList (void) const
+{
+  return m_sackList;
+}
+
+void
+TcpRxBuffer::UpdateSackList (const SequenceNumber32 &head, const SequenceNumber32 &tail)
+{
+  NS_LOG_FUNCTION (this << head << tail);
+  // Drop the blocks merged into the updated one, and the ones now in sequence
+  TcpOptionSack::SackList::iterator it = m_sackList.begin ();
+  while (it != m_sackList.end ())
+    {
+      if (it->second <= m_nextRxSeq || (it->first >= head && it->second <= tail))
+        {
+          it = m_sackList.erase (it);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+  if (head > m_nextRxSeq)
+    {
+      m_sackList.push_front (TcpOptionSack::SackBlock (head, tail));
+    }
 }
 
 } //namepsace ns3
@@ -22,11 +22,13 @@
 #define TCP_RX_BUFFER_H
 
 #include <map>
+#include <list>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
 #include "ns3/ptr.h"
 #include "ns3/tcp-header.h"
+#include "ns3/tcp-option-sack.h"
 
 namespace ns3 {
 class Packet;
@@ -36,6 +38,12 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * The buffer is an ordered map of disjoint blocks of contiguous data, keyed
+ * by the sequence number of their first byte. An incoming segment is trimmed
+ * against its neighbouring blocks only, and it is merged with the blocks it
+ * touches; hence all the in-sequence data is held in the first block and the
+ * number of blocks is bounded by the number of holes in the sequence space.
  */
 class TcpRxBuffer : public Object
 {
@@ -120,20 +128,64 @@ public:
    * Extract data from the head of the buffer as indicated by nextRxSeq.
    * The extracted data is going to be forwarded to the application.
    *
+   * A read served by a single segment returns that segment without a
+   * copy. A read spanning several segments concatenates them into a new
+   * packet; see ExtractSegments to get them without the copy.
+   *
    * \param maxSize maximum number of bytes to extract
    * \returns a packet
    */
   Ptr<Packet> Extract (uint32_t maxSize);
+
+  /**
+   * Extract data from the head of the buffer as indicated by nextRxSeq,
+   * as the chain of the buffered segments which hold it. No data is
+   * copied: the segments are handed over, the last one being a fragment
+   * if the read ends inside it.
+   *
+   * \param maxSize maximum number of bytes to extract
+   * \param segments the list the extracted segments are appended to, in
+   *        sequence order
+   * \returns the number of bytes extracted
+   */
+  uint32_t ExtractSegments (uint32_t maxSize, std::list<Ptr<Packet> > &segments);
+
+  /**
+   * \brief Get the blocks of out-of-order data, to be reported in a SACK option
+   *
+   * As per RFC 2018, the block holding the most recently received segment
+   * comes first, followed by the other blocks in order of recency.
+   *
+   * \returns the list of out-of-order blocks
+   */
+  TcpOptionSack::SackList GetSackList (void) const;
+private:
+  /**
+   * \brief Update the SACK list after the block [head, tail) was updated
+   * \param head sequence number of the first byte of the block
+   * \param tail sequence number of the last byte of the block + 1
+   */
+  void UpdateSackList (const SequenceNumber32 &head, const SequenceNumber32 &tail);
+
+  TcpOptionSack::SackList m_sackList; //!< Out-of-order blocks, most recently updated first
 public:
+  /**
+   * \brief A block of contiguous data, made of the segments that filled it
+   */
+  struct DataBlock
+  {
+    uint32_t m_size;                //!< Number of data bytes in the block
+    std::list<Ptr<Packet> > m_pkts; //!< Segments, in sequence order
+  };
   /// container for data stored in the buffer
-  typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
+  typedef std::map<SequenceNumber32, DataBlock>::iterator BufIterator;
   TracedValue<SequenceNumber32> m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber32 m_finSeq;                 //!< Seqnum of the FIN packet
   bool m_gotFin;                             //!< Did I received FIN packet?
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  std::map<SequenceNumber32, DataBlock> m_data; //!< Corresponding data (may be null)
 };
 
 } //namepsace ns3
@@ -49,6 +49,8 @@
 #include "tcp-header.h"
 #include "tcp-option-winscale.h"
 #include "tcp-option-ts.h"
+#include "tcp-option-sack-permitted.h"
+#include "tcp-option-sack.h"
 #include "rtt-estimator.h"
 
 #include <math.h>
@@ -58,6 +60,7 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("TcpSocketBase");
 
+NS_OBJECT_ENSURE_REGISTERED (TcpSocketState);
 NS_OBJECT_ENSURE_REGISTERED (TcpSocketBase);
 
 TypeId
@@ -97,6 +100,10 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_timestampEnabled),
                    MakeBooleanChecker ())
+    .AddAttribute ("Sack", "Enable or disable the SACK option and SACK-based loss recovery",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_sackEnabled),
+                   MakeBooleanChecker ())
     .AddAttribute ("MinRto",
                    "Minimum retransmit timeout value",
                    TimeValue (Seconds (1.0)), // RFC 6298 says min RTO=1 sec, but Linux uses 200ms.
@@ -120,6 +127,10 @@ TcpSocketBase::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&TcpSocketBase::GetRxBuffer),
                    MakePointerChecker<TcpRxBuffer> ())
+    .AddAttribute ("UseEcn", "Negotiate ECN in the handshake (RFC 3168)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_useEcn),
+                   MakeBooleanChecker ())
     .AddAttribute ("ReTxThreshold", "Threshold for fast retransmit",
                     UintegerValue (3),
                     MakeUintegerAccessor (&TcpSocketBase::m_retxThresh),
@@ -128,6 +139,12 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_limitedTx),
                    MakeBooleanChecker ())
+    .AddAttribute ("AckCoalescingTime",
+                   "Interval over which the cWnd growth of new ACKs is "
+                   "coalesced into a single congestion control call (0 disables)",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&TcpSocketBase::m_ackCoalescingTime),
+                   MakeTimeChecker ())
     .AddTraceSource ("RTO",
                      "Retransmission timeout",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_rto),
@@ -172,6 +189,10 @@ TcpSocketBase::GetTypeId (void)
                      "TCP slow start threshold (bytes)",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_ssThTrace),
                      "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("PacingRate",
+                     "The current TCP pacing rate",
+                     MakeTraceSourceAccessor (&TcpSocketBase::m_pacingRateTrace),
+                     "ns3::TracedValueCallback::DataRate")
     .AddTraceSource ("Tx",
                      "Send tcp packet to IP protocol",
                      MakeTraceSourceAccessor (&TcpSocketBase::m_txTrace),
@@ -200,10 +221,30 @@ TcpSocketState::GetTypeId (void)
                      "TCP slow start threshold (bytes)",
                      MakeTraceSourceAccessor (&TcpSocketState::m_ssThresh),
                      "ns3::TracedValue::Uint32Callback")
+    .AddAttribute ("EnablePacing", "Enable or disable the pacing of the segments",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketState::m_pacing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxPacingRate", "Upper bound of the pacing rate",
+                   DataRateValue (DataRate ("4Gb/s")),
+                   MakeDataRateAccessor (&TcpSocketState::m_maxPacingRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("PacingSsRatio", "Pacing gain in slow start, in percent of cWnd / sRTT",
+                   UintegerValue (200),
+                   MakeUintegerAccessor (&TcpSocketState::m_pacingSsRatio),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("PacingCaRatio", "Pacing gain in congestion avoidance, in percent of cWnd / sRTT",
+                   UintegerValue (120),
+                   MakeUintegerAccessor (&TcpSocketState::m_pacingCaRatio),
+                   MakeUintegerChecker<uint16_t> ())
     .AddTraceSource ("CongState",
                      "TCP Congestion machine state",
                      MakeTraceSourceAccessor (&TcpSocketState::m_congState),
                      "ns3::TracedValue::TcpCongStatesTracedValueCallback")
+    .AddTraceSource ("PacingRate",
+                     "The current TCP pacing rate",
+                     MakeTraceSourceAccessor (&TcpSocketState::m_pacingRate),
+                     "ns3::TracedValueCallback::DataRate")
   ;
   return tid;
 }
@@ -215,7 +256,15 @@ TcpSocketState::TcpSocketState (void)
     m_initialCWnd (0),
     m_initialSsThresh (0),
     m_segmentSize (0),
-    m_congState (CA_OPEN)
+    m_congState (CA_OPEN),
+    m_pacing (false),
+    m_maxPacingRate (DataRate ("4Gb/s")),
+    m_pacingRate (m_maxPacingRate),
+    m_pacingSsRatio (200),
+    m_pacingCaRatio (120),
+    m_srtt (Seconds (0)),
+    m_ecnState (ECN_DISABLED),
+    m_ecnEcho (false)
 {
 }
 
@@ -226,7 +275,15 @@ TcpSocketState::TcpSocketState (const TcpSocketState &other)
     m_initialCWnd (other.m_initialCWnd),
     m_initialSsThresh (other.m_initialSsThresh),
     m_segmentSize (other.m_segmentSize),
-    m_congState (other.m_congState)
+    m_congState (other.m_congState),
+    m_pacing (other.m_pacing),
+    m_maxPacingRate (other.m_maxPacingRate),
+    m_pacingRate (other.m_pacingRate),
+    m_pacingSsRatio (other.m_pacingSsRatio),
+    m_pacingCaRatio (other.m_pacingCaRatio),
+    m_srtt (other.m_srtt),
+    m_ecnState (other.m_ecnState),
+    m_ecnEcho (other.m_ecnEcho)
 {
 }
 
@@ -264,6 +321,11 @@ TcpSocketBase::TcpSocketBase (void)
     m_rcvScaleFactor (0),
     m_timestampEnabled (true),
     m_timestampToEcho (0),
+    m_sackEnabled (false),
+    m_useEcn (false),
+    m_ecnRecover (0),
+    m_coalescedSegsAcked (0),
+    m_coalescedAcks (0),
     m_retxThresh (3),
     m_limitedTx (false),
     m_congestionControl (0),
@@ -274,6 +336,8 @@ TcpSocketBase::TcpSocketBase (void)
   m_txBuffer = CreateObject<TcpTxBuffer> ();
   m_tcb      = CreateObject<TcpSocketState> ();
 
+  m_tcb->m_pacingRate = m_tcb->m_maxPacingRate;
+
   bool ok;
 
   ok = m_tcb->TraceConnectWithoutContext ("CongestionWindow",
@@ -287,6 +351,10 @@ TcpSocketBase::TcpSocketBase (void)
   ok = m_tcb->TraceConnectWithoutContext ("CongState",
                                           MakeCallback (&TcpSocketBase::UpdateCongState, this));
   NS_ASSERT (ok == true);
+
+  ok = m_tcb->TraceConnectWithoutContext ("PacingRate",
+                                          MakeCallback (&TcpSocketBase::UpdatePacingRateTrace, this));
+  NS_ASSERT (ok == true);
 }
 
 TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
@@ -324,6 +392,12 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_rcvScaleFactor (sock.m_rcvScaleFactor),
     m_timestampEnabled (sock.m_timestampEnabled),
     m_timestampToEcho (sock.m_timestampToEcho),
+    m_sackEnabled (sock.m_sackEnabled),
+    m_useEcn (sock.m_useEcn),
+    m_ecnRecover (sock.m_ecnRecover),
+    m_ackCoalescingTime (sock.m_ackCoalescingTime),
+    m_coalescedSegsAcked (0),
+    m_coalescedAcks (0),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
     m_tcb (sock.m_tcb),
@@ -367,6 +441,10 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
   ok = m_tcb->TraceConnectWithoutContext ("CongState",
                                           MakeCallback (&TcpSocketBase::UpdateCongState, this));
   NS_ASSERT (ok == true);
+
+  ok = m_tcb->TraceConnectWithoutContext ("PacingRate",
+                                          MakeCallback (&TcpSocketBase::UpdatePacingRateTrace, this));
+  NS_ASSERT (ok == true);
 }
 
 TcpSocketBase::~TcpSocketBase (void)
@@ -1069,6 +1147,12 @@ TcpSocketBase::ForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port,
   Address toAddress = InetSocketAddress (header.GetDestination (),
                                          m_endPoint->GetLocalPort ());
 
+  if (m_tcb->m_ecnState != TcpSocketState::ECN_DISABLED
+      && header.GetEcn () != Ipv4Header::ECN_NotECT)
+    {
+      ReceivedEcnCodepoint (packet, header.GetEcn () == Ipv4Header::ECN_CE);
+    }
+
   DoForwardUp (packet, fromAddress, toAddress);
 }
 
@@ -1086,6 +1170,13 @@ TcpSocketBase::ForwardUp6 (Ptr<Packet> packet, Ipv6Header header, uint16_t port,
   Address toAddress = Inet6SocketAddress (header.GetDestinationAddress (),
                                           m_endPoint6->GetLocalPort ());
 
+  // The ECN field is made of the two low bits of the traffic class
+  uint8_t ecn = header.GetTrafficClass () & 0x03;
+  if (m_tcb->m_ecnState != TcpSocketState::ECN_DISABLED && ecn != Ipv4Header::ECN_NotECT)
+    {
+      ReceivedEcnCodepoint (packet, ecn == Ipv4Header::ECN_CE);
+    }
+
   DoForwardUp (packet, fromAddress, toAddress);
 }
 
@@ -1128,7 +1219,10 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
       return; // Discard invalid packet
     }
 
-  m_rxTrace (packet, tcpHeader, this);
+  if (!m_rxTrace.IsEmpty ())
+    {
+      m_rxTrace (packet, tcpHeader, this);
+    }
 
   ReadOptions (tcpHeader);
 
@@ -1196,7 +1290,8 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
       break;
     case CLOSED:
       // Send RST if the incoming packet is not a RST
-      if ((tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG)) != TcpHeader::RST)
+      if ((tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                     | TcpHeader::ECE | TcpHeader::CWR)) != TcpHeader::RST)
         { // Since m_endPoint is not configured yet, we cannot use SendRST here
           TcpHeader h;
           Ptr<Packet> p = Create<Packet> ();
@@ -1207,7 +1302,10 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
           h.SetDestinationPort (tcpHeader.GetSourcePort ());
           h.SetWindowSize (AdvertisedWindowSize ());
           AddOptions (h);
-          m_txTrace (p, h, this);
+          if (!m_txTrace.IsEmpty ())
+            {
+              m_txTrace (p, h, this);
+            }
           m_tcp->SendPacket (p, h, toAddress, fromAddress, m_boundnetdevice);
         }
       break;
@@ -1255,8 +1353,9 @@ TcpSocketBase::ProcessEstablished (Ptr<Packet> packet, const TcpHeader& tcpHeade
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::ECE | TcpHeader::CWR);
 
   // Different flags are different events
   if (tcpflags == TcpHeader::ACK)
@@ -1346,6 +1445,18 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
                 " SND.NXT=" << m_nextTxSequence << 
                 " CWND=" << m_tcb->m_cWnd);
 
+  if (m_coalescedAcks > 0
+      && (m_tcb->m_congState != TcpSocketState::CA_OPEN
+          || tcpHeader.GetAckNumber () <= m_txBuffer->HeadSequence ()))
+    { // Only new ACKs in Open join the batch; anything else needs the real cWnd
+      FlushCoalescedAcks ();
+    }
+
+  if (m_tcb->m_ecnState != TcpSocketState::ECN_DISABLED)
+    {
+      ReceivedEcnAck (tcpHeader);
+    }
+
   bool expiredRtt =  !(m_txBuffer->HeadSequence () < m_nextTxSequence);
 
   if (tcpHeader.GetAckNumber () == m_txBuffer->HeadSequence () &&
@@ -1366,14 +1477,18 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
         }
       else if (m_tcb->m_congState == TcpSocketState::CA_DISORDER)
         {
-          if (m_dupAckCount < m_retxThresh && m_limitedTx)
+          // With SACK, the recovery starts as soon as the head is deemed lost (RFC6675 sec.5)
+          bool sackLoss = m_sackEnabled
+            && m_txBuffer->IsLost (m_txBuffer->HeadSequence (), m_retxThresh, m_tcb->m_segmentSize);
+
+          if (m_dupAckCount < m_retxThresh && m_limitedTx && !sackLoss)
             {
               // RFC3042 Limited transmit: Send a new packet for each duplicated ACK before fast retransmit
               NS_LOG_INFO ("Limited transmit");
               uint32_t sz = SendDataPacket (m_nextTxSequence, m_tcb->m_segmentSize, true);
               m_nextTxSequence += sz;
             }
-          else if (m_dupAckCount == m_retxThresh)
+          else if (m_dupAckCount == m_retxThresh || sackLoss)
             {
               // triple duplicate ack triggers fast retransmit (RFC2582 sec.3 bullet #1)
               NS_LOG_DEBUG (TcpSocketState::TcpCongStateName[m_tcb->m_congState] <<
@@ -1383,13 +1498,26 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 
               m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb,
                                                                     BytesInFlight ());
-              uint32_t cwnd = m_tcb->m_ssThresh + m_dupAckCount * m_tcb->m_segmentSize;
-              m_tcb->m_cWnd = std::min(cwnd, CWND_CLAMP);
+              if (m_sackEnabled)
+                { // No inflation: the pipe accounts for the segments that left the network
+                  m_tcb->m_cWnd = std::min (m_tcb->m_ssThresh.Get (), CWND_CLAMP);
+                  m_txBuffer->ResetHighRxt ();
+                }
+              else
+                {
+                  uint32_t cwnd = m_tcb->m_ssThresh + m_dupAckCount * m_tcb->m_segmentSize;
+                  m_tcb->m_cWnd = std::min(cwnd, CWND_CLAMP);
+                }
 
               NS_LOG_INFO (m_dupAckCount << " dupack. Enter fast recovery mode." <<
                            "Reset cwnd to " << m_tcb->m_cWnd << ", ssthresh to " <<
                            m_tcb->m_ssThresh << " at fast recovery seqnum " << m_recover);
               DoRetransmit ();
+
+              if (m_sackEnabled)
+                { // Fill the other holes, as far as the pipe allows (RFC6675 sec.5 step 4.3)
+                  SendPendingData (m_connected);
+                }
             }
           else
             {
@@ -1398,11 +1526,14 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
             }
         }
       else if (m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
-        { // Increase cwnd for every additional dupack (RFC2582, sec.3 bullet #3)
-          uint32_t cwnd = m_tcb->m_cWnd + m_tcb->m_segmentSize;
-          m_tcb->m_cWnd = std::min(cwnd, CWND_CLAMP);
-          NS_LOG_INFO (m_dupAckCount << " Dupack received in fast recovery mode."
-                       "Increase cwnd to " << m_tcb->m_cWnd);
+        {
+          if (!m_sackEnabled)
+            { // Increase cwnd for every additional dupack (RFC2582, sec.3 bullet #3)
+              uint32_t cwnd = m_tcb->m_cWnd + m_tcb->m_segmentSize;
+              m_tcb->m_cWnd = std::min(cwnd, CWND_CLAMP);
+              NS_LOG_INFO (m_dupAckCount << " Dupack received in fast recovery mode."
+                           "Increase cwnd to " << m_tcb->m_cWnd);
+            }
           SendPendingData (m_connected);
         }
 
@@ -1474,7 +1605,11 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
                            " segment size = " << m_tcb->m_segmentSize <<
                            " segsAcked = " << segsAcked);
 
-              if (segsAcked >= 1)
+              if (m_sackEnabled)
+                { // RFC6675: no deflation, the scoreboard drives the retransmissions
+                  NS_LOG_DEBUG (" CWND=" << m_tcb->m_cWnd);
+                }
+              else if (segsAcked >= 1)
                 {
                   int diff = m_tcb->m_segmentSize - bytesAcked;
                   if (diff > 0) {
@@ -1492,7 +1627,10 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
               callCongestionControl = false; // No congestion control on cWnd show be invoked
               m_dupAckCount -= segsAcked;    // Update the dupAckCount
               m_txBuffer->DiscardUpTo (tcpHeader.GetAckNumber ());  //Bug 1850:  retransmit before newack
-              DoRetransmit (); // Assume the next seq is lost. Retransmit lost packet
+              if (!m_sackEnabled)
+                {
+                  DoRetransmit (); // Assume the next seq is lost. Retransmit lost packet
+                }
 
               if (m_isFirstPartialAck)
                 {
@@ -1546,8 +1684,20 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
           NS_LOG_DEBUG ("LOSS -> OPEN");
         }
 
-      if (callCongestionControl)
+      if (m_tcb->m_ecnState == TcpSocketState::ECN_ECE_RCVD
+          || m_tcb->m_ecnState == TcpSocketState::ECN_CWR_SENT)
+        { // cWnd does not grow until the window reduced on an ECE is acked
+          callCongestionControl = false;
+        }
+
+      if (callCongestionControl && !m_ackCoalescingTime.IsZero ()
+          && m_tcb->m_congState == TcpSocketState::CA_OPEN)
+        {
+          CoalesceAck (newSegsAcked);
+        }
+      else if (callCongestionControl)
         {
+          FlushCoalescedAcks ();
           m_congestionControl->IncreaseWindow (m_tcb, newSegsAcked);
 
           NS_LOG_LOGIC ("Congestion control called: " <<
@@ -1574,6 +1724,11 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
         }
     }
 
+  if (m_tcb->m_pacing)
+    {
+      m_congestionControl->UpdatePacingRate (m_tcb);
+    }
+
   // If there is any data piggybacked, store it into m_rxBuffer
   if (packet->GetSize () > 0)
     {
@@ -1588,8 +1743,9 @@ TcpSocketBase::ProcessListen (Ptr<Packet> packet, const TcpHeader& tcpHeader,
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::ECE | TcpHeader::CWR);
 
   // Fork a socket if received a SYN. Do nothing otherwise.
   // C.f.: the LISTEN part in tcp_v4_do_rcv() in tcp_ipv4.c in Linux kernel
@@ -1617,8 +1773,9 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == 0)
     { // Bare data, accept it and move to ESTABLISHED state. This is not a normal behaviour. Remove this?
@@ -1651,6 +1808,12 @@ TcpSocketBase::ProcessSynSent (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       m_rxBuffer->SetNextRxSequence (tcpHeader.GetSequenceNumber () + SequenceNumber32 (1));
       m_highTxMark = ++m_nextTxSequence;
       m_txBuffer->SetHeadSequence (m_nextTxSequence);
+      if (EcnRequested ()
+          && (tcpHeader.GetFlags () & (TcpHeader::ECE | TcpHeader::CWR)) == TcpHeader::ECE)
+        { // ECN-setup SYN-ACK (RFC 3168 sec. 6.1.1)
+          NS_LOG_DEBUG ("ECN negotiated");
+          m_tcb->m_ecnState = TcpSocketState::ECN_IDLE;
+        }
       SendEmptyPacket (TcpHeader::ACK);
       SendPendingData (m_connected);
       Simulator::ScheduleNow (&TcpSocketBase::ConnectionSucceeded, this);
@@ -1677,8 +1840,9 @@ TcpSocketBase::ProcessSynRcvd (Ptr<Packet> packet, const TcpHeader& tcpHeader,
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == 0
       || (tcpflags == TcpHeader::ACK
@@ -1767,8 +1931,9 @@ TcpSocketBase::ProcessWait (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::ECE | TcpHeader::CWR);
 
   if (packet->GetSize () > 0 && tcpflags != TcpHeader::ACK)
     { // Bare data, accept it
@@ -1839,8 +2004,9 @@ TcpSocketBase::ProcessClosing (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == TcpHeader::ACK)
     {
@@ -1871,8 +2037,9 @@ TcpSocketBase::ProcessLastAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
 {
   NS_LOG_FUNCTION (this << tcpHeader);
 
-  // Extract the flags. PSH and URG are not honoured.
-  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG);
+  // Extract the flags. PSH and URG are not honoured, ECE and CWR are processed apart.
+  uint8_t tcpflags = tcpHeader.GetFlags () & ~(TcpHeader::PSH | TcpHeader::URG
+                                               | TcpHeader::ECE | TcpHeader::CWR);
 
   if (tcpflags == 0)
     {
@@ -2065,6 +2232,25 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
       ++s;
     }
 
+  if (flags == TcpHeader::SYN)
+    {
+      if (EcnRequested ())
+        { // ECN-setup SYN (RFC 3168 sec. 6.1.1)
+          flags |= TcpHeader::ECE | TcpHeader::CWR;
+        }
+    }
+  else if (flags == (TcpHeader::SYN | TcpHeader::ACK))
+    {
+      if (m_tcb->m_ecnState != TcpSocketState::ECN_DISABLED)
+        { // ECN-setup SYN-ACK
+          flags |= TcpHeader::ECE;
+        }
+    }
+  else if ((flags & TcpHeader::ACK) && m_tcb->m_ecnEcho)
+    {
+      flags |= TcpHeader::ECE;
+    }
+
   header.SetFlags (flags);
   header.SetSequenceNumber (s);
   header.SetAckNumber (m_rxBuffer->NextRxSequence ());
@@ -2114,7 +2300,10 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
                          m_endPoint6->GetPeerAddress (), m_boundnetdevice);
     }
 
-  m_txTrace (p, header, this);
+  if (!m_txTrace.IsEmpty ())
+    {
+      m_txTrace (p, header, this);
+    }
 
   if (flags & TcpHeader::ACK)
     { // If sending an ACK, cancel the delay ACK as well
@@ -2257,6 +2446,12 @@ TcpSocketBase::CompleteFork (Ptr<Packet> p, const TcpHeader& h,
   SetupCallback ();
   // Set the sequence number and send SYN+ACK
   m_rxBuffer->SetNextRxSequence (h.GetSequenceNumber () + SequenceNumber32 (1));
+  if (EcnRequested ()
+      && (h.GetFlags () & (TcpHeader::ECE | TcpHeader::CWR)) == (TcpHeader::ECE | TcpHeader::CWR))
+    { // ECN-setup SYN (RFC 3168 sec. 6.1.1)
+      NS_LOG_DEBUG ("ECN negotiated");
+      m_tcb->m_ecnState = TcpSocketState::ECN_IDLE;
+    }
 
   SendEmptyPacket (TcpHeader::SYN | TcpHeader::ACK);
 }
@@ -2287,12 +2482,28 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
     {
       isRetransmission = true;
     }
+  else if (m_sackEnabled && seq < m_highTxMark)
+    { // Hole filled during a SACK recovery
+      isRetransmission = true;
+    }
 
   Ptr<Packet> p = m_txBuffer->CopyFromSequence (maxSize, seq);
   uint32_t sz = p->GetSize (); // Size of packet
   uint8_t flags = withAck ? TcpHeader::ACK : 0;
   uint32_t remainingData = m_txBuffer->SizeFromSequence (seq + SequenceNumber32 (sz));
 
+  // Only the new data is sent ECN-capable (RFC 3168 sec. 6.1.5)
+  bool ect = m_tcb->m_ecnState != TcpSocketState::ECN_DISABLED && !(seq < m_highTxMark);
+  if (withAck && m_tcb->m_ecnEcho)
+    {
+      flags |= TcpHeader::ECE;
+    }
+  if (ect && m_tcb->m_ecnState == TcpSocketState::ECN_ECE_RCVD)
+    {
+      flags |= TcpHeader::CWR;
+      m_tcb->m_ecnState = TcpSocketState::ECN_CWR_SENT;
+    }
+
   if (withAck)
     {
       m_delAckEvent.Cancel ();
@@ -2305,17 +2516,27 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
    * if both options are set. Once the packet got to layer three, only
    * the corresponding tags will be read.
    */
-  if (IsManualIpTos ())
+  if (IsManualIpTos () || (ect && m_endPoint != 0))
     {
       SocketIpTosTag ipTosTag;
-      ipTosTag.SetTos (GetIpTos ());
+      uint8_t tos = GetIpTos ();
+      if (ect)
+        {
+          tos = (tos & 0xfc) | Ipv4Header::ECN_ECT0;
+        }
+      ipTosTag.SetTos (tos);
       p->AddPacketTag (ipTosTag);
     }
 
-  if (IsManualIpv6Tclass ())
+  if (IsManualIpv6Tclass () || (ect && m_endPoint6 != 0))
     {
       SocketIpv6TclassTag ipTclassTag;
-      ipTclassTag.SetTclass (GetIpv6Tclass ());
+      uint8_t tclass = GetIpv6Tclass ();
+      if (ect)
+        {
+          tclass = (tclass & 0xfc) | Ipv4Header::ECN_ECT0;
+        }
+      ipTclassTag.SetTclass (tclass);
       p->AddPacketTag (ipTclassTag);
     }
 
@@ -2398,7 +2619,15 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
                     ". Header " << header);
     }
 
-  m_txTrace (p, header, this);
+  if (!m_txTrace.IsEmpty ())
+    {
+      m_txTrace (p, header, this);
+    }
+
+  if (m_sackEnabled && seq < m_highTxMark)
+    {
+      m_txBuffer->MarkRetransmitted (seq, sz);
+    }
 
   // update the history of sequence numbers used to calculate the RTT
   if (isRetransmission == false)
@@ -2445,8 +2674,34 @@ TcpSocketBase::SendPendingData (bool withAck)
       return false; // Is this the right way to handle this condition?
     }
   uint32_t nPacketsSent = 0;
-  while (m_txBuffer->SizeFromSequence (m_nextTxSequence))
+  while (true)
     {
+      if (m_tcb->m_pacing && m_pacingEvent.IsRunning ())
+        {
+          NS_LOG_LOGIC ("Pacing is enabled and the timer is running. Wait to send.");
+          break;
+        }
+      if (m_sackEnabled && m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
+        { // RFC6675 sec.5 step (C): lost segments first, then new data, then rule 3
+          SequenceNumber32 seq;
+          uint32_t length;
+          uint32_t pipe = m_txBuffer->BytesInFlight (m_highTxMark, m_retxThresh, m_tcb->m_segmentSize);
+          if (m_tcb->m_cWnd >= pipe + m_tcb->m_segmentSize
+              && (m_txBuffer->NextSeg (&seq, &length, m_retxThresh, m_tcb->m_segmentSize, m_highTxMark, true)
+                  || (m_txBuffer->SizeFromSequence (m_nextTxSequence) == 0
+                      && m_txBuffer->NextSeg (&seq, &length, m_retxThresh, m_tcb->m_segmentSize, m_highTxMark, false))))
+            {
+              NS_LOG_LOGIC ("SACK recovery: retransmitting " << length << " bytes at " << seq);
+              uint32_t sz = SendDataPacket (seq, length, withAck);
+              nPacketsSent++;
+              PaceSegment (sz);
+              continue;
+            }
+        }
+      if (m_txBuffer->SizeFromSequence (m_nextTxSequence) == 0)
+        {
+          break;
+        }
       uint32_t w = AvailableWindow (); // Get available window size
       // Stop sending if we need to wait for a larger Tx window (prevent silly window syndrome)
       if (w < m_tcb->m_segmentSize && m_txBuffer->SizeFromSequence (m_nextTxSequence) > w)
@@ -2479,6 +2734,7 @@ TcpSocketBase::SendPendingData (bool withAck)
       uint32_t sz = SendDataPacket (m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_nextTxSequence += sz;                     // Advance next tx sequence
+      PaceSegment (sz);
     }
   if (nPacketsSent > 0)
     {
@@ -2487,6 +2743,149 @@ TcpSocketBase::SendPendingData (bool withAck)
   return (nPacketsSent > 0);
 }
 
+void
+TcpSocketBase::PaceSegment (uint32_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  if (!m_tcb->m_pacing || m_tcb->m_pacingRate.Get ().GetBitRate () == 0)
+    {
+      return;
+    }
+  Time gap = m_tcb->m_pacingRate.Get ().CalculateBytesTxTime (size);
+  NS_LOG_LOGIC ("Next segment released in " << gap.GetSeconds () << " s at rate "
+                << m_tcb->m_pacingRate);
+  m_pacingEvent = Simulator::Schedule (gap, &TcpSocketBase::NotifyPacingPerformed, this);
+}
+
+void
+TcpSocketBase::NotifyPacingPerformed (void)
+{
+  NS_LOG_FUNCTION (this);
+  SendPendingData (m_connected);
+}
+
+void
+TcpSocketBase::CoalesceAck (uint32_t segmentsAcked)
+{
+  NS_LOG_FUNCTION (this << segmentsAcked);
+
+  m_coalescedSegsAcked += segmentsAcked;
+  ++m_coalescedAcks;
+
+  if (!m_ackCoalescingEvent.IsRunning ())
+    {
+      m_ackCoalescingEvent = Simulator::Schedule (m_ackCoalescingTime,
+                                                  &TcpSocketBase::AckCoalescingTimeout, this);
+    }
+}
+
+void
+TcpSocketBase::FlushCoalescedAcks (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_ackCoalescingEvent.Cancel ();
+  if (m_coalescedAcks == 0)
+    {
+      return;
+    }
+
+  NS_LOG_LOGIC ("Applying " << m_coalescedAcks << " coalesced ACKs for " <<
+                m_coalescedSegsAcked << " segments");
+  if (m_coalescedAcks == 1)
+    {
+      m_congestionControl->IncreaseWindow (m_tcb, m_coalescedSegsAcked);
+    }
+  else
+    {
+      m_congestionControl->IncreaseWindowCumulative (m_tcb, m_coalescedSegsAcked,
+                                                     m_coalescedAcks);
+    }
+  m_coalescedSegsAcked = 0;
+  m_coalescedAcks = 0;
+
+  if (m_tcb->m_pacing)
+    {
+      m_congestionControl->UpdatePacingRate (m_tcb);
+    }
+}
+
+void
+TcpSocketBase::AckCoalescingTimeout (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  FlushCoalescedAcks ();
+  // No ACK is processed here to send the data the new window allows
+  SendPendingData (m_connected);
+}
+
+bool
+TcpSocketBase::EcnRequested (void) const
+{
+  return m_useEcn || (m_congestionControl != 0 && m_congestionControl->NeedsEcn ());
+}
+
+void
+TcpSocketBase::ReceivedEcnCodepoint (Ptr<const Packet> packet, bool ceMarked)
+{
+  NS_LOG_FUNCTION (this << packet << ceMarked);
+
+  TcpHeader tcpHeader;
+  packet->PeekHeader (tcpHeader);
+  if (tcpHeader.GetFlags () & TcpHeader::CWR)
+    { // The sender reduced its window: the marks echoed so far are acknowledged
+      m_tcb->m_ecnEcho = false;
+    }
+
+  bool ecnEcho = m_tcb->m_ecnEcho;
+  m_congestionControl->CwndEvent (m_tcb, ceMarked ? TcpCongestionOps::CA_EVENT_ECN_IS_CE
+                                                  : TcpCongestionOps::CA_EVENT_ECN_NO_CE);
+
+  if (m_tcb->m_ecnEcho != ecnEcho && m_delAckEvent.IsRunning ())
+    { // The segments held by the delayed ACK keep the echo they arrived with
+      bool newEcnEcho = m_tcb->m_ecnEcho;
+      m_tcb->m_ecnEcho = ecnEcho;
+      SendEmptyPacket (TcpHeader::ACK);
+      m_tcb->m_ecnEcho = newEcnEcho;
+    }
+}
+
+void
+TcpSocketBase::ReceivedEcnAck (const TcpHeader& tcpHeader)
+{
+  NS_LOG_FUNCTION (this << tcpHeader);
+
+  bool ecnEcho = tcpHeader.GetFlags () & TcpHeader::ECE;
+  SequenceNumber32 ackNumber = tcpHeader.GetAckNumber ();
+  uint32_t bytesAcked = 0;
+  if (ackNumber > m_txBuffer->HeadSequence ())
+    {
+      bytesAcked = ackNumber - m_txBuffer->HeadSequence ();
+    }
+  m_congestionControl->InAckEvent (m_tcb, bytesAcked, ecnEcho);
+
+  if (m_tcb->m_ecnState != TcpSocketState::ECN_IDLE && ackNumber >= m_ecnRecover)
+    { // The data sent before the last reduction is acked
+      NS_LOG_DEBUG ("End of the window reduced on an ECE");
+      m_tcb->m_ecnState = TcpSocketState::ECN_IDLE;
+    }
+
+  if (ecnEcho && m_tcb->m_ecnState == TcpSocketState::ECN_IDLE
+      && (m_tcb->m_congState == TcpSocketState::CA_OPEN
+          || m_tcb->m_congState == TcpSocketState::CA_DISORDER))
+    { // Reduce the window as for a loss, at most once per window (RFC 3168 sec. 6.1.2);
+      // a loss recovery in progress already reduced it
+      FlushCoalescedAcks ();
+      m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb, BytesInFlight ());
+      m_tcb->m_cWnd = m_tcb->m_ssThresh.Get ();
+      m_tcb->m_ecnState = TcpSocketState::ECN_ECE_RCVD;
+      m_ecnRecover = m_highTxMark;
+      NS_LOG_INFO ("ECE received: cwnd reduced to " << m_tcb->m_cWnd <<
+                   " until seq " << m_ecnRecover << " is acked");
+    }
+}
+
 uint32_t
 TcpSocketBase::UnAckDataCount () const
 {
@@ -2515,6 +2914,15 @@ TcpSocketBase::AvailableWindow () const
   uint32_t unack = UnAckDataCount (); // Number of outstanding bytes
   uint32_t win = Window ();           // Number of bytes allowed to be outstanding
 
+  if (m_sackEnabled && m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
+    { // The cWnd bounds the pipe, the rWnd bounds the outstanding data (RFC6675 sec.5)
+      uint32_t pipe = m_txBuffer->BytesInFlight (m_highTxMark, m_retxThresh, m_tcb->m_segmentSize);
+      uint32_t cWnd = m_tcb->m_cWnd.Get ();
+      uint32_t rWnd = m_rWnd.Get ();
+      NS_LOG_DEBUG ("Pipe=" << pipe << ", UnAckCount=" << unack << ", cWnd=" << cWnd);
+      return std::min (cWnd < pipe ? 0 : cWnd - pipe, rWnd < unack ? 0 : rWnd - unack);
+    }
+
   NS_LOG_DEBUG ("UnAckCount=" << unack << ", Win=" << win);
   return (win < unack) ? 0 : (win - unack);
 }
@@ -2640,6 +3048,7 @@ TcpSocketBase::EstimateRtt (const TcpHeader& tcpHeader)
       // RFC 6298, clause 2.4
       m_rto = Max (m_rtt->GetEstimate () + Max (m_clockGranularity, m_rtt->GetVariation ()*4), m_minRto);
       m_lastRtt = m_rtt->GetEstimate ();
+      m_tcb->m_srtt = m_rtt->GetEstimate ();
       NS_LOG_FUNCTION(this << m_lastRtt);
     }
 }
@@ -2766,7 +3175,10 @@ TcpSocketBase::PersistTimeout ()
                          m_endPoint6->GetPeerAddress (), m_boundnetdevice);
     }
 
-  m_txTrace (p, tcpHeader, this);
+  if (!m_txTrace.IsEmpty ())
+    {
+      m_txTrace (p, tcpHeader, this);
+    }
 
   NS_LOG_LOGIC ("Schedule persist timeout at time "
                 << Simulator::Now ().GetSeconds () << " to expire at time "
@@ -2782,6 +3194,9 @@ TcpSocketBase::Retransmit ()
   // If all data are received (non-closing socket and nothing to send), just return
   if (m_state <= ESTABLISHED && m_txBuffer->HeadSequence () >= m_highTxMark) return;
 
+  // The slow start threshold below is computed on the real cWnd
+  FlushCoalescedAcks ();
+
   /*
    * When a TCP sender detects segment loss using the retransmission timer
    * and the given segment has not yet been resent by way of the
@@ -2815,6 +3230,7 @@ TcpSocketBase::Retransmit ()
 
   m_nextTxSequence = m_txBuffer->HeadSequence (); // Restart from highest Ack
   m_dupAckCount = 0;
+  m_txBuffer->ResetScoreboard (); // The receiver may have reneged (RFC2018 sec.8)
 
   if (m_tcb->m_congState != TcpSocketState::CA_LOSS)
     {
@@ -2823,6 +3239,11 @@ TcpSocketBase::Retransmit ()
       m_tcb->m_cWnd = m_tcb->m_segmentSize;
     }
 
+  if (m_tcb->m_pacing)
+    {
+      m_congestionControl->UpdatePacingRate (m_tcb);
+    }
+
   NS_LOG_DEBUG ("RTO. Reset cwnd to " <<  m_tcb->m_cWnd << ", ssthresh to " <<
                 m_tcb->m_ssThresh << ", restart from seqnum " << m_nextTxSequence);
   DoRetransmit ();                          // Retransmit the packet
@@ -2885,6 +3306,8 @@ TcpSocketBase::CancelAllTimers ()
   m_lastAckEvent.Cancel ();
   m_timewaitEvent.Cancel ();
   m_sendPendingDataEvent.Cancel ();
+  m_pacingEvent.Cancel ();
+  m_ackCoalescingEvent.Cancel ();
 }
 
 /* Move TCP to Time_Wait state and schedule a transition to Closed state */
@@ -3076,6 +3499,12 @@ TcpSocketBase::ReadOptions (const TcpHeader& header)
               ScaleSsThresh (m_sndScaleFactor);
             }
         }
+
+      if (m_sackEnabled)
+        {
+          m_sackEnabled = header.HasOption (TcpOption::SACKPERMITTED);
+          NS_LOG_INFO (m_node->GetId () << (m_sackEnabled ? " SACK permitted" : " SACK disabled"));
+        }
     }
 
   bool timestampAttribute = m_timestampEnabled;
@@ -3086,6 +3515,12 @@ TcpSocketBase::ReadOptions (const TcpHeader& header)
       m_timestampEnabled = true;
       ProcessOptionTimestamp (header.GetOption (TcpOption::TS));
     }
+
+  if (m_sackEnabled && (header.GetFlags () & TcpHeader::ACK)
+      && header.HasOption (TcpOption::SACK))
+    {
+      ProcessOptionSack (header.GetOption (TcpOption::SACK));
+    }
 }
 
 void
@@ -3099,10 +3534,23 @@ TcpSocketBase::AddOptions (TcpHeader& header)
       AddOptionWScale (header);
     }
 
+  // The SACK-permitted option is set only on SYN packets
+  if (m_sackEnabled && (header.GetFlags () & TcpHeader::SYN))
+    {
+      AddOptionSackPermitted (header);
+    }
+
   if (m_timestampEnabled)
     {
       AddOptionTimestamp (header);
     }
+
+  // The SACK option goes last, in the space left by the other options
+  if (m_sackEnabled && (header.GetFlags () & TcpHeader::ACK)
+      && !(header.GetFlags () & TcpHeader::SYN))
+    {
+      AddOptionSack (header);
+    }
 }
 
 void
@@ -3197,6 +3645,57 @@ TcpSocketBase::AddOptionTimestamp (TcpHeader& header)
                option->GetTimestamp () << " echo=" << m_timestampToEcho);
 }
 
+void
+TcpSocketBase::ProcessOptionSack (const Ptr<const TcpOption> option)
+{
+  NS_LOG_FUNCTION (this << option);
+
+  Ptr<const TcpOptionSack> sack = DynamicCast<const TcpOptionSack> (option);
+  if (m_txBuffer->Update (sack->GetSackList ()))
+    {
+      NS_LOG_INFO (m_node->GetId () << " Received " << sack->GetNumSackBlocks () << " SACK blocks, "
+                   << m_txBuffer->GetSacked () << " bytes SACKed");
+    }
+}
+
+void
+TcpSocketBase::AddOptionSackPermitted (TcpHeader &header)
+{
+  NS_LOG_FUNCTION (this << header);
+  NS_ASSERT (header.GetFlags () & TcpHeader::SYN);
+
+  header.AppendOption (CreateObject<TcpOptionSackPermitted> ());
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK-PERM");
+}
+
+void
+TcpSocketBase::AddOptionSack (TcpHeader& header)
+{
+  NS_LOG_FUNCTION (this << header);
+
+  TcpOptionSack::SackList list = m_rxBuffer->GetSackList ();
+  if (list.empty ())
+    {
+      return;
+    }
+
+  // Option space left, excluding the padding of the options already there
+  uint32_t space = 40 - (header.GetLength () * 4 - 20);
+  uint32_t maxBlocks = TcpOptionSack::GetMaxSackBlocks (space);
+  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+  for (TcpOptionSack::SackList::const_iterator it = list.begin ();
+       it != list.end () && option->GetNumSackBlocks () < maxBlocks; ++it)
+    {
+      option->AddSackBlock (*it);
+    }
+
+  if (option->GetNumSackBlocks () > 0)
+    {
+      header.AppendOption (option);
+      NS_LOG_INFO (m_node->GetId () << " Add option SACK, " << option->GetNumSackBlocks () << " blocks");
+    }
+}
+
 void TcpSocketBase::UpdateWindowSize (const TcpHeader &header)
 {
   NS_LOG_FUNCTION (this << header);
@@ -3298,6 +3797,12 @@ TcpSocketBase::UpdateCongState (TcpSocketState::TcpCongState_t oldValue,
   m_congStateTrace (oldValue, newValue);
 }
 
+void
+TcpSocketBase::UpdatePacingRateTrace (DataRate oldValue, DataRate newValue)
+{
+  m_pacingRateTrace (oldValue, newValue);
+}
+
 void
 TcpSocketBase::SetCongestionControlAlgorithm (Ptr<TcpCongestionOps> algo)
 {
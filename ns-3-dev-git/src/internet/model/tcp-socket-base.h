@@ -33,6 +33,7 @@
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-interface.h"
 #include "ns3/event-id.h"
+#include "ns3/data-rate.h"
 #include "tcp-tx-buffer.h"
 #include "tcp-rx-buffer.h"
 #include "rtt-estimator.h"
@@ -144,6 +145,17 @@ public:
    */
   static const char* const TcpCongStateName[TcpSocketState::CA_LAST_STATE];
 
+  /**
+   * \brief ECN state of the sender side of the connection (RFC 3168)
+   */
+  typedef enum
+  {
+    ECN_DISABLED, /**< ECN was not negotiated in the handshake */
+    ECN_IDLE,     /**< ECN is in use, no congestion is being signalled */
+    ECN_ECE_RCVD, /**< cWnd was reduced on an ECE, the CWR flag is not sent yet */
+    ECN_CWR_SENT  /**< CWR was sent, the reduction lasts until the window is acked */
+  } EcnState_t;
+
   // Congestion control
   TracedValue<uint32_t>  m_cWnd;            //!< Congestion window
   TracedValue<uint32_t>  m_ssThresh;        //!< Slow start threshold
@@ -155,6 +167,19 @@ public:
 
   TracedValue<TcpCongState_t> m_congState;    //!< State in the Congestion state machine
 
+  // Pacing
+  bool                   m_pacing;          //!< Pacing enabled
+  DataRate               m_maxPacingRate;   //!< Upper bound of the pacing rate
+  TracedValue<DataRate>  m_pacingRate;      //!< Current pacing rate
+  uint16_t               m_pacingSsRatio;   //!< Pacing gain in slow start, in percent
+  uint16_t               m_pacingCaRatio;   //!< Pacing gain in congestion avoidance, in percent
+
+  Time                   m_srtt;            //!< Smoothed RTT, zero until the first sample
+
+  // ECN
+  EcnState_t             m_ecnState;        //!< ECN state of the sender side
+  bool                   m_ecnEcho;         //!< Set the ECE flag on the outgoing ACKs
+
   /**
    * \brief Get cwnd in segments rather than bytes
    *
@@ -256,6 +281,54 @@ public:
  *
  * The algorithm is implemented in the ReceivedAck method.
  *
+ * Selective acknowledgments
+ * --------------------------
+ *
+ * The SACK option of RFC 2018 is negotiated in the three-way handshake when
+ * the attribute "Sack" is set to true on both ends. The receiver then reports
+ * the out-of-order blocks held by the TcpRxBuffer in every ACK, while the
+ * sender keeps the SACK scoreboard in the TcpTxBuffer and uses it for the
+ * conservative loss recovery of RFC 6675: the recovery starts as soon as the
+ * first hole is deemed lost, the congestion window is not inflated, and the
+ * transmissions during the recovery are clocked by the estimated number of
+ * bytes in flight (pipe), filling the holes before sending new data.
+ *
+ * Pacing
+ * --------------------------
+ *
+ * When the TcpSocketState attribute "EnablePacing" is true, the segments
+ * allowed by the window are not sent back-to-back: a timer releases them
+ * one at a time, at the pacing rate held in the TcpSocketState. The rate is
+ * updated at every ACK by the congestion control (see
+ * TcpCongestionOps::UpdatePacingRate), which by default sets it to cWnd / sRTT
+ * times a gain, and it is exported through the "PacingRate" trace source.
+ *
+ * ACK coalescing
+ * --------------------------
+ *
+ * With a non-zero "AckCoalescingTime", the window growth of the new ACKs
+ * received in Open state is not applied at every ACK: the acked segments are
+ * accumulated, and a single TcpCongestionOps::IncreaseWindowCumulative call
+ * applies them at the end of the interval. Any other event (a duplicate
+ * ACK, a change of the congestion state, a retransmission) applies the
+ * pending growth first. This trades a slightly delayed cWnd growth for far
+ * fewer congestion control calls and cWnd trace updates with many flows.
+ *
+ * Explicit congestion notification
+ * --------------------------
+ *
+ * With the attribute "UseEcn", or with a congestion control which needs it
+ * (see TcpCongestionOps::NeedsEcn), the socket negotiates ECN in the
+ * three-way handshake as RFC 3168 describes. It then sends its new data
+ * segments with the ECT(0) codepoint, and reports the CE codepoints of the
+ * data segments it receives to the congestion control, which decides
+ * whether the ACKs carry the ECE flag (see TcpCongestionOps::CwndEvent).
+ * An ACK with ECE reduces cWnd to the slow start threshold given by the
+ * congestion control, at most once per window of data, and the next new
+ * segment carries the CWR flag. The ACKs are also reported to the
+ * congestion control with their ECE flag (see TcpCongestionOps::InAckEvent),
+ * which lets DCTCP measure the extent of the congestion.
+ *
  */
 class TcpSocketBase : public TcpSocket
 {
@@ -353,6 +426,11 @@ public:
    */
   TracedCallback<TcpSocketState::TcpCongState_t, TcpSocketState::TcpCongState_t> m_congStateTrace;
 
+  /**
+   * \brief Callback pointer for pacing rate trace chaining
+   */
+  TracedCallback<DataRate, DataRate> m_pacingRateTrace;
+
   /**
    * \brief Callback function to hook to TcpSocketState congestion window
    * \param oldValue old cWnd value
@@ -375,6 +453,13 @@ public:
   void UpdateCongState (TcpSocketState::TcpCongState_t oldValue,
                        TcpSocketState::TcpCongState_t newValue);
 
+  /**
+   * \brief Callback function to hook to TcpSocketState pacing rate
+   * \param oldValue old pacing rate value
+   * \param newValue new pacing rate value
+   */
+  void UpdatePacingRateTrace (DataRate oldValue, DataRate newValue);
+
   /**
    * \brief Install a congestion control algorithm on this socket
    *
@@ -561,13 +646,80 @@ protected:
   /**
    * \brief Send as much pending data as possible according to the Tx window.
    *
-   * Note that this function did not implement the PSH flag.
+   * Note that this function did not implement the PSH flag. When pacing is
+   * enabled, a single segment is sent, and the next one is released by the
+   * pacing timer.
    *
    * \param withAck forces an ACK to be sent
    * \returns true if some data have been sent
    */
   bool SendPendingData (bool withAck = false);
 
+  /**
+   * \brief Start the pacing timer after a segment has been sent
+   *
+   * The timer lasts the transmission time of the segment at the current
+   * pacing rate.
+   *
+   * \param size size of the segment sent (bytes)
+   */
+  void PaceSegment (uint32_t size);
+
+  /**
+   * \brief Pacing timer expired: send the next segment, if any
+   */
+  void NotifyPacingPerformed (void);
+
+  /**
+   * \brief Add the segments acked by a new ACK to the coalesced batch
+   *
+   * The batch is applied when the coalescing interval expires, or before
+   * any event that needs an up-to-date cWnd.
+   *
+   * \param segmentsAcked count of segments acked, as given to IncreaseWindow
+   */
+  void CoalesceAck (uint32_t segmentsAcked);
+
+  /**
+   * \brief Apply the window growth of the coalesced ACKs, if any
+   */
+  void FlushCoalescedAcks (void);
+
+  /**
+   * \brief End of the coalescing interval: apply the batch and send
+   * what the grown window allows
+   */
+  void AckCoalescingTimeout (void);
+
+  /**
+   * \brief Whether the socket asks for ECN in the handshake
+   *
+   * \returns true if UseEcn is set or the congestion control needs ECN
+   */
+  bool EcnRequested (void) const;
+
+  /**
+   * \brief Process the ECN codepoint of a received ECT or CE packet
+   *
+   * Clear the echo on a CWR, report the codepoint to the congestion
+   * control and, if the echo changed, ACK the segments held by the
+   * delayed ACK with the previous echo.
+   *
+   * \param packet the incoming packet, starting with the TCP header
+   * \param ceMarked true if the packet carries the CE codepoint
+   */
+  void ReceivedEcnCodepoint (Ptr<const Packet> packet, bool ceMarked);
+
+  /**
+   * \brief Process the ECN information of a received ACK
+   *
+   * Report the ACK to the congestion control, end the last window
+   * reduction if the ACK covers it, and reduce cWnd on an ECE.
+   *
+   * \param tcpHeader the header of the ACK
+   */
+  void ReceivedEcnAck (const TcpHeader& tcpHeader);
+
   /**
    * \brief Extract at most maxSize bytes from the TxBuffer at sequence seq, add the
    *        TCP header, and send to TcpL4Protocol
@@ -898,6 +1050,29 @@ protected:
    * \param option Option from the packet
    */
   void ProcessOptionTimestamp (const Ptr<const TcpOption> option);
+  /**
+   * \brief Process the SACK option from the other side
+   *
+   * Update the scoreboard of the Tx buffer with the SACK blocks.
+   *
+   * \param option Option from the packet
+   */
+  void ProcessOptionSack (const Ptr<const TcpOption> option);
+  /**
+   * \brief Add the SACK-permitted option to the header
+   *
+   * \param header TcpHeader where the method should add the option
+   */
+  void AddOptionSackPermitted (TcpHeader &header);
+  /**
+   * \brief Add the SACK option to the header
+   *
+   * Report the most recent out-of-order blocks of the Rx buffer, as many as
+   * they fit in the option space left.
+   *
+   * \param header TcpHeader where the method should add the SACK option
+   */
+  void AddOptionSack (TcpHeader& header);
   /**
    * \brief Add the timestamp option to the header
    *
@@ -992,7 +1167,20 @@ protected:
   bool     m_timestampEnabled;    //!< Timestamp option enabled
   uint32_t m_timestampToEcho;     //!< Timestamp to echo
 
+  bool     m_sackEnabled;         //!< SACK option enabled
+
+  // ECN
+  bool             m_useEcn;      //!< Ask for ECN in the handshake
+  SequenceNumber32 m_ecnRecover;  //!< Highest Tx seqnum when cWnd was reduced on an ECE
+
   EventId m_sendPendingDataEvent; //!< micro-delay event to send pending data
+  EventId m_pacingEvent;          //!< Release of the next paced segment
+
+  // ACK coalescing
+  Time     m_ackCoalescingTime;   //!< Interval of the coalesced ACK batches (0 disables)
+  uint32_t m_coalescedSegsAcked;  //!< Segments acked by the pending batch
+  uint32_t m_coalescedAcks;       //!< ACKs in the pending batch
+  EventId  m_ackCoalescingEvent;  //!< End of the pending batch
 
   // Fast Retransmit and Recovery
   SequenceNumber32       m_recover;      //!< Previous highest Tx seqnum for fast recovery
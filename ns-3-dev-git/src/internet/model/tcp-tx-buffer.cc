@@ -57,7 +57,8 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_headOffset (0),
+    m_sackedBytes (0), m_highRxt (n)
 {
 }
 
@@ -112,6 +113,7 @@ TcpTxBuffer::Add (Ptr<Packet> p)
       if (p->GetSize () > 0)
         {
           m_data.push_back (p);
+          m_dataOffset.push_back (m_headOffset + m_size);
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -148,54 +150,38 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
     }
 
   // Extract data from the buffer and return
-  uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
-  Ptr<Packet> outPacket;
-  NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  uint64_t offset = m_headOffset + (seq - m_firstByteSeq.Get ());
+  uint32_t i = FindIndex (offset);
+  NS_LOG_LOGIC ("First byte found in packet #" << i << " of " << m_data.size ()
+                                               << " at stream offset " << m_dataOffset[i]);
+
+  uint32_t packetOffset = static_cast<uint32_t> (offset - m_dataOffset[i]);
+  uint32_t fragmentLength = m_data[i]->GetSize () - packetOffset;
+  if (fragmentLength >= s)
+    { // Data to be copied falls entirely in this packet
+      return m_data[i]->CreateFragment (packetOffset, s);
+    }
+
+  // This packet only fulfills part of the request
+  Ptr<Packet> outPacket = m_data[i]->CreateFragment (packetOffset, fragmentLength);
+  uint32_t remaining = s - fragmentLength;
+  while (remaining > 0)
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
-        }
-      else if (count + pktSize >= offset + s)
+      ++i;
+      uint32_t pktSize = m_data[i]->GetSize ();
+      if (pktSize >= remaining)
         { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
-                                                      << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-          break;
+          NS_LOG_LOGIC ("Last byte found in packet #" << i << ", packet len=" << pktSize);
+          outPacket->AddAtEnd (m_data[i]->CreateFragment (0, remaining));
+          remaining = 0;
         }
       else
         {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+          NS_LOG_LOGIC ("Appending to output the packet #" << i << " len=" << pktSize);
+          outPacket->AddAtEnd (m_data[i]);
+          remaining -= pktSize;
         }
-      count += pktSize;
+      NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
     }
   NS_ASSERT (outPacket->GetSize () == s);
   return outPacket;
@@ -206,6 +192,7 @@ TcpTxBuffer::SetHeadSequence (const SequenceNumber32& seq)
 {
   NS_LOG_FUNCTION (this << seq);
   m_firstByteSeq = seq;
+  m_highRxt = seq;
 }
 
 void
@@ -217,40 +204,252 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
+  // Pop the packets that are entirely behind the seqnum
   uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
-  uint32_t pktSize;
+  uint32_t discarded = std::min (offset, m_size);
+  uint64_t newHead = m_headOffset + discarded;
   NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  while (!m_data.empty () && m_dataOffset.front () + m_data.front ()->GetSize () <= newHead)
     {
-      if (offset > (*i)->GetSize ())
-        { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
-          m_size -= pktSize;
-          offset -= pktSize;
-          m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
-          NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
-        }
-      else if (offset > 0)
-        { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
-          m_size -= offset;
-          m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
-          break;
-        }
+      NS_LOG_LOGIC ("Removed one packet of size " << m_data.front ()->GetSize ());
+      m_data.pop_front ();
+      m_dataOffset.pop_front ();
+    }
+  // Part of the head packet may be behind the seqnum. Fragment
+  if (!m_data.empty () && m_dataOffset.front () < newHead)
+    {
+      uint32_t cut = static_cast<uint32_t> (newHead - m_dataOffset.front ());
+      uint32_t pktSize = m_data.front ()->GetSize () - cut;
+      m_data.front () = m_data.front ()->CreateFragment (cut, pktSize);
+      m_dataOffset.front () = newHead;
+      NS_LOG_LOGIC ("Fragmented one packet by size " << cut << ", new size=" << pktSize);
     }
+  m_headOffset = newHead;
+  m_size -= discarded;
+  m_firstByteSeq += discarded;
+
   // Catching the case of ACKing a FIN
   if (m_size == 0)
     {
       m_firstByteSeq = seq;
     }
+  // Trim the scoreboard to the data still in the buffer
+  while (!m_sacked.empty () && m_sacked.begin ()->second <= m_firstByteSeq.Get ())
+    {
+      m_sackedBytes -= m_sacked.begin ()->second - m_sacked.begin ()->first;
+      m_sacked.erase (m_sacked.begin ());
+    }
+  if (!m_sacked.empty () && m_sacked.begin ()->first < m_firstByteSeq.Get ())
+    {
+      SequenceNumber32 end = m_sacked.begin ()->second;
+      m_sackedBytes -= m_firstByteSeq.Get () - m_sacked.begin ()->first;
+      m_sacked.erase (m_sacked.begin ());
+      m_sacked[m_firstByteSeq] = end;
+    }
   NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer
                         <<" numPkts="<< m_data.size ());
   NS_ASSERT (m_firstByteSeq == seq);
 }
 
+uint32_t
+TcpTxBuffer::FindIndex (uint64_t offset) const
+{
+  NS_ASSERT (!m_dataOffset.empty ());
+  NS_ASSERT (offset >= m_headOffset && offset < m_headOffset + m_size);
+  // The first packet starting after the offset follows the one we look for
+  std::deque<uint64_t>::const_iterator it = std::upper_bound (m_dataOffset.begin (),
+                                                              m_dataOffset.end (), offset);
+  return static_cast<uint32_t> (it - m_dataOffset.begin ()) - 1;
+}
+
+bool
+TcpTxBuffer::Update (const TcpOptionSack::SackList &list)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t sackedBefore = m_sackedBytes;
+  SequenceNumber32 tail = TailSequence ();
+  for (TcpOptionSack::SackList::const_iterator it = list.begin (); it != list.end (); ++it)
+    {
+      SequenceNumber32 start = std::max (it->first, m_firstByteSeq.Get ());
+      SequenceNumber32 end = std::min (it->second, tail);
+      if (start >= end)
+        {
+          NS_LOG_LOGIC ("Ignoring SACK block [" << it->first << ";" << it->second << ")");
+          continue;
+        }
+      // Merge the block with the ranges it overlaps or touches
+      SackedMap::iterator i = m_sacked.upper_bound (start);
+      if (i != m_sacked.begin ())
+        {
+          SackedMap::iterator prev = i;
+          --prev;
+          if (prev->second >= start)
+            {
+              i = prev;
+            }
+        }
+      while (i != m_sacked.end () && i->first <= end)
+        {
+          start = std::min (start, i->first);
+          end = std::max (end, i->second);
+          m_sackedBytes -= i->second - i->first;
+          m_sacked.erase (i++);
+        }
+      m_sacked[start] = end;
+      m_sackedBytes += end - start;
+      NS_LOG_LOGIC ("SACKed range [" << start << ";" << end << ")");
+    }
+  return m_sackedBytes > sackedBefore;
+}
+
+void
+TcpTxBuffer::ResetScoreboard (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_sacked.clear ();
+  m_sackedBytes = 0;
+  m_highRxt = m_firstByteSeq;
+}
+
+uint32_t
+TcpTxBuffer::GetSacked (void) const
+{
+  return m_sackedBytes;
+}
+
+bool
+TcpTxBuffer::IsSacked (const SequenceNumber32 &seq) const
+{
+  SackedMap::const_iterator i = m_sacked.upper_bound (seq);
+  if (i == m_sacked.begin ())
+    {
+      return false;
+    }
+  --i;
+  return seq < i->second;
+}
+
+bool
+TcpTxBuffer::IsLost (const SequenceNumber32 &seq, uint32_t dupThresh, uint32_t segSize) const
+{
+  return seq < LossBoundary (dupThresh, segSize) && !IsSacked (seq);
+}
+
+bool
+TcpTxBuffer::NextSeg (SequenceNumber32 *seq, uint32_t *length, uint32_t dupThresh,
+                      uint32_t segSize, const SequenceNumber32 &highData, bool lostOnly) const
+{
+  NS_LOG_FUNCTION (this << dupThresh << segSize << highData << lostOnly);
+  // First byte above HighRxt that has not been SACKed
+  SequenceNumber32 start = std::max (m_highRxt, m_firstByteSeq.Get ());
+  SackedMap::const_iterator next = m_sacked.upper_bound (start);
+  if (next != m_sacked.begin ())
+    {
+      SackedMap::const_iterator prev = next;
+      --prev;
+      if (prev->second > start)
+        {
+          start = prev->second;
+        }
+    }
+  SequenceNumber32 end = std::min (highData, TailSequence ());
+  if (start >= end)
+    {
+      return false;
+    }
+  if (start >= LossBoundary (dupThresh, segSize))
+    { // Not lost (rule 1); rule 3 needs SACKed data above it
+      if (lostOnly || next == m_sacked.end ())
+        {
+          return false;
+        }
+    }
+  if (next != m_sacked.end ())
+    {
+      end = std::min (end, next->first);
+    }
+  *seq = start;
+  *length = std::min (segSize, static_cast<uint32_t> (end - start));
+  NS_LOG_LOGIC ("Next segment to retransmit " << *seq << " length " << *length);
+  return true;
+}
+
+uint32_t
+TcpTxBuffer::BytesInFlight (const SequenceNumber32 &highData, uint32_t dupThresh,
+                            uint32_t segSize) const
+{
+  if (highData <= m_firstByteSeq.Get ())
+    {
+      return 0;
+    }
+  // Not lost and not SACKed, plus retransmitted and not SACKed
+  SequenceNumber32 lost = std::min (LossBoundary (dupThresh, segSize), highData);
+  SequenceNumber32 rxt = std::min (std::max (m_highRxt, m_firstByteSeq.Get ()), highData);
+  return NotSacked (lost, highData) + NotSacked (m_firstByteSeq, rxt);
+}
+
+void
+TcpTxBuffer::MarkRetransmitted (const SequenceNumber32 &seq, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << seq << size);
+  m_highRxt = std::max (m_highRxt, seq + SequenceNumber32 (size));
+}
+
+void
+TcpTxBuffer::ResetHighRxt (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_highRxt = m_firstByteSeq;
+}
+
+SequenceNumber32
+TcpTxBuffer::LossBoundary (uint32_t dupThresh, uint32_t segSize) const
+{
+  // Walk the SACKed ranges downwards, until more than (dupThresh - 1) * segSize
+  // bytes above the boundary are SACKed, or dupThresh discontiguous ranges
+  // lie above it
+  uint32_t threshold = (dupThresh - 1) * segSize;
+  uint32_t above = 0;
+  uint32_t ranges = 0;
+  for (SackedMap::const_reverse_iterator i = m_sacked.rbegin (); i != m_sacked.rend (); ++i)
+    {
+      uint32_t len = i->second - i->first;
+      if (above + len > threshold)
+        {
+          return i->second - (threshold - above + 1);
+        }
+      if (++ranges >= dupThresh)
+        {
+          return i->first;
+        }
+      above += len;
+    }
+  return m_firstByteSeq;
+}
+
+uint32_t
+TcpTxBuffer::NotSacked (const SequenceNumber32 &start, const SequenceNumber32 &end) const
+{
+  if (start >= end)
+    {
+      return 0;
+    }
+  uint32_t count = end - start;
+  SackedMap::const_iterator i = m_sacked.upper_bound (start);
+  if (i != m_sacked.begin ())
+    {
+      --i;
+    }
+  for (; i != m_sacked.end () && i->first < end; ++i)
+    {
+      SequenceNumber32 s = std::max (i->first, start);
+      SequenceNumber32 e = std::min (i->second, end);
+      if (s < e)
+        {
+          count -= e - s;
+        }
+    }
+  return count;
+}
+
 } // namepsace ns3
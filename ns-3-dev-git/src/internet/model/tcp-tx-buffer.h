@@ -21,12 +21,14 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <deque>
+#include <map>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
 #include "ns3/sequence-number.h"
 #include "ns3/ptr.h"
+#include "ns3/tcp-option-sack.h"
 
 namespace ns3 {
 class Packet;
@@ -36,6 +38,20 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The packets handed over by the application are kept in a deque, together
+ * with the stream offset of their first byte. The offsets are monotonically
+ * increasing, so the packet holding a given sequence number is found with a
+ * binary search instead of a walk from the head of the buffer, and
+ * acknowledged packets are popped from the front in constant time.
+ *
+ * Next to the data, the buffer keeps the SACK scoreboard of \RFC{6675}: the
+ * ranges of the buffer that the receiver reported with SACK blocks, merged
+ * into disjoint ranges ordered by sequence number, and the highest sequence
+ * number retransmitted during the current loss recovery (HighRxt). The
+ * socket asks the scoreboard which bytes are deemed lost (IsLost), which
+ * segment to retransmit next (NextSeg) and how many bytes are still in the
+ * network (BytesInFlight).
  */
 class TcpTxBuffer : public Object
 {
@@ -127,14 +143,136 @@ public:
    */
   void DiscardUpTo (const SequenceNumber32& seq);
 
+  /**
+   * \brief Update the scoreboard with the blocks of a SACK option
+   *
+   * The blocks are clipped to the data in the buffer; blocks lying outside
+   * the buffer (e.g., D-SACK blocks) are ignored.
+   *
+   * \param list the SACK blocks received
+   * \returns true if the blocks reported bytes not SACKed before
+   */
+  bool Update (const TcpOptionSack::SackList &list);
+
+  /**
+   * \brief Forget every SACK information, as suggested by \RFC{2018} after
+   * a retransmission timeout
+   */
+  void ResetScoreboard (void);
+
+  /**
+   * \brief Get the number of bytes reported by SACK blocks
+   * \returns the number of SACKed bytes in the buffer
+   */
+  uint32_t GetSacked (void) const;
+
+  /**
+   * \brief Check if a byte has been reported by a SACK block
+   * \param seq sequence number of the byte
+   * \returns true if the byte has been SACKed
+   */
+  bool IsSacked (const SequenceNumber32 &seq) const;
+
+  /**
+   * \brief Check if a byte is deemed lost, as in IsLost () of \RFC{6675}
+   *
+   * A byte is lost when more than (dupThresh - 1) * segSize bytes with
+   * higher sequence numbers have been SACKed, or when dupThresh
+   * discontiguous SACKed ranges lie above it.
+   *
+   * \param seq sequence number of the byte
+   * \param dupThresh duplicate ACK threshold
+   * \param segSize sender maximum segment size
+   * \returns true if the byte is deemed lost
+   */
+  bool IsLost (const SequenceNumber32 &seq, uint32_t dupThresh, uint32_t segSize) const;
+
+  /**
+   * \brief Find the next segment to retransmit, as in NextSeg () of \RFC{6675}
+   *
+   * The first byte above HighRxt that is neither SACKed nor beyond highData
+   * is returned if it is deemed lost (rule 1) or, if lostOnly is false, if
+   * some data above it has been SACKed (rule 3). The length of the segment
+   * stops at the next SACKed range.
+   *
+   * \param seq sequence number of the segment, if any
+   * \param length length of the segment, if any
+   * \param dupThresh duplicate ACK threshold
+   * \param segSize sender maximum segment size
+   * \param highData highest sequence number transmitted + 1
+   * \param lostOnly if true, only segments deemed lost are returned
+   * \returns true if a segment to retransmit has been found
+   */
+  bool NextSeg (SequenceNumber32 *seq, uint32_t *length, uint32_t dupThresh,
+                uint32_t segSize, const SequenceNumber32 &highData, bool lostOnly) const;
+
+  /**
+   * \brief Estimate the bytes in the network, as in SetPipe () of \RFC{6675}
+   *
+   * Every byte below highData that is not SACKed is counted once if it is
+   * not deemed lost, and once more if it has been retransmitted.
+   *
+   * \param highData highest sequence number transmitted + 1
+   * \param dupThresh duplicate ACK threshold
+   * \param segSize sender maximum segment size
+   * \returns the estimated number of bytes in flight (pipe)
+   */
+  uint32_t BytesInFlight (const SequenceNumber32 &highData, uint32_t dupThresh,
+                          uint32_t segSize) const;
+
+  /**
+   * \brief Record a retransmission, advancing HighRxt
+   * \param seq sequence number of the retransmitted segment
+   * \param size size of the retransmitted segment
+   */
+  void MarkRetransmitted (const SequenceNumber32 &seq, uint32_t size);
+
+  /**
+   * \brief Restart the retransmission accounting at the head of the buffer,
+   * when a new loss recovery starts
+   */
+  void ResetHighRxt (void);
+
 private:
-  /// container for data stored in the buffer
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  /// Scoreboard: first sequence number -> last sequence number + 1 of the SACKed ranges
+  typedef std::map<SequenceNumber32, SequenceNumber32> SackedMap;
+
+  /**
+   * \brief Get the lowest sequence number not deemed lost
+   *
+   * Every byte below the boundary is lost, according to IsLost ().
+   *
+   * \param dupThresh duplicate ACK threshold
+   * \param segSize sender maximum segment size
+   * \returns the loss boundary, or the head sequence if nothing is lost
+   */
+  SequenceNumber32 LossBoundary (uint32_t dupThresh, uint32_t segSize) const;
+
+  /**
+   * \brief Count the bytes not SACKed in a range
+   * \param start first sequence number of the range
+   * \param end last sequence number of the range + 1
+   * \returns the number of bytes in [start, end) not SACKed
+   */
+  uint32_t NotSacked (const SequenceNumber32 &start, const SequenceNumber32 &end) const;
+
+
+  /**
+   * \brief Find the packet holding the byte at the given stream offset
+   * \param offset stream offset, must lie in [m_headOffset, m_headOffset + m_size)
+   * \returns the index of the packet in m_data
+   */
+  uint32_t FindIndex (uint64_t offset) const;
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //!< Number of data bytes
   uint32_t m_maxBuffer;                         //!< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //!< Corresponding data (may be null)
+  uint64_t m_headOffset;                        //!< Stream offset of the first byte in data
+  std::deque<Ptr<Packet> > m_data;              //!< Corresponding data (may be null)
+  std::deque<uint64_t> m_dataOffset;            //!< Stream offset of the first byte of each packet in m_data
+  SackedMap m_sacked;                           //!< SACKed ranges of the buffer
+  uint32_t m_sackedBytes;                       //!< Number of SACKed bytes
+  SequenceNumber32 m_highRxt;                   //!< Highest sequence number retransmitted + 1 (HighRxt)
 };
 
 } // namepsace ns3
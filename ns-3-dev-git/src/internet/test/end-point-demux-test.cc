@@ -0,0 +1,269 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv6-interface.h"
+#include "../model/ipv4-end-point.h"
+#include "../model/ipv4-end-point-demux.h"
+#include "../model/ipv6-end-point.h"
+#include "../model/ipv6-end-point-demux.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the match precedence of the IPv4 endpoint lookups, the
+ *        lookups of endpoints whose addresses change, and the lookups
+ *        among many connections.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Look up the endpoint of a packet, expecting a single one
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \returns the endpoint, or 0 if the lookup did not give a single one
+   */
+  Ipv4EndPoint *Lookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport);
+
+  Ipv4EndPointDemux *m_demux;              //!< Demux under test
+  Ptr<Ipv4Interface> m_interface;          //!< Incoming interface
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Lookups and ephemeral ports of the IPv4 endpoint demux")
+{
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxTestCase::Lookup (Ipv4Address daddr, uint16_t dport, Ipv4Address saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints endPoints = m_demux->Lookup (daddr, dport, saddr, sport, m_interface);
+  return endPoints.size () == 1 ? endPoints.front () : 0;
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  m_demux = new Ipv4EndPointDemux ();
+  m_interface = CreateObject<Ipv4Interface> ();
+  Ipv4Address local ("10.0.0.1");
+  Ipv4Address peer ("10.0.0.2");
+
+  Ipv4EndPoint *listener = m_demux->Allocate (80);
+  Ipv4EndPoint *bound = m_demux->Allocate (local, 80);
+  Ipv4EndPoint *connection = m_demux->Allocate (local, 80, peer, 1234);
+  NS_TEST_ASSERT_MSG_NE (connection, 0, "Connection not allocated");
+  Ipv4EndPoint *duplicate = m_demux->Allocate (local, 80);
+  NS_TEST_EXPECT_MSG_EQ (duplicate, 0, "Duplicate address and port allocated");
+  duplicate = m_demux->Allocate (local, 80, peer, 1234);
+  NS_TEST_EXPECT_MSG_EQ (duplicate, 0, "Duplicate connection allocated");
+
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer, 1234), connection, "Connection not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer, 1235), bound, "Bound endpoint not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (Ipv4Address ("10.0.0.3"), 80, peer, 1234), listener, "Listener not found");
+  NS_TEST_EXPECT_MSG_EQ (m_demux->Lookup (local, 81, peer, 1234, m_interface).size (), 0, "Wrong port matched");
+  NS_TEST_EXPECT_MSG_EQ (m_demux->SimpleLookup (local, 80, peer, 1234), connection, "Connection not found");
+
+  connection->SetRxEnabled (false);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer, 1234), bound, "Endpoint not receiving found");
+  connection->SetRxEnabled (true);
+
+  // a connection made by an unbound socket gets its addresses afterwards
+  Ipv4EndPoint *client = m_demux->Allocate ();
+  NS_TEST_ASSERT_MSG_NE (client, 0, "Ephemeral endpoint not allocated");
+  uint16_t port = client->GetLocalPort ();
+  NS_TEST_EXPECT_MSG_EQ (port, 49153, "Wrong first ephemeral port");
+  client->SetPeer (peer, 80);
+  client->SetLocalAddress (local);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, port, peer, 80), client, "Connected endpoint not found");
+  NS_TEST_EXPECT_MSG_EQ (m_demux->LookupLocal (local, port), true, "Local address and port not found");
+  m_demux->DeAllocate (client);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, port, peer, 80), 0, "Deallocated endpoint found");
+  NS_TEST_EXPECT_MSG_EQ (m_demux->LookupPortLocal (port), false, "Deallocated port in use");
+
+  m_demux->DeAllocate (connection);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer, 1234), bound, "Bound endpoint not found");
+
+  // many connections accepted by the listener
+  std::vector<Ipv4EndPoint *> connections;
+  for (uint32_t i = 0; i < 2000; ++i)
+    {
+      connections.push_back (m_demux->Allocate (local, 80, Ipv4Address (peer.Get () + i / 100), 1000 + i % 100));
+    }
+  for (uint32_t i = 0; i < 2000; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Lookup (local, 80, Ipv4Address (peer.Get () + i / 100), 1000 + i % 100),
+                             connections[i], "Connection " << i << " not found");
+    }
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer, 999), bound, "Bound endpoint not found");
+  for (uint32_t i = 0; i < 2000; i += 2)
+    {
+      m_demux->DeAllocate (connections[i]);
+    }
+  for (uint32_t i = 1; i < 2000; i += 2)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Lookup (local, 80, Ipv4Address (peer.Get () + i / 100), 1000 + i % 100),
+                             connections[i], "Connection " << i << " not found");
+    }
+  NS_TEST_EXPECT_MSG_EQ (Lookup (local, 80, peer, 1000), bound, "Bound endpoint not found");
+
+  // the ephemeral ports count up, skipping the ports in use, and wrap
+  Ipv4EndPoint *first = m_demux->Allocate ();
+  NS_TEST_EXPECT_MSG_EQ (first->GetLocalPort (), 49154, "Ephemeral port not counting up");
+  Ipv4EndPoint *reserved = m_demux->Allocate (Ipv4Address::GetAny (), 49160);
+  NS_TEST_EXPECT_MSG_NE (reserved, 0, "Port not allocated");
+  for (uint32_t expected = 49155; expected <= 65535; ++expected)
+    {
+      if (expected == 49160)
+        {
+          continue;
+        }
+      Ipv4EndPoint *endPoint = m_demux->Allocate ();
+      NS_TEST_ASSERT_MSG_NE (endPoint, 0, "Ephemeral port " << expected << " not allocated");
+      NS_TEST_ASSERT_MSG_EQ (endPoint->GetLocalPort (), expected, "Wrong ephemeral port");
+    }
+  Ipv4EndPoint *wrapped = m_demux->Allocate ();
+  NS_TEST_EXPECT_MSG_EQ (wrapped->GetLocalPort (), 49152, "Ephemeral port not wrapped");
+  wrapped = m_demux->Allocate ();
+  NS_TEST_EXPECT_MSG_EQ (wrapped->GetLocalPort (), 49153, "Ephemeral port not wrapped");
+  Ipv4EndPoint *exhausted = m_demux->Allocate ();
+  NS_TEST_EXPECT_MSG_EQ (exhausted, 0, "Ephemeral ports not exhausted");
+  m_demux->DeAllocate (first);
+  Ipv4EndPoint *freed = m_demux->Allocate ();
+  NS_TEST_EXPECT_MSG_EQ (freed->GetLocalPort (), 49154, "Free ephemeral port not found");
+
+  delete m_demux;
+  m_interface = 0;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the match precedence of the IPv6 endpoint lookups and the
+ *        lookups of endpoints whose addresses change.
+ */
+class Ipv6EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv6EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Look up the endpoint of a packet, expecting a single one
+   * \param demux the demux
+   * \param daddr destination address
+   * \param dport destination port
+   * \param saddr source address
+   * \param sport source port
+   * \returns the endpoint, or 0 if the lookup did not give a single one
+   */
+  static Ipv6EndPoint *Lookup (Ipv6EndPointDemux &demux, Ipv6Address daddr, uint16_t dport,
+                               Ipv6Address saddr, uint16_t sport);
+};
+
+Ipv6EndPointDemuxTestCase::Ipv6EndPointDemuxTestCase ()
+  : TestCase ("Lookups and ephemeral ports of the IPv6 endpoint demux")
+{
+}
+
+Ipv6EndPoint *
+Ipv6EndPointDemuxTestCase::Lookup (Ipv6EndPointDemux &demux, Ipv6Address daddr, uint16_t dport,
+                                   Ipv6Address saddr, uint16_t sport)
+{
+  Ipv6EndPointDemux::EndPoints endPoints = demux.Lookup (daddr, dport, saddr, sport, 0);
+  return endPoints.size () == 1 ? endPoints.front () : 0;
+}
+
+void
+Ipv6EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv6EndPointDemux demux;
+  Ipv6Address local ("2001:db8::1");
+  Ipv6Address peer ("2001:db8::2");
+
+  Ipv6EndPoint *listener = demux.Allocate (80);
+  Ipv6EndPoint *bound = demux.Allocate (local, 80);
+  Ipv6EndPoint *connection = demux.Allocate (local, 80, peer, 1234);
+  NS_TEST_ASSERT_MSG_NE (connection, 0, "Connection not allocated");
+  Ipv6EndPoint *duplicate = demux.Allocate (local, 80, peer, 1234);
+  NS_TEST_EXPECT_MSG_EQ (duplicate, 0, "Duplicate connection allocated");
+
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, peer, 1234), connection, "Connection not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, peer, 1235), bound, "Bound endpoint not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, Ipv6Address ("2001:db8::3"), 80, peer, 1234), listener, "Listener not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.SimpleLookup (local, 80, peer, 1234), connection, "Connection not found");
+
+  Ipv6EndPoint *client = demux.Allocate ();
+  uint16_t port = client->GetLocalPort ();
+  NS_TEST_EXPECT_MSG_EQ (port, 49153, "Wrong first ephemeral port");
+  client->SetPeer (peer, 80);
+  client->SetLocalAddress (local);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, port, peer, 80), client, "Connected endpoint not found");
+  client->SetLocalPort (8080);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 8080, peer, 80), client, "Endpoint with a new port not found");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (port), false, "Former port in use");
+
+  std::vector<Ipv6EndPoint *> connections;
+  for (uint32_t i = 0; i < 500; ++i)
+    {
+      connections.push_back (demux.Allocate (local, 80, peer, 2000 + i));
+    }
+  for (uint32_t i = 0; i < 500; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Lookup (demux, local, 80, peer, 2000 + i), connections[i],
+                             "Connection " << i << " not found");
+    }
+  demux.DeAllocate (connection);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, peer, 1234), bound, "Bound endpoint not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, peer, 2234), connections[234], "Connection not found");
+  Ipv6EndPoint *next = demux.Allocate ();
+  NS_TEST_EXPECT_MSG_EQ (next->GetLocalPort (), 49154, "Ephemeral port not counting up");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Endpoint demux TestSuite
+ */
+class EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  EndPointDemuxTestSuite () : TestSuite ("end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv6EndPointDemuxTestCase, TestCase::QUICK);
+  }
+};
+
+static EndPointDemuxTestSuite g_endPointDemuxTestSuite; //!< Static variable for test initialization
+
+} // namespace ns3
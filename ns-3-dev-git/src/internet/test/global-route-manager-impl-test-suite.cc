@@ -27,9 +27,88 @@
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
 #include <cstdlib> // for rand()
+#include <vector>
 
 using namespace ns3;
 
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase();
+  virtual void DoRun (void);
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase()
+  : TestCase ("CandidateQueueTestCase")
+{
+}
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  CandidateQueue candidate;
+  std::vector<SPFVertex *> vertices;
+
+  // vertex i is at distance i % 10, every third one being a network
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      SPFVertex *v = new SPFVertex;
+      v->SetVertexId (Ipv4Address (i + 1));
+      v->SetVertexIndex (i);
+      v->SetDistanceFromRoot (i % 10);
+      v->SetVertexType (i % 3 == 0 ? SPFVertex::VertexNetwork : SPFVertex::VertexRouter);
+      candidate.Push (v);
+      vertices.push_back (v);
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Size (), 100, "Wrong size");
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (41), vertices[41], "Find failed");
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (1000), 0, "Find found a missing vertex");
+
+  // vertex 99 gets a shorter path, and so does vertex 5
+  vertices[99]->SetDistanceFromRoot (0);
+  candidate.DecreaseKey (vertices[99]);
+  vertices[5]->SetDistanceFromRoot (4);
+  candidate.DecreaseKey (vertices[5]);
+
+  // the expected order: by distance, networks first, then as pushed or
+  // decreased
+  std::vector<SPFVertex *> expected;
+  for (uint32_t distance = 0; distance < 10; ++distance)
+    {
+      for (int type = 0; type < 2; ++type)
+        {
+          SPFVertex::VertexType vertexType = type == 0 ? SPFVertex::VertexNetwork : SPFVertex::VertexRouter;
+          for (uint32_t i = 0; i < 100; ++i)
+            {
+              if (i != 99 && i != 5
+                  && vertices[i]->GetDistanceFromRoot () == distance
+                  && vertices[i]->GetVertexType () == vertexType)
+                {
+                  expected.push_back (vertices[i]);
+                }
+            }
+          if (distance == 0 && vertexType == SPFVertex::VertexNetwork)
+            {
+              expected.push_back (vertices[99]);
+            }
+          if (distance == 4 && vertexType == SPFVertex::VertexRouter)
+            {
+              expected.push_back (vertices[5]);
+            }
+        }
+    }
+
+  for (uint32_t i = 0; i < expected.size (); ++i)
+    {
+      SPFVertex *top = candidate.Top ();
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ (top, v, "Top and Pop differ");
+      NS_TEST_ASSERT_MSG_EQ (v, expected[i], "Wrong vertex popped at " << i);
+      delete v;
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Empty (), true, "Queue not empty");
+  NS_TEST_ASSERT_MSG_EQ (candidate.Pop (), 0, "Pop from an empty queue");
+}
+
 class GlobalRouteManagerImplTestCase : public TestCase
 {
 public:
@@ -190,6 +269,14 @@ GlobalRouteManagerImplTestCase::DoRun (void)
   srmlsdb->Insert (lsa2->GetLinkStateId (), lsa2);
   srmlsdb->Insert (lsa3->GetLinkStateId (), lsa3);
   NS_ASSERT (lsa2 == srmlsdb->GetLSA (lsa2->GetLinkStateId ()));
+  NS_TEST_ASSERT_MSG_EQ (srmlsdb->GetLSA ("0.0.0.9"), 0, "Found a missing LSA");
+  NS_TEST_ASSERT_MSG_EQ (srmlsdb->GetNLSAs (), 4, "Wrong number of LSAs");
+  NS_TEST_ASSERT_MSG_EQ (srmlsdb->GetLSAIndex (lsa2->GetLinkStateId ()), 2, "Wrong LSA index");
+  NS_TEST_ASSERT_MSG_EQ (srmlsdb->GetLSAByIndex (3), lsa3, "Wrong LSA by index");
+  NS_TEST_ASSERT_MSG_EQ (srmlsdb->GetLSAIndex ("0.0.0.9"), GlobalRouteManagerLSDB::NO_INDEX, "Found a missing LSA index");
+  srmlsdb->Initialize ();
+  NS_TEST_ASSERT_MSG_EQ (srmlsdb->GetNeighborIndex (2, 4), 3, "Wrong neighbor of a point-to-point link");
+  NS_TEST_ASSERT_MSG_EQ (srmlsdb->GetNeighborIndex (2, 5), GlobalRouteManagerLSDB::NO_INDEX, "A stub link has a neighbor");
 
   // next, calculate routes based on the manually created LSDB
   GlobalRouteManagerImpl* srm = new GlobalRouteManagerImpl ();
@@ -220,6 +307,7 @@ public:
   GlobalRouteManagerImplTestSuite()
     : TestSuite ("global-route-manager-impl", UNIT)
   {
+    AddTestCase (new CandidateQueueTestCase (), TestCase::QUICK);
     AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
   }
 } g_globalRoutingManagerImplTestSuite;
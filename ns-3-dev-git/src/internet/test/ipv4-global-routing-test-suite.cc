@@ -15,15 +15,21 @@
  */
 
 #include <vector>
+#include <sstream>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/global-route-manager.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/node.h"
 #include "ns3/node-container.h"
+#include "ns3/node-list.h"
+#include "ns3/output-stream-wrapper.h"
 #include "ns3/packet.h"
 #include "ns3/simple-net-device-helper.h"
 #include "ns3/pointer.h"
@@ -419,6 +425,113 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check that recomputing the routes after a link change only recomputes
+ * the nodes whose routes depend on the link, and that these routes, as
+ * well as the routes computed by several threads, are the same as a
+ * full computation on a single thread.
+ */
+class Ipv4GlobalRoutingRecomputeTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingRecomputeTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \returns the routing tables of all the nodes
+   */
+  std::string GetRoutingTables (void);
+  /**
+   * Delete and compute all the routes again.
+   * \param threads the number of threads computing the routes
+   * \returns the routing tables of all the nodes
+   */
+  std::string ComputeRoutes (uint32_t threads);
+};
+
+Ipv4GlobalRoutingRecomputeTestCase::Ipv4GlobalRoutingRecomputeTestCase ()
+  : TestCase ("Recompute the routes affected by a link change")
+{
+}
+
+std::string
+Ipv4GlobalRoutingRecomputeTestCase::GetRoutingTables (void)
+{
+  std::ostringstream oss;
+  Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (&oss);
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      (*i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ()->PrintRoutingTable (stream);
+    }
+  return oss.str ();
+}
+
+std::string
+Ipv4GlobalRoutingRecomputeTestCase::ComputeRoutes (uint32_t threads)
+{
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (threads));
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  GlobalRouteManager::InitializeRoutes ();
+  return GetRoutingTables ();
+}
+
+// A ring of four routers, each with a host:
+//
+//   H0 -- R0 ---- R1 -- H1
+//         |       |
+//   H3 -- R3 ---- R2 -- H2
+//
+void
+Ipv4GlobalRoutingRecomputeTestCase::DoRun (void)
+{
+  NodeContainer routers;
+  routers.Create (4);
+  NodeContainer hosts;
+  hosts.Create (4);
+  InternetStackHelper internet;
+  internet.Install (routers);
+  internet.Install (hosts);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.252");
+  std::vector<Ipv4InterfaceContainer> ring;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      ring.push_back (ipv4.Assign (devHelper.Install (NodeContainer (routers.Get (i), routers.Get ((i + 1) % 4)))));
+      ipv4.NewNetwork ();
+    }
+  ipv4.SetBase ("10.2.0.0", "255.255.255.0");
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      ipv4.Assign (devHelper.Install (NodeContainer (hosts.Get (i), routers.Get (i))));
+      ipv4.NewNetwork ();
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::string tables = GetRoutingTables ();
+  NS_TEST_ASSERT_MSG_EQ (GlobalRouteManager::RecomputeRoutes (), 0, "Routes recomputed without a change");
+  NS_TEST_ASSERT_MSG_EQ (GetRoutingTables (), tables, "Routes changed without a change");
+
+  // Take the link between R2 and R3 down: the hosts of R0 and R1 keep the
+  // same default route.
+  std::pair<Ptr<Ipv4>, uint32_t> end2 = ring[2].Get (0);
+  std::pair<Ptr<Ipv4>, uint32_t> end3 = ring[2].Get (1);
+  end2.first->SetDown (end2.second);
+  end3.first->SetDown (end3.second);
+  NS_TEST_ASSERT_MSG_EQ (GlobalRouteManager::RecomputeRoutes (), 6, "Wrong number of nodes recomputed");
+  std::string before = tables;
+  tables = GetRoutingTables ();
+  NS_TEST_ASSERT_MSG_NE (tables, before, "Routes not changed by the link change");
+  NS_TEST_ASSERT_MSG_EQ (ComputeRoutes (1), tables, "Recomputed routes differ from a full computation");
+  NS_TEST_ASSERT_MSG_EQ (ComputeRoutes (4), tables, "Routes computed by several threads differ");
+
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (0));
+  Simulator::Destroy ();
+}
 
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
@@ -431,6 +544,7 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
 {
   AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
   AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingRecomputeTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
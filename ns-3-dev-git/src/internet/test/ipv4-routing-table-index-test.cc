@@ -0,0 +1,285 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-routing-table-index.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4RoutingTableIndex test: the index finds the same routes, in
+ * the same order, as a walk of the routing table.
+ */
+class Ipv4RoutingTableIndexTestCase : public TestCase
+{
+public:
+  Ipv4RoutingTableIndexTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4RoutingTableIndexTestCase::Ipv4RoutingTableIndexTestCase ()
+  : TestCase ("Index lookups match a walk of the table")
+{
+}
+
+void
+Ipv4RoutingTableIndexTestCase::DoRun (void)
+{
+  std::vector<Ipv4Address> networks;
+  std::vector<Ipv4Mask> masks;
+  networks.push_back (Ipv4Address ("10.1.1.1"));
+  masks.push_back (Ipv4Mask::GetOnes ());
+  networks.push_back (Ipv4Address ("10.1.1.0"));
+  masks.push_back (Ipv4Mask ("255.255.255.0"));
+  networks.push_back (Ipv4Address ("10.1.0.0"));
+  masks.push_back (Ipv4Mask ("255.255.0.0"));
+  networks.push_back (Ipv4Address ("10.1.1.0"));
+  masks.push_back (Ipv4Mask ("255.255.255.0"));
+  // a network address with bits set outside of its mask
+  networks.push_back (Ipv4Address ("10.2.3.4"));
+  masks.push_back (Ipv4Mask ("255.255.0.0"));
+  // a non-contiguous mask
+  networks.push_back (Ipv4Address ("10.0.0.1"));
+  masks.push_back (Ipv4Mask ("255.0.0.255"));
+  networks.push_back (Ipv4Address ("0.0.0.0"));
+  masks.push_back (Ipv4Mask::GetZero ());
+  networks.push_back (Ipv4Address ("10.1.1.1"));
+  masks.push_back (Ipv4Mask::GetOnes ());
+
+  Ipv4RoutingTableIndex index;
+  for (uint32_t i = 0; i < networks.size (); i++)
+    {
+      index.Add (networks[i], masks[i]);
+    }
+  NS_TEST_ASSERT_MSG_EQ (index.GetN (), networks.size (), "Wrong number of routes");
+
+  const char *dests[] = { "10.1.1.1", "10.1.1.2", "10.1.2.1", "10.2.9.9",
+                          "10.3.3.1", "11.1.1.1", "0.0.0.0" };
+  for (uint32_t d = 0; d < sizeof (dests) / sizeof (dests[0]); d++)
+    {
+      Ipv4Address dest (dests[d]);
+      std::vector<uint32_t> expected;
+      for (uint32_t i = 0; i < networks.size (); i++)
+        {
+          if (masks[i].IsMatch (dest, networks[i]))
+            {
+              expected.push_back (i);
+            }
+        }
+      std::vector<uint32_t> positions;
+      index.Lookup (dest, positions);
+      NS_TEST_ASSERT_MSG_EQ (positions.size (), expected.size (), "Wrong number of routes to " << dest);
+      for (uint32_t i = 0; i < expected.size (); i++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (positions[i], expected[i], "Wrong route to " << dest);
+        }
+    }
+
+  index.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (index.GetN (), 0, "Routes left after Clear");
+  std::vector<uint32_t> positions;
+  index.Lookup (Ipv4Address ("10.1.1.1"), positions);
+  NS_TEST_ASSERT_MSG_EQ (positions.size (), 0, "Route found after Clear");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4StaticRouting test: the indexed lookup keeps choosing the
+ * longest prefix, then the lowest metric, then the last route added, and
+ * follows the changes of the table.
+ */
+class Ipv4StaticRoutingIndexTestCase : public TestCase
+{
+public:
+  Ipv4StaticRoutingIndexTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4StaticRoutingIndexTestCase::Ipv4StaticRoutingIndexTestCase ()
+  : TestCase ("Static routing lookups through the index")
+{
+}
+
+void
+Ipv4StaticRoutingIndexTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (device);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+  ipv4->SetUp (interface);
+
+  Ipv4StaticRoutingHelper helper;
+  Ptr<Ipv4StaticRouting> routing = helper.GetStaticRouting (ipv4);
+  routing->SetDefaultRoute (Ipv4Address ("10.0.0.254"), interface);
+  routing->AddNetworkRouteTo (Ipv4Address ("10.2.0.0"), Ipv4Mask ("255.255.0.0"), Ipv4Address ("10.0.0.2"), interface, 5);
+  routing->AddNetworkRouteTo (Ipv4Address ("10.2.1.0"), Ipv4Mask ("255.255.255.0"), Ipv4Address ("10.0.0.3"), interface, 5);
+  routing->AddNetworkRouteTo (Ipv4Address ("10.2.1.0"), Ipv4Mask ("255.255.255.0"), Ipv4Address ("10.0.0.4"), interface, 1);
+  routing->AddNetworkRouteTo (Ipv4Address ("10.2.1.0"), Ipv4Mask ("255.255.255.0"), Ipv4Address ("10.0.0.5"), interface, 1);
+
+  Ipv4Header header;
+  Socket::SocketErrno err;
+  header.SetDestination (Ipv4Address ("10.2.1.1"));
+  Ptr<Ipv4Route> route = routing->RouteOutput (0, header, 0, err);
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route to 10.2.1.1");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.0.0.5"), "Wrong route to 10.2.1.1");
+  header.SetDestination (Ipv4Address ("10.2.2.1"));
+  route = routing->RouteOutput (0, header, 0, err);
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route to 10.2.2.1");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.0.0.2"), "Wrong route to 10.2.2.1");
+  header.SetDestination (Ipv4Address ("10.3.0.1"));
+  route = routing->RouteOutput (0, header, 0, err);
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route to 10.3.0.1");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.0.0.254"), "Wrong route to 10.3.0.1");
+  header.SetDestination (Ipv4Address ("10.0.0.7"));
+  route = routing->RouteOutput (0, header, 0, err);
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route to 10.0.0.7");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address::GetZero (), "Wrong route to 10.0.0.7");
+
+  // remove the /16 route, leaving the default route to 10.2.2.1
+  uint32_t n = routing->GetNRoutes ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (routing->GetRoute (i).GetDestNetworkMask () == Ipv4Mask ("255.255.0.0"))
+        {
+          routing->RemoveRoute (i);
+          break;
+        }
+    }
+  header.SetDestination (Ipv4Address ("10.2.2.1"));
+  route = routing->RouteOutput (0, header, 0, err);
+  NS_TEST_ASSERT_MSG_NE (route, 0, "No route to 10.2.2.1");
+  NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address ("10.0.0.254"), "Wrong route to 10.2.2.1 after removal");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4GlobalRouting test: the routes of more destinations than
+ * the route cache holds stay right, and the cached routes are reused
+ * until an interface changes.
+ */
+class Ipv4GlobalRoutingCacheTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingCacheTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRoutingCacheTestCase::Ipv4GlobalRoutingCacheTestCase ()
+  : TestCase ("Global routing lookups through the route cache")
+{
+}
+
+void
+Ipv4GlobalRoutingCacheTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  node->AddDevice (device);
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (device);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address ("10.0.0.1"), Ipv4Mask ("255.255.255.0")));
+  ipv4->SetUp (interface);
+
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  routing->SetIpv4 (ipv4);
+  // more destinations than the 4096 of the route cache
+  const uint32_t nDestinations = 6000;
+  for (uint32_t i = 0; i < nDestinations; i++)
+    {
+      routing->AddHostRouteTo (Ipv4Address (0x0b000000 + i), Ipv4Address (0x0a000002 + i % 200), interface);
+    }
+
+  Ipv4Header header;
+  Socket::SocketErrno err;
+  for (uint32_t pass = 0; pass < 2; pass++)
+    {
+      for (uint32_t i = 0; i < nDestinations; i++)
+        {
+          header.SetDestination (Ipv4Address (0x0b000000 + i));
+          Ptr<Ipv4Route> route = routing->RouteOutput (0, header, 0, err);
+          NS_TEST_ASSERT_MSG_NE (route, 0, "No route to " << header.GetDestination ());
+          NS_TEST_ASSERT_MSG_EQ (route->GetGateway (), Ipv4Address (0x0a000002 + i % 200),
+                                 "Wrong route to " << header.GetDestination ());
+          NS_TEST_ASSERT_MSG_EQ (route->GetSource (), Ipv4Address ("10.0.0.1"),
+                                 "Wrong source to " << header.GetDestination ());
+        }
+    }
+
+  header.SetDestination (Ipv4Address (0x0b000000));
+  Ptr<Ipv4Route> route = routing->RouteOutput (0, header, 0, err);
+  NS_TEST_ASSERT_MSG_EQ (routing->RouteOutput (0, header, 0, err), route, "Cached route not reused");
+  routing->NotifyInterfaceDown (interface);
+  NS_TEST_ASSERT_MSG_NE (routing->RouteOutput (0, header, 0, err), route, "Cached route kept after an interface change");
+
+  routing->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Ipv4RoutingTableIndex TestSuite
+ */
+class Ipv4RoutingTableIndexTestSuite : public TestSuite
+{
+public:
+  Ipv4RoutingTableIndexTestSuite ();
+};
+
+Ipv4RoutingTableIndexTestSuite::Ipv4RoutingTableIndexTestSuite ()
+  : TestSuite ("ipv4-routing-table-index", UNIT)
+{
+  AddTestCase (new Ipv4RoutingTableIndexTestCase (), TestCase::QUICK);
+  AddTestCase (new Ipv4StaticRoutingIndexTestCase (), TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingCacheTestCase (), TestCase::QUICK);
+}
+
+static Ipv4RoutingTableIndexTestSuite g_ipv4RoutingTableIndexTestSuite;
@@ -0,0 +1,239 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "tcp-general-test.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+#include "ns3/tcp-congestion-ops.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpAckCoalescingTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief A NewReno whose congestion avoidance grows cWnd by one segment per
+ *        acked segment, as a subclass overriding the hooks of NewReno
+ */
+class TcpNewRenoFastAvoidance : public TcpNewReno
+{
+protected:
+  virtual void CongestionAvoidance (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked)
+  {
+    tcb->m_cWnd += segmentsAcked * tcb->m_segmentSize;
+  }
+};
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that the NewReno growth of a batch of ACKs, computed in one
+ *        step, matches the growth of the same ACKs processed one by one
+ */
+class TcpNewRenoCumulativeTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param cWnd initial congestion window
+   * \param ssThresh slow start threshold
+   * \param segmentSize segment size
+   * \param segmentsAcked segments acked by the batch
+   * \param acks ACKs in the batch
+   * \param fastAvoidance whether to test a TcpNewRenoFastAvoidance
+   * \param name test description
+   */
+  TcpNewRenoCumulativeTestCase (uint32_t cWnd, uint32_t ssThresh, uint32_t segmentSize,
+                                uint32_t segmentsAcked, uint32_t acks, bool fastAvoidance,
+                                std::string name);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Create a TcpSocketState with the configured window
+   * \returns the TcpSocketState
+   */
+  Ptr<TcpSocketState> CreateState (void) const;
+
+  uint32_t m_cWnd;          //!< Initial congestion window
+  uint32_t m_ssThresh;      //!< Slow start threshold
+  uint32_t m_segmentSize;   //!< Segment size
+  uint32_t m_segmentsAcked; //!< Segments acked by the batch
+  uint32_t m_acks;          //!< ACKs in the batch
+  bool m_fastAvoidance;     //!< Whether to test a TcpNewRenoFastAvoidance
+};
+
+TcpNewRenoCumulativeTestCase::TcpNewRenoCumulativeTestCase (uint32_t cWnd, uint32_t ssThresh,
+                                                            uint32_t segmentSize,
+                                                            uint32_t segmentsAcked,
+                                                            uint32_t acks, bool fastAvoidance,
+                                                            std::string name)
+  : TestCase (name),
+    m_cWnd (cWnd),
+    m_ssThresh (ssThresh),
+    m_segmentSize (segmentSize),
+    m_segmentsAcked (segmentsAcked),
+    m_acks (acks),
+    m_fastAvoidance (fastAvoidance)
+{
+}
+
+Ptr<TcpSocketState>
+TcpNewRenoCumulativeTestCase::CreateState (void) const
+{
+  Ptr<TcpSocketState> state = CreateObject<TcpSocketState> ();
+  state->m_cWnd = m_cWnd;
+  state->m_ssThresh = m_ssThresh;
+  state->m_segmentSize = m_segmentSize;
+  return state;
+}
+
+void
+TcpNewRenoCumulativeTestCase::DoRun (void)
+{
+  Ptr<TcpNewReno> cong = CreateObject<TcpNewReno> ();
+  if (m_fastAvoidance)
+    {
+      cong = CreateObject<TcpNewRenoFastAvoidance> ();
+    }
+
+  Ptr<TcpSocketState> perAck = CreateState ();
+  for (uint32_t i = 0; i < m_acks; ++i)
+    {
+      cong->IncreaseWindow (perAck, m_segmentsAcked / m_acks + (i < m_segmentsAcked % m_acks ? 1 : 0));
+    }
+
+  Ptr<TcpSocketState> batch = CreateState ();
+  cong->IncreaseWindowCumulative (batch, m_segmentsAcked, m_acks);
+
+  NS_TEST_ASSERT_MSG_EQ (batch->m_cWnd.Get (), perAck->m_cWnd.Get (),
+                         "Coalesced growth differs from the per-ACK growth");
+  NS_TEST_ASSERT_MSG_EQ (batch->m_ssThresh.Get (), m_ssThresh, "ssThresh changed");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the coalescing of the ACKs by the sender
+ *
+ * Without losses, every cWnd change is the end of a batch: the changes are at
+ * least a coalescing interval apart, and fewer than the new ACKs received.
+ */
+class TcpAckCoalescingTestCase : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param coalescingTime coalescing interval of the sender
+   * \param name test description
+   */
+  TcpAckCoalescingTestCase (const Time &coalescingTime, std::string name);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+
+  virtual void CWndTrace (uint32_t oldValue, uint32_t newValue);
+  virtual void RcvAck (const Ptr<const TcpSocketState> tcb,
+                       const TcpHeader& h, SocketWho who);
+  virtual void FinalChecks ();
+
+  Time m_coalescingTime;      //!< Coalescing interval of the sender
+  SequenceNumber32 m_highAck; //!< Highest ACK received by the sender
+  uint32_t m_newAcks;         //!< New ACKs received by the sender
+  uint32_t m_cWndChanges;     //!< cWnd changes of the sender
+  Time m_lastChange;          //!< Time of the last cWnd change
+};
+
+TcpAckCoalescingTestCase::TcpAckCoalescingTestCase (const Time &coalescingTime, std::string name)
+  : TcpGeneralTest (name, 500, 200, Seconds (0.001), Seconds (0.05), Seconds (10),
+                    0xffff, 1, 500),
+    m_coalescingTime (coalescingTime),
+    m_highAck (0),
+    m_newAcks (0),
+    m_cWndChanges (0)
+{
+}
+
+Ptr<TcpSocketMsgBase>
+TcpAckCoalescingTestCase::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("AckCoalescingTime", TimeValue (m_coalescingTime));
+  return socket;
+}
+
+void
+TcpAckCoalescingTestCase::CWndTrace (uint32_t oldValue, uint32_t newValue)
+{
+  NS_LOG_INFO ("cWnd " << oldValue << " -> " << newValue);
+  if (m_cWndChanges > 1)
+    {
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (Simulator::Now () - m_lastChange, m_coalescingTime,
+                                   "cWnd changed twice in a coalescing interval");
+    }
+  ++m_cWndChanges;
+  m_lastChange = Simulator::Now ();
+}
+
+void
+TcpAckCoalescingTestCase::RcvAck (const Ptr<const TcpSocketState> tcb,
+                                  const TcpHeader& h, SocketWho who)
+{
+  if (who == SENDER && h.GetAckNumber () > m_highAck)
+    {
+      m_highAck = h.GetAckNumber ();
+      ++m_newAcks;
+    }
+}
+
+void
+TcpAckCoalescingTestCase::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_GT (m_cWndChanges, 1, "cWnd never grew");
+  NS_TEST_ASSERT_MSG_LT (m_cWndChanges, m_newAcks, "ACKs not coalesced");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP ACK coalescing TestSuite
+ */
+static class TcpAckCoalescingTestSuite : public TestSuite
+{
+public:
+  TcpAckCoalescingTestSuite ()
+    : TestSuite ("tcp-ack-coalescing", UNIT)
+  {
+    AddTestCase (new TcpNewRenoCumulativeTestCase (500, 10000, 500, 8, 8, false, "Slow start, one segment per ACK"), TestCase::QUICK);
+    AddTestCase (new TcpNewRenoCumulativeTestCase (500, 10000, 500, 16, 8, false, "Slow start, stretch ACKs"), TestCase::QUICK);
+    AddTestCase (new TcpNewRenoCumulativeTestCase (3000, 4000, 500, 10, 10, false, "Slow start to congestion avoidance"), TestCase::QUICK);
+    AddTestCase (new TcpNewRenoCumulativeTestCase (10000, 4000, 500, 7, 5, false, "Congestion avoidance"), TestCase::QUICK);
+    AddTestCase (new TcpNewRenoCumulativeTestCase (10000, 4000, 500, 3, 5, false, "Congestion avoidance, partial ACKs"), TestCase::QUICK);
+    AddTestCase (new TcpNewRenoCumulativeTestCase (3000, 4000, 500, 10, 10, true, "Slow start to an overridden congestion avoidance"), TestCase::QUICK);
+    AddTestCase (new TcpAckCoalescingTestCase (Seconds (0.05), "Coalesced ACKs of a bulk transfer"), TestCase::QUICK);
+  }
+
+} g_tcpAckCoalescingTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,577 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#include "ns3/test.h"
+#include "tcp-general-test.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/error-model.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/tcp-congestion-ops.h"
+
+#include <set>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpEcnTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Error model which sets the CE codepoint of the ECN-capable
+ *        data segments declared, as an AQM would, instead of dropping them
+ */
+class TcpCeMarkingModel : public ErrorModel
+{
+public:
+  TcpCeMarkingModel ()
+    : m_ectData (0),
+      m_ectControl (0)
+  {
+  }
+
+  /**
+   * \brief Add a data segment to mark
+   * \param seq sequence number of the segment
+   */
+  void AddSeqToMark (const SequenceNumber32 &seq)
+  {
+    m_seqToMark.insert (seq);
+  }
+
+  /**
+   * \param seq sequence number of a data segment
+   * \returns true if the segment has been marked
+   */
+  bool IsMarked (const SequenceNumber32 &seq) const
+  {
+    return m_marked.find (seq) != m_marked.end ();
+  }
+
+  /**
+   * \returns the number of ECN-capable data segments seen
+   */
+  uint32_t GetEctData (void) const
+  {
+    return m_ectData;
+  }
+
+  /**
+   * \returns the number of ECN-capable segments without data seen
+   */
+  uint32_t GetEctControl (void) const
+  {
+    return m_ectControl;
+  }
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p)
+  {
+    Ipv4Header ipHeader;
+    TcpHeader tcpHeader;
+    p->RemoveHeader (ipHeader);
+    p->PeekHeader (tcpHeader);
+    if (ipHeader.GetEcn () != Ipv4Header::ECN_NotECT)
+      {
+        if (p->GetSize () > tcpHeader.GetSerializedSize ())
+          {
+            ++m_ectData;
+          }
+        else
+          {
+            ++m_ectControl;
+          }
+      }
+    if (ipHeader.GetEcn () != Ipv4Header::ECN_NotECT
+        && m_seqToMark.find (tcpHeader.GetSequenceNumber ()) != m_seqToMark.end ())
+      {
+        ipHeader.SetEcn (Ipv4Header::ECN_CE);
+        m_marked.insert (tcpHeader.GetSequenceNumber ());
+      }
+    p->AddHeader (ipHeader);
+    return false;
+  }
+  virtual void DoReset (void)
+  {
+    m_marked.clear ();
+  }
+
+  std::set<SequenceNumber32> m_seqToMark; //!< Segments to mark
+  std::set<SequenceNumber32> m_marked;    //!< Segments marked
+  uint32_t m_ectData;                     //!< ECN-capable data segments seen
+  uint32_t m_ectControl;                  //!< ECN-capable segments without data seen
+};
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the negotiation of ECN in the three-way handshake, and that
+ *        only the data segments of an ECN-capable connection are ECT
+ */
+class EcnNegotiationTestCase : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Ends with ECN enabled
+   */
+  enum Configuration
+  {
+    DISABLED,
+    ENABLED_SENDER,
+    ENABLED_RECEIVER,
+    ENABLED
+  };
+
+  /**
+   * \brief Constructor
+   * \param conf ends with ECN enabled
+   * \param name test description
+   */
+  EcnNegotiationTestCase (Configuration conf, std::string name);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateReceiverSocket (Ptr<Node> node);
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual Ptr<ErrorModel> CreateSenderErrorModel ();
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void FinalChecks ();
+
+  Configuration m_configuration;       //!< Ends with ECN enabled
+  Ptr<TcpCeMarkingModel> m_toSender;   //!< Sees the segments of the receiver
+  Ptr<TcpCeMarkingModel> m_toReceiver; //!< Sees the segments of the sender
+};
+
+EcnNegotiationTestCase::EcnNegotiationTestCase (Configuration conf, std::string name)
+  : TcpGeneralTest (name, 500, 20, Seconds (0.01), Seconds (0.5), Seconds (10),
+                    0xffff, 10, 500),
+    m_configuration (conf)
+{
+}
+
+Ptr<TcpSocketMsgBase>
+EcnNegotiationTestCase::CreateReceiverSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateReceiverSocket (node);
+  socket->SetAttribute ("UseEcn", BooleanValue (m_configuration == ENABLED
+                                                || m_configuration == ENABLED_RECEIVER));
+  return socket;
+}
+
+Ptr<TcpSocketMsgBase>
+EcnNegotiationTestCase::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("UseEcn", BooleanValue (m_configuration == ENABLED
+                                                || m_configuration == ENABLED_SENDER));
+  return socket;
+}
+
+Ptr<ErrorModel>
+EcnNegotiationTestCase::CreateSenderErrorModel ()
+{
+  m_toSender = CreateObject<TcpCeMarkingModel> ();
+  return m_toSender;
+}
+
+Ptr<ErrorModel>
+EcnNegotiationTestCase::CreateReceiverErrorModel ()
+{
+  m_toReceiver = CreateObject<TcpCeMarkingModel> ();
+  return m_toReceiver;
+}
+
+void
+EcnNegotiationTestCase::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  NS_LOG_INFO (h);
+
+  uint8_t flags = h.GetFlags ();
+  uint8_t ecnFlags = flags & (TcpHeader::ECE | TcpHeader::CWR);
+  if ((flags & TcpHeader::SYN) && !(flags & TcpHeader::ACK))
+    {
+      bool expected = (m_configuration == ENABLED || m_configuration == ENABLED_SENDER);
+      NS_TEST_ASSERT_MSG_EQ ((ecnFlags == (TcpHeader::ECE | TcpHeader::CWR)), expected,
+                             "Wrong ECN-setup SYN");
+    }
+  else if (flags & TcpHeader::SYN)
+    {
+      bool expected = (m_configuration == ENABLED);
+      NS_TEST_ASSERT_MSG_EQ ((ecnFlags == TcpHeader::ECE), expected, "Wrong ECN-setup SYN-ACK");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) ecnFlags, 0, "ECN flags without congestion");
+    }
+}
+
+void
+EcnNegotiationTestCase::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_EQ ((m_toReceiver->GetEctData () > 0), (m_configuration == ENABLED),
+                         "ECN-capable segments sent or not sent unexpectedly");
+  NS_TEST_ASSERT_MSG_EQ (m_toReceiver->GetEctControl (), 0, "ECN-capable control segment");
+  NS_TEST_ASSERT_MSG_EQ (m_toSender->GetEctData () + m_toSender->GetEctControl (), 0,
+                         "ECN-capable segment from the receiver");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the reaction of a connection to a CE mark (RFC 3168)
+ *
+ * The receiver echoes the mark until the sender tells with CWR that it
+ * has reduced its window; the sender reduces its window once, without
+ * entering the loss recovery.
+ */
+class EcnReactionTestCase : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param name test description
+   */
+  EcnReactionTestCase (std::string name);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateReceiverSocket (Ptr<Node> node);
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void Rx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void CWndTrace (uint32_t oldValue, uint32_t newValue);
+  virtual void CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                               const TcpSocketState::TcpCongState_t newValue);
+  virtual void RTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who);
+  virtual void FinalChecks ();
+
+  Ptr<TcpCeMarkingModel> m_marker; //!< Marks the data segments
+  bool m_ceReceived;               //!< The receiver got a marked segment
+  bool m_cwrReceived;              //!< The receiver got the CWR flag
+  uint32_t m_eceSent;              //!< ACKs with ECE sent by the receiver
+  uint32_t m_cwrSent;              //!< Segments with CWR sent by the sender
+  uint32_t m_reductions;           //!< Decreases of the congestion window
+};
+
+EcnReactionTestCase::EcnReactionTestCase (std::string name)
+  : TcpGeneralTest (name, 500, 100, Seconds (0.01), Seconds (0.05), Seconds (10),
+                    0xffff, 1, 500),
+    m_ceReceived (false),
+    m_cwrReceived (false),
+    m_eceSent (0),
+    m_cwrSent (0),
+    m_reductions (0)
+{
+}
+
+Ptr<TcpSocketMsgBase>
+EcnReactionTestCase::CreateReceiverSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateReceiverSocket (node);
+  socket->SetAttribute ("UseEcn", BooleanValue (true));
+  return socket;
+}
+
+Ptr<TcpSocketMsgBase>
+EcnReactionTestCase::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("UseEcn", BooleanValue (true));
+  return socket;
+}
+
+Ptr<ErrorModel>
+EcnReactionTestCase::CreateReceiverErrorModel ()
+{
+  m_marker = CreateObject<TcpCeMarkingModel> ();
+  m_marker->AddSeqToMark (SequenceNumber32 (5001));
+  return m_marker;
+}
+
+void
+EcnReactionTestCase::Rx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who == RECEIVER && m_marker->IsMarked (h.GetSequenceNumber ()))
+    {
+      m_ceReceived = true;
+    }
+  if (who == RECEIVER && (h.GetFlags () & (TcpHeader::SYN | TcpHeader::CWR)) == TcpHeader::CWR)
+    {
+      m_cwrReceived = true;
+    }
+}
+
+void
+EcnReactionTestCase::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (h.GetFlags () & TcpHeader::SYN)
+    {
+      return;
+    }
+
+  if (who == RECEIVER)
+    {
+      bool ece = (h.GetFlags () & TcpHeader::ECE) != 0;
+      NS_TEST_ASSERT_MSG_EQ (ece, (m_ceReceived && !m_cwrReceived),
+                             "ECE not echoed between the mark and the CWR");
+      if (ece)
+        {
+          ++m_eceSent;
+        }
+    }
+  else if (h.GetFlags () & TcpHeader::CWR)
+    {
+      NS_TEST_ASSERT_MSG_GT (p->GetSize (), h.GetSerializedSize (), "CWR on a control segment");
+      ++m_cwrSent;
+    }
+}
+
+void
+EcnReactionTestCase::CWndTrace (uint32_t oldValue, uint32_t newValue)
+{
+  if (newValue < oldValue)
+    {
+      ++m_reductions;
+    }
+}
+
+void
+EcnReactionTestCase::CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                                     const TcpSocketState::TcpCongState_t newValue)
+{
+  NS_TEST_ASSERT_MSG_EQ (newValue, TcpSocketState::CA_OPEN, "Loss recovery without losses");
+}
+
+void
+EcnReactionTestCase::RTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who)
+{
+  NS_TEST_ASSERT_MSG_EQ (true, false, "RTO expired without losses");
+}
+
+void
+EcnReactionTestCase::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_EQ (m_marker->IsMarked (SequenceNumber32 (5001)), true,
+                         "The segment was not ECN-capable");
+  NS_TEST_ASSERT_MSG_GT (m_eceSent, 0, "The mark was not echoed");
+  NS_TEST_ASSERT_MSG_EQ (m_cwrSent, 1, "Wrong number of CWR segments");
+  NS_TEST_ASSERT_MSG_EQ (m_reductions, 1, "Wrong number of window reductions");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that a DCTCP receiver echoes exactly which segments were
+ *        marked, and that the sender estimates the fraction of marks
+ */
+class DctcpEchoTestCase : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param name test description
+   */
+  DctcpEchoTestCase (std::string name);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void Rx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void RTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who);
+  virtual void FinalChecks ();
+
+  Ptr<TcpCeMarkingModel> m_marker; //!< Marks the data segments
+  Ptr<TcpDctcp> m_senderCc;        //!< Congestion control of the sender
+  bool m_lastCe;                   //!< The last segment received was marked
+  uint32_t m_eceSent;              //!< ACKs with ECE sent by the receiver
+  uint32_t m_ackSent;              //!< ACKs without ECE sent by the receiver
+};
+
+DctcpEchoTestCase::DctcpEchoTestCase (std::string name)
+  : TcpGeneralTest (name, 500, 100, Seconds (0.01), Seconds (0.05), Seconds (10),
+                    0xffff, 1, 500, TcpDctcp::GetTypeId ()),
+    m_lastCe (false),
+    m_eceSent (0),
+    m_ackSent (0)
+{
+}
+
+Ptr<TcpSocketMsgBase>
+DctcpEchoTestCase::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  m_senderCc = CreateObject<TcpDctcp> ();
+  socket->SetCongestionControlAlgorithm (m_senderCc);
+  return socket;
+}
+
+Ptr<ErrorModel>
+DctcpEchoTestCase::CreateReceiverErrorModel ()
+{
+  m_marker = CreateObject<TcpCeMarkingModel> ();
+  for (uint32_t seq = 5001; seq <= 10001; seq += 1000)
+    {
+      m_marker->AddSeqToMark (SequenceNumber32 (seq));
+    }
+  return m_marker;
+}
+
+void
+DctcpEchoTestCase::Rx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who == RECEIVER && p->GetSize () > h.GetSerializedSize ())
+    {
+      m_lastCe = m_marker->IsMarked (h.GetSequenceNumber ());
+    }
+}
+
+void
+DctcpEchoTestCase::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who != RECEIVER || (h.GetFlags () & TcpHeader::SYN))
+    {
+      return;
+    }
+
+  // Each ACK echoes the mark of the last segment it acks
+  bool ece = (h.GetFlags () & TcpHeader::ECE) != 0;
+  NS_TEST_ASSERT_MSG_EQ (ece, m_lastCe, "The ACK " << h << " does not echo the mark exactly");
+  if (ece)
+    {
+      ++m_eceSent;
+    }
+  else
+    {
+      ++m_ackSent;
+    }
+}
+
+void
+DctcpEchoTestCase::RTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who)
+{
+  NS_TEST_ASSERT_MSG_EQ (true, false, "RTO expired without losses");
+}
+
+void
+DctcpEchoTestCase::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_GT (m_eceSent, 0, "The marks were not echoed");
+  NS_TEST_ASSERT_MSG_GT (m_ackSent, m_eceSent, "Unmarked segments echoed");
+  NS_TEST_ASSERT_MSG_LT (m_senderCc->GetAlpha (), 1024, "Alpha did not decay");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the estimate of the fraction of marks of DCTCP, and the
+ *        window reduction which follows from it
+ */
+class DctcpAlphaTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   */
+  DctcpAlphaTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DctcpAlphaTestCase::DctcpAlphaTestCase ()
+  : TestCase ("DCTCP alpha and slow start threshold")
+{
+}
+
+void
+DctcpAlphaTestCase::DoRun (void)
+{
+  Ptr<TcpSocketState> tcb = CreateObject<TcpSocketState> ();
+  tcb->m_segmentSize = 500;
+  tcb->m_cWnd = 10000;
+  Ptr<TcpDctcp> cc = CreateObject<TcpDctcp> ();
+
+  NS_TEST_ASSERT_MSG_EQ (cc->NeedsEcn (), true, "DCTCP does not need ECN");
+  NS_TEST_ASSERT_MSG_EQ (cc->GetAlpha (), 1024, "Wrong initial alpha");
+
+  // Half of a window marked: alpha = 1024 * 15/16 + 1024 / 2 / 16
+  cc->InAckEvent (tcb, 5000, true);
+  NS_TEST_ASSERT_MSG_EQ (cc->GetAlpha (), 1024, "Alpha updated before a window");
+  cc->InAckEvent (tcb, 5000, false);
+  NS_TEST_ASSERT_MSG_EQ (cc->GetAlpha (), 992, "Wrong alpha after half a window marked");
+
+  // The window is reduced by alpha / 2
+  uint32_t ssThresh = cc->GetSsThresh (tcb, 10000);
+  NS_TEST_ASSERT_MSG_EQ (ssThresh, 10000 - ((10000 * 992) >> 11), "Wrong slow start threshold");
+
+  // A window without marks
+  cc->InAckEvent (tcb, 10000, false);
+  NS_TEST_ASSERT_MSG_EQ (cc->GetAlpha (), 930, "Wrong alpha after a window without marks");
+
+  // The threshold never goes below two segments
+  tcb->m_cWnd = 1000;
+  cc->SetAttribute ("AlphaOnInit", UintegerValue (1024));
+  NS_TEST_ASSERT_MSG_EQ (cc->GetSsThresh (tcb, 1000), 1000, "Threshold below two segments");
+
+  // The receiver echoes exactly the last codepoint
+  cc->CwndEvent (tcb, TcpCongestionOps::CA_EVENT_ECN_IS_CE);
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_ecnEcho, true, "CE not echoed");
+  cc->CwndEvent (tcb, TcpCongestionOps::CA_EVENT_ECN_NO_CE);
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_ecnEcho, false, "Echo latched by DCTCP");
+
+  // while the classic echo is latched until the CWR
+  Ptr<TcpNewReno> reno = CreateObject<TcpNewReno> ();
+  NS_TEST_ASSERT_MSG_EQ (reno->NeedsEcn (), false, "NewReno needs ECN");
+  reno->CwndEvent (tcb, TcpCongestionOps::CA_EVENT_ECN_IS_CE);
+  reno->CwndEvent (tcb, TcpCongestionOps::CA_EVENT_ECN_NO_CE);
+  NS_TEST_ASSERT_MSG_EQ (tcb->m_ecnEcho, true, "Classic echo not latched");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP ECN and DCTCP TestSuite
+ */
+static class TcpEcnTestSuite : public TestSuite
+{
+public:
+  TcpEcnTestSuite ()
+    : TestSuite ("tcp-ecn", UNIT)
+  {
+    AddTestCase (new EcnNegotiationTestCase (EcnNegotiationTestCase::ENABLED, "ECN enabled"), TestCase::QUICK);
+    AddTestCase (new EcnNegotiationTestCase (EcnNegotiationTestCase::DISABLED, "ECN disabled"), TestCase::QUICK);
+    AddTestCase (new EcnNegotiationTestCase (EcnNegotiationTestCase::ENABLED_SENDER, "ECN enabled only on the client"), TestCase::QUICK);
+    AddTestCase (new EcnNegotiationTestCase (EcnNegotiationTestCase::ENABLED_RECEIVER, "ECN enabled only on the server"), TestCase::QUICK);
+    AddTestCase (new EcnReactionTestCase ("ECN reaction to a CE mark"), TestCase::QUICK);
+    AddTestCase (new DctcpEchoTestCase ("DCTCP echo of the CE marks"), TestCase::QUICK);
+    AddTestCase (new DctcpAlphaTestCase (), TestCase::QUICK);
+  }
+
+} g_tcpEcnTestSuite;
+
+} // namespace ns3
@@ -22,6 +22,8 @@
 #include "ns3/tcp-option.h"
 #include "ns3/private/tcp-option-winscale.h"
 #include "ns3/private/tcp-option-ts.h"
+#include "ns3/private/tcp-option-sack-permitted.h"
+#include "ns3/tcp-option-sack.h"
 
 #include <string.h>
 
@@ -164,6 +166,64 @@ TcpOptionTSTestCase::DoTeardown ()
 {
 }
 
+class TcpOptionSackTestCase : public TestCase
+{
+public:
+  TcpOptionSackTestCase (std::string name, uint32_t blocks);
+
+private:
+  virtual void DoRun (void);
+  virtual void DoTeardown (void);
+
+  uint32_t m_blocks;
+};
+
+
+TcpOptionSackTestCase::TcpOptionSackTestCase (std::string name, uint32_t blocks)
+  : TestCase (name),
+    m_blocks (blocks)
+{
+}
+
+void
+TcpOptionSackTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+
+  TcpOptionSack opt;
+  for (uint32_t i = 0; i < m_blocks; ++i)
+    {
+      SequenceNumber32 left (x->GetInteger ());
+      opt.AddSackBlock (TcpOptionSack::SackBlock (left, left + SequenceNumber32 (x->GetInteger (1, 65535))));
+    }
+  NS_TEST_EXPECT_MSG_EQ (opt.GetSerializedSize (), 2 + 8 * m_blocks, "Wrong option size");
+
+  Buffer buffer;
+  buffer.AddAtStart (opt.GetSerializedSize ());
+  opt.Serialize (buffer.Begin ());
+
+  Buffer::Iterator start = buffer.Begin ();
+  NS_TEST_EXPECT_MSG_EQ (start.PeekU8 (), TcpOption::SACK, "Different kind found");
+
+  TcpOptionSack copy;
+  NS_TEST_EXPECT_MSG_EQ (copy.Deserialize (start), opt.GetSerializedSize (), "Different size read");
+  NS_TEST_EXPECT_MSG_EQ (copy.GetNumSackBlocks (), m_blocks, "Different number of blocks found");
+  NS_TEST_EXPECT_MSG_EQ ((copy.GetSackList () == opt.GetSackList ()), true, "Different blocks found");
+
+  // The permitted option is just a kind and a length
+  TcpOptionSackPermitted perm;
+  NS_TEST_EXPECT_MSG_EQ (perm.GetSerializedSize (), 2, "Wrong SACK-permitted size");
+  buffer.AddAtStart (perm.GetSerializedSize ());
+  perm.Serialize (buffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().PeekU8 (), TcpOption::SACKPERMITTED, "Different kind found");
+  NS_TEST_EXPECT_MSG_EQ (perm.Deserialize (buffer.Begin ()), 2, "Different size read");
+}
+
+void
+TcpOptionSackTestCase::DoTeardown ()
+{
+}
+
 static class TcpOptionTestSuite : public TestSuite
 {
 public:
@@ -176,6 +236,10 @@ public:
                                               "scale value", i), TestCase::QUICK);
       }
     AddTestCase (new TcpOptionTSTestCase ("Testing serialization of random values for timestamp"), TestCase::QUICK);
+    for (uint32_t i = 1; i <= 4; ++i)
+      {
+        AddTestCase (new TcpOptionSackTestCase ("Testing serialization of SACK blocks", i), TestCase::QUICK);
+      }
   }
 
 } g_TcpOptionTestSuite;
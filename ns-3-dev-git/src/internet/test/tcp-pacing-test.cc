@@ -0,0 +1,164 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "tcp-general-test.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+#include "ns3/config.h"
+#include "ns3/data-rate.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpPacingTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the spacing of the data segments sent by the sender
+ *
+ * With pacing, every segment leaves at least its transmission time at the
+ * pacing rate after the previous one, and the rate follows cWnd / sRTT. Without
+ * pacing, the window is sent in back-to-back bursts.
+ */
+class TcpPacingTestCase : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param pacing enable pacing on the sender
+   * \param name test description
+   */
+  TcpPacingTestCase (bool pacing, std::string name);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void FinalChecks ();
+
+  /**
+   * \brief Pacing rate trace of the sender
+   * \param oldValue old pacing rate
+   * \param newValue new pacing rate
+   */
+  void PacingRateTrace (DataRate oldValue, DataRate newValue);
+
+  bool m_pacing;          //!< Pacing enabled on the sender
+  DataRate m_rate;        //!< Current pacing rate of the sender
+  uint32_t m_rateUpdates; //!< Number of changes of the pacing rate
+  Time m_lastTx;          //!< Time of the last data segment
+  Time m_nextTx;          //!< Earliest time allowed for the next data segment
+  bool m_firstTx;         //!< No data segment sent yet
+  uint32_t m_bursts;      //!< Number of data segments sent back-to-back
+};
+
+TcpPacingTestCase::TcpPacingTestCase (bool pacing, std::string name)
+  : TcpGeneralTest (name, 500, 200, Seconds (0.0001), Seconds (0.05), Seconds (10),
+                    0xffff, 10, 500),
+    m_pacing (pacing),
+    m_rateUpdates (0),
+    m_firstTx (true),
+    m_bursts (0)
+{
+}
+
+Ptr<TcpSocketMsgBase>
+TcpPacingTestCase::CreateSenderSocket (Ptr<Node> node)
+{
+  // Pacing is an attribute of the TcpSocketState created by the socket
+  Config::SetDefault ("ns3::TcpSocketState::EnablePacing", BooleanValue (m_pacing));
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  Config::SetDefault ("ns3::TcpSocketState::EnablePacing", BooleanValue (false));
+
+  socket->TraceConnectWithoutContext ("PacingRate",
+                                      MakeCallback (&TcpPacingTestCase::PacingRateTrace, this));
+  m_rate = DataRate ("4Gb/s");
+  return socket;
+}
+
+void
+TcpPacingTestCase::PacingRateTrace (DataRate oldValue, DataRate newValue)
+{
+  NS_LOG_INFO ("Pacing rate " << oldValue << " -> " << newValue);
+  NS_TEST_ASSERT_MSG_EQ (m_pacing, true, "Pacing rate updated without pacing");
+  NS_TEST_ASSERT_MSG_GT (newValue.GetBitRate (), 0, "Null pacing rate");
+  m_rate = newValue;
+  ++m_rateUpdates;
+}
+
+void
+TcpPacingTestCase::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  uint32_t size = p->GetSize () - h.GetSerializedSize ();
+  if (who != SENDER || size == 0)
+    {
+      return;
+    }
+
+  NS_LOG_INFO ("\tSENDER Tx " << h << " size=" << size);
+  if (!m_firstTx)
+    {
+      if (m_pacing)
+        {
+          NS_TEST_ASSERT_MSG_EQ ((Simulator::Now () >= m_nextTx), true,
+                                 "Segment sent before the pacing timer expired");
+        }
+      if (Simulator::Now () == m_lastTx)
+        {
+          ++m_bursts;
+        }
+    }
+  m_firstTx = false;
+  m_lastTx = Simulator::Now ();
+  m_nextTx = m_lastTx + m_rate.CalculateBytesTxTime (size);
+}
+
+void
+TcpPacingTestCase::FinalChecks ()
+{
+  if (m_pacing)
+    {
+      NS_TEST_ASSERT_MSG_GT (m_rateUpdates, 0, "Pacing rate never updated");
+      NS_TEST_ASSERT_MSG_EQ (m_bursts, 0, "Back-to-back segments with pacing");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_GT (m_bursts, 0, "No burst without pacing");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP pacing TestSuite
+ */
+static class TcpPacingTestSuite : public TestSuite
+{
+public:
+  TcpPacingTestSuite ()
+    : TestSuite ("tcp-pacing", UNIT)
+  {
+    AddTestCase (new TcpPacingTestCase (true, "Paced segments"), TestCase::QUICK);
+    AddTestCase (new TcpPacingTestCase (false, "Unpaced segments"), TestCase::QUICK);
+  }
+
+} g_tcpPacingTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-rx-buffer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check reassembly of reordered and overlapping segments in the
+ *        Rx buffer, the data handed over to the application, and the
+ *        out-of-order blocks reported in SACK options.
+ */
+class TcpRxBufferTestCase : public TestCase
+{
+public:
+  TcpRxBufferTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Add the bytes [start, start + size) of the stream to the buffer
+   * \param start offset of the first byte in the stream
+   * \param size number of bytes
+   * \returns the value returned by TcpRxBuffer::Add
+   */
+  bool AddRange (uint32_t start, uint32_t size);
+
+  /**
+   * \brief Check that the packet holds the stream starting at start
+   * \param p packet to check
+   * \param start offset of the first byte in the stream
+   * \returns true if the whole packet matches
+   */
+  bool CheckPattern (Ptr<Packet> p, uint32_t start);
+
+  Ptr<TcpRxBuffer> m_rxBuf; //!< Buffer under test
+};
+
+TcpRxBufferTestCase::TcpRxBufferTestCase ()
+  : TestCase ("Reassembly of reordered and overlapping segments")
+{
+}
+
+bool
+TcpRxBufferTestCase::AddRange (uint32_t start, uint32_t size)
+{
+  uint8_t *data = new uint8_t[size];
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      data[i] = static_cast<uint8_t> (start + i);
+    }
+  Ptr<Packet> p = Create<Packet> (data, size);
+  delete [] data;
+  TcpHeader tcph;
+  tcph.SetSequenceNumber (SequenceNumber32 (start));
+  return m_rxBuf->Add (p, tcph);
+}
+
+bool
+TcpRxBufferTestCase::CheckPattern (Ptr<Packet> p, uint32_t start)
+{
+  uint32_t size = p->GetSize ();
+  uint8_t *data = new uint8_t[size];
+  p->CopyData (data, size);
+  bool ok = true;
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      if (data[i] != static_cast<uint8_t> (start + i))
+        {
+          ok = false;
+          break;
+        }
+    }
+  delete [] data;
+  return ok;
+}
+
+void
+TcpRxBufferTestCase::DoRun (void)
+{
+  m_rxBuf = CreateObject<TcpRxBuffer> (0);
+  m_rxBuf->SetMaxBufferSize (100000);
+
+  // Out of order segments leave a hole at the head
+  NS_TEST_ASSERT_MSG_EQ (AddRange (1000, 500), true, "Segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddRange (2000, 500), true, "Segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddRange (1500, 500), true, "Segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->Available (), 0, "Data available past a hole");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->NextRxSequence (), SequenceNumber32 (0), "RCV.NXT moved past a hole");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->Extract (1000), 0, "Data extracted past a hole");
+
+  // Duplicates and partial overlaps are trimmed
+  NS_TEST_ASSERT_MSG_EQ (AddRange (1200, 300), false, "Duplicate segment buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddRange (2400, 300), true, "Overlapping segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->Size (), 1700, "Overlap counted twice");
+
+  // A segment embedding a buffered one replaces it
+  NS_TEST_ASSERT_MSG_EQ (AddRange (3000, 100), true, "Segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddRange (2900, 300), true, "Embedding segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->Size (), 2000, "Embedded segment counted twice");
+
+  // Out of order blocks are reported most recent first
+  TcpOptionSack::SackList sackList = m_rxBuf->GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (sackList.size (), 2, "Wrong number of SACK blocks");
+  NS_TEST_ASSERT_MSG_EQ (sackList.front ().first, SequenceNumber32 (2900), "Wrong first SACK block");
+  NS_TEST_ASSERT_MSG_EQ (sackList.front ().second, SequenceNumber32 (3200), "Wrong first SACK block");
+  NS_TEST_ASSERT_MSG_EQ (sackList.back ().first, SequenceNumber32 (1000), "Wrong last SACK block");
+  NS_TEST_ASSERT_MSG_EQ (sackList.back ().second, SequenceNumber32 (2700), "Wrong last SACK block");
+
+  // Filling the head hole makes everything up to the next hole available
+  NS_TEST_ASSERT_MSG_EQ (AddRange (0, 1000), true, "Segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->NextRxSequence (), SequenceNumber32 (2700), "Wrong RCV.NXT");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->Available (), 2700, "Wrong available bytes");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->GetSackList ().size (), 1, "In-sequence block still reported");
+
+  Ptr<Packet> p = m_rxBuf->Extract (700);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 700, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (CheckPattern (p, 0), true, "Wrong extracted content");
+  p = m_rxBuf->Extract (100000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 2000, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (CheckPattern (p, 700), true, "Wrong extracted content");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->Size (), 300, "Wrong occupancy after extract");
+
+  // Data already delivered is not buffered again
+  NS_TEST_ASSERT_MSG_EQ (AddRange (0, 2700), false, "Old data buffered");
+
+  // Closing the last hole
+  NS_TEST_ASSERT_MSG_EQ (AddRange (2700, 200), true, "Segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->NextRxSequence (), SequenceNumber32 (3200), "Wrong RCV.NXT");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->GetSackList ().size (), 0, "SACK blocks without holes");
+  p = m_rxBuf->Extract (100000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 500, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (CheckPattern (p, 2700), true, "Wrong extracted content");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->Size (), 0, "Buffer not empty");
+
+  // A read across several segments hands them over as a chain
+  NS_TEST_ASSERT_MSG_EQ (AddRange (3700, 500), true, "Segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddRange (4200, 500), true, "Segment not buffered");
+  NS_TEST_ASSERT_MSG_EQ (AddRange (3200, 500), true, "Segment not buffered");
+  std::list<Ptr<Packet> > segments;
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->ExtractSegments (1200, segments), 1200, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (segments.size (), 3, "Wrong number of extracted segments");
+  NS_TEST_ASSERT_MSG_EQ (segments.front ()->GetSize (), 500, "First segment not handed over whole");
+  NS_TEST_ASSERT_MSG_EQ (CheckPattern (segments.front (), 3200), true, "Wrong content of the first segment");
+  NS_TEST_ASSERT_MSG_EQ ((*(++segments.begin ()))->GetSize (), 500, "Second segment not handed over whole");
+  NS_TEST_ASSERT_MSG_EQ (CheckPattern (*(++segments.begin ()), 3700), true, "Wrong content of the second segment");
+  NS_TEST_ASSERT_MSG_EQ (segments.back ()->GetSize (), 200, "Wrong size of the last fragment");
+  NS_TEST_ASSERT_MSG_EQ (CheckPattern (segments.back (), 4200), true, "Wrong content of the last fragment");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->Size (), 300, "Wrong occupancy after extract");
+
+  // and Extract concatenates them
+  NS_TEST_ASSERT_MSG_EQ (AddRange (4700, 400), true, "Segment not buffered");
+  p = m_rxBuf->Extract (600);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 600, "Wrong extracted size");
+  NS_TEST_ASSERT_MSG_EQ (CheckPattern (p, 4400), true, "Wrong extracted content");
+  NS_TEST_ASSERT_MSG_EQ (m_rxBuf->Size (), 100, "Wrong occupancy after extract");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TcpRxBuffer TestSuite
+ */
+static class TcpRxBufferTestSuite : public TestSuite
+{
+public:
+  TcpRxBufferTestSuite ()
+    : TestSuite ("tcp-rx-buffer", UNIT)
+  {
+    AddTestCase (new TcpRxBufferTestCase, TestCase::QUICK);
+  }
+} g_tcpRxBufferTestSuite;
+
+} // namespace ns3
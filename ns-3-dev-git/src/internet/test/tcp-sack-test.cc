@@ -0,0 +1,303 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "tcp-general-test.h"
+#include "tcp-error-model.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+
+#include <map>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SackTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the negotiation of the SACK option in the three-way handshake,
+ *        and the options sent afterwards
+ */
+class SackNegotiationTestCase : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Ends with the SACK option enabled
+   */
+  enum Configuration
+  {
+    DISABLED,
+    ENABLED_SENDER,
+    ENABLED_RECEIVER,
+    ENABLED
+  };
+
+  /**
+   * \brief Constructor
+   * \param conf ends with the SACK option enabled
+   * \param name test description
+   */
+  SackNegotiationTestCase (Configuration conf, std::string name);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateReceiverSocket (Ptr<Node> node);
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void FinalChecks ();
+
+  /**
+   * \brief Called when the error model drops a segment
+   * \param ipH IPv4 header of the segment
+   * \param tcpH TCP header of the segment
+   */
+  void PktDropped (const Ipv4Header &ipH, const TcpHeader& tcpH);
+
+  Configuration m_configuration; //!< Ends with the SACK option enabled
+  bool m_sackSent;               //!< A SACK option has been sent
+};
+
+SackNegotiationTestCase::SackNegotiationTestCase (Configuration conf, std::string name)
+  : TcpGeneralTest (name, 500, 20, Seconds (0.01), Seconds (0.5), Seconds (10),
+                    0xffff, 10, 500),
+    m_configuration (conf),
+    m_sackSent (false)
+{
+}
+
+Ptr<TcpSocketMsgBase>
+SackNegotiationTestCase::CreateReceiverSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateReceiverSocket (node);
+  socket->SetAttribute ("Sack", BooleanValue (m_configuration == ENABLED
+                                              || m_configuration == ENABLED_RECEIVER));
+  return socket;
+}
+
+Ptr<TcpSocketMsgBase>
+SackNegotiationTestCase::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("Sack", BooleanValue (m_configuration == ENABLED
+                                              || m_configuration == ENABLED_SENDER));
+  return socket;
+}
+
+Ptr<ErrorModel>
+SackNegotiationTestCase::CreateReceiverErrorModel ()
+{
+  // Lose the first data segment, so that the receiver has a hole to report
+  Ptr<TcpSeqErrorModel> errorModel = CreateObject<TcpSeqErrorModel> ();
+  errorModel->AddSeqToKill (SequenceNumber32 (1));
+  errorModel->SetDropCallback (MakeCallback (&SackNegotiationTestCase::PktDropped, this));
+  return errorModel;
+}
+
+void
+SackNegotiationTestCase::PktDropped (const Ipv4Header &ipH, const TcpHeader& tcpH)
+{
+  NS_LOG_INFO ("Dropped " << tcpH);
+}
+
+void
+SackNegotiationTestCase::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  NS_LOG_INFO (h);
+
+  if (h.GetFlags () & TcpHeader::SYN)
+    {
+      bool expected = (who == SENDER) ? (m_configuration == ENABLED || m_configuration == ENABLED_SENDER)
+                                      : (m_configuration == ENABLED);
+      NS_TEST_ASSERT_MSG_EQ (h.HasOption (TcpOption::SACKPERMITTED), expected,
+                             "Wrong SACK-permitted option in SYN");
+      NS_TEST_ASSERT_MSG_EQ (h.HasOption (TcpOption::SACK), false, "SACK option in SYN");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ (h.HasOption (TcpOption::SACKPERMITTED), false,
+                             "SACK-permitted option in non-SYN packet");
+      if (h.HasOption (TcpOption::SACK))
+        {
+          NS_TEST_ASSERT_MSG_EQ (m_configuration, ENABLED, "SACK option not negotiated");
+          NS_TEST_ASSERT_MSG_EQ (who, RECEIVER, "SACK option sent by the sender");
+          m_sackSent = true;
+        }
+    }
+}
+
+void
+SackNegotiationTestCase::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_EQ (m_sackSent, (m_configuration == ENABLED),
+                         "SACK option sent or not sent unexpectedly");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the loss recovery with several segments lost in the same window
+ *
+ * With SACK, each lost segment is retransmitted once, within a single fast
+ * recovery and without waiting for the retransmission timer.
+ */
+class SackRecoveryTestCase : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param toDrop sequence numbers of the segments to lose
+   * \param name test description
+   */
+  SackRecoveryTestCase (const std::list<uint32_t> &toDrop, std::string name);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateReceiverSocket (Ptr<Node> node);
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void RTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who);
+  virtual void CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                               const TcpSocketState::TcpCongState_t newValue);
+  virtual void FinalChecks ();
+
+  /**
+   * \brief Called when the error model drops a segment
+   * \param ipH IPv4 header of the segment
+   * \param tcpH TCP header of the segment
+   */
+  void PktDropped (const Ipv4Header &ipH, const TcpHeader& tcpH);
+
+  std::list<uint32_t> m_toDrop;           //!< Sequence numbers of the segments to lose
+  std::map<uint32_t, uint32_t> m_txCount; //!< Transmissions of each data segment
+  uint32_t m_recoveries;                  //!< Number of fast recoveries entered
+};
+
+SackRecoveryTestCase::SackRecoveryTestCase (const std::list<uint32_t> &toDrop, std::string name)
+  : TcpGeneralTest (name, 500, 100, Seconds (0.01), Seconds (0.5), Seconds (10),
+                    0xffff, 1, 500),
+    m_toDrop (toDrop),
+    m_recoveries (0)
+{
+}
+
+Ptr<TcpSocketMsgBase>
+SackRecoveryTestCase::CreateReceiverSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateReceiverSocket (node);
+  socket->SetAttribute ("Sack", BooleanValue (true));
+  return socket;
+}
+
+Ptr<TcpSocketMsgBase>
+SackRecoveryTestCase::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("Sack", BooleanValue (true));
+  socket->SetAttribute ("MinRto", TimeValue (Seconds (10.0)));
+  return socket;
+}
+
+Ptr<ErrorModel>
+SackRecoveryTestCase::CreateReceiverErrorModel ()
+{
+  Ptr<TcpSeqErrorModel> errorModel = CreateObject<TcpSeqErrorModel> ();
+  for (std::list<uint32_t>::const_iterator it = m_toDrop.begin (); it != m_toDrop.end (); ++it)
+    {
+      errorModel->AddSeqToKill (SequenceNumber32 (*it));
+    }
+  errorModel->SetDropCallback (MakeCallback (&SackRecoveryTestCase::PktDropped, this));
+  return errorModel;
+}
+
+void
+SackRecoveryTestCase::PktDropped (const Ipv4Header &ipH, const TcpHeader& tcpH)
+{
+  NS_LOG_INFO ("Dropped " << tcpH);
+}
+
+void
+SackRecoveryTestCase::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who == SENDER && p->GetSize () > h.GetSerializedSize ())
+    {
+      NS_LOG_INFO ("\tSENDER Tx " << h << " size=" << p->GetSize ());
+      m_txCount[h.GetSequenceNumber ().GetValue ()]++;
+    }
+}
+
+void
+SackRecoveryTestCase::RTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who)
+{
+  NS_TEST_ASSERT_MSG_EQ (true, false, "RTO expired during a SACK recovery");
+}
+
+void
+SackRecoveryTestCase::CongStateTrace (const TcpSocketState::TcpCongState_t oldValue,
+                                      const TcpSocketState::TcpCongState_t newValue)
+{
+  if (newValue == TcpSocketState::CA_RECOVERY)
+    {
+      ++m_recoveries;
+    }
+}
+
+void
+SackRecoveryTestCase::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_EQ (m_recoveries, 1, "Losses in one window need a single recovery");
+  for (std::map<uint32_t, uint32_t>::iterator it = m_txCount.begin (); it != m_txCount.end (); ++it)
+    {
+      bool dropped = std::find (m_toDrop.begin (), m_toDrop.end (), it->first) != m_toDrop.end ();
+      NS_TEST_ASSERT_MSG_EQ (it->second, (dropped ? 2 : 1),
+                             "Segment " << it->first << " sent a wrong number of times");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP SACK TestSuite
+ */
+static class TcpSackTestSuite : public TestSuite
+{
+public:
+  TcpSackTestSuite ()
+    : TestSuite ("tcp-sack", UNIT)
+  {
+    AddTestCase (new SackNegotiationTestCase (SackNegotiationTestCase::ENABLED, "SACK enabled"), TestCase::QUICK);
+    AddTestCase (new SackNegotiationTestCase (SackNegotiationTestCase::DISABLED, "SACK disabled"), TestCase::QUICK);
+    AddTestCase (new SackNegotiationTestCase (SackNegotiationTestCase::ENABLED_SENDER, "SACK enabled only on the client"), TestCase::QUICK);
+    AddTestCase (new SackNegotiationTestCase (SackNegotiationTestCase::ENABLED_RECEIVER, "SACK enabled only on the server"), TestCase::QUICK);
+
+    std::list<uint32_t> toDrop;
+    toDrop.push_back (5001);
+    AddTestCase (new SackRecoveryTestCase (toDrop, "SACK recovery of one loss"), TestCase::QUICK);
+    toDrop.push_back (6001);
+    toDrop.push_back (7001);
+    AddTestCase (new SackRecoveryTestCase (toDrop, "SACK recovery of three losses in a window"), TestCase::QUICK);
+  }
+
+} g_tcpSackTestSuite;
+
+} // namespace ns3
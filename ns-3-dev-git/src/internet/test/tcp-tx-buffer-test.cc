@@ -0,0 +1,303 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-tx-buffer.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check that data is copied out of, and discarded from, the Tx buffer
+ *        across the boundaries of the packets handed over by the application.
+ */
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  TcpTxBufferTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Build a packet whose byte i holds (start + i) mod 256
+   * \param start value of the first byte
+   * \param size size of the packet
+   * \returns the packet
+   */
+  Ptr<Packet> MakePattern (uint32_t start, uint32_t size);
+
+  /**
+   * \brief Check that the packet holds the pattern starting at start
+   * \param p packet to check
+   * \param start expected value of the first byte
+   * \returns true if the whole packet matches
+   */
+  bool CheckPattern (Ptr<Packet> p, uint32_t start);
+};
+
+TcpTxBufferTestCase::TcpTxBufferTestCase ()
+  : TestCase ("Copy and discard across packet boundaries")
+{
+}
+
+Ptr<Packet>
+TcpTxBufferTestCase::MakePattern (uint32_t start, uint32_t size)
+{
+  uint8_t *data = new uint8_t[size];
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      data[i] = static_cast<uint8_t> (start + i);
+    }
+  Ptr<Packet> p = Create<Packet> (data, size);
+  delete [] data;
+  return p;
+}
+
+bool
+TcpTxBufferTestCase::CheckPattern (Ptr<Packet> p, uint32_t start)
+{
+  uint32_t size = p->GetSize ();
+  uint8_t *data = new uint8_t[size];
+  p->CopyData (data, size);
+  bool ok = true;
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      if (data[i] != static_cast<uint8_t> (start + i))
+        {
+          ok = false;
+          break;
+        }
+    }
+  delete [] data;
+  return ok;
+}
+
+void
+TcpTxBufferTestCase::DoRun (void)
+{
+  Ptr<TcpTxBuffer> txBuf = CreateObject<TcpTxBuffer> (1000);
+  txBuf->SetMaxBufferSize (10000);
+
+  // Application writes of uneven sizes
+  uint32_t sizes[] = { 100, 536, 1, 1460, 7, 300 };
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (txBuf->Add (MakePattern (total, sizes[i])), true, "Add failed");
+      total += sizes[i];
+    }
+  NS_TEST_ASSERT_MSG_EQ (txBuf->Size (), total, "Wrong buffer size");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->TailSequence (), SequenceNumber32 (1000 + total), "Wrong tail");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->Add (MakePattern (0, 10000)), false, "Buffer overflow accepted");
+
+  // Segments of every size starting at every offset
+  for (uint32_t start = 0; start < total; start += 37)
+    {
+      for (uint32_t len = 1; len <= 1500; len += 113)
+        {
+          Ptr<Packet> p = txBuf->CopyFromSequence (len, SequenceNumber32 (1000 + start));
+          uint32_t expected = std::min (len, total - start);
+          NS_TEST_ASSERT_MSG_EQ (p->GetSize (), expected, "Wrong segment size");
+          NS_TEST_ASSERT_MSG_EQ (CheckPattern (p, start), true, "Wrong segment content");
+        }
+    }
+
+  // Discard in the middle of a packet, then on a packet boundary
+  txBuf->DiscardUpTo (SequenceNumber32 (1000 + 150));
+  NS_TEST_ASSERT_MSG_EQ (txBuf->HeadSequence (), SequenceNumber32 (1150), "Wrong head");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->Size (), total - 150, "Wrong size after discard");
+  Ptr<Packet> p = txBuf->CopyFromSequence (1000, SequenceNumber32 (1150));
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1000, "Wrong segment size after discard");
+  NS_TEST_ASSERT_MSG_EQ (CheckPattern (p, 150), true, "Wrong segment content after discard");
+
+  txBuf->DiscardUpTo (SequenceNumber32 (1000 + 637));
+  p = txBuf->CopyFromSequence (1460, SequenceNumber32 (1637));
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1460, "Wrong segment size after discard");
+  NS_TEST_ASSERT_MSG_EQ (CheckPattern (p, 637), true, "Wrong segment content after discard");
+
+  // New data appended after a discard is still found
+  NS_TEST_ASSERT_MSG_EQ (txBuf->Add (MakePattern (total, 50)), true, "Add failed");
+  total += 50;
+  p = txBuf->CopyFromSequence (100, SequenceNumber32 (1000 + total - 100));
+  NS_TEST_ASSERT_MSG_EQ (CheckPattern (p, total - 100), true, "Wrong content of the tail");
+
+  // Acknowledge everything plus the FIN
+  txBuf->DiscardUpTo (SequenceNumber32 (1000 + total + 1));
+  NS_TEST_ASSERT_MSG_EQ (txBuf->Size (), 0, "Buffer not empty");
+  NS_TEST_ASSERT_MSG_EQ (txBuf->HeadSequence (), SequenceNumber32 (1000 + total + 1), "Wrong head after FIN");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the SACK scoreboard of the Tx buffer: merging of the blocks,
+ *        loss detection, choice of the segment to retransmit and pipe.
+ */
+class TcpTxBufferSackTestCase : public TestCase
+{
+public:
+  TcpTxBufferSackTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Update the scoreboard with a single block
+   * \param start first sequence number of the block
+   * \param end last sequence number of the block + 1
+   * \returns the value returned by TcpTxBuffer::Update
+   */
+  bool Sack (uint32_t start, uint32_t end);
+
+  Ptr<TcpTxBuffer> m_txBuf; //!< Buffer under test
+};
+
+TcpTxBufferSackTestCase::TcpTxBufferSackTestCase ()
+  : TestCase ("SACK scoreboard")
+{
+}
+
+bool
+TcpTxBufferSackTestCase::Sack (uint32_t start, uint32_t end)
+{
+  TcpOptionSack::SackList list;
+  list.push_back (TcpOptionSack::SackBlock (SequenceNumber32 (start), SequenceNumber32 (end)));
+  return m_txBuf->Update (list);
+}
+
+void
+TcpTxBufferSackTestCase::DoRun (void)
+{
+  const uint32_t dupThresh = 3;
+  const uint32_t segSize = 100;
+  const SequenceNumber32 highData (2000);
+  SequenceNumber32 seq;
+  uint32_t length;
+
+  m_txBuf = CreateObject<TcpTxBuffer> (1000);
+  m_txBuf->SetMaxBufferSize (10000);
+  m_txBuf->Add (Create<Packet> (1000));
+
+  // One SACKed segment is not enough to deem the head lost
+  NS_TEST_ASSERT_MSG_EQ (Sack (1200, 1300), true, "New block not reported");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsLost (SequenceNumber32 (1000), dupThresh, segSize), false,
+                         "Head lost with one SACKed segment");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->NextSeg (&seq, &length, dupThresh, segSize, highData, true), false,
+                         "Segment to retransmit without losses");
+
+  // Adjacent blocks are merged, duplicates and blocks out of the buffer are ignored
+  NS_TEST_ASSERT_MSG_EQ (Sack (1300, 1400), true, "New block not reported");
+  NS_TEST_ASSERT_MSG_EQ (Sack (1500, 1600), true, "New block not reported");
+  NS_TEST_ASSERT_MSG_EQ (Sack (1250, 1400), false, "Duplicate block reported as new");
+  NS_TEST_ASSERT_MSG_EQ (Sack (900, 1000), false, "Block below the head accepted");
+  NS_TEST_ASSERT_MSG_EQ (Sack (2000, 2100), false, "Block above the tail accepted");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->GetSacked (), 300, "Wrong SACKed bytes");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsSacked (SequenceNumber32 (1399)), true, "Byte not SACKed");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsSacked (SequenceNumber32 (1400)), false, "Byte SACKed");
+
+  // Three SACKed segments above the holes: [1000,1200) is lost, [1400,1500) is not
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsLost (SequenceNumber32 (1000), dupThresh, segSize), true,
+                         "Head not lost");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsLost (SequenceNumber32 (1250), dupThresh, segSize), false,
+                         "SACKed byte lost");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsLost (SequenceNumber32 (1400), dupThresh, segSize), false,
+                         "Byte with two SACKed segments above lost");
+
+  // Pipe: the holes above the lost bytes, i.e. [1400,1500) and [1600,2000)
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->BytesInFlight (highData, dupThresh, segSize), 500, "Wrong pipe");
+
+  // Lost segments are retransmitted in order, each one counted in the pipe
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->NextSeg (&seq, &length, dupThresh, segSize, highData, true), true,
+                         "No segment to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (1000), "Wrong segment to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (length, 100, "Wrong length to retransmit");
+  m_txBuf->MarkRetransmitted (seq, length);
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->BytesInFlight (highData, dupThresh, segSize), 600, "Wrong pipe");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->NextSeg (&seq, &length, dupThresh, segSize, highData, true), true,
+                         "No segment to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (1100), "Wrong segment to retransmit");
+  m_txBuf->MarkRetransmitted (seq, length);
+
+  // Only the hole that is not deemed lost is left, for rule 3
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->NextSeg (&seq, &length, dupThresh, segSize, highData, true), false,
+                         "Segment not lost to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->NextSeg (&seq, &length, dupThresh, segSize, highData, false), true,
+                         "No segment for rule 3");
+  NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (1400), "Wrong segment for rule 3");
+  NS_TEST_ASSERT_MSG_EQ (length, 100, "Wrong length for rule 3");
+
+  // A new recovery retransmits from the head again
+  m_txBuf->ResetHighRxt ();
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->NextSeg (&seq, &length, dupThresh, segSize, highData, true), true,
+                         "No segment to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (1000), "Wrong segment after reset");
+
+  // Cumulative ACKs trim the scoreboard
+  m_txBuf->DiscardUpTo (SequenceNumber32 (1300));
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->GetSacked (), 200, "Scoreboard not trimmed");
+  m_txBuf->DiscardUpTo (SequenceNumber32 (1450));
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->GetSacked (), 100, "Scoreboard not trimmed");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsSacked (SequenceNumber32 (1550)), true, "Byte not SACKed");
+
+  m_txBuf->ResetScoreboard ();
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->GetSacked (), 0, "Scoreboard not reset");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsSacked (SequenceNumber32 (1550)), false, "Byte still SACKed");
+
+  // Three small discontiguous blocks, far less than (dupThresh - 1) * segSize
+  // bytes, deem the bytes below them lost
+  NS_TEST_ASSERT_MSG_EQ (Sack (1500, 1510), true, "New block not reported");
+  NS_TEST_ASSERT_MSG_EQ (Sack (1600, 1610), true, "New block not reported");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsLost (SequenceNumber32 (1450), dupThresh, segSize), false,
+                         "Byte with two SACKed blocks above lost");
+  NS_TEST_ASSERT_MSG_EQ (Sack (1700, 1710), true, "New block not reported");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsLost (SequenceNumber32 (1450), dupThresh, segSize), true,
+                         "Byte with three SACKed blocks above not lost");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsLost (SequenceNumber32 (1499), dupThresh, segSize), true,
+                         "Byte with three SACKed blocks above not lost");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->IsLost (SequenceNumber32 (1550), dupThresh, segSize), false,
+                         "Byte with two SACKed blocks above lost");
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->NextSeg (&seq, &length, dupThresh, segSize, highData, true), true,
+                         "No segment to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (seq, SequenceNumber32 (1450), "Wrong segment to retransmit");
+  NS_TEST_ASSERT_MSG_EQ (length, 50, "Wrong length to retransmit");
+  // Pipe: the holes above the lost bytes, [1510,1600), [1610,1700) and [1710,2000)
+  NS_TEST_ASSERT_MSG_EQ (m_txBuf->BytesInFlight (highData, dupThresh, segSize), 470, "Wrong pipe");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TcpTxBuffer TestSuite
+ */
+static class TcpTxBufferTestSuite : public TestSuite
+{
+public:
+  TcpTxBufferTestSuite ()
+    : TestSuite ("tcp-tx-buffer", UNIT)
+  {
+    AddTestCase (new TcpTxBufferTestCase, TestCase::QUICK);
+    AddTestCase (new TcpTxBufferSackTestCase, TestCase::QUICK);
+  }
+} g_tcpTxBufferTestSuite;
+
+} // namespace ns3
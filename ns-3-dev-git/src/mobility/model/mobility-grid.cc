@@ -0,0 +1,218 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "mobility-grid.h"
+#include "mobility-model.h"
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MobilityGrid");
+
+MobilityGrid::MobilityGrid ()
+  : m_cellSize (0.0),
+    m_maxSpeed (0.0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+MobilityGrid::~MobilityGrid ()
+{
+  NS_LOG_FUNCTION (this);
+  Clear ();
+}
+
+void
+MobilityGrid::SetCellSize (double cellSize)
+{
+  NS_LOG_FUNCTION (this << cellSize);
+  NS_ASSERT (cellSize > 0);
+  if (cellSize != m_cellSize)
+    {
+      m_cellSize = cellSize;
+      Rebuild ();
+    }
+}
+
+double
+MobilityGrid::GetCellSize (void) const
+{
+  return m_cellSize;
+}
+
+uint32_t
+MobilityGrid::Add (Ptr<MobilityModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  NS_ASSERT (model != 0);
+  std::map<Ptr<const MobilityModel>, uint32_t>::const_iterator found = m_indexOf.find (model);
+  if (found != m_indexOf.end ())
+    {
+      return found->second;
+    }
+  uint32_t i = m_entries.size ();
+  Entry entry;
+  entry.model = model;
+  entry.placed = false;
+  m_entries.push_back (entry);
+  m_indexOf[model] = i;
+  model->TraceConnectWithoutContext ("CourseChange", MakeCallback (&MobilityGrid::CourseChanged, this));
+  if (m_cellSize > 0)
+    {
+      Place (i);
+    }
+  return i;
+}
+
+uint32_t
+MobilityGrid::GetN (void) const
+{
+  return m_entries.size ();
+}
+
+Ptr<MobilityModel>
+MobilityGrid::Get (uint32_t i) const
+{
+  return m_entries[i].model;
+}
+
+void
+MobilityGrid::GetNear (const Vector &position, double distance, std::vector<uint32_t> &indices)
+{
+  NS_LOG_FUNCTION (this << position << distance);
+  if (m_cellSize <= 0)
+    {
+      for (uint32_t i = 0; i < m_entries.size (); i++)
+        {
+          indices.push_back (i);
+        }
+      return;
+    }
+  double drift = m_maxSpeed * (Simulator::Now () - m_builtAt).GetSeconds ();
+  if (drift > m_cellSize / 2)
+    {
+      Rebuild ();
+      drift = 0;
+    }
+  double radius = distance + drift;
+  Cell low = GetCell (Vector (position.x - radius, position.y - radius, 0));
+  Cell high = GetCell (Vector (position.x + radius, position.y + radius, 0));
+  std::vector<uint32_t>::size_type first = indices.size ();
+  double nCells = static_cast<double> (high.first - low.first + 1) * (high.second - low.second + 1);
+  if (nCells > m_cells.size ())
+    {
+      // fewer occupied cells than cells to look at
+      for (std::map<Cell, std::vector<uint32_t> >::const_iterator cell = m_cells.begin (); cell != m_cells.end (); cell++)
+        {
+          if (cell->first.first >= low.first && cell->first.first <= high.first
+              && cell->first.second >= low.second && cell->first.second <= high.second)
+            {
+              indices.insert (indices.end (), cell->second.begin (), cell->second.end ());
+            }
+        }
+    }
+  else
+    {
+      for (int64_t x = low.first; x <= high.first; x++)
+        {
+          for (int64_t y = low.second; y <= high.second; y++)
+            {
+              std::map<Cell, std::vector<uint32_t> >::const_iterator cell = m_cells.find (Cell (x, y));
+              if (cell != m_cells.end ())
+                {
+                  indices.insert (indices.end (), cell->second.begin (), cell->second.end ());
+                }
+            }
+        }
+    }
+  std::sort (indices.begin () + first, indices.end ());
+}
+
+void
+MobilityGrid::Clear (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<Entry>::const_iterator i = m_entries.begin (); i != m_entries.end (); i++)
+    {
+      i->model->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&MobilityGrid::CourseChanged, this));
+    }
+  m_entries.clear ();
+  m_indexOf.clear ();
+  m_cells.clear ();
+  m_maxSpeed = 0.0;
+}
+
+MobilityGrid::Cell
+MobilityGrid::GetCell (const Vector &position) const
+{
+  return Cell (static_cast<int64_t> (std::floor (position.x / m_cellSize)),
+               static_cast<int64_t> (std::floor (position.y / m_cellSize)));
+}
+
+void
+MobilityGrid::Place (uint32_t i)
+{
+  Entry &entry = m_entries[i];
+  Cell cell = GetCell (entry.model->GetPosition ());
+  m_maxSpeed = std::max (m_maxSpeed, CalculateDistance (entry.model->GetVelocity (), Vector ()));
+  if (entry.placed)
+    {
+      if (cell == entry.cell)
+        {
+          return;
+        }
+      std::vector<uint32_t> &from = m_cells[entry.cell];
+      from.erase (std::find (from.begin (), from.end (), i));
+      if (from.empty ())
+        {
+          m_cells.erase (entry.cell);
+        }
+    }
+  entry.cell = cell;
+  entry.placed = true;
+  m_cells[cell].push_back (i);
+}
+
+void
+MobilityGrid::Rebuild (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_cells.clear ();
+  m_builtAt = Simulator::Now ();
+  m_maxSpeed = 0.0;
+  for (uint32_t i = 0; i < m_entries.size (); i++)
+    {
+      m_entries[i].placed = false;
+      Place (i);
+    }
+}
+
+void
+MobilityGrid::CourseChanged (Ptr<const MobilityModel> model)
+{
+  NS_LOG_FUNCTION (this << model);
+  std::map<Ptr<const MobilityModel>, uint32_t>::const_iterator found = m_indexOf.find (model);
+  NS_ASSERT (found != m_indexOf.end ());
+  if (m_cellSize > 0)
+    {
+      Place (found->second);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef MOBILITY_GRID_H
+#define MOBILITY_GRID_H
+
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+namespace ns3 {
+
+class MobilityModel;
+
+/**
+ * \ingroup mobility
+ * \brief A grid of mobility models, to find quickly the models which
+ * are near a position.
+ *
+ * The models are kept in square cells (in the x-y plane) of a given
+ * size, and moved from cell to cell by their CourseChange traces. A
+ * model moving at a constant velocity does not notify its course, so
+ * GetNear widens its search by the distance the fastest model may have
+ * covered since the grid was built, and rebuilds the grid before this
+ * distance gets larger than half a cell.
+ *
+ * GetNear is conservative: it may return models further than the
+ * distance asked for, and the callers check the exact distance.
+ */
+class MobilityGrid
+{
+public:
+  MobilityGrid ();
+  ~MobilityGrid ();
+
+  /**
+   * \param cellSize the width of the cells (m), typically the largest
+   * distance given to GetNear
+   */
+  void SetCellSize (double cellSize);
+  /**
+   * \return the width of the cells (m)
+   */
+  double GetCellSize (void) const;
+
+  /**
+   * Add a mobility model to the grid, if it is not there yet.
+   *
+   * \param model the mobility model
+   * \return the index of the model in the grid
+   */
+  uint32_t Add (Ptr<MobilityModel> model);
+  /**
+   * \return the number of models in the grid
+   */
+  uint32_t GetN (void) const;
+  /**
+   * \param i the index of a model
+   * \return the model
+   */
+  Ptr<MobilityModel> Get (uint32_t i) const;
+
+  /**
+   * Find the models which may be within a distance of a position.
+   *
+   * \param position the position
+   * \param distance the distance (m)
+   * \param indices the indices of the models found are appended to
+   * this vector, in increasing order
+   */
+  void GetNear (const Vector &position, double distance, std::vector<uint32_t> &indices);
+
+  /**
+   * Remove all the models from the grid, and disconnect from them.
+   */
+  void Clear (void);
+
+private:
+  /**
+   * Copy constructor
+   *
+   * Defined and unimplemented to avoid misuse: the models call back
+   * the grid
+   */
+  MobilityGrid (const MobilityGrid &);
+  /**
+   * Copy assignment
+   *
+   * Defined and unimplemented to avoid misuse
+   * \returns
+   */
+  MobilityGrid &operator = (const MobilityGrid &);
+
+  /** The cell of a position */
+  typedef std::pair<int64_t, int64_t> Cell;
+  /**
+   * \param position a position
+   * \return the cell of the position
+   */
+  Cell GetCell (const Vector &position) const;
+  /**
+   * Put model i in the cell of its current position.
+   *
+   * \param i the index of the model
+   */
+  void Place (uint32_t i);
+  /**
+   * Place all the models again, and restart the drift of the grid.
+   */
+  void Rebuild (void);
+  /**
+   * \param model the mobility model which changed course
+   */
+  void CourseChanged (Ptr<const MobilityModel> model);
+
+  /** A model in the grid */
+  struct Entry
+  {
+    Ptr<MobilityModel> model;   //!< the mobility model
+    Cell cell;                  //!< the cell of its last known position
+    bool placed;                //!< the model is in a cell
+  };
+
+  double m_cellSize;                                   //!< width of the cells (m)
+  std::vector<Entry> m_entries;                        //!< the models
+  std::map<Ptr<const MobilityModel>, uint32_t> m_indexOf;  //!< the index of each model
+  std::map<Cell, std::vector<uint32_t> > m_cells;      //!< the models in each cell
+  Time m_builtAt;                                      //!< time at which the grid was built
+  double m_maxSpeed;                                   //!< highest speed of the models since then (m/s)
+};
+
+} // namespace ns3
+
+#endif /* MOBILITY_GRID_H */
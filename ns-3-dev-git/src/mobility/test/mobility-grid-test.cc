@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/mobility-grid.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include <algorithm>
+
+using namespace ns3;
+
+/**
+ * Check that MobilityGrid::GetNear finds all the models within range
+ * while they jump around or move at constant velocity, and that it
+ * leaves out most of the others.
+ */
+class MobilityGridTestCase : public TestCase
+{
+public:
+  MobilityGridTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Compare GetNear with the exact distances, then make a model jump */
+  void Check (void);
+
+  MobilityGrid m_grid;                              //!< the grid
+  std::vector<Ptr<MobilityModel> > m_models;        //!< the models of the grid
+  Ptr<UniformRandomVariable> m_random;              //!< positions and velocities
+  uint32_t m_checks;                                //!< number of positions checked
+  uint32_t m_found;                                 //!< number of models found
+  uint32_t m_inRange;                               //!< number of models within range
+};
+
+MobilityGridTestCase::MobilityGridTestCase ()
+  : TestCase ("Check the models found by MobilityGrid"),
+    m_checks (0),
+    m_found (0),
+    m_inRange (0)
+{
+}
+
+void
+MobilityGridTestCase::Check (void)
+{
+  double range = 100;
+  Vector position (m_random->GetValue (-500, 500), m_random->GetValue (-500, 500), 0);
+  std::vector<uint32_t> near;
+  m_grid.GetNear (position, range, near);
+  for (uint32_t i = 0; i < m_models.size (); i++)
+    {
+      if (CalculateDistance (position, m_models[i]->GetPosition ()) <= range)
+        {
+          m_inRange++;
+          NS_TEST_EXPECT_MSG_EQ (std::binary_search (near.begin (), near.end (), i), true,
+                                 "Model " << i << " within range at " << Simulator::Now ().GetSeconds () << " s not found");
+        }
+    }
+  m_found += near.size ();
+  m_checks++;
+  // make a model jump, which notifies its course
+  uint32_t jumping = m_random->GetInteger (0, m_models.size () / 2 - 1);
+  m_models[jumping]->SetPosition (Vector (m_random->GetValue (-500, 500), m_random->GetValue (-500, 500), 0));
+}
+
+void
+MobilityGridTestCase::DoRun (void)
+{
+  m_random = CreateObject<UniformRandomVariable> ();
+  m_random->SetStream (1);
+  m_grid.SetCellSize (100);
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Vector position (m_random->GetValue (-500, 500), m_random->GetValue (-500, 500), m_random->GetValue (0, 50));
+      Ptr<MobilityModel> model;
+      if (i < 50)
+        {
+          model = CreateObject<ConstantPositionMobilityModel> ();
+        }
+      else
+        {
+          Ptr<ConstantVelocityMobilityModel> moving = CreateObject<ConstantVelocityMobilityModel> ();
+          moving->SetVelocity (Vector (m_random->GetValue (-30, 30), m_random->GetValue (-30, 30), 0));
+          model = moving;
+        }
+      model->SetPosition (position);
+      m_models.push_back (model);
+      NS_TEST_EXPECT_MSG_EQ (m_grid.Add (model), i, "Wrong index");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_grid.Add (m_models[3]), 3, "A model was added twice");
+  NS_TEST_EXPECT_MSG_EQ (m_grid.GetN (), 100, "Wrong number of models");
+
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Simulator::Schedule (MilliSeconds (100 * i), &MobilityGridTestCase::Check, this);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_GT (m_inRange, 0, "No model was ever within range");
+  // at most 4 x 4 cells of 100 m out of 10 x 10
+  NS_TEST_EXPECT_MSG_LT (m_found, m_checks * m_models.size () / 4, "Too many models found");
+  m_grid.Clear ();
+  NS_TEST_EXPECT_MSG_EQ (m_grid.GetN (), 0, "Models left in the grid");
+  m_models.clear ();
+}
+
+/**
+ * The MobilityGrid test suite.
+ */
+class MobilityGridTestSuite : public TestSuite
+{
+public:
+  MobilityGridTestSuite ();
+};
+
+MobilityGridTestSuite::MobilityGridTestSuite ()
+  : TestSuite ("mobility-grid", UNIT)
+{
+  AddTestCase (new MobilityGridTestCase, TestCase::QUICK);
+}
+
+static MobilityGridTestSuite g_mobilityGridTestSuite;
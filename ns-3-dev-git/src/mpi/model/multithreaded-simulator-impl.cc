@@ -0,0 +1,929 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/multithreading.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#include "ns3/system-thread.h"
+#include <sched.h>
+#endif /* HAVE_PTHREAD_H */
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+namespace {
+
+/** Time step of the events which never come. */
+const uint64_t INFINITE_TS = 0x7fffffffffffffffULL;
+
+#ifdef HAVE_PTHREAD_H
+/** The partition run by the current thread. */
+__thread void *g_currentPartition = 0;
+#else /* HAVE_PTHREAD_H */
+/** The partition run by the only thread. */
+void *g_currentPartition = 0;
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \param [in] channel a channel
+ * \param [out] delay the value of its "Delay" attribute, in time steps
+ * \returns true if the channel has a positive delay
+ */
+bool
+GetChannelDelay (Ptr<Channel> channel, uint64_t &delay)
+{
+  TimeValue value;
+  if (!channel->GetAttributeFailSafe ("Delay", value) || !value.Get ().IsStrictlyPositive ())
+    {
+      return false;
+    }
+  delay = value.Get ().GetTimeStep ();
+  return true;
+}
+
+/**
+ * Find the root of the set of an element, halving the paths.
+ *
+ * \param [in,out] parent the parent of each element
+ * \param [in] i an element
+ * \returns the root of its set
+ */
+uint32_t
+FindRoot (std::vector<uint32_t> &parent, uint32_t i)
+{
+  while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+  return i;
+}
+
+} // unnamed namespace
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("Partitions",
+                   "The number of partitions, each run by a thread; "
+                   "zero to use the system ids of the nodes as partitions",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_nPartitions),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_global (0),
+    m_nPartitions (0),
+    m_lookAhead (INFINITE_TS),
+    m_stop (false),
+    m_inWindow (false),
+    m_done (false),
+    m_window (0),
+    m_windowEnd (0),
+    m_barrierCount (0),
+    m_barrierSense (false),
+    m_eventsWithContextEmpty (true),
+    m_mutex (0)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  m_mutex = new SystemMutex ();
+#else /* HAVE_PTHREAD_H */
+  NS_FATAL_ERROR ("MultithreadedSimulatorImpl requires ns-3 to be built with threading support");
+#endif /* HAVE_PTHREAD_H */
+  m_global = CreatePartition (0);
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_global->uid = 4;
+  g_currentPartition = m_global;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  if (g_currentPartition == m_global)
+    {
+      g_currentPartition = 0;
+    }
+  delete m_global;
+  m_global = 0;
+#ifdef HAVE_PTHREAD_H
+  delete m_mutex;
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  ProcessEventsWithContext ();
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      while (!(*i)->events->IsEmpty ())
+        {
+          Scheduler::Event next = (*i)->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      delete *i;
+    }
+  m_partitions.clear ();
+  while (!m_global->events->IsEmpty ())
+    {
+      Scheduler::Event next = m_global->events->RemoveNext ();
+      next.impl->Unref ();
+    }
+  m_global->events = 0;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::CreatePartition (uint32_t index)
+{
+  Partition *partition = new Partition ();
+  partition->index = index;
+  partition->uid = 4;
+  partition->currentUid = 0;
+  partition->currentTs = 0;
+  partition->currentContext = 0xffffffff;
+  partition->unscheduledEvents = 0;
+  partition->stop = false;
+  partition->stopTs = INFINITE_TS;
+  partition->outboxTs[0] = INFINITE_TS;
+  partition->outboxTs[1] = INFINITE_TS;
+  partition->barrierSense = false;
+  if (m_schedulerFactory.GetTypeId ().GetUid () != 0)
+    {
+      CreateScheduler (partition);
+    }
+  return partition;
+}
+
+void
+MultithreadedSimulatorImpl::CreateScheduler (Partition *partition)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  if (partition->events != 0)
+    {
+      while (!partition->events->IsEmpty ())
+        {
+          scheduler->Insert (partition->events->RemoveNext ());
+        }
+    }
+  partition->events = scheduler;
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (!m_inWindow, "Cannot change the scheduler during the run");
+  m_schedulerFactory = schedulerFactory;
+  CreateScheduler (m_global);
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      CreateScheduler (*i);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::AssignPartitions (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  uint32_t nNodes = NodeList::GetNNodes ();
+  std::vector<uint32_t> parent (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      parent[i] = i;
+    }
+  // The nodes linked by a channel which cannot carry the lookahead
+  // must be run by the same thread
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          Ptr<NetDevice> device = node->GetDevice (j);
+          Ptr<Channel> channel = device->GetChannel ();
+          uint64_t delay;
+          if (channel == 0 || (device->IsPointToPoint () && GetChannelDelay (channel, delay)))
+            {
+              continue;
+            }
+          for (uint32_t k = 0; k < channel->GetNDevices (); ++k)
+            {
+              uint32_t a = FindRoot (parent, i);
+              uint32_t b = FindRoot (parent, channel->GetDevice (k)->GetNode ()->GetId ());
+              parent[std::max (a, b)] = std::min (a, b);
+            }
+        }
+    }
+
+  std::vector<uint32_t> groupSize (nNodes, 0);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      groupSize[FindRoot (parent, i)]++;
+    }
+  // Fill the partitions with the groups in the order of the node ids,
+  // which usually follows the topology
+  std::vector<uint32_t> partitionOfRoot (nNodes, n);
+  uint32_t current = 0;
+  uint32_t assigned = 0;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      uint32_t root = FindRoot (parent, i);
+      if (partitionOfRoot[root] == n)
+        {
+          if (current + 1 < n && assigned >= static_cast<uint64_t> (current + 1) * nNodes / n)
+            {
+              current++;
+            }
+          partitionOfRoot[root] = current;
+          assigned += groupSize[root];
+        }
+      m_partitionOfNode[i] = partitionOfRoot[root];
+    }
+}
+
+void
+MultithreadedSimulatorImpl::CreatePartitions (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nNodes = NodeList::GetNNodes ();
+  m_partitionOfNode.assign (nNodes, 0);
+  uint32_t n = 1;
+  if (m_nPartitions > 0)
+    {
+      n = m_nPartitions;
+      AssignPartitions (n);
+    }
+  else
+    {
+      for (uint32_t i = 0; i < nNodes; ++i)
+        {
+          m_partitionOfNode[i] = NodeList::GetNode (i)->GetSystemId ();
+          n = std::max (n, m_partitionOfNode[i] + 1);
+        }
+    }
+
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      Partition *partition = CreatePartition (i);
+      // the uids of the events moved from the global queue are smaller
+      partition->uid = m_global->uid;
+      partition->currentTs = m_global->currentTs;
+      partition->outbox[0].resize (n + 1);
+      partition->outbox[1].resize (n + 1);
+      m_partitions.push_back (partition);
+    }
+  m_global->index = n;
+
+  m_lookAhead = INFINITE_TS;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          Ptr<NetDevice> device = node->GetDevice (j);
+          Ptr<Channel> channel = device->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          for (uint32_t k = 0; k < channel->GetNDevices (); ++k)
+            {
+              uint32_t remote = channel->GetDevice (k)->GetNode ()->GetId ();
+              if (m_partitionOfNode[remote] == m_partitionOfNode[i])
+                {
+                  continue;
+                }
+              uint64_t delay;
+              if (!device->IsPointToPoint () || !GetChannelDelay (channel, delay))
+                {
+                  NS_FATAL_ERROR ("Nodes " << i << " and " << remote << " are in different partitions "
+                                  "but are not linked by a point to point channel with a delay");
+                }
+              m_lookAhead = std::min (m_lookAhead, delay);
+            }
+        }
+    }
+  NS_LOG_INFO (n << " partitions, lookahead " << TimeStep (m_lookAhead));
+
+  // Move the events of the nodes to their partitions
+  Ptr<Scheduler> events = m_global->events;
+  m_global->events = m_schedulerFactory.Create<Scheduler> ();
+  while (!events->IsEmpty ())
+    {
+      Scheduler::Event ev = events->RemoveNext ();
+      Partition *partition = GetPartition (ev.key.m_context);
+      partition->events->Insert (ev);
+      if (partition != m_global)
+        {
+          m_global->unscheduledEvents--;
+          partition->unscheduledEvents++;
+        }
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  if (context < m_partitionOfNode.size ())
+    {
+      return m_partitions[m_partitionOfNode[context]];
+    }
+  return m_global;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  Partition *current = static_cast<Partition *> (g_currentPartition);
+  return current == 0 ? m_global : current;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = partition->uid;
+  partition->uid++;
+  partition->unscheduledEvents++;
+  partition->events->Insert (ev);
+  return ev.key.m_uid;
+}
+
+void
+MultithreadedSimulatorImpl::DrainInbox (Partition *partition, uint32_t parity)
+{
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      std::vector<Scheduler::Event> &inbox = (*i)->outbox[parity][partition->index];
+      for (std::vector<Scheduler::Event>::const_iterator j = inbox.begin (); j != inbox.end (); ++j)
+        {
+          Insert (partition, j->key.m_ts, j->key.m_context, j->impl);
+        }
+      inbox.clear ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessEventsWithContext (void)
+{
+  if (m_eventsWithContextEmpty)
+    {
+      return;
+    }
+
+  // swap queues
+  EventsWithContext eventsWithContext;
+  {
+#ifdef HAVE_PTHREAD_H
+    CriticalSection cs (*m_mutex);
+#endif /* HAVE_PTHREAD_H */
+    m_eventsWithContext.swap (eventsWithContext);
+    m_eventsWithContextEmpty = true;
+  }
+  // No partition runs: every event earlier than the latest clock has run
+  uint64_t now = m_global->currentTs;
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      now = std::max (now, (*i)->currentTs);
+    }
+  while (!eventsWithContext.empty ())
+    {
+      EventWithContext event = eventsWithContext.front ();
+      eventsWithContext.pop_front ();
+      Insert (GetPartition (event.context), now + event.timestamp, event.context, event.event);
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::NextWindow (void)
+{
+  // parity of the last window run
+  uint32_t parity = m_window & 1;
+  DrainInbox (m_global, parity);
+  for (;;)
+    {
+      ProcessEventsWithContext ();
+      bool stop = m_global->stop;
+      uint64_t stopTs = m_global->stopTs;
+      uint64_t next = INFINITE_TS;
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          stop = stop || (*i)->stop;
+          stopTs = std::min (stopTs, (*i)->stopTs);
+          if (!(*i)->events->IsEmpty ())
+            {
+              next = std::min (next, (*i)->events->PeekNext ().key.m_ts);
+            }
+          next = std::min (next, (*i)->outboxTs[parity]);
+        }
+      if (stop)
+        {
+          m_stop = true;
+          return false;
+        }
+      uint64_t globalNext = m_global->events->IsEmpty () ? INFINITE_TS : m_global->events->PeekNext ().key.m_ts;
+      if (std::min (next, globalNext) >= stopTs)
+        {
+          if (stopTs != INFINITE_TS)
+            {
+              // as if the event calling Simulator::Stop had run
+              m_stop = true;
+              m_global->currentTs = stopTs;
+              m_global->stopTs = INFINITE_TS;
+              for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+                {
+                  (*i)->stopTs = INFINITE_TS;
+                }
+            }
+          return false;
+        }
+
+      if (globalNext <= next)
+        {
+          // The global event runs alone: the partitions get the events
+          // sent to them and the event may schedule in any queue
+          for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+            {
+              DrainInbox (*i, parity);
+              (*i)->outboxTs[parity] = INFINITE_TS;
+            }
+          Scheduler::Event ev = m_global->events->RemoveNext ();
+          m_global->unscheduledEvents--;
+          m_global->currentTs = ev.key.m_ts;
+          m_global->currentContext = ev.key.m_context;
+          m_global->currentUid = ev.key.m_uid;
+          ev.impl->Invoke ();
+          ev.impl->Unref ();
+          continue;
+        }
+
+      // No partition can receive an event earlier than the earliest
+      // pending event plus the lookahead
+      uint64_t end = next > INFINITE_TS - m_lookAhead ? INFINITE_TS : next + m_lookAhead;
+      m_windowEnd = std::min (end, std::min (globalNext, stopTs));
+      m_window++;
+      m_inWindow = true;
+      return true;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (Partition *partition)
+{
+  uint32_t parity = m_window & 1;
+  partition->outboxTs[parity] = INFINITE_TS;
+  DrainInbox (partition, parity ^ 1);
+  while (!partition->events->IsEmpty () && !partition->stop)
+    {
+      if (partition->events->PeekNext ().key.m_ts >= m_windowEnd)
+        {
+          break;
+        }
+      Scheduler::Event next = partition->events->RemoveNext ();
+      partition->unscheduledEvents--;
+      partition->currentTs = next.key.m_ts;
+      partition->currentContext = next.key.m_context;
+      partition->currentUid = next.key.m_uid;
+      next.impl->Invoke ();
+      next.impl->Unref ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (Partition *partition)
+{
+  bool sense = !partition->barrierSense;
+  partition->barrierSense = sense;
+  if (__sync_add_and_fetch (&m_barrierCount, 1) == m_partitions.size ())
+    {
+      m_barrierCount = 0;
+      __sync_synchronize ();
+      m_barrierSense = sense;
+      return;
+    }
+  uint32_t spins = 0;
+  while (m_barrierSense != sense)
+    {
+#ifdef HAVE_PTHREAD_H
+      // the windows are short: spin, then give the processor away
+      if (++spins > 1000)
+        {
+          sched_yield ();
+        }
+#endif /* HAVE_PTHREAD_H */
+    }
+  __sync_synchronize ();
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (MultithreadedSimulatorImpl *simulator, Partition *partition)
+{
+  g_currentPartition = partition;
+  for (;;)
+    {
+      simulator->Barrier (partition);
+      if (simulator->m_done)
+        {
+          break;
+        }
+      simulator->ProcessWindow (partition);
+      simulator->Barrier (partition);
+    }
+  g_currentPartition = 0;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop || !m_global->events->IsEmpty ())
+    {
+      return m_stop;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!(*i)->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (g_currentPartition == m_global, "Simulator::Run Thread-unsafe invocation!");
+  if (m_partitions.empty ())
+    {
+      CreatePartitions ();
+    }
+  m_stop = false;
+  m_done = false;
+  m_global->stop = false;
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      (*i)->stop = false;
+    }
+
+#ifdef HAVE_PTHREAD_H
+  if (m_partitions.size () > 1)
+    {
+      Multithreading::Enable ();
+      for (uint32_t i = 1; i < m_partitions.size (); ++i)
+        {
+          Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&RunPartition, this, m_partitions[i]));
+          thread->Start ();
+          m_threads.push_back (thread);
+        }
+    }
+#endif /* HAVE_PTHREAD_H */
+
+  Partition *first = m_partitions[0];
+  for (;;)
+    {
+      m_done = !NextWindow ();
+      Barrier (first);
+      if (m_done)
+        {
+          break;
+        }
+      g_currentPartition = first;
+      ProcessWindow (first);
+      g_currentPartition = m_global;
+      Barrier (first);
+      m_inWindow = false;
+    }
+
+#ifdef HAVE_PTHREAD_H
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_threads.begin (); i != m_threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_threads.clear ();
+  Multithreading::Disable ();
+#endif /* HAVE_PTHREAD_H */
+
+  // Hand the events still in the mailboxes to their partitions
+  DrainInbox (m_global, m_window & 1);
+  bool empty = m_global->events->IsEmpty ();
+  int unscheduledEvents = m_global->unscheduledEvents;
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      DrainInbox (*i, m_window & 1);
+      (*i)->outboxTs[0] = INFINITE_TS;
+      (*i)->outboxTs[1] = INFINITE_TS;
+      m_global->currentTs = std::max (m_global->currentTs, (*i)->currentTs);
+      empty = empty && (*i)->events->IsEmpty ();
+      unscheduledEvents += (*i)->unscheduledEvents;
+    }
+
+  // If the simulator stopped naturally by lack of events, make a
+  // consistency test to check that we didn't lose any events along the way.
+  NS_ASSERT (!empty || unscheduledEvents == 0);
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  GetCurrent ()->stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  Partition *current = GetCurrent ();
+  uint64_t ts = (delay + TimeStep (current->currentTs)).GetTimeStep ();
+  current->stopTs = std::min (current->stopTs, ts);
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  NS_ASSERT_MSG (g_currentPartition != 0, "Simulator::Schedule Thread-unsafe invocation!");
+  Partition *current = GetCurrent ();
+
+  Time tAbsolute = delay + TimeStep (current->currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (current->currentTs));
+  uint64_t ts = tAbsolute.GetTimeStep ();
+  uint32_t uid = Insert (current, ts, current->currentContext, event);
+  return EventId (event, ts, current->currentContext, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+
+  Partition *current = static_cast<Partition *> (g_currentPartition);
+  if (current == 0)
+    {
+      // A thread which runs no partition
+      EventWithContext ev;
+      ev.context = context;
+      // Current time added in ProcessEventsWithContext()
+      ev.timestamp = delay.GetTimeStep ();
+      ev.event = event;
+      {
+#ifdef HAVE_PTHREAD_H
+        CriticalSection cs (*m_mutex);
+#endif /* HAVE_PTHREAD_H */
+        m_eventsWithContext.push_back (ev);
+        m_eventsWithContextEmpty = false;
+      }
+      return;
+    }
+
+  uint64_t ts = (delay + TimeStep (current->currentTs)).GetTimeStep ();
+  Partition *target = GetPartition (context);
+  if (target == current || !m_inWindow)
+    {
+      Insert (target, ts, context, event);
+      return;
+    }
+  if (ts < m_windowEnd)
+    {
+      NS_FATAL_ERROR ("Event for context " << context << " scheduled by context " << current->currentContext <<
+                      " at " << TimeStep (ts) << ", within the lookahead of " << TimeStep (m_lookAhead));
+    }
+  uint32_t parity = m_window & 1;
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  ev.key.m_uid = 0;
+  current->outbox[parity][target->index].push_back (ev);
+  current->outboxTs[parity] = std::min (current->outboxTs[parity], ts);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  NS_ASSERT_MSG (g_currentPartition != 0, "Simulator::ScheduleNow Thread-unsafe invocation!");
+  Partition *current = GetCurrent ();
+  uint32_t uid = Insert (current, current->currentTs, current->currentContext, event);
+  return EventId (event, current->currentTs, current->currentContext, uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), GetCurrent ()->currentTs, 0xffffffff, 2);
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (*m_mutex);
+#endif /* HAVE_PTHREAD_H */
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetCurrent ()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrent ()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+#ifdef HAVE_PTHREAD_H
+      CriticalSection cs (*m_mutex);
+#endif /* HAVE_PTHREAD_H */
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = GetPartition (id.GetContext ());
+  if (m_inWindow && partition != GetCurrent ())
+    {
+      // the queue belongs to another thread
+      id.PeekEventImpl ()->Cancel ();
+      return;
+    }
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  partition->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  partition->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+#ifdef HAVE_PTHREAD_H
+      CriticalSection cs (*m_mutex);
+#endif /* HAVE_PTHREAD_H */
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  // the clock of the partition which runs the event tells whether it ran
+  Partition *partition = GetPartition (id.GetContext ());
+  if (id.PeekEventImpl () == 0 ||
+      id.GetTs () < partition->currentTs ||
+      (id.GetTs () == partition->currentTs &&
+       id.GetUid () <= partition->currentUid) ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (INFINITE_TS);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  Partition *current = GetCurrent ();
+  return current == m_global ? 0 : current->index;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrent ()->currentContext;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetNPartitions (void) const
+{
+  return m_partitions.size ();
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return TimeStep (m_lookAhead);
+}
+
+} // namespace ns3
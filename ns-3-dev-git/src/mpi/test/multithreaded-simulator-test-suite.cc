@@ -0,0 +1,344 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <vector>
+#include <map>
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/mac48-address.h"
+#include "ns3/multithreaded-simulator-impl.h"
+
+using namespace ns3;
+
+/**
+ * A line of nodes linked by point to point simple channels of different
+ * delays. Every node sends packets to both neighbors, and forwards the
+ * packets it receives until their hop budget, carried by their size, is
+ * spent.
+ */
+class PacketRelay
+{
+public:
+  /** A packet received by a node. */
+  struct Arrival
+  {
+    int64_t time;  //!< Time of the arrival
+    uint32_t size; //!< Size of the packet
+    uint32_t from; //!< Index of the device of the node which received it
+    uint64_t uid;  //!< Uid of the packet
+    /**
+     * \param o another arrival
+     * \returns true if this arrival comes before the other one
+     */
+    bool operator < (const Arrival &o) const
+    {
+      return time < o.time || (time == o.time && (size < o.size || (size == o.size && from < o.from)));
+    }
+    /**
+     * \param o another arrival
+     * \returns true if the arrivals are the same
+     */
+    bool operator == (const Arrival &o) const
+    {
+      return time == o.time && size == o.size && from == o.from;
+    }
+  };
+
+  /**
+   * Build the nodes and the channels.
+   *
+   * \param nNodes number of nodes
+   * \param systemIds number of system ids the nodes are spread over
+   */
+  PacketRelay (uint32_t nNodes, uint32_t systemIds);
+  /**
+   * Run the simulation.
+   *
+   * \param duration the time the simulation is stopped at
+   */
+  void Run (Time duration);
+
+  std::vector<std::vector<Arrival> > m_arrivals; //!< Arrivals at each node
+
+private:
+  /**
+   * Send a packet.
+   *
+   * \param node the index of the sending node
+   * \param device the index of the device of the node
+   * \param size the size of the packet
+   */
+  void Send (uint32_t node, uint32_t device, uint32_t size);
+  /**
+   * Send a packet to both neighbors, and schedule the next ones.
+   *
+   * \param node the index of the sending node
+   */
+  void Generate (uint32_t node);
+  /**
+   * Receive callback of the devices.
+   *
+   * \param device the receiving device
+   * \param packet the packet
+   * \param protocol the protocol number
+   * \param from the address of the sender
+   * \returns true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+
+  std::vector<Ptr<Node> > m_nodes; //!< The nodes
+  std::vector<uint32_t> m_generated; //!< Packets generated by each node
+};
+
+PacketRelay::PacketRelay (uint32_t nNodes, uint32_t systemIds)
+  : m_arrivals (nNodes),
+    m_generated (nNodes, 0)
+{
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      m_nodes.push_back (CreateObject<Node> (i * systemIds / nNodes));
+    }
+  for (uint32_t i = 0; i + 1 < nNodes; ++i)
+    {
+      Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+      channel->SetAttribute ("Delay", TimeValue (MicroSeconds (2000 + 300 * (i % 3))));
+      for (uint32_t j = i; j <= i + 1; ++j)
+        {
+          Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+          device->SetAttribute ("PointToPointMode", BooleanValue (true));
+          device->SetAddress (Mac48Address::Allocate ());
+          device->SetChannel (channel);
+          m_nodes[j]->AddDevice (device);
+          // replaces the callback set by the node
+          device->SetReceiveCallback (MakeCallback (&PacketRelay::Receive, this));
+        }
+    }
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      Simulator::ScheduleWithContext (i, MicroSeconds (370 * i), &PacketRelay::Generate, this, i);
+    }
+}
+
+void
+PacketRelay::Run (Time duration)
+{
+  Simulator::Stop (duration);
+  Simulator::Run ();
+}
+
+void
+PacketRelay::Send (uint32_t node, uint32_t device, uint32_t size)
+{
+  m_nodes[node]->GetDevice (device)->Send (Create<Packet> (size), Mac48Address::GetBroadcast (), 0x800);
+}
+
+void
+PacketRelay::Generate (uint32_t node)
+{
+  uint32_t budget = m_generated[node]++ % 6;
+  for (uint32_t i = 0; i < m_nodes[node]->GetNDevices (); ++i)
+    {
+      Send (node, i, 20 + budget);
+    }
+  Simulator::Schedule (MicroSeconds (1100 + 17 * node), &PacketRelay::Generate, this, node);
+}
+
+bool
+PacketRelay::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  uint32_t node = device->GetNode ()->GetId ();
+  Arrival arrival;
+  arrival.time = Simulator::Now ().GetTimeStep ();
+  arrival.size = packet->GetSize ();
+  arrival.from = device->GetIfIndex ();
+  arrival.uid = packet->GetUid ();
+  m_arrivals[node].push_back (arrival);
+  NS_ASSERT (Simulator::GetContext () == node);
+  if (arrival.size > 20 && m_nodes[node]->GetNDevices () > 1)
+    {
+      // forward through the other device, after some processing
+      Simulator::Schedule (MicroSeconds (50 + 13 * node), &PacketRelay::Send,
+                           this, node, 1 - arrival.from, arrival.size - 1);
+    }
+  return true;
+}
+
+/**
+ * Run the packet relay with the default and the multithreaded simulators,
+ * and check that the nodes receive the same packets at the same times.
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Run the packet relay.
+   *
+   * \param simulator the simulator implementation
+   * \param partitions the value of the "Partitions" attribute
+   * \param systemIds number of system ids the nodes are spread over
+   * \param [out] arrivals the arrivals at each node
+   * \param [out] nPartitions the number of partitions used
+   * \returns the time of the simulator after the run
+   */
+  Time RunRelay (std::string simulator, uint32_t partitions, uint32_t systemIds,
+                 std::vector<std::vector<PacketRelay::Arrival> > &arrivals, uint32_t &nPartitions);
+};
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase ()
+  : TestCase ("Check that the multithreaded simulator gives the results of the default one")
+{
+}
+
+Time
+MultithreadedSimulatorTestCase::RunRelay (std::string simulator, uint32_t partitions, uint32_t systemIds,
+                                          std::vector<std::vector<PacketRelay::Arrival> > &arrivals,
+                                          uint32_t &nPartitions)
+{
+  Simulator::Destroy ();
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue (simulator));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Partitions", UintegerValue (partitions));
+  Time end;
+  {
+    PacketRelay relay (12, systemIds);
+    relay.Run (MilliSeconds (300));
+    end = Simulator::Now ();
+    arrivals = relay.m_arrivals;
+    nPartitions = 1;
+    Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+    if (impl != 0)
+      {
+        nPartitions = impl->GetNPartitions ();
+        if (nPartitions == 1)
+          {
+            NS_TEST_EXPECT_MSG_EQ (impl->GetLookAhead (), Simulator::GetMaximumSimulationTime (),
+                                   "Lookahead of a single partition not infinite");
+          }
+        else
+          {
+            // the smallest delay of the links between the partitions
+            NS_TEST_EXPECT_MSG_GT_OR_EQ (impl->GetLookAhead (), MicroSeconds (2000), "Lookahead too small");
+            NS_TEST_EXPECT_MSG_LT_OR_EQ (impl->GetLookAhead (), MicroSeconds (2600), "Lookahead too large");
+          }
+      }
+  }
+  Simulator::Destroy ();
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::Partitions", UintegerValue (0));
+  return end;
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun (void)
+{
+  std::vector<std::vector<PacketRelay::Arrival> > reference;
+  uint32_t nPartitions;
+  Time end = RunRelay ("ns3::DefaultSimulatorImpl", 0, 1, reference, nPartitions);
+  NS_TEST_ASSERT_MSG_EQ (end, MilliSeconds (300), "Wrong stop time");
+  for (uint32_t i = 0; i < reference.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_GT (reference[i].size (), 300, "Too few packets received by node " << i);
+      std::sort (reference[i].begin (), reference[i].end ());
+    }
+
+  struct
+  {
+    uint32_t partitions; //!< Value of the "Partitions" attribute
+    uint32_t systemIds;  //!< Number of system ids
+    uint32_t expected;   //!< Expected number of partitions
+  } configurations[] = {
+    { 0, 1, 1 },
+    { 0, 3, 3 },
+    { 4, 1, 4 },
+    { 5, 2, 5 },
+  };
+  std::vector<std::vector<PacketRelay::Arrival> > previous;
+  for (uint32_t c = 0; c < sizeof (configurations) / sizeof (configurations[0]); ++c)
+    {
+      std::vector<std::vector<PacketRelay::Arrival> > arrivals;
+      end = RunRelay ("ns3::MultithreadedSimulatorImpl", configurations[c].partitions,
+                      configurations[c].systemIds, arrivals, nPartitions);
+      NS_TEST_ASSERT_MSG_EQ (nPartitions, configurations[c].expected, "Wrong number of partitions");
+      NS_TEST_ASSERT_MSG_EQ (end, MilliSeconds (300), "Wrong stop time with " << nPartitions << " partitions");
+      NS_TEST_ASSERT_MSG_EQ (arrivals.size (), reference.size (), "Wrong number of nodes");
+
+      if (c == 3)
+        {
+          // the same partitions run again give the arrivals in the same order,
+          // and each system id shifts the uids of its packets by the number
+          // of packets it counted in the first run
+          std::vector<std::vector<PacketRelay::Arrival> > again;
+          RunRelay ("ns3::MultithreadedSimulatorImpl", configurations[c].partitions,
+                    configurations[c].systemIds, again, nPartitions);
+          std::map<uint64_t, uint64_t> uidOffsets;
+          for (uint32_t i = 0; i < arrivals.size (); ++i)
+            {
+              NS_TEST_ASSERT_MSG_EQ ((arrivals[i] == again[i]), true, "Run not reproducible at node " << i);
+              for (uint32_t j = 0; j < arrivals[i].size (); ++j)
+                {
+                  uint64_t systemId = arrivals[i][j].uid >> 32;
+                  uint64_t againSystemId = again[i][j].uid >> 32;
+                  NS_TEST_ASSERT_MSG_EQ (againSystemId, systemId, "Uid of another system id at node " << i);
+                  uint64_t offset = again[i][j].uid - arrivals[i][j].uid;
+                  uidOffsets.insert (std::make_pair (systemId, offset));
+                  NS_TEST_ASSERT_MSG_EQ (offset, uidOffsets[systemId], "Uid not reproducible at node " << i);
+                }
+            }
+          NS_TEST_ASSERT_MSG_EQ (uidOffsets.size (), nPartitions, "Uids not counted by partition");
+        }
+
+      for (uint32_t i = 0; i < arrivals.size (); ++i)
+        {
+          std::sort (arrivals[i].begin (), arrivals[i].end ());
+          NS_TEST_ASSERT_MSG_EQ (arrivals[i].size (), reference[i].size (),
+                                 "Wrong number of packets at node " << i << " with " << nPartitions << " partitions");
+          NS_TEST_ASSERT_MSG_EQ ((arrivals[i] == reference[i]), true,
+                                 "Wrong arrivals at node " << i << " with " << nPartitions << " partitions");
+        }
+    }
+}
+
+/**
+ * The multithreaded simulator test suite.
+ */
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ();
+};
+
+MultithreadedSimulatorTestSuite::MultithreadedSimulatorTestSuite ()
+  : TestSuite ("multithreaded-simulator", UNIT)
+{
+  AddTestCase (new MultithreadedSimulatorTestCase, TestCase::QUICK);
+}
+
+static MultithreadedSimulatorTestSuite g_multithreadedSimulatorTestSuite; //!< Static variable for test initialization
@@ -38,6 +38,14 @@ NS_LOG_COMPONENT_DEFINE ("TraceHelper");
 PcapHelper::PcapHelper ()
 {
   NS_LOG_FUNCTION_NOARGS ();
+  m_fileFactory.SetTypeId ("ns3::PcapFileWrapper");
+}
+
+void
+PcapHelper::SetFileAttribute (std::string name, const AttributeValue &value)
+{
+  NS_LOG_FUNCTION (name);
+  m_fileFactory.Set (name, value);
 }
 
 PcapHelper::~PcapHelper ()
@@ -55,7 +63,7 @@ PcapHelper::CreateFile (
 {
   NS_LOG_FUNCTION (filename << filemode << dataLinkType << snapLen << tzCorrection);
 
-  Ptr<PcapFileWrapper> file = CreateObject<PcapFileWrapper> ();
+  Ptr<PcapFileWrapper> file = m_fileFactory.Create<PcapFileWrapper> ();
   file->Open (filename, filemode);
   NS_ABORT_MSG_IF (file->Fail (), "Unable to Open " << filename << " for mode " << filemode);
 
@@ -208,6 +216,16 @@ AsciiTraceHelper::CreateFileStream (std::string filename, std::ios::openmode fil
   return StreamWrapper;
 }
 
+Ptr<TimeSeriesWriter>
+AsciiTraceHelper::CreateTimeSeriesFile (std::string filename, bool compress)
+{
+  NS_LOG_FUNCTION (filename << compress);
+
+  Ptr<OutputStreamWrapper> stream =
+    Create<OutputStreamWrapper> (filename, std::ios::out | std::ios::binary);
+  return Create<TimeSeriesWriter> (stream, compress);
+}
+
 std::string
 AsciiTraceHelper::GetFilenameFromDevice (std::string prefix, Ptr<NetDevice> device, bool useObjectNames)
 {
@@ -310,14 +328,14 @@ void
 AsciiTraceHelper::DefaultEnqueueSinkWithoutContext (Ptr<OutputStreamWrapper> stream, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (stream << p);
-  *stream->GetStream () << "+ " << Simulator::Now ().GetSeconds () << " " << *p << std::endl;
+  *stream->GetStream () << "+ " << Simulator::Now ().GetSeconds () << " " << *p << "\n";
 }
 
 void
 AsciiTraceHelper::DefaultEnqueueSinkWithContext (Ptr<OutputStreamWrapper> stream, std::string context, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (stream << p);
-  *stream->GetStream () << "+ " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << std::endl;
+  *stream->GetStream () << "+ " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << "\n";
 }
 
 //
@@ -336,14 +354,14 @@ void
 AsciiTraceHelper::DefaultDropSinkWithoutContext (Ptr<OutputStreamWrapper> stream, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (stream << p);
-  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << *p << std::endl;
+  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << *p << "\n";
 }
 
 void
 AsciiTraceHelper::DefaultDropSinkWithContext (Ptr<OutputStreamWrapper> stream, std::string context, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (stream << p);
-  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << std::endl;
+  *stream->GetStream () << "d " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << "\n";
 }
 
 //
@@ -363,14 +381,14 @@ void
 AsciiTraceHelper::DefaultDequeueSinkWithoutContext (Ptr<OutputStreamWrapper> stream, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (stream << p);
-  *stream->GetStream () << "- " << Simulator::Now ().GetSeconds () << " " << *p << std::endl;
+  *stream->GetStream () << "- " << Simulator::Now ().GetSeconds () << " " << *p << "\n";
 }
 
 void
 AsciiTraceHelper::DefaultDequeueSinkWithContext (Ptr<OutputStreamWrapper> stream, std::string context, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (stream << p);
-  *stream->GetStream () << "- " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << std::endl;
+  *stream->GetStream () << "- " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << "\n";
 }
 
 //
@@ -387,14 +405,20 @@ void
 AsciiTraceHelper::DefaultReceiveSinkWithoutContext (Ptr<OutputStreamWrapper> stream, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (stream << p);
-  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << *p << std::endl;
+  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << *p << "\n";
 }
 
 void
 AsciiTraceHelper::DefaultReceiveSinkWithContext (Ptr<OutputStreamWrapper> stream, std::string context, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (stream << p);
-  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << std::endl;
+  *stream->GetStream () << "r " << Simulator::Now ().GetSeconds () << " " << context << " " << *p << "\n";
+}
+
+void
+PcapHelperForDevice::SetPcapFileAttribute (std::string name, const AttributeValue &value)
+{
+  m_pcapHelper.SetFileAttribute (name, value);
 }
 
 void 
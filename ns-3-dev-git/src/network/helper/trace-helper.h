@@ -23,8 +23,10 @@
 #include "ns3/net-device-container.h"
 #include "ns3/node-container.h"
 #include "ns3/simulator.h"
+#include "ns3/object-factory.h"
 #include "ns3/pcap-file-wrapper.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/time-series-file.h"
 
 namespace ns3 {
 
@@ -91,6 +93,18 @@ public:
   std::string GetFilenameFromInterfacePair (std::string prefix, Ptr<Object> object, 
                                             uint32_t interface, bool useObjectNames = true);
 
+  /**
+   * @brief Set an attribute of the pcap files created by this helper.
+   *
+   * The attributes of ns3::PcapFileWrapper select the capture size and
+   * whether the packets are buffered, written by a background thread and
+   * compressed.
+   *
+   * @param name the name of the attribute
+   * @param value the value of the attribute
+   */
+  void SetFileAttribute (std::string name, const AttributeValue &value);
+
   /**
    * @brief Create and initialize a pcap file.
    * 
@@ -135,6 +149,8 @@ private:
    * @see DefaultSink
    */
   static void SinkWithHeader (Ptr<PcapFileWrapper> file, const Header& header, Ptr<const Packet> p);
+
+  ObjectFactory m_fileFactory; //!< factory of the pcap files
 };
 
 template <typename T> void
@@ -216,6 +232,21 @@ public:
   Ptr<OutputStreamWrapper> CreateFileStream (std::string filename, 
                                              std::ios::openmode filemode = std::ios::out);
 
+  /**
+   * @brief Create a binary time series file, the buffered alternative to
+   * a file stream written one line of text per traced value.
+   *
+   * The trace sinks of the returned writer, such as
+   * TimeSeriesWriter::TraceUint32, can be hooked directly to a traced
+   * value.  The file is completed when the writer is closed or destroyed;
+   * the reader of the file is TimeSeriesReader.
+   *
+   * @param filename file name
+   * @param compress compress the blocks of the file
+   * @returns a smart pointer to the writer
+   */
+  Ptr<TimeSeriesWriter> CreateTimeSeriesFile (std::string filename, bool compress = true);
+
   /**
    * @brief Hook a trace source to the default enqueue operation trace sink that
    * does not accept nor log a trace context.
@@ -626,6 +657,22 @@ public:
    * @param promiscuous If true capture all possible packets available at the device.
    */
   void EnablePcapAll (std::string prefix, bool promiscuous = false);
+
+  /**
+   * @brief Set an attribute of the pcap files of the devices enabled
+   * afterwards.
+   *
+   * For instance, a "CaptureSize" of 64 bytes keeps only the headers of
+   * the packets of the devices of this helper, and a "BufferSize" with
+   * "AsyncWrite" moves the writing of the files to background threads.
+   *
+   * @param name the name of an attribute of ns3::PcapFileWrapper
+   * @param value the value of the attribute
+   */
+  void SetPcapFileAttribute (std::string name, const AttributeValue &value);
+
+protected:
+  PcapHelper m_pcapHelper; //!< creates the pcap files, with the attributes set by SetPcapFileAttribute
 };
 
 /**
@@ -20,6 +20,7 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "packet-pool.h"
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -52,95 +53,31 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use 
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy 
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long) 0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
 uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
-{
-  NS_LOG_FUNCTION (this);
-  if (IS_INITIALIZED (g_freeList))
-    {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
-      delete g_freeList;
-      g_freeList = DESTROYED;
-    }
-}
 
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  if (!Multithreading::IsEnabled ())
     {
-      Buffer::Deallocate (data);
-    }
-  else
-    {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      /* a size beyond the size classes of the pool would take every
+       * buffer out of its free lists */
+      uint32_t maxPooledSize = PacketPool::GetMaxPooledSize () + 1 - sizeof (struct Buffer::Data);
+      g_maxSize = std::max (g_maxSize, std::min (data->m_size, maxPooledSize));
     }
+  Deallocate (data);
 }
 
 Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
-  if (IS_UNINITIALIZED (g_freeList))
-    {
-      g_freeList = new Buffer::FreeList ();
-    }
-  else if (IS_INITIALIZED (g_freeList))
-    {
-      while (!g_freeList->empty ()) 
-        {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
-            {
-              data->m_count = 1;
-              return data;
-            }
-          Buffer::Deallocate (data);
-        }
-    }
-  struct Buffer::Data *data = Buffer::Allocate (dataSize);
-  NS_ASSERT (data->m_count == 1);
-  return data;
+  /* give every buffer the largest size recycled so far, up to the
+   * largest size class of the pool, so that the headers are added in
+   * place */
+  return Allocate (std::max (dataSize, g_maxSize));
 }
 #else /* BUFFER_FREE_LIST */
 void
@@ -169,7 +106,14 @@ Buffer::Allocate (uint32_t reqSize)
     }
   NS_ASSERT (reqSize >= 1);
   uint32_t size = reqSize - 1 + sizeof (struct Buffer::Data);
+#ifdef BUFFER_FREE_LIST
+  /* the block of the pool may be larger than requested: use all of it */
+  std::size_t capacity;
+  uint8_t *b = static_cast<uint8_t *> (PacketPool::Allocate (PacketPool::BUFFER_DATA, size, &capacity));
+  reqSize = capacity + 1 - sizeof (struct Buffer::Data);
+#else /* BUFFER_FREE_LIST */
   uint8_t *b = new uint8_t [size];
+#endif /* BUFFER_FREE_LIST */
   struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data*>(b);
   data->m_size = reqSize;
   data->m_count = 1;
@@ -181,8 +125,12 @@ Buffer::Deallocate (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
+#ifdef BUFFER_FREE_LIST
+  PacketPool::Deallocate (PacketPool::BUFFER_DATA, data, data->m_size - 1 + sizeof (struct Buffer::Data));
+#else /* BUFFER_FREE_LIST */
   uint8_t *buf = reinterpret_cast<uint8_t *> (data);
   delete [] buf;
+#endif /* BUFFER_FREE_LIST */
 }
 
 Buffer::Buffer ()
@@ -240,6 +188,16 @@ Buffer::CheckInternalState (void) const
 #endif
 }
 
+void
+Buffer::UpdateRecommendedStart (void) const
+{
+  /* the threads of a multithreaded simulation only read it */
+  if (!Multithreading::IsEnabled ())
+    {
+      g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+    }
+}
+
 void
 Buffer::Initialize (uint32_t zeroSize)
 {
@@ -262,15 +220,14 @@ Buffer::operator = (Buffer const&o)
   if (m_data != o.m_data) 
     {
       // not assignment to self.
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (Multithreading::Decrement (m_data->m_count) == 0)
         {
           Recycle (m_data);
         }
       m_data = o.m_data;
-      m_data->m_count++;
+      Multithreading::Increment (m_data->m_count);
     }
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  UpdateRecommendedStart ();
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
   m_zeroAreaEnd = o.m_zeroAreaEnd;
@@ -284,9 +241,8 @@ Buffer::~Buffer ()
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
-  g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  UpdateRecommendedStart ();
+  if (Multithreading::Decrement (m_data->m_count) == 0)
     {
       Recycle (m_data);
     }
@@ -310,7 +266,10 @@ Buffer::AddAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (CheckInternalState ());
-  bool isDirty = m_data->m_count > 1 && m_start > m_data->m_dirtyStart;
+  // The copies sharing the data may live in other threads: never write
+  // to shared data then, even in its clean area.
+  bool isDirty = m_data->m_count > 1
+    && (m_start > m_data->m_dirtyStart || Multithreading::IsEnabled ());
   if (m_start >= start && !isDirty)
     {
       /* enough space in the buffer and not dirty. 
@@ -328,8 +287,7 @@ Buffer::AddAtStart (uint32_t start)
       uint32_t newSize = GetInternalSize () + start;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data + start, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0)
+      if (Multithreading::Decrement (m_data->m_count) == 0)
         {
           Buffer::Recycle (m_data);
         }
@@ -355,7 +313,8 @@ Buffer::AddAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
-  bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
+  bool isDirty = m_data->m_count > 1
+    && (m_end < m_data->m_dirtyEnd || Multithreading::IsEnabled ());
   if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
     {
       /* enough space in buffer and not dirty
@@ -373,8 +332,7 @@ Buffer::AddAtEnd (uint32_t end)
       uint32_t newSize = GetInternalSize () + end;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (Multithreading::Decrement (m_data->m_count) == 0)
         {
           Buffer::Recycle (m_data);
         }
@@ -24,6 +24,7 @@
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
+#include "ns3/multithreading.h"
 
 #define BUFFER_FREE_LIST 1
 
@@ -700,6 +701,12 @@ private:
    */
   bool CheckInternalState (void) const;
 
+  /**
+   * \brief Raise g_recommendedStart to the headroom this buffer used,
+   * unless the threads of a multithreaded simulation run.
+   */
+  void UpdateRecommendedStart (void) const;
+
   /**
    * \brief Initializes the buffer with a number of zeroes.
    *
@@ -785,16 +792,7 @@ private:
   uint32_t m_end;
 
 #ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
-  struct LocalStaticDestructor 
-  {
-    ~LocalStaticDestructor ();
-  };
   static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
 };
 
@@ -1049,7 +1047,7 @@ Buffer::Buffer (Buffer const&o)
     m_start (o.m_start),
     m_end (o.m_end)
 {
-  m_data->m_count++;
+  Multithreading::Increment (m_data->m_count);
   NS_ASSERT (CheckInternalState ());
 }
 
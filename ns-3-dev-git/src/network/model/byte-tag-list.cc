@@ -19,6 +19,7 @@
  */
 #include "byte-tag-list.h"
 #include "ns3/log.h"
+#include "ns3/multithreading.h"
 #include <vector>
 #include <cstring>
 
@@ -156,7 +157,7 @@ ByteTagList::ByteTagList (const ByteTagList &o)
   NS_LOG_FUNCTION (this << &o);
   if (m_data != 0)
     {
-      m_data->count++;
+      Multithreading::Increment (m_data->count);
     }
 }
 ByteTagList &
@@ -175,7 +176,7 @@ ByteTagList::operator = (const ByteTagList &o)
   m_used = o.m_used;
   if (m_data != 0)
     {
-      m_data->count++;
+      Multithreading::Increment (m_data->count);
     }
   return *this;
 }
@@ -199,7 +200,8 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
       m_used = 0;
     } 
   else if (m_data->size < spaceNeeded ||
-           (m_data->count != 1 && m_data->dirty != m_used))
+           (m_data->count != 1 &&
+            (m_data->dirty != m_used || Multithreading::IsEnabled ())))
     {
       struct ByteTagListData *newData = Allocate (spaceNeeded);
       std::memcpy (&newData->data, &m_data->data, m_used);
@@ -344,7 +346,7 @@ struct ByteTagListData *
 ByteTagList::Allocate (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
-  while (!g_freeList.empty ())
+  while (!Multithreading::IsEnabled () && !g_freeList.empty ())
     {
       struct ByteTagListData *data = g_freeList.back ();
       g_freeList.pop_back ();
@@ -358,7 +360,8 @@ ByteTagList::Allocate (uint32_t size)
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
     }
-  uint8_t *buffer = new uint8_t [std::max (size, g_maxSize) + sizeof (struct ByteTagListData) - 4];
+  uint32_t allocated = Multithreading::IsEnabled () ? size : std::max (size, g_maxSize);
+  uint8_t *buffer = new uint8_t [allocated + sizeof (struct ByteTagListData) - 4];
   struct ByteTagListData *data = (struct ByteTagListData *)buffer;
   data->count = 1;
   data->size = size;
@@ -374,10 +377,16 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  g_maxSize = std::max (g_maxSize, data->size);
-  data->count--;
-  if (data->count == 0)
+  if (Multithreading::Decrement (data->count) == 0)
     {
+      if (Multithreading::IsEnabled ())
+        {
+          // the free list is not shared by the threads
+          uint8_t *buffer = (uint8_t *)data;
+          delete [] buffer;
+          return;
+        }
+      g_maxSize = std::max (g_maxSize, data->size);
       if (g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
         {
@@ -413,8 +422,7 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  data->count--;
-  if (data->count == 0)
+  if (Multithreading::Decrement (data->count) == 0)
     {
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
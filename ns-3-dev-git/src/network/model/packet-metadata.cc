@@ -23,6 +23,7 @@
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include "packet-metadata.h"
+#include "packet-pool.h"
 #include "buffer.h"
 #include "header.h"
 #include "trailer.h"
@@ -36,17 +37,6 @@ bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
-
-PacketMetadata::DataFreeList::~DataFreeList ()
-{
-  NS_LOG_FUNCTION (this);
-  for (iterator i = begin (); i != end (); i++)
-    {
-      PacketMetadata::Deallocate (*i);
-    }
-  PacketMetadata::m_enable = false;
-}
 
 void 
 PacketMetadata::Enable (void)
@@ -77,8 +67,7 @@ PacketMetadata::ReserveCopy (uint32_t size)
   struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
   memcpy (newData->m_data, m_data->m_data, m_used);
   newData->m_dirtyEnd = m_used;
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (Multithreading::Decrement (m_data->m_count) == 0)
     {
       PacketMetadata::Recycle (m_data);
     }
@@ -101,9 +90,10 @@ PacketMetadata::Reserve (uint32_t size)
   NS_LOG_FUNCTION (this << size);
   NS_ASSERT (m_data != 0);
   if (m_data->m_size >= m_used + size &&
-      (m_head == 0xffff ||
-       m_data->m_count == 1 ||
-       m_data->m_dirtyEnd == m_used))
+      (m_data->m_count == 1 ||
+       // the copies sharing the data may live in other threads
+       (!Multithreading::IsEnabled () &&
+        (m_head == 0xffff || m_data->m_dirtyEnd == m_used))))
     {
       /* enough room, not dirty. */
     }
@@ -381,9 +371,9 @@ PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
   uint32_t sizeSize = GetUleb128Size (item->size);
   uint32_t n =  2 + 2 + typeUidSize + sizeSize + 2;
   if (m_used + n > m_data->m_size ||
-      (m_head != 0xffff &&
-       m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+      (m_data->m_count != 1 &&
+       (Multithreading::IsEnabled () ||
+        (m_head != 0xffff && m_used != m_data->m_dirtyEnd))))
     {
       ReserveCopy (n);
     }
@@ -419,9 +409,9 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
 
   if (m_used + n > m_data->m_size ||
-      (m_head != 0xffff &&
-       m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+      (m_data->m_count != 1 &&
+       (Multithreading::IsEnabled () ||
+        (m_head != 0xffff && m_used != m_data->m_dirtyEnd))))
     {
       ReserveCopy (n);
     }
@@ -576,20 +566,6 @@ PacketMetadata::Create (uint32_t size)
     {
       m_maxSize = size;
     }
-  while (!m_freeList.empty ()) 
-    {
-      struct PacketMetadata::Data *data = m_freeList.back ();
-      m_freeList.pop_back ();
-      if (data->m_size >= size) 
-        {
-          NS_LOG_LOGIC ("create found size="<<data->m_size);
-          data->m_count = 1;
-          return data;
-        }
-      PacketMetadata::Deallocate (data);
-      NS_LOG_LOGIC ("create dealloc size="<<data->m_size);
-    }
-  NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
   return PacketMetadata::Allocate (m_maxSize);
 }
 
@@ -597,22 +573,8 @@ void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  if (!m_enable)
-    {
-      PacketMetadata::Deallocate (data);
-      return;
-    } 
-  NS_LOG_LOGIC ("recycle size="<<data->m_size<<", list="<<m_freeList.size ());
   NS_ASSERT (data->m_count == 0);
-  if (m_freeList.size () > 1000 ||
-      data->m_size < m_maxSize) 
-    {
-      PacketMetadata::Deallocate (data);
-    } 
-  else 
-    {
-      m_freeList.push_back (data);
-    }
+  PacketMetadata::Deallocate (data);
 }
 
 struct PacketMetadata::Data *
@@ -625,9 +587,13 @@ PacketMetadata::Allocate (uint32_t n)
       n = PACKET_METADATA_DATA_M_DATA_SIZE;
     }
   size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-  uint8_t *buf = new uint8_t [size];
+  std::size_t capacity;
+  uint8_t *buf = static_cast<uint8_t *> (PacketPool::Allocate (PacketPool::METADATA_DATA, size, &capacity));
   struct PacketMetadata::Data *data = (struct PacketMetadata::Data *)buf;
-  data->m_size = n;
+  // use all the block of the pool, if the offsets stay below the
+  // 0xffff end of list marker
+  std::size_t usable = n + capacity - size;
+  data->m_size = usable < 0xff00 ? usable : n;
   data->m_count = 1;
   data->m_dirtyEnd = 0;
   return data;
@@ -636,8 +602,8 @@ void
 PacketMetadata::Deallocate (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
-  uint8_t *buf = (uint8_t *)data;
-  delete [] buf;
+  PacketPool::Deallocate (PacketPool::METADATA_DATA, data,
+                          sizeof (struct Data) + data->m_size - PACKET_METADATA_DATA_M_DATA_SIZE);
 }
 
 
@@ -0,0 +1,371 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-config.h"
+#include "packet-pool.h"
+#include "ns3/global-value.h"
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/multithreading.h"
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#include "ns3/system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
+#include <new>
+#include <string.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PacketPool");
+
+namespace {
+
+/** The smallest size class is 1 << MIN_SHIFT bytes. */
+const std::size_t MIN_SHIFT = 5;
+/** Number of size classes, each twice as large as the previous one. */
+const std::size_t CLASSES = 12;
+/** Bytes a free list may hold. */
+const std::size_t MAX_CACHED_BYTES = 1 << 20;
+/** Blocks a free list may hold, whatever their size. */
+const std::size_t MIN_CACHED_BLOCKS = 16;
+
+/**
+ * The free lists and counters of a kind of blocks in a thread. Only the
+ * thread of the pool writes its counters, with Multithreading::Publish,
+ * so that GetStats may read them from another thread. The live bytes are
+ * counted for all the threads at once, in g_live, since a block may be
+ * released by another thread than the one which allocated it.
+ */
+struct KindPool
+{
+  void *m_free[CLASSES];     //!< Free lists, linked through the first word of the blocks
+  uint32_t m_nFree[CLASSES]; //!< Number of blocks of each free list
+  uint64_t m_allocations;    //!< Number of blocks allocated
+  uint64_t m_hits;           //!< Allocations served from a free list
+  uint64_t m_large;          //!< Allocations too large for the size classes
+  uint64_t m_cached;         //!< Bytes of the blocks of the free lists
+};
+
+/** The pools of a thread. */
+struct ThreadPool
+{
+  KindPool m_kinds[PacketPool::KINDS]; //!< The pools of each kind
+  bool m_orphan;                       //!< The thread of the pool exited
+  ThreadPool *m_next;                  //!< Next pool of the list of all the pools
+};
+
+/** List of the pools of all the threads. */
+ThreadPool *g_pools = 0;
+
+/** Bytes of the blocks live in all the threads, by kind, then of all the kinds. */
+uint64_t g_live[PacketPool::KINDS + 1];
+/** Highest values of g_live. */
+uint64_t g_peak[PacketPool::KINDS + 1];
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * The pool of the current thread. The initial exec model saves the
+ * call which finds the variable of a shared library at each access.
+ */
+__thread ThreadPool *g_threadPool __attribute__ ((tls_model ("initial-exec"))) = 0;
+
+/**
+ * \returns The mutex protecting g_pools.
+ */
+SystemMutex &
+GetPoolsMutex (void)
+{
+  static SystemMutex mutex;
+  return mutex;
+}
+
+/**
+ * Leave the pool of an exiting thread to the next thread created.
+ *
+ * \param [in] pool The pool of the thread.
+ */
+void
+ReleaseThreadPool (void *pool)
+{
+  CriticalSection cs (GetPoolsMutex ());
+  static_cast<ThreadPool *> (pool)->m_orphan = true;
+}
+
+/**
+ * \returns The key whose destructor releases the pool of a thread.
+ */
+pthread_key_t
+GetPoolKey (void)
+{
+  static struct PoolKey
+  {
+    PoolKey ()
+    {
+      pthread_key_create (&key, &ReleaseThreadPool);
+    }
+    pthread_key_t key; //!< The key
+  } poolKey;
+  return poolKey.key;
+}
+#else /* HAVE_PTHREAD_H */
+/** The pool of the only thread. */
+ThreadPool *g_threadPool = 0;
+#endif /* HAVE_PTHREAD_H */
+
+/**
+ * \returns The pool of the current thread, created or taken over from an
+ * exited thread on first use.
+ */
+ThreadPool *
+GetThreadPool (void)
+{
+  if (g_threadPool == 0)
+    {
+      ThreadPool *pool = 0;
+      {
+#ifdef HAVE_PTHREAD_H
+        CriticalSection cs (GetPoolsMutex ());
+#endif /* HAVE_PTHREAD_H */
+        for (ThreadPool *i = g_pools; i != 0 && pool == 0; i = i->m_next)
+          {
+            if (i->m_orphan)
+              {
+                pool = i;
+                pool->m_orphan = false;
+              }
+          }
+        if (pool == 0)
+          {
+            pool = new ThreadPool;
+            memset (pool, 0, sizeof (ThreadPool));
+            pool->m_next = g_pools;
+            g_pools = pool;
+          }
+      }
+#ifdef HAVE_PTHREAD_H
+      pthread_setspecific (GetPoolKey (), pool);
+#endif /* HAVE_PTHREAD_H */
+      g_threadPool = pool;
+    }
+  return g_threadPool;
+}
+
+/**
+ * \param [in] size A block size.
+ * \returns The smallest size class which holds the block.
+ */
+inline std::size_t
+GetClass (std::size_t size)
+{
+  if (size <= (std::size_t (1) << MIN_SHIFT))
+    {
+      return 0;
+    }
+#ifdef __GNUC__
+  // the number of bits of size - 1
+  return sizeof (unsigned long) * 8 - __builtin_clzl (size - 1) - MIN_SHIFT;
+#else /* __GNUC__ */
+  std::size_t cls = 0;
+  while ((std::size_t (1) << (cls + MIN_SHIFT)) < size)
+    {
+      cls++;
+    }
+  return cls;
+#endif /* __GNUC__ */
+}
+
+/**
+ * \returns The "PacketPoolEnabled" global value, registered on first use
+ * so that the packets created by static constructors find it.
+ */
+GlobalValue &
+GetEnabledValue (void)
+{
+  static GlobalValue value ("PacketPoolEnabled",
+                            "Allocate the packets, their buffers, metadata and tags "
+                            "from the packet pool; must be set before the first packet is created",
+                            BooleanValue (true),
+                            MakeBooleanChecker ());
+  return value;
+}
+
+/**
+ * \returns The value of the "PacketPoolEnabled" global value.
+ */
+bool
+ReadEnabled (void)
+{
+  BooleanValue enabled;
+  GetEnabledValue ().GetValue (enabled);
+  return enabled.Get ();
+}
+
+} // unnamed namespace
+
+bool
+PacketPool::IsEnabled (void)
+{
+  static bool enabled = ReadEnabled ();
+  return enabled;
+}
+
+std::size_t
+PacketPool::GetMaxPooledSize (void)
+{
+  return std::size_t (1) << (MIN_SHIFT + CLASSES - 1);
+}
+
+void *
+PacketPool::Allocate (enum Kind kind, std::size_t size, std::size_t *capacity)
+{
+  if (!IsEnabled ())
+    {
+      if (capacity != 0)
+        {
+          *capacity = size;
+        }
+      return ::operator new (size);
+    }
+  KindPool *pool = &GetThreadPool ()->m_kinds[kind];
+  Multithreading::Publish (pool->m_allocations, pool->m_allocations + 1);
+  std::size_t cls = GetClass (size);
+  void *block;
+  if (cls >= CLASSES)
+    {
+      Multithreading::Publish (pool->m_large, pool->m_large + 1);
+      block = ::operator new (size);
+    }
+  else
+    {
+      size = std::size_t (1) << (cls + MIN_SHIFT);
+      block = pool->m_free[cls];
+      if (block == 0)
+        {
+          block = ::operator new (size);
+        }
+      else
+        {
+          Multithreading::Publish (pool->m_hits, pool->m_hits + 1);
+          pool->m_free[cls] = *static_cast<void **> (block);
+          --pool->m_nFree[cls];
+          Multithreading::Publish (pool->m_cached, pool->m_cached - size);
+        }
+    }
+  Multithreading::Raise (g_peak[kind], Multithreading::Add (g_live[kind], size));
+  Multithreading::Raise (g_peak[KINDS], Multithreading::Add (g_live[KINDS], size));
+  if (capacity != 0)
+    {
+      *capacity = size;
+    }
+  return block;
+}
+
+void
+PacketPool::Deallocate (enum Kind kind, void *p, std::size_t size)
+{
+  if (!IsEnabled ())
+    {
+      ::operator delete (p);
+      return;
+    }
+  KindPool *pool = &GetThreadPool ()->m_kinds[kind];
+  std::size_t cls = GetClass (size);
+  if (cls < CLASSES)
+    {
+      size = std::size_t (1) << (cls + MIN_SHIFT);
+    }
+  Multithreading::Add (g_live[kind], -static_cast<int64_t> (size));
+  Multithreading::Add (g_live[KINDS], -static_cast<int64_t> (size));
+  if (cls >= CLASSES)
+    {
+      ::operator delete (p);
+      return;
+    }
+  if (pool->m_nFree[cls] >= MIN_CACHED_BLOCKS
+      && (pool->m_nFree[cls] + 1) * size > MAX_CACHED_BYTES)
+    {
+      ::operator delete (p);
+      return;
+    }
+  *static_cast<void **> (p) = pool->m_free[cls];
+  pool->m_free[cls] = p;
+  ++pool->m_nFree[cls];
+  Multithreading::Publish (pool->m_cached, pool->m_cached + size);
+}
+
+PacketPool::Stats
+PacketPool::GetStats (enum Kind kind)
+{
+  NS_LOG_FUNCTION (kind);
+  Stats stats;
+  memset (&stats, 0, sizeof (stats));
+#ifdef HAVE_PTHREAD_H
+  CriticalSection cs (GetPoolsMutex ());
+#endif /* HAVE_PTHREAD_H */
+  for (ThreadPool *i = g_pools; i != 0; i = i->m_next)
+    {
+      const KindPool &pool = i->m_kinds[kind];
+      stats.allocations += Multithreading::Read (pool.m_allocations);
+      stats.hits += Multithreading::Read (pool.m_hits);
+      stats.large += Multithreading::Read (pool.m_large);
+      stats.cachedBytes += Multithreading::Read (pool.m_cached);
+    }
+  stats.misses = stats.allocations - stats.hits;
+  stats.liveBytes = Multithreading::Read (g_live[kind]);
+  stats.peakBytes = Multithreading::Read (g_peak[kind]);
+  return stats;
+}
+
+PacketPool::Stats
+PacketPool::GetStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Stats stats;
+  memset (&stats, 0, sizeof (stats));
+  for (uint32_t kind = 0; kind < KINDS; kind++)
+    {
+      Stats k = GetStats (static_cast<enum Kind> (kind));
+      stats.allocations += k.allocations;
+      stats.hits += k.hits;
+      stats.misses += k.misses;
+      stats.large += k.large;
+      stats.cachedBytes += k.cachedBytes;
+    }
+  stats.liveBytes = Multithreading::Read (g_live[KINDS]);
+  stats.peakBytes = Multithreading::Read (g_peak[KINDS]);
+  return stats;
+}
+
+double
+PacketPool::Stats::GetHitRate (void) const
+{
+  return allocations == 0 ? 0 : static_cast<double> (hits) / allocations;
+}
+
+std::ostream &
+operator << (std::ostream &os, const PacketPool::Stats &stats)
+{
+  os << "allocations=" << stats.allocations
+     << " hits=" << stats.hits
+     << " misses=" << stats.misses
+     << " large=" << stats.large
+     << " live=" << stats.liveBytes
+     << " peak=" << stats.peakBytes
+     << " cached=" << stats.cachedBytes;
+  return os;
+}
+
+} // namespace ns3
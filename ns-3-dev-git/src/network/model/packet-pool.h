@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <ostream>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ * \brief The allocator of the packets and of their buffers, metadata and
+ * tags.
+ *
+ * The Packet objects, the Buffer::Data, PacketMetadata::Data and
+ * PacketTagList::TagData blocks are allocated from this pool, each kind
+ * with its own free lists and counters. The pool serves the sizes up to
+ * 64 kB from power of two size classes, starting at 32 bytes; a free list
+ * keeps at most 1 MB, or 16 blocks, and returns the other blocks to the
+ * system. Larger blocks come straight from the global operator new.
+ *
+ * When threading is enabled each thread has its own free lists, so that
+ * the threads of a multithreaded simulation copy and release packets
+ * without a lock. A block released by another thread than the one which
+ * allocated it goes to the free lists of the releasing thread, and the
+ * free lists of a thread which exits are taken over by the next thread
+ * created.
+ *
+ * The pool is disabled, for instance to track the packets with valgrind,
+ * by setting the "PacketPoolEnabled" global value to false before the
+ * first packet is created.
+ */
+class PacketPool
+{
+public:
+  /** The kinds of blocks, each with its own free lists and counters. */
+  enum Kind
+  {
+    PACKET,        //!< Packet objects
+    BUFFER_DATA,   //!< Buffer::Data
+    METADATA_DATA, //!< PacketMetadata::Data
+    TAG_DATA,      //!< PacketTagList::TagData
+    KINDS          //!< Number of kinds
+  };
+
+  /** Counters of the pools of a kind, summed over all the threads. */
+  struct Stats
+  {
+    uint64_t allocations; //!< Number of blocks allocated
+    uint64_t hits;        //!< Allocations served from a free list
+    uint64_t misses;      //!< Allocations served by the system, large ones included
+    uint64_t large;       //!< Allocations too large for the size classes
+    uint64_t liveBytes;   //!< Bytes of the blocks allocated and not released
+    uint64_t peakBytes;   //!< Highest value of liveBytes
+    uint64_t cachedBytes; //!< Bytes of the blocks held by the free lists
+
+    /**
+     * \returns The fraction of the allocations served from a free list.
+     */
+    double GetHitRate (void) const;
+  };
+
+  /**
+   * Allocate a block.
+   *
+   * \param [in] kind The kind of the block.
+   * \param [in] size The size requested.
+   * \param [out] capacity If not null, the usable size of the block, at
+   * least \p size.
+   * \returns The memory of the block.
+   */
+  static void * Allocate (enum Kind kind, std::size_t size, std::size_t *capacity = 0);
+  /**
+   * Release a block.
+   *
+   * \param [in] kind The kind of the block, as given to Allocate().
+   * \param [in] p The memory of the block.
+   * \param [in] size The size requested from Allocate(), or the capacity
+   * it returned.
+   */
+  static void Deallocate (enum Kind kind, void *p, std::size_t size);
+  /**
+   * \returns \c true if the blocks are allocated from the pool.
+   */
+  static bool IsEnabled (void);
+  /**
+   * \returns The size of the largest size class: larger blocks are not
+   * kept by the free lists.
+   */
+  static std::size_t GetMaxPooledSize (void);
+  /**
+   * \param [in] kind The kind of the blocks.
+   * \returns The counters of the pools of this kind.
+   */
+  static Stats GetStats (enum Kind kind);
+  /**
+   * \returns The counters of the pools of all the kinds; peakBytes is
+   * the highest number of bytes of all the kinds live at once.
+   */
+  static Stats GetStats (void);
+};
+
+/**
+ * \ingroup packet
+ * Output streamer for the counters of the packet pools.
+ *
+ * \param [in,out] os The output stream.
+ * \param [in] stats The counters.
+ * \returns The stream.
+ */
+std::ostream & operator << (std::ostream &os, const PacketPool::Stats &stats);
+
+} // namespace ns3
+
+#endif /* PACKET_POOL_H */
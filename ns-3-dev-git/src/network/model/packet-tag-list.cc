@@ -26,6 +26,7 @@
 #include "packet-tag-list.h"
 #include "tag-buffer.h"
 #include "tag.h"
+#include "packet-pool.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 #include <cstring>
@@ -34,6 +35,18 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("PacketTagList");
 
+void *
+PacketTagList::TagData::operator new (std::size_t size)
+{
+  return PacketPool::Allocate (PacketPool::TAG_DATA, size);
+}
+
+void
+PacketTagList::TagData::operator delete (void *p, std::size_t size)
+{
+  PacketPool::Deallocate (PacketPool::TAG_DATA, p, size);
+}
+
 bool
 PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 {
@@ -132,13 +145,13 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
     {
       NS_ASSERT (cur != 0);
       NS_ASSERT (cur->count > 1);
-      cur->count--;                       // unmerge cur
+      Multithreading::Decrement (cur->count);  // unmerge cur
       struct TagData * copy = new struct TagData ();
       copy->tid = cur->tid;
       copy->count = 1;
       memcpy (copy->data, cur->data, TagData::MAX_SIZE);
       copy->next = cur->next;             // merge into tail
-      copy->next->count++;                // mark new merge
+      Multithreading::Increment (copy->next->count);  // mark new merge
       *prevNext = copy;                   // point prior list at copy
       prevNext = &copy->next;             // advance
       cur      =  copy->next;
@@ -183,11 +196,11 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
     {
       // cur is always a merge at this point
       // unmerge cur, since we linked around it already
-      cur->count--;
+      Multithreading::Decrement (cur->count);
       if (cur->next != 0)
         {
           // there's a next, so make it a merge
-          cur->next->count++;
+          Multithreading::Increment (cur->next->count);
         }
     }
   return found;
@@ -224,7 +237,7 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
     {
       // cur is always a merge at this point
       // need to copy, replace, and link past cur
-      cur->count--;                     // unmerge cur
+      Multithreading::Decrement (cur->count);  // unmerge cur
       struct TagData * copy = new struct TagData ();
       copy->tid = tag.GetInstanceTypeId ();
       copy->count = 1;
@@ -233,7 +246,7 @@ PacketTagList::ReplaceWriter (Tag & tag, bool preMerge,
       copy->next = cur->next;           // merge into tail
       if (copy->next != 0)
         {
-          copy->next->count++;          // mark new merge
+          Multithreading::Increment (copy->next->count);  // mark new merge
         }
       *prevNext = copy;                 // point prior list at copy
     }
@@ -26,8 +26,10 @@
 */
 
 #include <stdint.h>
+#include <cstddef>
 #include <ostream>
 #include "ns3/type-id.h"
+#include "ns3/multithreading.h"
 
 namespace ns3 {
 
@@ -165,6 +167,19 @@ public:
     struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
     uint32_t count;           /**< Number of incoming links */
+
+    /**
+     * Allocate a TagData from the PacketPool.
+     * \param [in] size The size of the TagData.
+     * \returns The memory of the TagData.
+     */
+    static void * operator new (std::size_t size);
+    /**
+     * Release a TagData to the PacketPool.
+     * \param [in] p The memory of the TagData.
+     * \param [in] size The size of the TagData.
+     */
+    static void operator delete (void *p, std::size_t size);
   };  /* struct TagData */
 
   /**
@@ -311,7 +326,7 @@ PacketTagList::PacketTagList (PacketTagList const &o)
 {
   if (m_next != 0)
     {
-      m_next->count++;
+      Multithreading::Increment (m_next->count);
     }
 }
 
@@ -327,7 +342,7 @@ PacketTagList::operator = (PacketTagList const &o)
   m_next = o.m_next;
   if (m_next != 0) 
     {
-      m_next->count++;
+      Multithreading::Increment (m_next->count);
     }
   return *this;
 }
@@ -343,8 +358,7 @@ PacketTagList::RemoveAll (void)
   struct TagData *prev = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
     {
-      cur->count--;
-      if (cur->count > 0) 
+      if (Multithreading::Decrement (cur->count) > 0)
         {
           break;
         }
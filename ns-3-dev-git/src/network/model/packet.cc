@@ -17,18 +17,77 @@
  *
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
+#include "ns3/core-config.h"
 #include "packet.h"
+#include "packet-pool.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/multithreading.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
 #include <string>
+#include <map>
 #include <cstdarg>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
-uint32_t Packet::m_globalUid = 0;
+namespace {
+
+/**
+ * \returns The counters of the packet uids, by system id. The elements
+ * of a map do not move, so the threads keep a pointer to their counter.
+ */
+std::map<uint32_t, uint32_t> &
+GetUidCounters (void)
+{
+  static std::map<uint32_t, uint32_t> counters;
+  return counters;
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * \returns The mutex protecting the counters of the packet uids.
+ */
+SystemMutex &
+GetUidMutex (void)
+{
+  static SystemMutex mutex;
+  return mutex;
+}
+
+/** The system id of the counter used last by the current thread. */
+__thread uint32_t g_uidSystemId = 0;
+/** The counter used last by the current thread, or 0. */
+__thread uint32_t *g_uidCounter = 0;
+#else /* HAVE_PTHREAD_H */
+/** The system id of the counter used last. */
+uint32_t g_uidSystemId = 0;
+/** The counter used last, or 0. */
+uint32_t *g_uidCounter = 0;
+#endif /* HAVE_PTHREAD_H */
+
+} // unnamed namespace
+
+uint64_t
+Packet::AllocateUid (void)
+{
+  uint32_t systemId = Simulator::GetSystemId ();
+  if (g_uidCounter == 0 || g_uidSystemId != systemId)
+    {
+#ifdef HAVE_PTHREAD_H
+      CriticalSection cs (GetUidMutex ());
+#endif /* HAVE_PTHREAD_H */
+      g_uidCounter = &GetUidCounters ()[systemId];
+      g_uidSystemId = systemId;
+    }
+  // only the threads of the same partition share a counter
+  return static_cast<uint64_t> (systemId) << 32
+         | Multithreading::FetchAndIncrement (*g_uidCounter);
+}
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -118,6 +177,18 @@ PacketTagIterator::Item::GetTag (Tag &tag) const
 }
 
 
+void *
+Packet::operator new (std::size_t size)
+{
+  return PacketPool::Allocate (PacketPool::PACKET, size);
+}
+
+void
+Packet::operator delete (void *p, std::size_t size)
+{
+  PacketPool::Deallocate (PacketPool::PACKET, p, size);
+}
+
 Ptr<Packet> 
 Packet::Copy (void) const
 {
@@ -131,16 +202,9 @@ Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (AllocateUid (), 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
@@ -173,16 +237,9 @@ Packet::Packet (uint32_t size)
   : m_buffer (size),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -199,16 +256,9 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
   : m_buffer (),
     m_byteTagList (),
     m_packetTagList (),
-    /* The upper 32 bits of the packet id in 
-     * metadata is for the system id. For non-
-     * distributed simulations, this is simply 
-     * zero.  The lower 32 bits are for the 
-     * global UID
-     */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
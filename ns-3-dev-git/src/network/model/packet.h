@@ -502,6 +502,19 @@ public:
    */
   static void EnableChecking (void);
 
+  /**
+   * \brief Allocate a packet from the PacketPool.
+   * \param size the size of the packet
+   * \returns the memory of the packet
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * \brief Release a packet to the PacketPool.
+   * \param p the memory of the packet
+   * \param size the size of the packet
+   */
+  static void operator delete (void *p, std::size_t size);
+
   /**
    * \brief Returns number of bytes required for packet
    * serialization.
@@ -721,7 +734,17 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  /**
+   * \brief Allocate the uid of a new packet.
+   *
+   * The upper 32 bits of the uid are the system id, and the lower 32
+   * bits count the packets created with this system id. The threads of a
+   * multithreaded simulation, which run partitions with different system
+   * ids, so count their packets apart.
+   *
+   * \returns the uid
+   */
+  static uint64_t AllocateUid (void);
 };
 
 /**
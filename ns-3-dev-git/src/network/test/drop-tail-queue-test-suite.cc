@@ -19,6 +19,8 @@
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -77,6 +79,120 @@ DropTailQueueTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((p == 0), true, "There are really no packets in there");
 }
 
+class DropTailQueueBurstTestCase : public TestCase
+{
+public:
+  DropTailQueueBurstTestCase ();
+  virtual void DoRun (void);
+private:
+  void Enqueued (Ptr<const Packet> p);
+  void Dequeued (Ptr<const Packet> p);
+  void NPackets (uint32_t oldValue, uint32_t newValue);
+
+  uint32_t m_enqueued;      //!< packets seen by the Enqueue trace
+  uint32_t m_dequeued;      //!< packets seen by the Dequeue trace
+  uint32_t m_nPacketsCalls; //!< calls of the nPackets trace
+  uint32_t m_nPackets;      //!< last value of the nPackets trace
+};
+
+DropTailQueueBurstTestCase::DropTailQueueBurstTestCase ()
+  : TestCase ("Check the bursts and the ring buffer of the drop tail queue"),
+    m_enqueued (0),
+    m_dequeued (0),
+    m_nPacketsCalls (0),
+    m_nPackets (0)
+{
+}
+
+void
+DropTailQueueBurstTestCase::Enqueued (Ptr<const Packet> p)
+{
+  m_enqueued++;
+}
+
+void
+DropTailQueueBurstTestCase::Dequeued (Ptr<const Packet> p)
+{
+  m_dequeued++;
+}
+
+void
+DropTailQueueBurstTestCase::NPackets (uint32_t oldValue, uint32_t newValue)
+{
+  m_nPacketsCalls++;
+  m_nPackets = newValue;
+}
+
+void
+DropTailQueueBurstTestCase::DoRun (void)
+{
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (16));
+  queue->TraceConnectWithoutContext ("Enqueue", MakeCallback (&DropTailQueueBurstTestCase::Enqueued, this));
+  queue->TraceConnectWithoutContext ("Dequeue", MakeCallback (&DropTailQueueBurstTestCase::Dequeued, this));
+  queue->TraceConnectWithoutContext ("nPackets", MakeCallback (&DropTailQueueBurstTestCase::NPackets, this));
+
+  std::vector<Ptr<Packet> > burst;
+  for (uint32_t i = 0; i < 15; i++)
+    {
+      burst.push_back (Create<Packet> (100 + i));
+    }
+
+  // Move the front of the ring, so that the next bursts wrap around
+  uint32_t n = queue->EnqueueBurst (burst);
+  NS_TEST_EXPECT_MSG_EQ (n, 15, "Packets refused below the limit");
+  std::vector<Ptr<Packet> > out;
+  n = queue->DequeueBurst (out, 10);
+  NS_TEST_EXPECT_MSG_EQ (n, 10, "Wrong number of packets dequeued");
+  NS_TEST_EXPECT_MSG_EQ (out.size (), 10, "Wrong number of packets returned");
+  NS_TEST_EXPECT_MSG_EQ (m_nPacketsCalls, 2, "The nPackets trace is not fired once per burst");
+  NS_TEST_EXPECT_MSG_EQ (m_nPackets, 5, "Wrong nPackets trace");
+
+  // Only 11 of the 30 packets fit
+  n = queue->EnqueueBurst (burst);
+  NS_TEST_EXPECT_MSG_EQ (n, 11, "Wrong number of packets accepted up to the limit");
+  n = queue->EnqueueBurst (burst);
+  NS_TEST_EXPECT_MSG_EQ (n, 0, "Packets accepted above the limit");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 16, "Wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 19, "Wrong number of drops");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalReceivedPackets (), 26, "Wrong number of packets received");
+
+  // The packets come out in order, across the end of the ring
+  out.clear ();
+  n = queue->DequeueBurst (out, 64);
+  NS_TEST_EXPECT_MSG_EQ (n, 16, "Wrong number of packets dequeued");
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (out[i]->GetUid (), burst[10 + i]->GetUid (), "Packet out of order");
+    }
+  for (uint32_t i = 0; i < 11; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (out[5 + i]->GetUid (), burst[i]->GetUid (), "Packet out of order");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->IsEmpty (), true, "The queue is not empty");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), 0, "Bytes left in the queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->DequeueBurst (out, 64), 0, "Packets dequeued from an empty queue");
+  NS_TEST_EXPECT_MSG_EQ (m_enqueued, 26, "Wrong number of Enqueue traces");
+  NS_TEST_EXPECT_MSG_EQ (m_dequeued, 26, "Wrong number of Dequeue traces");
+
+  // In byte mode the ring grows beyond its first capacity
+  queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("Mode", EnumValue (Queue::QUEUE_MODE_BYTES));
+  queue->SetAttribute ("MaxBytes", UintegerValue (1000000));
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      queue->Enqueue (Create<Packet> (10));
+      if (i % 3 == 0)
+        {
+          queue->Dequeue ();
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 66, "Wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), 660, "Wrong number of bytes");
+  queue->DequeueAll ();
+  NS_TEST_EXPECT_MSG_EQ (queue->IsEmpty (), true, "The queue is not empty");
+}
+
 static class DropTailQueueTestSuite : public TestSuite
 {
 public:
@@ -84,5 +200,6 @@ public:
     : TestSuite ("drop-tail-queue", UNIT)
   {
     AddTestCase (new DropTailQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new DropTailQueueBurstTestCase (), TestCase::QUICK);
   }
 } g_dropTailQueueTestSuite;
@@ -0,0 +1,177 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/net-device-queue.h"
+
+using namespace ns3;
+
+/**
+ * Check that the queue stops at the byte queue limit and wakes the layer
+ * above up.
+ */
+class NetDeviceQueueStopWakeTestCase : public TestCase
+{
+public:
+  NetDeviceQueueStopWakeTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Count the wake ups */
+  void Woken (void);
+  uint32_t m_woken; //!< number of wake ups
+};
+
+NetDeviceQueueStopWakeTestCase::NetDeviceQueueStopWakeTestCase ()
+  : TestCase ("Check the stop and wake up of a NetDeviceQueue"),
+    m_woken (0)
+{
+}
+
+void
+NetDeviceQueueStopWakeTestCase::Woken (void)
+{
+  m_woken++;
+}
+
+void
+NetDeviceQueueStopWakeTestCase::DoRun (void)
+{
+  Ptr<NetDeviceQueue> queue = CreateObject<NetDeviceQueue> ();
+  queue->SetAttribute ("MinLimit", UintegerValue (3000));
+  queue->SetAttribute ("MaxLimit", UintegerValue (3000));
+  queue->SetWakeCallback (MakeCallback (&NetDeviceQueueStopWakeTestCase::Woken, this));
+
+  NS_TEST_EXPECT_MSG_EQ (queue->IsStopped (), false, "New queue stopped");
+  queue->NotifyQueuedBytes (1000);
+  queue->NotifyQueuedBytes (1000);
+  queue->NotifyQueuedBytes (1000);
+  NS_TEST_EXPECT_MSG_EQ (queue->IsStopped (), false, "Queue stopped at the limit");
+  queue->NotifyQueuedBytes (1000);
+  NS_TEST_EXPECT_MSG_EQ (queue->IsStopped (), true, "Queue not stopped above the limit");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetBytesInFlight (), 4000, "Wrong bytes in flight");
+
+  queue->NotifyTransmittedBytes (1000);
+  NS_TEST_EXPECT_MSG_EQ (queue->IsStopped (), false, "Queue not woken up at the limit");
+  NS_TEST_EXPECT_MSG_EQ (m_woken, 1, "Wake callback not invoked");
+  queue->NotifyTransmittedBytes (1000);
+  NS_TEST_EXPECT_MSG_EQ (m_woken, 1, "Wake callback invoked on a running queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueLimit (), 3000, "Limit out of its bounds");
+
+  queue->NotifyQueuedBytes (5000);
+  NS_TEST_EXPECT_MSG_EQ (queue->IsStopped (), true, "Queue not stopped above the limit");
+  queue->ResetQueueLimits ();
+  NS_TEST_EXPECT_MSG_EQ (queue->IsStopped (), false, "Queue not woken up by a reset");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetBytesInFlight (), 0, "Bytes in flight not reset");
+  NS_TEST_EXPECT_MSG_EQ (m_woken, 2, "Wake callback not invoked by a reset");
+  queue->Dispose ();
+}
+
+/**
+ * Check that the byte queue limit keeps a device busy with few bytes
+ * queued: a device transmits a 1000 bytes packet each millisecond, and
+ * the layer above sends packets whenever the queue runs.
+ */
+class NetDeviceQueueLimitTestCase : public TestCase
+{
+public:
+  NetDeviceQueueLimitTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Send packets to the device while the queue runs */
+  void Fill (void);
+  /** Complete the transmission of a packet */
+  void TransmitComplete (void);
+
+  Ptr<NetDeviceQueue> m_queue; //!< the queue of the device
+  uint32_t m_queued;           //!< packets queued in the device, the one transmitted included
+  uint32_t m_transmitted;      //!< packets transmitted
+  uint32_t m_idle;             //!< completions which left the device idle after the first 100 ms
+  uint32_t m_maxInFlight;      //!< most bytes queued in the device after the first 100 ms
+};
+
+NetDeviceQueueLimitTestCase::NetDeviceQueueLimitTestCase ()
+  : TestCase ("Check that the byte queue limit keeps the device busy with few bytes"),
+    m_queued (0),
+    m_transmitted (0),
+    m_idle (0),
+    m_maxInFlight (0)
+{
+}
+
+void
+NetDeviceQueueLimitTestCase::Fill (void)
+{
+  while (!m_queue->IsStopped ())
+    {
+      m_queue->NotifyQueuedBytes (1000);
+      if (m_queued++ == 0)
+        {
+          Simulator::Schedule (MilliSeconds (1), &NetDeviceQueueLimitTestCase::TransmitComplete, this);
+        }
+    }
+  if (Simulator::Now () > MilliSeconds (100))
+    {
+      m_maxInFlight = std::max (m_maxInFlight, m_queue->GetBytesInFlight ());
+    }
+}
+
+void
+NetDeviceQueueLimitTestCase::TransmitComplete (void)
+{
+  m_transmitted++;
+  if (--m_queued > 0)
+    {
+      Simulator::Schedule (MilliSeconds (1), &NetDeviceQueueLimitTestCase::TransmitComplete, this);
+    }
+  else if (Simulator::Now () > MilliSeconds (100))
+    {
+      m_idle++;
+    }
+  m_queue->NotifyTransmittedBytes (1000);
+}
+
+void
+NetDeviceQueueLimitTestCase::DoRun (void)
+{
+  m_queue = CreateObject<NetDeviceQueue> ();
+  m_queue->SetWakeCallback (MakeCallback (&NetDeviceQueueLimitTestCase::Fill, this));
+  Simulator::ScheduleNow (&NetDeviceQueueLimitTestCase::Fill, this);
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (m_transmitted, 4999, "Device starved");
+  NS_TEST_EXPECT_MSG_EQ (m_idle, 0, "Device left idle");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (m_maxInFlight, 3000, "Too many bytes queued in the device");
+  NS_TEST_EXPECT_MSG_GT (m_queue->GetQueueLimit (), 0, "Limit never raised");
+  m_queue->Dispose ();
+  m_queue = 0;
+}
+
+/** The NetDeviceQueue test suite. */
+static class NetDeviceQueueTestSuite : public TestSuite
+{
+public:
+  NetDeviceQueueTestSuite ()
+    : TestSuite ("net-device-queue", UNIT)
+  {
+    AddTestCase (new NetDeviceQueueStopWakeTestCase (), TestCase::QUICK);
+    AddTestCase (new NetDeviceQueueLimitTestCase (), TestCase::QUICK);
+  }
+} g_netDeviceQueueTestSuite;
@@ -0,0 +1,259 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include <algorithm>
+#include "ns3/core-config.h"
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/packet-pool.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/multithreading.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#endif /* HAVE_PTHREAD_H */
+
+using namespace ns3;
+
+/**
+ * Check the counters of the packet pools and that the released blocks
+ * are reused.
+ */
+class PacketPoolTestCase : public TestCase
+{
+public:
+  PacketPoolTestCase ();
+  virtual void DoRun (void);
+};
+
+PacketPoolTestCase::PacketPoolTestCase ()
+  : TestCase ("Check the packet pool counters")
+{
+}
+
+void
+PacketPoolTestCase::DoRun (void)
+{
+  if (!PacketPool::IsEnabled ())
+    {
+      return;
+    }
+
+  // the size classes
+  std::size_t capacity = 0;
+  void *block = PacketPool::Allocate (PacketPool::BUFFER_DATA, 100, &capacity);
+  NS_TEST_ASSERT_MSG_EQ (capacity, 128, "Wrong size class");
+  PacketPool::Deallocate (PacketPool::BUFFER_DATA, block, 100);
+  PacketPool::Stats before = PacketPool::GetStats (PacketPool::BUFFER_DATA);
+  block = PacketPool::Allocate (PacketPool::BUFFER_DATA, 120, &capacity);
+  PacketPool::Stats after = PacketPool::GetStats (PacketPool::BUFFER_DATA);
+  NS_TEST_ASSERT_MSG_EQ (after.hits - before.hits, 1, "Released block not reused");
+  NS_TEST_ASSERT_MSG_EQ (after.liveBytes - before.liveBytes, 128, "Wrong live bytes");
+  PacketPool::Deallocate (PacketPool::BUFFER_DATA, block, capacity);
+  block = PacketPool::Allocate (PacketPool::BUFFER_DATA, 100000, &capacity);
+  NS_TEST_ASSERT_MSG_EQ (capacity, 100000, "Wrong capacity of a large block");
+  PacketPool::Deallocate (PacketPool::BUFFER_DATA, block, capacity);
+  after = PacketPool::GetStats (PacketPool::BUFFER_DATA);
+  NS_TEST_ASSERT_MSG_EQ (after.large - before.large, 1, "Wrong large allocations");
+  NS_TEST_ASSERT_MSG_EQ (after.liveBytes, before.liveBytes, "Blocks not released");
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (after.peakBytes, 100000, "Wrong peak");
+
+  // the packets, their buffers and tags
+  block = PacketPool::Allocate (PacketPool::PACKET, sizeof (Packet), &capacity);
+  PacketPool::Deallocate (PacketPool::PACKET, block, capacity);
+  before = PacketPool::GetStats (PacketPool::PACKET);
+  PacketPool::Stats beforeTags = PacketPool::GetStats (PacketPool::TAG_DATA);
+  {
+    std::vector<Ptr<Packet> > packets;
+    uint8_t payload[500] = { 0 };
+    for (uint32_t i = 0; i < 100; i++)
+      {
+        Ptr<Packet> p = Create<Packet> (payload, sizeof (payload));
+        p->AddPacketTag (FlowIdTag (i));
+        packets.push_back (p);
+        packets.push_back (p->Copy ());
+      }
+    after = PacketPool::GetStats (PacketPool::PACKET);
+    NS_TEST_ASSERT_MSG_EQ (after.allocations - before.allocations, 200, "Wrong packet allocations");
+    NS_TEST_ASSERT_MSG_EQ (after.liveBytes - before.liveBytes, 200 * capacity, "Wrong packet live bytes");
+    PacketPool::Stats tags = PacketPool::GetStats (PacketPool::TAG_DATA);
+    NS_TEST_ASSERT_MSG_EQ (tags.allocations - beforeTags.allocations, 100, "Wrong tag allocations");
+    FlowIdTag tag;
+    NS_TEST_ASSERT_MSG_EQ (packets[21]->PeekPacketTag (tag), true, "Tag of a copy not found");
+    NS_TEST_ASSERT_MSG_EQ (tag.GetFlowId (), 10, "Wrong tag of a copy");
+  }
+  after = PacketPool::GetStats (PacketPool::PACKET);
+  NS_TEST_ASSERT_MSG_EQ (after.liveBytes, before.liveBytes, "Packets not released");
+  NS_TEST_ASSERT_MSG_EQ (PacketPool::GetStats (PacketPool::TAG_DATA).liveBytes, beforeTags.liveBytes,
+                         "Tags not released");
+
+  before = after;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Create<Packet> (100);
+    }
+  after = PacketPool::GetStats (PacketPool::PACKET);
+  NS_TEST_ASSERT_MSG_EQ (after.hits - before.hits, 100, "Released packets not reused");
+  NS_TEST_ASSERT_MSG_GT (after.GetHitRate (), 0, "Wrong hit rate");
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Check that threads allocate and release packets at once, and release
+ * the packets of other threads.
+ */
+class PacketPoolThreadsTestCase : public TestCase
+{
+public:
+  PacketPoolThreadsTestCase ();
+  virtual void DoRun (void);
+
+  /**
+   * Create, copy and release packets.
+   * \param ok set to false if a packet was corrupted
+   */
+  static void CopyPackets (bool *ok);
+  /**
+   * Release packets.
+   * \param packets the packets
+   */
+  static void ReleasePackets (std::vector<Ptr<Packet> > *packets);
+  /**
+   * Release buffer blocks.
+   * \param blocks the blocks, of 1024 bytes
+   */
+  static void ReleaseBlocks (std::vector<void *> *blocks);
+};
+
+PacketPoolThreadsTestCase::PacketPoolThreadsTestCase ()
+  : TestCase ("Check the packet pools of several threads")
+{
+}
+
+void
+PacketPoolThreadsTestCase::CopyPackets (bool *ok)
+{
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      uint8_t payload[64];
+      for (uint32_t j = 0; j < sizeof (payload); j++)
+        {
+          payload[j] = i + j;
+        }
+      Ptr<Packet> p = Create<Packet> (payload, sizeof (payload));
+      Ptr<Packet> copy = p->Copy ();
+      p = 0;
+      uint8_t check[64];
+      copy->CopyData (check, sizeof (check));
+      for (uint32_t j = 0; j < sizeof (check); j++)
+        {
+          *ok = *ok && check[j] == (uint8_t)(i + j);
+        }
+    }
+}
+
+void
+PacketPoolThreadsTestCase::ReleasePackets (std::vector<Ptr<Packet> > *packets)
+{
+  packets->clear ();
+}
+
+void
+PacketPoolThreadsTestCase::ReleaseBlocks (std::vector<void *> *blocks)
+{
+  for (std::vector<void *>::const_iterator i = blocks->begin (); i != blocks->end (); ++i)
+    {
+      PacketPool::Deallocate (PacketPool::BUFFER_DATA, *i, 1024);
+    }
+  blocks->clear ();
+}
+
+void
+PacketPoolThreadsTestCase::DoRun (void)
+{
+  if (!PacketPool::IsEnabled ())
+    {
+      return;
+    }
+  PacketPool::Stats before = PacketPool::GetStats ();
+
+  // the packet uids are shared by the threads
+  Multithreading::Enable ();
+  const uint32_t nThreads = 4;
+  bool ok[nThreads];
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      ok[i] = true;
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&PacketPoolThreadsTestCase::CopyPackets, &ok[i])));
+      threads.back ()->Start ();
+    }
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      threads[i]->Join ();
+      NS_TEST_ASSERT_MSG_EQ (ok[i], true, "Packet corrupted in thread " << i);
+    }
+
+  std::vector<Ptr<Packet> > packets;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      packets.push_back (Create<Packet> (100));
+    }
+  Ptr<SystemThread> thread = Create<SystemThread> (MakeBoundCallback (&PacketPoolThreadsTestCase::ReleasePackets, &packets));
+  thread->Start ();
+  thread->Join ();
+
+  // the blocks released by another thread are live no more, so that
+  // allocating them again does not raise the peak
+  PacketPool::Stats beforeBlocks = PacketPool::GetStats (PacketPool::BUFFER_DATA);
+  std::vector<void *> blocks;
+  for (uint32_t round = 0; round < 2; round++)
+    {
+      for (uint32_t i = 0; i < 100; i++)
+        {
+          blocks.push_back (PacketPool::Allocate (PacketPool::BUFFER_DATA, 1024));
+        }
+      thread = Create<SystemThread> (MakeBoundCallback (&PacketPoolThreadsTestCase::ReleaseBlocks, &blocks));
+      thread->Start ();
+      thread->Join ();
+    }
+  PacketPool::Stats afterBlocks = PacketPool::GetStats (PacketPool::BUFFER_DATA);
+  NS_TEST_ASSERT_MSG_EQ (afterBlocks.liveBytes, beforeBlocks.liveBytes, "Blocks not released");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (afterBlocks.peakBytes,
+                               std::max (beforeBlocks.peakBytes, beforeBlocks.liveBytes + 100 * 1024),
+                               "Peak above the bytes live at once");
+  Multithreading::Disable ();
+
+  PacketPool::Stats after = PacketPool::GetStats ();
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (after.allocations - before.allocations, nThreads * 2000 + 100,
+                               "Wrong allocations");
+  NS_TEST_ASSERT_MSG_EQ (after.liveBytes, before.liveBytes, "Blocks not released");
+}
+#endif /* HAVE_PTHREAD_H */
+
+/** The packet pool test suite. */
+static class PacketPoolTestSuite : public TestSuite
+{
+public:
+  PacketPoolTestSuite ()
+    : TestSuite ("packet-pool", UNIT)
+  {
+    AddTestCase (new PacketPoolTestCase (), TestCase::QUICK);
+#ifdef HAVE_PTHREAD_H
+    AddTestCase (new PacketPoolThreadsTestCase (), TestCase::QUICK);
+#endif /* HAVE_PTHREAD_H */
+  }
+} g_packetPoolTestSuite;
@@ -21,10 +21,21 @@
 #include <cstdlib>
 #include <sstream>
 #include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
 
+#include "ns3/network-config.h"
 #include "ns3/log.h"
 #include "ns3/test.h"
 #include "ns3/pcap-file.h"
+#include "ns3/packet.h"
+#include "ns3/ethernet-header.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-helper.h"
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif /* HAVE_ZLIB */
 
 using namespace ns3;
 
@@ -1121,6 +1132,226 @@ DiffTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+// ===========================================================================
+// Test case to make sure that the buffered, background and compressed
+// writers write the same records as the plain one
+// ===========================================================================
+class BufferedWriteTestCase : public TestCase
+{
+public:
+  /**
+   * \param bufferSize the buffer size
+   * \param async write from a background thread
+   * \param compress compress the file
+   */
+  BufferedWriteTestCase (uint32_t bufferSize, bool async, bool compress);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Write the test records.
+   * \param filename the file name
+   * \param bufferSize the buffer size
+   * \param async write from a background thread
+   * \param compress compress the file
+   */
+  void WriteFile (std::string filename, uint32_t bufferSize, bool async, bool compress);
+  /**
+   * \param filename the file name
+   * \param decompress decompress the file
+   * \returns the content of the file
+   */
+  std::vector<char> ReadFile (std::string filename, bool decompress);
+
+  uint32_t m_bufferSize; //!< the buffer size
+  bool m_async;          //!< write from a background thread
+  bool m_compress;       //!< compress the file
+};
+
+/**
+ * \param bufferSize the buffer size
+ * \param async write from a background thread
+ * \param compress compress the file
+ * \returns the name of the test case
+ */
+static std::string
+BufferedWriteTestCaseName (uint32_t bufferSize, bool async, bool compress)
+{
+  std::ostringstream oss;
+  oss << "Check that PcapFile writes the same records with a buffer of " << bufferSize << " bytes"
+      << (async ? ", in the background" : "") << (compress ? ", compressed" : "");
+  return oss.str ();
+}
+
+BufferedWriteTestCase::BufferedWriteTestCase (uint32_t bufferSize, bool async, bool compress)
+  : TestCase (BufferedWriteTestCaseName (bufferSize, async, compress)),
+    m_bufferSize (bufferSize),
+    m_async (async),
+    m_compress (compress)
+{
+}
+
+void
+BufferedWriteTestCase::WriteFile (std::string filename, uint32_t bufferSize, bool async, bool compress)
+{
+  PcapFile f;
+  f.SetBuffering (bufferSize, async, compress);
+  f.Open (filename, std::ios::out);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::out\") returns error");
+  f.Init (1, 1000);
+
+  uint8_t data[1500];
+  for (uint32_t i = 0; i < sizeof (data); ++i)
+    {
+      data[i] = i;
+    }
+  Ptr<Packet> p = Create<Packet> (data, 600);
+  EthernetHeader header;
+  for (uint32_t i = 0; i < 2000; ++i)
+    {
+      // some records are longer than the snap length
+      uint32_t size = (i * 37) % sizeof (data);
+      f.Write (i, i * 10, data, size);
+      f.Write (i, i * 10 + 1, p);
+      f.Write (i, i * 10 + 2, header, p);
+      if (i % 500 == 0)
+        {
+          f.Flush ();
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (f.Fail (), false, "Write must not fail");
+  f.Close ();
+}
+
+std::vector<char>
+BufferedWriteTestCase::ReadFile (std::string filename, bool decompress)
+{
+  std::ifstream file (filename.c_str (), std::ios::binary);
+  std::vector<char> content ((std::istreambuf_iterator<char> (file)), std::istreambuf_iterator<char> ());
+  if (!decompress)
+    {
+      return content;
+    }
+#ifdef HAVE_ZLIB
+  // the gzip members, one after the other
+  std::vector<char> inflated;
+  std::size_t used = 0;
+  while (used < content.size ())
+    {
+      z_stream stream;
+      std::memset (&stream, 0, sizeof (stream));
+      inflateInit2 (&stream, 15 + 16);
+      stream.next_in = (Bytef *)&content[used];
+      stream.avail_in = content.size () - used;
+      int status = Z_OK;
+      while (status == Z_OK)
+        {
+          char out[4096];
+          stream.next_out = (Bytef *)out;
+          stream.avail_out = sizeof (out);
+          status = inflate (&stream, Z_NO_FLUSH);
+          inflated.insert (inflated.end (), out, out + sizeof (out) - stream.avail_out);
+        }
+      used += stream.total_in;
+      inflateEnd (&stream);
+      if (status != Z_STREAM_END)
+        {
+          break;
+        }
+    }
+  return inflated;
+#else /* HAVE_ZLIB */
+  return std::vector<char> ();
+#endif /* HAVE_ZLIB */
+}
+
+void
+BufferedWriteTestCase::DoRun (void)
+{
+#ifndef HAVE_ZLIB
+  if (m_compress)
+    {
+      return;
+    }
+#endif /* HAVE_ZLIB */
+  std::string reference = CreateTempDirFilename ("reference.pcap");
+  std::string buffered = CreateTempDirFilename ("buffered.pcap");
+  WriteFile (reference, 0, false, false);
+  WriteFile (buffered, m_bufferSize, m_async, m_compress);
+
+  std::vector<char> expected = ReadFile (reference, false);
+  std::vector<char> written = ReadFile (buffered, m_compress);
+  NS_TEST_ASSERT_MSG_EQ (written.size (), expected.size (), "Wrong size of the file");
+  bool same = written == expected;
+  NS_TEST_EXPECT_MSG_EQ (same, true, "Records differ from the plain writer");
+  if (m_compress)
+    {
+      NS_TEST_EXPECT_MSG_LT (ReadFile (buffered, false).size (), expected.size () / 2, "File not compressed");
+    }
+  else
+    {
+      uint32_t sec (0), usec (0), packets (0);
+      bool diff = PcapFile::Diff (reference, buffered, sec, usec, packets, 1000);
+      NS_TEST_EXPECT_MSG_EQ (diff, false, "PcapDiff(reference, buffered) must be false");
+      NS_TEST_EXPECT_MSG_EQ (packets, 6000, "Wrong number of packets");
+    }
+}
+
+// ===========================================================================
+// Test case to make sure that the attributes given to PcapHelper reach
+// the files it creates
+// ===========================================================================
+class HelperFileAttributesTestCase : public TestCase
+{
+public:
+  HelperFileAttributesTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+HelperFileAttributesTestCase::HelperFileAttributesTestCase ()
+  : TestCase ("Check that PcapHelper creates the files with its attributes")
+{
+}
+
+void
+HelperFileAttributesTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("headers.pcap");
+  PcapHelper helper;
+  helper.SetFileAttribute ("CaptureSize", UintegerValue (64));
+  helper.SetFileAttribute ("BufferSize", UintegerValue (4096));
+  Ptr<PcapFileWrapper> file = helper.CreateFile (filename, std::ios::out, PcapHelper::DLT_EN10MB);
+  NS_TEST_ASSERT_MSG_EQ (file->GetSnapLen (), 64, "CaptureSize not applied");
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      file->Write (MicroSeconds (i), Create<Packet> (1000));
+    }
+  file->Close ();
+
+  PcapFile f;
+  f.Open (filename, std::ios::in);
+  NS_TEST_ASSERT_MSG_EQ (f.Fail (), false, "Open (" << filename << ", \"std::ios::in\") returns error");
+  NS_TEST_EXPECT_MSG_EQ (f.GetSnapLen (), 64, "Wrong snap length");
+  uint32_t packets = 0;
+  for (;;)
+    {
+      uint8_t data[1000];
+      uint32_t tsSec, tsUsec, inclLen, origLen, readLen;
+      f.Read (data, sizeof (data), tsSec, tsUsec, inclLen, origLen, readLen);
+      if (f.Fail ())
+        {
+          break;
+        }
+      NS_TEST_EXPECT_MSG_EQ (inclLen, 64, "Record not truncated");
+      NS_TEST_EXPECT_MSG_EQ (origLen, 1000, "Wrong original length");
+      NS_TEST_EXPECT_MSG_EQ (tsUsec, packets, "Wrong timestamp");
+      ++packets;
+    }
+  NS_TEST_EXPECT_MSG_EQ (packets, 100, "Wrong number of packets");
+}
+
 class PcapFileTestSuite : public TestSuite
 {
 public:
@@ -1138,6 +1369,11 @@ PcapFileTestSuite::PcapFileTestSuite ()
   AddTestCase (new RecordHeaderTestCase, TestCase::QUICK);
   AddTestCase (new ReadFileTestCase, TestCase::QUICK);
   AddTestCase (new DiffTestCase, TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase (4096, false, false), TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase (4096, true, false), TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase (0, false, true), TestCase::QUICK);
+  AddTestCase (new BufferedWriteTestCase (65536, true, true), TestCase::QUICK);
+  AddTestCase (new HelperFileAttributesTestCase, TestCase::QUICK);
 }
 
 static PcapFileTestSuite pcapFileTestSuite;
@@ -0,0 +1,237 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include <vector>
+#include <stdio.h>
+
+#include "ns3/test.h"
+#include "ns3/nstime.h"
+#include "ns3/time-series-file.h"
+#include "ns3/trace-helper.h"
+
+using namespace ns3;
+
+/**
+ * \param filename a file name
+ * \returns the size of the file
+ */
+static uint64_t
+GetFileSize (std::string filename)
+{
+  std::ifstream file (filename.c_str (), std::ios::in | std::ios::binary);
+  file.seekg (0, std::ios::end);
+  return file.tellg ();
+}
+
+/**
+ * Write records of every kind, out of order times included, and check
+ * that they are read back, whole and by time range.
+ */
+class TimeSeriesRoundTripTestCase : public TestCase
+{
+public:
+  /**
+   * \param compress compress the blocks
+   */
+  TimeSeriesRoundTripTestCase (bool compress);
+
+private:
+  virtual void DoRun (void);
+  bool m_compress; //!< Compress the blocks
+};
+
+TimeSeriesRoundTripTestCase::TimeSeriesRoundTripTestCase (bool compress)
+  : TestCase (compress ? "Check the round trip of a compressed time series file"
+              : "Check the round trip of a raw time series file"),
+    m_compress (compress)
+{
+}
+
+void
+TimeSeriesRoundTripTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename (m_compress ? "compressed.nts" : "raw.nts");
+  std::vector<TimeSeriesFile::Record> written;
+  uint32_t seed = 1;
+  for (uint32_t i = 0; i < 10500; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      TimeSeriesFile::Record record;
+      // Mostly increasing times, with a few steps back
+      record.time = static_cast<int64_t> (i) * 1000 - (i % 97 == 0 ? 5000 : 0);
+      switch (i % 4)
+        {
+        case 0:
+          record.value = i / 10;
+          break;
+        case 1:
+          record.value = -static_cast<double> (seed >> 8) / 3.0;
+          break;
+        case 2:
+          record.value = 1e-300 * seed;
+          break;
+        default:
+          record.value = 0;
+          break;
+        }
+      record.context = i % 3 == 0 ? 0xffffffff : seed % 7;
+      written.push_back (record);
+    }
+
+  {
+    Ptr<OutputStreamWrapper> stream =
+      Create<OutputStreamWrapper> (filename, std::ios::out | std::ios::binary);
+    Ptr<TimeSeriesWriter> writer = Create<TimeSeriesWriter> (stream, m_compress, 1000);
+    for (std::vector<TimeSeriesFile::Record>::const_iterator i = written.begin (); i != written.end (); ++i)
+      {
+        writer->Write (TimeStep (i->time), i->value, i->context);
+      }
+    NS_TEST_ASSERT_MSG_EQ (writer->GetNRecords (), written.size (), "Wrong number of records written");
+  }
+
+  TimeSeriesReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (filename), true, "Cannot open " << filename);
+  NS_TEST_ASSERT_MSG_EQ (reader.IsCompressed (), m_compress, "Wrong compression flag");
+  NS_TEST_ASSERT_MSG_EQ (reader.IsRecovered (), false, "Index not found");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetStepsPerSecond (), static_cast<uint64_t> (Seconds (1).GetTimeStep ()), "Wrong resolution");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNRecords (), written.size (), "Wrong number of records");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNBlocks (), 11, "Wrong number of blocks");
+
+  std::vector<TimeSeriesFile::Record> read;
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadAll (read), true, "Cannot read the records");
+  NS_TEST_ASSERT_MSG_EQ (read.size (), written.size (), "Wrong number of records read");
+  for (uint32_t i = 0; i < read.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (read[i].time, written[i].time, "Wrong time of record " << i);
+      NS_TEST_ASSERT_MSG_EQ (read[i].value, written[i].value, "Wrong value of record " << i);
+      NS_TEST_ASSERT_MSG_EQ (read[i].context, written[i].context, "Wrong context of record " << i);
+    }
+
+  int64_t from = 2500000;
+  int64_t to = 4000000;
+  uint32_t expected = 0;
+  for (uint32_t i = 0; i < written.size (); ++i)
+    {
+      expected += written[i].time >= from && written[i].time <= to;
+    }
+  read.clear ();
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadRange (TimeStep (from), TimeStep (to), read), true,
+                         "Cannot read the range");
+  NS_TEST_ASSERT_MSG_EQ (read.size (), expected, "Wrong number of records in the range");
+  for (uint32_t i = 0; i < read.size (); ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((read[i].time >= from && read[i].time <= to), true,
+                             "Record out of the range");
+    }
+
+  reader.Close ();
+  remove (filename.c_str ());
+}
+
+/**
+ * Check that a congestion window like series compresses well, and that
+ * the blocks of a file which was not closed are recovered.
+ */
+class TimeSeriesCompressionTestCase : public TestCase
+{
+public:
+  TimeSeriesCompressionTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TimeSeriesCompressionTestCase::TimeSeriesCompressionTestCase ()
+  : TestCase ("Check the compression and the recovery of time series files")
+{
+}
+
+void
+TimeSeriesCompressionTestCase::DoRun (void)
+{
+  std::string raw = CreateTempDirFilename ("cwnd-raw.nts");
+  std::string compressed = CreateTempDirFilename ("cwnd.nts");
+  AsciiTraceHelper ascii;
+  Ptr<TimeSeriesWriter> rawWriter = ascii.CreateTimeSeriesFile (raw, false);
+  Ptr<TimeSeriesWriter> writer = ascii.CreateTimeSeriesFile (compressed);
+  uint32_t cwnd = 536;
+  for (uint32_t i = 0; i < 20000; ++i)
+    {
+      Time now = MicroSeconds (100 * i);
+      cwnd = i % 1000 == 999 ? cwnd / 2 : cwnd + 536 * 536 / cwnd;
+      rawWriter->Write (now, cwnd);
+      writer->Write (now, cwnd);
+    }
+  rawWriter->Close ();
+  writer->Close ();
+
+  uint64_t rawSize = GetFileSize (raw);
+  uint64_t compressedSize = GetFileSize (compressed);
+  NS_TEST_ASSERT_MSG_GT (rawSize, 20000 * 20, "Raw file too small");
+  NS_TEST_ASSERT_MSG_LT (compressedSize * 2, rawSize, "Compressed file too large");
+
+  // Drop the index and the end of the last block, as if the simulation
+  // had been killed
+  std::vector<char> bytes (compressedSize);
+  {
+    std::ifstream in (compressed.c_str (), std::ios::in | std::ios::binary);
+    in.read (&bytes[0], bytes.size ());
+  }
+  TimeSeriesReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (compressed), true, "Cannot open " << compressed);
+  uint32_t blocks = reader.GetNBlocks ();
+  const TimeSeriesFile::Block &last = reader.GetBlock (blocks - 1);
+  uint64_t truncated = last.offset + TimeSeriesFile::BLOCK_HEADER_SIZE + last.size / 2;
+  uint64_t complete = reader.GetNRecords () - last.count;
+  reader.Close ();
+  {
+    std::ofstream out (compressed.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write (&bytes[0], truncated);
+  }
+
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (compressed), true, "Cannot open the truncated file");
+  NS_TEST_ASSERT_MSG_EQ (reader.IsRecovered (), true, "Truncated file not recovered");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNBlocks (), blocks - 1, "Wrong number of recovered blocks");
+  std::vector<TimeSeriesFile::Record> records;
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadAll (records), true, "Cannot read the recovered blocks");
+  NS_TEST_ASSERT_MSG_EQ (records.size (), complete, "Wrong number of recovered records");
+  NS_TEST_ASSERT_MSG_EQ (records.back ().time, MicroSeconds (100 * (complete - 1)).GetTimeStep (),
+                         "Wrong time of the last recovered record");
+  reader.Close ();
+
+  remove (raw.c_str ());
+  remove (compressed.c_str ());
+}
+
+/**
+ * The time series file test suite.
+ */
+class TimeSeriesFileTestSuite : public TestSuite
+{
+public:
+  TimeSeriesFileTestSuite ();
+};
+
+TimeSeriesFileTestSuite::TimeSeriesFileTestSuite ()
+  : TestSuite ("time-series-file", UNIT)
+{
+  AddTestCase (new TimeSeriesRoundTripTestCase (true), TestCase::QUICK);
+  AddTestCase (new TimeSeriesRoundTripTestCase (false), TestCase::QUICK);
+  AddTestCase (new TimeSeriesCompressionTestCase, TestCase::QUICK);
+}
+
+static TimeSeriesFileTestSuite g_timeSeriesFileTestSuite; //!< Static variable for test initialization
@@ -240,6 +240,18 @@ std::istream &operator >> (std::istream &is, DataRate &rate);
 
 ATTRIBUTE_HELPER_HEADER (DataRate);
 
+namespace TracedValueCallback {
+
+  /**
+   * TracedValue callback signature for DataRate
+   *
+   * \param [in] oldValue Original value of the traced variable
+   * \param [in] newValue New value of the traced variable
+   */
+  typedef void (* DataRate)(DataRate oldValue, DataRate newValue);
+
+}  // namespace TracedValueCallback
+
 
 /**
  * \brief Multiply datarate by a time value
@@ -20,6 +20,7 @@
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
 #include "drop-tail-queue.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -27,6 +28,9 @@ NS_LOG_COMPONENT_DEFINE ("DropTailQueue");
 
 NS_OBJECT_ENSURE_REGISTERED (DropTailQueue);
 
+/// Largest capacity reserved up front for the packet limit of the ring buffer
+static const uint32_t MAX_INITIAL_CAPACITY = 4096;
+
 TypeId DropTailQueue::GetTypeId (void) 
 {
   static TypeId tid = TypeId ("ns3::DropTailQueue")
@@ -57,7 +61,9 @@ TypeId DropTailQueue::GetTypeId (void)
 
 DropTailQueue::DropTailQueue () :
   Queue (),
-  m_packets (),
+  m_ring (),
+  m_head (0),
+  m_count (0),
   m_bytesInQueue (0)
 {
   NS_LOG_FUNCTION (this);
@@ -82,12 +88,48 @@ DropTailQueue::GetMode (void) const
   return m_mode;
 }
 
+void
+DropTailQueue::Reserve (uint32_t capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+
+  uint32_t size = 16;
+  while (size < capacity)
+    {
+      size <<= 1;
+    }
+  if (size <= m_ring.size ())
+    {
+      return;
+    }
+
+  std::vector<Ptr<Packet> > ring (size);
+  uint32_t mask = m_ring.size () - 1;
+  for (uint32_t i = 0; i < m_count; i++)
+    {
+      ring[i] = m_ring[(m_head + i) & mask];
+    }
+  m_ring.swap (ring);
+  m_head = 0;
+}
+
+Ptr<Packet>
+DropTailQueue::Pop (void)
+{
+  Ptr<Packet> p = m_ring[m_head];
+  m_ring[m_head] = 0;
+  m_head = (m_head + 1) & (m_ring.size () - 1);
+  m_count--;
+  m_bytesInQueue -= p->GetSize ();
+  return p;
+}
+
 bool 
 DropTailQueue::DoEnqueue (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
 
-  if (m_mode == QUEUE_MODE_PACKETS && (m_packets.size () >= m_maxPackets))
+  if (m_mode == QUEUE_MODE_PACKETS && (m_count >= m_maxPackets))
     {
       NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
       Drop (p);
@@ -101,10 +143,21 @@ DropTailQueue::DoEnqueue (Ptr<Packet> p)
       return false;
     }
 
+  if (m_count == m_ring.size ())
+    {
+      uint32_t capacity = m_count + 1;
+      if (m_mode == QUEUE_MODE_PACKETS)
+        {
+          // Size the ring for the limit at once, unless the limit is huge
+          capacity = std::max (capacity, std::min (m_maxPackets, MAX_INITIAL_CAPACITY));
+        }
+      Reserve (capacity);
+    }
+  m_ring[(m_head + m_count) & (m_ring.size () - 1)] = p;
+  m_count++;
   m_bytesInQueue += p->GetSize ();
-  m_packets.push (p);
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_count);
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return true;
@@ -115,38 +168,56 @@ DropTailQueue::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_packets.empty ())
+  if (m_count == 0)
     {
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
 
-  Ptr<Packet> p = m_packets.front ();
-  m_packets.pop ();
-  m_bytesInQueue -= p->GetSize ();
+  Ptr<Packet> p = Pop ();
 
   NS_LOG_LOGIC ("Popped " << p);
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_count);
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return p;
 }
 
+uint32_t
+DropTailQueue::DoDequeueBurst (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets)
+{
+  NS_LOG_FUNCTION (this << maxPackets);
+
+  uint32_t n = std::min (maxPackets, m_count);
+  packets.reserve (packets.size () + n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      packets.push_back (Pop ());
+    }
+
+  NS_LOG_LOGIC ("Popped " << n << " packets");
+
+  NS_LOG_LOGIC ("Number packets " << m_count);
+  NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
+
+  return n;
+}
+
 Ptr<const Packet>
 DropTailQueue::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_packets.empty ())
+  if (m_count == 0)
     {
       NS_LOG_LOGIC ("Queue empty");
       return 0;
     }
 
-  Ptr<Packet> p = m_packets.front ();
+  Ptr<Packet> p = m_ring[m_head];
 
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number packets " << m_count);
   NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
 
   return p;
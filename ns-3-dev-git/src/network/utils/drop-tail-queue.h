@@ -19,7 +19,7 @@
 #ifndef DROPTAIL_H
 #define DROPTAIL_H
 
-#include <queue>
+#include <vector>
 #include "ns3/packet.h"
 #include "ns3/queue.h"
 
@@ -31,6 +31,11 @@ class TraceContainer;
  * \ingroup queue
  *
  * \brief A FIFO packet queue that drops tail-end packets on overflow
+ *
+ * The packets are kept in a ring buffer whose capacity is a power of two.
+ * In packet mode the ring is sized for MaxPackets (up to 4096 packets)
+ * on the first enqueue, so that it does not reallocate; otherwise it
+ * doubles when full.
  */
 class DropTailQueue : public Queue {
 public:
@@ -67,8 +72,25 @@ private:
   virtual bool DoEnqueue (Ptr<Packet> p);
   virtual Ptr<Packet> DoDequeue (void);
   virtual Ptr<const Packet> DoPeek (void) const;
+  virtual uint32_t DoDequeueBurst (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets);
+
+  /**
+   * Reallocate the ring buffer so that it holds at least the given
+   * number of packets, keeping the packets in the queue.
+   *
+   * \param capacity the number of packets to hold
+   */
+  void Reserve (uint32_t capacity);
+  /**
+   * Remove the front packet from the ring buffer.
+   *
+   * \return the packet
+   */
+  Ptr<Packet> Pop (void);
 
-  std::queue<Ptr<Packet> > m_packets; //!< the packets in the queue
+  std::vector<Ptr<Packet> > m_ring;   //!< the slots of the ring buffer
+  uint32_t m_head;                    //!< slot of the front packet
+  uint32_t m_count;                   //!< packets in the ring buffer
   uint32_t m_maxPackets;              //!< max packets in the queue
   uint32_t m_maxBytes;                //!< max bytes in the queue
   uint32_t m_bytesInQueue;            //!< actual bytes in the queue
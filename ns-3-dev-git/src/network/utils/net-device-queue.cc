@@ -0,0 +1,269 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <limits>
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "net-device-queue.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NetDeviceQueue");
+
+NS_OBJECT_ENSURE_REGISTERED (NetDeviceQueue);
+
+/**
+ * \param a a counter
+ * \param b a counter
+ * \returns a - b if a is after b, 0 otherwise
+ */
+static inline uint32_t
+PosDiff (uint32_t a, uint32_t b)
+{
+  return static_cast<int32_t> (a - b) > 0 ? a - b : 0;
+}
+
+TypeId
+NetDeviceQueue::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NetDeviceQueue")
+    .SetParent<Object> ()
+    .SetGroupName ("Network")
+    .AddConstructor<NetDeviceQueue> ()
+    .AddAttribute ("MinLimit",
+                   "The lowest byte queue limit",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&NetDeviceQueue::m_minLimit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxLimit",
+                   "The highest byte queue limit",
+                   UintegerValue (std::numeric_limits<uint32_t>::max () / 16),
+                   MakeUintegerAccessor (&NetDeviceQueue::m_maxLimit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("HoldTime",
+                   "The time over which the slack of the byte queue limit is measured "
+                   "before the limit is lowered",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&NetDeviceQueue::m_slackHoldTime),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+NetDeviceQueue::NetDeviceQueue ()
+  : m_stopped (false),
+    m_numQueued (0),
+    m_adjLimit (0),
+    m_lastObjCnt (0),
+    m_limit (0),
+    m_numCompleted (0),
+    m_prevOvLimit (0),
+    m_prevNumQueued (0),
+    m_prevLastObjCnt (0),
+    m_lowestSlack (std::numeric_limits<uint32_t>::max ()),
+    m_slackStartTime (Seconds (0))
+{
+  NS_LOG_FUNCTION (this);
+}
+
+NetDeviceQueue::~NetDeviceQueue ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+NetDeviceQueue::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_wakeCallback = MakeNullCallback<void> ();
+  Object::DoDispose ();
+}
+
+void
+NetDeviceQueue::Start (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stopped = false;
+}
+
+void
+NetDeviceQueue::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stopped = true;
+}
+
+void
+NetDeviceQueue::Wake (void)
+{
+  NS_LOG_FUNCTION (this);
+  bool wasStopped = m_stopped;
+  m_stopped = false;
+  if (wasStopped && !m_wakeCallback.IsNull ())
+    {
+      m_wakeCallback ();
+    }
+}
+
+bool
+NetDeviceQueue::IsStopped (void) const
+{
+  return m_stopped;
+}
+
+void
+NetDeviceQueue::SetWakeCallback (WakeCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_wakeCallback = cb;
+}
+
+int32_t
+NetDeviceQueue::GetAvailable (void) const
+{
+  return static_cast<int32_t> (m_adjLimit - m_numQueued);
+}
+
+uint32_t
+NetDeviceQueue::GetQueueLimit (void) const
+{
+  return m_limit;
+}
+
+uint32_t
+NetDeviceQueue::GetBytesInFlight (void) const
+{
+  return m_numQueued - m_numCompleted;
+}
+
+void
+NetDeviceQueue::NotifyQueuedBytes (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  if (m_limit < m_minLimit)
+    {
+      // MinLimit was set after the queue was created
+      m_adjLimit += m_minLimit - m_limit;
+      m_limit = m_minLimit;
+    }
+  m_lastObjCnt = bytes;
+  m_numQueued += bytes;
+  if (GetAvailable () < 0)
+    {
+      NS_LOG_LOGIC ("Byte queue limit " << m_limit << " reached");
+      Stop ();
+    }
+}
+
+void
+NetDeviceQueue::NotifyTransmittedBytes (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  // the device may complete packets it queued before the queue was
+  // aggregated to it, which were never counted
+  bytes = std::min (bytes, m_numQueued - m_numCompleted);
+  if (bytes == 0)
+    {
+      return;
+    }
+
+  //
+  // This is the completion of the dynamic queue limits of Linux
+  // (lib/dynamic_queue_limits.c).  The interval between two completions
+  // is the unit of measure: the limit must let the device queue enough
+  // bytes to keep it busy until the next completion.
+  //
+  uint32_t completed = m_numCompleted + bytes;
+  uint32_t limit = m_limit;
+  uint32_t ovlimit = PosDiff (m_numQueued - m_numCompleted, limit);
+  uint32_t inprogress = m_numQueued - completed;
+  uint32_t prevInprogress = m_prevNumQueued - m_numCompleted;
+  bool allPrevCompleted = static_cast<int32_t> (completed - m_prevNumQueued) >= 0;
+
+  if ((ovlimit && !inprogress) || (m_prevOvLimit && allPrevCompleted))
+    {
+      //
+      // The device starved: it was over the limit in the last interval
+      // and has nothing left, or it was over the limit in the previous
+      // interval and all that it had then is now transmitted.  Grow the
+      // limit by the bytes both queued and completed in the last
+      // interval, plus the previous excess.
+      //
+      limit += PosDiff (completed, m_prevNumQueued) + m_prevOvLimit;
+      m_slackStartTime = Simulator::Now ();
+      m_lowestSlack = std::numeric_limits<uint32_t>::max ();
+    }
+  else if (inprogress && prevInprogress && !allPrevCompleted)
+    {
+      //
+      // The device was busy during the whole interval.  The slack is the
+      // excess of bytes queued above what was needed not to starve; the
+      // limit is lowered by the lowest slack seen over HoldTime.
+      //
+      uint32_t slack = PosDiff (limit + m_prevOvLimit, 2 * (completed - m_numCompleted));
+      uint32_t slackLastObjs = m_prevOvLimit ? PosDiff (m_prevLastObjCnt, m_prevOvLimit) : 0;
+      slack = std::max (slack, slackLastObjs);
+      if (slack < m_lowestSlack)
+        {
+          m_lowestSlack = slack;
+        }
+      if (Simulator::Now () > m_slackStartTime + m_slackHoldTime)
+        {
+          limit = PosDiff (limit, m_lowestSlack);
+          m_slackStartTime = Simulator::Now ();
+          m_lowestSlack = std::numeric_limits<uint32_t>::max ();
+        }
+    }
+
+  limit = std::min (std::max (limit, m_minLimit), m_maxLimit);
+  if (limit != m_limit)
+    {
+      NS_LOG_LOGIC ("Byte queue limit " << m_limit << " -> " << limit);
+      m_limit = limit;
+      ovlimit = 0;
+    }
+
+  m_adjLimit = limit + completed;
+  m_prevOvLimit = ovlimit;
+  m_prevLastObjCnt = m_lastObjCnt;
+  m_numCompleted = completed;
+  m_prevNumQueued = m_numQueued;
+
+  if (GetAvailable () >= 0)
+    {
+      Wake ();
+    }
+}
+
+void
+NetDeviceQueue::ResetQueueLimits (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_numQueued = 0;
+  m_numCompleted = 0;
+  m_adjLimit = m_limit;
+  m_lastObjCnt = 0;
+  m_prevOvLimit = 0;
+  m_prevNumQueued = 0;
+  m_prevLastObjCnt = 0;
+  m_lowestSlack = std::numeric_limits<uint32_t>::max ();
+  m_slackStartTime = Simulator::Now ();
+  Wake ();
+}
+
+} // namespace ns3
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NET_DEVICE_QUEUE_H
+#define NET_DEVICE_QUEUE_H
+
+#include <stdint.h>
+#include "ns3/object.h"
+#include "ns3/callback.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ * \brief The transmission queue of a NetDevice, as seen by the layers
+ * above the device.
+ *
+ * A NetDeviceQueue is aggregated to a NetDevice by the layer which sends
+ * packets to the device through a queue of its own, such as a queue disc
+ * of the traffic control layer.  The device stops the queue when it can
+ * not take more packets and wakes it up when it can again; waking the
+ * queue up calls the wake callback, so that the layer above sends its
+ * next packets.
+ *
+ * The queue also applies byte queue limits: the device reports the bytes
+ * it queues and the bytes it has transmitted, and the queue is stopped
+ * while the bytes queued in the device exceed a limit.  The limit is
+ * adapted as in the dynamic queue limits of Linux: it grows when the
+ * device starved while packets were held above it, and shrinks when the
+ * device always had more bytes queued than it needed during HoldTime.
+ * The device queue thus keeps just enough bytes to stay busy, and the
+ * packets wait in the layer above, whose queue management decides which
+ * packet goes next or is dropped.
+ *
+ * Devices which do not report their queue never stop it, and take the
+ * packets as they come.
+ */
+class NetDeviceQueue : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  NetDeviceQueue ();
+  virtual ~NetDeviceQueue ();
+
+  /// Callback invoked when the queue is woken up
+  typedef Callback<void> WakeCallback;
+
+  /**
+   * Let the layer above send packets to the device.
+   */
+  void Start (void);
+  /**
+   * Keep the layer above from sending packets to the device.
+   */
+  void Stop (void);
+  /**
+   * Start the queue and notify the layer above.
+   */
+  void Wake (void);
+  /**
+   * \return true if the layer above must not send packets to the device.
+   */
+  bool IsStopped (void) const;
+  /**
+   * \param cb the callback invoked when the queue is woken up
+   */
+  void SetWakeCallback (WakeCallback cb);
+
+  /**
+   * Report bytes queued in the device, and stop the queue if they exceed
+   * the byte queue limit.
+   *
+   * \param bytes the number of bytes of the packet queued
+   */
+  void NotifyQueuedBytes (uint32_t bytes);
+  /**
+   * Report bytes transmitted by the device, adapt the byte queue limit,
+   * and wake the queue up if the device can take more bytes.
+   *
+   * \param bytes the number of bytes of the packets transmitted
+   */
+  void NotifyTransmittedBytes (uint32_t bytes);
+  /**
+   * Forget the bytes queued in the device, for instance when the device
+   * queue was flushed.
+   */
+  void ResetQueueLimits (void);
+  /**
+   * \return the current byte queue limit
+   */
+  uint32_t GetQueueLimit (void) const;
+  /**
+   * \return the bytes queued in the device and not yet transmitted
+   */
+  uint32_t GetBytesInFlight (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \return the bytes which can still be queued before the limit is
+   * reached; negative if the limit is exceeded
+   */
+  int32_t GetAvailable (void) const;
+
+  bool m_stopped;             //!< the layer above must not send packets
+  WakeCallback m_wakeCallback; //!< notifies the layer above
+
+  // byte queue limits; the counters wrap around
+  uint32_t m_numQueued;       //!< bytes ever queued
+  uint32_t m_adjLimit;        //!< limit plus bytes ever completed
+  uint32_t m_lastObjCnt;      //!< bytes of the last packet queued
+  uint32_t m_limit;           //!< current limit
+  uint32_t m_numCompleted;    //!< bytes ever completed
+  uint32_t m_prevOvLimit;     //!< bytes over the limit at the previous completion
+  uint32_t m_prevNumQueued;   //!< bytes ever queued at the previous completion
+  uint32_t m_prevLastObjCnt;  //!< bytes of the last packet queued at the previous completion
+  uint32_t m_lowestSlack;     //!< lowest slack seen since m_slackStartTime
+  Time m_slackStartTime;      //!< start of the slack measurement
+  uint32_t m_minLimit;        //!< lowest limit
+  uint32_t m_maxLimit;        //!< highest limit
+  Time m_slackHoldTime;       //!< time over which the slack is measured
+};
+
+} // namespace ns3
+
+#endif /* NET_DEVICE_QUEUE_H */
@@ -18,6 +18,7 @@
 
 #include "ns3/log.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/buffer.h"
 #include "ns3/header.h"
 #include "pcap-file-wrapper.h"
@@ -40,6 +41,22 @@ PcapFileWrapper::GetTypeId (void)
                    UintegerValue (PcapFile::SNAPLEN_DEFAULT),
                    MakeUintegerAccessor (&PcapFileWrapper::m_snapLen),
                    MakeUintegerChecker<uint32_t> (0, PcapFile::SNAPLEN_DEFAULT))
+    .AddAttribute ("BufferSize",
+                   "Bytes of packets held in memory before they are written to the file; "
+                   "0 writes each packet as it comes",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&PcapFileWrapper::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("AsyncWrite",
+                   "Write the buffered packets from a background thread",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_async),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Compress",
+                   "Write a gzip compressed pcap file, in blocks of BufferSize bytes",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PcapFileWrapper::m_compress),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -83,6 +100,13 @@ PcapFileWrapper::Close (void)
   m_file.Close ();
 }
 
+void
+PcapFileWrapper::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_file.Flush ();
+}
+
 void
 PcapFileWrapper::Open (std::string const &filename, std::ios::openmode mode)
 {
@@ -99,6 +123,7 @@ PcapFileWrapper::Init (uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrec
   // a snaplen, we use the one provided.
   //
   NS_LOG_FUNCTION (this << dataLinkType << snapLen << tzCorrection);
+  m_file.SetBuffering (m_bufferSize, m_async, m_compress);
   if (snapLen != std::numeric_limits<uint32_t>::max ())
     {
       m_file.Init (dataLinkType, snapLen, tzCorrection);
@@ -82,6 +82,11 @@ public:
    */
   void Close (void);
 
+  /**
+   * Write the packets held in memory when the "BufferSize" attribute is set.
+   */
+  void Flush (void);
+
   /**
    * Initialize the pcap file associated with this wrapper.  This file must have
    * been previously opened with write permissions.
@@ -102,6 +107,9 @@ public:
    * time zone from UTC/GMT.  For example, Pacific Standard Time in the US is
    * GMT-8, so one would enter -8 for that correction.  Defaults to 0 (UTC).
    *
+   * The "BufferSize", "AsyncWrite" and "Compress" attributes select how
+   * the packets are written, see PcapFile::SetBuffering.
+   *
    * \warning Calling this method on an existing file will result in the loss
    * any existing data.
    */
@@ -215,6 +223,9 @@ public:
 private:
   PcapFile m_file; //!< Pcap file
   uint32_t m_snapLen; //!< max length of saved packets
+  uint32_t m_bufferSize; //!< bytes of packets held in memory
+  bool m_async; //!< write from a background thread
+  bool m_compress; //!< compress the file
 };
 
 } // namespace ns3
@@ -20,6 +20,9 @@
 
 #include <iostream>
 #include <cstring>
+#include <list>
+#include "ns3/core-config.h"
+#include "ns3/network-config.h"
 #include "ns3/assert.h"
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
@@ -29,6 +32,12 @@
 #include "pcap-file.h"
 #include "ns3/log.h"
 #include "ns3/build-profile.h"
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif /* HAVE_PTHREAD_H */
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif /* HAVE_ZLIB */
 //
 // This file is used as part of the ns-3 test framework, so please refrain from 
 // adding any ns-3 specific constructs such as Packet to this file.
@@ -47,9 +56,259 @@ const uint32_t NS_SWAPPED_MAGIC = 0xd43cb2a1; /**< Looks this way if byte swappi
 const uint16_t VERSION_MAJOR = 2;             /**< Major version of supported pcap file format */
 const uint16_t VERSION_MINOR = 4;             /**< Minor version of supported pcap file format */
 
+/**
+ * \brief Writes the blocks of records of a buffered PcapFile to its file
+ * stream, compressed or not, from the calling thread or from a background
+ * thread.
+ *
+ * The background thread writes the blocks in the order they are given.
+ * The simulation thread only waits for it when MAX_PENDING_BLOCKS blocks
+ * are already waiting, so that a slow disk bounds the memory used rather
+ * than letting the blocks pile up.
+ */
+class PcapFileWriter
+{
+public:
+  /**
+   * \param file the stream to write to, not used by the caller while the
+   * writer lives
+   * \param async write the blocks from a background thread
+   * \param compress write each block as a gzip member
+   */
+  PcapFileWriter (std::ostream *file, bool async, bool compress);
+  /**
+   * Write the blocks still pending and stop the background thread.
+   */
+  ~PcapFileWriter ();
+  /**
+   * Write a block, or hand it to the background thread.
+   * \param block [in,out] the block, left empty
+   */
+  void Write (std::vector<uint8_t> &block);
+  /**
+   * \returns true if a block could not be written
+   */
+  bool Fail (void);
+
+private:
+  /**
+   * Compress if needed and write a block.
+   * \param block the block
+   */
+  void WriteBlock (const std::vector<uint8_t> &block);
+
+  /** Blocks waiting for the background thread before Write waits. */
+  static const uint32_t MAX_PENDING_BLOCKS = 4;
+
+  std::ostream *m_file;                //!< the stream written to
+  bool m_compress;                     //!< write each block as a gzip member
+  std::vector<uint8_t> m_compressed;   //!< the last block compressed
+  bool m_failed;                       //!< a block could not be written
+#ifdef HAVE_PTHREAD_H
+  /**
+   * The background thread: write the pending blocks until stopped.
+   */
+  void Run (void);
+  /**
+   * Entry point of the background thread.
+   * \param writer the writer
+   * \returns 0
+   */
+  static void * StartThread (void *writer);
+
+  bool m_async;                                  //!< the blocks are written by m_thread
+  bool m_stop;                                   //!< m_thread must exit once the blocks are written
+  std::list<std::vector<uint8_t> > m_pending;    //!< blocks not yet written, oldest first
+  std::list<std::vector<uint8_t> > m_spare;      //!< written blocks, kept for their memory
+  pthread_t m_thread;                            //!< the background thread
+  pthread_mutex_t m_mutex;                       //!< protects the members shared with m_thread
+  pthread_cond_t m_ready;                        //!< signaled when a block is pending or m_stop set
+  pthread_cond_t m_done;                         //!< signaled when a block was written
+#endif /* HAVE_PTHREAD_H */
+};
+
+PcapFileWriter::PcapFileWriter (std::ostream *file, bool async, bool compress)
+  : m_file (file),
+    m_compress (compress),
+    m_failed (false)
+{
+  NS_LOG_FUNCTION (this << file << async << compress);
+#ifdef HAVE_PTHREAD_H
+  m_async = async;
+  m_stop = false;
+  if (m_async)
+    {
+      pthread_mutex_init (&m_mutex, 0);
+      pthread_cond_init (&m_ready, 0);
+      pthread_cond_init (&m_done, 0);
+      if (pthread_create (&m_thread, 0, &PcapFileWriter::StartThread, this) != 0)
+        {
+          NS_LOG_WARN ("Unable to start the pcap writer thread, writing synchronously");
+          pthread_mutex_destroy (&m_mutex);
+          pthread_cond_destroy (&m_ready);
+          pthread_cond_destroy (&m_done);
+          m_async = false;
+        }
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+PcapFileWriter::~PcapFileWriter ()
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      pthread_mutex_lock (&m_mutex);
+      m_stop = true;
+      pthread_cond_signal (&m_ready);
+      pthread_mutex_unlock (&m_mutex);
+      pthread_join (m_thread, 0);
+      pthread_mutex_destroy (&m_mutex);
+      pthread_cond_destroy (&m_ready);
+      pthread_cond_destroy (&m_done);
+    }
+#endif /* HAVE_PTHREAD_H */
+  m_file->flush ();
+}
+
+void
+PcapFileWriter::Write (std::vector<uint8_t> &block)
+{
+  NS_LOG_FUNCTION (this << block.size ());
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      pthread_mutex_lock (&m_mutex);
+      while (m_pending.size () >= MAX_PENDING_BLOCKS)
+        {
+          pthread_cond_wait (&m_done, &m_mutex);
+        }
+      m_pending.push_back (std::vector<uint8_t> ());
+      m_pending.back ().swap (block);
+      if (!m_spare.empty ())
+        {
+          block.swap (m_spare.front ());
+          m_spare.pop_front ();
+        }
+      pthread_cond_signal (&m_ready);
+      pthread_mutex_unlock (&m_mutex);
+      return;
+    }
+#endif /* HAVE_PTHREAD_H */
+  WriteBlock (block);
+  m_failed = m_failed || m_file->fail ();
+  block.clear ();
+}
+
+bool
+PcapFileWriter::Fail (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  if (m_async)
+    {
+      pthread_mutex_lock (&m_mutex);
+      bool failed = m_failed;
+      pthread_mutex_unlock (&m_mutex);
+      return failed;
+    }
+#endif /* HAVE_PTHREAD_H */
+  return m_failed || m_file->fail ();
+}
+
+void
+PcapFileWriter::WriteBlock (const std::vector<uint8_t> &block)
+{
+  NS_LOG_FUNCTION (this << block.size ());
+  if (!m_compress)
+    {
+      m_file->write ((const char *)&block[0], block.size ());
+      return;
+    }
+#ifdef HAVE_ZLIB
+  //
+  // Each block is a complete gzip member: a gzip file may hold several
+  // members, which readers decompress one after the other as a single
+  // stream.  The fastest level keeps the writer ahead of the simulation;
+  // the pcap records compress well anyway.
+  //
+  z_stream stream;
+  std::memset (&stream, 0, sizeof (stream));
+  // a window of 15 bits, plus 16 for a gzip header and trailer
+  if (deflateInit2 (&stream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+      m_failed = true;
+      return;
+    }
+  m_compressed.resize (deflateBound (&stream, block.size ()));
+  stream.next_in = const_cast<Bytef *> (&block[0]);
+  stream.avail_in = block.size ();
+  stream.next_out = &m_compressed[0];
+  stream.avail_out = m_compressed.size ();
+  int status = deflate (&stream, Z_FINISH);
+  uint32_t size = stream.total_out;
+  deflateEnd (&stream);
+  if (status != Z_STREAM_END)
+    {
+      m_failed = true;
+      return;
+    }
+  m_file->write ((const char *)&m_compressed[0], size);
+#else /* HAVE_ZLIB */
+  NS_FATAL_ERROR ("PcapFileWriter::WriteBlock(): compression needs zlib");
+#endif /* HAVE_ZLIB */
+}
+
+#ifdef HAVE_PTHREAD_H
+void *
+PcapFileWriter::StartThread (void *writer)
+{
+  static_cast<PcapFileWriter *> (writer)->Run ();
+  return 0;
+}
+
+void
+PcapFileWriter::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  pthread_mutex_lock (&m_mutex);
+  for (;;)
+    {
+      while (m_pending.empty () && !m_stop)
+        {
+          pthread_cond_wait (&m_ready, &m_mutex);
+        }
+      if (m_pending.empty ())
+        {
+          break;
+        }
+      std::vector<uint8_t> block;
+      block.swap (m_pending.front ());
+      pthread_mutex_unlock (&m_mutex);
+
+      WriteBlock (block);
+      bool failed = m_file->fail ();
+      block.clear ();
+
+      pthread_mutex_lock (&m_mutex);
+      m_failed = m_failed || failed;
+      m_pending.pop_front ();
+      m_spare.push_back (std::vector<uint8_t> ());
+      m_spare.back ().swap (block);
+      pthread_cond_signal (&m_done);
+    }
+  pthread_mutex_unlock (&m_mutex);
+}
+#endif /* HAVE_PTHREAD_H */
+
 PcapFile::PcapFile ()
   : m_file (),
-    m_swapMode (false)
+    m_swapMode (false),
+    m_bufferSize (0),
+    m_async (false),
+    m_compress (false),
+    m_writer (0)
 {
   NS_LOG_FUNCTION (this);
   FatalImpl::RegisterStream (&m_file);
@@ -58,8 +317,8 @@ PcapFile::PcapFile ()
 PcapFile::~PcapFile ()
 {
   NS_LOG_FUNCTION (this);
-  FatalImpl::UnregisterStream (&m_file);
   Close ();
+  FatalImpl::UnregisterStream (&m_file);
 }
 
 
@@ -67,6 +326,10 @@ bool
 PcapFile::Fail (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_writer != 0)
+    {
+      return m_writer->Fail ();
+    }
   return m_file.fail ();
 }
 bool 
@@ -87,9 +350,81 @@ void
 PcapFile::Close (void)
 {
   NS_LOG_FUNCTION (this);
+  Flush ();
+  delete m_writer;
+  m_writer = 0;
   m_file.close ();
 }
 
+void
+PcapFile::SetBuffering (uint32_t bufferSize, bool async, bool compress)
+{
+  NS_LOG_FUNCTION (this << bufferSize << async << compress);
+  NS_ASSERT_MSG (m_writer == 0, "PcapFile::SetBuffering(): must be called before Init");
+#ifndef HAVE_ZLIB
+  NS_ABORT_MSG_IF (compress, "PcapFile::SetBuffering(): compression needs zlib, which was not found");
+#endif /* HAVE_ZLIB */
+  if (compress && bufferSize == 0)
+    {
+      bufferSize = BUFFER_SIZE_DEFAULT;
+    }
+  m_bufferSize = bufferSize;
+  m_async = async;
+  m_compress = compress;
+  m_buffer.reserve (m_bufferSize);
+}
+
+void
+PcapFile::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_buffer.empty ())
+    {
+      return;
+    }
+  if (m_writer == 0)
+    {
+      m_writer = new PcapFileWriter (&m_file, m_async, m_compress);
+    }
+  m_writer->Write (m_buffer);
+  m_buffer.reserve (m_bufferSize);
+}
+
+void
+PcapFile::WriteData (const void *data, uint32_t size)
+{
+  if (m_bufferSize == 0)
+    {
+      m_file.write ((const char *)data, size);
+    }
+  else
+    {
+      const uint8_t *bytes = static_cast<const uint8_t *> (data);
+      m_buffer.insert (m_buffer.end (), bytes, bytes + size);
+    }
+}
+
+uint8_t *
+PcapFile::Reserve (uint32_t size)
+{
+  std::size_t start = m_buffer.size ();
+  m_buffer.resize (start + size);
+  return &m_buffer[0] + start;
+}
+
+void
+PcapFile::EndRecord (void)
+{
+  if (m_bufferSize == 0)
+    {
+      NS_BUILD_DEBUG (m_file.flush ());
+    }
+  else if (m_buffer.size () >= m_bufferSize)
+    {
+      Flush ();
+    }
+}
+
 uint32_t
 PcapFile::GetMagic (void)
 {
@@ -199,6 +534,7 @@ PcapFile::WriteFileHeader (void)
   // at the start of the file.
   //
   m_file.seekp (0, std::ios::beg);
+  m_buffer.clear ();
  
   //
   // We have the ability to write out the pcap file header in a foreign endian
@@ -226,13 +562,13 @@ PcapFile::WriteFileHeader (void)
   // Watch out for memory alignment differences between machines, so write
   // them all individually.
   //
-  m_file.write ((const char *)&headerOut->m_magicNumber, sizeof(headerOut->m_magicNumber));
-  m_file.write ((const char *)&headerOut->m_versionMajor, sizeof(headerOut->m_versionMajor));
-  m_file.write ((const char *)&headerOut->m_versionMinor, sizeof(headerOut->m_versionMinor));
-  m_file.write ((const char *)&headerOut->m_zone, sizeof(headerOut->m_zone));
-  m_file.write ((const char *)&headerOut->m_sigFigs, sizeof(headerOut->m_sigFigs));
-  m_file.write ((const char *)&headerOut->m_snapLen, sizeof(headerOut->m_snapLen));
-  m_file.write ((const char *)&headerOut->m_type, sizeof(headerOut->m_type));
+  WriteData (&headerOut->m_magicNumber, sizeof(headerOut->m_magicNumber));
+  WriteData (&headerOut->m_versionMajor, sizeof(headerOut->m_versionMajor));
+  WriteData (&headerOut->m_versionMinor, sizeof(headerOut->m_versionMinor));
+  WriteData (&headerOut->m_zone, sizeof(headerOut->m_zone));
+  WriteData (&headerOut->m_sigFigs, sizeof(headerOut->m_sigFigs));
+  WriteData (&headerOut->m_snapLen, sizeof(headerOut->m_snapLen));
+  WriteData (&headerOut->m_type, sizeof(headerOut->m_type));
 }
 
 void
@@ -375,7 +711,8 @@ uint32_t
 PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << totalLen);
-  NS_ASSERT (m_file.good ());
+  // the background writer owns the stream
+  NS_ASSERT (m_writer != 0 || m_file.good ());
 
   uint32_t inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
 
@@ -394,11 +731,10 @@ PcapFile::WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
   // Watch out for memory alignment differences between machines, so write
   // them all individually.
   //
-  m_file.write ((const char *)&header.m_tsSec, sizeof(header.m_tsSec));
-  m_file.write ((const char *)&header.m_tsUsec, sizeof(header.m_tsUsec));
-  m_file.write ((const char *)&header.m_inclLen, sizeof(header.m_inclLen));
-  m_file.write ((const char *)&header.m_origLen, sizeof(header.m_origLen));
-  NS_BUILD_DEBUG(m_file.flush());
+  WriteData (&header.m_tsSec, sizeof(header.m_tsSec));
+  WriteData (&header.m_tsUsec, sizeof(header.m_tsUsec));
+  WriteData (&header.m_inclLen, sizeof(header.m_inclLen));
+  WriteData (&header.m_origLen, sizeof(header.m_origLen));
   return inclLen;
 }
 
@@ -407,8 +743,8 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, uint8_t const * const data, ui
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << &data << totalLen);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, totalLen);
-  m_file.write ((const char *)data, inclLen);
-  NS_BUILD_DEBUG(m_file.flush());
+  WriteData (data, inclLen);
+  EndRecord ();
 }
 
 void 
@@ -416,8 +752,15 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
 {
   NS_LOG_FUNCTION (this << tsSec << tsUsec << p);
   uint32_t inclLen = WritePacketHeader (tsSec, tsUsec, p->GetSize ());
-  p->CopyData (&m_file, inclLen);
-  NS_BUILD_DEBUG(m_file.flush());
+  if (m_bufferSize == 0)
+    {
+      p->CopyData (&m_file, inclLen);
+    }
+  else
+    {
+      p->CopyData (Reserve (inclLen), inclLen);
+    }
+  EndRecord ();
 }
 
 void 
@@ -432,9 +775,19 @@ PcapFile::Write (uint32_t tsSec, uint32_t tsUsec, const Header &header, Ptr<cons
   headerBuffer.AddAtStart (headerSize);
   header.Serialize (headerBuffer.Begin ());
   uint32_t toCopy = std::min (headerSize, inclLen);
-  headerBuffer.CopyData (&m_file, toCopy);
   inclLen -= toCopy;
-  p->CopyData (&m_file, inclLen);
+  if (m_bufferSize == 0)
+    {
+      headerBuffer.CopyData (&m_file, toCopy);
+      p->CopyData (&m_file, inclLen);
+    }
+  else
+    {
+      uint8_t *record = Reserve (toCopy + inclLen);
+      headerBuffer.CopyData (record, toCopy);
+      p->CopyData (record + toCopy, inclLen);
+    }
+  EndRecord ();
 }
 
 void
@@ -23,6 +23,7 @@
 
 #include <string>
 #include <fstream>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ptr.h"
 
@@ -30,6 +31,7 @@ namespace ns3 {
 
 class Packet;
 class Header;
+class PcapFileWriter;
 
 
 /**
@@ -44,6 +46,7 @@ class PcapFile
 public:
   static const int32_t  ZONE_DEFAULT    = 0;           /**< Time zone offset for current location */
   static const uint32_t SNAPLEN_DEFAULT = 65535;       /**< Default value for maximum octets to save per packet */
+  static const uint32_t BUFFER_SIZE_DEFAULT = 65536;   /**< Default size of the compressed blocks */
 
 public:
   PcapFile ();
@@ -118,6 +121,37 @@ public:
              int32_t timeZoneCorrection = ZONE_DEFAULT,
              bool swapMode = false);
 
+  /**
+   * \brief Hold the records in memory and write them to the file in blocks.
+   *
+   * By default each record goes to the file stream as it is written.  With
+   * a buffer, the records are gathered in memory and written when the
+   * buffer is full, when Flush is called and when the file is closed.  The
+   * blocks may be written by a background thread, so that the simulation
+   * does not wait for the disk, and may be compressed: each block is then
+   * written as a gzip member, and the file as a whole is a gzip file
+   * holding the pcap file, which Wireshark and zcat read as is.  A
+   * compressed file can not be read back with this class.
+   *
+   * This method must be called before Init.
+   *
+   * \param bufferSize Bytes of records held in memory; 0 writes each record
+   * as it comes.  Compressed files use blocks of BUFFER_SIZE_DEFAULT bytes
+   * when no size is given.
+   * \param async Write the blocks from a background thread; without thread
+   * support the blocks are written synchronously.
+   * \param compress Compress the blocks; the build must have found zlib.
+   */
+  void SetBuffering (uint32_t bufferSize, bool async = false, bool compress = false);
+
+  /**
+   * \brief Write the records held in memory.
+   *
+   * With a background writer, the records are handed to the writer thread,
+   * which may still be writing them when this method returns.
+   */
+  void Flush (void);
+
   /**
    * \brief Write next packet to file
    * 
@@ -348,6 +382,23 @@ private:
    */
   uint32_t WritePacketHeader (uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen);
 
+  /**
+   * \brief Write bytes to the buffer, or to the file if there is none
+   * \param data the bytes
+   * \param size the number of bytes
+   */
+  void WriteData (const void *data, uint32_t size);
+  /**
+   * \brief Make room at the end of the buffer
+   * \param size the number of bytes
+   * \returns the start of the room
+   */
+  uint8_t *Reserve (uint32_t size);
+  /**
+   * \brief Flush the file or the buffer once a record is written
+   */
+  void EndRecord (void);
+
   /**
    * \brief Read and verify a Pcap file header
    */
@@ -357,6 +408,12 @@ private:
   std::fstream   m_file;        //!< file stream
   PcapFileHeader m_fileHeader;  //!< file header
   bool m_swapMode;              //!< swap mode
+
+  uint32_t m_bufferSize;          //!< bytes of records held in memory, 0 if not buffered
+  bool m_async;                   //!< write the blocks from a background thread
+  bool m_compress;                //!< compress the blocks
+  std::vector<uint8_t> m_buffer;  //!< records not yet written
+  PcapFileWriter *m_writer;       //!< writer of the blocks, created on the first flush
 };
 
 } // namespace ns3
@@ -76,20 +76,59 @@ Queue::Enqueue (Ptr<Packet> p)
   bool retval = DoEnqueue (p);
   if (retval)
     {
-      NS_LOG_LOGIC ("m_traceEnqueue (p)");
-      m_traceEnqueue (p);
+      // The trace sources are rarely connected; skip building their calls
+      if (!m_traceEnqueue.IsEmpty ())
+        {
+          NS_LOG_LOGIC ("m_traceEnqueue (p)");
+          m_traceEnqueue (p);
+        }
 
       uint32_t size = p->GetSize ();
       m_nBytes += size;
       m_nTotalReceivedBytes += size;
 
       m_nPackets++;
-      m_tracenPackets (m_nPackets-1, m_nPackets);
+      if (!m_tracenPackets.IsEmpty ())
+        {
+          m_tracenPackets (m_nPackets - 1, m_nPackets);
+        }
       m_nTotalReceivedPackets++;
     }
   return retval;
 }
 
+uint32_t
+Queue::EnqueueBurst (const std::vector<Ptr<Packet> > &packets)
+{
+  NS_LOG_FUNCTION (this << packets.size ());
+
+  uint32_t nPackets = 0;
+  uint32_t nBytes = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator it = packets.begin (); it != packets.end (); ++it)
+    {
+      // If DoEnqueue fails, Queue::Drop is called by the subclass
+      if (DoEnqueue (*it))
+        {
+          if (!m_traceEnqueue.IsEmpty ())
+            {
+              m_traceEnqueue (*it);
+            }
+          nPackets++;
+          nBytes += (*it)->GetSize ();
+        }
+    }
+
+  m_nBytes += nBytes;
+  m_nTotalReceivedBytes += nBytes;
+  m_nPackets += nPackets;
+  m_nTotalReceivedPackets += nPackets;
+  if (nPackets > 0 && !m_tracenPackets.IsEmpty ())
+    {
+      m_tracenPackets (m_nPackets - nPackets, m_nPackets);
+    }
+  return nPackets;
+}
+
 Ptr<Packet>
 Queue::Dequeue (void)
 {
@@ -104,21 +143,84 @@ Queue::Dequeue (void)
 
       m_nBytes -= packet->GetSize ();
       m_nPackets--;
-      m_tracenPackets (m_nPackets+1, m_nPackets);
-
-      NS_LOG_LOGIC ("m_traceDequeue (packet)");
-      m_traceDequeue (packet);
+      if (!m_tracenPackets.IsEmpty ())
+        {
+          m_tracenPackets (m_nPackets + 1, m_nPackets);
+        }
+
+      if (!m_traceDequeue.IsEmpty ())
+        {
+          NS_LOG_LOGIC ("m_traceDequeue (packet)");
+          m_traceDequeue (packet);
+        }
     }
   return packet;
 }
 
+uint32_t
+Queue::DequeueBurst (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets)
+{
+  NS_LOG_FUNCTION (this << maxPackets);
+
+  std::size_t first = packets.size ();
+  uint32_t nPackets = DoDequeueBurst (packets, maxPackets);
+  NS_ASSERT (packets.size () == first + nPackets);
+  NS_ASSERT (m_nPackets >= nPackets);
+
+  uint32_t nBytes = 0;
+  for (std::size_t i = first; i < packets.size (); i++)
+    {
+      nBytes += packets[i]->GetSize ();
+    }
+  NS_ASSERT (m_nBytes >= nBytes);
+  m_nBytes -= nBytes;
+  m_nPackets -= nPackets;
+  if (nPackets > 0 && !m_tracenPackets.IsEmpty ())
+    {
+      m_tracenPackets (m_nPackets + nPackets, m_nPackets);
+    }
+
+  if (!m_traceDequeue.IsEmpty ())
+    {
+      for (std::size_t i = first; i < packets.size (); i++)
+        {
+          m_traceDequeue (packets[i]);
+        }
+    }
+  return nPackets;
+}
+
+uint32_t
+Queue::DoDequeueBurst (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets)
+{
+  NS_LOG_FUNCTION (this << maxPackets);
+
+  uint32_t nPackets = 0;
+  while (nPackets < maxPackets)
+    {
+      Ptr<Packet> packet = DoDequeue ();
+      if (packet == 0)
+        {
+          break;
+        }
+      packets.push_back (packet);
+      nPackets++;
+    }
+  return nPackets;
+}
+
 void
 Queue::DequeueAll (void)
 {
   NS_LOG_FUNCTION (this);
+  std::vector<Ptr<Packet> > packets;
   while (!IsEmpty ())
     {
-      Dequeue ();
+      packets.clear ();
+      if (DequeueBurst (packets, m_nPackets) == 0)
+        {
+          break;
+        }
     }
 }
 
@@ -204,8 +306,11 @@ Queue::Drop (Ptr<Packet> p)
   m_nTotalDroppedPackets++;
   m_nTotalDroppedBytes += p->GetSize ();
 
-  NS_LOG_LOGIC ("m_traceDrop (p)");
-  m_traceDrop (p);
+  if (!m_traceDrop.IsEmpty ())
+    {
+      NS_LOG_LOGIC ("m_traceDrop (p)");
+      m_traceDrop (p);
+    }
 }
 
 } // namespace ns3
@@ -26,6 +26,7 @@
 
 #include <string>
 #include <list>
+#include <vector>
 #include "ns3/packet.h"
 #include "ns3/object.h"
 #include "ns3/traced-callback.h"
@@ -70,6 +71,26 @@ public:
    * \return 0 if the operation was not successful; the packet otherwise.
    */
   Ptr<Packet> Dequeue (void);
+  /**
+   * Place a burst of packets into the rear of the Queue, in order.
+   *
+   * Each packet is accepted or dropped as by Enqueue; the statistics are
+   * updated once for the whole burst.
+   *
+   * \param packets the packets to enqueue
+   * \return the number of packets enqueued
+   */
+  uint32_t EnqueueBurst (const std::vector<Ptr<Packet> > &packets);
+  /**
+   * Remove up to maxPackets packets from the front of the Queue.
+   *
+   * The nPackets trace is fired once for the whole burst.
+   *
+   * \param packets the vector the packets are appended to
+   * \param maxPackets the most packets to dequeue
+   * \return the number of packets dequeued
+   */
+  uint32_t DequeueBurst (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets);
   /**
    * Get a copy of the item at the front of the queue without removing it
    * \return 0 if the operation was not successful; the packet otherwise.
@@ -167,6 +188,16 @@ private:
    * \return the packet.
    */
   virtual Ptr<Packet> DoDequeue (void) = 0;
+  /**
+   * Pull up to maxPackets packets from the queue.
+   *
+   * The default implementation calls DoDequeue for each packet.
+   *
+   * \param packets the vector the packets are appended to
+   * \param maxPackets the most packets to pull
+   * \return the number of packets pulled
+   */
+  virtual uint32_t DoDequeueBurst (std::vector<Ptr<Packet> > &packets, uint32_t maxPackets);
   /**
    * Peek the front packet in the queue
    * \return the packet.
@@ -192,7 +223,7 @@ protected:
 
   uint32_t m_nBytes;                //!< Number of bytes in the queue
   uint32_t m_nTotalReceivedBytes;   //!< Total received bytes
-  TracedValue<uint32_t> m_nPackets;              //!< Number of packets in the queue
+  uint32_t m_nPackets;              //!< Number of packets in the queue
   uint32_t m_nTotalReceivedPackets; //!< Total received packets
   uint32_t m_nTotalDroppedBytes;    //!< Total dropped bytes
   uint32_t m_nTotalDroppedPackets;  //!< Total dropped packets
@@ -62,6 +62,7 @@
 #define RED_QUEUE_H
 
 #include <queue>
+#include <deque>
 #include "ns3/packet.h"
 #include "ns3/queue.h"
 #include "ns3/nstime.h"
@@ -233,7 +234,7 @@ private:
   double ModifyP (double p, uint32_t count, uint32_t countBytes,
                   uint32_t meanPktSize, bool wait, uint32_t size);
 
-  std::list<Ptr<Packet> > m_packets; //!< packets in the queue
+  std::deque<Ptr<Packet> > m_packets; //!< packets in the queue
 
   uint32_t m_bytesInQueue; //!< bytes in the queue
   bool m_hasRedStarted; //!< True if RED has started
@@ -0,0 +1,762 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "time-series-file.h"
+#include "ns3/simulator.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include <algorithm>
+#include <limits>
+#include <string.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimeSeriesFile");
+
+const uint32_t TimeSeriesFile::MAGIC;
+const uint32_t TimeSeriesFile::BLOCK_MAGIC;
+const uint32_t TimeSeriesFile::INDEX_MAGIC;
+const uint32_t TimeSeriesFile::TRAILER_MAGIC;
+const uint16_t TimeSeriesFile::VERSION_MAJOR;
+const uint16_t TimeSeriesFile::VERSION_MINOR;
+const uint32_t TimeSeriesFile::COMPRESSED;
+const uint32_t TimeSeriesFile::HEADER_SIZE;
+const uint32_t TimeSeriesFile::BLOCK_HEADER_SIZE;
+const uint32_t TimeSeriesFile::INDEX_ENTRY_SIZE;
+const uint32_t TimeSeriesFile::TRAILER_SIZE;
+const uint32_t TimeSeriesFile::BLOCK_RECORDS_DEFAULT;
+
+namespace {
+
+/**
+ * Append a little endian integer to a buffer.
+ *
+ * \param buffer the buffer
+ * \param value the integer
+ * \param size the number of bytes of the integer
+ */
+void
+PutLittleEndian (std::vector<uint8_t> &buffer, uint64_t value, uint32_t size)
+{
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      buffer.push_back (static_cast<uint8_t> (value >> (8 * i)));
+    }
+}
+
+/**
+ * \param value a double
+ * \returns the bits of the double
+ */
+uint64_t
+DoubleToBits (double value)
+{
+  uint64_t bits;
+  memcpy (&bits, &value, sizeof (bits));
+  return bits;
+}
+
+/**
+ * \param bits the bits of a double
+ * \returns the double
+ */
+double
+BitsToDouble (uint64_t bits)
+{
+  double value;
+  memcpy (&value, &bits, sizeof (value));
+  return value;
+}
+
+/**
+ * Append a varint, 7 bits per byte with the high bit set on all the bytes
+ * but the last, to a buffer.
+ *
+ * \param buffer the buffer
+ * \param value the integer
+ */
+void
+PutVarint (std::vector<uint8_t> &buffer, uint64_t value)
+{
+  while (value >= 0x80)
+    {
+      buffer.push_back (static_cast<uint8_t> (value | 0x80));
+      value >>= 7;
+    }
+  buffer.push_back (static_cast<uint8_t> (value));
+}
+
+/**
+ * \param value a signed integer
+ * \returns the integer mapped to an unsigned one, small for small
+ * absolute values
+ */
+uint64_t
+ZigZag (int64_t value)
+{
+  return (static_cast<uint64_t> (value) << 1) ^ static_cast<uint64_t> (value >> 63);
+}
+
+/**
+ * \param value an integer mapped by ZigZag()
+ * \returns the signed integer
+ */
+int64_t
+UnZigZag (uint64_t value)
+{
+  return static_cast<int64_t> (value >> 1) ^ -static_cast<int64_t> (value & 1);
+}
+
+/** A bounds checked reader of a buffer. */
+class Cursor
+{
+public:
+  /**
+   * \param data the buffer
+   * \param size the size of the buffer
+   */
+  Cursor (const uint8_t *data, uint32_t size)
+    : m_current (data),
+      m_end (data + size),
+      m_ok (true)
+  {
+  }
+  /**
+   * \param size the number of bytes of the integer
+   * \returns a little endian integer
+   */
+  uint64_t GetLittleEndian (uint32_t size)
+  {
+    if (m_end - m_current < static_cast<int64_t> (size))
+      {
+        m_ok = false;
+        return 0;
+      }
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < size; ++i)
+      {
+        value |= static_cast<uint64_t> (m_current[i]) << (8 * i);
+      }
+    m_current += size;
+    return value;
+  }
+  /**
+   * \returns a varint
+   */
+  uint64_t GetVarint (void)
+  {
+    uint64_t value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7)
+      {
+        if (m_current == m_end)
+          {
+            break;
+          }
+        uint8_t byte = *m_current++;
+        value |= static_cast<uint64_t> (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+          {
+            return value;
+          }
+      }
+    m_ok = false;
+    return 0;
+  }
+  /**
+   * \returns a byte
+   */
+  uint8_t GetByte (void)
+  {
+    return static_cast<uint8_t> (GetLittleEndian (1));
+  }
+  /**
+   * \returns true if all the reads were within the buffer
+   */
+  bool IsOk (void) const
+  {
+    return m_ok;
+  }
+  /**
+   * \returns the number of bytes left to read
+   */
+  uint32_t GetRemaining (void) const
+  {
+    return m_end - m_current;
+  }
+  /**
+   * \returns true if the whole buffer was read
+   */
+  bool IsAtEnd (void) const
+  {
+    return m_current == m_end;
+  }
+
+private:
+  const uint8_t *m_current; //!< Next byte to read
+  const uint8_t *m_end;     //!< End of the buffer
+  bool m_ok;                //!< No read went past the end
+};
+
+/**
+ * Decode the payload of a block.
+ *
+ * \param cursor the payload
+ * \param count the number of records
+ * \param compressed the payload is compressed
+ * \param records the vector the records are appended to
+ * \returns true if the payload is valid
+ */
+bool
+DecodeBlock (Cursor &cursor, uint32_t count, bool compressed,
+             std::vector<TimeSeriesFile::Record> &records)
+{
+  // A record takes at least three bytes compressed, twenty raw
+  if (count == 0 || count > cursor.GetRemaining () / (compressed ? 3 : 20))
+    {
+      return count == 0 && cursor.IsAtEnd ();
+    }
+  std::size_t start = records.size ();
+  records.resize (start + count);
+  TimeSeriesFile::Record *record = &records[0] + start;
+  if (!compressed)
+    {
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          record[i].time = static_cast<int64_t> (cursor.GetLittleEndian (8));
+        }
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          record[i].value = BitsToDouble (cursor.GetLittleEndian (8));
+        }
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          record[i].context = static_cast<uint32_t> (cursor.GetLittleEndian (4));
+        }
+    }
+  else
+    {
+      int64_t time = 0;
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          time += UnZigZag (cursor.GetVarint ());
+          record[i].time = time;
+        }
+      uint64_t bits = 0;
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          uint8_t control = cursor.GetByte ();
+          uint32_t shift = control >> 4;
+          uint32_t size = control & 0x0f;
+          if (shift + size > 8 || (size == 0 && shift != 0))
+            {
+              records.resize (start);
+              return false;
+            }
+          bits ^= cursor.GetLittleEndian (size) << (8 * shift);
+          record[i].value = BitsToDouble (bits);
+        }
+      int64_t context = 0;
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          context += UnZigZag (cursor.GetVarint ());
+          record[i].context = static_cast<uint32_t> (context);
+        }
+    }
+  if (!cursor.IsOk () || !cursor.IsAtEnd ())
+    {
+      records.resize (start);
+      return false;
+    }
+  return true;
+}
+
+} // unnamed namespace
+
+TimeSeriesWriter::TimeSeriesWriter (Ptr<OutputStreamWrapper> stream, bool compress,
+                                    uint32_t blockRecords)
+  : m_stream (stream),
+    m_compress (compress),
+    m_closed (false),
+    m_blockRecords (std::max<uint32_t> (blockRecords, 1)),
+    m_offset (0),
+    m_records (0)
+{
+  NS_LOG_FUNCTION (this << stream << compress << blockRecords);
+  m_times.reserve (m_blockRecords);
+  m_values.reserve (m_blockRecords);
+  m_contexts.reserve (m_blockRecords);
+  WriteHeader ();
+}
+
+TimeSeriesWriter::~TimeSeriesWriter ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+TimeSeriesWriter::Write (Time time, double value, uint32_t context)
+{
+  NS_ASSERT_MSG (!m_closed, "TimeSeriesWriter::Write(): the file is closed");
+  m_times.push_back (time.GetTimeStep ());
+  m_values.push_back (value);
+  m_contexts.push_back (context);
+  if (m_times.size () == m_blockRecords)
+    {
+      Flush ();
+    }
+}
+
+void
+TimeSeriesWriter::Write (double value, uint32_t context)
+{
+  Write (Simulator::Now (), value, context);
+}
+
+void
+TimeSeriesWriter::TraceUint32 (uint32_t oldValue, uint32_t newValue)
+{
+  Write (Simulator::Now (), newValue);
+}
+
+void
+TimeSeriesWriter::TraceDouble (double oldValue, double newValue)
+{
+  Write (Simulator::Now (), newValue);
+}
+
+void
+TimeSeriesWriter::TraceTime (Time oldValue, Time newValue)
+{
+  Write (Simulator::Now (), newValue.GetSeconds ());
+}
+
+void
+TimeSeriesWriter::WriteHeader (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_buffer.clear ();
+  PutLittleEndian (m_buffer, TimeSeriesFile::MAGIC, 4);
+  PutLittleEndian (m_buffer, TimeSeriesFile::VERSION_MAJOR, 2);
+  PutLittleEndian (m_buffer, TimeSeriesFile::VERSION_MINOR, 2);
+  PutLittleEndian (m_buffer, m_compress ? TimeSeriesFile::COMPRESSED : 0, 4);
+  PutLittleEndian (m_buffer, m_blockRecords, 4);
+  PutLittleEndian (m_buffer, Seconds (1).GetTimeStep (), 8);
+  WriteBuffer ();
+}
+
+void
+TimeSeriesWriter::WriteBuffer (void)
+{
+  m_stream->GetStream ()->write (reinterpret_cast<const char *> (&m_buffer[0]), m_buffer.size ());
+  m_offset += m_buffer.size ();
+}
+
+void
+TimeSeriesWriter::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t count = m_times.size ();
+  if (count == 0)
+    {
+      return;
+    }
+
+  TimeSeriesFile::Block block;
+  block.offset = m_offset;
+  block.minTime = *std::min_element (m_times.begin (), m_times.end ());
+  block.maxTime = *std::max_element (m_times.begin (), m_times.end ());
+  block.count = count;
+
+  m_buffer.clear ();
+  PutLittleEndian (m_buffer, TimeSeriesFile::BLOCK_MAGIC, 4);
+  PutLittleEndian (m_buffer, count, 4);
+  PutLittleEndian (m_buffer, 0, 4);
+  if (!m_compress)
+    {
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          PutLittleEndian (m_buffer, static_cast<uint64_t> (m_times[i]), 8);
+        }
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          PutLittleEndian (m_buffer, DoubleToBits (m_values[i]), 8);
+        }
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          PutLittleEndian (m_buffer, m_contexts[i], 4);
+        }
+    }
+  else
+    {
+      int64_t time = 0;
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          PutVarint (m_buffer, ZigZag (m_times[i] - time));
+          time = m_times[i];
+        }
+      uint64_t bits = 0;
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          uint64_t current = DoubleToBits (m_values[i]);
+          uint64_t x = current ^ bits;
+          bits = current;
+          // Keep the bytes of the XOR between its trailing and leading
+          // zero bytes
+          uint32_t shift = 0;
+          uint32_t size = 0;
+          if (x != 0)
+            {
+              while ((x & 0xff) == 0)
+                {
+                  x >>= 8;
+                  ++shift;
+                }
+              for (uint64_t rest = x; rest != 0; rest >>= 8)
+                {
+                  ++size;
+                }
+            }
+          m_buffer.push_back (static_cast<uint8_t> ((shift << 4) | size));
+          PutLittleEndian (m_buffer, x, size);
+        }
+      int64_t context = 0;
+      for (uint32_t i = 0; i < count; ++i)
+        {
+          PutVarint (m_buffer, ZigZag (static_cast<int64_t> (m_contexts[i]) - context));
+          context = m_contexts[i];
+        }
+    }
+  block.size = m_buffer.size () - TimeSeriesFile::BLOCK_HEADER_SIZE;
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      m_buffer[8 + i] = static_cast<uint8_t> (block.size >> (8 * i));
+    }
+  WriteBuffer ();
+
+  m_index.push_back (block);
+  m_records += count;
+  m_times.clear ();
+  m_values.clear ();
+  m_contexts.clear ();
+}
+
+void
+TimeSeriesWriter::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_closed)
+    {
+      return;
+    }
+  Flush ();
+
+  uint64_t indexOffset = m_offset;
+  m_buffer.clear ();
+  PutLittleEndian (m_buffer, TimeSeriesFile::INDEX_MAGIC, 4);
+  PutLittleEndian (m_buffer, m_index.size (), 4);
+  for (std::vector<TimeSeriesFile::Block>::const_iterator i = m_index.begin (); i != m_index.end (); ++i)
+    {
+      PutLittleEndian (m_buffer, i->offset, 8);
+      PutLittleEndian (m_buffer, static_cast<uint64_t> (i->minTime), 8);
+      PutLittleEndian (m_buffer, static_cast<uint64_t> (i->maxTime), 8);
+      PutLittleEndian (m_buffer, i->count, 4);
+      PutLittleEndian (m_buffer, i->size, 4);
+    }
+  PutLittleEndian (m_buffer, indexOffset, 8);
+  PutLittleEndian (m_buffer, m_records, 8);
+  PutLittleEndian (m_buffer, TimeSeriesFile::TRAILER_MAGIC, 4);
+  WriteBuffer ();
+  m_stream->GetStream ()->flush ();
+  m_closed = true;
+}
+
+uint64_t
+TimeSeriesWriter::GetNRecords (void) const
+{
+  return m_records + m_times.size ();
+}
+
+TimeSeriesReader::TimeSeriesReader ()
+  : m_flags (0),
+    m_stepsPerSecond (0),
+    m_recovered (false),
+    m_records (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TimeSeriesReader::~TimeSeriesReader ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+bool
+TimeSeriesReader::Open (std::string const &filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+  m_file.open (filename.c_str (), std::ios::in | std::ios::binary);
+  if (!m_file.is_open ())
+    {
+      NS_LOG_WARN ("Cannot open " << filename);
+      return false;
+    }
+
+  uint8_t header[TimeSeriesFile::HEADER_SIZE];
+  m_file.read (reinterpret_cast<char *> (header), sizeof (header));
+  Cursor cursor (header, m_file.gcount ());
+  uint32_t magic = cursor.GetLittleEndian (4);
+  uint16_t major = cursor.GetLittleEndian (2);
+  cursor.GetLittleEndian (2);
+  m_flags = cursor.GetLittleEndian (4);
+  cursor.GetLittleEndian (4);
+  m_stepsPerSecond = cursor.GetLittleEndian (8);
+  if (!cursor.IsOk () || magic != TimeSeriesFile::MAGIC || major != TimeSeriesFile::VERSION_MAJOR
+      || m_stepsPerSecond == 0)
+    {
+      NS_LOG_WARN (filename << " is not a time series file");
+      Close ();
+      return false;
+    }
+
+  m_file.seekg (0, std::ios::end);
+  uint64_t size = m_file.tellg ();
+  if (!ReadIndex (size))
+    {
+      RecoverIndex (size);
+    }
+  return true;
+}
+
+bool
+TimeSeriesReader::ReadIndex (uint64_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  if (size < TimeSeriesFile::HEADER_SIZE + 8 + TimeSeriesFile::TRAILER_SIZE)
+    {
+      return false;
+    }
+  uint8_t trailer[TimeSeriesFile::TRAILER_SIZE];
+  m_file.clear ();
+  m_file.seekg (size - TimeSeriesFile::TRAILER_SIZE);
+  m_file.read (reinterpret_cast<char *> (trailer), sizeof (trailer));
+  Cursor cursor (trailer, m_file.gcount ());
+  uint64_t indexOffset = cursor.GetLittleEndian (8);
+  uint64_t records = cursor.GetLittleEndian (8);
+  uint32_t magic = cursor.GetLittleEndian (4);
+  if (!cursor.IsOk () || magic != TimeSeriesFile::TRAILER_MAGIC
+      || indexOffset < TimeSeriesFile::HEADER_SIZE
+      || indexOffset + 8 + TimeSeriesFile::TRAILER_SIZE > size)
+    {
+      return false;
+    }
+
+  m_buffer.resize (size - TimeSeriesFile::TRAILER_SIZE - indexOffset);
+  m_file.seekg (indexOffset);
+  m_file.read (reinterpret_cast<char *> (&m_buffer[0]), m_buffer.size ());
+  Cursor index (&m_buffer[0], m_file.gcount ());
+  magic = index.GetLittleEndian (4);
+  uint32_t blocks = index.GetLittleEndian (4);
+  if (!index.IsOk () || magic != TimeSeriesFile::INDEX_MAGIC
+      || m_buffer.size () != 8 + static_cast<uint64_t> (blocks) * TimeSeriesFile::INDEX_ENTRY_SIZE)
+    {
+      return false;
+    }
+  m_index.resize (blocks);
+  for (uint32_t i = 0; i < blocks; ++i)
+    {
+      m_index[i].offset = index.GetLittleEndian (8);
+      m_index[i].minTime = static_cast<int64_t> (index.GetLittleEndian (8));
+      m_index[i].maxTime = static_cast<int64_t> (index.GetLittleEndian (8));
+      m_index[i].count = index.GetLittleEndian (4);
+      m_index[i].size = index.GetLittleEndian (4);
+    }
+  m_records = records;
+  return index.IsOk ();
+}
+
+void
+TimeSeriesReader::RecoverIndex (uint64_t size)
+{
+  NS_LOG_FUNCTION (this << size);
+  m_index.clear ();
+  m_records = 0;
+  m_recovered = true;
+  uint64_t offset = TimeSeriesFile::HEADER_SIZE;
+  while (offset + TimeSeriesFile::BLOCK_HEADER_SIZE <= size)
+    {
+      uint8_t header[TimeSeriesFile::BLOCK_HEADER_SIZE];
+      m_file.clear ();
+      m_file.seekg (offset);
+      m_file.read (reinterpret_cast<char *> (header), sizeof (header));
+      Cursor cursor (header, m_file.gcount ());
+      uint32_t magic = cursor.GetLittleEndian (4);
+      TimeSeriesFile::Block block;
+      block.offset = offset;
+      block.count = cursor.GetLittleEndian (4);
+      block.size = cursor.GetLittleEndian (4);
+      if (!cursor.IsOk () || magic != TimeSeriesFile::BLOCK_MAGIC
+          || offset + TimeSeriesFile::BLOCK_HEADER_SIZE + block.size > size)
+        {
+          break;
+        }
+      // The time range is unknown without decoding the block
+      block.minTime = std::numeric_limits<int64_t>::min ();
+      block.maxTime = std::numeric_limits<int64_t>::max ();
+      m_index.push_back (block);
+      m_records += block.count;
+      offset += TimeSeriesFile::BLOCK_HEADER_SIZE + block.size;
+    }
+  NS_LOG_WARN ("Time series file not closed, recovered " << m_index.size () << " blocks");
+}
+
+void
+TimeSeriesReader::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+  m_file.clear ();
+  m_flags = 0;
+  m_stepsPerSecond = 0;
+  m_recovered = false;
+  m_records = 0;
+  m_index.clear ();
+}
+
+bool
+TimeSeriesReader::IsCompressed (void) const
+{
+  return (m_flags & TimeSeriesFile::COMPRESSED) != 0;
+}
+
+bool
+TimeSeriesReader::IsRecovered (void) const
+{
+  return m_recovered;
+}
+
+uint64_t
+TimeSeriesReader::GetStepsPerSecond (void) const
+{
+  return m_stepsPerSecond;
+}
+
+double
+TimeSeriesReader::GetSeconds (int64_t time) const
+{
+  return static_cast<double> (time) / m_stepsPerSecond;
+}
+
+uint64_t
+TimeSeriesReader::GetNRecords (void) const
+{
+  return m_records;
+}
+
+uint32_t
+TimeSeriesReader::GetNBlocks (void) const
+{
+  return m_index.size ();
+}
+
+const TimeSeriesFile::Block &
+TimeSeriesReader::GetBlock (uint32_t i) const
+{
+  NS_ASSERT (i < m_index.size ());
+  return m_index[i];
+}
+
+bool
+TimeSeriesReader::ReadBlock (uint32_t i, std::vector<TimeSeriesFile::Record> &records)
+{
+  NS_LOG_FUNCTION (this << i);
+  NS_ASSERT (i < m_index.size ());
+  const TimeSeriesFile::Block &block = m_index[i];
+  m_buffer.resize (TimeSeriesFile::BLOCK_HEADER_SIZE + block.size);
+  m_file.clear ();
+  m_file.seekg (block.offset);
+  m_file.read (reinterpret_cast<char *> (&m_buffer[0]), m_buffer.size ());
+  Cursor cursor (&m_buffer[0], m_file.gcount ());
+  uint32_t magic = cursor.GetLittleEndian (4);
+  uint32_t count = cursor.GetLittleEndian (4);
+  uint32_t size = cursor.GetLittleEndian (4);
+  if (!cursor.IsOk () || magic != TimeSeriesFile::BLOCK_MAGIC
+      || count != block.count || size != block.size
+      || m_file.gcount () != static_cast<std::streamsize> (m_buffer.size ()))
+    {
+      NS_LOG_WARN ("Invalid header of block " << i);
+      return false;
+    }
+  Cursor payload (&m_buffer[TimeSeriesFile::BLOCK_HEADER_SIZE], size);
+  if (!DecodeBlock (payload, count, IsCompressed (), records))
+    {
+      NS_LOG_WARN ("Invalid payload of block " << i);
+      return false;
+    }
+  return true;
+}
+
+bool
+TimeSeriesReader::ReadAll (std::vector<TimeSeriesFile::Record> &records)
+{
+  NS_LOG_FUNCTION (this);
+  records.reserve (records.size () + m_records);
+  for (uint32_t i = 0; i < m_index.size (); ++i)
+    {
+      if (!ReadBlock (i, records))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+bool
+TimeSeriesReader::ReadRange (Time from, Time to, std::vector<TimeSeriesFile::Record> &records)
+{
+  NS_LOG_FUNCTION (this << from << to);
+  int64_t first = from.GetTimeStep ();
+  int64_t last = to.GetTimeStep ();
+  for (uint32_t i = 0; i < m_index.size (); ++i)
+    {
+      if (m_index[i].maxTime < first || m_index[i].minTime > last)
+        {
+          continue;
+        }
+      std::size_t start = records.size ();
+      if (!ReadBlock (i, records))
+        {
+          return false;
+        }
+      std::size_t kept = start;
+      for (std::size_t j = start; j < records.size (); ++j)
+        {
+          if (records[j].time >= first && records[j].time <= last)
+            {
+              records[kept++] = records[j];
+            }
+        }
+      records.resize (kept);
+    }
+  return true;
+}
+
+} // namespace ns3
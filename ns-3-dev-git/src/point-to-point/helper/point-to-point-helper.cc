@@ -88,7 +88,7 @@ PointToPointHelper::EnablePcapInternal (std::string prefix, Ptr<NetDevice> nd, b
       return;
     }
 
-  PcapHelper pcapHelper;
+  PcapHelper &pcapHelper = m_pcapHelper;
 
   std::string filename;
   if (explicitFilename)
@@ -18,6 +18,7 @@
 
 #include "ns3/log.h"
 #include "ns3/queue.h"
+#include "ns3/net-device-queue.h"
 #include "ns3/simulator.h"
 #include "ns3/mac48-address.h"
 #include "ns3/llc-snap-header.h"
@@ -214,9 +215,21 @@ PointToPointNetDevice::DoDispose ()
   m_channel = 0;
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
+  m_queueInterface = 0;
   NetDevice::DoDispose ();
 }
 
+void
+PointToPointNetDevice::NotifyNewAggregate (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_queueInterface == 0)
+    {
+      m_queueInterface = GetObject<NetDeviceQueue> ();
+    }
+  NetDevice::NotifyNewAggregate ();
+}
+
 void
 PointToPointNetDevice::SetDataRate (DataRate bps)
 {
@@ -278,23 +291,29 @@ PointToPointNetDevice::TransmitComplete (void)
   NS_ASSERT_MSG (m_currentPkt != 0, "PointToPointNetDevice::TransmitComplete(): m_currentPkt zero");
 
   m_phyTxEndTrace (m_currentPkt);
+  uint32_t size = m_currentPkt->GetSize ();
   m_currentPkt = 0;
 
   Ptr<Packet> p = m_queue->Dequeue ();
-  if (p == 0)
+  if (p != 0)
     {
       //
-      // No packet was on the queue, so we just exit.
+      // Got another packet off of the queue, so start the transmit process agin.
       //
-      return;
+      m_snifferTrace (p);
+      m_promiscSnifferTrace (p);
+      TransmitStart (p);
     }
 
   //
-  // Got another packet off of the queue, so start the transmit process agin.
+  // Report the transmitted bytes once the next packet is on the wire, so
+  // that the layer above, if woken up, finds the device busy and queues
+  // its packets rather than starting a transmission of its own.
   //
-  m_snifferTrace (p);
-  m_promiscSnifferTrace (p);
-  TransmitStart (p);
+  if (m_queueInterface != 0)
+    {
+      m_queueInterface->NotifyTransmittedBytes (size);
+    }
 }
 
 bool
@@ -537,6 +556,10 @@ PointToPointNetDevice::Send (
   //
   if (m_queue->Enqueue (packet))
     {
+      if (m_queueInterface != 0)
+        {
+          m_queueInterface->NotifyQueuedBytes (packet->GetSize ());
+        }
       //
       // If the channel is ready for transition we send the packet right now
       // 
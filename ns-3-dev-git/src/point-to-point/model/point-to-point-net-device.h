@@ -34,6 +34,7 @@
 namespace ns3 {
 
 class Queue;
+class NetDeviceQueue;
 class PointToPointChannel;
 class ErrorModel;
 
@@ -224,6 +225,11 @@ private:
    */
   virtual void DoDispose (void);
 
+  /**
+   * \brief Find the NetDeviceQueue aggregated to the device, if any
+   */
+  virtual void NotifyNewAggregate (void);
+
 private:
 
   /**
@@ -321,6 +327,16 @@ private:
    */
   Ptr<Queue> m_queue;
 
+  /**
+   * The NetDeviceQueue aggregated to this device by the layer above, if
+   * any.  The device reports to it the bytes it queues and transmits, so
+   * that the layer above holds the packets the device does not need to
+   * stay busy.  The device queue must not drop the packets it has taken
+   * (a DropTailQueue does not), otherwise the bytes of the dropped
+   * packets would be counted as in flight forever.
+   */
+  Ptr<NetDeviceQueue> m_queueInterface;
+
   /**
    * Error model for receive packet events
    */
@@ -81,6 +81,30 @@ PropagationLossModel::CalcRxPower (double txPowerDbm,
   return self;
 }
 
+void
+PropagationLossModel::CalcRxPowers (Ptr<MobilityModel> a,
+                                    const std::vector<Ptr<MobilityModel> > &b,
+                                    std::vector<double> &powersDbm) const
+{
+  NS_ASSERT (b.size () == powersDbm.size ());
+  DoCalcRxPowers (a, b, powersDbm);
+  if (m_next != 0)
+    {
+      m_next->CalcRxPowers (a, b, powersDbm);
+    }
+}
+
+void
+PropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                      const std::vector<Ptr<MobilityModel> > &b,
+                                      std::vector<double> &powersDbm) const
+{
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      powersDbm[i] = DoCalcRxPower (powersDbm[i], a, b[i]);
+    }
+}
+
 int64_t
 PropagationLossModel::AssignStreams (int64_t stream)
 {
@@ -269,6 +293,38 @@ FriisPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm - std::max (lossDb, m_minLoss);
 }
 
+void
+FriisPropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                           const std::vector<Ptr<MobilityModel> > &b,
+                                           std::vector<double> &powersDbm) const
+{
+  // the distances first, then the losses in a loop without calls
+  uint32_t n = b.size ();
+  std::vector<double> distances (n);
+  Vector position = a->GetPosition ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      distances[i] = CalculateDistance (position, b[i]->GetPosition ());
+      if (distances[i] < 3*m_lambda)
+        {
+          NS_LOG_WARN ("distance not within the far field region => inaccurate propagation loss value");
+        }
+    }
+  double numerator = m_lambda * m_lambda;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double distance = distances[i];
+      if (distance <= 0)
+        {
+          powersDbm[i] -= m_minLoss;
+          continue;
+        }
+      double denominator = 16 * M_PI * M_PI * distance * distance * m_systemLoss;
+      double lossDb = -10 * log10 (numerator / denominator);
+      powersDbm[i] -= std::max (lossDb, m_minLoss);
+    }
+}
+
 int64_t
 FriisPropagationLossModel::DoAssignStreams (int64_t stream)
 {
@@ -531,6 +587,29 @@ LogDistancePropagationLossModel::DoCalcRxPower (double txPowerDbm,
   return txPowerDbm + rxc;
 }
 
+void
+LogDistancePropagationLossModel::DoCalcRxPowers (Ptr<MobilityModel> a,
+                                                 const std::vector<Ptr<MobilityModel> > &b,
+                                                 std::vector<double> &powersDbm) const
+{
+  // the distances first, then the losses in a loop without calls
+  uint32_t n = b.size ();
+  std::vector<double> distances (n);
+  Vector position = a->GetPosition ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      distances[i] = CalculateDistance (position, b[i]->GetPosition ());
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      if (distances[i] > m_referenceDistance)
+        {
+          double pathLossDb = 10 * m_exponent * std::log10 (distances[i] / m_referenceDistance);
+          powersDbm[i] += -m_referenceLoss - pathLossDb;
+        }
+    }
+}
+
 int64_t
 LogDistancePropagationLossModel::DoAssignStreams (int64_t stream)
 {
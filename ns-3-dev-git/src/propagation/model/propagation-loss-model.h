@@ -28,6 +28,7 @@
 #include "ns3/object.h"
 #include "ns3/random-variable-stream.h"
 #include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -93,6 +94,22 @@ public:
                       Ptr<MobilityModel> a,
                       Ptr<MobilityModel> b) const;
 
+  /**
+   * Returns the Rx Powers of a transmission at several destinations,
+   * taking into account all the PropagationLossModel(s) chained to the
+   * current one. The result is the same as calling CalcRxPower for each
+   * destination in turn, but the models which support it process all the
+   * destinations in one pass.
+   *
+   * \param a the mobility model of the source
+   * \param b the mobility models of the destinations
+   * \param powersDbm on input, the transmission power (in dBm) towards
+   * each destination; on output, the reception power at each destination
+   */
+  void CalcRxPowers (Ptr<MobilityModel> a,
+                     const std::vector<Ptr<MobilityModel> > &b,
+                     std::vector<double> &powersDbm) const;
+
   /**
    * If this loss model uses objects of type RandomVariableStream,
    * set the stream numbers to the integers starting with the offset
@@ -134,6 +151,19 @@ private:
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const = 0;
 
+  /**
+   * Applies only the particular PropagationLossModel to the Rx Powers of
+   * several destinations. The default calls DoCalcRxPower for each
+   * destination in turn.
+   *
+   * \param a the mobility model of the source
+   * \param b the mobility models of the destinations
+   * \param powersDbm the powers (in dBm) to update
+   */
+  virtual void DoCalcRxPowers (Ptr<MobilityModel> a,
+                               const std::vector<Ptr<MobilityModel> > &b,
+                               std::vector<double> &powersDbm) const;
+
   /**
    * Subclasses must implement this; those not using random variables
    * can return zero
@@ -321,6 +351,9 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowers (Ptr<MobilityModel> a,
+                               const std::vector<Ptr<MobilityModel> > &b,
+                               std::vector<double> &powersDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   /**
@@ -529,6 +562,9 @@ private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
                                 Ptr<MobilityModel> b) const;
+  virtual void DoCalcRxPowers (Ptr<MobilityModel> a,
+                               const std::vector<Ptr<MobilityModel> > &b,
+                               std::vector<double> &powersDbm) const;
   virtual int64_t DoAssignStreams (int64_t stream);
 
   /**
@@ -436,6 +436,75 @@ RangePropagationLossModelTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check that CalcRxPowers gives the same powers as CalcRxPower, for the
+ * models which compute all the destinations in one pass, for the others,
+ * and for a chain of both.
+ */
+class CalcRxPowersTestCase : public TestCase
+{
+public:
+  CalcRxPowersTestCase ();
+  virtual ~CalcRxPowersTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \param model the loss model to check
+   * \param name the name of the model
+   */
+  void Check (Ptr<PropagationLossModel> model, std::string name);
+};
+
+CalcRxPowersTestCase::CalcRxPowersTestCase ()
+  : TestCase ("Test PropagationLossModel::CalcRxPowers")
+{
+}
+
+CalcRxPowersTestCase::~CalcRxPowersTestCase ()
+{
+}
+
+void
+CalcRxPowersTestCase::Check (Ptr<PropagationLossModel> model, std::string name)
+{
+  Ptr<MobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (10, -20, 1.5));
+  std::vector<Ptr<MobilityModel> > b;
+  std::vector<double> powers;
+  double distances[] = { 0, 0.5, 1, 2, 30, 100, 250, 1000, 5000 };
+  for (uint32_t i = 0; i < sizeof (distances) / sizeof (distances[0]); i++)
+    {
+      Ptr<MobilityModel> m = CreateObject<ConstantPositionMobilityModel> ();
+      m->SetPosition (Vector (10 + distances[i] * 0.6, -20 - distances[i] * 0.8, 1.5));
+      b.push_back (m);
+      powers.push_back (16.0 - i);
+    }
+  std::vector<double> expected;
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      expected.push_back (model->CalcRxPower (powers[i], a, b[i]));
+    }
+  model->CalcRxPowers (a, b, powers);
+  for (uint32_t i = 0; i < b.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (powers[i], expected[i], name << ": wrong power at " << distances[i] << " m");
+    }
+}
+
+void
+CalcRxPowersTestCase::DoRun (void)
+{
+  Check (CreateObject<FriisPropagationLossModel> (), "Friis");
+  Check (CreateObject<LogDistancePropagationLossModel> (), "LogDistance");
+  Check (CreateObject<ThreeLogDistancePropagationLossModel> (), "ThreeLogDistance");
+  Ptr<PropagationLossModel> chain = CreateObject<LogDistancePropagationLossModel> ();
+  chain->SetNext (CreateObject<RangePropagationLossModel> ());
+  chain->GetNext ()->SetNext (CreateObject<FriisPropagationLossModel> ());
+  Check (chain, "LogDistance, Range and Friis");
+  Simulator::Destroy ();
+}
+
 class PropagationLossModelsTestSuite : public TestSuite
 {
 public:
@@ -450,6 +519,7 @@ PropagationLossModelsTestSuite::PropagationLossModelsTestSuite ()
   AddTestCase (new LogDistancePropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new MatrixPropagationLossModelTestCase, TestCase::QUICK);
   AddTestCase (new RangePropagationLossModelTestCase, TestCase::QUICK);
+  AddTestCase (new CalcRxPowersTestCase, TestCase::QUICK);
 }
 
 static PropagationLossModelsTestSuite propagationLossModelsTestSuite;
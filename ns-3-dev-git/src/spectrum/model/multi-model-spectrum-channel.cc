@@ -36,6 +36,7 @@
 #include <ns3/angles.h>
 #include <iostream>
 #include <utility>
+#include <algorithm>
 #include "multi-model-spectrum-channel.h"
 
 
@@ -76,6 +77,7 @@ RxSpectrumModelInfo::RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumMod
 
 
 MultiModelSpectrumChannel::MultiModelSpectrumChannel ()
+  : m_gridStale (true)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -89,6 +91,9 @@ MultiModelSpectrumChannel::DoDispose ()
   m_spectrumPropagationLoss = 0;
   m_txSpectrumModelInfoMap.clear ();
   m_rxSpectrumModelInfoMap.clear ();
+  m_grid.Clear ();
+  m_rxOf.clear ();
+  m_unlocatedRx.clear ();
   SpectrumChannel::DoDispose ();
 }
 
@@ -113,6 +118,15 @@ MultiModelSpectrumChannel::GetTypeId (void)
                    DoubleValue (1.0e9),
                    MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxLossDb),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxRange",
+                   "The distance (m) beyond which transmissions are not "
+                   "passed to the receiving PHY. Like MaxLossDb, this is "
+                   "to be set beyond the interference range, and saves "
+                   "the computation of the losses of the receivers out of "
+                   "range. 0 passes transmissions at any distance.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0.0))
     .AddTraceSource ("PathLoss",
                      "This trace is fired whenever a new path loss value "
                      "is calculated. The first and second parameters "
@@ -145,7 +159,7 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
 
   SpectrumModelUid_t rxSpectrumModelUid = rxSpectrumModel->GetUid ();
 
-  std::vector<Ptr<SpectrumPhy> >::const_iterator it;
+  m_gridStale = true;
 
   // remove a previous entry of this phy if it exists
   // we need to scan for all rxSpectrumModel values since we don't
@@ -155,10 +169,11 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
        rxInfoIterator !=  m_rxSpectrumModelInfoMap.end ();
        ++rxInfoIterator)
     {
-      std::set<Ptr<SpectrumPhy> >::iterator phyIt = rxInfoIterator->second.m_rxPhySet.find (phy);
-      if (phyIt !=  rxInfoIterator->second.m_rxPhySet.end ())
+      std::vector<Ptr<SpectrumPhy> > &rxPhys = rxInfoIterator->second.m_rxPhys;
+      std::vector<Ptr<SpectrumPhy> >::iterator phyIt = std::find (rxPhys.begin (), rxPhys.end (), phy);
+      if (phyIt != rxPhys.end ())
         {
-          rxInfoIterator->second.m_rxPhySet.erase (phyIt);
+          rxPhys.erase (phyIt);
           --m_numDevices;
           break; // there should be at most one entry
         }       
@@ -175,8 +190,7 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
       ret = m_rxSpectrumModelInfoMap.insert (std::make_pair (rxSpectrumModelUid, RxSpectrumModelInfo (rxSpectrumModel)));
       NS_ASSERT (ret.second);
       // also add the phy to the newly created set of SpectrumPhy for this RxSpectrumModel
-      std::pair<std::set<Ptr<SpectrumPhy> >::iterator, bool> ret2 = ret.first->second.m_rxPhySet.insert (phy);
-      NS_ASSERT (ret2.second);
+      ret.first->second.m_rxPhys.push_back (phy);
 
       // and create the necessary converters for all the TX spectrum models that we know of
       for (TxSpectrumModelInfoMap_t::iterator txInfoIterator = m_txSpectrumModelInfoMap.begin ();
@@ -194,8 +208,7 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
   else
     {
       // spectrum model is already known, just add the device to the corresponding list
-      std::pair<std::set<Ptr<SpectrumPhy> >::iterator, bool> ret2 = rxInfoIterator->second.m_rxPhySet.insert (phy);
-      NS_ASSERT (ret2.second);
+      rxInfoIterator->second.m_rxPhys.push_back (phy);
     }
 
 }
@@ -266,108 +279,208 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
   NS_LOG_LOGIC ("converter map size: " << txInfoIteratorerator->second.m_spectrumConverterMap.size ());
   NS_LOG_LOGIC ("converter map first element: " << txInfoIteratorerator->second.m_spectrumConverterMap.begin ()->first);
 
-  for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
-       rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
-       ++rxInfoIterator)
+  std::vector<RxCandidate> candidates;
+  if (m_maxRange > 0 && txMobility)
+    {
+      GetCandidates (txMobility, candidates);
+    }
+  else
     {
-      SpectrumModelUid_t rxSpectrumModelUid = rxInfoIterator->second.m_rxSpectrumModel->GetUid ();
-      NS_LOG_LOGIC (" rxSpectrumModelUids " << rxSpectrumModelUid);
+      for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
+           rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
+           ++rxInfoIterator)
+        {
+          RxCandidate candidate;
+          candidate.uid = rxInfoIterator->first;
+          const std::vector<Ptr<SpectrumPhy> > &rxPhys = rxInfoIterator->second.m_rxPhys;
+          for (uint32_t i = 0; i < rxPhys.size (); i++)
+            {
+              candidate.rank = i;
+              candidate.phy = rxPhys[i];
+              candidates.push_back (candidate);
+            }
+        }
+    }
 
-      Ptr <SpectrumValue> convertedTxPowerSpectrum;
-      if (txSpectrumModelUid == rxSpectrumModelUid)
+  // the receivers in range, and their single-frequency propagation
+  // gains, computed in one pass
+  std::vector<RxCandidate> receivers;
+  std::vector<Ptr<MobilityModel> > receiverMobilities;
+  receivers.reserve (candidates.size ());
+  receiverMobilities.reserve (candidates.size ());
+  for (std::vector<RxCandidate>::const_iterator it = candidates.begin (); it != candidates.end (); ++it)
+    {
+      NS_ASSERT_MSG (it->phy->GetRxSpectrumModel ()->GetUid () == it->uid,
+                     "SpectrumModel change was not notified to MultiModelSpectrumChannel (i.e., AddRx should be called again after model is changed)");
+      if (it->phy == txParams->txPhy)
         {
-          NS_LOG_LOGIC ("no spectrum conversion needed");
-          convertedTxPowerSpectrum = txParams->psd;
+          continue;
         }
-      else
+      Ptr<MobilityModel> receiverMobility = it->phy->GetMobility ();
+      if (m_maxRange > 0 && txMobility && receiverMobility
+          && txMobility->GetDistanceFrom (receiverMobility) > m_maxRange)
         {
-          NS_LOG_LOGIC (" converting txPowerSpectrum SpectrumModelUids" << txSpectrumModelUid << " --> " << rxSpectrumModelUid);
-          SpectrumConverterMap_t::const_iterator rxConverterIterator = txInfoIteratorerator->second.m_spectrumConverterMap.find (rxSpectrumModelUid);
-          NS_ASSERT (rxConverterIterator != txInfoIteratorerator->second.m_spectrumConverterMap.end ());
-          convertedTxPowerSpectrum = rxConverterIterator->second.Convert (txParams->psd);
+          // beyond range
+          continue;
         }
+      receivers.push_back (*it);
+      receiverMobilities.push_back (receiverMobility);
+    }
+  std::vector<double> propagationGainsDb;
+  std::vector<Ptr<MobilityModel> > lossMobilities;
+  if (m_propagationLoss && txMobility)
+    {
+      for (uint32_t i = 0; i < receiverMobilities.size (); i++)
+        {
+          if (receiverMobilities[i])
+            {
+              lossMobilities.push_back (receiverMobilities[i]);
+            }
+        }
+      propagationGainsDb.resize (lossMobilities.size (), 0.0);
+      m_propagationLoss->CalcRxPowers (txMobility, lossMobilities, propagationGainsDb);
+    }
+  uint32_t nextGain = 0;
 
+  SpectrumModelUid_t rxSpectrumModelUid = 0;
+  Ptr <SpectrumValue> convertedTxPowerSpectrum;
+  for (uint32_t i = 0; i < receivers.size (); i++)
+    {
+      Ptr<SpectrumPhy> rxPhy = receivers[i].phy;
+      if (convertedTxPowerSpectrum == 0 || receivers[i].uid != rxSpectrumModelUid)
+        {
+          rxSpectrumModelUid = receivers[i].uid;
+          NS_LOG_LOGIC (" rxSpectrumModelUids " << rxSpectrumModelUid);
+          if (txSpectrumModelUid == rxSpectrumModelUid)
+            {
+              NS_LOG_LOGIC ("no spectrum conversion needed");
+              convertedTxPowerSpectrum = txParams->psd;
+            }
+          else
+            {
+              NS_LOG_LOGIC (" converting txPowerSpectrum SpectrumModelUids" << txSpectrumModelUid << " --> " << rxSpectrumModelUid);
+              SpectrumConverterMap_t::const_iterator rxConverterIterator = txInfoIteratorerator->second.m_spectrumConverterMap.find (rxSpectrumModelUid);
+              NS_ASSERT (rxConverterIterator != txInfoIteratorerator->second.m_spectrumConverterMap.end ());
+              convertedTxPowerSpectrum = rxConverterIterator->second.Convert (txParams->psd);
+            }
+        }
+
+      NS_LOG_LOGIC (" copying signal parameters " << txParams);
+      Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
+      rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
+      Time delay = MicroSeconds (0);
+
+      Ptr<MobilityModel> receiverMobility = receiverMobilities[i];
 
-      for (std::set<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxInfoIterator->second.m_rxPhySet.begin ();
-           rxPhyIterator != rxInfoIterator->second.m_rxPhySet.end ();
-           ++rxPhyIterator)
+      if (txMobility && receiverMobility)
         {
-          NS_ASSERT_MSG ((*rxPhyIterator)->GetRxSpectrumModel ()->GetUid () == rxSpectrumModelUid,
-                         "SpectrumModel change was not notified to MultiModelSpectrumChannel (i.e., AddRx should be called again after model is changed)");
+          double pathLossDb = 0;
+          if (rxParams->txAntenna != 0)
+            {
+              Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
+              double txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
+              NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+              pathLossDb -= txAntennaGain;
+            }
+          Ptr<AntennaModel> rxAntenna = rxPhy->GetRxAntenna ();
+          if (rxAntenna != 0)
+            {
+              Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
+              double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
+              NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+              pathLossDb -= rxAntennaGain;
+            }
+          if (m_propagationLoss)
+            {
+              double propagationGainDb = propagationGainsDb[nextGain++];
+              NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+              pathLossDb -= propagationGainDb;
+            }
+          NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
+          m_pathLossTrace (txParams->txPhy, rxPhy, pathLossDb);
+          if ( pathLossDb > m_maxLossDb)
+            {
+              // beyond range
+              continue;
+            }
+          double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+          *(rxParams->psd) *= pathGainLinear;
 
-          if ((*rxPhyIterator) != txParams->txPhy)
+          if (m_spectrumPropagationLoss)
             {
-              NS_LOG_LOGIC (" copying signal parameters " << txParams);
-              Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
-              rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
-              Time delay = MicroSeconds (0);
+              rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
+            }
 
-              Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
+          if (m_propagationDelay)
+            {
+              delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
+            }
+        }
 
-              if (txMobility && receiverMobility)
-                {
-                  double pathLossDb = 0;
-                  if (rxParams->txAntenna != 0)
-                    {
-                      Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
-                      double txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
-                      NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-                      pathLossDb -= txAntennaGain;
-                    }
-                  Ptr<AntennaModel> rxAntenna = (*rxPhyIterator)->GetRxAntenna ();
-                  if (rxAntenna != 0)
-                    {
-                      Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
-                      double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-                      NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-                      pathLossDb -= rxAntennaGain;
-                    }
-                  if (m_propagationLoss)
-                    {
-                      double propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
-                      NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                      pathLossDb -= propagationGainDb;
-                    }                    
-                  NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
-                  m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
-                  if ( pathLossDb > m_maxLossDb)
-                    {
-                      // beyond range
-                      continue;
-                    }
-                  double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-                  *(rxParams->psd) *= pathGainLinear;              
-
-                  if (m_spectrumPropagationLoss)
-                    {
-                      rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
-                    }
-
-                  if (m_propagationDelay)
-                    {
-                      delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
-                    }
-                }
+      Ptr<NetDevice> netDev = rxPhy->GetDevice ();
+      if (netDev)
+        {
+          // the receiver has a NetDevice, so we expect that it is attached to a Node
+          uint32_t dstNode =  netDev->GetNode ()->GetId ();
+          Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
+                                          rxParams, rxPhy);
+        }
+      else
+        {
+          // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
+          Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
+                               rxParams, rxPhy);
+        }
+    }
+}
 
-              Ptr<NetDevice> netDev = (*rxPhyIterator)->GetDevice ();
-              if (netDev)
-                {
-                  // the receiver has a NetDevice, so we expect that it is attached to a Node
-                  uint32_t dstNode =  netDev->GetNode ()->GetId ();
-                  Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
-                                                  rxParams, *rxPhyIterator);
-                }
-              else
+void
+MultiModelSpectrumChannel::GetCandidates (Ptr<MobilityModel> txMobility, std::vector<RxCandidate> &candidates)
+{
+  NS_LOG_FUNCTION (this << txMobility);
+  if (m_grid.GetCellSize () != m_maxRange)
+    {
+      m_grid.SetCellSize (m_maxRange);
+    }
+  if (m_gridStale)
+    {
+      // AddRx may have moved receivers between SpectrumModels
+      m_rxOf.clear ();
+      m_unlocatedRx.clear ();
+      for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
+           rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
+           ++rxInfoIterator)
+        {
+          RxCandidate candidate;
+          candidate.uid = rxInfoIterator->first;
+          const std::vector<Ptr<SpectrumPhy> > &rxPhys = rxInfoIterator->second.m_rxPhys;
+          for (uint32_t i = 0; i < rxPhys.size (); i++)
+            {
+              candidate.rank = i;
+              candidate.phy = rxPhys[i];
+              Ptr<MobilityModel> mobility = rxPhys[i]->GetMobility ();
+              if (mobility == 0)
                 {
-                  // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
-                  Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
-                                       rxParams, *rxPhyIterator);
+                  m_unlocatedRx.push_back (candidate);
+                  continue;
                 }
+              uint32_t index = m_grid.Add (mobility);
+              m_rxOf.resize (m_grid.GetN ());
+              m_rxOf[index].push_back (candidate);
             }
         }
-
+      m_gridStale = false;
     }
-
+  std::vector<uint32_t> near;
+  m_grid.GetNear (txMobility->GetPosition (), m_maxRange, near);
+  for (std::vector<uint32_t>::const_iterator it = near.begin (); it != near.end (); ++it)
+    {
+      candidates.insert (candidates.end (), m_rxOf[*it].begin (), m_rxOf[*it].end ());
+    }
+  // the receivers without a mobility model get all the signals
+  candidates.insert (candidates.end (), m_unlocatedRx.begin (), m_unlocatedRx.end ());
+  // schedule in the same order as without the grid
+  std::sort (candidates.begin (), candidates.end ());
 }
 
 void
@@ -391,29 +504,20 @@ Ptr<NetDevice>
 MultiModelSpectrumChannel::GetDevice (uint32_t i) const
 {
   NS_ASSERT (i < m_numDevices);
-  // this method implementation is computationally intensive. This
-  // method would be faster if we actually used a std::vector for
-  // storing devices, which we don't due to the need to have fast 
-  // SpectrumModel conversions and to allow PHY devices to changea
-  // SpectrumModel at run time. Note that having this method slow is
-  // acceptable as it is not used much at run time (often not at all).
-  // On the other hand, having slow SpectrumModel conversion would be
-  // less acceptable. 
+  // the devices are grouped by SpectrumModel, to have fast
+  // SpectrumModel conversions and to allow PHY devices to change
+  // SpectrumModel at run time
   uint32_t j = 0;
   for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
        rxInfoIterator !=  m_rxSpectrumModelInfoMap.end ();
        ++rxInfoIterator)
     {
-      for (std::set<Ptr<SpectrumPhy> >::const_iterator phyIt = rxInfoIterator->second.m_rxPhySet.begin ();
-           phyIt != rxInfoIterator->second.m_rxPhySet.end ();
-           ++phyIt)        
+      const std::vector<Ptr<SpectrumPhy> > &rxPhys = rxInfoIterator->second.m_rxPhys;
+      if (i - j < rxPhys.size ())
         {
-          if (j == i)
-            {
-              return (*phyIt)->GetDevice ();
-            }
-          j++;
+          return rxPhys[i - j]->GetDevice ();
         }
+      j += rxPhys.size ();
     }
   NS_FATAL_ERROR ("m_numDevice > actual number of devices");
   return 0;
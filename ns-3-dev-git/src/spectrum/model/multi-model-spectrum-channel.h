@@ -27,8 +27,9 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
+#include <ns3/mobility-grid.h>
 #include <map>
-#include <set>
+#include <vector>
 
 namespace ns3 {
 
@@ -62,7 +63,7 @@ public:
   RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumModel);
 
   Ptr<const SpectrumModel> m_rxSpectrumModel;
-  std::set<Ptr<SpectrumPhy> > m_rxPhySet;
+  std::vector<Ptr<SpectrumPhy> > m_rxPhys;
 };
 
 typedef std::map<SpectrumModelUid_t, RxSpectrumModelInfo> RxSpectrumModelInfoMap_t;
@@ -77,6 +78,14 @@ typedef std::map<SpectrumModelUid_t, RxSpectrumModelInfo> RxSpectrumModelInfoMap
  * SpectrumPhy instances which can use
  * different spectrum models, i.e.,  different SpectrumModel. 
  *
+ * With a non-zero MaxRange attribute, the channel keeps the mobility
+ * models of the receivers in a MobilityGrid of MaxRange-wide cells, and
+ * StartTx considers only the receivers of the cells around the
+ * transmitter; the receivers further than MaxRange do not get the
+ * signal. The single-frequency propagation losses of all the receivers
+ * of a transmission are computed in one call to
+ * PropagationLossModel::CalcRxPowers.
+ *
  * \note It is allowed for a receiving SpectrumPhy to switch to a
  * different SpectrumModel during the simulation. The requirement
  * for this to work is that, after the SpectrumPhy switched its
@@ -132,6 +141,31 @@ private:
    */
   virtual void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
 
+  /** A receiver of a transmission */
+  struct RxCandidate
+  {
+    SpectrumModelUid_t uid;   //!< the uid of the RX SpectrumModel of the receiver
+    uint32_t rank;            //!< the rank of the receiver among those of its SpectrumModel
+    Ptr<SpectrumPhy> phy;     //!< the receiver
+
+    /**
+     * \param o another receiver
+     * \return whether this receiver comes first in m_rxSpectrumModelInfoMap
+     */
+    bool operator < (const RxCandidate &o) const
+    {
+      return uid < o.uid || (uid == o.uid && rank < o.rank);
+    }
+  };
+
+  /**
+   * Find the receivers which may be within MaxRange of a transmitter.
+   *
+   * \param txMobility the mobility model of the transmitter
+   * \param candidates the receivers, in the order of m_rxSpectrumModelInfoMap
+   */
+  void GetCandidates (Ptr<MobilityModel> txMobility, std::vector<RxCandidate> &candidates);
+
 
 
   /**
@@ -173,6 +207,12 @@ private:
 
   double m_maxLossDb;
 
+  double m_maxRange;              //!< distance beyond which the receivers are skipped (m), 0 to disable
+  MobilityGrid m_grid;            //!< the mobility models of the receivers
+  std::vector<std::vector<RxCandidate> > m_rxOf;  //!< the receivers moved by each model of the grid
+  std::vector<RxCandidate> m_unlocatedRx;         //!< the receivers without a mobility model
+  bool m_gridStale;               //!< receivers were added since m_rxOf was built
+
   /**
    * \deprecated The non-const \c Ptr<SpectrumPhy> argument
    * is deprecated and will be changed to \c Ptr<const SpectrumPhy>
@@ -33,6 +33,7 @@
 #include <ns3/propagation-delay-model.h>
 #include <ns3/antenna-model.h>
 #include <ns3/angles.h>
+#include <algorithm>
 
 
 #include "single-model-spectrum-channel.h"
@@ -45,6 +46,7 @@ NS_LOG_COMPONENT_DEFINE ("SingleModelSpectrumChannel");
 NS_OBJECT_ENSURE_REGISTERED (SingleModelSpectrumChannel);
 
 SingleModelSpectrumChannel::SingleModelSpectrumChannel ()
+  : m_nIndexed (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -58,6 +60,10 @@ SingleModelSpectrumChannel::DoDispose ()
   m_propagationDelay = 0;
   m_propagationLoss = 0;
   m_spectrumPropagationLoss = 0;
+  m_grid.Clear ();
+  m_rxOf.clear ();
+  m_unlocatedRx.clear ();
+  m_nIndexed = 0;
   SpectrumChannel::DoDispose ();
 }
 
@@ -83,6 +89,15 @@ SingleModelSpectrumChannel::GetTypeId (void)
                    DoubleValue (1.0e9),
                    MakeDoubleAccessor (&SingleModelSpectrumChannel::m_maxLossDb),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxRange",
+                   "The distance (m) beyond which transmissions are not "
+                   "passed to the receiving PHY. Like MaxLossDb, this is "
+                   "to be set beyond the interference range, and saves "
+                   "the computation of the losses of the receivers out of "
+                   "range. 0 passes transmissions at any distance.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&SingleModelSpectrumChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0.0))
     .AddTraceSource ("PathLoss",
                      "This trace is fired whenever a new path loss value "
                      "is calculated. The first and second parameters "
@@ -134,82 +149,163 @@ SingleModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
 
   Ptr<MobilityModel> senderMobility = txParams->txPhy->GetMobility ();
 
-  for (PhyList::const_iterator rxPhyIterator = m_phyList.begin ();
-       rxPhyIterator != m_phyList.end ();
-       ++rxPhyIterator)
+  std::vector<uint32_t> candidates;
+  if (m_maxRange > 0 && senderMobility)
     {
-      if ((*rxPhyIterator) != txParams->txPhy)
+      GetCandidates (senderMobility, candidates);
+    }
+  else
+    {
+      candidates.reserve (m_phyList.size ());
+      for (uint32_t i = 0; i < m_phyList.size (); i++)
         {
-          Time delay  = MicroSeconds (0);
-
-          Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
-          NS_LOG_LOGIC ("copying signal parameters " << txParams);
-          Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
+          candidates.push_back (i);
+        }
+    }
 
-          if (senderMobility && receiverMobility)
+  // the receivers in range, and their single-frequency propagation
+  // gains, computed in one pass
+  std::vector<Ptr<SpectrumPhy> > receivers;
+  std::vector<Ptr<MobilityModel> > receiverMobilities;
+  receivers.reserve (candidates.size ());
+  receiverMobilities.reserve (candidates.size ());
+  for (std::vector<uint32_t>::const_iterator it = candidates.begin (); it != candidates.end (); ++it)
+    {
+      Ptr<SpectrumPhy> rxPhy = m_phyList[*it];
+      if (rxPhy == txParams->txPhy)
+        {
+          continue;
+        }
+      Ptr<MobilityModel> receiverMobility = rxPhy->GetMobility ();
+      if (m_maxRange > 0 && senderMobility && receiverMobility
+          && senderMobility->GetDistanceFrom (receiverMobility) > m_maxRange)
+        {
+          // beyond range
+          continue;
+        }
+      receivers.push_back (rxPhy);
+      receiverMobilities.push_back (receiverMobility);
+    }
+  std::vector<double> propagationGainsDb;
+  std::vector<Ptr<MobilityModel> > lossMobilities;
+  if (m_propagationLoss && senderMobility)
+    {
+      for (uint32_t i = 0; i < receiverMobilities.size (); i++)
+        {
+          if (receiverMobilities[i])
             {
-              double pathLossDb = 0;
-              if (rxParams->txAntenna != 0)
-                {
-                  Angles txAngles (receiverMobility->GetPosition (), senderMobility->GetPosition ());
-                  double txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
-                  NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-                  pathLossDb -= txAntennaGain;
-                }
-              Ptr<AntennaModel> rxAntenna = (*rxPhyIterator)->GetRxAntenna ();
-              if (rxAntenna != 0)
-                {
-                  Angles rxAngles (senderMobility->GetPosition (), receiverMobility->GetPosition ());
-                  double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-                  NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-                  pathLossDb -= rxAntennaGain;
-                }
-              if (m_propagationLoss)
-                {
-                  double propagationGainDb = m_propagationLoss->CalcRxPower (0, senderMobility, receiverMobility);
-                  NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                  pathLossDb -= propagationGainDb;
-                }                    
-              NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
-              m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
-              if ( pathLossDb > m_maxLossDb)
-                {
-                  // beyond range
-                  continue;
-                }
-              double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-              *(rxParams->psd) *= pathGainLinear;              
-
-              if (m_spectrumPropagationLoss)
-                {
-                  rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, senderMobility, receiverMobility);
-                }
-
-              if (m_propagationDelay)
-                {
-                  delay = m_propagationDelay->GetDelay (senderMobility, receiverMobility);
-                }
+              lossMobilities.push_back (receiverMobilities[i]);
             }
+        }
+      propagationGainsDb.resize (lossMobilities.size (), 0.0);
+      m_propagationLoss->CalcRxPowers (senderMobility, lossMobilities, propagationGainsDb);
+    }
+  uint32_t nextGain = 0;
+
+  for (uint32_t i = 0; i < receivers.size (); i++)
+    {
+      Ptr<SpectrumPhy> rxPhy = receivers[i];
+      Time delay  = MicroSeconds (0);
 
+      Ptr<MobilityModel> receiverMobility = receiverMobilities[i];
+      NS_LOG_LOGIC ("copying signal parameters " << txParams);
+      Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
 
-          Ptr<NetDevice> netDev = (*rxPhyIterator)->GetDevice ();
-          if (netDev)
+      if (senderMobility && receiverMobility)
+        {
+          double pathLossDb = 0;
+          if (rxParams->txAntenna != 0)
+            {
+              Angles txAngles (receiverMobility->GetPosition (), senderMobility->GetPosition ());
+              double txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
+              NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+              pathLossDb -= txAntennaGain;
+            }
+          Ptr<AntennaModel> rxAntenna = rxPhy->GetRxAntenna ();
+          if (rxAntenna != 0)
             {
-              // the receiver has a NetDevice, so we expect that it is attached to a Node
-              uint32_t dstNode =  netDev->GetNode ()->GetId ();
-              Simulator::ScheduleWithContext (dstNode, delay, &SingleModelSpectrumChannel::StartRx, this, rxParams, *rxPhyIterator);
+              Angles rxAngles (senderMobility->GetPosition (), receiverMobility->GetPosition ());
+              double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
+              NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+              pathLossDb -= rxAntennaGain;
             }
-          else
+          if (m_propagationLoss)
             {
-              // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
-              Simulator::Schedule (delay, &SingleModelSpectrumChannel::StartRx, this,
-                                   rxParams, *rxPhyIterator);
+              double propagationGainDb = propagationGainsDb[nextGain++];
+              NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+              pathLossDb -= propagationGainDb;
             }
+          NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
+          m_pathLossTrace (txParams->txPhy, rxPhy, pathLossDb);
+          if ( pathLossDb > m_maxLossDb)
+            {
+              // beyond range
+              continue;
+            }
+          double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+          *(rxParams->psd) *= pathGainLinear;
+
+          if (m_spectrumPropagationLoss)
+            {
+              rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, senderMobility, receiverMobility);
+            }
+
+          if (m_propagationDelay)
+            {
+              delay = m_propagationDelay->GetDelay (senderMobility, receiverMobility);
+            }
+        }
+
+
+      Ptr<NetDevice> netDev = rxPhy->GetDevice ();
+      if (netDev)
+        {
+          // the receiver has a NetDevice, so we expect that it is attached to a Node
+          uint32_t dstNode =  netDev->GetNode ()->GetId ();
+          Simulator::ScheduleWithContext (dstNode, delay, &SingleModelSpectrumChannel::StartRx, this, rxParams, rxPhy);
+        }
+      else
+        {
+          // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
+          Simulator::Schedule (delay, &SingleModelSpectrumChannel::StartRx, this,
+                               rxParams, rxPhy);
         }
     }
 
 }
 
+void
+SingleModelSpectrumChannel::GetCandidates (Ptr<MobilityModel> txMobility, std::vector<uint32_t> &candidates)
+{
+  NS_LOG_FUNCTION (this << txMobility);
+  if (m_grid.GetCellSize () != m_maxRange)
+    {
+      m_grid.SetCellSize (m_maxRange);
+    }
+  for (; m_nIndexed < m_phyList.size (); m_nIndexed++)
+    {
+      Ptr<MobilityModel> mobility = m_phyList[m_nIndexed]->GetMobility ();
+      if (mobility == 0)
+        {
+          m_unlocatedRx.push_back (m_nIndexed);
+          continue;
+        }
+      uint32_t index = m_grid.Add (mobility);
+      m_rxOf.resize (m_grid.GetN ());
+      m_rxOf[index].push_back (m_nIndexed);
+    }
+  std::vector<uint32_t> near;
+  m_grid.GetNear (txMobility->GetPosition (), m_maxRange, near);
+  for (std::vector<uint32_t>::const_iterator it = near.begin (); it != near.end (); ++it)
+    {
+      candidates.insert (candidates.end (), m_rxOf[*it].begin (), m_rxOf[*it].end ());
+    }
+  // the receivers without a mobility model get all the signals
+  candidates.insert (candidates.end (), m_unlocatedRx.begin (), m_unlocatedRx.end ());
+  // schedule in the same order as without the grid
+  std::sort (candidates.begin (), candidates.end ());
+}
+
 void
 SingleModelSpectrumChannel::StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver)
 {
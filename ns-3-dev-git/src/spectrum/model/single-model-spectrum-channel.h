@@ -25,6 +25,7 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-model.h>
 #include <ns3/traced-callback.h>
+#include <ns3/mobility-grid.h>
 
 namespace ns3 {
 
@@ -36,6 +37,14 @@ namespace ns3 {
  * @brief SpectrumChannel implementation which handles a single spectrum model
  *
  * All SpectrumPhy layers attached to this SpectrumChannel
+ *
+ * With a non-zero MaxRange attribute, the channel keeps the mobility
+ * models of the receivers in a MobilityGrid of MaxRange-wide cells, and
+ * StartTx considers only the receivers of the cells around the
+ * transmitter; the receivers further than MaxRange do not get the
+ * signal. The single-frequency propagation losses of all the receivers
+ * of a transmission are computed in one call to
+ * PropagationLossModel::CalcRxPowers.
  */
 class SingleModelSpectrumChannel : public SpectrumChannel
 {
@@ -74,6 +83,14 @@ private:
    */
   void StartRx (Ptr<SpectrumSignalParameters> params, Ptr<SpectrumPhy> receiver);
 
+  /**
+   * Find the receivers which may be within MaxRange of a transmitter.
+   *
+   * \param txMobility the mobility model of the transmitter
+   * \param candidates the indices of the receivers in m_phyList, in increasing order
+   */
+  void GetCandidates (Ptr<MobilityModel> txMobility, std::vector<uint32_t> &candidates);
+
   /**
    * list of SpectrumPhy instances attached to
    * the channel
@@ -109,6 +126,12 @@ private:
 
   double m_maxLossDb;
 
+  double m_maxRange;              //!< distance beyond which the receivers are skipped (m), 0 to disable
+  MobilityGrid m_grid;            //!< the mobility models of the receivers
+  std::vector<std::vector<uint32_t> > m_rxOf;  //!< the receivers moved by each model of the grid
+  std::vector<uint32_t> m_unlocatedRx;         //!< the receivers without a mobility model
+  uint32_t m_nIndexed;            //!< number of receivers of m_phyList in the grid
+
   /**
    * \deprecated The non-const \c Ptr<SpectrumPhy> argument
    * is deprecated and will be changed to \c Ptr<const SpectrumPhy>
@@ -107,10 +107,16 @@ public:
   Bands::const_iterator End () const;
 
 private:
+  friend class SpectrumValue;
+
   Bands m_bands;         ///< actual definition of frequency bands
                          /// within this SpectrumModel
   SpectrumModelUid_t m_uid;        ///< unique id for a given set of frequencies
   static SpectrumModelUid_t m_uidCount;    ///< counter to assign m_uids
+  /// storage of the SpectrumValues of this model which were destroyed,
+  /// kept for the next ones to be created; unused while Multithreading
+  /// is enabled, since the models are shared by the threads
+  mutable std::vector<std::vector<double> > m_freeValues;
 };
 
 
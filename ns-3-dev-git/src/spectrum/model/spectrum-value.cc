@@ -22,20 +22,218 @@
 #include <ns3/spectrum-value.h>
 #include <ns3/math.h>
 #include <ns3/log.h>
+#include <ns3/multithreading.h>
+#include <algorithm>
+
+#if defined (__AVX__)
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("SpectrumValue");
 
+namespace {
+
+/// the largest number of storages kept by a SpectrumModel
+const size_t MAX_FREE_VALUES = 32;
+
+/*
+ * The elementwise operations are computed on packs of doubles when the
+ * compiler targets SSE2 (two doubles) or AVX (four doubles), and one
+ * double at a time for the remaining values. These instructions round
+ * as the scalar ones, so the results do not depend on the instruction
+ * set.
+ */
+#if defined (__AVX__)
+#define SPECTRUM_VALUE_PACK_SIZE 4
+typedef __m256d Pack;
+inline Pack PackLoad (const double *p) { return _mm256_loadu_pd (p); }
+inline void PackStore (double *p, Pack x) { _mm256_storeu_pd (p, x); }
+inline Pack PackSet (double x) { return _mm256_set1_pd (x); }
+inline Pack PackAdd (Pack x, Pack y) { return _mm256_add_pd (x, y); }
+inline Pack PackSub (Pack x, Pack y) { return _mm256_sub_pd (x, y); }
+inline Pack PackMul (Pack x, Pack y) { return _mm256_mul_pd (x, y); }
+inline Pack PackDiv (Pack x, Pack y) { return _mm256_div_pd (x, y); }
+#elif defined (__SSE2__)
+#define SPECTRUM_VALUE_PACK_SIZE 2
+typedef __m128d Pack;
+inline Pack PackLoad (const double *p) { return _mm_loadu_pd (p); }
+inline void PackStore (double *p, Pack x) { _mm_storeu_pd (p, x); }
+inline Pack PackSet (double x) { return _mm_set1_pd (x); }
+inline Pack PackAdd (Pack x, Pack y) { return _mm_add_pd (x, y); }
+inline Pack PackSub (Pack x, Pack y) { return _mm_sub_pd (x, y); }
+inline Pack PackMul (Pack x, Pack y) { return _mm_mul_pd (x, y); }
+inline Pack PackDiv (Pack x, Pack y) { return _mm_div_pd (x, y); }
+#endif
+
+struct AddOp
+{
+  static double Apply (double x, double y) { return x + y; }
+#ifdef SPECTRUM_VALUE_PACK_SIZE
+  static Pack Apply (Pack x, Pack y) { return PackAdd (x, y); }
+#endif
+};
+
+struct SubtractOp
+{
+  static double Apply (double x, double y) { return x - y; }
+#ifdef SPECTRUM_VALUE_PACK_SIZE
+  static Pack Apply (Pack x, Pack y) { return PackSub (x, y); }
+#endif
+};
+
+struct MultiplyOp
+{
+  static double Apply (double x, double y) { return x * y; }
+#ifdef SPECTRUM_VALUE_PACK_SIZE
+  static Pack Apply (Pack x, Pack y) { return PackMul (x, y); }
+#endif
+};
+
+struct DivideOp
+{
+  static double Apply (double x, double y) { return x / y; }
+#ifdef SPECTRUM_VALUE_PACK_SIZE
+  static Pack Apply (Pack x, Pack y) { return PackDiv (x, y); }
+#endif
+};
+
+/*
+ * r = x op y, value by value. r may be x or y.
+ */
+template <class Op>
+void
+Apply (Values &r, const Values &x, const Values &y)
+{
+  NS_ASSERT (x.size () == r.size () && y.size () == r.size ());
+  size_t n = r.size ();
+  if (n == 0)
+    {
+      return;
+    }
+  double *pr = &r[0];
+  const double *px = &x[0];
+  const double *py = &y[0];
+  size_t i = 0;
+#ifdef SPECTRUM_VALUE_PACK_SIZE
+  for (; i + SPECTRUM_VALUE_PACK_SIZE <= n; i += SPECTRUM_VALUE_PACK_SIZE)
+    {
+      PackStore (pr + i, Op::Apply (PackLoad (px + i), PackLoad (py + i)));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      pr[i] = Op::Apply (px[i], py[i]);
+    }
+}
+
+/*
+ * r = x op s, value by value. r may be x.
+ */
+template <class Op>
+void
+Apply (Values &r, const Values &x, double s)
+{
+  NS_ASSERT (x.size () == r.size ());
+  size_t n = r.size ();
+  if (n == 0)
+    {
+      return;
+    }
+  double *pr = &r[0];
+  const double *px = &x[0];
+  size_t i = 0;
+#ifdef SPECTRUM_VALUE_PACK_SIZE
+  Pack ps = PackSet (s);
+  for (; i + SPECTRUM_VALUE_PACK_SIZE <= n; i += SPECTRUM_VALUE_PACK_SIZE)
+    {
+      PackStore (pr + i, Op::Apply (PackLoad (px + i), ps));
+    }
+#endif
+  for (; i < n; i++)
+    {
+      pr[i] = Op::Apply (px[i], s);
+    }
+}
+
+} // anonymous namespace
+
 SpectrumValue::SpectrumValue ()
 {
 }
 
 SpectrumValue::SpectrumValue (Ptr<const SpectrumModel> sof)
-  : m_spectrumModel (sof),
-    m_values (sof->GetNumBands ())
+  : m_spectrumModel (sof)
+{
+  TakeStorage (sof->GetNumBands ());
+  std::fill (m_values.begin (), m_values.end (), 0.0);
+}
+
+SpectrumValue::SpectrumValue (const SpectrumValue& x)
+  : m_spectrumModel (x.m_spectrumModel)
+{
+  TakeStorage (x.m_values.size ());
+  std::copy (x.m_values.begin (), x.m_values.end (), m_values.begin ());
+}
+
+SpectrumValue::~SpectrumValue ()
+{
+  ReleaseStorage ();
+}
+
+SpectrumValue&
+SpectrumValue::operator= (const SpectrumValue& x)
+{
+  m_spectrumModel = x.m_spectrumModel;
+  m_values = x.m_values;
+  return *this;
+}
+
+void
+SpectrumValue::Alike (const SpectrumValue& x)
+{
+  NS_ASSERT (m_spectrumModel == 0 && m_values.empty ());
+  m_spectrumModel = x.m_spectrumModel;
+  TakeStorage (x.m_values.size ());
+}
+
+void
+SpectrumValue::TakeStorage (size_t n)
 {
+  // the models are shared by the threads of a multithreaded simulation,
+  // and their storage with them
+  if (m_spectrumModel != 0 && n == m_spectrumModel->GetNumBands ()
+      && !Multithreading::IsEnabled ()
+      && !m_spectrumModel->m_freeValues.empty ())
+    {
+      m_values.swap (m_spectrumModel->m_freeValues.back ());
+      m_spectrumModel->m_freeValues.pop_back ();
+    }
+  else
+    {
+      m_values.resize (n);
+    }
+}
 
+void
+SpectrumValue::ReleaseStorage ()
+{
+  if (m_spectrumModel == 0 || m_values.size () != m_spectrumModel->GetNumBands ()
+      || Multithreading::IsEnabled ())
+    {
+      return;
+    }
+  std::vector<Values> &freeValues = m_spectrumModel->m_freeValues;
+  if (freeValues.size () < MAX_FREE_VALUES)
+    {
+      // reserve first, so that the storages are never copied
+      freeValues.reserve (MAX_FREE_VALUES);
+      freeValues.push_back (Values ());
+      freeValues.back ().swap (m_values);
+    }
 }
 
 double&
@@ -106,31 +304,15 @@ SpectrumValue::ConstBandsEnd () const
 void
 SpectrumValue::Add (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 += *it2;
-      ++it1;
-      ++it2;
-    }
+  Apply<AddOp> (m_values, m_values, x.m_values);
 }
 
 
 void
 SpectrumValue::Add (double s)
 {
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
-    {
-      *it1 += s;
-      ++it1;
-    }
+  Apply<AddOp> (m_values, m_values, s);
 }
 
 
@@ -138,18 +320,8 @@ SpectrumValue::Add (double s)
 void
 SpectrumValue::Subtract (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 -= *it2;
-      ++it1;
-      ++it2;
-    }
+  Apply<SubtractOp> (m_values, m_values, x.m_values);
 }
 
 
@@ -164,31 +336,15 @@ SpectrumValue::Subtract (double s)
 void
 SpectrumValue::Multiply (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 *= *it2;
-      ++it1;
-      ++it2;
-    }
+  Apply<MultiplyOp> (m_values, m_values, x.m_values);
 }
 
 
 void
 SpectrumValue::Multiply (double s)
 {
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
-    {
-      *it1 *= s;
-      ++it1;
-    }
+  Apply<MultiplyOp> (m_values, m_values, s);
 }
 
 
@@ -197,18 +353,8 @@ SpectrumValue::Multiply (double s)
 void
 SpectrumValue::Divide (const SpectrumValue& x)
 {
-  Values::iterator it1 = m_values.begin ();
-  Values::const_iterator it2 = x.m_values.begin ();
-
   NS_ASSERT (m_spectrumModel == x.m_spectrumModel);
-
-  while (it1 != m_values.end ())
-    {
-      NS_ASSERT ( it2 != x.m_values.end ());
-      *it1 /= *it2;
-      ++it1;
-      ++it2;
-    }
+  Apply<DivideOp> (m_values, m_values, x.m_values);
 }
 
 
@@ -216,13 +362,7 @@ void
 SpectrumValue::Divide (double s)
 {
   NS_LOG_FUNCTION (this << s);
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
-    {
-      *it1 /= s;
-      ++it1;
-    }
+  Apply<DivideOp> (m_values, m_values, s);
 }
 
 
@@ -408,11 +548,7 @@ Integral (const SpectrumValue& arg)
 Ptr<SpectrumValue>
 SpectrumValue::Copy () const
 {
-  Ptr<SpectrumValue> p = Create<SpectrumValue> (m_spectrumModel);
-  *p = *this;
-  return p;
-
-  //  return Copy<SpectrumValue> (*this)
+  return Create<SpectrumValue> (*this);
 }
 
 
@@ -434,8 +570,10 @@ operator << (std::ostream& os, const SpectrumValue& pvf)
 SpectrumValue
 operator+ (const SpectrumValue& lhs, const SpectrumValue& rhs)
 {
-  SpectrumValue res = lhs;
-  res.Add (rhs);
+  NS_ASSERT (lhs.m_spectrumModel == rhs.m_spectrumModel);
+  SpectrumValue res;
+  res.Alike (lhs);
+  Apply<AddOp> (res.m_values, lhs.m_values, rhs.m_values);
   return res;
 }
 
@@ -443,8 +581,9 @@ operator+ (const SpectrumValue& lhs, const SpectrumValue& rhs)
 SpectrumValue
 operator+ (const SpectrumValue& lhs, double rhs)
 {
-  SpectrumValue res = lhs;
-  res.Add (rhs);
+  SpectrumValue res;
+  res.Alike (lhs);
+  Apply<AddOp> (res.m_values, lhs.m_values, rhs);
   return res;
 }
 
@@ -452,8 +591,9 @@ operator+ (const SpectrumValue& lhs, double rhs)
 SpectrumValue
 operator+ (double lhs, const SpectrumValue& rhs)
 {
-  SpectrumValue res = rhs;
-  res.Add (lhs);
+  SpectrumValue res;
+  res.Alike (rhs);
+  Apply<AddOp> (res.m_values, rhs.m_values, lhs);
   return res;
 }
 
@@ -461,9 +601,10 @@ operator+ (double lhs, const SpectrumValue& rhs)
 SpectrumValue
 operator- (const SpectrumValue& lhs, const SpectrumValue& rhs)
 {
-  SpectrumValue res = rhs;
-  res.ChangeSign ();
-  res.Add (lhs);
+  NS_ASSERT (lhs.m_spectrumModel == rhs.m_spectrumModel);
+  SpectrumValue res;
+  res.Alike (lhs);
+  Apply<SubtractOp> (res.m_values, lhs.m_values, rhs.m_values);
   return res;
 }
 
@@ -472,8 +613,9 @@ operator- (const SpectrumValue& lhs, const SpectrumValue& rhs)
 SpectrumValue
 operator- (const SpectrumValue& lhs, double rhs)
 {
-  SpectrumValue res = lhs;
-  res.Subtract (rhs);
+  SpectrumValue res;
+  res.Alike (lhs);
+  Apply<SubtractOp> (res.m_values, lhs.m_values, rhs);
   return res;
 }
 
@@ -481,16 +623,19 @@ operator- (const SpectrumValue& lhs, double rhs)
 SpectrumValue
 operator- (double lhs, const SpectrumValue& rhs)
 {
-  SpectrumValue res = rhs;
-  res.Subtract (lhs);
+  SpectrumValue res;
+  res.Alike (rhs);
+  Apply<SubtractOp> (res.m_values, rhs.m_values, lhs);
   return res;
 }
 
 SpectrumValue
 operator* (const SpectrumValue& lhs, const SpectrumValue& rhs)
 {
-  SpectrumValue res = lhs;
-  res.Multiply (rhs);
+  NS_ASSERT (lhs.m_spectrumModel == rhs.m_spectrumModel);
+  SpectrumValue res;
+  res.Alike (lhs);
+  Apply<MultiplyOp> (res.m_values, lhs.m_values, rhs.m_values);
   return res;
 }
 
@@ -498,8 +643,9 @@ operator* (const SpectrumValue& lhs, const SpectrumValue& rhs)
 SpectrumValue
 operator* (const SpectrumValue& lhs, double rhs)
 {
-  SpectrumValue res = lhs;
-  res.Multiply (rhs);
+  SpectrumValue res;
+  res.Alike (lhs);
+  Apply<MultiplyOp> (res.m_values, lhs.m_values, rhs);
   return res;
 }
 
@@ -507,8 +653,9 @@ operator* (const SpectrumValue& lhs, double rhs)
 SpectrumValue
 operator* (double lhs, const SpectrumValue& rhs)
 {
-  SpectrumValue res = rhs;
-  res.Multiply (lhs);
+  SpectrumValue res;
+  res.Alike (rhs);
+  Apply<MultiplyOp> (res.m_values, rhs.m_values, lhs);
   return res;
 }
 
@@ -516,8 +663,10 @@ operator* (double lhs, const SpectrumValue& rhs)
 SpectrumValue
 operator/ (const SpectrumValue& lhs, const SpectrumValue& rhs)
 {
-  SpectrumValue res = lhs;
-  res.Divide (rhs);
+  NS_ASSERT (lhs.m_spectrumModel == rhs.m_spectrumModel);
+  SpectrumValue res;
+  res.Alike (lhs);
+  Apply<DivideOp> (res.m_values, lhs.m_values, rhs.m_values);
   return res;
 }
 
@@ -525,8 +674,9 @@ operator/ (const SpectrumValue& lhs, const SpectrumValue& rhs)
 SpectrumValue
 operator/ (const SpectrumValue& lhs, double rhs)
 {
-  SpectrumValue res = lhs;
-  res.Divide (rhs);
+  SpectrumValue res;
+  res.Alike (lhs);
+  Apply<DivideOp> (res.m_values, lhs.m_values, rhs);
   return res;
 }
 
@@ -534,8 +684,9 @@ operator/ (const SpectrumValue& lhs, double rhs)
 SpectrumValue
 operator/ (double lhs, const SpectrumValue& rhs)
 {
-  SpectrumValue res = rhs;
-  res.Divide (lhs);
+  SpectrumValue res;
+  res.Alike (rhs);
+  Apply<DivideOp> (res.m_values, rhs.m_values, lhs);
   return res;
 }
 
@@ -658,13 +809,7 @@ SpectrumValue::operator/= (double rhs)
 SpectrumValue&
 SpectrumValue::operator= (double rhs)
 {
-  Values::iterator it1 = m_values.begin ();
-
-  while (it1 != m_values.end ())
-    {
-      *it1 = rhs;
-      ++it1;
-    }
+  std::fill (m_values.begin (), m_values.end (), rhs);
   return *this;
 }
 
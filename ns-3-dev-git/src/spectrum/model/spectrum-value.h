@@ -53,6 +53,12 @@ typedef std::vector<double> Values;
  * The intended use of this class is to represent frequency-dependent
  * things, such as power spectral densities, frequency-dependent
  * propagation losses, spectral masks, etc.
+ *
+ * The operations are computed with the SSE2 or AVX instructions when
+ * the compiler targets them, and the storage of the values is handed
+ * from the SpectrumValues which are destroyed to the new ones of the
+ * same SpectrumModel, which saves most of the memory allocations of the
+ * temporary values made by the operators.
  */
 class SpectrumValue : public SimpleRefCount<SpectrumValue>
 {
@@ -79,6 +85,23 @@ public:
 
   SpectrumValue ();
 
+  /**
+   * Copy constructor
+   *
+   * @param x the SpectrumValue to copy
+   */
+  SpectrumValue (const SpectrumValue& x);
+
+  ~SpectrumValue ();
+
+  /**
+   * Assignment operator
+   *
+   * @param x the SpectrumValue to copy
+   *
+   * @return a reference to this instance
+   */
+  SpectrumValue& operator= (const SpectrumValue& x);
 
   /**
    * Access value at given frequency index
@@ -532,6 +555,24 @@ private:
   void Log2 ();
   void Log ();
 
+  /**
+   * Give this instance the SpectrumModel of another one, and storage
+   * for as many values, which are left uninitialized
+   *
+   * @param x the other SpectrumValue
+   */
+  void Alike (const SpectrumValue& x);
+  /**
+   * Take storage for the values, from the SpectrumModel if it has some
+   *
+   * @param n the number of values
+   */
+  void TakeStorage (size_t n);
+  /**
+   * Give the storage of the values to the SpectrumModel
+   */
+  void ReleaseStorage ();
+
   Ptr<const SpectrumModel> m_spectrumModel;
 
 
@@ -0,0 +1,248 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/double.h>
+#include <ns3/object-factory.h>
+#include <ns3/spectrum-channel.h>
+#include <ns3/spectrum-phy.h>
+#include <ns3/spectrum-value.h>
+#include <ns3/spectrum-signal-parameters.h>
+#include <ns3/net-device.h>
+#include <ns3/antenna-model.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/propagation-delay-model.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/constant-velocity-mobility-model.h>
+#include <cmath>
+
+using namespace ns3;
+
+/**
+ * A SpectrumPhy which counts the signals it receives.
+ */
+class ChannelTestSpectrumPhy : public SpectrumPhy
+{
+public:
+  /**
+   * \param model the SpectrumModel of the PHY
+   */
+  ChannelTestSpectrumPhy (Ptr<const SpectrumModel> model)
+    : m_model (model),
+      m_arrivals (0),
+      m_expected (0),
+      m_lastPower (0)
+  {
+  }
+  virtual void SetDevice (Ptr<NetDevice> d)
+  {
+  }
+  virtual Ptr<NetDevice> GetDevice () const
+  {
+    return 0;
+  }
+  virtual void SetMobility (Ptr<MobilityModel> m)
+  {
+    m_mobility = m;
+  }
+  virtual Ptr<MobilityModel> GetMobility ()
+  {
+    return m_mobility;
+  }
+  virtual void SetChannel (Ptr<SpectrumChannel> c)
+  {
+  }
+  virtual Ptr<const SpectrumModel> GetRxSpectrumModel () const
+  {
+    return m_model;
+  }
+  virtual Ptr<AntennaModel> GetRxAntenna ()
+  {
+    return 0;
+  }
+  virtual void StartRx (Ptr<SpectrumSignalParameters> params)
+  {
+    m_arrivals++;
+    m_lastPower = Integral (*params->psd);
+  }
+
+  Ptr<const SpectrumModel> m_model;   //!< the SpectrumModel of the PHY
+  Ptr<MobilityModel> m_mobility;      //!< the mobility model of the PHY
+  uint32_t m_arrivals;                //!< number of signals received
+  uint32_t m_expected;                //!< number of signals the channel should deliver
+  double m_lastPower;                 //!< the power of the last signal received (W)
+};
+
+/**
+ * Check that a SpectrumChannel with a MaxRange delivers a signal exactly
+ * to the PHYs within range, with the losses of the PropagationLossModel,
+ * while the PHYs move.
+ */
+class SpectrumChannelRangeTestCase : public TestCase
+{
+public:
+  /**
+   * \param channelType the TypeId name of the channel
+   */
+  SpectrumChannelRangeTestCase (std::string channelType);
+private:
+  virtual void DoRun (void);
+  /**
+   * Add a PHY to the channel.
+   *
+   * \param model the SpectrumModel of the PHY
+   * \param mobility the mobility model of the PHY, or 0
+   */
+  void AddPhy (Ptr<const SpectrumModel> model, Ptr<MobilityModel> mobility);
+  /** Transmit from the first PHY, and count the PHYs which should receive */
+  void Transmit (void);
+  /** Check the power of the last signal received by the nearest PHY */
+  void CheckPower (void);
+
+  std::string m_channelType;                              //!< the TypeId name of the channel
+  Ptr<SpectrumChannel> m_channel;                         //!< the channel
+  Ptr<PropagationLossModel> m_loss;                       //!< the loss model of the channel
+  Ptr<SpectrumModel> m_model;                             //!< the SpectrumModel of the transmissions
+  std::vector<Ptr<ChannelTestSpectrumPhy> > m_phys;       //!< the PHYs
+};
+
+SpectrumChannelRangeTestCase::SpectrumChannelRangeTestCase (std::string channelType)
+  : TestCase ("Check the deliveries of a " + channelType + " with a MaxRange"),
+    m_channelType (channelType)
+{
+}
+
+void
+SpectrumChannelRangeTestCase::AddPhy (Ptr<const SpectrumModel> model, Ptr<MobilityModel> mobility)
+{
+  Ptr<ChannelTestSpectrumPhy> phy = CreateObject<ChannelTestSpectrumPhy> (model);
+  phy->SetMobility (mobility);
+  m_channel->AddRx (phy);
+  m_phys.push_back (phy);
+}
+
+void
+SpectrumChannelRangeTestCase::Transmit (void)
+{
+  Ptr<MobilityModel> sender = m_phys[0]->GetMobility ();
+  for (uint32_t i = 1; i < m_phys.size (); i++)
+    {
+      Ptr<MobilityModel> receiver = m_phys[i]->GetMobility ();
+      if (receiver == 0 || sender->GetDistanceFrom (receiver) <= 100)
+        {
+          m_phys[i]->m_expected++;
+        }
+    }
+  Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters> ();
+  params->psd = Create<SpectrumValue> (m_model);
+  (*params->psd) = 1e-9;
+  params->duration = MicroSeconds (100);
+  params->txPhy = m_phys[0];
+  m_channel->StartTx (params);
+  Simulator::Schedule (MicroSeconds (50), &SpectrumChannelRangeTestCase::CheckPower, this);
+}
+
+void
+SpectrumChannelRangeTestCase::CheckPower (void)
+{
+  double gainDb = m_loss->CalcRxPower (0, m_phys[0]->GetMobility (), m_phys[1]->GetMobility ());
+  SpectrumValue txPsd (m_model);
+  txPsd = 1e-9;
+  double expected = Integral (txPsd) * std::pow (10.0, gainDb / 10);
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_phys[1]->m_lastPower, expected, expected * 1e-9, "Wrong received power");
+}
+
+void
+SpectrumChannelRangeTestCase::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (m_channelType);
+  factory.Set ("MaxRange", DoubleValue (100));
+  m_channel = factory.Create<SpectrumChannel> ();
+  m_loss = CreateObject<LogDistancePropagationLossModel> ();
+  m_channel->AddPropagationLossModel (m_loss);
+  m_channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+
+  std::vector<double> freqs;
+  freqs.push_back (2.40e9);
+  freqs.push_back (2.41e9);
+  freqs.push_back (2.42e9);
+  m_model = Create<SpectrumModel> (freqs);
+
+  Ptr<ConstantPositionMobilityModel> sender = CreateObject<ConstantPositionMobilityModel> ();
+  sender->SetPosition (Vector (0, 0, 0));
+  AddPhy (m_model, sender);
+  Ptr<ConstantPositionMobilityModel> near = CreateObject<ConstantPositionMobilityModel> ();
+  near->SetPosition (Vector (30, 40, 0));
+  AddPhy (m_model, near);
+  Ptr<ConstantPositionMobilityModel> far = CreateObject<ConstantPositionMobilityModel> ();
+  far->SetPosition (Vector (-100, 1, 0));
+  AddPhy (m_model, far);
+  Ptr<ConstantVelocityMobilityModel> moving = CreateObject<ConstantVelocityMobilityModel> ();
+  moving->SetPosition (Vector (0, -400, 0));
+  moving->SetVelocity (Vector (0, 50, 0));
+  AddPhy (m_model, moving);
+  // without mobility, a PHY gets all the signals
+  AddPhy (m_model, 0);
+  if (m_channelType == "ns3::MultiModelSpectrumChannel")
+    {
+      // a PHY with another SpectrumModel, moving between cells
+      std::vector<double> otherFreqs;
+      otherFreqs.push_back (2.405e9);
+      otherFreqs.push_back (2.415e9);
+      Ptr<ConstantPositionMobilityModel> jumping = CreateObject<ConstantPositionMobilityModel> ();
+      jumping->SetPosition (Vector (500, 500, 0));
+      AddPhy (Create<SpectrumModel> (otherFreqs), jumping);
+      Simulator::Schedule (Seconds (3.05), &ConstantPositionMobilityModel::SetPosition, jumping, Vector (-50, 50, 0));
+      Simulator::Schedule (Seconds (6.05), &ConstantPositionMobilityModel::SetPosition, jumping, Vector (-500, 0, 0));
+    }
+
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      Simulator::Schedule (MilliSeconds (100 * i), &SpectrumChannelRangeTestCase::Transmit, this);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < m_phys.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_phys[i]->m_arrivals, m_phys[i]->m_expected, "Wrong deliveries to PHY " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_phys[1]->m_arrivals, 100, "The PHY in range missed signals");
+  NS_TEST_EXPECT_MSG_EQ (m_phys[2]->m_arrivals, 0, "The PHY out of range got signals");
+  m_channel->Dispose ();
+  m_channel = 0;
+  m_phys.clear ();
+}
+
+/**
+ * The test suite of the culling of the SpectrumChannels.
+ */
+class SpectrumChannelTestSuite : public TestSuite
+{
+public:
+  SpectrumChannelTestSuite ();
+};
+
+SpectrumChannelTestSuite::SpectrumChannelTestSuite ()
+  : TestSuite ("spectrum-channel", UNIT)
+{
+  AddTestCase (new SpectrumChannelRangeTestCase ("ns3::SingleModelSpectrumChannel"), TestCase::QUICK);
+  AddTestCase (new SpectrumChannelRangeTestCase ("ns3::MultiModelSpectrumChannel"), TestCase::QUICK);
+}
+
+static SpectrumChannelTestSuite g_spectrumChannelTestSuite;
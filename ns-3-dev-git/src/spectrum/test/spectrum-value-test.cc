@@ -23,6 +23,11 @@
 #include <ns3/spectrum-converter.h>
 #include <ns3/log.h>
 #include <ns3/test.h>
+#include <ns3/multithreading.h>
+#include <ns3/core-config.h>
+#ifdef HAVE_PTHREAD_H
+#include <ns3/system-thread.h>
+#endif /* HAVE_PTHREAD_H */
 #include <iostream>
 #include <cmath>
 
@@ -82,6 +87,170 @@ SpectrumValueTestCase::DoRun (void)
 
 
 
+/**
+ * Check the operators on values of all sizes, which are computed partly
+ * with vector instructions, and the reuse of the storage of the values.
+ */
+class SpectrumValueStorageTestCase : public TestCase
+{
+public:
+  SpectrumValueStorageTestCase ();
+  virtual ~SpectrumValueStorageTestCase ();
+  virtual void DoRun (void);
+};
+
+SpectrumValueStorageTestCase::SpectrumValueStorageTestCase ()
+  : TestCase ("Check the operators and the storage of SpectrumValues of all sizes")
+{
+}
+
+SpectrumValueStorageTestCase::~SpectrumValueStorageTestCase ()
+{
+}
+
+void
+SpectrumValueStorageTestCase::DoRun (void)
+{
+  for (uint32_t n = 2; n <= 11; n++)
+    {
+      std::vector<double> freqs;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          freqs.push_back (1e9 + i * 1e6);
+        }
+      Ptr<SpectrumModel> model = Create<SpectrumModel> (freqs);
+      SpectrumValue a (model);
+      SpectrumValue b (model);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          a[i] = 1.0 / (i + 3);
+          b[i] = 0.7 - i * 0.3;
+        }
+      double s = 1.1;
+
+      SpectrumValue sum = a + b;
+      SpectrumValue difference = a - b;
+      SpectrumValue product = a * b;
+      SpectrumValue quotient = a / b;
+      SpectrumValue scaled = a * s;
+      SpectrumValue shifted = s + a;
+      SpectrumValue inPlace = a;
+      inPlace /= b;
+      inPlace -= s;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (sum[i], a[i] + b[i], "Wrong sum at " << i << " of " << n);
+          NS_TEST_EXPECT_MSG_EQ (difference[i], a[i] - b[i], "Wrong difference at " << i << " of " << n);
+          NS_TEST_EXPECT_MSG_EQ (product[i], a[i] * b[i], "Wrong product at " << i << " of " << n);
+          NS_TEST_EXPECT_MSG_EQ (quotient[i], a[i] / b[i], "Wrong quotient at " << i << " of " << n);
+          NS_TEST_EXPECT_MSG_EQ (scaled[i], a[i] * s, "Wrong scaled value at " << i << " of " << n);
+          NS_TEST_EXPECT_MSG_EQ (shifted[i], a[i] + s, "Wrong shifted value at " << i << " of " << n);
+          NS_TEST_EXPECT_MSG_EQ (inPlace[i], a[i] / b[i] - s, "Wrong in-place result at " << i << " of " << n);
+        }
+
+      // the storage of destroyed values is given to new ones, which
+      // must still start at zero or at the values they copy
+      for (uint32_t k = 0; k < 100; k++)
+        {
+          Ptr<SpectrumValue> garbage = Create<SpectrumValue> (model);
+          *garbage = k + 1.0;
+        }
+      SpectrumValue fresh (model);
+      SpectrumValue copy (a);
+      Ptr<SpectrumValue> pointerCopy = a.Copy ();
+      for (uint32_t i = 0; i < n; i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (fresh[i], 0.0, "New value not zero at " << i << " of " << n);
+          NS_TEST_EXPECT_MSG_EQ (copy[i], a[i], "Wrong copy at " << i << " of " << n);
+          NS_TEST_EXPECT_MSG_EQ ((*pointerCopy)[i], a[i], "Wrong Copy () at " << i << " of " << n);
+        }
+      NS_TEST_EXPECT_MSG_EQ (copy.GetSpectrumModelUid (), model->GetUid (), "Wrong model of the copy");
+    }
+}
+
+#ifdef HAVE_PTHREAD_H
+/**
+ * Check that threads build values of the same model at once, as the
+ * threads of a multithreaded simulation do.
+ */
+class SpectrumValueThreadsTestCase : public TestCase
+{
+public:
+  SpectrumValueThreadsTestCase ();
+  virtual void DoRun (void);
+
+  /** The work of a thread. */
+  struct Job
+  {
+    Ptr<const SpectrumModel> model; //!< the model of the values
+    double value;                   //!< the value of the bands
+    bool ok;                        //!< false if a result was wrong
+  };
+  /**
+   * Build, compute and destroy values of a model.
+   * \param job the model and the value of the bands
+   */
+  static void BuildValues (Job *job);
+};
+
+SpectrumValueThreadsTestCase::SpectrumValueThreadsTestCase ()
+  : TestCase ("Check the SpectrumValues of a model built by several threads")
+{
+}
+
+void
+SpectrumValueThreadsTestCase::BuildValues (Job *job)
+{
+  for (uint32_t k = 0; k < 2000; k++)
+    {
+      SpectrumValue a (job->model);
+      a = job->value;
+      Ptr<SpectrumValue> b = Create<SpectrumValue> (job->model);
+      *b = 2.0;
+      SpectrumValue c = a * *b + a;
+      for (uint32_t i = 0; i < job->model->GetNumBands (); i++)
+        {
+          job->ok = job->ok && c[i] == 3 * job->value;
+        }
+    }
+}
+
+void
+SpectrumValueThreadsTestCase::DoRun (void)
+{
+  std::vector<double> freqs;
+  for (uint32_t i = 0; i < 16; i++)
+    {
+      freqs.push_back (1e9 + i * 1e6);
+    }
+  Ptr<const SpectrumModel> model = Create<SpectrumModel> (freqs);
+
+  // the reference count of the model is shared by the threads
+  Multithreading::Enable ();
+  const uint32_t nThreads = 2;
+  Job jobs[nThreads];
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      jobs[i].model = model;
+      jobs[i].value = i + 1.0;
+      jobs[i].ok = true;
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&SpectrumValueThreadsTestCase::BuildValues, &jobs[i])));
+      threads.back ()->Start ();
+    }
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      threads[i]->Join ();
+    }
+  Multithreading::Disable ();
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (jobs[i].ok, true, "Wrong value computed in thread " << i);
+    }
+}
+#endif /* HAVE_PTHREAD_H */
+
+
 class SpectrumValueTestSuite : public TestSuite
 {
 public:
@@ -241,6 +410,11 @@ SpectrumValueTestSuite::SpectrumValueTestSuite ()
   tv1rs3 = v1 >> 3;
   AddTestCase (new SpectrumValueTestCase (tv1rs3, v1rs3, "tv1rs3 = v1 >> 3"), TestCase::QUICK);
 
+  AddTestCase (new SpectrumValueStorageTestCase (), TestCase::QUICK);
+#ifdef HAVE_PTHREAD_H
+  AddTestCase (new SpectrumValueThreadsTestCase (), TestCase::QUICK);
+#endif /* HAVE_PTHREAD_H */
+
 
 }
 
@@ -18,6 +18,7 @@
  * Author: Benjamin Cizdziel <ben.cizdziel@gmail.com>
  */
 
+#include <sstream>
 #define private public //to make private method testable
 
 #include <ns3/test.h>
@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Network topology
+//
+//       n0 ----------- n1
+//            10 Mbps
+//             5 ms
+//
+// - Bulk TCP flows from n0 to n1, through the root queue disc installed
+//   on the device of n0 (FQ-CoDel by default).
+// - The byte queue limits of the device keep few bytes in the device
+//   queue, so that the packets wait in the queue disc.
+// - Prints the bytes received by each flow and the queue disc statistics.
+
+#include <iostream>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TrafficControlExample");
+
+int
+main (int argc, char *argv[])
+{
+  std::string queueDisc = "ns3::FqCoDelQueueDisc";
+  uint32_t nFlows = 4;
+  double duration = 5.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("queueDisc", "The type of the root queue disc", queueDisc);
+  cmd.AddValue ("nFlows", "The number of TCP flows", nFlows);
+  cmd.AddValue ("duration", "The duration of the simulation, in seconds", duration);
+  cmd.Parse (argc, argv);
+
+  NodeContainer nodes;
+  nodes.Create (2);
+
+  PointToPointHelper pointToPoint;
+  pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  pointToPoint.SetChannelAttribute ("Delay", StringValue ("5ms"));
+  NetDeviceContainer devices = pointToPoint.Install (nodes);
+
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  // the root queue disc of the bottleneck device
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc (queueDisc);
+  QueueDiscContainer qdiscs = tch.Install (devices.Get (0));
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+
+  ApplicationContainer sinkApps;
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      uint16_t port = 5000 + i;
+      BulkSendHelper source ("ns3::TcpSocketFactory",
+                             InetSocketAddress (interfaces.GetAddress (1), port));
+      source.Install (nodes.Get (0)).Start (Seconds (0.1 * i));
+
+      PacketSinkHelper sink ("ns3::TcpSocketFactory",
+                             InetSocketAddress (Ipv4Address::GetAny (), port));
+      sinkApps.Add (sink.Install (nodes.Get (1)));
+    }
+  sinkApps.Start (Seconds (0.0));
+
+  Simulator::Stop (Seconds (duration));
+  Simulator::Run ();
+
+  for (uint32_t i = 0; i < sinkApps.GetN (); i++)
+    {
+      Ptr<PacketSink> sink = DynamicCast<PacketSink> (sinkApps.Get (i));
+      std::cout << "Flow " << i << " received " << sink->GetTotalRx () << " bytes" << std::endl;
+    }
+  Ptr<QueueDisc> q = qdiscs.Get (0);
+  std::cout << "Queue disc: received " << q->GetTotalReceivedPackets ()
+            << " dropped " << q->GetTotalDroppedPackets ()
+            << " held " << q->GetNPackets () << std::endl;
+  Ptr<NetDeviceQueue> devQueue = devices.Get (0)->GetObject<NetDeviceQueue> ();
+  std::cout << "Byte queue limit: " << devQueue->GetQueueLimit () << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/node.h"
+#include "ns3/net-device-queue.h"
+#include "ns3/traffic-control-layer.h"
+#include "traffic-control-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TrafficControlHelper");
+
+TrafficControlHelper::TrafficControlHelper ()
+{
+  m_queueDiscFactory.SetTypeId ("ns3::FqCoDelQueueDisc");
+  m_deviceQueueFactory.SetTypeId ("ns3::NetDeviceQueue");
+}
+
+void
+TrafficControlHelper::SetRootQueueDisc (std::string type,
+                                        std::string n01, const AttributeValue& v01,
+                                        std::string n02, const AttributeValue& v02,
+                                        std::string n03, const AttributeValue& v03,
+                                        std::string n04, const AttributeValue& v04)
+{
+  m_queueDiscFactory = ObjectFactory ();
+  m_queueDiscFactory.SetTypeId (type);
+  m_queueDiscFactory.Set (n01, v01);
+  m_queueDiscFactory.Set (n02, v02);
+  m_queueDiscFactory.Set (n03, v03);
+  m_queueDiscFactory.Set (n04, v04);
+}
+
+void
+TrafficControlHelper::SetNetDeviceQueueAttribute (std::string name, const AttributeValue &value)
+{
+  m_deviceQueueFactory.Set (name, value);
+}
+
+QueueDiscContainer
+TrafficControlHelper::Install (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+
+  Ptr<TrafficControlLayer> tc = device->GetNode ()->GetObject<TrafficControlLayer> ();
+  NS_ABORT_MSG_IF (tc == 0, "The node of the device has no TrafficControlLayer; "
+                   "install the internet stack first");
+
+  if (device->GetObject<NetDeviceQueue> () == 0)
+    {
+      device->AggregateObject (m_deviceQueueFactory.Create<NetDeviceQueue> ());
+    }
+  Ptr<QueueDisc> qDisc = m_queueDiscFactory.Create<QueueDisc> ();
+  tc->SetRootQueueDiscOnDevice (device, qDisc);
+  return QueueDiscContainer (qDisc);
+}
+
+QueueDiscContainer
+TrafficControlHelper::Install (NetDeviceContainer c)
+{
+  QueueDiscContainer container;
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      container.Add (Install (*i));
+    }
+  return container;
+}
+
+void
+TrafficControlHelper::Uninstall (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  Ptr<TrafficControlLayer> tc = device->GetNode ()->GetObject<TrafficControlLayer> ();
+  NS_ABORT_MSG_IF (tc == 0, "The node of the device has no TrafficControlLayer");
+  tc->DeleteRootQueueDiscOnDevice (device);
+}
+
+void
+TrafficControlHelper::Uninstall (NetDeviceContainer c)
+{
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Uninstall (*i);
+    }
+}
+
+} // namespace ns3
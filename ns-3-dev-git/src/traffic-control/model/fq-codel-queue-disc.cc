@@ -0,0 +1,551 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "fq-codel-queue-disc.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FqCoDelQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (FqCoDelQueueDisc);
+
+namespace {
+
+/** Marks the end of a list of flows. */
+const uint32_t NO_FLOW = 0xffffffff;
+
+/**
+ * Number of bits discarded from the time representation of CoDel.
+ * The time is assumed to be in nanoseconds.
+ */
+const int CODEL_SHIFT = 10;
+/** Number of bits of the reciprocal inverse square root. */
+const int REC_INV_SQRT_BITS = 8 * sizeof (uint16_t);
+/** Shift of the reciprocal inverse square root. */
+const int REC_INV_SQRT_SHIFT = 32 - REC_INV_SQRT_BITS;
+
+/**
+ * Performs a reciprocal divide, similar to the
+ * Linux kernel reciprocal_divide function
+ * \param A numerator
+ * \param R reciprocal of the denominator B
+ * \return the value of A/B
+ */
+inline uint32_t
+ReciprocalDivide (uint32_t A, uint32_t R)
+{
+  return (uint32_t)(((uint64_t)A * R) >> 32);
+}
+
+/**
+ * \param t a time
+ * \return the time in CoDel time representation
+ */
+inline uint32_t
+Time2CoDel (Time t)
+{
+  return t.GetNanoSeconds () >> CODEL_SHIFT;
+}
+
+/**
+ * \param a a CoDel time
+ * \param b a CoDel time
+ * \return true if a is after b
+ */
+inline bool
+CoDelTimeAfter (uint32_t a, uint32_t b)
+{
+  return static_cast<int32_t> (a - b) > 0;
+}
+
+/**
+ * \param a a CoDel time
+ * \param b a CoDel time
+ * \return true if a is after or equal to b
+ */
+inline bool
+CoDelTimeAfterEq (uint32_t a, uint32_t b)
+{
+  return static_cast<int32_t> (a - b) >= 0;
+}
+
+/**
+ * \param a a CoDel time
+ * \param b a CoDel time
+ * \return true if a is before b
+ */
+inline bool
+CoDelTimeBefore (uint32_t a, uint32_t b)
+{
+  return static_cast<int32_t> (a - b) < 0;
+}
+
+} // unnamed namespace
+
+FqCoDelQueueDisc::Flow::Flow ()
+  : m_backlog (0),
+    m_deficit (0),
+    m_status (INACTIVE),
+    m_next (NO_FLOW),
+    m_dropping (false),
+    m_count (0),
+    m_lastCount (0),
+    m_recInvSqrt (~0U >> REC_INV_SQRT_SHIFT),
+    m_firstAboveTime (0),
+    m_dropNext (0)
+{
+}
+
+TypeId
+FqCoDelQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FqCoDelQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<FqCoDelQueueDisc> ()
+    .AddAttribute ("Interval",
+                   "The CoDel algorithm interval for each flow queue",
+                   StringValue ("100ms"),
+                   MakeTimeAccessor (&FqCoDelQueueDisc::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("Target",
+                   "The CoDel algorithm target queue delay for each flow queue",
+                   StringValue ("5ms"),
+                   MakeTimeAccessor (&FqCoDelQueueDisc::m_target),
+                   MakeTimeChecker ())
+    .AddAttribute ("PacketLimit",
+                   "The hard limit on the number of packets held by the queue disc",
+                   UintegerValue (10240),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_limit),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Flows",
+                   "The number of flow queues",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_nFlows),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Quantum",
+                   "The number of bytes served from a flow queue at each round",
+                   UintegerValue (1514),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_quantum),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MinBytes",
+                   "The CoDel algorithm minbytes parameter",
+                   UintegerValue (1500),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_minBytes),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DropBatchSize",
+                   "The maximum number of packets dropped from the fattest flow queue "
+                   "when the queue disc overflows",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_dropBatchSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Perturbation",
+                   "The salt mixed in the hash of the flows",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FqCoDelQueueDisc::m_perturbation),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("UseEcn",
+                   "Mark the ECN-capable packets instead of dropping them",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&FqCoDelQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CeThreshold",
+                   "The sojourn time above which the ECN-capable packets are marked (0 disables)",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&FqCoDelQueueDisc::m_ceThreshold),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+FqCoDelQueueDisc::FqCoDelQueueDisc ()
+  : m_nActiveFlows (0),
+    m_overlimitDrops (0),
+    m_codelDrops (0),
+    m_codelMarks (0),
+    m_ceThresholdMarks (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_newFlows.m_head = NO_FLOW;
+  m_newFlows.m_tail = NO_FLOW;
+  m_oldFlows.m_head = NO_FLOW;
+  m_oldFlows.m_tail = NO_FLOW;
+}
+
+FqCoDelQueueDisc::~FqCoDelQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FqCoDelQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_flows.clear ();
+  m_newFlows.m_head = NO_FLOW;
+  m_oldFlows.m_head = NO_FLOW;
+  m_nActiveFlows = 0;
+  QueueDisc::DoDispose ();
+}
+
+uint32_t
+FqCoDelQueueDisc::GetOverlimitDrops (void) const
+{
+  return m_overlimitDrops;
+}
+
+uint32_t
+FqCoDelQueueDisc::GetCoDelDrops (void) const
+{
+  return m_codelDrops;
+}
+
+uint32_t
+FqCoDelQueueDisc::GetCoDelMarks (void) const
+{
+  return m_codelMarks;
+}
+
+uint32_t
+FqCoDelQueueDisc::GetCeThresholdMarks (void) const
+{
+  return m_ceThresholdMarks;
+}
+
+uint32_t
+FqCoDelQueueDisc::GetNActiveFlows (void) const
+{
+  return m_nActiveFlows;
+}
+
+void
+FqCoDelQueueDisc::PushBack (FlowList &list, uint32_t index)
+{
+  m_flows[index].m_next = NO_FLOW;
+  if (list.m_head == NO_FLOW)
+    {
+      list.m_head = index;
+    }
+  else
+    {
+      m_flows[list.m_tail].m_next = index;
+    }
+  list.m_tail = index;
+}
+
+void
+FqCoDelQueueDisc::PopFront (FlowList &list)
+{
+  NS_ASSERT (list.m_head != NO_FLOW);
+  uint32_t index = list.m_head;
+  list.m_head = m_flows[index].m_next;
+  m_flows[index].m_next = NO_FLOW;
+}
+
+bool
+FqCoDelQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  if (m_flows.empty ())
+    {
+      m_flows.resize (m_nFlows);
+    }
+
+  uint32_t index = item->Hash (m_perturbation) % m_flows.size ();
+  Flow &flow = m_flows[index];
+  flow.m_items.push_back (item);
+  flow.m_backlog += item->GetSize ();
+  NS_LOG_LOGIC ("Item enqueued in flow " << index << ", backlog " << flow.m_backlog);
+
+  if (flow.m_status == INACTIVE)
+    {
+      flow.m_status = NEW_FLOW;
+      flow.m_deficit = m_quantum;
+      PushBack (m_newFlows, index);
+      m_nActiveFlows++;
+    }
+
+  if (GetNPackets () > m_limit)
+    {
+      FatFlowDrop ();
+    }
+  return true;
+}
+
+void
+FqCoDelQueueDisc::FatFlowDrop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t fattest = 0;
+  uint32_t maxBacklog = 0;
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      if (m_flows[i].m_backlog > maxBacklog)
+        {
+          maxBacklog = m_flows[i].m_backlog;
+          fattest = i;
+        }
+    }
+
+  // drop from the head, as in the Linux implementation, so that the
+  // sender learns about the congestion as soon as possible
+  Flow &flow = m_flows[fattest];
+  uint32_t threshold = maxBacklog / 2;
+  uint32_t dropped = 0;
+  uint32_t bytes = 0;
+  do
+    {
+      Ptr<QueueDiscItem> item = PopItem (flow);
+      bytes += item->GetSize ();
+      Drop (item);
+      m_overlimitDrops++;
+    }
+  while (++dropped < m_dropBatchSize && bytes < threshold);
+  NS_LOG_LOGIC ("Dropped " << dropped << " items from flow " << fattest);
+}
+
+Ptr<QueueDiscItem>
+FqCoDelQueueDisc::PopItem (Flow &flow)
+{
+  NS_ASSERT (!flow.m_items.empty ());
+  Ptr<QueueDiscItem> item = flow.m_items.front ();
+  flow.m_items.pop_front ();
+  flow.m_backlog -= item->GetSize ();
+  return item;
+}
+
+Ptr<QueueDiscItem>
+FqCoDelQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  while (true)
+    {
+      FlowList *list;
+      if (m_newFlows.m_head != NO_FLOW)
+        {
+          list = &m_newFlows;
+        }
+      else if (m_oldFlows.m_head != NO_FLOW)
+        {
+          list = &m_oldFlows;
+        }
+      else
+        {
+          NS_LOG_LOGIC ("Queue disc empty");
+          return 0;
+        }
+
+      uint32_t index = list->m_head;
+      Flow &flow = m_flows[index];
+
+      if (flow.m_deficit <= 0)
+        {
+          // the flow used its quantum: give it another one, and let the
+          // other flows go first
+          flow.m_deficit += m_quantum;
+          PopFront (*list);
+          flow.m_status = OLD_FLOW;
+          PushBack (m_oldFlows, index);
+          continue;
+        }
+
+      Ptr<QueueDiscItem> item = CoDelDequeue (flow);
+      if (item == 0)
+        {
+          // a new flow which empties goes to the old flows, so that a
+          // flow sending a packet now and then does not always get the
+          // precedence of the new flows
+          PopFront (*list);
+          if (list == &m_newFlows && m_oldFlows.m_head != NO_FLOW)
+            {
+              flow.m_status = OLD_FLOW;
+              PushBack (m_oldFlows, index);
+            }
+          else
+            {
+              flow.m_status = INACTIVE;
+              m_nActiveFlows--;
+            }
+          continue;
+        }
+
+      flow.m_deficit -= item->GetSize ();
+      return item;
+    }
+}
+
+void
+FqCoDelQueueDisc::NewtonStep (Flow &flow)
+{
+  uint32_t invsqrt = ((uint32_t) flow.m_recInvSqrt) << REC_INV_SQRT_SHIFT;
+  uint32_t invsqrt2 = ((uint64_t) invsqrt * invsqrt) >> 32;
+  uint64_t val = (3ll << 32) - ((uint64_t) flow.m_count * invsqrt2);
+
+  val >>= 2; /* avoid overflow */
+  val = (val * invsqrt) >> (32 - 2 + 1);
+  flow.m_recInvSqrt = val >> REC_INV_SQRT_SHIFT;
+}
+
+uint32_t
+FqCoDelQueueDisc::ControlLaw (const Flow &flow, uint32_t t) const
+{
+  return t + ReciprocalDivide (Time2CoDel (m_interval), flow.m_recInvSqrt << REC_INV_SQRT_SHIFT);
+}
+
+bool
+FqCoDelQueueDisc::OkToDrop (Flow &flow, Ptr<QueueDiscItem> item, uint32_t now)
+{
+  uint32_t sojournTime = Time2CoDel (Simulator::Now () - item->GetTimeStamp ());
+
+  // the bytes of the queue disc still count the item
+  if (CoDelTimeBefore (sojournTime, Time2CoDel (m_target))
+      || GetNBytes () - item->GetSize () < m_minBytes)
+    {
+      flow.m_firstAboveTime = 0;
+      return false;
+    }
+  bool okToDrop = false;
+  if (flow.m_firstAboveTime == 0)
+    {
+      flow.m_firstAboveTime = now + Time2CoDel (m_interval);
+    }
+  else if (CoDelTimeAfter (now, flow.m_firstAboveTime))
+    {
+      okToDrop = true;
+    }
+  return okToDrop;
+}
+
+Ptr<QueueDiscItem>
+FqCoDelQueueDisc::CoDelDequeue (Flow &flow)
+{
+  NS_LOG_FUNCTION (this);
+
+  //
+  // This is the dequeue of CoDelQueue, applied to a flow queue.
+  //
+  if (flow.m_items.empty ())
+    {
+      flow.m_dropping = false;
+      flow.m_firstAboveTime = 0;
+      return 0;
+    }
+  uint32_t now = Time2CoDel (Simulator::Now ());
+  Ptr<QueueDiscItem> item = PopItem (flow);
+  bool okToDrop = OkToDrop (flow, item, now);
+
+  if (flow.m_dropping)
+    {
+      if (!okToDrop)
+        {
+          // sojourn time fell below target: leave the dropping state
+          flow.m_dropping = false;
+        }
+      else
+        {
+          while (flow.m_dropping && CoDelTimeAfterEq (now, flow.m_dropNext))
+            {
+              ++flow.m_count;
+              NewtonStep (flow);
+              if (m_useEcn && item->Mark ())
+                {
+                  // the mark signals the congestion as the drop would
+                  NS_LOG_LOGIC ("CoDel marks " << item);
+                  m_codelMarks++;
+                  flow.m_dropNext = ControlLaw (flow, flow.m_dropNext);
+                  break;
+                }
+              NS_LOG_LOGIC ("CoDel drops " << item);
+              Drop (item);
+              m_codelDrops++;
+              if (flow.m_items.empty ())
+                {
+                  flow.m_dropping = false;
+                  return 0;
+                }
+              item = PopItem (flow);
+              if (!OkToDrop (flow, item, now))
+                {
+                  flow.m_dropping = false;
+                }
+              else
+                {
+                  flow.m_dropNext = ControlLaw (flow, flow.m_dropNext);
+                }
+            }
+        }
+    }
+  else if (okToDrop)
+    {
+      // drop (or mark) the first item and enter the dropping state
+      if (m_useEcn && item->Mark ())
+        {
+          NS_LOG_LOGIC ("CoDel marks " << item << " and enters the dropping state");
+          m_codelMarks++;
+          flow.m_dropping = true;
+        }
+      else
+        {
+          NS_LOG_LOGIC ("CoDel drops " << item << " and enters the dropping state");
+          Drop (item);
+          m_codelDrops++;
+          if (flow.m_items.empty ())
+            {
+              item = 0;
+            }
+          else
+            {
+              item = PopItem (flow);
+              OkToDrop (flow, item, now);
+              flow.m_dropping = true;
+            }
+        }
+      // if the drop rate which controlled the queue on the last cycle is
+      // recent, it is a good starting point to control it now
+      uint32_t delta = flow.m_count - flow.m_lastCount;
+      if (delta > 1 && CoDelTimeBefore (now - flow.m_dropNext, 16 * Time2CoDel (m_interval)))
+        {
+          flow.m_count = delta;
+          NewtonStep (flow);
+        }
+      else
+        {
+          flow.m_count = 1;
+          flow.m_recInvSqrt = ~0U >> REC_INV_SQRT_SHIFT;
+        }
+      flow.m_lastCount = flow.m_count;
+      flow.m_dropNext = ControlLaw (flow, now);
+    }
+
+  if (item != 0 && !m_ceThreshold.IsZero ()
+      && Simulator::Now () - item->GetTimeStamp () > m_ceThreshold
+      && item->Mark ())
+    {
+      NS_LOG_LOGIC ("Sojourn time above the CE threshold, marked " << item);
+      m_ceThresholdMarks++;
+    }
+  return item;
+}
+
+} // namespace ns3
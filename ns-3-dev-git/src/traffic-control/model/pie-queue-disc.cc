@@ -0,0 +1,295 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "pie-queue-disc.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PieQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (PieQueueDisc);
+
+TypeId
+PieQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PieQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<PieQueueDisc> ()
+    .AddAttribute ("MaxPackets",
+                   "The maximum number of packets held by the queue disc",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&PieQueueDisc::m_limit),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MeanPktSize",
+                   "The average size of the packets, in bytes",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&PieQueueDisc::m_meanPktSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("A",
+                   "The weight of the deviation of the queue delay from the reference, in Hz",
+                   DoubleValue (0.125),
+                   MakeDoubleAccessor (&PieQueueDisc::m_a),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("B",
+                   "The weight of the trend of the queue delay, in Hz",
+                   DoubleValue (1.25),
+                   MakeDoubleAccessor (&PieQueueDisc::m_b),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("Tupdate",
+                   "The interval between the updates of the drop probability",
+                   StringValue ("15ms"),
+                   MakeTimeAccessor (&PieQueueDisc::m_tUpdate),
+                   MakeTimeChecker ())
+    .AddAttribute ("QueueDelayReference",
+                   "The target queue delay",
+                   StringValue ("15ms"),
+                   MakeTimeAccessor (&PieQueueDisc::m_qDelayRef),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxBurstAllowance",
+                   "The time during which a burst is let through",
+                   StringValue ("150ms"),
+                   MakeTimeAccessor (&PieQueueDisc::m_maxBurst),
+                   MakeTimeChecker ())
+    .AddAttribute ("UseEcn",
+                   "Mark the ECN-capable packets instead of dropping them",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PieQueueDisc::m_useEcn),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MarkEcnThreshold",
+                   "The drop probability above which the ECN-capable packets are dropped",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&PieQueueDisc::m_markEcnTh),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+  return tid;
+}
+
+PieQueueDisc::PieQueueDisc ()
+  : m_backlog (0),
+    m_dropProb (0),
+    m_qDelayOld (Seconds (0)),
+    m_burstAllowance (Seconds (0)),
+    m_earlyDrops (0),
+    m_earlyMarks (0),
+    m_overlimitDrops (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_uv = CreateObject<UniformRandomVariable> ();
+}
+
+PieQueueDisc::~PieQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+PieQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_updateEvent.Cancel ();
+  m_items.clear ();
+  m_uv = 0;
+  QueueDisc::DoDispose ();
+}
+
+double
+PieQueueDisc::GetDropProbability (void) const
+{
+  return m_dropProb;
+}
+
+uint32_t
+PieQueueDisc::GetEarlyDrops (void) const
+{
+  return m_earlyDrops;
+}
+
+uint32_t
+PieQueueDisc::GetEarlyMarks (void) const
+{
+  return m_earlyMarks;
+}
+
+uint32_t
+PieQueueDisc::GetOverlimitDrops (void) const
+{
+  return m_overlimitDrops;
+}
+
+int64_t
+PieQueueDisc::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_uv->SetStream (stream);
+  return 1;
+}
+
+bool
+PieQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  if (!m_updateEvent.IsRunning ())
+    {
+      // the first item, or the first one since the timer stopped; the
+      // updates skipped meanwhile would have restored the burst allowance
+      if (m_burstAllowance.IsZero () && m_dropProb == 0)
+        {
+          m_burstAllowance = m_maxBurst;
+        }
+      m_updateEvent = Simulator::Schedule (m_tUpdate, &PieQueueDisc::CalculateP, this);
+    }
+
+  if (m_items.size () >= m_limit)
+    {
+      NS_LOG_LOGIC ("Queue disc full -- dropping item");
+      m_overlimitDrops++;
+      return false;
+    }
+  if (DropEarly ())
+    {
+      if (m_useEcn && m_dropProb <= m_markEcnTh && item->Mark ())
+        {
+          NS_LOG_LOGIC ("Early mark with probability " << m_dropProb);
+          m_earlyMarks++;
+        }
+      else
+        {
+          NS_LOG_LOGIC ("Early drop with probability " << m_dropProb);
+          m_earlyDrops++;
+          return false;
+        }
+    }
+
+  m_items.push_back (item);
+  m_backlog += item->GetSize ();
+  return true;
+}
+
+bool
+PieQueueDisc::DropEarly (void)
+{
+  if (m_burstAllowance.IsStrictlyPositive ())
+    {
+      return false;
+    }
+  // keep the queue disc work conserving while the delay is low
+  if ((m_qDelayOld < m_qDelayRef / 2 && m_dropProb < 0.2)
+      || m_backlog <= 2 * m_meanPktSize)
+    {
+      return false;
+    }
+  return m_uv->GetValue () < m_dropProb;
+}
+
+Ptr<QueueDiscItem>
+PieQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_items.empty ())
+    {
+      return 0;
+    }
+  Ptr<QueueDiscItem> item = m_items.front ();
+  m_items.pop_front ();
+  m_backlog -= item->GetSize ();
+  return item;
+}
+
+void
+PieQueueDisc::CalculateP (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time qDelay = Seconds (0);
+  if (!m_items.empty ())
+    {
+      qDelay = Simulator::Now () - m_items.front ()->GetTimeStamp ();
+    }
+
+  double p = m_a * (qDelay - m_qDelayRef).GetSeconds ()
+    + m_b * (qDelay - m_qDelayOld).GetSeconds ();
+
+  // scale the update to the current probability, so that it is
+  // not too aggressive while the probability is low
+  if (m_dropProb < 0.000001)
+    {
+      p /= 2048;
+    }
+  else if (m_dropProb < 0.00001)
+    {
+      p /= 512;
+    }
+  else if (m_dropProb < 0.0001)
+    {
+      p /= 128;
+    }
+  else if (m_dropProb < 0.001)
+    {
+      p /= 32;
+    }
+  else if (m_dropProb < 0.01)
+    {
+      p /= 8;
+    }
+  else if (m_dropProb < 0.1)
+    {
+      p /= 2;
+    }
+  else if (p > 0.02)
+    {
+      p = 0.02;
+    }
+  m_dropProb += p;
+
+  if (qDelay.IsZero () && m_qDelayOld.IsZero ())
+    {
+      // decay the probability when the congestion has gone away
+      m_dropProb *= 0.98;
+    }
+  else if (qDelay > MilliSeconds (250))
+    {
+      m_dropProb += 0.02;
+    }
+  m_dropProb = std::min (std::max (m_dropProb, 0.0), 1.0);
+
+  m_burstAllowance = std::max (m_burstAllowance - m_tUpdate, Seconds (0));
+  if (m_dropProb == 0 && qDelay < m_qDelayRef / 2 && m_qDelayOld < m_qDelayRef / 2)
+    {
+      m_burstAllowance = m_maxBurst;
+    }
+  m_qDelayOld = qDelay;
+  NS_LOG_LOGIC ("Queue delay " << qDelay.GetSeconds () << " drop probability " << m_dropProb);
+
+  if (m_items.empty () && m_dropProb == 0 && m_qDelayOld.IsZero ())
+    {
+      // the updates would not change anything until the next item
+      NS_LOG_LOGIC ("Update timer stopped");
+      return;
+    }
+  m_updateEvent = Simulator::Schedule (m_tUpdate, &PieQueueDisc::CalculateP, this);
+}
+
+} // namespace ns3
@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PIE_QUEUE_DISC_H
+#define PIE_QUEUE_DISC_H
+
+#include <list>
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
+#include "queue-disc.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ * \brief The Proportional Integral controller Enhanced queue disc
+ * (RFC 8033).
+ *
+ * Every Tupdate, the drop probability is updated from the deviation of
+ * the queue delay from QueueDelayReference and from its trend, and the
+ * items are dropped at random on arrival with that probability.  The
+ * queue delay is the sojourn time of the item at the head of the queue.
+ * No item is dropped during the first MaxBurstAllowance of a burst,
+ * while the delay is low, or while the queue holds less than two
+ * MeanPktSize.
+ *
+ * With UseEcn, the ECN-capable items chosen at random are marked with CE
+ * instead of being dropped, as long as the drop probability does not
+ * exceed MarkEcnThreshold (RFC 8033 sec. 5.1).
+ *
+ * The update timer only runs while it may change the state of the queue
+ * disc: it stops when the queue disc is empty and the drop probability
+ * has decayed to zero, and starts again with the next item.
+ */
+class PieQueueDisc : public QueueDisc
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  PieQueueDisc ();
+  virtual ~PieQueueDisc ();
+
+  /**
+   * \return the current drop probability
+   */
+  double GetDropProbability (void) const;
+  /**
+   * \return the number of items dropped at random
+   */
+  uint32_t GetEarlyDrops (void) const;
+  /**
+   * \return the number of items marked at random instead of being dropped
+   */
+  uint32_t GetEarlyMarks (void) const;
+  /**
+   * \return the number of items dropped because the queue disc was full
+   */
+  uint32_t GetOverlimitDrops (void) const;
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+
+  /**
+   * \return true if the item arriving must be dropped at random
+   */
+  bool DropEarly (void);
+  /**
+   * Update the drop probability, and schedule the next update.
+   */
+  void CalculateP (void);
+
+  uint32_t m_limit;          //!< most items held
+  uint32_t m_meanPktSize;    //!< average size of the packets, in bytes
+  double m_a;                //!< weight of the deviation from the reference delay
+  double m_b;                //!< weight of the trend of the delay
+  Time m_tUpdate;            //!< interval between the updates
+  Time m_qDelayRef;          //!< reference queue delay
+  Time m_maxBurst;           //!< time during which a burst is let through
+  bool m_useEcn;             //!< mark the ECN-capable items instead of dropping them
+  double m_markEcnTh;        //!< highest drop probability at which the items are marked
+
+  std::list<Ptr<QueueDiscItem> > m_items; //!< the items
+  uint32_t m_backlog;        //!< the bytes of the items
+  double m_dropProb;         //!< drop probability
+  Time m_qDelayOld;          //!< queue delay at the previous update
+  Time m_burstAllowance;     //!< burst time left
+  EventId m_updateEvent;     //!< the next update
+  Ptr<UniformRandomVariable> m_uv; //!< draws the random drops
+  uint32_t m_earlyDrops;     //!< items dropped at random
+  uint32_t m_earlyMarks;     //!< items marked at random
+  uint32_t m_overlimitDrops; //!< items dropped on overflow
+};
+
+} // namespace ns3
+
+#endif /* PIE_QUEUE_DISC_H */
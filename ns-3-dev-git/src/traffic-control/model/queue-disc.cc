@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/net-device.h"
+#include "ns3/net-device-queue.h"
+#include "queue-disc.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("QueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (QueueDisc);
+
+QueueDiscItem::QueueDiscItem (Ptr<Packet> p, const Address &addr, uint16_t protocol)
+  : m_packet (p),
+    m_address (addr),
+    m_protocol (protocol)
+{
+}
+
+QueueDiscItem::~QueueDiscItem ()
+{
+}
+
+Ptr<Packet>
+QueueDiscItem::GetPacket (void) const
+{
+  return m_packet;
+}
+
+Address
+QueueDiscItem::GetAddress (void) const
+{
+  return m_address;
+}
+
+uint16_t
+QueueDiscItem::GetProtocol (void) const
+{
+  return m_protocol;
+}
+
+uint32_t
+QueueDiscItem::GetSize (void) const
+{
+  return m_packet->GetSize ();
+}
+
+Time
+QueueDiscItem::GetTimeStamp (void) const
+{
+  return m_tstamp;
+}
+
+void
+QueueDiscItem::SetTimeStamp (Time t)
+{
+  m_tstamp = t;
+}
+
+uint32_t
+QueueDiscItem::Hash (uint32_t perturbation) const
+{
+  return 0;
+}
+
+bool
+QueueDiscItem::Mark (void)
+{
+  return false;
+}
+
+void
+QueueDiscItem::Print (std::ostream &os) const
+{
+  os << *m_packet << " Dst addr " << m_address << " proto " << m_protocol
+     << " txq " << m_tstamp.GetSeconds ();
+}
+
+std::ostream &
+operator << (std::ostream &os, const QueueDiscItem &item)
+{
+  item.Print (os);
+  return os;
+}
+
+TypeId
+QueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::QueueDisc")
+    .SetParent<Object> ()
+    .SetGroupName ("TrafficControl")
+    .AddTraceSource ("Enqueue", "Enqueue an item in the queue disc",
+                     MakeTraceSourceAccessor (&QueueDisc::m_traceEnqueue),
+                     "ns3::QueueDiscItem::TracedCallback")
+    .AddTraceSource ("Dequeue", "Dequeue an item from the queue disc",
+                     MakeTraceSourceAccessor (&QueueDisc::m_traceDequeue),
+                     "ns3::QueueDiscItem::TracedCallback")
+    .AddTraceSource ("Drop", "Drop an item from the queue disc",
+                     MakeTraceSourceAccessor (&QueueDisc::m_traceDrop),
+                     "ns3::QueueDiscItem::TracedCallback")
+  ;
+  return tid;
+}
+
+QueueDisc::QueueDisc ()
+  : m_nPackets (0),
+    m_nBytes (0),
+    m_nTotalReceivedPackets (0),
+    m_nTotalDroppedPackets (0),
+    m_nTotalDroppedBytes (0),
+    m_running (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+QueueDisc::~QueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+QueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_devQueue != 0)
+    {
+      m_devQueue->SetWakeCallback (MakeNullCallback<void> ());
+    }
+  m_devQueue = 0;
+  m_device = 0;
+  Object::DoDispose ();
+}
+
+void
+QueueDisc::SetNetDevice (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  m_device = device;
+  m_devQueue = device->GetObject<NetDeviceQueue> ();
+  if (m_devQueue == 0)
+    {
+      m_devQueue = CreateObject<NetDeviceQueue> ();
+      device->AggregateObject (m_devQueue);
+    }
+  m_devQueue->SetWakeCallback (MakeCallback (&QueueDisc::Run, this));
+}
+
+Ptr<NetDevice>
+QueueDisc::GetNetDevice (void) const
+{
+  return m_device;
+}
+
+bool
+QueueDisc::Enqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  item->SetTimeStamp (Simulator::Now ());
+  m_nTotalReceivedPackets++;
+  m_nPackets++;
+  m_nBytes += item->GetSize ();
+
+  if (!DoEnqueue (item))
+    {
+      NS_LOG_LOGIC ("Item refused " << item);
+      Drop (item);
+      return false;
+    }
+  m_traceEnqueue (item);
+  return true;
+}
+
+Ptr<QueueDiscItem>
+QueueDisc::Dequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Ptr<QueueDiscItem> item = DoDequeue ();
+  if (item != 0)
+    {
+      NS_ASSERT (m_nPackets > 0 && m_nBytes >= item->GetSize ());
+      m_nPackets--;
+      m_nBytes -= item->GetSize ();
+      m_traceDequeue (item);
+    }
+  return item;
+}
+
+void
+QueueDisc::Drop (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  NS_ASSERT (m_nPackets > 0 && m_nBytes >= item->GetSize ());
+  m_nPackets--;
+  m_nBytes -= item->GetSize ();
+  m_nTotalDroppedPackets++;
+  m_nTotalDroppedBytes += item->GetSize ();
+  m_traceDrop (item);
+}
+
+void
+QueueDisc::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT_MSG (m_device != 0, "The queue disc is not attached to a device");
+
+  //
+  // The device may wake its queue up while it takes a packet, which calls
+  // Run again; the loop below sends the packets of that call.
+  //
+  if (m_running)
+    {
+      return;
+    }
+  m_running = true;
+  while (!m_devQueue->IsStopped ())
+    {
+      Ptr<QueueDiscItem> item = Dequeue ();
+      if (item == 0)
+        {
+          break;
+        }
+      if (!m_device->Send (item->GetPacket (), item->GetAddress (), item->GetProtocol ()))
+        {
+          // the item already left the queue disc: only count the drop
+          NS_LOG_LOGIC ("Item refused by the device " << item);
+          m_nTotalDroppedPackets++;
+          m_nTotalDroppedBytes += item->GetSize ();
+          m_traceDrop (item);
+        }
+    }
+  m_running = false;
+}
+
+uint32_t
+QueueDisc::GetNPackets (void) const
+{
+  return m_nPackets;
+}
+
+uint32_t
+QueueDisc::GetNBytes (void) const
+{
+  return m_nBytes;
+}
+
+uint32_t
+QueueDisc::GetTotalReceivedPackets (void) const
+{
+  return m_nTotalReceivedPackets;
+}
+
+uint32_t
+QueueDisc::GetTotalDroppedPackets (void) const
+{
+  return m_nTotalDroppedPackets;
+}
+
+uint32_t
+QueueDisc::GetTotalDroppedBytes (void) const
+{
+  return m_nTotalDroppedBytes;
+}
+
+} // namespace ns3
@@ -0,0 +1,87 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRAFFIC_CONTROL_LAYER_H
+#define TRAFFIC_CONTROL_LAYER_H
+
+#include <vector>
+#include "ns3/object.h"
+#include "queue-disc.h"
+
+namespace ns3 {
+
+class NetDevice;
+
+/**
+ * \ingroup traffic-control
+ * \brief The traffic control layer of a node, between its network
+ * protocols and its devices.
+ *
+ * The layer is aggregated to the node.  The network protocols send their
+ * packets to a device through the layer, which enqueues them in the root
+ * queue disc installed on the device, if any, and runs the queue disc;
+ * without a queue disc, the packets go straight to the device.
+ */
+class TrafficControlLayer : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  TrafficControlLayer ();
+  virtual ~TrafficControlLayer ();
+
+  /**
+   * Install a root queue disc on a device of the node.
+   *
+   * \param device the device
+   * \param qDisc the queue disc
+   */
+  void SetRootQueueDiscOnDevice (Ptr<NetDevice> device, Ptr<QueueDisc> qDisc);
+  /**
+   * \param device a device of the node
+   * \return the root queue disc installed on the device, or 0
+   */
+  Ptr<QueueDisc> GetRootQueueDiscOnDevice (Ptr<NetDevice> device) const;
+  /**
+   * Remove the root queue disc installed on a device.  The packets it
+   * holds are lost.
+   *
+   * \param device the device
+   */
+  void DeleteRootQueueDiscOnDevice (Ptr<NetDevice> device);
+
+  /**
+   * Send an item to a device, through its root queue disc if any.
+   *
+   * \param device the device
+   * \param item the item
+   */
+  void Send (Ptr<NetDevice> device, Ptr<QueueDiscItem> item);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  std::vector<Ptr<QueueDisc> > m_rootQueueDiscs; //!< the root queue discs, by device index
+};
+
+} // namespace ns3
+
+#endif /* TRAFFIC_CONTROL_LAYER_H */
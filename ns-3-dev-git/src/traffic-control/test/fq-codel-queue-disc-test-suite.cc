@@ -0,0 +1,361 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
+#include "ns3/nstime.h"
+#include "ns3/fq-codel-queue-disc.h"
+
+using namespace ns3;
+
+/**
+ * An item whose flow is given, and which may be ECN-capable.
+ */
+class FqCoDelTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * \param size the size of the packet
+   * \param flow the hash of the flow
+   * \param ecnCapable whether the item can be marked
+   */
+  FqCoDelTestItem (uint32_t size, uint32_t flow, bool ecnCapable)
+    : QueueDiscItem (Create<Packet> (size), Address (), 0),
+      m_flow (flow),
+      m_ecnCapable (ecnCapable)
+  {
+  }
+  virtual uint32_t Hash (uint32_t perturbation) const
+  {
+    return m_flow;
+  }
+  virtual bool Mark (void)
+  {
+    return m_ecnCapable;
+  }
+private:
+  uint32_t m_flow;   //!< the hash of the flow
+  bool m_ecnCapable; //!< whether the item can be marked
+};
+
+/**
+ * \param q the queue disc
+ * \param size the size of the packet
+ * \param flow the hash of the flow
+ */
+static void
+EnqueueItem (Ptr<FqCoDelQueueDisc> q, uint32_t size, uint32_t flow)
+{
+  q->Enqueue (Create<FqCoDelTestItem> (size, flow, false));
+}
+
+/**
+ * \param q the queue disc
+ * \param size the size of the packet
+ * \param flow the hash of the flow
+ */
+static void
+EnqueueEcnItem (Ptr<FqCoDelQueueDisc> q, uint32_t size, uint32_t flow)
+{
+  q->Enqueue (Create<FqCoDelTestItem> (size, flow, true));
+}
+
+/**
+ * \param q the queue disc
+ * \return the flow of the next item, or -1 if the queue disc is empty
+ */
+static int32_t
+DequeueFlow (Ptr<FqCoDelQueueDisc> q)
+{
+  Ptr<QueueDiscItem> item = q->Dequeue ();
+  if (item == 0)
+    {
+      return -1;
+    }
+  return item->Hash (0);
+}
+
+/**
+ * Check that the flows are served in turn, the new flows first.
+ */
+class FqCoDelRoundRobinTestCase : public TestCase
+{
+public:
+  FqCoDelRoundRobinTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+FqCoDelRoundRobinTestCase::FqCoDelRoundRobinTestCase ()
+  : TestCase ("Check the deficit round robin of FQ-CoDel")
+{
+}
+
+void
+FqCoDelRoundRobinTestCase::DoRun (void)
+{
+  Ptr<FqCoDelQueueDisc> q = CreateObjectWithAttributes<FqCoDelQueueDisc> (
+      "Flows", UintegerValue (8),
+      "Quantum", UintegerValue (100));
+
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      EnqueueItem (q, 100, 1);
+    }
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      EnqueueItem (q, 100, 2);
+    }
+  NS_TEST_EXPECT_MSG_EQ (q->GetNPackets (), 10, "Wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (q->GetNActiveFlows (), 2, "Wrong number of flows");
+
+  int32_t flow;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      flow = DequeueFlow (q);
+      NS_TEST_EXPECT_MSG_EQ (flow, 1, "The flows are not served in turn");
+      flow = DequeueFlow (q);
+      NS_TEST_EXPECT_MSG_EQ (flow, 2, "The flows are not served in turn");
+    }
+
+  // a new flow goes before the old ones
+  EnqueueItem (q, 100, 3);
+  flow = DequeueFlow (q);
+  NS_TEST_EXPECT_MSG_EQ (flow, 3, "The new flow is not served first");
+
+  // a flow with larger packets gets fewer of them
+  EnqueueItem (q, 300, 4);
+  EnqueueItem (q, 300, 4);
+  uint32_t served[5] = { 0, 0, 0, 0, 0 };
+  while ((flow = DequeueFlow (q)) >= 0)
+    {
+      served[flow]++;
+      if (served[1] == 2)
+        {
+          break;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (served[4], 1, "The deficit of the flows is not kept");
+
+  while (DequeueFlow (q) >= 0)
+    {
+    }
+  NS_TEST_EXPECT_MSG_EQ (q->GetNPackets (), 0, "Items left in the queue disc");
+  NS_TEST_EXPECT_MSG_EQ (q->GetNBytes (), 0, "Bytes left in the queue disc");
+  NS_TEST_EXPECT_MSG_EQ (q->GetNActiveFlows (), 0, "Flows left active");
+  q->Dispose ();
+}
+
+/**
+ * Check that an overflow drops from the flow holding the most bytes.
+ */
+class FqCoDelOverflowTestCase : public TestCase
+{
+public:
+  FqCoDelOverflowTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+FqCoDelOverflowTestCase::FqCoDelOverflowTestCase ()
+  : TestCase ("Check the overflow drops of FQ-CoDel")
+{
+}
+
+void
+FqCoDelOverflowTestCase::DoRun (void)
+{
+  Ptr<FqCoDelQueueDisc> q = CreateObjectWithAttributes<FqCoDelQueueDisc> (
+      "Flows", UintegerValue (8),
+      "PacketLimit", UintegerValue (10));
+
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      EnqueueItem (q, 100, 1);
+    }
+  EnqueueItem (q, 100, 2);
+  EnqueueItem (q, 100, 2);
+  NS_TEST_EXPECT_MSG_EQ (q->GetOverlimitDrops (), 0, "Drops below the limit");
+
+  // the flow 1 loses half its bytes
+  EnqueueItem (q, 100, 2);
+  NS_TEST_EXPECT_MSG_EQ (q->GetOverlimitDrops (), 4, "Wrong number of overflow drops");
+  NS_TEST_EXPECT_MSG_EQ (q->GetTotalDroppedPackets (), 4, "Wrong number of drops");
+  NS_TEST_EXPECT_MSG_EQ (q->GetNPackets (), 7, "Wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (q->GetNBytes (), 700, "Wrong number of bytes");
+
+  uint32_t served[3] = { 0, 0, 0 };
+  int32_t flow;
+  while ((flow = DequeueFlow (q)) >= 0)
+    {
+      served[flow]++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (served[1], 4, "Wrong packets of the fat flow");
+  NS_TEST_EXPECT_MSG_EQ (served[2], 3, "Packets of the thin flow dropped");
+  q->Dispose ();
+}
+
+/**
+ * Check that CoDel drops from a flow whose packets wait too long, and
+ * not from a flow whose packets do not.
+ */
+class FqCoDelCoDelTestCase : public TestCase
+{
+public:
+  FqCoDelCoDelTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Dequeue an item every 10 ms while the queue disc holds items */
+  void Dequeue (void);
+  Ptr<FqCoDelQueueDisc> m_q; //!< the queue disc
+  uint32_t m_served[3];      //!< items dequeued from each flow
+};
+
+FqCoDelCoDelTestCase::FqCoDelCoDelTestCase ()
+  : TestCase ("Check the CoDel drops of FQ-CoDel")
+{
+}
+
+void
+FqCoDelCoDelTestCase::Dequeue (void)
+{
+  int32_t flow = DequeueFlow (m_q);
+  if (flow >= 0)
+    {
+      m_served[flow]++;
+      Simulator::Schedule (MilliSeconds (10), &FqCoDelCoDelTestCase::Dequeue, this);
+    }
+}
+
+void
+FqCoDelCoDelTestCase::DoRun (void)
+{
+  m_q = CreateObjectWithAttributes<FqCoDelQueueDisc> (
+      "Flows", UintegerValue (8),
+      "Quantum", UintegerValue (1000));
+  m_served[1] = 0;
+  m_served[2] = 0;
+
+  // flow 1 has a standing queue of 100 items; flow 2 sends an item
+  // every 50 ms, which goes first as a new flow and never waits for long
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      EnqueueItem (m_q, 1000, 1);
+    }
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::Schedule (MilliSeconds (50 * i + 7), &EnqueueItem, m_q, 1000, 2);
+    }
+  Simulator::Schedule (MilliSeconds (10), &FqCoDelCoDelTestCase::Dequeue, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_GT (m_q->GetCoDelDrops (), 0, "CoDel did not drop");
+  NS_TEST_EXPECT_MSG_EQ (m_served[1] + m_q->GetCoDelDrops (), 100, "Items of flow 1 lost");
+  NS_TEST_EXPECT_MSG_EQ (m_served[2], 10, "Items of the sparse flow dropped");
+  m_q->Dispose ();
+  m_q = 0;
+}
+
+/**
+ * Check that CoDel marks the ECN-capable items instead of dropping them,
+ * and that the items waiting longer than the CE threshold are marked.
+ */
+class FqCoDelEcnTestCase : public TestCase
+{
+public:
+  FqCoDelEcnTestCase ();
+private:
+  virtual void DoRun (void);
+  /** Dequeue an item every 10 ms while the queue disc holds items */
+  void Dequeue (void);
+  /**
+   * Serve a standing queue of 100 items of a flow
+   * \param useEcn whether CoDel marks instead of dropping
+   * \param ceThreshold the CE threshold
+   */
+  void Serve (bool useEcn, Time ceThreshold);
+  Ptr<FqCoDelQueueDisc> m_q; //!< the queue disc
+  uint32_t m_served;         //!< items dequeued
+};
+
+FqCoDelEcnTestCase::FqCoDelEcnTestCase ()
+  : TestCase ("Check the ECN marks of FQ-CoDel")
+{
+}
+
+void
+FqCoDelEcnTestCase::Dequeue (void)
+{
+  if (DequeueFlow (m_q) >= 0)
+    {
+      m_served++;
+      Simulator::Schedule (MilliSeconds (10), &FqCoDelEcnTestCase::Dequeue, this);
+    }
+}
+
+void
+FqCoDelEcnTestCase::Serve (bool useEcn, Time ceThreshold)
+{
+  m_q = CreateObjectWithAttributes<FqCoDelQueueDisc> (
+      "Flows", UintegerValue (8),
+      "UseEcn", BooleanValue (useEcn),
+      "CeThreshold", TimeValue (ceThreshold));
+  m_served = 0;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      EnqueueEcnItem (m_q, 1000, 1);
+    }
+  Simulator::Schedule (MilliSeconds (10), &FqCoDelEcnTestCase::Dequeue, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+void
+FqCoDelEcnTestCase::DoRun (void)
+{
+  Serve (true, Seconds (0));
+  NS_TEST_EXPECT_MSG_GT (m_q->GetCoDelMarks (), 0, "CoDel did not mark");
+  NS_TEST_EXPECT_MSG_EQ (m_q->GetCoDelDrops (), 0, "CoDel dropped ECN-capable items");
+  NS_TEST_EXPECT_MSG_EQ (m_q->GetCeThresholdMarks (), 0, "Marks without a CE threshold");
+  NS_TEST_EXPECT_MSG_EQ (m_served, 100, "Items lost");
+  m_q->Dispose ();
+
+  // every item but the first one waits more than 10 ms
+  Serve (false, MilliSeconds (10));
+  NS_TEST_EXPECT_MSG_EQ (m_q->GetCeThresholdMarks (), m_served - 1,
+                         "Wrong number of CE threshold marks");
+  NS_TEST_EXPECT_MSG_EQ (m_q->GetCoDelMarks (), 0, "CoDel marked without ECN");
+  m_q->Dispose ();
+  m_q = 0;
+}
+
+/** The FQ-CoDel test suite. */
+static class FqCoDelQueueDiscTestSuite : public TestSuite
+{
+public:
+  FqCoDelQueueDiscTestSuite ()
+    : TestSuite ("fq-codel-queue-disc", UNIT)
+  {
+    AddTestCase (new FqCoDelRoundRobinTestCase (), TestCase::QUICK);
+    AddTestCase (new FqCoDelOverflowTestCase (), TestCase::QUICK);
+    AddTestCase (new FqCoDelCoDelTestCase (), TestCase::QUICK);
+    AddTestCase (new FqCoDelEcnTestCase (), TestCase::QUICK);
+  }
+} g_fqCoDelQueueDiscTestSuite;
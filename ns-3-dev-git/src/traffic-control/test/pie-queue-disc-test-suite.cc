@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/pie-queue-disc.h"
+
+using namespace ns3;
+
+/**
+ * \param size the size of the packet
+ * \return an item
+ */
+static Ptr<QueueDiscItem>
+CreateItem (uint32_t size)
+{
+  return Create<QueueDiscItem> (Create<Packet> (size), Address (), 0);
+}
+
+/**
+ * An item which can be marked.
+ */
+class PieEcnTestItem : public QueueDiscItem
+{
+public:
+  /**
+   * \param size the size of the packet
+   */
+  PieEcnTestItem (uint32_t size)
+    : QueueDiscItem (Create<Packet> (size), Address (), 0)
+  {
+  }
+  virtual bool Mark (void)
+  {
+    return true;
+  }
+};
+
+/**
+ * Check that PIE drops the items arriving when it is full.
+ */
+class PieOverflowTestCase : public TestCase
+{
+public:
+  PieOverflowTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+PieOverflowTestCase::PieOverflowTestCase ()
+  : TestCase ("Check the overflow drops of PIE")
+{
+}
+
+void
+PieOverflowTestCase::DoRun (void)
+{
+  Ptr<PieQueueDisc> q = CreateObjectWithAttributes<PieQueueDisc> (
+      "MaxPackets", UintegerValue (5));
+
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (q->Enqueue (CreateItem (1000)), true, "Item refused below the limit");
+    }
+  NS_TEST_EXPECT_MSG_EQ (q->Enqueue (CreateItem (1000)), false, "Item accepted above the limit");
+  NS_TEST_EXPECT_MSG_EQ (q->GetNPackets (), 5, "Wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (q->GetNBytes (), 5000, "Wrong number of bytes");
+  NS_TEST_EXPECT_MSG_EQ (q->GetOverlimitDrops (), 1, "Wrong number of overflow drops");
+  NS_TEST_EXPECT_MSG_EQ (q->GetTotalDroppedPackets (), 1, "Wrong number of drops");
+  while (q->Dequeue () != 0)
+    {
+    }
+  NS_TEST_EXPECT_MSG_EQ (q->GetNBytes (), 0, "Bytes left in the queue disc");
+  Simulator::Destroy ();
+  q->Dispose ();
+}
+
+/**
+ * Check that PIE drops at random the items of a link which is too slow
+ * for them, that it keeps the queue delay near its reference, and that
+ * it stops its timer once the traffic is gone.
+ */
+class PieControlTestCase : public TestCase
+{
+public:
+  /**
+   * \param useEcn whether the items are ECN-capable and PIE marks them
+   */
+  PieControlTestCase (bool useEcn);
+private:
+  virtual void DoRun (void);
+  /** Enqueue an item every millisecond until the arrivals stop */
+  void Arrive (void);
+  /** Dequeue an item every two milliseconds while there are items */
+  void Depart (void);
+
+  Ptr<PieQueueDisc> m_q;  //!< the queue disc
+  Time m_stop;            //!< end of the arrivals
+  bool m_departing;       //!< Depart is scheduled
+  uint32_t m_maxPackets;  //!< most items held after the first second
+  bool m_useEcn;          //!< the items are ECN-capable
+};
+
+PieControlTestCase::PieControlTestCase (bool useEcn)
+  : TestCase (useEcn ? "Check the early marks of PIE" : "Check the early drops of PIE"),
+    m_departing (false),
+    m_maxPackets (0),
+    m_useEcn (useEcn)
+{
+}
+
+void
+PieControlTestCase::Arrive (void)
+{
+  if (m_useEcn)
+    {
+      m_q->Enqueue (Create<PieEcnTestItem> (1000));
+    }
+  else
+    {
+      m_q->Enqueue (CreateItem (1000));
+    }
+  if (!m_departing)
+    {
+      m_departing = true;
+      Simulator::Schedule (MilliSeconds (2), &PieControlTestCase::Depart, this);
+    }
+  if (Simulator::Now () > Seconds (1))
+    {
+      m_maxPackets = std::max (m_maxPackets, m_q->GetNPackets ());
+    }
+  if (Simulator::Now () < m_stop)
+    {
+      Simulator::Schedule (MilliSeconds (1), &PieControlTestCase::Arrive, this);
+    }
+}
+
+void
+PieControlTestCase::Depart (void)
+{
+  m_q->Dequeue ();
+  if (m_q->GetNPackets () > 0)
+    {
+      Simulator::Schedule (MilliSeconds (2), &PieControlTestCase::Depart, this);
+    }
+  else
+    {
+      m_departing = false;
+    }
+}
+
+void
+PieControlTestCase::DoRun (void)
+{
+  m_q = CreateObjectWithAttributes<PieQueueDisc> (
+      "UseEcn", BooleanValue (m_useEcn));
+  m_q->AssignStreams (1);
+  m_stop = Seconds (5);
+  Simulator::ScheduleNow (&PieControlTestCase::Arrive, this);
+  // the simulation ends only if the update timer stops
+  Simulator::Run ();
+
+  if (m_useEcn)
+    {
+      // the arrivals do not slow down on the marks: once the probability
+      // is above the threshold of the marks, PIE drops to control the delay
+      NS_TEST_EXPECT_MSG_GT (m_q->GetEarlyMarks (), 0, "No early mark");
+      NS_TEST_EXPECT_MSG_GT (m_q->GetEarlyDrops (), 0, "No early drop above the threshold");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_GT (m_q->GetEarlyDrops (), 0, "No early drop");
+      NS_TEST_EXPECT_MSG_EQ (m_q->GetEarlyMarks (), 0, "Items marked without ECN");
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_q->GetOverlimitDrops (), 0, "The queue disc overflowed");
+  // a delay of 15 ms is 7.5 items; allow for the oscillations
+  NS_TEST_EXPECT_MSG_LT (m_maxPackets, 100, "The queue delay is not controlled");
+  NS_TEST_EXPECT_MSG_EQ (m_q->GetNPackets (), 0, "Items left in the queue disc");
+  NS_TEST_EXPECT_MSG_EQ (m_q->GetDropProbability (), 0, "The drop probability did not decay");
+
+  Simulator::Destroy ();
+  m_q->Dispose ();
+  m_q = 0;
+}
+
+/** The PIE test suite. */
+static class PieQueueDiscTestSuite : public TestSuite
+{
+public:
+  PieQueueDiscTestSuite ()
+    : TestSuite ("pie-queue-disc", UNIT)
+  {
+    AddTestCase (new PieOverflowTestCase (), TestCase::QUICK);
+    AddTestCase (new PieControlTestCase (false), TestCase::QUICK);
+    AddTestCase (new PieControlTestCase (true), TestCase::QUICK);
+  }
+} g_pieQueueDiscTestSuite;
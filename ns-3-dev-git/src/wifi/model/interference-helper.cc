@@ -104,9 +104,10 @@ InterferenceHelper::Event::GetPreambleType (void) const
  *       short period of time.
  ****************************************************************/
 
-InterferenceHelper::NiChange::NiChange (Time time, double delta)
+InterferenceHelper::NiChange::NiChange (Time time, double power, Time signalEnd)
   : m_time (time),
-    m_delta (delta)
+    m_power (power),
+    m_signalEnd (signalEnd)
 {
 }
 
@@ -117,9 +118,21 @@ InterferenceHelper::NiChange::GetTime (void) const
 }
 
 double
-InterferenceHelper::NiChange::GetDelta (void) const
+InterferenceHelper::NiChange::GetPower (void) const
 {
-  return m_delta;
+  return m_power;
+}
+
+void
+InterferenceHelper::NiChange::AddPower (double power)
+{
+  m_power += power;
+}
+
+Time
+InterferenceHelper::NiChange::GetSignalEnd (void) const
+{
+  return m_signalEnd;
 }
 
 bool
@@ -135,7 +148,6 @@ InterferenceHelper::NiChange::operator < (const InterferenceHelper::NiChange& o)
 
 InterferenceHelper::InterferenceHelper ()
   : m_errorRateModel (0),
-    m_firstPower (0.0),
     m_rxing (false)
 {
 }
@@ -191,45 +203,57 @@ Time
 InterferenceHelper::GetEnergyDuration (double energyW)
 {
   Time now = Simulator::Now ();
-  double noiseInterferenceW = 0.0;
-  Time end = now;
-  noiseInterferenceW = m_firstPower;
-  for (NiChanges::const_iterator i = m_niChanges.begin (); i != m_niChanges.end (); i++)
+  const NiChanges &changes = m_niChanges;
+  NiChanges::const_iterator last = changes.end ();
+  NiChanges::const_iterator i = std::lower_bound (changes.begin (), last, NiChange (now, 0.0, now));
+  NiChanges::const_iterator later = std::upper_bound (i, last, NiChange (now, 0.0, now));
+  while (i != later && i->GetPower () >= energyW)
+    {
+      i++;
+    }
+  if (i == later)
     {
-      noiseInterferenceW += i->GetDelta ();
-      end = i->GetTime ();
-      if (end < now)
+      //the changes after now only end signals, so the power decreases
+      //from one to the next: bisect them
+      NiChanges::const_iterator high = last;
+      while (i != high)
         {
-          continue;
+          NiChanges::const_iterator middle = i + (high - i) / 2;
+          if (middle->GetPower () >= energyW)
+            {
+              i = middle + 1;
+            }
+          else
+            {
+              high = middle;
+            }
         }
-      if (noiseInterferenceW < energyW)
+    }
+  if (i == last)
+    {
+      if (changes.empty ())
         {
-          break;
+          return MicroSeconds (0);
         }
+      i--;
     }
+  Time end = i->GetTime ();
   return end > now ? end - now : MicroSeconds (0);
 }
 
 void
 InterferenceHelper::AppendEvent (Ptr<InterferenceHelper::Event> event)
 {
-  Time now = Simulator::Now ();
-  if (!m_rxing)
+  NS_LOG_FUNCTION (this << event);
+  EraseExpiredChanges ();
+  //the insertions invalidate the iterators of the deque, so keep an index
+  NiChanges::iterator first = AddNiChangeEvent (event->GetStartTime (), event);
+  NiChanges::difference_type start = first - m_niChanges.begin ();
+  NiChanges::iterator end = AddNiChangeEvent (event->GetEndTime (), event);
+  for (NiChanges::iterator i = m_niChanges.begin () + start; i != end; i++)
     {
-      NiChanges::iterator nowIterator = GetPosition (now);
-      for (NiChanges::iterator i = m_niChanges.begin (); i != nowIterator; i++)
-        {
-          m_firstPower += i->GetDelta ();
-        }
-      m_niChanges.erase (m_niChanges.begin (), nowIterator);
-      m_niChanges.insert (m_niChanges.begin (), NiChange (event->GetStartTime (), event->GetRxPowerW ()));
-    }
-  else
-    {
-      AddNiChangeEvent (NiChange (event->GetStartTime (), event->GetRxPowerW ()));
+      i->AddPower (event->GetRxPowerW ());
     }
-  AddNiChangeEvent (NiChange (event->GetEndTime (), -event->GetRxPowerW ()));
-
 }
 
 
@@ -249,21 +273,10 @@ InterferenceHelper::CalculateSnr (double signal, double noiseInterference, uint3
 }
 
 double
-InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event> event, NiChanges *ni) const
+InterferenceHelper::CalculateNoiseInterferenceW (Ptr<InterferenceHelper::Event> event) const
 {
-  double noiseInterference = m_firstPower;
   NS_ASSERT (m_rxing);
-  for (NiChanges::const_iterator i = m_niChanges.begin () + 1; i != m_niChanges.end (); i++)
-    {
-      if ((event->GetEndTime () == i->GetTime ()) && event->GetRxPowerW () == -i->GetDelta ())
-        {
-          break;
-        }
-      ni->push_back (*i);
-    }
-  ni->insert (ni->begin (), NiChange (event->GetStartTime (), noiseInterference));
-  ni->push_back (NiChange (event->GetEndTime (), 0));
-  return noiseInterference;
+  return GetStartPosition (event)->GetPower () - event->GetRxPowerW ();
 }
 
 double
@@ -280,11 +293,11 @@ InterferenceHelper::CalculateChunkSuccessRate (double snir, Time duration, WifiM
 }
 
 double
-InterferenceHelper::CalculatePlcpPayloadPer (Ptr<const InterferenceHelper::Event> event, NiChanges *ni) const
+InterferenceHelper::CalculatePlcpPayloadPer (Ptr<const InterferenceHelper::Event> event) const
 {
   NS_LOG_FUNCTION (this);
   double psr = 1.0; /* Packet Success Rate */
-  NiChanges::iterator j = ni->begin ();
+  NiChanges::const_iterator j = GetStartPosition (event);
   Time previous = (*j).GetTime ();
   WifiMode payloadMode = event->GetPayloadMode ();
   WifiPreamble preamble = event->GetPreambleType ();
@@ -292,10 +305,10 @@ InterferenceHelper::CalculatePlcpPayloadPer (Ptr<const InterferenceHelper::Event
   Time plcpHsigHeaderStart = plcpHeaderStart + WifiPhy::GetPlcpHeaderDuration (event->GetTxVector (), preamble); //packet start time + preamble + L-SIG
   Time plcpHtTrainingSymbolsStart = plcpHsigHeaderStart + WifiPhy::GetPlcpHtSigHeaderDuration (preamble) + WifiPhy::GetPlcpVhtSigA1Duration (preamble) + WifiPhy::GetPlcpVhtSigA2Duration (preamble); //packet start time + preamble + L-SIG + HT-SIG or VHT-SIG-A (A1 + A2)
   Time plcpPayloadStart = plcpHtTrainingSymbolsStart + WifiPhy::GetPlcpHtTrainingSymbolDuration (preamble, event->GetTxVector ()) + WifiPhy::GetPlcpVhtSigBDuration (preamble); //packet start time + preamble + L-SIG + HT-SIG or VHT-SIG-A (A1 + A2) + (V)HT Training + VHT-SIG-B
-  double noiseInterferenceW = (*j).GetDelta ();
   double powerW = event->GetRxPowerW ();
+  double noiseInterferenceW = (*j).GetPower () - powerW;
   j++;
-  while (ni->end () != j)
+  while (m_niChanges.end () != j)
     {
       Time current = (*j).GetTime ();
       NS_LOG_DEBUG ("previous= " << previous << ", current=" << current);
@@ -322,7 +335,12 @@ InterferenceHelper::CalculatePlcpPayloadPer (Ptr<const InterferenceHelper::Event
           NS_LOG_DEBUG ("previous is before payload and current is in the payload: mode=" << payloadMode << ", psr=" << psr);
         }
 
-      noiseInterferenceW += (*j).GetDelta ();
+      if (current >= event->GetEndTime ())
+        {
+          //the end of the event
+          break;
+        }
+      noiseInterferenceW = (*j).GetPower () - powerW;
       previous = (*j).GetTime ();
       j++;
     }
@@ -332,11 +350,11 @@ InterferenceHelper::CalculatePlcpPayloadPer (Ptr<const InterferenceHelper::Event
 }
 
 double
-InterferenceHelper::CalculatePlcpHeaderPer (Ptr<const InterferenceHelper::Event> event, NiChanges *ni) const
+InterferenceHelper::CalculatePlcpHeaderPer (Ptr<const InterferenceHelper::Event> event) const
 {
   NS_LOG_FUNCTION (this);
   double psr = 1.0; /* Packet Success Rate */
-  NiChanges::iterator j = ni->begin ();
+  NiChanges::const_iterator j = GetStartPosition (event);
   Time previous = (*j).GetTime ();
   WifiMode payloadMode = event->GetPayloadMode ();
   WifiPreamble preamble = event->GetPreambleType ();
@@ -356,19 +374,19 @@ InterferenceHelper::CalculatePlcpHeaderPer (Ptr<const InterferenceHelper::Event>
   Time plcpHsigHeaderStart = plcpHeaderStart + WifiPhy::GetPlcpHeaderDuration (event->GetTxVector (), preamble); //packet start time + preamble + L-SIG
   Time plcpHtTrainingSymbolsStart = plcpHsigHeaderStart + WifiPhy::GetPlcpHtSigHeaderDuration (preamble) + WifiPhy::GetPlcpVhtSigA1Duration (preamble) + WifiPhy::GetPlcpVhtSigA2Duration (preamble); //packet start time + preamble + L-SIG + HT-SIG or VHT-SIG-A (A1 + A2)
   Time plcpPayloadStart = plcpHtTrainingSymbolsStart + WifiPhy::GetPlcpHtTrainingSymbolDuration (preamble, event->GetTxVector ()) + WifiPhy::GetPlcpVhtSigBDuration (preamble); //packet start time + preamble + L-SIG + HT-SIG or VHT-SIG-A (A1 + A2) + (V)HT Training + VHT-SIG-B
-  double noiseInterferenceW = (*j).GetDelta ();
   double powerW = event->GetRxPowerW ();
+  double noiseInterferenceW = (*j).GetPower () - powerW;
   j++;
-  while (ni->end () != j)
+  while (m_niChanges.end () != j)
     {
       Time current = (*j).GetTime ();
       NS_LOG_DEBUG ("previous= " << previous << ", current=" << current);
       NS_ASSERT (current >= previous);
-      //Case 1: previous and current after playload start: nothing to do
+      //Case 1: previous and current after playload start: nothing to do, for the next changes too
       if (previous >= plcpPayloadStart)
         {
-          psr *= 1;
           NS_LOG_DEBUG ("Case 1 - previous and current after playload start: nothing to do");
+          break;
         }
       //Case 2: previous is in (V)HT training or in VHT-SIG-B: Non (V)HT will not enter here since it didn't enter in the last two and they are all the same for non (V)HT
       else if (previous >= plcpHtTrainingSymbolsStart)
@@ -776,7 +794,12 @@ InterferenceHelper::CalculatePlcpHeaderPer (Ptr<const InterferenceHelper::Event>
             }
         }
 
-      noiseInterferenceW += (*j).GetDelta ();
+      if (current >= event->GetEndTime ())
+        {
+          //the end of the event
+          break;
+        }
+      noiseInterferenceW = (*j).GetPower () - powerW;
       previous = (*j).GetTime ();
       j++;
     }
@@ -788,16 +811,15 @@ InterferenceHelper::CalculatePlcpHeaderPer (Ptr<const InterferenceHelper::Event>
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculatePlcpPayloadSnrPer (Ptr<InterferenceHelper::Event> event)
 {
-  NiChanges ni;
-  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
+  double noiseInterferenceW = CalculateNoiseInterferenceW (event);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
                              event->GetTxVector ().GetChannelWidth ());
 
-  /* calculate the SNIR at the start of the packet and accumulate
-   * all SNIR changes in the snir vector.
+  /* calculate the PER over all the SNIR changes between the start
+   * and the end of the packet.
    */
-  double per = CalculatePlcpPayloadPer (event, &ni);
+  double per = CalculatePlcpPayloadPer (event);
 
   struct SnrPer snrPer;
   snrPer.snr = snr;
@@ -808,16 +830,15 @@ InterferenceHelper::CalculatePlcpPayloadSnrPer (Ptr<InterferenceHelper::Event> e
 struct InterferenceHelper::SnrPer
 InterferenceHelper::CalculatePlcpHeaderSnrPer (Ptr<InterferenceHelper::Event> event)
 {
-  NiChanges ni;
-  double noiseInterferenceW = CalculateNoiseInterferenceW (event, &ni);
+  double noiseInterferenceW = CalculateNoiseInterferenceW (event);
   double snr = CalculateSnr (event->GetRxPowerW (),
                              noiseInterferenceW,
                              event->GetTxVector ().GetChannelWidth ());
 
-  /* calculate the SNIR at the start of the plcp header and accumulate
-   * all SNIR changes in the snir vector.
+  /* calculate the PER over all the SNIR changes between the start
+   * of the packet and the start of the plcp payload.
    */
-  double per = CalculatePlcpHeaderPer (event, &ni);
+  double per = CalculatePlcpHeaderPer (event);
 
   struct SnrPer snrPer;
   snrPer.snr = snr;
@@ -830,19 +851,55 @@ InterferenceHelper::EraseEvents (void)
 {
   m_niChanges.clear ();
   m_rxing = false;
-  m_firstPower = 0.0;
 }
 
 InterferenceHelper::NiChanges::iterator
 InterferenceHelper::GetPosition (Time moment)
 {
-  return std::upper_bound (m_niChanges.begin (), m_niChanges.end (), NiChange (moment, 0));
+  return std::upper_bound (m_niChanges.begin (), m_niChanges.end (), NiChange (moment, 0.0, moment));
+}
+
+InterferenceHelper::NiChanges::iterator
+InterferenceHelper::AddNiChangeEvent (Time moment, Ptr<const InterferenceHelper::Event> event)
+{
+  NiChanges::iterator next = GetPosition (moment);
+  double powerW = 0.0;
+  if (next != m_niChanges.begin ())
+    {
+      NiChanges::iterator previous = next;
+      previous--;
+      powerW = previous->GetPower ();
+    }
+  return m_niChanges.insert (next, NiChange (moment, powerW, event->GetEndTime ()));
+}
+
+InterferenceHelper::NiChanges::const_iterator
+InterferenceHelper::GetStartPosition (Ptr<const InterferenceHelper::Event> event) const
+{
+  //the last change at the start of the event holds the power of all the
+  //signals which start with it
+  NiChanges::const_iterator i = std::upper_bound (m_niChanges.begin (), m_niChanges.end (), NiChange (event->GetStartTime (), 0.0, event->GetStartTime ()));
+  NS_ASSERT (i != m_niChanges.begin ());
+  i--;
+  NS_ASSERT_MSG (i->GetTime () == event->GetStartTime (), "The changes of the event were erased");
+  return i;
 }
 
 void
-InterferenceHelper::AddNiChangeEvent (NiChange change)
+InterferenceHelper::EraseExpiredChanges (void)
 {
-  m_niChanges.insert (GetPosition (change.GetTime ()), change);
+  Time now = Simulator::Now ();
+  NiChanges::iterator first = m_niChanges.begin ();
+  while (first != m_niChanges.end () && first->GetSignalEnd () < now)
+    {
+      first++;
+    }
+  if (first != m_niChanges.begin ())
+    {
+      //keep the last expired change, which holds the power until the next change
+      first--;
+      m_niChanges.erase (m_niChanges.begin (), first);
+    }
 }
 
 void
@@ -22,8 +22,8 @@
 #define INTERFERENCE_HELPER_H
 
 #include <stdint.h>
-#include <vector>
 #include <list>
+#include <deque>
 #include "wifi-mode.h"
 #include "wifi-preamble.h"
 #include "wifi-phy-standard.h"
@@ -184,8 +184,8 @@ private:
                                       Time duration, double rxPower);
 
   /**
-   * Calculate the SNIR at the start of the plcp payload and accumulate
-   * all SNIR changes in the snir vector.
+   * Calculate the SNIR at the start of the plcp payload, and the PER of
+   * the payload over all the SNIR changes.
    *
    * \param event the event corresponding to the first time the corresponding packet arrives
    *
@@ -193,8 +193,8 @@ private:
    */
   struct InterferenceHelper::SnrPer CalculatePlcpPayloadSnrPer (Ptr<InterferenceHelper::Event> event);
   /**
-   * Calculate the SNIR at the start of the plcp header and accumulate
-   * all SNIR changes in the snir vector.
+   * Calculate the SNIR at the start of the plcp header, and the PER of
+   * the header over all the SNIR changes.
    *
    * \param event the event corresponding to the first time the corresponding packet arrives
    *
@@ -218,18 +218,24 @@ private:
 
 private:
   /**
-   * Noise and Interference (thus Ni) event.
+   * Noise and Interference (thus Ni) event: the start or the end of
+   * the signal of an Event.
+   *
+   * A NiChange holds the total power of the signals from its time
+   * until the next NiChange, so the power over any interval is read
+   * without summing the changes before it.
    */
   class NiChange
   {
 public:
     /**
-     * Create a NiChange at the given time and the amount of NI change.
+     * Create a NiChange at the given time with the given power.
      *
-     * \param time time of the event
-     * \param delta the power
+     * \param time time of the change
+     * \param power the power of all the signals after the change (W)
+     * \param signalEnd the end of the signal which starts or ends
      */
-    NiChange (Time time, double delta);
+    NiChange (Time time, double power, Time signalEnd);
     /**
      * Return the event time.
      *
@@ -237,11 +243,24 @@ public:
      */
     Time GetTime (void) const;
     /**
-     * Return the power
+     * Return the power of all the signals after the change.
+     *
+     * \return the power (W)
+     */
+    double GetPower (void) const;
+    /**
+     * Add the power of a signal which overlaps the change.
+     *
+     * \param power the power of the signal (W)
+     */
+    void AddPower (double power);
+    /**
+     * Return the end of the signal which starts or ends at the change:
+     * the change is not needed anymore after it.
      *
-     * \return the power
+     * \return the end of the signal
      */
-    double GetDelta (void) const;
+    Time GetSignalEnd (void) const;
     /**
      * Compare the event time of two NiChange objects (a < o).
      *
@@ -253,12 +272,15 @@ public:
 
 private:
     Time m_time;
-    double m_delta;
+    double m_power;
+    Time m_signalEnd;
   };
   /**
-   * typedef for a vector of NiChanges
+   * typedef for a deque of NiChanges, sorted by time, the changes at the
+   * same time in the order they were added. The expired changes are
+   * erased at the front.
    */
-  typedef std::vector <NiChange> NiChanges;
+  typedef std::deque<NiChange> NiChanges;
   /**
    * typedef for a list of Events
    */
@@ -274,11 +296,10 @@ private:
    * Calculate noise and interference power in W.
    *
    * \param event
-   * \param ni
    *
-   * \return noise and interference power
+   * \return noise and interference power at the start of the event
    */
-  double CalculateNoiseInterferenceW (Ptr<Event> event, NiChanges *ni) const;
+  double CalculateNoiseInterferenceW (Ptr<Event> event) const;
   /**
    * Calculate SNR (linear ratio) from the given signal power and noise+interference power.
    * (Mode is not currently used)
@@ -307,36 +328,50 @@ private:
    * multiple chunks (e.g. due to interference from other transmissions).
    *
    * \param event
-   * \param ni
    *
    * \return the error rate of the packet
    */
-  double CalculatePlcpPayloadPer (Ptr<const Event> event, NiChanges *ni) const;
+  double CalculatePlcpPayloadPer (Ptr<const Event> event) const;
   /**
    * Calculate the error rate of the plcp header. The plcp header can be divided into
    * multiple chunks (e.g. due to interference from other transmissions).
    *
    * \param event
-   * \param ni
    *
    * \return the error rate of the packet
    */
-  double CalculatePlcpHeaderPer (Ptr<const Event> event, NiChanges *ni) const;
+  double CalculatePlcpHeaderPer (Ptr<const Event> event) const;
 
   double m_noiseFigure; /**< noise figure (linear) */
   Ptr<ErrorRateModel> m_errorRateModel;
-  /// Experimental: needed for energy duration calculation
+  /// the changes of the signals which have not ended yet, and the last
+  /// change before them
   NiChanges m_niChanges;
-  double m_firstPower;
   bool m_rxing;
   /// Returns an iterator to the first nichange, which is later than moment
   NiChanges::iterator GetPosition (Time moment);
   /**
-   * Add NiChange to the list at the appropriate position.
+   * Add a NiChange after the other ones at the same time, with the power
+   * of the change before it.
    *
-   * \param change
+   * \param moment the time of the change
+   * \param event the Event which starts or ends
+   *
+   * \return the position of the new change
+   */
+  NiChanges::iterator AddNiChangeEvent (Time moment, Ptr<const Event> event);
+  /**
+   * \param event an Event which has not ended yet
+   *
+   * \return the position of the last change at the start of the event
+   */
+  NiChanges::const_iterator GetStartPosition (Ptr<const Event> event) const;
+  /**
+   * Erase the changes before the first one of a signal which has not
+   * ended yet, except the last one, which holds the power until the
+   * next change.
    */
-  void AddNiChangeEvent (NiChange change);
+  void EraseExpiredChanges (void);
 };
 
 } //namespace ns3
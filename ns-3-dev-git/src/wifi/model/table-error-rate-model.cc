@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "table-error-rate-model.h"
+#include "nist-error-rate-model.h"
+#include "ns3/pointer.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TableErrorRateModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TableErrorRateModel);
+
+TypeId
+TableErrorRateModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TableErrorRateModel")
+    .SetParent<ErrorRateModel> ()
+    .SetGroupName ("Wifi")
+    .AddConstructor<TableErrorRateModel> ()
+    .AddAttribute ("ErrorRateModel",
+                   "The error rate model whose BERs are tabulated. "
+                   "A NistErrorRateModel is used if none is set.",
+                   PointerValue (),
+                   MakePointerAccessor (&TableErrorRateModel::m_errorRateModel),
+                   MakePointerChecker<ErrorRateModel> ())
+    .AddAttribute ("MinSnr",
+                   "The lowest SNR (dB) of the tables.",
+                   DoubleValue (-10.0),
+                   MakeDoubleAccessor (&TableErrorRateModel::m_minSnr),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxSnr",
+                   "The highest SNR (dB) of the tables.",
+                   DoubleValue (50.0),
+                   MakeDoubleAccessor (&TableErrorRateModel::m_maxSnr),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("SnrResolution",
+                   "The step (dB) between the SNRs of the tables.",
+                   DoubleValue (0.05),
+                   MakeDoubleAccessor (&TableErrorRateModel::m_resolution),
+                   MakeDoubleChecker<double> (1e-6))
+  ;
+  return tid;
+}
+
+TableErrorRateModel::TableErrorRateModel ()
+  : m_lastTable (0)
+{
+}
+
+bool
+TableErrorRateModel::TableKey::operator < (const TableKey &o) const
+{
+  if (mode != o.mode)
+    {
+      return mode < o.mode;
+    }
+  if (channelWidth != o.channelWidth)
+    {
+      return channelWidth < o.channelWidth;
+    }
+  return shortGuardInterval < o.shortGuardInterval;
+}
+
+const TableErrorRateModel::LogBers &
+TableErrorRateModel::GetTable (WifiMode mode, WifiTxVector txVector) const
+{
+  TableKey key;
+  key.mode = mode.GetUid ();
+  key.channelWidth = txVector.GetChannelWidth ();
+  key.shortGuardInterval = txVector.IsShortGuardInterval ();
+  if (m_lastTable != 0 && !(key < m_lastKey) && !(m_lastKey < key))
+    {
+      return *m_lastTable;
+    }
+  Tables::iterator it = m_tables.find (key);
+  if (it == m_tables.end ())
+    {
+      NS_LOG_DEBUG ("fill the table of " << mode << " width=" << key.channelWidth << " sgi=" << key.shortGuardInterval);
+      if (m_errorRateModel == 0)
+        {
+          const_cast<TableErrorRateModel *> (this)->m_errorRateModel = CreateObject<NistErrorRateModel> ();
+        }
+      uint32_t size = static_cast<uint32_t> ((m_maxSnr - m_minSnr) / m_resolution + 0.5) + 1;
+      LogBers logBers (size);
+      for (uint32_t i = 0; i < size; i++)
+        {
+          double snr = std::pow (10.0, (m_minSnr + i * m_resolution) / 10.0);
+          double ber = 1 - m_errorRateModel->GetChunkSuccessRate (mode, txVector, snr, 1);
+          //a BER of 0 would not interpolate
+          logBers[i] = std::log (std::max (ber, std::numeric_limits<double>::min ()));
+        }
+      it = m_tables.insert (std::make_pair (key, logBers)).first;
+    }
+  m_lastKey = key;
+  m_lastTable = &it->second;
+  return it->second;
+}
+
+double
+TableErrorRateModel::GetChunkSuccessRate (WifiMode mode, WifiTxVector txVector, double snr, uint32_t nbits) const
+{
+  if (nbits == 0)
+    {
+      return 1.0;
+    }
+  const LogBers &logBers = GetTable (mode, txVector);
+  double position = (10.0 * std::log10 (snr) - m_minSnr) / m_resolution;
+  if (!(position >= 0) || position >= logBers.size () - 1)
+    {
+      //beyond the table, or a SNR of 0
+      return m_errorRateModel->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  uint32_t i = static_cast<uint32_t> (position);
+  if (logBers[i] == 0)
+    {
+      if (logBers[i + 1] == 0)
+        {
+          //a BER of 1
+          return 0.0;
+        }
+      //the BER of the model may reach 1 with a kink, which does not
+      //interpolate
+      return m_errorRateModel->GetChunkSuccessRate (mode, txVector, snr, nbits);
+    }
+  double logBer = logBers[i] + (position - i) * (logBers[i + 1] - logBers[i]);
+  double psr = std::exp (nbits * log1p (-std::exp (logBer)));
+  NS_LOG_INFO ("mode=" << mode << " snr=" << snr << " ber=" << std::exp (logBer) << " psr=" << psr);
+  return psr;
+}
+
+} //namespace ns3
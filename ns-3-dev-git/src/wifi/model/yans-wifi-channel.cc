@@ -25,10 +25,12 @@
 #include "ns3/node.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
+#include "ns3/double.h"
 #include "ns3/object-factory.h"
 #include "yans-wifi-channel.h"
 #include "ns3/propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -51,11 +53,24 @@ YansWifiChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&YansWifiChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("MaxRange",
+                   "The distance (m) beyond which a transmission is not delivered, "
+                   "not even as interference. 0 delivers at any distance.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("RxPowerFloor",
+                   "The reception power (dBm) below which a transmission is not delivered, "
+                   "not even as interference. The default delivers at any power.",
+                   DoubleValue (-1000.0),
+                   MakeDoubleAccessor (&YansWifiChannel::m_rxPowerFloorDbm),
+                   MakeDoubleChecker<double> ())
   ;
   return tid;
 }
 
 YansWifiChannel::YansWifiChannel ()
+  : m_nIndexed (0)
 {
 }
 
@@ -65,6 +80,19 @@ YansWifiChannel::~YansWifiChannel ()
   m_phyList.clear ();
 }
 
+void
+YansWifiChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_grid.Clear ();
+  m_physOf.clear ();
+  m_nIndexed = 0;
+  m_phyList.clear ();
+  m_loss = 0;
+  m_delay = 0;
+  WifiChannel::DoDispose ();
+}
+
 void
 YansWifiChannel::SetPropagationLossModel (Ptr<PropagationLossModel> loss)
 {
@@ -83,24 +111,52 @@ YansWifiChannel::Send (Ptr<YansWifiPhy> sender, Ptr<const Packet> packet, double
 {
   Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
   NS_ASSERT (senderMobility != 0);
-  uint32_t j = 0;
-  for (PhyList::const_iterator i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+  std::vector<uint32_t> candidates;
+  if (m_maxRange > 0)
+    {
+      GetCandidates (senderMobility->GetPosition (), candidates);
+    }
+  else
+    {
+      candidates.reserve (m_phyList.size ());
+      for (uint32_t j = 0; j < m_phyList.size (); j++)
+        {
+          candidates.push_back (j);
+        }
+    }
+  // the receivers share a single copy of the packet
+  Ptr<Packet> copy;
+  for (std::vector<uint32_t>::const_iterator k = candidates.begin (); k != candidates.end (); k++)
     {
-      if (sender != (*i))
+      uint32_t j = *k;
+      Ptr<YansWifiPhy> phy = m_phyList[j];
+      if (sender != phy)
         {
           //For now don't account for inter channel interference
-          if ((*i)->GetChannelNumber () != sender->GetChannelNumber ())
+          if (phy->GetChannelNumber () != sender->GetChannelNumber ())
             {
               continue;
             }
 
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->GetObject<MobilityModel> ();
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+          Ptr<MobilityModel> receiverMobility = phy->GetMobility ()->GetObject<MobilityModel> ();
+          if (m_maxRange > 0 && senderMobility->GetDistanceFrom (receiverMobility) > m_maxRange)
+            {
+              continue;
+            }
           double rxPowerDbm = m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
+          if (rxPowerDbm < m_rxPowerFloorDbm)
+            {
+              NS_LOG_DEBUG ("skip receiver " << j << ": rxPower=" << rxPowerDbm << "dbm");
+              continue;
+            }
+          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
           NS_LOG_DEBUG ("propagation: txPower=" << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
                         "distance=" << senderMobility->GetDistanceFrom (receiverMobility) << "m, delay=" << delay);
-          Ptr<Packet> copy = packet->Copy ();
-          Ptr<Object> dstNetDevice = m_phyList[j]->GetDevice ();
+          if (copy == 0)
+            {
+              copy = packet->Copy ();
+            }
+          Ptr<Object> dstNetDevice = phy->GetDevice ();
           uint32_t dstNode;
           if (dstNetDevice == 0)
             {
@@ -149,6 +205,31 @@ YansWifiChannel::Add (Ptr<YansWifiPhy> phy)
   m_phyList.push_back (phy);
 }
 
+void
+YansWifiChannel::GetCandidates (const Vector &position, std::vector<uint32_t> &candidates) const
+{
+  if (m_grid.GetCellSize () != m_maxRange)
+    {
+      m_grid.SetCellSize (m_maxRange);
+    }
+  for (; m_nIndexed < m_phyList.size (); m_nIndexed++)
+    {
+      Ptr<MobilityModel> model = m_phyList[m_nIndexed]->GetMobility ()->GetObject<MobilityModel> ();
+      NS_ASSERT (model != 0);
+      uint32_t i = m_grid.Add (model);
+      m_physOf.resize (m_grid.GetN ());
+      m_physOf[i].push_back (m_nIndexed);
+    }
+  std::vector<uint32_t> near;
+  m_grid.GetNear (position, m_maxRange, near);
+  for (std::vector<uint32_t>::const_iterator i = near.begin (); i != near.end (); i++)
+    {
+      candidates.insert (candidates.end (), m_physOf[*i].begin (), m_physOf[*i].end ());
+    }
+  // deliver in the order of the PHY list, as without the grid
+  std::sort (candidates.begin (), candidates.end ());
+}
+
 int64_t
 YansWifiChannel::AssignStreams (int64_t stream)
 {
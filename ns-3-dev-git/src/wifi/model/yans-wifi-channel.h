@@ -30,6 +30,7 @@
 #include "wifi-tx-vector.h"
 #include "yans-wifi-phy.h"
 #include "ns3/nstime.h"
+#include "ns3/mobility-grid.h"
 
 namespace ns3 {
 
@@ -57,6 +58,19 @@ struct Parameters
  * class and contains a ns3::PropagationLossModel and a ns3::PropagationDelayModel.
  * By default, no propagation models are set so, it is the caller's responsability
  * to set them before using the channel.
+ *
+ * Send normally schedules a reception on every other PHY of the channel.
+ * With a non-zero MaxRange attribute, the channel keeps the mobility
+ * models of the PHYs in a MobilityGrid of MaxRange-wide cells and
+ * considers only the PHYs of the cells around the sender; the PHYs
+ * further than MaxRange are skipped.
+ * With the RxPowerFloor attribute, the PHYs which would receive less
+ * power are skipped as well. A skipped PHY neither receives the packet nor
+ * counts it as interference, so both attributes should be set well beyond
+ * the range at which a signal could matter.
+ *
+ * All the PHYs receiving a transmission share the same copy of the packet:
+ * they must not modify it, and copy it before handing it to the MAC.
  */
 class YansWifiChannel : public WifiChannel
 {
@@ -116,6 +130,8 @@ public:
 
 
 private:
+  virtual void DoDispose (void);
+
   /**
    * A vector of pointers to YansWifiPhy.
    */
@@ -134,9 +150,23 @@ private:
    */
   void Receive (uint32_t i, Ptr<Packet> packet, struct Parameters parameters) const;
 
+  /**
+   * Find the PHYs which may be within MaxRange of a position.
+   *
+   * \param position the position of the sender
+   * \param candidates the indices of the PHYs, in increasing order
+   */
+  void GetCandidates (const Vector &position, std::vector<uint32_t> &candidates) const;
+
   PhyList m_phyList;                   //!< List of YansWifiPhys connected to this YansWifiChannel
   Ptr<PropagationLossModel> m_loss;    //!< Propagation loss model
   Ptr<PropagationDelayModel> m_delay;  //!< Propagation delay model
+  double m_maxRange;                   //!< Range beyond which the PHYs are skipped (m), 0 to disable
+  double m_rxPowerFloorDbm;            //!< Power below which the PHYs are skipped (dBm)
+
+  mutable MobilityGrid m_grid;                             //!< The mobility models of the PHYs
+  mutable std::vector<std::vector<uint32_t> > m_physOf;    //!< The PHYs of each model of the grid
+  mutable uint32_t m_nIndexed;                             //!< Number of PHYs of m_phyList in the grid
 };
 
 } //namespace ns3
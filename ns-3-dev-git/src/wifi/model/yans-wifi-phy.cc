@@ -1184,7 +1184,9 @@ YansWifiPhy::EndReceive (Ptr<Packet> packet, enum WifiPreamble preamble, enum mp
           aMpdu.type = mpdutype;
           aMpdu.mpduRefNumber = m_rxMpduReferenceNumber;
           NotifyMonitorSniffRx (packet, (uint16_t)GetChannelFrequencyMhz (), GetChannelNumber (), dataRate500KbpsUnits, event->GetPreambleType (), event->GetTxVector (), aMpdu, signalNoise);
-          m_state->SwitchFromRxEndOk (packet, snrPer.snr, event->GetTxVector (), event->GetPreambleType ());
+          // the packet is shared with the other receivers of the channel
+          // and the MAC removes its headers
+          m_state->SwitchFromRxEndOk (packet->Copy (), snrPer.snr, event->GetTxVector (), event->GetPreambleType ());
         }
       else
         {
@@ -103,7 +103,7 @@ public:
   /**
    * Starting receiving the plcp of a packet (i.e. the first bit of the preamble has arrived).
    *
-   * \param packet the arriving packet
+   * \param packet the arriving packet, shared with the other receivers of the channel
    * \param rxPowerDbm the receive power in dBm
    * \param txVector the TXVECTOR of the arriving packet
    * \param preamble the preamble of the arriving packet
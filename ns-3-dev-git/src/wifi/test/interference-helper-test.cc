@@ -0,0 +1,259 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/interference-helper.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/wifi-phy.h"
+
+using namespace ns3;
+
+/**
+ * Base of the tests: an InterferenceHelper which receives 54 Mbps OFDM
+ * frames, and the SNRs and PERs it should compute.
+ */
+class InterferenceHelperTestCase : public TestCase
+{
+public:
+  /**
+   * \param name the name of the test
+   */
+  InterferenceHelperTestCase (std::string name);
+
+protected:
+  /**
+   * Add a signal of the given power.
+   *
+   * \param duration the duration of the signal
+   * \param powerW the power of the signal (W)
+   *
+   * \return the event of the signal
+   */
+  Ptr<InterferenceHelper::Event> Add (Time duration, double powerW);
+  /**
+   * Add a signal and start to receive it.
+   *
+   * \param duration the duration of the signal
+   * \param powerW the power of the signal (W)
+   */
+  void Receive (Time duration, double powerW);
+  /**
+   * \param powerW the power of the signal (W)
+   * \param interferenceW the power of the other signals (W)
+   *
+   * \return the SNR of the signal
+   */
+  double GetSnr (double powerW, double interferenceW) const;
+  /**
+   * \param mode the mode of the chunk
+   * \param snr the SNR of the chunk
+   * \param duration the duration of the chunk
+   *
+   * \return the success rate of the chunk
+   */
+  double GetChunkSuccessRate (WifiMode mode, double snr, Time duration) const;
+
+  InterferenceHelper m_interference;          //!< the InterferenceHelper under test
+  Ptr<ErrorRateModel> m_errorRateModel;       //!< the error rate model of m_interference
+  WifiTxVector m_txVector;                    //!< the TXVECTOR of the signals
+  Ptr<InterferenceHelper::Event> m_event;     //!< the event being received
+  Time m_payloadStart;                        //!< offset of the payload in a frame
+  Time m_headerStart;                         //!< offset of the plcp header in a frame
+};
+
+InterferenceHelperTestCase::InterferenceHelperTestCase (std::string name)
+  : TestCase (name)
+{
+  m_interference.SetNoiseFigure (5.01187);
+  m_errorRateModel = CreateObject<NistErrorRateModel> ();
+  m_interference.SetErrorRateModel (m_errorRateModel);
+  m_txVector = WifiTxVector (WifiPhy::GetOfdmRate54Mbps (), 0, 0, false, 1, 0, 20, false, false);
+  m_headerStart = WifiPhy::GetPlcpPreambleDuration (m_txVector, WIFI_PREAMBLE_LONG);
+  m_payloadStart = m_headerStart + WifiPhy::GetPlcpHeaderDuration (m_txVector, WIFI_PREAMBLE_LONG);
+}
+
+Ptr<InterferenceHelper::Event>
+InterferenceHelperTestCase::Add (Time duration, double powerW)
+{
+  return m_interference.Add (1000, m_txVector, WIFI_PREAMBLE_LONG, duration, powerW);
+}
+
+void
+InterferenceHelperTestCase::Receive (Time duration, double powerW)
+{
+  m_event = Add (duration, powerW);
+  m_interference.NotifyRxStart ();
+}
+
+double
+InterferenceHelperTestCase::GetSnr (double powerW, double interferenceW) const
+{
+  double noiseFloorW = m_interference.GetNoiseFigure () * 1.3803e-23 * 290.0 * 20e6;
+  return powerW / (noiseFloorW + interferenceW);
+}
+
+double
+InterferenceHelperTestCase::GetChunkSuccessRate (WifiMode mode, double snr, Time duration) const
+{
+  uint64_t nbits = (uint64_t)(mode.GetPhyRate (20, false, 1) * duration.GetSeconds ());
+  return m_errorRateModel->GetChunkSuccessRate (mode, m_txVector, snr, (uint32_t)nbits);
+}
+
+/**
+ * Check the SNR, the PERs and the energy durations of a frame which
+ * overlaps two other signals.
+ */
+class InterferenceHelperOverlapTest : public InterferenceHelperTestCase
+{
+public:
+  InterferenceHelperOverlapTest ();
+private:
+  virtual void DoRun (void);
+  /** Check the energy durations in the middle of the frame */
+  void CheckEnergy (void);
+  /** Check the SNR and the PERs of the frame */
+  void CheckPer (void);
+};
+
+InterferenceHelperOverlapTest::InterferenceHelperOverlapTest ()
+  : InterferenceHelperTestCase ("Check the SNR and the PER of a frame with interferers")
+{
+}
+
+void
+InterferenceHelperOverlapTest::CheckEnergy (void)
+{
+  // 450us: all the signals until 600us, then the frame and the second
+  // interferer until 1000us, then the second interferer until 1500us
+  NS_TEST_EXPECT_MSG_EQ (m_interference.GetEnergyDuration (1.2e-10), MicroSeconds (150), "Wrong energy duration");
+  NS_TEST_EXPECT_MSG_EQ (m_interference.GetEnergyDuration (5e-11), MicroSeconds (550), "Wrong energy duration");
+  NS_TEST_EXPECT_MSG_EQ (m_interference.GetEnergyDuration (1e-12), MicroSeconds (1050), "Wrong energy duration");
+}
+
+void
+InterferenceHelperOverlapTest::CheckPer (void)
+{
+  WifiMode mode = m_txVector.GetMode ();
+  WifiMode headerMode = WifiPhy::GetPlcpHeaderMode (mode, WIFI_PREAMBLE_LONG, m_txVector);
+  InterferenceHelper::SnrPer header = m_interference.CalculatePlcpHeaderSnrPer (m_event);
+  NS_TEST_EXPECT_MSG_EQ_TOL (header.snr, GetSnr (1e-10, 0), 1e-9, "Wrong SNR");
+  double expected = 1 - GetChunkSuccessRate (headerMode, GetSnr (1e-10, 0), m_payloadStart - m_headerStart);
+  NS_TEST_EXPECT_MSG_EQ_TOL (header.per, expected, 1e-12, "Wrong PER of the header");
+
+  InterferenceHelper::SnrPer payload = m_interference.CalculatePlcpPayloadSnrPer (m_event);
+  NS_TEST_EXPECT_MSG_EQ_TOL (payload.snr, GetSnr (1e-10, 0), 1e-9, "Wrong SNR");
+  double psr = GetChunkSuccessRate (mode, GetSnr (1e-10, 0), MicroSeconds (200) - m_payloadStart);
+  psr *= GetChunkSuccessRate (mode, GetSnr (1e-10, 3e-11), MicroSeconds (200));
+  psr *= GetChunkSuccessRate (mode, GetSnr (1e-10, 4e-11), MicroSeconds (200));
+  psr *= GetChunkSuccessRate (mode, GetSnr (1e-10, 1e-11), MicroSeconds (400));
+  NS_TEST_EXPECT_MSG_GT (1 - psr, 0.01, "The interference does not matter");
+  NS_TEST_EXPECT_MSG_EQ_TOL (payload.per, 1 - psr, 1e-12, "Wrong PER of the payload");
+  m_interference.NotifyRxEnd ();
+}
+
+void
+InterferenceHelperOverlapTest::DoRun (void)
+{
+  Simulator::Schedule (Seconds (0), &InterferenceHelperOverlapTest::Receive, this, MicroSeconds (1000), 1e-10);
+  Simulator::Schedule (MicroSeconds (200), &InterferenceHelperOverlapTest::Add, this, MicroSeconds (400), 3e-11);
+  Simulator::Schedule (MicroSeconds (400), &InterferenceHelperOverlapTest::Add, this, MicroSeconds (1100), 1e-11);
+  Simulator::Schedule (MicroSeconds (450), &InterferenceHelperOverlapTest::CheckEnergy, this);
+  Simulator::Schedule (MicroSeconds (1000), &InterferenceHelperOverlapTest::CheckPer, this);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+/**
+ * Receive many frames, each with an interferer which starts with it and
+ * one which started before it, and check that the changes which are
+ * erased between the frames do not alter their PER.
+ */
+class InterferenceHelperPruneTest : public InterferenceHelperTestCase
+{
+public:
+  InterferenceHelperPruneTest ();
+private:
+  virtual void DoRun (void);
+  /** Add the interferer which starts with the frame, then the frame */
+  void Start (void);
+  /** Check the SNR and the PER of the frame */
+  void CheckPer (void);
+
+  uint32_t m_frames;  //!< number of frames received
+};
+
+InterferenceHelperPruneTest::InterferenceHelperPruneTest ()
+  : InterferenceHelperTestCase ("Check the PERs of a sequence of frames"),
+    m_frames (0)
+{
+}
+
+void
+InterferenceHelperPruneTest::Start (void)
+{
+  Add (MicroSeconds (300), 2e-11);
+  Receive (MicroSeconds (1000), 1e-10);
+}
+
+void
+InterferenceHelperPruneTest::CheckPer (void)
+{
+  WifiMode mode = m_txVector.GetMode ();
+  InterferenceHelper::SnrPer payload = m_interference.CalculatePlcpPayloadSnrPer (m_event);
+  NS_TEST_EXPECT_MSG_EQ_TOL (payload.snr, GetSnr (1e-10, 3e-11), 1e-9, "Wrong SNR");
+  double psr = GetChunkSuccessRate (mode, GetSnr (1e-10, 3e-11), MicroSeconds (300) - m_payloadStart);
+  psr *= GetChunkSuccessRate (mode, GetSnr (1e-10, 1e-11), MicroSeconds (200));
+  psr *= GetChunkSuccessRate (mode, GetSnr (1e-10, 0), MicroSeconds (500));
+  NS_TEST_EXPECT_MSG_EQ_TOL (payload.per, 1 - psr, 1e-12, "Wrong PER of frame " << m_frames);
+  m_interference.NotifyRxEnd ();
+  m_frames++;
+}
+
+void
+InterferenceHelperPruneTest::DoRun (void)
+{
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      Time start = MilliSeconds (3 * i + 1);
+      Simulator::Schedule (start - MicroSeconds (200), &InterferenceHelperPruneTest::Add, this, MicroSeconds (700), 1e-11);
+      Simulator::Schedule (start, &InterferenceHelperPruneTest::Start, this);
+      Simulator::Schedule (start + MicroSeconds (1000), &InterferenceHelperPruneTest::CheckPer, this);
+      // a signal during the idle time, to be erased
+      Simulator::Schedule (start + MicroSeconds (1500), &InterferenceHelperPruneTest::Add, this, MicroSeconds (100), 1e-9);
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (m_frames, 200, "Frames were not received");
+}
+
+/**
+ * The InterferenceHelper test suite.
+ */
+class InterferenceHelperTestSuite : public TestSuite
+{
+public:
+  InterferenceHelperTestSuite ();
+};
+
+InterferenceHelperTestSuite::InterferenceHelperTestSuite ()
+  : TestSuite ("interference-helper", UNIT)
+{
+  AddTestCase (new InterferenceHelperOverlapTest, TestCase::QUICK);
+  AddTestCase (new InterferenceHelperPruneTest, TestCase::QUICK);
+}
+
+static InterferenceHelperTestSuite g_interferenceHelperTestSuite;
@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/pointer.h"
+#include "ns3/object-factory.h"
+#include "ns3/table-error-rate-model.h"
+#include "ns3/wifi-phy.h"
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Check that the success rates of a TableErrorRateModel stay within a
+ * bound of the ones of the model it tabulates, for all the modes, and
+ * are equal beyond its tables.
+ */
+class TableErrorRateModelAccuracyTest : public TestCase
+{
+public:
+  /**
+   * \param analytic the TypeId name of the tabulated model
+   */
+  TableErrorRateModelAccuracyTest (std::string analytic);
+private:
+  virtual void DoRun (void);
+  /**
+   * Compare the success rates of the models for a transmission, over a
+   * range of SNRs and chunk sizes.
+   *
+   * \param mode the mode of the transmission
+   * \param channelWidth the channel width (MHz)
+   * \param sgi whether the guard interval is short
+   */
+  void Compare (WifiMode mode, uint32_t channelWidth, bool sgi);
+
+  std::string m_analyticType;               //!< the TypeId name of the tabulated model
+  Ptr<ErrorRateModel> m_analytic;           //!< the tabulated model
+  Ptr<TableErrorRateModel> m_table;         //!< the model under test
+};
+
+TableErrorRateModelAccuracyTest::TableErrorRateModelAccuracyTest (std::string analytic)
+  : TestCase ("Check the success rates of a table of a " + analytic),
+    m_analyticType (analytic)
+{
+}
+
+void
+TableErrorRateModelAccuracyTest::Compare (WifiMode mode, uint32_t channelWidth, bool sgi)
+{
+  WifiTxVector txVector (mode, 0, 0, sgi, 1, 0, channelWidth, false, false);
+  uint32_t sizes[] = { 1, 8, 100, 1000, 12000 };
+  for (double snrDb = -20.0; snrDb <= 60.0; snrDb += 0.0731)
+    {
+      double snr = std::pow (10.0, snrDb / 10);
+      for (uint32_t s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+        {
+          double expected = m_analytic->GetChunkSuccessRate (mode, txVector, snr, sizes[s]);
+          double actual = m_table->GetChunkSuccessRate (mode, txVector, snr, sizes[s]);
+          if (snrDb < -10.0 || snrDb > 50.0)
+            {
+              NS_TEST_ASSERT_MSG_EQ (actual, expected, "Not the " << m_analyticType << " beyond the table for " << mode << " at " << snrDb << " dB");
+            }
+          else
+            {
+              NS_TEST_ASSERT_MSG_EQ_TOL (actual, expected, 5e-4, "Wrong success rate of " << sizes[s] << " bits of " << mode << " at " << snrDb << " dB");
+            }
+        }
+    }
+}
+
+void
+TableErrorRateModelAccuracyTest::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (m_analyticType);
+  m_analytic = factory.Create<ErrorRateModel> ();
+  m_table = CreateObject<TableErrorRateModel> ();
+  m_table->SetAttribute ("ErrorRateModel", PointerValue (m_analytic));
+
+  std::vector<WifiMode> modes;
+  modes.push_back (WifiPhy::GetDsssRate1Mbps ());
+  modes.push_back (WifiPhy::GetDsssRate2Mbps ());
+  modes.push_back (WifiPhy::GetDsssRate5_5Mbps ());
+  modes.push_back (WifiPhy::GetDsssRate11Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate6Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate9Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate12Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate18Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate24Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate36Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate48Mbps ());
+  modes.push_back (WifiPhy::GetOfdmRate54Mbps ());
+  for (uint32_t i = 0; i < modes.size (); i++)
+    {
+      Compare (modes[i], 20, false);
+    }
+  modes.clear ();
+  modes.push_back (WifiPhy::GetHtMcs0 ());
+  modes.push_back (WifiPhy::GetHtMcs2 ());
+  modes.push_back (WifiPhy::GetHtMcs4 ());
+  modes.push_back (WifiPhy::GetHtMcs5 ());
+  modes.push_back (WifiPhy::GetHtMcs7 ());
+  modes.push_back (WifiPhy::GetVhtMcs8 ());
+  modes.push_back (WifiPhy::GetVhtMcs9 ());
+  for (uint32_t i = 0; i < modes.size (); i++)
+    {
+      Compare (modes[i], 40, true);
+    }
+}
+
+/**
+ * The TableErrorRateModel test suite.
+ */
+class TableErrorRateModelTestSuite : public TestSuite
+{
+public:
+  TableErrorRateModelTestSuite ();
+};
+
+TableErrorRateModelTestSuite::TableErrorRateModelTestSuite ()
+  : TestSuite ("table-error-rate-model", UNIT)
+{
+  AddTestCase (new TableErrorRateModelAccuracyTest ("ns3::NistErrorRateModel"), TestCase::QUICK);
+  AddTestCase (new TableErrorRateModelAccuracyTest ("ns3::YansErrorRateModel"), TestCase::QUICK);
+}
+
+static TableErrorRateModelTestSuite g_tableErrorRateModelTestSuite;
@@ -0,0 +1,263 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/yans-wifi-channel.h"
+#include "ns3/yans-wifi-phy.h"
+#include "ns3/yans-error-rate-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+
+using namespace ns3;
+
+/**
+ * What a PHY of the tests received.
+ */
+struct ChannelTestReceiver
+{
+  uint32_t arrivals;            //!< number of packets delivered by the channel
+  uint32_t expected;            //!< number of packets the channel should deliver
+  Ptr<const Packet> packet;     //!< the last packet delivered
+};
+
+/**
+ * Count a packet delivered to a PHY, which either syncs to it or drops it.
+ *
+ * \param receiver the receiver of the packet
+ * \param packet the packet
+ */
+static void
+ChannelTestArrival (ChannelTestReceiver *receiver, Ptr<const Packet> packet)
+{
+  receiver->arrivals++;
+  receiver->packet = packet;
+}
+
+/**
+ * Base of the tests: PHYs on a YansWifiChannel with a log-distance loss.
+ */
+class YansWifiChannelTestCase : public TestCase
+{
+public:
+  /**
+   * \param name the name of the test
+   */
+  YansWifiChannelTestCase (std::string name);
+protected:
+  /**
+   * Add a PHY to the channel.
+   *
+   * \param mobility the mobility model of the PHY
+   */
+  void AddPhy (Ptr<MobilityModel> mobility);
+  /**
+   * Send a packet from the first PHY, and count the PHYs to which the
+   * channel should deliver it.
+   *
+   * \param maxRange the range of the channel, 0 for none
+   * \param floor the reception floor of the channel
+   */
+  void Send (double maxRange, double floor);
+  /** Check the deliveries, then destroy the simulation. */
+  void Finish (void);
+
+  Ptr<YansWifiChannel> m_channel;               //!< the channel
+  Ptr<PropagationLossModel> m_loss;             //!< the loss model of the channel
+  std::vector<Ptr<YansWifiPhy> > m_phys;        //!< the PHYs
+  std::vector<ChannelTestReceiver> m_receivers; //!< what each PHY received
+};
+
+YansWifiChannelTestCase::YansWifiChannelTestCase (std::string name)
+  : TestCase (name)
+{
+}
+
+void
+YansWifiChannelTestCase::AddPhy (Ptr<MobilityModel> mobility)
+{
+  if (m_channel == 0)
+    {
+      m_channel = CreateObject<YansWifiChannel> ();
+      m_loss = CreateObject<LogDistancePropagationLossModel> ();
+      m_channel->SetPropagationLossModel (m_loss);
+      m_channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+      // the sinks keep pointers into m_receivers
+      m_receivers.reserve (16);
+    }
+  NS_ASSERT (m_receivers.size () < 16);
+  Ptr<YansWifiPhy> phy = CreateObject<YansWifiPhy> ();
+  phy->SetErrorRateModel (CreateObject<YansErrorRateModel> ());
+  phy->SetMobility (mobility);
+  phy->ConfigureStandard (WIFI_PHY_STANDARD_80211a);
+  phy->SetChannel (m_channel);
+  ChannelTestReceiver receiver;
+  receiver.arrivals = 0;
+  receiver.expected = 0;
+  m_receivers.push_back (receiver);
+  phy->TraceConnectWithoutContext ("PhyRxBegin", MakeBoundCallback (&ChannelTestArrival, &m_receivers.back ()));
+  phy->TraceConnectWithoutContext ("PhyRxDrop", MakeBoundCallback (&ChannelTestArrival, &m_receivers.back ()));
+  m_phys.push_back (phy);
+}
+
+void
+YansWifiChannelTestCase::Send (double maxRange, double floor)
+{
+  m_channel->SetAttribute ("MaxRange", DoubleValue (maxRange));
+  m_channel->SetAttribute ("RxPowerFloor", DoubleValue (floor));
+  Ptr<MobilityModel> sender = m_phys[0]->GetMobility ();
+  for (uint32_t i = 1; i < m_phys.size (); i++)
+    {
+      Ptr<MobilityModel> receiver = m_phys[i]->GetMobility ();
+      if ((maxRange == 0 || sender->GetDistanceFrom (receiver) <= maxRange)
+          && m_loss->CalcRxPower (16.0, sender, receiver) >= floor)
+        {
+          m_receivers[i].expected++;
+        }
+    }
+  WifiTxVector txVector (WifiPhy::GetOfdmRate6Mbps (), 0, 0, false, 1, 0, 20, false, false);
+  m_channel->Send (m_phys[0], Create<Packet> (100), 16.0, txVector, WIFI_PREAMBLE_LONG, NORMAL_MPDU, MicroSeconds (200));
+}
+
+void
+YansWifiChannelTestCase::Finish (void)
+{
+  Simulator::Run ();
+  for (uint32_t i = 0; i < m_receivers.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_receivers[i].arrivals, m_receivers[i].expected, "Wrong deliveries to PHY " << i);
+    }
+  Simulator::Destroy ();
+  m_channel->Dispose ();
+  m_channel = 0;
+  m_loss = 0;
+  m_phys.clear ();
+  m_receivers.clear ();
+}
+
+/**
+ * Check that a channel with a MaxRange delivers a packet exactly to the
+ * PHYs within range, while the PHYs jump between the cells of its grid,
+ * move without notifying their course, or join the channel late.
+ */
+class YansWifiChannelRangeTest : public YansWifiChannelTestCase
+{
+public:
+  YansWifiChannelRangeTest ();
+private:
+  virtual void DoRun (void);
+};
+
+YansWifiChannelRangeTest::YansWifiChannelRangeTest ()
+  : YansWifiChannelTestCase ("Check the deliveries of a YansWifiChannel with a MaxRange")
+{
+}
+
+void
+YansWifiChannelRangeTest::DoRun (void)
+{
+  Ptr<ConstantPositionMobilityModel> sender = CreateObject<ConstantPositionMobilityModel> ();
+  sender->SetPosition (Vector (0.0, 0.0, 0.0));
+  AddPhy (sender);
+  // within range, and just beyond it
+  Ptr<ConstantPositionMobilityModel> near = CreateObject<ConstantPositionMobilityModel> ();
+  near->SetPosition (Vector (60.0, -70.0, 0.0));
+  AddPhy (near);
+  Ptr<ConstantPositionMobilityModel> far = CreateObject<ConstantPositionMobilityModel> ();
+  far->SetPosition (Vector (0.0, 100.5, 0.0));
+  AddPhy (far);
+  // two PHYs on a node which jumps in and out of range
+  Ptr<ConstantPositionMobilityModel> jumping = CreateObject<ConstantPositionMobilityModel> ();
+  jumping->SetPosition (Vector (-1000.0, 0.0, 0.0));
+  AddPhy (jumping);
+  AddPhy (jumping);
+  // a node which crosses the range at constant velocity
+  Ptr<ConstantVelocityMobilityModel> moving = CreateObject<ConstantVelocityMobilityModel> ();
+  moving->SetPosition (Vector (500.0, 30.0, 0.0));
+  moving->SetVelocity (Vector (-40.0, 0.0, 0.0));
+  AddPhy (moving);
+
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      Time t = MilliSeconds (500 * i);
+      Simulator::Schedule (t, &YansWifiChannelRangeTest::Send, this, 100.0, -1000.0);
+    }
+  Simulator::Schedule (Seconds (3.2), &ConstantPositionMobilityModel::SetPosition, jumping, Vector (-40.0, 80.0, 0.0));
+  Simulator::Schedule (Seconds (7.2), &ConstantPositionMobilityModel::SetPosition, jumping, Vector (300.0, 300.0, 0.0));
+  Simulator::Schedule (Seconds (9.2), &ConstantPositionMobilityModel::SetPosition, jumping, Vector (20.0, 20.0, 0.0));
+  Simulator::Schedule (Seconds (5.2), &YansWifiChannelRangeTest::AddPhy, this, near);
+  Finish ();
+}
+
+/**
+ * Check that a channel with a RxPowerFloor skips the PHYs which would
+ * receive too little power, and that the PHYs share the packet they
+ * receive.
+ */
+class YansWifiChannelFloorTest : public YansWifiChannelTestCase
+{
+public:
+  YansWifiChannelFloorTest ();
+private:
+  virtual void DoRun (void);
+};
+
+YansWifiChannelFloorTest::YansWifiChannelFloorTest ()
+  : YansWifiChannelTestCase ("Check the deliveries of a YansWifiChannel with a RxPowerFloor")
+{
+}
+
+void
+YansWifiChannelFloorTest::DoRun (void)
+{
+  double distances[] = { 0.0, 10.0, 50.0, 120.0, 150.0, 400.0 };
+  for (uint32_t i = 0; i < sizeof (distances) / sizeof (distances[0]); i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (distances[i], 0.0, 0.0));
+      AddPhy (mobility);
+    }
+  Send (0.0, -100.0);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_receivers[1].expected, 1, "The nearest PHY is below the floor");
+  NS_TEST_EXPECT_MSG_EQ (m_receivers[5].expected, 0, "The furthest PHY is above the floor");
+  NS_TEST_EXPECT_MSG_EQ ((m_receivers[1].packet == m_receivers[2].packet), true, "The PHYs received different packets");
+  Simulator::Schedule (Seconds (1.0), &YansWifiChannelFloorTest::Send, this, 0.0, -90.0);
+  // a floor can combine with a range
+  Simulator::Schedule (Seconds (2.0), &YansWifiChannelFloorTest::Send, this, 100.0, -100.0);
+  Finish ();
+}
+
+/**
+ * The YansWifiChannel test suite.
+ */
+class YansWifiChannelTestSuite : public TestSuite
+{
+public:
+  YansWifiChannelTestSuite ();
+};
+
+YansWifiChannelTestSuite::YansWifiChannelTestSuite ()
+  : TestSuite ("yans-wifi-channel", UNIT)
+{
+  AddTestCase (new YansWifiChannelRangeTest, TestCase::QUICK);
+  AddTestCase (new YansWifiChannelFloorTest, TestCase::QUICK);
+}
+
+static YansWifiChannelTestSuite g_yansWifiChannelTestSuite;
@@ -574,7 +574,7 @@ WimaxHelper::EnablePcapInternal (std::string prefix, Ptr<NetDevice> nd, bool exp
     }
 
   Ptr<WimaxPhy> phy = device->GetPhy ();
-  PcapHelper pcapHelper;
+  PcapHelper &pcapHelper = m_pcapHelper;
   std::string filename;
   if (explicitFilename)
     {
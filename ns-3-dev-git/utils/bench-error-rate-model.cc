@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/pointer.h"
+#include "ns3/object-factory.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/table-error-rate-model.h"
+#include "ns3/wifi-phy.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+using namespace ns3;
+
+/*
+ * The chunks of the frames of a receiver: the SNRs, sizes and modes
+ * of the chunks.
+ */
+struct Chunks
+{
+  std::vector<double> snrs;
+  std::vector<uint32_t> sizes;
+  std::vector<WifiMode> modes;
+};
+
+/*
+ * Compute the success rates of the chunks n times, and return the
+ * elapsed time.
+ */
+static uint64_t
+benchChunks (Ptr<ErrorRateModel> model, const Chunks &chunks, uint32_t n, double &sumPsr)
+{
+  WifiTxVector txVector (WifiPhy::GetOfdmRate6Mbps (), 0, 0, false, 1, 0, 20, false, false);
+  sumPsr = 0;
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t j = i % chunks.snrs.size ();
+      sumPsr += model->GetChunkSuccessRate (chunks.modes[j], txVector, chunks.snrs[j], chunks.sizes[j]);
+    }
+  return time.End ();
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the OFDM error rate models with and without tables");
+  cmd.AddValue ("n", "number of chunks", n);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of chunks must be specified " <<
+        "by command-line argument --n=(number of chunks)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-error-rate-model with n=" << n << std::endl;
+
+  // chunks of 5 to 35 dB, of up to a frame of 1500 bytes, with the
+  // modes of 802.11a, each chunk with its own mode as the modes of the
+  // frames of several stations
+  WifiMode modes[] = { WifiPhy::GetOfdmRate6Mbps (), WifiPhy::GetOfdmRate9Mbps (),
+                       WifiPhy::GetOfdmRate12Mbps (), WifiPhy::GetOfdmRate18Mbps (),
+                       WifiPhy::GetOfdmRate24Mbps (), WifiPhy::GetOfdmRate36Mbps (),
+                       WifiPhy::GetOfdmRate48Mbps (), WifiPhy::GetOfdmRate54Mbps () };
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  Chunks chunks;
+  for (uint32_t i = 0; i < 10000; i++)
+    {
+      chunks.snrs.push_back (std::pow (10.0, random->GetValue (5, 35) / 10));
+      chunks.sizes.push_back (random->GetInteger (1, 12000));
+      chunks.modes.push_back (modes[random->GetInteger (0, 7)]);
+    }
+
+  std::string models[] = { "ns3::NistErrorRateModel", "ns3::YansErrorRateModel" };
+  for (uint32_t m = 0; m < 2; m++)
+    {
+      for (uint32_t tables = 0; tables <= 1; tables++)
+        {
+          ObjectFactory factory;
+          factory.SetTypeId (models[m]);
+          Ptr<ErrorRateModel> model = factory.Create<ErrorRateModel> ();
+          if (tables)
+            {
+              Ptr<TableErrorRateModel> table = CreateObject<TableErrorRateModel> ();
+              table->SetAttribute ("ErrorRateModel", PointerValue (model));
+              model = table;
+            }
+          double sumPsr = 0;
+          uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+          // the first iteration fills the tables
+          for (uint32_t i = 0; i < minIterations; i++)
+            {
+              minDelay = std::min (minDelay, benchChunks (model, chunks, n, sumPsr));
+            }
+          double ps = n;
+          ps *= 1000;
+          ps /= std::max<uint64_t> (minDelay, 1);
+          std::cout << ps << " chunks/s"
+                    << " (" << minDelay << " ms elapsed, sum of PSRs " << sumPsr << ")\t"
+                    << models[m] << (tables ? " with tables" : "")
+                    << std::endl;
+        }
+    }
+
+  return 0;
+}
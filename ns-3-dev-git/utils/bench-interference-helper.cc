@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/interference-helper.h"
+#include "ns3/nist-error-rate-model.h"
+#include "ns3/wifi-phy.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+/*
+ * A receiver which hears the frames of a dense BSS: it synchronizes on
+ * a frame whenever it is not receiving one, and the other frames are
+ * interference.
+ */
+class BenchReceiver
+{
+public:
+  BenchReceiver (uint32_t n, double overlap);
+  /* Add the frames, run the simulation and return the elapsed time */
+  uint64_t Run (void);
+
+  uint32_t m_received;
+  double m_sumPer;
+
+private:
+  void Arrive (void);
+  void EndHeader (Ptr<InterferenceHelper::Event> event);
+  void EndReceive (Ptr<InterferenceHelper::Event> event);
+
+  InterferenceHelper m_interference;
+  WifiTxVector m_txVector;
+  Ptr<UniformRandomVariable> m_duration;
+  Ptr<ExponentialRandomVariable> m_interval;
+  Ptr<UniformRandomVariable> m_power;
+  uint32_t m_left;
+  bool m_rxing;
+};
+
+BenchReceiver::BenchReceiver (uint32_t n, double overlap)
+  : m_received (0),
+    m_sumPer (0),
+    m_left (n),
+    m_rxing (false)
+{
+  m_interference.SetNoiseFigure (5.01187);
+  m_interference.SetErrorRateModel (CreateObject<NistErrorRateModel> ());
+  m_txVector = WifiTxVector (WifiPhy::GetOfdmRate54Mbps (), 0, 0, false, 1, 0, 20, false, false);
+  m_duration = CreateObject<UniformRandomVariable> ();
+  m_duration->SetAttribute ("Min", DoubleValue (100e-6));
+  m_duration->SetAttribute ("Max", DoubleValue (2e-3));
+  m_duration->SetStream (1);
+  // frames of 1.05 ms on average, overlap of them at any time
+  m_interval = CreateObject<ExponentialRandomVariable> ();
+  m_interval->SetAttribute ("Mean", DoubleValue (1.05e-3 / overlap));
+  m_interval->SetStream (2);
+  m_power = CreateObject<UniformRandomVariable> ();
+  m_power->SetAttribute ("Min", DoubleValue (1e-12));
+  m_power->SetAttribute ("Max", DoubleValue (1e-9));
+  m_power->SetStream (3);
+}
+
+uint64_t
+BenchReceiver::Run (void)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::ScheduleNow (&BenchReceiver::Arrive, this);
+  Simulator::Run ();
+  uint64_t deltaMs = time.End ();
+  Simulator::Destroy ();
+  return deltaMs;
+}
+
+void
+BenchReceiver::Arrive (void)
+{
+  Time duration = Seconds (m_duration->GetValue ());
+  Ptr<InterferenceHelper::Event> event = m_interference.Add (1000, m_txVector, WIFI_PREAMBLE_LONG,
+                                                             duration, m_power->GetValue ());
+  if (!m_rxing)
+    {
+      m_rxing = true;
+      m_interference.NotifyRxStart ();
+      Simulator::Schedule (MicroSeconds (20), &BenchReceiver::EndHeader, this, event);
+      Simulator::Schedule (duration, &BenchReceiver::EndReceive, this, event);
+    }
+  else
+    {
+      m_interference.GetEnergyDuration (1e-10);
+    }
+  if (--m_left > 0)
+    {
+      Simulator::Schedule (Seconds (m_interval->GetValue ()), &BenchReceiver::Arrive, this);
+    }
+}
+
+void
+BenchReceiver::EndHeader (Ptr<InterferenceHelper::Event> event)
+{
+  m_sumPer += m_interference.CalculatePlcpHeaderSnrPer (event).per;
+}
+
+void
+BenchReceiver::EndReceive (Ptr<InterferenceHelper::Event> event)
+{
+  m_sumPer += m_interference.CalculatePlcpPayloadSnrPer (event).per;
+  m_interference.NotifyRxEnd ();
+  m_rxing = false;
+  m_received++;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the InterferenceHelper of a receiver in a dense BSS");
+  cmd.AddValue ("n", "number of frames", n);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of frames must be specified " <<
+        "by command-line argument --n=(number of frames)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-interference-helper with n=" << n << std::endl;
+
+  double overlaps[] = { 1, 4, 16, 64, 256 };
+  for (uint32_t o = 0; o < sizeof (overlaps) / sizeof (overlaps[0]); o++)
+    {
+      uint32_t received = 0;
+      double sumPer = 0;
+      uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+      for (uint32_t i = 0; i < minIterations; i++)
+        {
+          BenchReceiver receiver (n, overlaps[o]);
+          minDelay = std::min (minDelay, receiver.Run ());
+          received = receiver.m_received;
+          sumPer = receiver.m_sumPer;
+        }
+      double ps = n;
+      ps *= 1000;
+      ps /= std::max<uint64_t> (minDelay, 1);
+      std::cout << ps << " frames/s"
+                << " (" << minDelay << " ms elapsed, "
+                << received << " received, sum of PERs " << sumPer << ")\t"
+                << "overlap " << overlaps[o]
+                << std::endl;
+    }
+
+  return 0;
+}
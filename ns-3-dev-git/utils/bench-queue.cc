@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/drop-tail-queue.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+/*
+ * Trace sink, connected to the queue to measure the cost of the traces.
+ */
+static void
+EnqueueSink (Ptr<const Packet> p)
+{
+}
+
+/*
+ * Pass n packets through a DropTailQueue in bursts of "burst" packets.
+ * With "batch", each burst goes through EnqueueBurst and DequeueBurst;
+ * otherwise through one Enqueue and one Dequeue per packet.
+ */
+static uint64_t
+benchBurst (uint32_t n, uint32_t burst, bool batch, bool trace, uint32_t pktSize)
+{
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (burst));
+  if (trace)
+    {
+      queue->TraceConnectWithoutContext ("Enqueue", MakeCallback (&EnqueueSink));
+    }
+  std::vector<Ptr<Packet> > in;
+  for (uint32_t i = 0; i < burst; i++)
+    {
+      in.push_back (Create<Packet> (pktSize));
+    }
+  std::vector<Ptr<Packet> > out;
+  out.reserve (burst);
+  uint64_t passed = 0;
+
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t sent = 0; sent < n; sent += burst)
+    {
+      if (batch)
+        {
+          queue->EnqueueBurst (in);
+          out.clear ();
+          passed += queue->DequeueBurst (out, burst);
+        }
+      else
+        {
+          for (uint32_t i = 0; i < burst; i++)
+            {
+              queue->Enqueue (in[i]);
+            }
+          for (uint32_t i = 0; i < burst; i++)
+            {
+              if (queue->Dequeue () != 0)
+                {
+                  passed++;
+                }
+            }
+        }
+    }
+  uint64_t deltaMs = time.End ();
+  uint64_t expected = static_cast<uint64_t> ((n + burst - 1) / burst) * burst;
+  if (passed != expected)
+    {
+      std::cerr << "Error-- passed " << passed << " packets instead of " << expected << std::endl;
+      exit (1);
+    }
+  return deltaMs;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t pktSize = 1000;
+  uint32_t minIterations = 1;
+  bool trace = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark DropTailQueue with single packets and with bursts");
+  cmd.AddValue ("n", "number of packets", n);
+  cmd.AddValue ("pkt-size", "packet size in bytes", pktSize);
+  cmd.AddValue ("trace", "connect a sink to the Enqueue trace", trace);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of packets must be specified " <<
+        "by command-line argument --n=(number of packets)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-queue with n=" << n << ", pkt-size=" << pktSize
+            << ", trace=" << trace << std::endl;
+
+  uint32_t bursts[] = { 1, 2, 4, 8, 16, 32, 64 };
+  for (uint32_t b = 0; b < sizeof (bursts) / sizeof (bursts[0]); b++)
+    {
+      for (uint32_t batch = 0; batch <= 1; batch++)
+        {
+          uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+          for (uint32_t i = 0; i < minIterations; i++)
+            {
+              minDelay = std::min (minDelay, benchBurst (n, bursts[b], batch, trace, pktSize));
+            }
+          double ps = n;
+          ps *= 1000;
+          ps /= std::max<uint64_t> (minDelay, 1);
+          std::cout << ps << " packets/s"
+                    << " (" << minDelay << " ms elapsed)\t"
+                    << "burst " << bursts[b]
+                    << (batch ? " EnqueueBurst/DequeueBurst" : " Enqueue/Dequeue")
+                    << std::endl;
+        }
+    }
+
+  return 0;
+}
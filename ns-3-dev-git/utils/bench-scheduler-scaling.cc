@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/core-module.h"
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+
+using namespace ns3;
+
+/*
+ * Classic "hold" benchmark of the event schedulers, run on the schedulers
+ * directly so that millions of pending events fit in memory: the event set
+ * is filled with a number of pending events, then every operation removes
+ * the earliest event and inserts a new one. The delays mimic a network
+ * simulation: most events are a few microseconds ahead, and one in ten is
+ * a timer hundreds of milliseconds ahead.
+ */
+class HoldBenchmark
+{
+public:
+  HoldBenchmark ()
+    : m_seed (1),
+      m_uid (4),
+      m_now (0)
+  {
+  }
+  /**
+   * \param scheduler the scheduler to fill
+   * \param pending number of events to insert
+   */
+  void Fill (Ptr<Scheduler> scheduler, uint32_t pending)
+  {
+    for (uint32_t i = 0; i < pending; ++i)
+      {
+        scheduler->Insert (MakeEvent ());
+      }
+  }
+  /**
+   * \param scheduler the scheduler
+   * \param operations number of hold operations
+   */
+  void Hold (Ptr<Scheduler> scheduler, uint32_t operations)
+  {
+    for (uint32_t i = 0; i < operations; ++i)
+      {
+        m_now = scheduler->RemoveNext ().key.m_ts;
+        scheduler->Insert (MakeEvent ());
+      }
+  }
+
+private:
+  double Uniform (void)
+  {
+    m_seed = m_seed * 1103515245 + 12345;
+    return ((m_seed >> 8) + 1) / 16777217.0;
+  }
+  Scheduler::Event MakeEvent (void)
+  {
+    // Time stamps in nanoseconds
+    double mean = Uniform () < 0.9 ? 10e3 : 200e6;
+    Scheduler::Event ev;
+    ev.impl = 0;
+    ev.key.m_ts = m_now + static_cast<uint64_t> (-mean * std::log (Uniform ()));
+    ev.key.m_uid = m_uid++;
+    ev.key.m_context = 0;
+    return ev;
+  }
+
+  uint32_t m_seed;
+  uint32_t m_uid;
+  uint64_t m_now;
+};
+
+int main (int argc, char *argv[])
+{
+  uint32_t minPending = 1000;
+  uint32_t maxPending = 10000000;
+  uint32_t operations = 1000000;
+  bool list = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Measure the cost of the event schedulers as the number of pending events grows");
+  cmd.AddValue ("min-pending", "smallest number of pending events", minPending);
+  cmd.AddValue ("max-pending", "largest number of pending events", maxPending);
+  cmd.AddValue ("operations", "number of hold operations per run", operations);
+  cmd.AddValue ("list", "include the ListScheduler (up to 10000 pending events)", list);
+  cmd.Parse (argc, argv);
+
+  const char *schedulers[] = {
+    "ns3::ListScheduler",
+    "ns3::MapScheduler",
+    "ns3::HeapScheduler",
+    "ns3::CalendarScheduler",
+    "ns3::DaryHeapScheduler",
+    "ns3::LadderScheduler"
+  };
+
+  std::cout << "pending";
+  for (uint32_t s = list ? 0 : 1; s < sizeof (schedulers) / sizeof (schedulers[0]); s++)
+    {
+      std::cout << "\t" << schedulers[s];
+    }
+  std::cout << std::endl << "(ns per hold operation)" << std::endl;
+
+  for (uint64_t pending = minPending; pending <= maxPending; pending *= 10)
+    {
+      std::cout << pending;
+      for (uint32_t s = list ? 0 : 1; s < sizeof (schedulers) / sizeof (schedulers[0]); s++)
+        {
+          if (s == 0 && pending > 10000)
+            {
+              std::cout << "\t-";
+              continue;
+            }
+          ObjectFactory factory (schedulers[s]);
+          Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+          HoldBenchmark bench;
+          bench.Fill (scheduler, pending);
+
+          SystemWallClockMs time;
+          time.Start ();
+          bench.Hold (scheduler, operations);
+          uint64_t deltaMs = time.End ();
+
+          std::cout << "\t" << std::fixed << std::setprecision (0)
+                    << deltaMs * 1e6 / operations << std::flush;
+        }
+      std::cout << std::endl;
+    }
+
+  return 0;
+}
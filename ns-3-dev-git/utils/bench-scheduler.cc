@@ -0,0 +1,253 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/core-module.h"
+#include <iostream>
+#include <vector>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+/*
+ * Synthetic event patterns of the two kinds of simulations that dominate
+ * our runs, built on the core module only:
+ *
+ * - tcp: every flow receives a segment every few microseconds; each segment
+ *   re-arms the retransmission timer with Simulator::Remove and starts or
+ *   removes a delayed ACK timer, so most scheduled events never expire.
+ * - wifi: a transmission schedules one reception per node, all within a few
+ *   nanoseconds, and cancels the backoff timer of every node; at the end of
+ *   the transmission every node draws a new backoff, and the first to expire
+ *   transmits next.
+ *
+ * The pseudo-random sequence is a plain LCG, so that the benchmark measures
+ * the event list rather than the random variables.
+ */
+class Workload
+{
+public:
+  Workload (uint32_t n)
+    : m_n (n),
+      m_seed (1),
+      m_events (0)
+  {
+  }
+  virtual ~Workload ()
+  {
+  }
+  virtual void Start (void) = 0;
+  uint64_t GetEvents (void) const
+  {
+    return m_events;
+  }
+
+protected:
+  uint32_t Random (uint32_t max)
+  {
+    m_seed = m_seed * 1103515245 + 12345;
+    return (m_seed >> 8) % max;
+  }
+
+  uint32_t m_n;
+  uint32_t m_seed;
+  uint64_t m_events;
+};
+
+class TcpWorkload : public Workload
+{
+public:
+  TcpWorkload (uint32_t n)
+    : Workload (n),
+      m_rto (n),
+      m_delAck (n)
+  {
+  }
+  virtual void Start (void)
+  {
+    for (uint32_t flow = 0; flow < m_n; ++flow)
+      {
+        Simulator::Schedule (NanoSeconds (Random (10000)), &TcpWorkload::Segment, this, flow);
+      }
+  }
+
+private:
+  void Segment (uint32_t flow)
+  {
+    ++m_events;
+    Simulator::Remove (m_rto[flow]);
+    m_rto[flow] = Simulator::Schedule (MilliSeconds (200) + NanoSeconds (Random (1000000)),
+                                       &TcpWorkload::Timer, this);
+    if (m_delAck[flow].IsRunning ())
+      {
+        Simulator::Remove (m_delAck[flow]);
+      }
+    else
+      {
+        m_delAck[flow] = Simulator::Schedule (MilliSeconds (1), &TcpWorkload::Timer, this);
+      }
+    Simulator::Schedule (NanoSeconds (5000 + Random (10000)), &TcpWorkload::Segment, this, flow);
+  }
+  void Timer (void)
+  {
+    ++m_events;
+  }
+
+  std::vector<EventId> m_rto;
+  std::vector<EventId> m_delAck;
+};
+
+class WifiWorkload : public Workload
+{
+public:
+  WifiWorkload (uint32_t n)
+    : Workload (n),
+      m_backoff (n)
+  {
+  }
+  virtual void Start (void)
+  {
+    EndTx ();
+  }
+
+private:
+  void Transmit (uint32_t sender)
+  {
+    ++m_events;
+    for (uint32_t node = 0; node < m_n; ++node)
+      {
+        Simulator::Cancel (m_backoff[node]);
+        if (node != sender)
+          {
+            Simulator::Schedule (NanoSeconds (1 + Random (300)), &WifiWorkload::Receive, this);
+          }
+      }
+    Simulator::Schedule (MicroSeconds (100), &WifiWorkload::EndTx, this);
+  }
+  void Receive (void)
+  {
+    ++m_events;
+  }
+  void EndTx (void)
+  {
+    ++m_events;
+    for (uint32_t node = 0; node < m_n; ++node)
+      {
+        m_backoff[node] = Simulator::Schedule (MicroSeconds (34 + 9 * Random (16)) + NanoSeconds (node),
+                                               &WifiWorkload::Transmit, this, node);
+      }
+  }
+
+  std::vector<EventId> m_backoff;
+};
+
+static uint64_t
+benchWorkload (std::string scheduler, uint32_t arity, std::string workload,
+               uint32_t n, Time duration, uint64_t &events)
+{
+  ObjectFactory factory (scheduler);
+  if (arity != 0)
+    {
+      factory.Set ("Arity", UintegerValue (arity));
+    }
+  Simulator::SetScheduler (factory);
+
+  Workload *w;
+  if (workload == "tcp")
+    {
+      w = new TcpWorkload (n);
+    }
+  else
+    {
+      w = new WifiWorkload (n);
+    }
+  w->Start ();
+  Simulator::Stop (duration);
+
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::Run ();
+  uint64_t deltaMs = time.End ();
+
+  events = w->GetEvents ();
+  Simulator::Destroy ();
+  delete w;
+  return deltaMs;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t flows = 1000;
+  uint32_t nodes = 50;
+  double duration = 0.2;
+  uint32_t minIterations = 1;
+  bool list = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the event schedulers on TCP-like and wifi-like event patterns");
+  cmd.AddValue ("flows", "number of flows of the tcp workload", flows);
+  cmd.AddValue ("nodes", "number of nodes of the wifi workload", nodes);
+  cmd.AddValue ("duration", "simulated time of each run, in seconds", duration);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.AddValue ("list", "include the ListScheduler (slow with large populations)", list);
+  cmd.Parse (argc, argv);
+
+  std::cout << "Running bench-scheduler with flows=" << flows << ", nodes=" << nodes
+            << ", duration=" << duration << "s" << std::endl;
+
+  struct
+  {
+    const char *name;
+    uint32_t arity;
+  } schedulers[] = {
+    { "ns3::ListScheduler", 0 },
+    { "ns3::MapScheduler", 0 },
+    { "ns3::HeapScheduler", 0 },
+    { "ns3::CalendarScheduler", 0 },
+    { "ns3::DaryHeapScheduler", 4 },
+    { "ns3::DaryHeapScheduler", 8 }
+  };
+  std::string workloads[] = { "tcp", "wifi" };
+
+  for (uint32_t w = 0; w < sizeof (workloads) / sizeof (workloads[0]); w++)
+    {
+      for (uint32_t s = list ? 0 : 1; s < sizeof (schedulers) / sizeof (schedulers[0]); s++)
+        {
+          uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+          uint64_t events = 0;
+          for (uint32_t i = 0; i < minIterations; i++)
+            {
+              minDelay = std::min (minDelay, benchWorkload (schedulers[s].name, schedulers[s].arity,
+                                                            workloads[w],
+                                                            workloads[w] == "tcp" ? flows : nodes,
+                                                            Seconds (duration), events));
+            }
+          double ps = events;
+          ps *= 1000;
+          ps /= std::max<uint64_t> (minDelay, 1);
+          std::cout << ps << " events/s"
+                    << " (" << minDelay << " ms elapsed)\t"
+                    << workloads[w] << "\t" << schedulers[s].name;
+          if (schedulers[s].arity != 0)
+            {
+              std::cout << " arity " << schedulers[s].arity;
+            }
+          std::cout << std::endl;
+        }
+    }
+
+  return 0;
+}
@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/object-factory.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/net-device.h"
+#include "ns3/antenna-model.h"
+#include "ns3/spectrum-channel.h"
+#include "ns3/spectrum-phy.h"
+#include "ns3/spectrum-value.h"
+#include "ns3/spectrum-signal-parameters.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+/*
+ * A SpectrumPhy which only counts the signals it receives.
+ */
+class BenchSpectrumPhy : public SpectrumPhy
+{
+public:
+  BenchSpectrumPhy (Ptr<const SpectrumModel> model, Ptr<MobilityModel> mobility)
+    : m_model (model),
+      m_mobility (mobility),
+      m_arrivals (0)
+  {
+  }
+  virtual void SetDevice (Ptr<NetDevice> d)
+  {
+  }
+  virtual Ptr<NetDevice> GetDevice () const
+  {
+    return 0;
+  }
+  virtual void SetMobility (Ptr<MobilityModel> m)
+  {
+    m_mobility = m;
+  }
+  virtual Ptr<MobilityModel> GetMobility ()
+  {
+    return m_mobility;
+  }
+  virtual void SetChannel (Ptr<SpectrumChannel> c)
+  {
+  }
+  virtual Ptr<const SpectrumModel> GetRxSpectrumModel () const
+  {
+    return m_model;
+  }
+  virtual Ptr<AntennaModel> GetRxAntenna ()
+  {
+    return 0;
+  }
+  virtual void StartRx (Ptr<SpectrumSignalParameters> params)
+  {
+    m_arrivals++;
+  }
+
+  Ptr<const SpectrumModel> m_model;
+  Ptr<MobilityModel> m_mobility;
+  uint64_t m_arrivals;
+};
+
+/*
+ * Place nPhys PHYs at random in a square, then make n transmissions
+ * from PHYs taken at random, and return the elapsed time.
+ */
+static uint64_t
+benchChannel (std::string channelType, uint32_t n, uint32_t nPhys, double side,
+              double maxRange, uint32_t nRbs, uint64_t &arrivals)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (channelType);
+  factory.Set ("MaxRange", DoubleValue (maxRange));
+  Ptr<SpectrumChannel> channel = factory.Create<SpectrumChannel> ();
+  channel->AddPropagationLossModel (CreateObject<LogDistancePropagationLossModel> ());
+  channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+
+  std::vector<double> freqs;
+  for (uint32_t i = 0; i < nRbs; i++)
+    {
+      freqs.push_back (2.1e9 + i * 180e3);
+    }
+  Ptr<SpectrumModel> model = Create<SpectrumModel> (freqs);
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  std::vector<Ptr<BenchSpectrumPhy> > phys;
+  for (uint32_t i = 0; i < nPhys; i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (random->GetValue (0, side), random->GetValue (0, side), 1.5));
+      Ptr<BenchSpectrumPhy> phy = CreateObject<BenchSpectrumPhy> (model, mobility);
+      channel->AddRx (phy);
+      phys.push_back (phy);
+    }
+
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters> ();
+      params->psd = Create<SpectrumValue> (model);
+      (*params->psd) = 1e-16;
+      params->duration = MicroSeconds (500);
+      params->txPhy = phys[random->GetInteger (0, nPhys - 1)];
+      channel->StartTx (params);
+      Simulator::Run ();
+    }
+  uint64_t deltaMs = time.End ();
+
+  arrivals = 0;
+  for (uint32_t i = 0; i < nPhys; i++)
+    {
+      arrivals += phys[i]->m_arrivals;
+    }
+  Simulator::Destroy ();
+  channel->Dispose ();
+  return deltaMs;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t nPhys = 500;
+  double side = 2000;
+  double maxRange = 300;
+  uint32_t nRbs = 25;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the SpectrumChannels with and without a MaxRange");
+  cmd.AddValue ("n", "number of transmissions", n);
+  cmd.AddValue ("phys", "number of PHYs", nPhys);
+  cmd.AddValue ("side", "side of the square of the PHYs (m)", side);
+  cmd.AddValue ("max-range", "MaxRange of the culled channels (m)", maxRange);
+  cmd.AddValue ("rbs", "number of bands of the SpectrumModel", nRbs);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of transmissions must be specified " <<
+        "by command-line argument --n=(number of transmissions)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-spectrum-channel with n=" << n << ", phys=" << nPhys
+            << ", side=" << side << ", rbs=" << nRbs << std::endl;
+
+  std::string channels[] = { "ns3::SingleModelSpectrumChannel", "ns3::MultiModelSpectrumChannel" };
+  for (uint32_t c = 0; c < 2; c++)
+    {
+      for (uint32_t culled = 0; culled <= 1; culled++)
+        {
+          double range = culled ? maxRange : 0;
+          uint64_t arrivals = 0;
+          uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+          for (uint32_t i = 0; i < minIterations; i++)
+            {
+              minDelay = std::min (minDelay, benchChannel (channels[c], n, nPhys, side, range, nRbs, arrivals));
+            }
+          double ps = n;
+          ps *= 1000;
+          ps /= std::max<uint64_t> (minDelay, 1);
+          std::cout << ps << " transmissions/s"
+                    << " (" << minDelay << " ms elapsed, "
+                    << arrivals << " receptions)\t"
+                    << channels[c] << " MaxRange=" << range
+                    << std::endl;
+        }
+    }
+
+  return 0;
+}
@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/spectrum-value.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+/*
+ * Run n times the operations made on the SpectrumValues of a receiver
+ * for one subframe of an interference-limited cell: the channel scales
+ * the PSDs of the serving cell and of the interferers, the interference
+ * model adds them up, computes the SINR and accumulates it over the
+ * subframe, then subtracts the signals again.  Return the elapsed time.
+ */
+static uint64_t
+benchChunks (uint32_t n, uint32_t nRbs, uint32_t nInterferers, double &check)
+{
+  std::vector<double> freqs;
+  for (uint32_t i = 0; i < nRbs; i++)
+    {
+      freqs.push_back (2.1e9 + i * 180e3);
+    }
+  Ptr<SpectrumModel> model = Create<SpectrumModel> (freqs);
+
+  Ptr<SpectrumValue> txPsd = Create<SpectrumValue> (model);
+  Ptr<SpectrumValue> noise = Create<SpectrumValue> (model);
+  for (uint32_t i = 0; i < nRbs; i++)
+    {
+      (*txPsd)[i] = 1e-16 * (1 + i % 3);
+      (*noise)[i] = 1e-20;
+    }
+  SpectrumValue allSignals (model);
+  SpectrumValue sumSinr (model);
+
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      std::vector<Ptr<SpectrumValue> > rx;
+      for (uint32_t j = 0; j <= nInterferers; j++)
+        {
+          Ptr<SpectrumValue> psd = Copy<SpectrumValue> (txPsd);
+          *psd *= 1e-9 / (j + 1);
+          allSignals += *psd;
+          rx.push_back (psd);
+        }
+      SpectrumValue sinr = (*rx[0]) / (allSignals - (*rx[0]) + (*noise));
+      sumSinr += sinr * 1e-3;
+      check += Integral (sinr);
+      for (uint32_t j = 0; j <= nInterferers; j++)
+        {
+          allSignals -= *rx[j];
+        }
+    }
+  return time.End ();
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t nInterferers = 3;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the SpectrumValue arithmetic of an interference model");
+  cmd.AddValue ("n", "number of subframes", n);
+  cmd.AddValue ("interferers", "number of interfering signals", nInterferers);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of subframes must be specified " <<
+        "by command-line argument --n=(number of subframes)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-spectrum-value with n=" << n
+            << ", interferers=" << nInterferers << std::endl;
+
+  // the bandwidths of LTE, in resource blocks
+  uint32_t rbs[] = { 6, 15, 25, 50, 75, 100 };
+  for (uint32_t r = 0; r < sizeof (rbs) / sizeof (rbs[0]); r++)
+    {
+      double check = 0;
+      uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+      for (uint32_t i = 0; i < minIterations; i++)
+        {
+          minDelay = std::min (minDelay, benchChunks (n, rbs[r], nInterferers, check));
+        }
+      double ps = n;
+      ps *= 1000;
+      ps /= std::max<uint64_t> (minDelay, 1);
+      std::cout << ps << " subframes/s"
+                << " (" << minDelay << " ms elapsed)\t"
+                << rbs[r] << " RBs, check " << check / minIterations
+                << std::endl;
+    }
+
+  return 0;
+}
@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-rx-buffer.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+/*
+ * Feed n segments to a TcpRxBuffer in groups of "depth" segments. The first
+ * segment of each group is lost and arrives after the rest of the group, as
+ * a retransmission, filling a hole behind depth - 1 out-of-order segments.
+ * The application drains the buffer after every segment, as TcpSocketBase
+ * does.
+ */
+static uint64_t
+benchReorder (uint32_t n, uint32_t depth, uint32_t segSize)
+{
+  Ptr<TcpRxBuffer> rxBuf = CreateObject<TcpRxBuffer> (0);
+  rxBuf->SetMaxBufferSize (std::numeric_limits<uint32_t>::max () / 2);
+  Ptr<Packet> segment = Create<Packet> (segSize);
+  TcpHeader tcph;
+  uint64_t delivered = 0;
+
+  SystemWallClockMs time;
+  time.Start ();
+  for (uint32_t group = 0; group < n; group += depth)
+    {
+      uint32_t last = std::min (n, group + depth);
+      for (uint32_t i = group + 1; i <= last; ++i)
+        {
+          tcph.SetSequenceNumber (SequenceNumber32 ((i == last ? group : i) * segSize));
+          rxBuf->Add (segment, tcph);
+          Ptr<Packet> out = rxBuf->Extract (std::numeric_limits<uint32_t>::max ());
+          if (out != 0)
+            {
+              delivered += out->GetSize ();
+            }
+        }
+    }
+  uint64_t deltaMs = time.End ();
+  if (delivered != static_cast<uint64_t> (n) * segSize)
+    {
+      std::cerr << "Error-- delivered " << delivered << " bytes instead of "
+                << static_cast<uint64_t> (n) * segSize << std::endl;
+      exit (1);
+    }
+  return deltaMs;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t segSize = 536;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark TcpRxBuffer reassembly under reordering");
+  cmd.AddValue ("n", "number of segments", n);
+  cmd.AddValue ("seg-size", "segment size in bytes", segSize);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of segments must be specified " <<
+        "by command-line argument --n=(number of segments)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-tcp-rx-buffer with n=" << n << ", seg-size=" << segSize << std::endl;
+
+  uint32_t depths[] = { 1, 64, 4096 };
+  for (uint32_t d = 0; d < sizeof (depths) / sizeof (depths[0]); d++)
+    {
+      uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+      for (uint32_t i = 0; i < minIterations; i++)
+        {
+          minDelay = std::min (minDelay, benchReorder (n, depths[d], segSize));
+        }
+      double ps = n;
+      ps *= 1000;
+      ps /= std::max<uint64_t> (minDelay, 1);
+      std::cout << ps << " segments/s"
+                << " (" << minDelay << " ms elapsed)\t"
+                << "reorder depth " << depths[d]
+                << std::endl;
+    }
+
+  return 0;
+}
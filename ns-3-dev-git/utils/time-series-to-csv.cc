@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/time-series-file.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <limits>
+
+using namespace ns3;
+
+/*
+ * Convert a binary time series file, as written by TimeSeriesWriter, to
+ * text: either CSV with a header, or the "time value" lines of the ASCII
+ * tracers of the examples, which the existing plotting scripts read.
+ */
+int main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  std::string format = "csv";
+  double from = -1;
+  double to = -1;
+  bool info = false;
+
+  CommandLine cmd;
+  cmd.Usage ("Convert a binary time series file to CSV or to \"time value\" lines");
+  cmd.AddValue ("input", "the time series file", input);
+  cmd.AddValue ("output", "the text file (standard output if empty)", output);
+  cmd.AddValue ("format", "csv (time,value,context) or data (time value)", format);
+  cmd.AddValue ("from", "start of the time range, in seconds (negative for the start of the file)", from);
+  cmd.AddValue ("to", "end of the time range, in seconds (negative for the end of the file)", to);
+  cmd.AddValue ("info", "print the index of the file instead of the records", info);
+  cmd.Parse (argc, argv);
+
+  if (input.empty () || (format != "csv" && format != "data"))
+    {
+      std::cerr << "Usage: time-series-to-csv --input=<file> [--output=<file>] "
+                << "[--format=csv|data] [--from=<s>] [--to=<s>] [--info]" << std::endl;
+      return 1;
+    }
+
+  TimeSeriesReader reader;
+  if (!reader.Open (input))
+    {
+      std::cerr << "Cannot read the time series file " << input << std::endl;
+      return 1;
+    }
+
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+      if (!file.is_open ())
+        {
+          std::cerr << "Cannot open " << output << std::endl;
+          return 1;
+        }
+    }
+  std::ostream &out = output.empty () ? std::cout : file;
+  out << std::setprecision (15);
+
+  if (info)
+    {
+      out << "records " << reader.GetNRecords () << "\n"
+          << "blocks " << reader.GetNBlocks () << "\n"
+          << "compressed " << reader.IsCompressed () << "\n"
+          << "recovered " << reader.IsRecovered () << "\n"
+          << "steps per second " << reader.GetStepsPerSecond () << "\n";
+      for (uint32_t i = 0; i < reader.GetNBlocks (); ++i)
+        {
+          const TimeSeriesFile::Block &block = reader.GetBlock (i);
+          out << "block " << i << " offset=" << block.offset << " records=" << block.count
+              << " size=" << block.size;
+          if (!reader.IsRecovered ())
+            {
+              out << " time=" << reader.GetSeconds (block.minTime) << ".."
+                  << reader.GetSeconds (block.maxTime);
+            }
+          out << "\n";
+        }
+      return 0;
+    }
+
+  if (format == "csv")
+    {
+      out << "time,value,context\n";
+    }
+  int64_t first = from < 0 ? std::numeric_limits<int64_t>::min () : Seconds (from).GetTimeStep ();
+  int64_t last = to < 0 ? std::numeric_limits<int64_t>::max () : Seconds (to).GetTimeStep ();
+  std::vector<TimeSeriesFile::Record> records;
+  for (uint32_t i = 0; i < reader.GetNBlocks (); ++i)
+    {
+      const TimeSeriesFile::Block &block = reader.GetBlock (i);
+      if (block.maxTime < first || block.minTime > last)
+        {
+          continue;
+        }
+      records.clear ();
+      if (!reader.ReadBlock (i, records))
+        {
+          std::cerr << "Cannot read block " << i << " of " << input << std::endl;
+          return 1;
+        }
+      for (std::vector<TimeSeriesFile::Record>::const_iterator r = records.begin (); r != records.end (); ++r)
+        {
+          if (r->time < first || r->time > last)
+            {
+              continue;
+            }
+          if (format == "csv")
+            {
+              out << reader.GetSeconds (r->time) << "," << r->value << "," << r->context << "\n";
+            }
+          else
+            {
+              out << reader.GetSeconds (r->time) << " " << r->value << "\n";
+            }
+        }
+    }
+  return 0;
+}